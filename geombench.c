@@ -0,0 +1,264 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  MapServer
+ * Purpose:  Commandline benchmark of the clipping and pixel transformation
+ *           done to every shape drawn.
+ * Author:   Steve Lime and the MapServer team.
+ *
+ ******************************************************************************
+ * Copyright (c) 1996-2005 Regents of the University of Minnesota.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies of this Software or works derived from this Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "mapserver.h"
+#include "maptime.h"
+
+/*
+** Reads the shapes of a shapefile into memory, then for views from the
+** whole file down to a small window around its center prepares every shape
+** overlapping the view as msDrawShape() does for an AGG map: once with
+** msClipPolygonRect()/msClipPolylineRect(), msTransformShape() and
+** msComputeBounds() in a row, and once with msClipTransformShape(). Both
+** results are compared point by point, and the best time per vertex read
+** of several runs of each is reported. Small files are gone through several
+** times per run. Copying the shapes is timed on its own as it is part of
+** both numbers.
+*/
+
+#define MODE_COPY 0
+#define MODE_SEPARATE 1
+#define MODE_FUSED 2
+
+static const char *modeNames[] = { "copy", "separate", "fused" };
+
+static double elapsed(struct mstimeval *start)
+{
+  struct mstimeval now;
+  msGettimeofday(&now, NULL);
+  return (now.tv_sec - start->tv_sec) + (now.tv_usec - start->tv_usec)/1000000.0;
+}
+
+static int overlaps(rectObj *a, rectObj *b)
+{
+  return a->minx <= b->maxx && a->maxx >= b->minx && a->miny <= b->maxy && a->maxy >= b->miny;
+}
+
+/* what msDrawShape() does to a line or polygon crossing the map edge, or not */
+static void prepare(int mode, shapeObj *shape, rectObj *view, double cellsize, imageObj *image, pointBufferObj *buffer)
+{
+  rectObj cliprect, *clip = NULL;
+  double clip_buf = (shape->type == MS_SHAPE_POLYGON) ? 4 : 2; /* a 1 pixel style, plus 2 for polygons (#179) */
+
+  if(shape->bounds.minx < view->minx || shape->bounds.miny < view->miny ||
+      shape->bounds.maxx > view->maxx || shape->bounds.maxy > view->maxy) {
+    cliprect.minx = view->minx - clip_buf*cellsize;
+    cliprect.miny = view->miny - clip_buf*cellsize;
+    cliprect.maxx = view->maxx + clip_buf*cellsize;
+    cliprect.maxy = view->maxy + clip_buf*cellsize;
+    clip = &cliprect;
+  }
+
+  if(mode == MODE_FUSED) {
+    msClipTransformShape(shape, clip, *view, cellsize, image, buffer);
+  } else if(mode == MODE_SEPARATE) {
+    if(clip) {
+      if(shape->type == MS_SHAPE_POLYGON)
+        msClipPolygonRect(shape, *clip);
+      else
+        msClipPolylineRect(shape, *clip);
+    }
+    msTransformShape(shape, *view, cellsize, image);
+    msComputeBounds(shape);
+  }
+}
+
+/* prepares the shapes overlapping view repeat times, returns the time taken */
+static double run(int mode, shapeObj *shapes, int numshapes, int repeat, rectObj *view, double cellsize, imageObj *image, long *vertices, long *points)
+{
+  struct mstimeval start;
+  pointBufferObj buffer = {NULL, 0};
+  shapeObj shape;
+  int i, j, r;
+
+  *vertices = *points = 0;
+  msGettimeofday(&start, NULL);
+  for(r=0; r<repeat; r++) {
+    for(i=0; i<numshapes; i++) {
+      if(!overlaps(&(shapes[i].bounds), view)) continue;
+      msInitShape(&shape);
+      msCopyShape(&(shapes[i]), &shape);
+      for(j=0; j<shape.numlines; j++)
+        *vertices += shape.line[j].numpoints;
+      prepare(mode, &shape, view, cellsize, image, &buffer);
+      for(j=0; j<shape.numlines; j++)
+        *points += shape.line[j].numpoints;
+      msFreeShape(&shape);
+    }
+  }
+  free(buffer.point);
+  return elapsed(&start);
+}
+
+/* number of shapes for which both ways give different results */
+static int verify(shapeObj *shapes, int numshapes, rectObj *view, double cellsize, imageObj *image)
+{
+  pointBufferObj buffer = {NULL, 0};
+  shapeObj a, b;
+  int i, j, k, differ = 0;
+
+  for(i=0; i<numshapes; i++) {
+    int same = MS_TRUE;
+    if(!overlaps(&(shapes[i].bounds), view)) continue;
+    msInitShape(&a);
+    msInitShape(&b);
+    msCopyShape(&(shapes[i]), &a);
+    msCopyShape(&(shapes[i]), &b);
+    prepare(MODE_SEPARATE, &a, view, cellsize, image, NULL);
+    prepare(MODE_FUSED, &b, view, cellsize, image, &buffer);
+    if(a.numlines != b.numlines)
+      same = MS_FALSE;
+    else if(a.numlines > 0 && (a.bounds.minx != b.bounds.minx || a.bounds.miny != b.bounds.miny ||
+                               a.bounds.maxx != b.bounds.maxx || a.bounds.maxy != b.bounds.maxy))
+      same = MS_FALSE;
+    for(j=0; same && j<a.numlines; j++) {
+      if(a.line[j].numpoints != b.line[j].numpoints)
+        same = MS_FALSE;
+      for(k=0; same && k<a.line[j].numpoints; k++)
+        if(a.line[j].point[k].x != b.line[j].point[k].x || a.line[j].point[k].y != b.line[j].point[k].y)
+          same = MS_FALSE;
+    }
+    if(!same) differ++;
+    msFreeShape(&a);
+    msFreeShape(&b);
+  }
+  free(buffer.point);
+  return differ;
+}
+
+int main(int argc, char *argv[])
+{
+  shapefileObj shp;
+  shapeObj *shapes;
+  outputFormatObj *format;
+  imageObj *image;
+  colorObj background;
+  rectObj view;
+  double cellsize, seconds[3], cx, cy, dx, dy;
+  long points, vertices = 0, read;
+  int i, j, mode, zoom, numshapes, repeat, size = 1000, iterations = 5, differ, status = 0;
+
+  if(argc > 1 && strcmp(argv[1], "-v") == 0) {
+    printf("%s\n", msGetVersion());
+    exit(0);
+  }
+
+  if(argc < 2) {
+    fprintf(stdout,"Syntax: geombench [shapefile] [image size] [iterations]\n" );
+    fprintf(stdout,"Times clipping and pixel transformation of the shapes of a line or polygon shapefile, separately and in one pass.\n" );
+    exit(0);
+  }
+
+  if(argc > 2)
+    size = atoi(argv[2]);
+  if(argc > 3)
+    iterations = atoi(argv[3]);
+  if(size < 1 || iterations < 1) {
+    fprintf(stderr, "Image size and iterations must be positive.\n");
+    exit(1);
+  }
+
+  if(msShapefileOpen(&shp, "rb", argv[1], MS_TRUE) == -1) {
+    msWriteError(stderr);
+    exit(1);
+  }
+  shapes = (shapeObj *) msSmallMalloc(sizeof(shapeObj) * (shp.numshapes > 0 ? shp.numshapes : 1));
+  for(i=0, numshapes=0; i<shp.numshapes; i++) {
+    msSHPReadShape(shp.hSHP, i, &(shapes[numshapes]));
+    if(shapes[numshapes].type != MS_SHAPE_LINE && shapes[numshapes].type != MS_SHAPE_POLYGON) { /* points are not clipped */
+      msFreeShape(&(shapes[numshapes]));
+      continue;
+    }
+    for(j=0; j<shapes[numshapes].numlines; j++)
+      vertices += shapes[numshapes].line[j].numpoints;
+    numshapes++;
+  }
+  view = shp.bounds;
+  printf("%d of %d shapes are lines or polygons, %ld vertices\n", numshapes, shp.numshapes, vertices);
+  msShapefileClose(&shp);
+  if(vertices == 0) {
+    fprintf(stderr, "Nothing to clip in %s.\n", argv[1]);
+    exit(1);
+  }
+  repeat = (vertices < 1000000) ? 1000000/vertices : 1;
+
+  format = msCreateDefaultOutputFormat(NULL, "AGG/PNG", "png");
+  if(!format || msInitializeRendererVTable(format) != MS_SUCCESS) {
+    msWriteError(stderr);
+    exit(1);
+  }
+  MS_INIT_COLOR(background, 255, 255, 255, 255);
+  image = msImageCreate(size, size, format, NULL, NULL, MS_DEFAULT_RESOLUTION, MS_DEFAULT_RESOLUTION, &background);
+  if(!image) {
+    msWriteError(stderr);
+    exit(1);
+  }
+  MS_IMAGE_RENDERER(image)->transform_mode = MS_IMAGE_RENDERER(image)->default_transform_mode; /* as msImageStartLayer() does */
+
+  cx = (view.minx + view.maxx)/2;
+  cy = (view.miny + view.maxy)/2;
+  dx = MS_MAX(view.maxx - view.minx, view.maxy - view.miny)/2;
+  for(zoom=1; zoom<=64; zoom*=4) {
+    dy = dx = dx / (zoom == 1 ? 1 : 4); /* a square view, a quarter as wide each time */
+    view.minx = cx - dx;
+    view.maxx = cx + dx;
+    view.miny = cy - dy;
+    view.maxy = cy + dy;
+    cellsize = (2*dx)/size;
+
+    for(mode=0; mode<3; mode++)
+      seconds[mode] = -1;
+    for(i=0; i<iterations; i++) { /* interleaved so all modes see the same machine */
+      for(mode=0; mode<3; mode++) {
+        double t = run(mode, shapes, numshapes, repeat, &view, cellsize, image, &read, &points);
+        if(seconds[mode] < 0 || t < seconds[mode]) seconds[mode] = t;
+      }
+    }
+    differ = verify(shapes, numshapes, &view, cellsize, image);
+    if(differ > 0) status = 1;
+
+    printf("zoom %2dx: %9ld vertices -> %9ld points, ns/vertex:", zoom, read/repeat, points/repeat);
+    for(mode=0; mode<3; mode++)
+      printf("  %s %6.2f", modeNames[mode], read > 0 ? seconds[mode]*1e9/read : 0);
+    if(seconds[MODE_FUSED] > seconds[MODE_COPY] && seconds[MODE_SEPARATE] > seconds[MODE_COPY])
+      printf("  speedup %.2fx", (seconds[MODE_SEPARATE] - seconds[MODE_COPY])/(seconds[MODE_FUSED] - seconds[MODE_COPY]));
+    if(differ > 0)
+      printf("  %d shapes differ!", differ);
+    printf("\n");
+  }
+
+  msFreeImage(image);
+  for(i=0; i<numshapes; i++)
+    msFreeShape(&(shapes[i]));
+  free(shapes);
+  msCleanup(0);
+
+  return(status);
+}
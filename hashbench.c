@@ -0,0 +1,121 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  MapServer
+ * Purpose:  Commandline benchmark of metadata lookups, as done by OWS
+ *           capabilities documents.
+ * Author:   Steve Lime and the MapServer team.
+ *
+ ******************************************************************************
+ * Copyright (c) 1996-2005 Regents of the University of Minnesota.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies of this Software or works derived from this Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "mapserver.h"
+#include "maptime.h"
+
+/*
+** Looks up, for every layer of a map, the metadata a WMS GetCapabilities
+** document asks for (wms_ then ows_, so mostly misses), then walks every
+** layer's metadata with msFirstKeyFromHashTable()/msNextKeyFromHashTable(),
+** and reports the time per lookup and per key. The number of values found
+** is printed so runs against different builds can be compared.
+*/
+
+static const char *capabilitiesKeys[] = {
+  "title", "abstract", "keywordlist", "keywordlist_vocabulary", "srs",
+  "extent", "opaque", "attribution_title", "attribution_onlineresource",
+  "attribution_logourl_href", "dataurl_format", "dataurl_href",
+  "metadataurl_format", "metadataurl_href", "metadataurl_type", "style",
+  "style_title", "style_abstract", "include_items", "exclude_items",
+  "enable_request", "allowed_ip_list", "denied_ip_list", "layer_group",
+  "group_title", "group_abstract", "identifier_value", "authorityurl_href",
+  "timeextent", "timedefault", "dimensionlist", "sld_enabled", NULL
+};
+
+static double elapsed(struct mstimeval *start)
+{
+  struct mstimeval now;
+  msGettimeofday(&now, NULL);
+  return (now.tv_sec - start->tv_sec) + (now.tv_usec - start->tv_usec)/1000000.0;
+}
+
+int main(int argc, char *argv[])
+{
+  mapObj *map;
+  struct mstimeval start;
+  double seconds;
+  const char *key;
+  long found = 0, lookups = 0, keys = 0;
+  int i, j, k, iterations = 100;
+
+  if(argc > 1 && strcmp(argv[1], "-v") == 0) {
+    printf("%s\n", msGetVersion());
+    exit(0);
+  }
+
+  if(argc < 2) {
+    fprintf(stdout,"Syntax: hashbench [mapfile] [iterations]\n" );
+    fprintf(stdout,"Times msOWSLookupMetadata() on the metadata of every layer, as a WMS GetCapabilities does.\n" );
+    exit(0);
+  }
+
+  if(argc > 2)
+    iterations = atoi(argv[2]);
+
+  map = msLoadMap(argv[1], NULL);
+  if(!map) {
+    msWriteError(stderr);
+    exit(1);
+  }
+
+  msGettimeofday(&start, NULL);
+  for(k=0; k<iterations; k++) {
+    for(i=0; i<map->numlayers; i++) {
+      layerObj *lp = GET_LAYER(map, i);
+      for(j=0; capabilitiesKeys[j] != NULL; j++) {
+        if(msOWSLookupMetadata(&(lp->metadata), "MO", capabilitiesKeys[j]) != NULL)
+          found++;
+        lookups++;
+      }
+    }
+  }
+  seconds = elapsed(&start);
+  printf("lookup  %10.3f s  %8.1f ns/lookup  %ld of %ld found\n", seconds, seconds*1e9/(lookups > 0 ? lookups : 1), found, lookups);
+
+  found = 0;
+  msGettimeofday(&start, NULL);
+  for(k=0; k<iterations; k++) {
+    for(i=0; i<map->numlayers; i++) {
+      hashTableObj *metadata = &(GET_LAYER(map, i)->metadata);
+      for(key = msFirstKeyFromHashTable(metadata); key != NULL; key = msNextKeyFromHashTable(metadata, key)) {
+        found += strlen(key);
+        keys++;
+      }
+    }
+  }
+  seconds = elapsed(&start);
+  printf("iterate %10.3f s  %8.1f ns/key     %ld keys, checksum %ld\n", seconds, seconds*1e9/(keys > 0 ? keys : 1), keys, found);
+
+  msFreeMap(map);
+  msCleanup(0);
+
+  return(0);
+}
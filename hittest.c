@@ -263,7 +263,7 @@ int msHitTestLayer(mapObj *map, layerObj *layer, layer_hittest *hittest) {
 int msHitTestMap(mapObj *map, map_hittest *hittest) {
   int i,status;
   for(i=0; i<map->numlayers; i++) {
-    layerObj *lp = map->layers[i];
+    layerObj *lp = GET_LAYER(map, i);
     status = msHitTestLayer(map,lp,&hittest->layerhits[i]);
     if(status != MS_SUCCESS) {
       return MS_FAILURE;
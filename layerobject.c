@@ -93,6 +93,7 @@ int msInsertClass(layerObj *layer, classObj *classobj, int nIndex)
     MS_REFCNT_INCR(classobj);
     /* increment number of classes and return */
     layer->numclasses++;
+    msFreeNameIndex(&(layer->classindex)); /* positions have shifted */
     return nIndex;
   } else {
     msSetError(MS_CHILDERR, "Invalid index", "msInsertClass()");
@@ -140,6 +141,7 @@ classObj *msRemoveClass(layerObj *layer, int nIndex)
 
     /* decrement number of layers and return copy of removed layer */
     layer->numclasses--;
+    msFreeNameIndex(&(layer->classindex));
     return classobj;
   }
 }
@@ -156,6 +158,7 @@ int msMoveClassUp(layerObj *layer, int nClassIndex)
     layer->class[nClassIndex] = layer->class[nClassIndex-1];
 
     layer->class[nClassIndex-1] = psTmpClass;
+    msFreeNameIndex(&(layer->classindex));
 
     return(MS_SUCCESS);
   }
@@ -177,6 +180,7 @@ int msMoveClassDown(layerObj *layer, int nClassIndex)
     layer->class[nClassIndex] = layer->class[nClassIndex+1];
 
     layer->class[nClassIndex+1] = psTmpClass;
+    msFreeNameIndex(&(layer->classindex));
 
     return(MS_SUCCESS);
   }
@@ -0,0 +1,720 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  MapServer
+ * Purpose:  Sorted attribute index (.aix) of one shapefile column, used to
+ *           narrow down the shapes a layer FILTER has to be evaluated on.
+ * Author:   Steve Lime and the MapServer team.
+ *
+ ******************************************************************************
+ * Copyright (c) 1996-2005 Regents of the University of Minnesota.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies of this Software or works derived from this Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "mapserver.h"
+#include "maptree.h"
+#include "mapparser.h" /* for the IN token */
+#include <ctype.h>
+#include <sys/stat.h>
+
+/*
+** An attribute index lives next to the shapefile as <basename>.<item>.aix,
+** the item in lower case, and is built by shpattridx. It holds one entry per
+** record sorted by the value of the item:
+**
+**   header   32 bytes, see below
+**   entries  numkeys * (keysize + 4) bytes, a key followed by the int32
+**            record id, sorted by key then id
+**
+** N and F fields are indexed as doubles (atof() of the value), all other
+** types as the trimmed string msDBFReadStringAttribute() returns, padded
+** with NULs to the field width. The header holds the "SAI" signature and a
+** version byte, the key type ('N' or 'C') and 3 bytes of padding, then as
+** int32 the key size, the number of records of the .dbf, the number of keys,
+** the low and high 32 bits of the size of the .dbf and the low 32 bits of
+** its modification time. Everything is little endian. An index whose .dbf
+** size or time differs was built from another version of the file and is
+** ignored.
+**
+** The index only selects candidates: the layer still evaluates its filter
+** on every shape it returns, so a filter the index can only partly answer
+** (other terms, other items) still gives the right result.
+*/
+
+#define MS_ATTRINDEX_VERSION 2
+#define MS_ATTRINDEX_HEADER_SIZE 32
+
+typedef struct {
+  double key;
+  ms_int32 id;
+} attrNumberEntryObj;
+
+typedef struct {
+  char *key;
+  ms_int32 id;
+} attrStringEntryObj;
+
+/* a key to look up, in the form of the index it is used with */
+typedef struct {
+  double number;
+  char *string;
+} attrKeyObj;
+
+static int attrIsBigEndian(void)
+{
+  int i = 1;
+  return (*((uchar *) &i) == 1) ? MS_FALSE : MS_TRUE;
+}
+
+static void attrSwapWord(int length, void *wordP)
+{
+  int i;
+  uchar temp;
+
+  for(i=0; i < length/2; i++) {
+    temp = ((uchar *) wordP)[i];
+    ((uchar *)wordP)[i] = ((uchar *) wordP)[length-i-1];
+    ((uchar *) wordP)[length-i-1] = temp;
+  }
+}
+
+/* NaN sorts after every number so the keys stay totally ordered */
+static int attrCompareNumbers(double a, double b)
+{
+  if(msIsNan(a)) return msIsNan(b) ? 0 : 1;
+  if(msIsNan(b)) return -1;
+  if(a < b) return -1;
+  if(a > b) return 1;
+  return 0;
+}
+
+static int attrNumberEntryCompare(const void *a, const void *b)
+{
+  const attrNumberEntryObj *ea = (const attrNumberEntryObj *) a, *eb = (const attrNumberEntryObj *) b;
+  int cmp = attrCompareNumbers(ea->key, eb->key);
+
+  if(cmp != 0) return cmp;
+  return ea->id - eb->id;
+}
+
+static int attrStringEntryCompare(const void *a, const void *b)
+{
+  const attrStringEntryObj *ea = (const attrStringEntryObj *) a, *eb = (const attrStringEntryObj *) b;
+  int cmp = strcmp(ea->key, eb->key);
+
+  if(cmp != 0) return cmp;
+  return ea->id - eb->id;
+}
+
+static void attrWriteInt32(FILE *fp, ms_int32 value, int swap)
+{
+  if(swap) attrSwapWord(4, &value);
+  fwrite(&value, 4, 1, fp);
+}
+
+/* the version of a .dbf as stored in the header: size (low, high) and mtime */
+static void attrDBFVersion(struct stat *sb, ms_int32 *version)
+{
+  double size = (double) sb->st_size;
+
+  version[0] = (ms_int32) (unsigned int) fmod(size, 4294967296.0);
+  version[1] = (ms_int32) (unsigned int) floor(size / 4294967296.0);
+  version[2] = (ms_int32) (unsigned int) ((unsigned long) sb->st_mtime & 0xffffffffUL);
+}
+
+/* locate the .dbf of basename the way msDBFOpen() does */
+static int attrStatDBF(const char *basename, struct stat *sb)
+{
+  char *path;
+  int n = strlen(basename), status = MS_FAILURE;
+
+  path = (char *) msSmallMalloc(n + 5);
+  strcpy(path, basename);
+  strcpy(path+n, ".dbf");
+  if(stat(path, sb) == 0)
+    status = MS_SUCCESS;
+  else {
+    strcpy(path+n, ".DBF");
+    if(stat(path, sb) == 0)
+      status = MS_SUCCESS;
+  }
+
+  msFree(path);
+  return status;
+}
+
+/*
+** Name of the index of item for the shapefile basename (without .shp).
+*/
+char *msAttributeIndexFilename(const char *basename, const char *item)
+{
+  char *filename;
+  int i, n = strlen(basename);
+
+  filename = (char *) msSmallMalloc(n + 1 + strlen(item) + strlen(MS_ATTRIBUTE_INDEX_EXTENSION) + 1);
+  sprintf(filename, "%s.%s%s", basename, item, MS_ATTRIBUTE_INDEX_EXTENSION);
+  for(i=n+1; filename[i] != '\0'; i++)
+    filename[i] = tolower((unsigned char) filename[i]);
+
+  return filename;
+}
+
+/*
+** Index field item of a .dbf and write the index to filename.
+*/
+int msWriteAttributeIndex(DBFHandle hDBF, int item, char *filename)
+{
+  attrNumberEntryObj *numbers = NULL;
+  attrStringEntryObj *strings = NULL;
+  char *buffer = NULL, header[MS_ATTRINDEX_HEADER_SIZE];
+  const char *value;
+  int i, numrecords, width, keysize, isnumber, swap;
+  ms_int32 dbfversion[3];
+  struct stat sb;
+  FILE *fp;
+
+  if(item < 0 || item >= msDBFGetFieldCount(hDBF)) {
+    msSetError(MS_DBFERR, "Invalid field index %d.", "msWriteAttributeIndex()", item);
+    return MS_FAILURE;
+  }
+  if(fstat(fileno(hDBF->fp), &sb) != 0) {
+    msSetError(MS_IOERR, "Unable to stat the .dbf.", "msWriteAttributeIndex()");
+    return MS_FAILURE;
+  }
+  attrDBFVersion(&sb, dbfversion);
+
+  numrecords = msDBFGetRecordCount(hDBF);
+  width = hDBF->panFieldSize[item];
+  isnumber = (hDBF->pachFieldType[item] == 'N' || hDBF->pachFieldType[item] == 'F');
+  keysize = isnumber ? 8 : MS_MAX(width, 1);
+  swap = attrIsBigEndian();
+
+  /* -------------------------------------------------------------------- */
+  /*      Read and sort the keys.                                         */
+  /* -------------------------------------------------------------------- */
+  if(isnumber) {
+    numbers = (attrNumberEntryObj *) msSmallMalloc(sizeof(attrNumberEntryObj) * (numrecords > 0 ? numrecords : 1));
+    for(i=0; i<numrecords; i++) {
+      if((value = msDBFReadStringAttribute(hDBF, i, item)) == NULL) {
+        free(numbers);
+        return MS_FAILURE;
+      }
+      numbers[i].key = atof(value);
+      numbers[i].id = i;
+    }
+    qsort(numbers, numrecords, sizeof(attrNumberEntryObj), attrNumberEntryCompare);
+  } else {
+    strings = (attrStringEntryObj *) msSmallMalloc(sizeof(attrStringEntryObj) * (numrecords > 0 ? numrecords : 1));
+    buffer = (char *) msSmallMalloc((size_t) (width + 1) * (numrecords > 0 ? numrecords : 1));
+    for(i=0; i<numrecords; i++) {
+      if((value = msDBFReadStringAttribute(hDBF, i, item)) == NULL) {
+        free(strings);
+        free(buffer);
+        return MS_FAILURE;
+      }
+      strings[i].key = buffer + (size_t) (width + 1) * i;
+      strlcpy(strings[i].key, value, width + 1);
+      strings[i].id = i;
+    }
+    qsort(strings, numrecords, sizeof(attrStringEntryObj), attrStringEntryCompare);
+  }
+
+  /* -------------------------------------------------------------------- */
+  /*      Write the header and the entries.                               */
+  /* -------------------------------------------------------------------- */
+  if((fp = fopen(filename, "wb")) == NULL) {
+    msSetError(MS_IOERR, "(%s)", "msWriteAttributeIndex()", filename);
+    msFree(numbers);
+    msFree(strings);
+    msFree(buffer);
+    return MS_FAILURE;
+  }
+
+  memset(header, 0, MS_ATTRINDEX_HEADER_SIZE);
+  memcpy(header, "SAI", 3);
+  header[3] = MS_ATTRINDEX_VERSION;
+  header[4] = isnumber ? 'N' : 'C';
+  fwrite(header, 8, 1, fp);
+  attrWriteInt32(fp, keysize, swap);
+  attrWriteInt32(fp, numrecords, swap);
+  attrWriteInt32(fp, numrecords, swap);
+  for(i=0; i<3; i++)
+    attrWriteInt32(fp, dbfversion[i], swap);
+
+  memset(header, 0, MS_ATTRINDEX_HEADER_SIZE);
+  for(i=0; i<numrecords; i++) {
+    if(isnumber) {
+      double key = numbers[i].key;
+      if(swap) attrSwapWord(8, &key);
+      fwrite(&key, 8, 1, fp);
+      attrWriteInt32(fp, numbers[i].id, swap);
+    } else {
+      int length = strlen(strings[i].key);
+      fwrite(strings[i].key, length, 1, fp);
+      if(keysize > length) fwrite(header, keysize - length, 1, fp); /* NUL padding */
+      attrWriteInt32(fp, strings[i].id, swap);
+    }
+  }
+
+  msFree(numbers);
+  msFree(strings);
+  msFree(buffer);
+
+  if(fclose(fp) != 0) {
+    msSetError(MS_IOERR, "Error writing %s.", "msWriteAttributeIndex()", filename);
+    return MS_FAILURE;
+  }
+
+  return MS_SUCCESS;
+}
+
+attributeIndexObj *msAttributeIndexOpen(const char *filename, int debug)
+{
+  attributeIndexObj *index;
+  uchar header[MS_ATTRINDEX_HEADER_SIZE];
+  FILE *fp;
+  int swap = attrIsBigEndian();
+
+  if((fp = fopen(filename, "rb")) == NULL)
+    return NULL; /* no index, not an error */
+
+  if(fread(header, MS_ATTRINDEX_HEADER_SIZE, 1, fp) != 1 || strncmp((char *) header, "SAI", 3) != 0 ||
+      header[3] != MS_ATTRINDEX_VERSION || (header[4] != 'N' && header[4] != 'C')) {
+    if(debug)
+      msDebug("msAttributeIndexOpen(): %s is not an attribute index, ignoring it.\n", filename);
+    fclose(fp);
+    return NULL;
+  }
+
+  index = (attributeIndexObj *) msSmallMalloc(sizeof(attributeIndexObj));
+  index->fp = fp;
+  index->type = header[4];
+  memcpy(&index->keysize, header + 8, 4);
+  memcpy(&index->numrecords, header + 12, 4);
+  memcpy(&index->numkeys, header + 16, 4);
+  memcpy(index->dbfversion, header + 20, 12);
+  if(swap) {
+    attrSwapWord(4, &index->keysize);
+    attrSwapWord(4, &index->numrecords);
+    attrSwapWord(4, &index->numkeys);
+    attrSwapWord(4, &index->dbfversion[0]);
+    attrSwapWord(4, &index->dbfversion[1]);
+    attrSwapWord(4, &index->dbfversion[2]);
+  }
+  index->needswap = swap;
+
+  if(index->keysize <= 0 || (index->type == 'N' && index->keysize != 8) || index->numkeys < 0) {
+    if(debug)
+      msDebug("msAttributeIndexOpen(): %s has an invalid header, ignoring it.\n", filename);
+    msAttributeIndexClose(index);
+    return NULL;
+  }
+
+  index->entrysize = index->keysize + 4;
+  index->entry = (uchar *) msSmallMalloc(index->entrysize);
+  index->position = -1;
+
+  return index;
+}
+
+void msAttributeIndexClose(attributeIndexObj *index)
+{
+  if(!index) return;
+  if(index->fp) fclose(index->fp);
+  msFree(index->entry);
+  free(index);
+}
+
+/* reads entry i into index->entry, seeking only when not reading forward */
+static int attrReadEntry(attributeIndexObj *index, int i)
+{
+  if(i != index->position) {
+    if(fseek(index->fp, MS_ATTRINDEX_HEADER_SIZE + (long) i * index->entrysize, SEEK_SET) != 0)
+      return MS_FAILURE;
+  }
+  if(fread(index->entry, index->entrysize, 1, index->fp) != 1) {
+    index->position = -1;
+    return MS_FAILURE;
+  }
+  index->position = i + 1;
+  return MS_SUCCESS;
+}
+
+static ms_int32 attrEntryId(attributeIndexObj *index)
+{
+  ms_int32 id;
+
+  memcpy(&id, index->entry + index->keysize, 4);
+  if(index->needswap) attrSwapWord(4, &id);
+  return id;
+}
+
+/* compares the key of the entry last read with key */
+static int attrCompareEntry(attributeIndexObj *index, attrKeyObj *key)
+{
+  int cmp;
+
+  if(index->type == 'N') {
+    double number;
+    memcpy(&number, index->entry, 8);
+    if(index->needswap) attrSwapWord(8, &number);
+    return attrCompareNumbers(number, key->number);
+  }
+
+  cmp = strncmp((char *) index->entry, key->string, index->keysize);
+  if(cmp == 0 && strlen(key->string) > (size_t) index->keysize)
+    cmp = -1; /* the key is longer than any value */
+  return cmp;
+}
+
+/*
+** Adds the ids of the entries with lo <= key <= hi (or < when not inclusive)
+** to set, a NULL bound is open.
+*/
+static void attrSearchRange(attributeIndexObj *index, attrKeyObj *lo, int loinclusive, attrKeyObj *hi, int hiinclusive, shapeIdSetObj *set)
+{
+  int first=0, last, mid, cmp, i;
+
+  /* first entry not below lo */
+  if(lo) {
+    last = index->numkeys;
+    while(first < last) {
+      mid = first + (last - first) / 2;
+      if(attrReadEntry(index, mid) != MS_SUCCESS) return;
+      cmp = attrCompareEntry(index, lo);
+      if(cmp < 0 || (cmp == 0 && !loinclusive))
+        first = mid + 1;
+      else
+        last = mid;
+    }
+  }
+
+  for(i=first; i<index->numkeys; i++) {
+    if(attrReadEntry(index, i) != MS_SUCCESS) return;
+    if(hi) {
+      cmp = attrCompareEntry(index, hi);
+      if(cmp > 0 || (cmp == 0 && !hiinclusive)) break;
+    }
+    msAddShapeId(set, attrEntryId(index));
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/*      Filter analysis.                                                */
+/* -------------------------------------------------------------------- */
+
+/* one term of a filter: <item> <op> <value> */
+typedef struct {
+  char *item;
+  int op; /* MS_TOKEN_COMPARISON_* or IN, with the item on the left */
+  int isstring; /* string comparison, else numeric */
+  double number;
+  char *string;
+} attrTermObj;
+
+static int attrReverseComparison(int op)
+{
+  switch(op) {
+    case MS_TOKEN_COMPARISON_LT:
+      return MS_TOKEN_COMPARISON_GT;
+    case MS_TOKEN_COMPARISON_GT:
+      return MS_TOKEN_COMPARISON_LT;
+    case MS_TOKEN_COMPARISON_LE:
+      return MS_TOKEN_COMPARISON_GE;
+    case MS_TOKEN_COMPARISON_GE:
+      return MS_TOKEN_COMPARISON_LE;
+    case MS_TOKEN_COMPARISON_EQ:
+      return op;
+    default:
+      return -1; /* IN and the others can't be turned around */
+  }
+}
+
+static int attrIsBinding(int token)
+{
+  return (token == MS_TOKEN_BINDING_DOUBLE || token == MS_TOKEN_BINDING_INTEGER || token == MS_TOKEN_BINDING_STRING);
+}
+
+static int attrIsLiteral(int token)
+{
+  return (token == MS_TOKEN_LITERAL_NUMBER || token == MS_TOKEN_LITERAL_STRING);
+}
+
+/*
+** Turns a <binding> <comparison> <literal> term, or the reverse, into an
+** attrTermObj. Returns MS_FALSE for anything else.
+*/
+static int attrMakeTerm(tokenListNodeObjPtr *nodes, attrTermObj *term)
+{
+  tokenListNodeObjPtr binding, literal;
+  int op;
+
+  if(attrIsBinding(nodes[0]->token) && attrIsLiteral(nodes[2]->token)) {
+    binding = nodes[0];
+    literal = nodes[2];
+    op = nodes[1]->token;
+  } else if(attrIsLiteral(nodes[0]->token) && attrIsBinding(nodes[2]->token)) {
+    binding = nodes[2];
+    literal = nodes[0];
+    op = attrReverseComparison(nodes[1]->token);
+  } else
+    return MS_FALSE;
+
+  term->item = binding->tokenval.bindval.item;
+  term->op = op;
+  term->isstring = (binding->token == MS_TOKEN_BINDING_STRING);
+
+  if(op == IN) {
+    if(literal->token != MS_TOKEN_LITERAL_STRING) return MS_FALSE;
+    term->string = literal->tokenval.strval;
+    return MS_TRUE;
+  }
+  if(op != MS_TOKEN_COMPARISON_EQ && op != MS_TOKEN_COMPARISON_LT && op != MS_TOKEN_COMPARISON_GT &&
+      op != MS_TOKEN_COMPARISON_LE && op != MS_TOKEN_COMPARISON_GE)
+    return MS_FALSE;
+
+  /* the types must agree, otherwise the filter does not parse anyway */
+  if(term->isstring && literal->token == MS_TOKEN_LITERAL_STRING)
+    term->string = literal->tokenval.strval;
+  else if(!term->isstring && literal->token == MS_TOKEN_LITERAL_NUMBER)
+    term->number = literal->tokenval.dblval;
+  else
+    return MS_FALSE;
+
+  return MS_TRUE;
+}
+
+/*
+** Split a filter made only of comparisons joined by AND into terms an index
+** may answer. Terms of any other form are left out, which is fine since the
+** filter is evaluated on the shapes anyway. Returns the number of terms.
+*/
+static int attrGetFilterTerms(layerObj *layer, attrTermObj *terms, int maxterms)
+{
+  expressionObj *filter = &(layer->filter);
+  tokenListNodeObjPtr node, nodes[3];
+  int n=0, numterms=0, closed=MS_FALSE;
+
+  if(!filter->string) return 0;
+
+  if(filter->type == MS_STRING || filter->type == MS_LIST) {
+    if(!layer->filteritem || (filter->flags & MS_EXP_INSENSITIVE)) return 0;
+    terms[0].item = layer->filteritem;
+    terms[0].op = (filter->type == MS_STRING) ? MS_TOKEN_COMPARISON_EQ : IN;
+    terms[0].isstring = MS_TRUE;
+    terms[0].string = filter->string;
+    return 1;
+  }
+
+  if(filter->type != MS_EXPRESSION || !filter->tokens) return 0;
+
+  /*
+  ** Anything but comparisons, literals, bindings and AND could change the
+  ** meaning, and so could parentheses anywhere else than around terms.
+  */
+  for(node=filter->tokens; ; node=node->next) {
+    if(node && node->token == '(') {
+      if(n > 0 || closed) return 0;
+      continue;
+    }
+    if(node && node->token == ')') {
+      closed = MS_TRUE;
+      continue;
+    }
+
+    if(!node || node->token == MS_TOKEN_LOGICAL_AND) {
+      if(n == 3 && numterms < maxterms && attrMakeTerm(nodes, &terms[numterms]))
+        numterms++;
+      n = 0;
+      closed = MS_FALSE;
+      if(!node) break;
+      continue;
+    }
+
+    if(closed) return 0;
+    if(!attrIsBinding(node->token) && !attrIsLiteral(node->token) && node->token != IN &&
+        (node->token < MS_TOKEN_COMPARISON_EQ || node->token > MS_TOKEN_COMPARISON_LIKE))
+      return 0;
+
+    if(n < 3) nodes[n] = node;
+    n++;
+  }
+
+  return numterms;
+}
+
+/* sets key from a string value of a term, for the type of index */
+static void attrSetKey(attributeIndexObj *index, char *value, attrKeyObj *key)
+{
+  key->string = value;
+  key->number = (index->type == 'N') ? atof(value) : 0;
+}
+
+/*
+** Adds the entries equal to one of the comma separated values, split the
+** way the expression parser splits IN lists (empty values included).
+*/
+static void attrSearchList(attributeIndexObj *index, const char *list, shapeIdSetObj *set)
+{
+  char *value = msStrdup(list), *start, *end;
+  attrKeyObj key;
+
+  for(start=value; ; start=end+1) {
+    if((end = strchr(start, ',')) != NULL) *end = '\0';
+    attrSetKey(index, start, &key);
+    attrSearchRange(index, &key, MS_TRUE, &key, MS_TRUE, set);
+    if(!end) break;
+  }
+  free(value);
+}
+
+/*
+** Search the index of item with the terms about it, returns MS_FALSE when
+** none of them can use the index.
+*/
+static int attrSearchTerms(attributeIndexObj *index, const char *item, attrTermObj *terms, int numterms, shapeIdSetObj *set)
+{
+  attrKeyObj lo, hi, key;
+  int i, cmp, haslo=MS_FALSE, hashi=MS_FALSE, loinclusive=MS_TRUE, hiinclusive=MS_TRUE;
+  int numeric = (index->type == 'N');
+
+  /* an equality or list is the most selective, use the first one */
+  for(i=0; i<numterms; i++) {
+    if(strcasecmp(terms[i].item, item) != 0) continue;
+    if(!terms[i].isstring && !numeric) continue; /* a number against a text column */
+
+    if(terms[i].op == MS_TOKEN_COMPARISON_EQ) {
+      if(terms[i].isstring)
+        attrSetKey(index, terms[i].string, &key); /* equal strings are equal numbers too */
+      else
+        key.number = terms[i].number;
+      attrSearchRange(index, &key, MS_TRUE, &key, MS_TRUE, set);
+      return MS_TRUE;
+    }
+    if(terms[i].op == IN) {
+      attrSearchList(index, terms[i].string, set);
+      return MS_TRUE;
+    }
+  }
+
+  /* otherwise intersect the ranges, strings on a numeric column don't order like numbers */
+  for(i=0; i<numterms; i++) {
+    if(strcasecmp(terms[i].item, item) != 0) continue;
+    if(terms[i].isstring == numeric) continue;
+
+    key.number = terms[i].number;
+    key.string = terms[i].string;
+    if(terms[i].op == MS_TOKEN_COMPARISON_GT || terms[i].op == MS_TOKEN_COMPARISON_GE) {
+      cmp = !haslo ? 1 : (numeric ? attrCompareNumbers(key.number, lo.number) : strcmp(key.string, lo.string));
+      if(cmp > 0 || (cmp == 0 && terms[i].op == MS_TOKEN_COMPARISON_GT)) {
+        lo = key;
+        loinclusive = (terms[i].op == MS_TOKEN_COMPARISON_GE);
+      }
+      haslo = MS_TRUE;
+    } else if(terms[i].op == MS_TOKEN_COMPARISON_LT || terms[i].op == MS_TOKEN_COMPARISON_LE) {
+      cmp = !hashi ? -1 : (numeric ? attrCompareNumbers(key.number, hi.number) : strcmp(key.string, hi.string));
+      if(cmp < 0 || (cmp == 0 && terms[i].op == MS_TOKEN_COMPARISON_LT)) {
+        hi = key;
+        hiinclusive = (terms[i].op == MS_TOKEN_COMPARISON_LE);
+      }
+      hashi = MS_TRUE;
+    }
+  }
+
+  if(!haslo && !hashi) return MS_FALSE;
+
+  attrSearchRange(index, haslo ? &lo : NULL, loinclusive, hashi ? &hi : NULL, hiinclusive, set);
+  return MS_TRUE;
+}
+
+#define MS_ATTRINDEX_MAXTERMS 32
+
+/*
+** Look for an attribute index of the shapefile basename (without .shp)
+** answering the layer filter, and if there is one put the ids of the
+** records that may match in set. Returns MS_SUCCESS when set was filled,
+** MS_DONE when no index applies.
+*/
+int msSearchAttributeIndex(layerObj *layer, const char *basename, int numshapes, shapeIdSetObj *set)
+{
+  attrTermObj terms[MS_ATTRINDEX_MAXTERMS], term;
+  attributeIndexObj *index;
+  char *filename;
+  int i, j, n, numterms, found;
+  ms_int32 dbfversion[3];
+  struct stat sb;
+
+  numterms = attrGetFilterTerms(layer, terms, MS_ATTRINDEX_MAXTERMS);
+  if(numterms == 0)
+    return MS_DONE;
+
+  /* indexes built from another version of the .dbf are ignored */
+  if(attrStatDBF(basename, &sb) != MS_SUCCESS)
+    return MS_DONE;
+  attrDBFVersion(&sb, dbfversion);
+
+  /* try the items compared for equality first, they select the fewest records */
+  for(i=0, n=0; i<numterms; i++) {
+    if(terms[i].op == MS_TOKEN_COMPARISON_EQ || terms[i].op == IN) {
+      term = terms[i];
+      for(j=i; j>n; j--) terms[j] = terms[j-1];
+      terms[n++] = term;
+    }
+  }
+
+  for(i=0; i<numterms; i++) {
+    for(j=0; j<i; j++) /* each item once */
+      if(strcasecmp(terms[j].item, terms[i].item) == 0) break;
+    if(j < i) continue;
+
+    filename = msAttributeIndexFilename(basename, terms[i].item);
+    index = msAttributeIndexOpen(filename, layer->debug);
+    if(index && index->numrecords != numshapes) {
+      if(layer->debug)
+        msDebug("msSearchAttributeIndex(): %s indexes %d records instead of %d, ignoring it.\n", filename, index->numrecords, numshapes);
+      msAttributeIndexClose(index);
+      index = NULL;
+    } else if(index && memcmp(index->dbfversion, dbfversion, sizeof(dbfversion)) != 0) {
+      if(layer->debug)
+        msDebug("msSearchAttributeIndex(): %s was built from another version of %s.dbf, ignoring it.\n", filename, basename);
+      msAttributeIndexClose(index);
+      index = NULL;
+    }
+    if(!index) {
+      free(filename);
+      continue;
+    }
+
+    msInitShapeIdSet(set, numshapes);
+    found = attrSearchTerms(index, terms[i].item, terms, numterms, set);
+    msAttributeIndexClose(index);
+
+    if(found) {
+      if(layer->debug >= MS_DEBUGLEVEL_VV)
+        msDebug("msSearchAttributeIndex(): using %s.\n", filename);
+      free(filename);
+      return MS_SUCCESS;
+    }
+    msFreeShapeIdSet(set);
+    free(filename);
+  }
+
+  return MS_DONE;
+}
@@ -32,6 +32,10 @@
 
 #include "mapserver.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 
 
 #include <limits.h>
@@ -50,7 +54,7 @@ size_t msGetBitArraySize(int numbits)
 
 ms_bitarray msAllocBitArray(int numbits)
 {
-  ms_bitarray array = calloc((numbits + MS_ARRAY_BIT - 1) / MS_ARRAY_BIT, MS_ARRAY_BIT);
+  ms_bitarray array = calloc((numbits + MS_ARRAY_BIT - 1) / MS_ARRAY_BIT, sizeof(ms_uint32));
 
   return(array);
 }
@@ -61,37 +65,55 @@ int msGetBit(ms_bitarray array, int index)
   return (*array & (1 << (index % MS_ARRAY_BIT))) != 0;    /* 0 or 1 */
 }
 
+/*
+** Index of the lowest bit set in a non zero word.
+*/
+static int countTrailingZeros(ms_uint32 b)
+{
+#if defined(__GNUC__) && (__GNUC__ > 3 || (__GNUC__ == 3 && __GNUC_MINOR__ >= 4))
+  return __builtin_ctz(b);
+#elif defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, b);
+  return (int) index;
+#else
+  static const int debruijn[32] = {
+    0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+    31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+  };
+  return debruijn[((b & (0 - b)) * 0x077CB531U) >> 27];
+#endif
+}
+
 /*
 ** msGetNextBit( status, start, size)
 **
 ** Quickly find the next bit set. If start == 0 and 0 is set, will return 0.
 ** If hits end of bitmap without finding set bit, will return -1.
 **
+** Whole words are tested at once, the bits below start are masked off the
+** first one and the position within a word comes from its trailing zeros.
 */
 int msGetNextBit(ms_bitarray array, int i, int size)
 {
+  ms_uint32 b;
+  int word, numwords;
 
-  register ms_uint32 b;
-
-  while(i < size) {
-    b = *(array + (i/MS_ARRAY_BIT));
-    if( b && (b >> (i % MS_ARRAY_BIT)) ) {
-      /* There is something in this byte */
-      /* And it is not to the right of us */
-      if( b & ( 1 << (i % MS_ARRAY_BIT)) ) {
-        /* There is something at this bit! */
-        return i;
-      } else {
-        i++;
-      }
-    } else {
-      /* Nothing in this byte, move to start of next byte */
-      i += MS_ARRAY_BIT - (i % MS_ARRAY_BIT);
-    }
+  if(i < 0) i = 0;
+  if(i >= size) return -1;
+
+  numwords = (size + MS_ARRAY_BIT - 1) / MS_ARRAY_BIT;
+  word = i / MS_ARRAY_BIT;
+  b = array[word] & (0xFFFFFFFFU << (i % MS_ARRAY_BIT));
+
+  while(!b) {
+    if(++word == numwords)
+      return -1; /* got to the last word with no hits! */
+    b = array[word];
   }
 
-  /* Got to the last byte with no hits! */
-  return -1;
+  i = word * MS_ARRAY_BIT + countTrailingZeros(b);
+  return (i < size) ? i : -1;
 }
 
 void msSetBit(ms_bitarray array, int index, int value)
@@ -116,3 +138,111 @@ void msFlipBit(ms_bitarray array, int index)
   array += index / MS_ARRAY_BIT;
   *array ^= 1 << (index % MS_ARRAY_BIT);                   /* flip bit */
 }
+
+/* -------------------------------------------------------------------- */
+/*      Shape id sets.                                                  */
+/*                                                                      */
+/*      A small extent search over a large shapefile finds a handful    */
+/*      of shapes, yet a bit array costs one bit per shape in the file  */
+/*      to allocate, clear and scan. Ids are therefore collected in a   */
+/*      list first and only moved into a bit array once the list        */
+/*      would take more memory than the bit array does.                 */
+/* -------------------------------------------------------------------- */
+
+void msInitShapeIdSet(shapeIdSetObj *set, int numshapes)
+{
+  set->numshapes = (numshapes > 0) ? numshapes : 0;
+  set->bits = NULL;
+  set->ids = NULL;
+  set->numids = set->maxids = 0;
+}
+
+static void shapeIdSetMakeDense(shapeIdSetObj *set)
+{
+  int i;
+  size_t size = msGetBitArraySize(set->numshapes);
+
+  set->bits = (ms_bitarray) msSmallCalloc(size > 0 ? size : 1, sizeof(ms_uint32));
+  for(i=0; i<set->numids; i++)
+    msSetBit(set->bits, set->ids[i], 1);
+  msFree(set->ids);
+  set->ids = NULL;
+  set->numids = set->maxids = 0;
+}
+
+/*
+** Ids outside of 0..numshapes-1 are ignored, so a damaged index can not
+** select shapes that do not exist.
+*/
+void msAddShapeId(shapeIdSetObj *set, int id)
+{
+  if(id < 0 || id >= set->numshapes)
+    return;
+
+  if(set->bits) {
+    msSetBit(set->bits, id, 1);
+    return;
+  }
+
+  if(set->numids == set->maxids) {
+    /* a list of numshapes/32 ints is as large as the bit array */
+    int limit = set->numshapes / MS_ARRAY_BIT;
+
+    if(set->maxids >= limit) {
+      shapeIdSetMakeDense(set);
+      msSetBit(set->bits, id, 1);
+      return;
+    }
+    set->maxids = (set->maxids == 0) ? 64 : set->maxids * 2;
+    if(set->maxids > limit) set->maxids = limit;
+    set->ids = (int *) msSmallRealloc(set->ids, sizeof(int) * set->maxids);
+  }
+  set->ids[set->numids++] = id;
+}
+
+static int compareShapeIds(const void *a, const void *b)
+{
+  int ia = *((const int *) a), ib = *((const int *) b);
+  return (ia > ib) - (ia < ib);
+}
+
+/*
+** Indexes do not return ids in file order, sort the list (dropping
+** duplicates) so shapes are read the way a bit array scan reads them.
+*/
+void msSortShapeIdSet(shapeIdSetObj *set)
+{
+  int i, n;
+
+  if(set->bits || set->numids < 2)
+    return;
+
+  qsort(set->ids, set->numids, sizeof(int), compareShapeIds);
+  for(i=1, n=1; i<set->numids; i++) {
+    if(set->ids[i] != set->ids[n-1])
+      set->ids[n++] = set->ids[i];
+  }
+  set->numids = n;
+}
+
+/*
+** Hands the set over as a bit array, whichever form it is in. The set is
+** left empty.
+*/
+ms_bitarray msShapeIdSetToBitArray(shapeIdSetObj *set)
+{
+  ms_bitarray bits;
+
+  if(!set->bits)
+    shapeIdSetMakeDense(set);
+  bits = set->bits;
+  set->bits = NULL;
+  return bits;
+}
+
+void msFreeShapeIdSet(shapeIdSetObj *set)
+{
+  msFree(set->bits);
+  msFree(set->ids);
+  msInitShapeIdSet(set, set->numshapes);
+}
@@ -132,8 +132,6 @@ struct cluster_layer_info {
 };
 
 
-extern int yyparse(parseObj *p);
-
 /* evaluate the filter expression */
 int msClusterEvaluateFilter(expressionObj* expression, shapeObj *shape)
 {
@@ -146,7 +144,7 @@ int msClusterEvaluateFilter(expressionObj* expression, shapeObj *shape)
     p.expr->curtoken = p.expr->tokens; /* reset */
     p.type = MS_PARSE_TYPE_BOOLEAN;
 
-    status = yyparse(&p);
+    status = msExecuteExpression(&p);
 
     if (status != 0) {
       msSetError(MS_PARSEERR, "Failed to parse expression: %s", "msClusterEvaluateFilter", expression->string);
@@ -178,7 +176,7 @@ char *msClusterGetGroupText(expressionObj* expression, shapeObj *shape)
         p.expr->curtoken = p.expr->tokens; /* reset */
         p.type = MS_PARSE_TYPE_STRING;
 
-        status = yyparse(&p);
+        status = msExecuteExpression(&p);
 
         if (status != 0) {
           msSetError(MS_PARSEERR, "Failed to process text expression: %s", "msClusterGetGroupText", expression->string);
@@ -573,8 +571,7 @@ static int BuildFeatureAttributes(layerObj* layer, msClusterLayerInfo* layerinfo
       values[i] = msStrdup("");
   }
 
-  if (shape->values)
-    msFreeCharArray(shape->values, shape->numvalues);
+  msFreeShapeValues(shape);
 
   shape->values = values;
   shape->numvalues = layer->numitems;
@@ -998,6 +995,7 @@ int RebuildClusters(layerObj *layer, int isQuery)
     /* construct the item array */
     if (layer->iteminfo)
       BuildFeatureAttributes(layer, layerinfo, &current->shape);
+    msShapeOwnValues(&current->shape); /* kept in the tree past the next read */
 
     /* evaluate the group expression */
     if (layer->cluster.group.string)
@@ -1418,12 +1416,12 @@ int msClusterLayerOpen(layerObj *layer)
     return MS_FAILURE;
   }
 
-  if (layer->map->layers[layerIndex]->type != MS_LAYER_POINT) {
+  if (GET_LAYER(layer->map, layerIndex)->type != MS_LAYER_POINT) {
     msSetError(MS_MISCERR, "Only point layers are supported for cluster data source: %s", "msClusterLayerOpen()", layer->name);
     return MS_FAILURE;
   }
 
-  if (msCopyLayer(&layerinfo->srcLayer, layer->map->layers[layerIndex]) != MS_SUCCESS)
+  if (msCopyLayer(&layerinfo->srcLayer, GET_LAYER(layer->map, layerIndex)) != MS_SUCCESS)
     return(MS_FAILURE);
 #else
   /* hook the vtable to this driver, will be restored in LayerClose*/
@@ -0,0 +1,107 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  MapServer
+ * Purpose:  Commandline utility to compile a mapfile into the token stream
+ *           msLoadMap() reads without scanning text.
+ * Author:   Steve Lime and the MapServer team.
+ *
+ ******************************************************************************
+ * Copyright (c) 1996-2005 Regents of the University of Minnesota.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies of this Software or works derived from this Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "mapserver.h"
+#include "maptime.h"
+
+/*
+** Writes a compiled copy of a mapfile (see msCompileMap()): its tokens with
+** INCLUDEs inlined, which msLoadMap() recognizes and replays instead of
+** scanning text. Give the copy a name matching MS_MAPFILE_PATTERN (a .map
+** extension by default) and keep it next to the mapfile. With -b the text
+** and compiled mapfiles are each loaded a number of times and the average
+** load times reported, along with whether both load to the same map.
+*/
+
+static double loadTime(char *filename, int iterations, char **text)
+{
+  struct mstimeval start, end;
+  mapObj *map;
+  int i;
+
+  msGettimeofday(&start, NULL);
+  for(i=0; i<iterations; i++) {
+    if((map = msLoadMap(filename, NULL)) == NULL) {
+      msWriteError(stderr);
+      exit(1);
+    }
+    if(i == iterations-1)
+      *text = msWriteMapToString(map);
+    msFreeMap(map);
+  }
+  msGettimeofday(&end, NULL);
+
+  return ((end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec)/1000000.0) * 1000.0 / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+  int iterations = 0;
+  double textTime, compiledTime;
+  char *text, *compiledText;
+
+  if(argc > 1 && strcmp(argv[1], "-v") == 0) {
+    printf("%s\n", msGetVersion());
+    exit(0);
+  }
+
+  if(argc > 2 && strcmp(argv[1], "-b") == 0) {
+    iterations = atoi(argv[2]);
+    argc -= 2;
+    argv += 2;
+  }
+
+  if(argc != 3 || iterations < 0) {
+    fprintf(stdout,"Syntax: mapcompile [-b iterations] [mapfile] [compiledmapfile]\n" );
+    fprintf(stdout,"Writes [compiledmapfile], which msLoadMap() reads faster than [mapfile]. Keep it\n"
+            "in the same directory. -b reports the average load time of both over [iterations].\n" );
+    exit(0);
+  }
+
+  if(msCompileMap(argv[1], argv[2]) != MS_SUCCESS) {
+    msWriteError(stderr);
+    exit(1);
+  }
+
+  if(iterations > 0) {
+    textTime = loadTime(argv[1], iterations, &text);
+    compiledTime = loadTime(argv[2], iterations, &compiledText);
+
+    printf("text: %.3fms, compiled: %.3fms per load (%.1fx)\n", textTime, compiledTime, compiledTime > 0 ? textTime/compiledTime : 0);
+    printf("maps are %s\n", (text && compiledText && strcmp(text, compiledText) == 0) ? "identical" : "DIFFERENT");
+
+    msFree(text);
+    msFree(compiledText);
+  }
+
+  msCleanup(0);
+
+  return(0);
+}
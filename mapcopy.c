@@ -878,9 +878,13 @@ int msCopyScaleToken(scaleTokenObj *src, scaleTokenObj *dst) {
  * msCreateHashTable(), msCopyHashTable(), msCopyExpression()          *
  *                                                                     *
  * As it stands, we are not copying a layer's resultcache              *
+ *                                                                     *
+ * A lazy source layer is parsed first: the copy is mostly used out of *
+ * map->layers[], where GET_LAYER() won't parse it. msCopyMap() calls  *
+ * copyLayer() instead, so lazy layers stay lazy there.                *
  **********************************************************************/
 
-int msCopyLayer(layerObj *dst, layerObj *src)
+static int copyLayer(layerObj *dst, layerObj *src)
 {
   int i, return_value;
   featureListNodeObjPtr current;
@@ -897,6 +901,8 @@ int msCopyLayer(layerObj *dst, layerObj *src)
     msCopyScaleToken(&src->scaletokens[i],&dst->scaletokens[i]);
     dst->numscaletokens++;
   }
+  /* orig_* only live while the scale tokens are applied to src, see
+     msLayerRestoreScaletokens(), the copy keeps the values in use */
 
   for (i = 0; i < src->numclasses; i++) {
     if (msGrowLayerClasses(dst) == NULL)
@@ -943,6 +949,8 @@ int msCopyLayer(layerObj *dst, layerObj *src)
 
   MS_COPYSTELEM(sizeunits);
   MS_COPYSTELEM(maxfeatures);
+  MS_COPYSTELEM(minfeaturesize);
+  MS_COPYSTELEM(startindex);
 
   MS_COPYCOLOR(&(dst->offsite), &(src->offsite));
 
@@ -998,6 +1006,9 @@ int msCopyLayer(layerObj *dst, layerObj *src)
   MS_COPYSTRING(dst->filteritem, src->filteritem);
   MS_COPYSTELEM(filteritemindex);
 
+  MS_COPYSTRING(dst->bandsitem, src->bandsitem);
+  MS_COPYSTELEM(bandsitemindex);
+
   MS_COPYSTRING(dst->styleitem, src->styleitem);
   MS_COPYSTELEM(styleitemindex);
 
@@ -1008,6 +1019,7 @@ int msCopyLayer(layerObj *dst, layerObj *src)
     msCopyHashTable(&(dst->metadata), &(src->metadata));
   }
   msCopyHashTable(&dst->validation,&src->validation);
+  msCopyHashTable(&dst->bindvals,&src->bindvals);
 
   MS_COPYSTELEM(opacity);
   MS_COPYSTELEM(dump);
@@ -1033,9 +1045,30 @@ int msCopyLayer(layerObj *dst, layerObj *src)
   MS_COPYSTRING(dst->classgroup, src->classgroup);
   MS_COPYSTRING(dst->mask, src->mask);
 
+  MS_COPYSTRING(dst->_geomtransform.string, src->_geomtransform.string);
+  MS_COPYSTELEM(_geomtransform.type);
+
+  /* a lazy layer stays lazy (msCopyMap() only), the copy gets its own token records */
+  msFree(dst->lazy);
+  dst->lazy = NULL;
+  dst->lazysize = 0;
+  if(src->lazy) {
+    dst->lazy = (char *) msSmallMalloc(src->lazysize);
+    memcpy(dst->lazy, src->lazy, src->lazysize);
+    dst->lazysize = src->lazysize;
+  }
+
   return MS_SUCCESS;
 }
 
+int msCopyLayer(layerObj *dst, layerObj *src)
+{
+  if(src->lazy)
+    msLoadLazyLayer(src);
+
+  return copyLayer(dst, src);
+}
+
 /***********************************************************************
  * msCopyMap()                                                         *
  *                                                                     *
@@ -1059,9 +1092,9 @@ int msCopyMap(mapObj *dst, mapObj *src)
   for (i = 0; i < src->numlayers; i++) {
     if (msGrowMapLayers(dst) == NULL)
       return MS_FAILURE;
-    initLayer((GET_LAYER(dst, i)), dst);
+    initLayer(dst->layers[i], dst);
 
-    return_value = msCopyLayer((GET_LAYER(dst, i)), (GET_LAYER(src, i)));
+    return_value = copyLayer(dst->layers[i], src->layers[i]);
     if (return_value != MS_SUCCESS) {
       msSetError(MS_MEMERR, "Failed to copy layer.", "msCopyMap()");
       return MS_FAILURE;
@@ -1087,6 +1120,8 @@ int msCopyMap(mapObj *dst, mapObj *src)
   MS_COPYSTELEM(imagequality);
 
   MS_COPYRECT(&(dst->extent), &(src->extent));
+  MS_COPYSTELEM(gt);
+  MS_COPYRECT(&(dst->saved_extent), &(src->saved_extent));
 
   MS_COPYSTELEM(cellsize);
   MS_COPYSTELEM(units);
@@ -1095,6 +1130,9 @@ int msCopyMap(mapObj *dst, mapObj *src)
   MS_COPYSTELEM(resolution);
   MS_COPYSTRING(dst->shapepath, src->shapepath);
   MS_COPYSTRING(dst->mappath, src->mappath);
+  MS_COPYSTRING(dst->filename, src->filename);
+  MS_COPYSTELEM(filemtime);
+  MS_COPYSTELEM(filesize);
 
   MS_COPYCOLOR(&(dst->imagecolor), &(src->imagecolor));
 
@@ -1130,7 +1168,15 @@ int msCopyMap(mapObj *dst, mapObj *src)
     return MS_FAILURE;
   }
 
-  /* No need to copy latlon projection */
+  /* latlon only needs copying when not the default one */
+  if(msProjectionsDiffer(&(dst->latlon), &(src->latlon))) {
+    msFreeProjection(&(dst->latlon));
+    if(msInitProjection(&(dst->latlon)) == -1 ||
+        msCopyProjection(&(dst->latlon), &(src->latlon)) != MS_SUCCESS) {
+      msSetError(MS_MEMERR, "Failed to copy latlon projection.", "msCopyMap()");
+      return MS_FAILURE;
+    }
+  }
 
   return_value = msCopyReferenceMap(&(dst->reference),&(src->reference),
                                     dst);
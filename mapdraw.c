@@ -32,6 +32,7 @@
 #include "mapserver.h"
 #include "maptime.h"
 #include "mapcopy.h"
+#include "mapthread.h"
 
 
 #ifdef USE_GD
@@ -113,7 +114,8 @@ void msClearPenValues(mapObj *map)
   int i;
 
   for(i=0; i<map->numlayers; i++)
-    msClearLayerPenValues((GET_LAYER(map, i)));
+    if(!map->layers[i]->lazy) /* not parsed yet, no pens either */
+      msClearLayerPenValues(map->layers[i]);
 
   msClearLegendPenValues(&(map->legend));
   msClearScalebarPenValues(&(map->scalebar));
@@ -146,9 +148,9 @@ imageObj *msPrepareImage(mapObj *map, int allow_nonsquare)
 
   /* clear any previously created mask layer images */
   for(i=0; i<map->numlayers; i++) {
-    if(GET_LAYER(map, i)->maskimage) {
-      msFreeImage(GET_LAYER(map, i)->maskimage);
-      GET_LAYER(map, i)->maskimage = NULL;
+    if(map->layers[i]->maskimage) {
+      msFreeImage(map->layers[i]->maskimage);
+      map->layers[i]->maskimage = NULL;
     }
   }
 
@@ -248,6 +250,7 @@ imageObj *msPrepareImage(mapObj *map, int allow_nonsquare)
 
   /* compute layer scale factors now */
   for(i=0; i<map->numlayers; i++) {
+    if(MS_LAZY_LAYER_OFF(map, i)) continue;
     if(GET_LAYER(map, i)->sizeunits != MS_PIXELS)
       GET_LAYER(map, i)->scalefactor = (msInchesPerUnit(GET_LAYER(map, i)->sizeunits,0)/msInchesPerUnit(map->units,0)) / geo_cellsize;
     else if(GET_LAYER(map, i)->symbolscaledenom > 0 && map->scaledenom > 0)
@@ -263,6 +266,311 @@ imageObj *msPrepareImage(mapObj *map, int allow_nonsquare)
 }
 
 
+/*
+** Layer prefetching: with MS_LAYER_THREADS set to a number of threads (or ON
+** for one per processor) in the map CONFIG or the environment, and thread
+** support built in, msDrawMap() reads the features of eligible vector layers
+** on several threads before drawing them. A worker opens its layer, selects
+** the shapes in the map extent and classifies them, as msDrawVectorLayer()
+** would, and keeps them with the layer. msDrawVectorLayer() then draws them on
+** the calling thread in layer order, so rendering and the label cache see
+** the same shapes in the same order as a serial draw and the image is the
+** same. At most one batch of MS_LAYER_THREADS layers is held at a time, and
+** the shapes of a batch are bounded by MS_LAYER_PREFETCH_SIZE megabytes
+** (64 by default), shared evenly by its layers: a worker stops reading its
+** layer when its share is full, and msDrawVectorLayer() reads the rest of
+** the layer itself once the prefetched shapes are drawn.
+*/
+#define MS_LAYER_PREFETCH_SIZE 64
+
+struct layerPrefetchObj {
+  mapObj *map;
+  layerObj *layer;
+  rectObj searchrect;
+  int threadid; /* of the thread calling msDrawMap() */
+  int status; /* MS_SUCCESS, MS_DONE if no shape overlaps the map or MS_FAILURE */
+  shapeObj *shapes;
+  int numshapes, maxshapes, next;
+  size_t size, maxsize; /* bytes held by shapes, and the share of the batch */
+  int more; /* reading stopped at maxsize, the layer has shapes left */
+  errorObj *errors; /* raised on a worker thread, oldest first, passed on by msDrawVectorLayer() */
+};
+
+typedef struct layerPrefetchObj layerPrefetchObj;
+
+static int layerPrefetchThreads(mapObj *map)
+{
+#ifdef USE_THREAD
+  const char *value = msGetConfigOption(map, "MS_LAYER_THREADS");
+  int numthreads;
+
+  if(!value && (value = getenv("MS_LAYER_THREADS")) == NULL)
+    return 1;
+  if(strcasecmp(value, "ON") == 0 || strcasecmp(value, "YES") == 0 || strcasecmp(value, "TRUE") == 0)
+    return msGetProcessorCount();
+  numthreads = atoi(value);
+  return (numthreads > 1) ? numthreads : 1;
+#else
+  return 1;
+#endif
+}
+
+/* bytes of shapes a batch of prefetched layers may hold */
+static size_t layerPrefetchSize(mapObj *map)
+{
+  const char *value = msGetConfigOption(map, "MS_LAYER_PREFETCH_SIZE");
+  int megabytes = MS_LAYER_PREFETCH_SIZE;
+
+  if(value || (value = getenv("MS_LAYER_PREFETCH_SIZE")) != NULL)
+    megabytes = MS_MAX(atoi(value), 1);
+  return (size_t) megabytes * 1024 * 1024;
+}
+
+/* the extent msDrawVectorLayer() selects shapes in, in layer coordinates */
+static rectObj layerDrawSearchRect(mapObj *map, layerObj *layer)
+{
+  rectObj searchrect;
+
+  if(layer->transform == MS_TRUE) {
+    searchrect = map->extent;
+#ifdef USE_PROJ
+    if((map->projection.numargs > 0) && (layer->projection.numargs > 0))
+      msProjectRect(&map->projection, &layer->projection, &searchrect); /* project the searchrect to source coords */
+#endif
+  } else {
+    searchrect.minx = searchrect.miny = 0;
+    searchrect.maxx = map->width-1;
+    searchrect.maxy = map->height-1;
+  }
+
+  return searchrect;
+}
+
+/* sets the class of a shape, returns MS_FALSE if it is not drawn */
+static int layerClassifyShape(mapObj *map, layerObj *layer, shapeObj *shape, int *classgroup, int nclasses, double minfeaturesize)
+{
+  /* Check if the shape size is ok to be drawn */
+  if((shape->type == MS_SHAPE_LINE || shape->type == MS_SHAPE_POLYGON) && (minfeaturesize > 0) && (msShapeCheckSize(shape, minfeaturesize) == MS_FALSE)) {
+    if(layer->debug >= MS_DEBUGLEVEL_V)
+      msDebug("msDrawVectorLayer(): Skipping shape (%ld) because LAYER::MINFEATURESIZE is bigger than shape size\n", shape->index);
+    return MS_FALSE;
+  }
+
+  shape->classindex = msShapeGetClass(layer, map, shape, classgroup, nclasses);
+  if((shape->classindex == -1) || (layer->class[shape->classindex]->status == MS_OFF))
+    return MS_FALSE;
+
+  return MS_TRUE;
+}
+
+/*
+** Only layers msDrawLayer() hands to msDrawVectorLayer() as they are, whose
+** data source can be read from another thread and which do not read other
+** layers while drawing, are prefetched.
+*/
+static int layerCanPrefetch(mapObj *map, layerObj *layer, imageObj *image)
+{
+  if(layer->prefetch || layer->postlabelcache || layer->opacity == 0)
+    return MS_FALSE;
+  if(layer->type != MS_LAYER_POINT && layer->type != MS_LAYER_LINE && layer->type != MS_LAYER_POLYGON && layer->type != MS_LAYER_ANNOTATION)
+    return MS_FALSE;
+  if(layer->connectiontype != MS_SHAPEFILE && layer->connectiontype != MS_OGR && layer->connectiontype != MS_POSTGIS)
+    return MS_FALSE;
+  if(layer->tileindex || layer->styleitem || layer->cluster.region)
+    return MS_FALSE;
+  if(msLayerGetProcessingKey(layer, "RENDERER") || msLayerGetMaxFeaturesToDraw(layer, image->format) >= 0)
+    return MS_FALSE;
+
+  return msLayerIsVisible(map, layer);
+}
+
+static void layerPrefetchFree(layerPrefetchObj *prefetch)
+{
+  int i;
+
+  for(i=prefetch->next; i<prefetch->numshapes; i++)
+    msFreeShape(&(prefetch->shapes[i]));
+  msFree(prefetch->shapes);
+  while(prefetch->errors) {
+    errorObj *next = prefetch->errors->next;
+    msFree(prefetch->errors);
+    prefetch->errors = next;
+  }
+  msFree(prefetch);
+}
+
+/* hands over the next prefetched shape, the caller frees it */
+static int layerPrefetchNextShape(layerPrefetchObj *prefetch, shapeObj *shape)
+{
+  if(prefetch->next >= prefetch->numshapes)
+    return MS_DONE;
+
+  *shape = prefetch->shapes[prefetch->next];
+  msInitShape(&(prefetch->shapes[prefetch->next]));
+  prefetch->next++;
+
+  return MS_SUCCESS;
+}
+
+/* memory held by a shape owning its values */
+static size_t layerPrefetchShapeSize(shapeObj *shape)
+{
+  size_t size = sizeof(shapeObj) + shape->numlines * sizeof(lineObj);
+  int i;
+
+  for(i=0; i<shape->numlines; i++)
+    size += shape->line[i].numpoints * sizeof(pointObj);
+  for(i=0; i<shape->numvalues; i++)
+    size += sizeof(char *) + (shape->values[i] ? strlen(shape->values[i]) + 1 : 0);
+
+  return size;
+}
+
+/*
+** Next shape msDrawVectorLayer() draws: the prefetched ones, then those left
+** in the layer if the worker stopped early, *prefetch is freed and reset by
+** then.
+*/
+static int layerDrawNextShape(layerObj *layer, layerPrefetchObj **prefetch, shapeObj *shape)
+{
+  int status;
+
+  if(*prefetch) {
+    status = layerPrefetchNextShape(*prefetch, shape);
+    if(status != MS_DONE || !(*prefetch)->more)
+      return status;
+    layerPrefetchFree(*prefetch);
+    *prefetch = NULL;
+  }
+
+  return msLayerNextShape(layer, shape);
+}
+
+/* msThreadTaskFunc reading the shapes of one layer */
+static void layerPrefetchRead(void *task)
+{
+  layerPrefetchObj *prefetch = (layerPrefetchObj *) task;
+  mapObj *map = prefetch->map;
+  layerObj *layer = prefetch->layer;
+  shapeObj shape;
+  int *classgroup = NULL;
+  int nclasses = 0;
+  double minfeaturesize = -1;
+  int status;
+
+  status = msLayerOpen(layer);
+  if(status == MS_SUCCESS) {
+    status = msLayerWhichItems(layer, MS_FALSE, NULL);
+    if(status == MS_SUCCESS)
+      status = msLayerWhichShapes(layer, prefetch->searchrect, MS_FALSE);
+    if(status != MS_SUCCESS && status != MS_DONE)
+      status = MS_FAILURE;
+  }
+
+  if(status == MS_SUCCESS) {
+    if(layer->classgroup && layer->numclasses > 0)
+      classgroup = msAllocateValidClassGroups(layer, &nclasses);
+    if(layer->minfeaturesize > 0)
+      minfeaturesize = Pix2LayerGeoref(map, layer, layer->minfeaturesize);
+
+    msInitShape(&shape);
+    while((status = msLayerNextShape(layer, &shape)) == MS_SUCCESS) {
+      if(!layerClassifyShape(map, layer, &shape, classgroup, nclasses, minfeaturesize)) {
+        msFreeShape(&shape);
+        continue;
+      }
+      if(prefetch->numshapes == prefetch->maxshapes) {
+        prefetch->maxshapes = MS_MAX(64, prefetch->maxshapes*2);
+        prefetch->shapes = (shapeObj *) msSmallRealloc(prefetch->shapes, prefetch->maxshapes*sizeof(shapeObj));
+      }
+      msShapeOwnValues(&shape); /* kept past the next read */
+      prefetch->size += layerPrefetchShapeSize(&shape);
+      prefetch->shapes[prefetch->numshapes++] = shape; /* the array owns the shape now */
+      msInitShape(&shape);
+      if(prefetch->size >= prefetch->maxsize) { /* msDrawVectorLayer() reads the rest */
+        prefetch->more = MS_TRUE;
+        status = MS_DONE;
+        break;
+      }
+    }
+    msFree(classgroup);
+
+    /* all shapes were read, or the share is full: whether any overlaps the map is known by now */
+    status = (status == MS_DONE) ? MS_SUCCESS : MS_FAILURE;
+  }
+  prefetch->status = status;
+
+  /* errors of a worker thread would be lost with it, keep them */
+  if(msGetThreadId() != prefetch->threadid) {
+    errorObj *error;
+    for(error = msGetErrorObj(); status == MS_FAILURE && error && error->code != MS_NOERR; error = error->next) {
+      errorObj *copy = (errorObj *) msSmallMalloc(sizeof(errorObj));
+      *copy = *error;
+      copy->next = prefetch->errors; /* the list is newest first */
+      prefetch->errors = copy;
+    }
+    msResetErrorList();
+  }
+}
+
+/*
+** Reads the next batch of layers, starting at position first of the layer
+** order, before they are drawn.
+*/
+static void msPrefetchLayers(mapObj *map, imageObj *image, int first, int numthreads)
+{
+  layerPrefetchObj **tasks;
+  size_t maxsize = layerPrefetchSize(map);
+  int i, numtasks = 0;
+
+  tasks = (layerPrefetchObj **) msSmallMalloc(numthreads*sizeof(layerPrefetchObj *));
+  for(i=first; i<map->numlayers && numtasks<numthreads; i++) {
+    layerObj *layer;
+    layerPrefetchObj *prefetch;
+
+    if(map->layerorder[i] == -1 || MS_LAZY_LAYER_OFF(map, map->layerorder[i]))
+      continue;
+    layer = GET_LAYER(map, map->layerorder[i]); /* lazy layers are parsed here, not on a worker */
+    if(!layer || !layerCanPrefetch(map, layer, image))
+      continue;
+
+    prefetch = (layerPrefetchObj *) msSmallCalloc(1, sizeof(layerPrefetchObj));
+    prefetch->map = map;
+    prefetch->layer = layer;
+    prefetch->searchrect = layerDrawSearchRect(map, layer);
+    prefetch->threadid = msGetThreadId();
+    prefetch->status = MS_FAILURE;
+    tasks[numtasks++] = prefetch;
+  }
+
+  if(numtasks > 1) {
+    for(i=0; i<numtasks; i++)
+      tasks[i]->maxsize = maxsize / numtasks;
+    msRunThreadTasks((void **) tasks, numtasks, layerPrefetchRead, numthreads);
+    for(i=0; i<numtasks; i++)
+      tasks[i]->layer->prefetch = tasks[i];
+  } else if(numtasks == 1) { /* nothing to overlap with, msDrawVectorLayer() reads it */
+    layerPrefetchFree(tasks[0]);
+  }
+
+  free(tasks);
+}
+
+/* drops prefetched shapes that were not drawn, on errors */
+static void msDiscardLayerPrefetches(mapObj *map)
+{
+  int i;
+
+  for(i=0; i<map->numlayers; i++) {
+    layerObj *layer = map->layers[i];
+    if(layer->prefetch) {
+      layerPrefetchFree(layer->prefetch);
+      layer->prefetch = NULL;
+      msLayerClose(layer);
+    }
+  }
+}
+
 /*
  * Generic function to render the map file.
  * The type of the image created is based on the imagetype parameter in the map file.
@@ -272,7 +580,7 @@ imageObj *msPrepareImage(mapObj *map, int allow_nonsquare)
 */
 imageObj *msDrawMap(mapObj *map, int querymap)
 {
-  int i;
+  int i, numthreads;
   layerObj *lp=NULL;
   int status = MS_FAILURE;
   imageObj *image = NULL;
@@ -301,6 +609,8 @@ imageObj *msDrawMap(mapObj *map, int querymap)
     return(NULL);
   }
 
+  numthreads = querymap ? 1 : layerPrefetchThreads(map);
+
   if( map->debug >= MS_DEBUGLEVEL_DEBUG )
     msDebug( "msDrawMap(): rendering using outputformat named %s (%s).\n",
              map->outputformat->name,
@@ -318,7 +628,7 @@ imageObj *msDrawMap(mapObj *map, int querymap)
    */
   numOWSLayers=0;
   for(i=0; i<map->numlayers; i++) {
-    if(map->layerorder[i] != -1 &&
+    if(map->layerorder[i] != -1 && !MS_LAZY_LAYER_OFF(map, map->layerorder[i]) &&
         msLayerIsVisible(map, GET_LAYER(map,map->layerorder[i])))
       numOWSLayers++;
   }
@@ -338,7 +648,8 @@ imageObj *msDrawMap(mapObj *map, int querymap)
     /* Pre-download all WMS/WFS layers in parallel before starting to draw map */
     lastconnectiontype = MS_SHAPEFILE;
     for(i=0; numOWSLayers && i<map->numlayers; i++) {
-      if(map->layerorder[i] == -1 || !msLayerIsVisible(map, GET_LAYER(map,map->layerorder[i])))
+      if(map->layerorder[i] == -1 || MS_LAZY_LAYER_OFF(map, map->layerorder[i]) ||
+          !msLayerIsVisible(map, GET_LAYER(map,map->layerorder[i])))
         continue;
 
       lp = GET_LAYER(map,map->layerorder[i]);
@@ -392,6 +703,7 @@ imageObj *msDrawMap(mapObj *map, int querymap)
   for(i=0; i<map->numlayers; i++) {
 
     if(map->layerorder[i] != -1) {
+      if(MS_LAZY_LAYER_OFF(map, map->layerorder[i])) continue;
       lp = (GET_LAYER(map,  map->layerorder[i]));
 
       if(lp->postlabelcache) /* wait to draw */
@@ -417,6 +729,7 @@ imageObj *msDrawMap(mapObj *map, int querymap)
                      "or another unexpected result in response to the GetMap request. Also check "
                      "and make sure that the layer's connection URL is valid.",
                      "msDrawMap()", lp->name);
+          msDiscardLayerPrefetches(map);
           msFreeImage(image);
           msHTTPFreeRequestObj(pasOWSReqInfo, numOWSRequests);
           msFree(pasOWSReqInfo);
@@ -426,16 +739,21 @@ imageObj *msDrawMap(mapObj *map, int querymap)
 
 #else /* ndef USE_WMS_LYR */
         msSetError(MS_WMSCONNERR, "MapServer not built with WMS Client support, unable to render layer '%s'.", "msDrawMap()", lp->name);
+        msDiscardLayerPrefetches(map);
         msFreeImage(image);
         return(NULL);
 #endif
       } else { /* Default case: anything but WMS layers */
+        if(numthreads > 1 && layerCanPrefetch(map, lp, image))
+          msPrefetchLayers(map, image, i, numthreads);
+
         if(querymap)
           status = msDrawQueryLayer(map, lp, image);
         else
           status = msDrawLayer(map, lp, image);
         if(status == MS_FAILURE) {
           msSetError(MS_IMGERR, "Failed to draw layer named '%s'.", "msDrawMap()", lp->name);
+          msDiscardLayerPrefetches(map);
           msFreeImage(image);
 #if defined(USE_WMS_LYR) || defined(USE_WFS_LYR)
           if (pasOWSReqInfo) {
@@ -504,6 +822,7 @@ imageObj *msDrawMap(mapObj *map, int querymap)
 
   for(i=0; i<map->numlayers; i++) { /* for each layer, check for postlabelcache layers */
 
+    if(MS_LAZY_LAYER_OFF(map, map->layerorder[i])) continue;
     lp = (GET_LAYER(map, map->layerorder[i]));
 
     if(!lp->postlabelcache) continue;
@@ -582,6 +901,13 @@ imageObj *msDrawMap(mapObj *map, int querymap)
 #endif
 
   if(map->debug >= MS_DEBUGLEVEL_TUNING) {
+    long hits, misses;
+    int count;
+
+    msGetTextCacheStats(&hits, &misses, &count);
+    msDebug("msDrawMap(): Text size cache (process wide), %ld hits, %ld misses, %d entries\n",
+            hits, misses, count);
+
     msGettimeofday(&mapendtime, NULL);
     msDebug("msDrawMap() total time: %.3fs\n",
             (mapendtime.tv_sec+mapendtime.tv_usec/1.0e6)-
@@ -915,6 +1241,7 @@ int msDrawVectorLayer(mapObj *map, layerObj *layer, imageObj *image)
   double minfeaturesize = -1;
   int maxfeatures=-1;
   int featuresdrawn=0;
+  layerPrefetchObj *prefetch = layer->prefetch;
 
   if (image)
     maxfeatures=msLayerGetMaxFeaturesToDraw(layer, image->format);
@@ -932,64 +1259,66 @@ int msDrawVectorLayer(mapObj *map, layerObj *layer, imageObj *image)
   msClearLayerPenValues(layer);
 #endif
 
-  /* open this layer */
-  status = msLayerOpen(layer);
-  if(status != MS_SUCCESS) return MS_FAILURE;
+  if(prefetch) {
+    errorObj *error;
 
-  /* build item list */
-  status = msLayerWhichItems(layer, MS_FALSE, NULL);
+    /* msDrawMap() already opened this layer and read its shapes, see msPrefetchLayers() */
+    layer->prefetch = NULL;
+    for(error = prefetch->errors; error; error = error->next)
+      msSetError(error->code, "%s", error->routine, error->message);
+    status = prefetch->status;
+    if(status != MS_SUCCESS) {
+      layerPrefetchFree(prefetch);
+      msLayerClose(layer);
+      return (status == MS_DONE) ? MS_SUCCESS : MS_FAILURE; /* MS_DONE: no overlap */
+    }
+  } else {
+    /* open this layer */
+    status = msLayerOpen(layer);
+    if(status != MS_SUCCESS) return MS_FAILURE;
 
-  if(status != MS_SUCCESS) {
-    msLayerClose(layer);
-    return MS_FAILURE;
-  }
+    /* build item list */
+    status = msLayerWhichItems(layer, MS_FALSE, NULL);
 
-  /* identify target shapes */
-  if(layer->transform == MS_TRUE) {
-    searchrect = map->extent;
-#ifdef USE_PROJ
-    if((map->projection.numargs > 0) && (layer->projection.numargs > 0))
-      msProjectRect(&map->projection, &layer->projection, &searchrect); /* project the searchrect to source coords */
-#endif
-  }
-  else {
-    searchrect.minx = searchrect.miny = 0;
-    searchrect.maxx = map->width-1;
-    searchrect.maxy = map->height-1;
-  }
+    if(status != MS_SUCCESS) {
+      msLayerClose(layer);
+      return MS_FAILURE;
+    }
 
-  status = msLayerWhichShapes(layer, searchrect, MS_FALSE);
-  if(status == MS_DONE) { /* no overlap */
-    msLayerClose(layer);
-    return MS_SUCCESS;
-  } else if(status != MS_SUCCESS) {
-    msLayerClose(layer);
-    return MS_FAILURE;
-  }
+    /* identify target shapes */
+    searchrect = layerDrawSearchRect(map, layer);
 
-  /* step through the target shapes */
-  msInitShape(&shape);
+    status = msLayerWhichShapes(layer, searchrect, MS_FALSE);
+    if(status == MS_DONE) { /* no overlap */
+      msLayerClose(layer);
+      return MS_SUCCESS;
+    } else if(status != MS_SUCCESS) {
+      msLayerClose(layer);
+      return MS_FAILURE;
+    }
+  }
 
+  /* shapes read here are classified here, prefetched ones already were */
   nclasses = 0;
   classgroup = NULL;
-  if(layer->classgroup && layer->numclasses > 0)
-    classgroup = msAllocateValidClassGroups(layer, &nclasses);
+  if(!prefetch || prefetch->more) {
+    if(layer->classgroup && layer->numclasses > 0)
+      classgroup = msAllocateValidClassGroups(layer, &nclasses);
 
-  if(layer->minfeaturesize > 0)
-    minfeaturesize = Pix2LayerGeoref(map, layer, layer->minfeaturesize);
+    if(layer->minfeaturesize > 0)
+      minfeaturesize = Pix2LayerGeoref(map, layer, layer->minfeaturesize);
+  }
 
-  while((status = msLayerNextShape(layer, &shape)) == MS_SUCCESS) {
+  /* shapes crossing the map edge are clipped in the same scratch points, see msClipTransformShape() */
+  layer->clipbuffer = (pointBufferObj *) msSmallCalloc(1, sizeof(pointBufferObj));
 
-    /* Check if the shape size is ok to be drawn */
-    if((shape.type == MS_SHAPE_LINE || shape.type == MS_SHAPE_POLYGON) && (minfeaturesize > 0) && (msShapeCheckSize(&shape, minfeaturesize) == MS_FALSE)) {
-      if(layer->debug >= MS_DEBUGLEVEL_V)
-        msDebug("msDrawVectorLayer(): Skipping shape (%ld) because LAYER::MINFEATURESIZE is bigger than shape size\n", shape.index);
-      msFreeShape(&shape);
-      continue;
-    }
+  /* step through the target shapes */
+  msInitShape(&shape);
+
+  while((status = layerDrawNextShape(layer, &prefetch, &shape)) == MS_SUCCESS) {
 
-    shape.classindex = msShapeGetClass(layer, map, &shape, classgroup, nclasses);
-    if((shape.classindex == -1) || (layer->class[shape.classindex]->status == MS_OFF)) {
+    /* prefetched shapes are classified already */
+    if(!prefetch && !layerClassifyShape(map, layer, &shape, classgroup, nclasses, minfeaturesize)) {
       msFreeShape(&shape);
       continue;
     }
@@ -1116,6 +1445,11 @@ int msDrawVectorLayer(mapObj *map, layerObj *layer, imageObj *image)
 
   if (classgroup)
     msFree(classgroup);
+  if (prefetch)
+    layerPrefetchFree(prefetch);
+  msFree(layer->clipbuffer->point);
+  msFree(layer->clipbuffer);
+  layer->clipbuffer = NULL;
 
   if(status != MS_DONE || retcode == MS_FAILURE) {
     msLayerClose(layer);
@@ -2085,9 +2419,8 @@ int msDrawShape(mapObj *map, layerObj *layer, shapeObj *shape, imageObj *image,
 
     /* if we need a copy of the unclipped shape, transform first, then clip to avoid transforming twice */
     if(bNeedUnclippedShape) {
-      msTransformShape(shape, map->extent, map->cellsize, image);
+      msClipTransformShape(shape, NULL, map->extent, map->cellsize, image, layer->clipbuffer);
       if(shape->numlines == 0) return MS_SUCCESS;
-      msComputeBounds(shape);
 
       /* TODO: there's an optimization here that can be implemented:
          - no need to allocate unclipped_shape for each call to this function
@@ -2131,14 +2464,8 @@ int msDrawShape(mapObj *map, layerObj *layer, shapeObj *shape, imageObj *image,
       cliprect.miny = map->extent.miny - clip_buf_d;
       cliprect.maxx = map->extent.maxx + clip_buf_d;
       cliprect.maxy = map->extent.maxy + clip_buf_d;
-      if(shape->type == MS_SHAPE_POLYGON) {
-        msClipPolygonRect(shape, cliprect);
-      } else {
-        assert(shape->type == MS_SHAPE_LINE);
-        msClipPolylineRect(shape, cliprect);
-      }
-      msTransformShape(shape, map->extent, map->cellsize, image);
-      msComputeBounds(shape);
+      assert(shape->type == MS_SHAPE_POLYGON || shape->type == MS_SHAPE_LINE);
+      msClipTransformShape(shape, &cliprect, map->extent, map->cellsize, image, layer->clipbuffer);
       anno_shape = shape;
     }
 
@@ -2146,8 +2473,7 @@ int msDrawShape(mapObj *map, layerObj *layer, shapeObj *shape, imageObj *image,
     /* the shape is fully in the map extent,
      * or is a point type layer where out of bounds points are treated differently*/
     if (layer->transform == MS_TRUE) {
-      msTransformShape(shape, map->extent, map->cellsize, image);
-      msComputeBounds(shape);
+      msClipTransformShape(shape, NULL, map->extent, map->cellsize, image, layer->clipbuffer);
     } else {
       msOffsetShapeRelativeTo(shape, layer);
     }
@@ -2411,6 +2737,7 @@ void offsetAndTest(imageObj*image, mapObj *map, labelCacheMemberObj *cachePtr, d
   cachePtr->status = msTestLabelCacheCollisions(map, cachePtr, cachePtr->poly, cachePtr->labels[0].mindistance,priority,-label_idx);
   if(cachePtr->status) {
     int ll;
+    msLabelCacheIndexAddLabel(&(map->labelcache), priority, label_idx);
     for(ll=0; ll<cachePtr->numlabels; ll++) {
       cachePtr->labels[ll].annopoint.x += ox;
       cachePtr->labels[ll].annopoint.y += oy;
@@ -2744,7 +3071,7 @@ int computeLabelMarkerPoly(mapObj *map, imageObj *img, labelCacheMemberObj *cach
   return MS_SUCCESS;
 }
 
-int msDrawLabelCache(imageObj *image, mapObj *map)
+static int drawLabelCache(imageObj *image, mapObj *map)
 {
   int nReturnVal = MS_SUCCESS;
 
@@ -2861,6 +3188,7 @@ int msDrawLabelCache(imageObj *image, mapObj *map)
               cachePtr->poly->bounds.maxx = cachePtr->labelpath->bounds.bounds.maxx;
               cachePtr->poly->bounds.maxy = cachePtr->labelpath->bounds.bounds.maxy;
               msFreeShape(&cachePtr->labelpath->bounds);
+              msLabelCacheIndexAddLabel(&(map->labelcache), priority, l);
             }
 
             msDrawTextLine(image, labelPtr->annotext, labelPtr, cachePtr->labelpath, &(map->fontset), layerPtr->scalefactor); /* Draw the curved label */
@@ -3157,6 +3485,7 @@ int msDrawLabelCache(imageObj *image, mapObj *map)
 
             if(cachePtr->status == MS_OFF)
               continue; /* next label, as we had a collision */
+            msLabelCacheIndexAddLabel(&(map->labelcache), priority, l);
 
 
             if(layerPtr->type == MS_LAYER_ANNOTATION && cachePtr->numstyles > 0) { /* need to draw a marker */
@@ -3219,6 +3548,19 @@ int msDrawLabelCache(imageObj *image, mapObj *map)
   return nReturnVal;
 }
 
+int msDrawLabelCache(imageObj *image, mapObj *map)
+{
+  int status;
+
+  /* collision tests look the placed labels and markers up in a grid while drawing */
+  if(image && MS_RENDERER_PLUGIN(image->format))
+    msBuildLabelCacheIndex(map);
+  status = drawLabelCache(image, map);
+  msFreeLabelCacheIndex(&(map->labelcache));
+
+  return status;
+}
+
 
 /**
  * Generic function to tell the underline device that layer
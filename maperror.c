@@ -578,6 +578,9 @@ char *msGetVersion()
 #ifdef USE_POINT_Z_M
   strcat(version, " SUPPORTS=POINT_Z_M");
 #endif
+#ifdef USE_SHAPEFILE_MMAP
+  strcat(version, " SUPPORTS=SHAPEFILE_MMAP");
+#endif
 #ifdef USE_JPEG
   strcat(version, " INPUT=JPEG");
 #endif
@@ -0,0 +1,832 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  MapServer
+ * Purpose:  Compilation of expression token lists to a stack program
+ * Author:   Steve Lime and the MapServer team.
+ *
+ ******************************************************************************
+ * Copyright (c) 1996-2005 Regents of the University of Minnesota.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies of this Software or works derived from this Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *****************************************************************************/
+
+/*
+** The bison parser in mapparser.y walks the token list of an expression for
+** every feature it is evaluated against. This file type checks the same token
+** list once and turns it into a flat postfix program that is then executed
+** against each shape. Only the logical, comparison, arithmetic and string
+** parts of the grammar are compiled, anything else (shape operators, parse
+** errors, ...) leaves the expression to yyparse() which remains the reference
+** implementation. Results of both must be identical, see testexpr.c.
+*/
+
+#include <math.h>
+
+#include "mapserver.h"
+#include "maptime.h"
+#include "mapparser.h" /* for the IN token */
+
+extern int yyparse(parseObj *);
+
+#define MS_EXPR_MAXSTACK 64
+
+enum MS_EXPR_TYPE_ENUM { MS_EXPR_TYPE_NONE=-1, MS_EXPR_TYPE_BOOLEAN, MS_EXPR_TYPE_NUMBER, MS_EXPR_TYPE_STRING, MS_EXPR_TYPE_TIME };
+
+enum MS_EXPR_OPCODE_ENUM {
+  MS_EXPR_OP_PUSH_NUMBER, MS_EXPR_OP_PUSH_STRING, MS_EXPR_OP_PUSH_TIME,
+  MS_EXPR_OP_BIND_NUMBER, MS_EXPR_OP_BIND_STRING, MS_EXPR_OP_BIND_TIME,
+  MS_EXPR_OP_MAP_CELLSIZE, MS_EXPR_OP_DATA_CELLSIZE,
+  MS_EXPR_OP_OR, MS_EXPR_OP_AND, MS_EXPR_OP_NOT,
+  MS_EXPR_OP_COMPARE_NUMBER, MS_EXPR_OP_COMPARE_STRING, MS_EXPR_OP_COMPARE_TIME,
+  MS_EXPR_OP_REGEX, MS_EXPR_OP_REGEX_CONST,
+  MS_EXPR_OP_IN_STRING, MS_EXPR_OP_IN_NUMBER, MS_EXPR_OP_IN_STRING_CONST, MS_EXPR_OP_IN_NUMBER_CONST,
+  MS_EXPR_OP_ADD, MS_EXPR_OP_SUBTRACT, MS_EXPR_OP_MULTIPLY, MS_EXPR_OP_DIVIDE, MS_EXPR_OP_MODULO, MS_EXPR_OP_POWER,
+  MS_EXPR_OP_CONCAT, MS_EXPR_OP_LENGTH, MS_EXPR_OP_ROUND, MS_EXPR_OP_TOSTRING, MS_EXPR_OP_COMMIFY
+};
+
+typedef struct {
+  int op;
+  int arg; /* comparison token, binding index or regex flags */
+  double dblval;
+  char *strval;
+  struct tm tmval;
+  ms_regex_t *regex;
+  int numlistitems; /* pre-split list for IN against a literal */
+  char **strlist;
+  double *dbllist;
+} exprInstructionObj;
+
+struct exprProgramObj {
+  exprInstructionObj *instructions;
+  int numinstructions;
+  int maxinstructions;
+  int resulttype;
+};
+
+typedef struct {
+  double dblval; /* numbers and booleans (0 or 1) */
+  const char *strval;
+  char *ownedstr; /* non-NULL when strval was allocated by the program */
+  struct tm tmval;
+} exprValueObj;
+
+typedef struct {
+  tokenListNodeObjPtr curtoken;
+  exprProgramObj *program;
+  int depth, maxdepth;
+} exprCompilerObj;
+
+/*
+** Program construction.
+*/
+static exprInstructionObj *emitInstruction(exprCompilerObj *c, int op, int stackdelta)
+{
+  exprProgramObj *program = c->program;
+  exprInstructionObj *instr;
+
+  if(program->numinstructions == program->maxinstructions) {
+    program->maxinstructions = program->maxinstructions ? program->maxinstructions*2 : 16;
+    program->instructions = (exprInstructionObj *) msSmallRealloc(program->instructions, sizeof(exprInstructionObj)*program->maxinstructions);
+  }
+
+  instr = &(program->instructions[program->numinstructions++]);
+  memset(instr, 0, sizeof(exprInstructionObj));
+  instr->op = op;
+
+  c->depth += stackdelta;
+  if(c->depth > c->maxdepth) c->maxdepth = c->depth;
+
+  return instr;
+}
+
+static void freeInstruction(exprInstructionObj *instr)
+{
+  msFree(instr->strval);
+  if(instr->regex) {
+    ms_regfree(instr->regex);
+    msFree(instr->regex);
+  }
+  if(instr->strlist) msFreeCharArray(instr->strlist, instr->numlistitems);
+  msFree(instr->dbllist);
+}
+
+static int isLogical(int type)
+{
+  return (type == MS_EXPR_TYPE_BOOLEAN || type == MS_EXPR_TYPE_NUMBER);
+}
+
+/* binary operator precedence, mirrors the %left/%right declarations in mapparser.y */
+static int getPrecedence(int token)
+{
+  switch(token) {
+    case MS_TOKEN_LOGICAL_OR:
+      return 1;
+    case MS_TOKEN_LOGICAL_AND:
+      return 2;
+    /* 3 is NOT */
+    case MS_TOKEN_COMPARISON_EQ:
+    case MS_TOKEN_COMPARISON_NE:
+    case MS_TOKEN_COMPARISON_GT:
+    case MS_TOKEN_COMPARISON_LT:
+    case MS_TOKEN_COMPARISON_GE:
+    case MS_TOKEN_COMPARISON_LE:
+    case MS_TOKEN_COMPARISON_IEQ:
+    case MS_TOKEN_COMPARISON_RE:
+    case MS_TOKEN_COMPARISON_IRE:
+    case IN:
+      return 4;
+    case '+':
+    case '-':
+      return 5;
+    case '*':
+    case '/':
+    case '%':
+      return 6;
+    /* 7 is unary minus */
+    case '^':
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+static int compileExpression(exprCompilerObj *c, int minprecedence);
+
+static int expectToken(exprCompilerObj *c, int token)
+{
+  if(!c->curtoken || c->curtoken->token != token) return MS_FALSE;
+  c->curtoken = c->curtoken->next;
+  return MS_TRUE;
+}
+
+static int compileFunction(exprCompilerObj *c, int token)
+{
+  int type1, type2;
+
+  if(!expectToken(c, '(')) return MS_EXPR_TYPE_NONE;
+  type1 = compileExpression(c, 1);
+
+  switch(token) {
+    case MS_TOKEN_FUNCTION_LENGTH:
+      if(type1 != MS_EXPR_TYPE_STRING || !expectToken(c, ')')) return MS_EXPR_TYPE_NONE;
+      emitInstruction(c, MS_EXPR_OP_LENGTH, 0);
+      return MS_EXPR_TYPE_NUMBER;
+    case MS_TOKEN_FUNCTION_COMMIFY:
+      if(type1 != MS_EXPR_TYPE_STRING || !expectToken(c, ')')) return MS_EXPR_TYPE_NONE;
+      emitInstruction(c, MS_EXPR_OP_COMMIFY, 0);
+      return MS_EXPR_TYPE_STRING;
+    case MS_TOKEN_FUNCTION_ROUND:
+    case MS_TOKEN_FUNCTION_TOSTRING:
+      if(type1 != MS_EXPR_TYPE_NUMBER || !expectToken(c, ',')) return MS_EXPR_TYPE_NONE;
+      type2 = compileExpression(c, 1);
+      if(!expectToken(c, ')')) return MS_EXPR_TYPE_NONE;
+      if(token == MS_TOKEN_FUNCTION_ROUND) {
+        if(type2 != MS_EXPR_TYPE_NUMBER) return MS_EXPR_TYPE_NONE;
+        emitInstruction(c, MS_EXPR_OP_ROUND, -1);
+        return MS_EXPR_TYPE_NUMBER;
+      }
+      if(type2 != MS_EXPR_TYPE_STRING) return MS_EXPR_TYPE_NONE;
+      emitInstruction(c, MS_EXPR_OP_TOSTRING, -1);
+      return MS_EXPR_TYPE_STRING;
+    default:
+      return MS_EXPR_TYPE_NONE;
+  }
+}
+
+static int compileOperand(exprCompilerObj *c)
+{
+  tokenListNodeObjPtr node = c->curtoken;
+  exprInstructionObj *instr;
+  int type;
+
+  if(!node) return MS_EXPR_TYPE_NONE;
+  c->curtoken = node->next;
+
+  switch(node->token) {
+    case MS_TOKEN_LITERAL_NUMBER:
+      instr = emitInstruction(c, MS_EXPR_OP_PUSH_NUMBER, 1);
+      instr->dblval = node->tokenval.dblval;
+      return MS_EXPR_TYPE_NUMBER;
+    case MS_TOKEN_LITERAL_STRING:
+      instr = emitInstruction(c, MS_EXPR_OP_PUSH_STRING, 1);
+      instr->strval = msStrdup(node->tokenval.strval);
+      return MS_EXPR_TYPE_STRING;
+    case MS_TOKEN_LITERAL_TIME:
+      instr = emitInstruction(c, MS_EXPR_OP_PUSH_TIME, 1);
+      instr->tmval = node->tokenval.tmval;
+      return MS_EXPR_TYPE_TIME;
+    case MS_TOKEN_BINDING_DOUBLE:
+    case MS_TOKEN_BINDING_INTEGER:
+      instr = emitInstruction(c, MS_EXPR_OP_BIND_NUMBER, 1);
+      instr->arg = node->tokenval.bindval.index;
+      return MS_EXPR_TYPE_NUMBER;
+    case MS_TOKEN_BINDING_STRING:
+      instr = emitInstruction(c, MS_EXPR_OP_BIND_STRING, 1);
+      instr->arg = node->tokenval.bindval.index;
+      return MS_EXPR_TYPE_STRING;
+    case MS_TOKEN_BINDING_TIME:
+      instr = emitInstruction(c, MS_EXPR_OP_BIND_TIME, 1);
+      instr->arg = node->tokenval.bindval.index;
+      return MS_EXPR_TYPE_TIME;
+    case MS_TOKEN_BINDING_MAP_CELLSIZE:
+      emitInstruction(c, MS_EXPR_OP_MAP_CELLSIZE, 1);
+      return MS_EXPR_TYPE_NUMBER;
+    case MS_TOKEN_BINDING_DATA_CELLSIZE:
+      emitInstruction(c, MS_EXPR_OP_DATA_CELLSIZE, 1);
+      return MS_EXPR_TYPE_NUMBER;
+    case MS_TOKEN_LOGICAL_NOT:
+      type = compileExpression(c, 4);
+      if(!isLogical(type)) return MS_EXPR_TYPE_NONE;
+      emitInstruction(c, MS_EXPR_OP_NOT, 0);
+      return MS_EXPR_TYPE_BOOLEAN;
+    case '-':
+      /* the grammar defines unary minus as a no-op ($$ = $2), keep it that way */
+      type = compileExpression(c, 8);
+      return (type == MS_EXPR_TYPE_NUMBER) ? type : MS_EXPR_TYPE_NONE;
+    case '(':
+      type = compileExpression(c, 1);
+      if(!expectToken(c, ')')) return MS_EXPR_TYPE_NONE;
+      return type;
+    case MS_TOKEN_FUNCTION_LENGTH:
+    case MS_TOKEN_FUNCTION_COMMIFY:
+    case MS_TOKEN_FUNCTION_ROUND:
+    case MS_TOKEN_FUNCTION_TOSTRING:
+      return compileFunction(c, node->token);
+    default: /* shapes, spatial functions and operators are left to yyparse() */
+      return MS_EXPR_TYPE_NONE;
+  }
+}
+
+/* unlike msStringSplit() empty items are kept, "a,,b" has three of them */
+static char **splitList(const char *list, int *numitems)
+{
+  const char *start = list, *end;
+  char **items;
+  int n = 1;
+
+  for(end=list; *end; end++)
+    if(*end == ',') n++;
+
+  items = (char **) msSmallMalloc(sizeof(char *)*n);
+  n = 0;
+  while((end = strchr(start, ',')) != NULL) {
+    items[n] = (char *) msSmallMalloc(end-start+1);
+    strncpy(items[n], start, end-start);
+    items[n][end-start] = '\0';
+    n++;
+    start = end+1;
+  }
+  items[n++] = msStrdup(start);
+
+  *numitems = n;
+  return items;
+}
+
+/*
+** A literal right hand side of IN, ~ and ~* is processed once here rather
+** than for every feature. Returns MS_TRUE if the last instruction was
+** replaced.
+*/
+static int compileConstantOperator(exprCompilerObj *c, int token, int lefttype, int rhsstart)
+{
+  exprProgramObj *program = c->program;
+  exprInstructionObj *instr;
+  char *value;
+
+  if(program->numinstructions != rhsstart+1) return MS_FALSE;
+  instr = &(program->instructions[rhsstart]);
+  if(instr->op != MS_EXPR_OP_PUSH_STRING) return MS_FALSE;
+
+  value = instr->strval;
+  instr->strval = NULL;
+
+  if(token == IN) {
+    instr->strlist = splitList(value, &(instr->numlistitems));
+    if(lefttype == MS_EXPR_TYPE_NUMBER) {
+      int i;
+      instr->op = MS_EXPR_OP_IN_NUMBER_CONST;
+      instr->dbllist = (double *) msSmallMalloc(sizeof(double)*instr->numlistitems);
+      for(i=0; i<instr->numlistitems; i++)
+        instr->dbllist[i] = atof(instr->strlist[i]);
+    } else {
+      instr->op = MS_EXPR_OP_IN_STRING_CONST;
+    }
+  } else {
+    instr->op = MS_EXPR_OP_REGEX_CONST;
+    instr->regex = (ms_regex_t *) msSmallMalloc(sizeof(ms_regex_t));
+    if(ms_regcomp(instr->regex, value, MS_REG_EXTENDED|MS_REG_NOSUB|((token == MS_TOKEN_COMPARISON_IRE) ? MS_REG_ICASE : 0)) != 0) {
+      msFree(instr->regex);
+      instr->regex = NULL;
+      msFree(value);
+      return -1; /* yyparse() deals with invalid patterns */
+    }
+  }
+
+  msFree(value);
+  c->depth--; /* the constant is no longer pushed */
+  return MS_TRUE;
+}
+
+static int compileBinaryOperator(exprCompilerObj *c, int token, int type1, int type2, int rhsstart)
+{
+  exprInstructionObj *instr;
+  int status;
+
+  switch(token) {
+    case MS_TOKEN_LOGICAL_OR:
+    case MS_TOKEN_LOGICAL_AND:
+      if(!isLogical(type1) || !isLogical(type2)) return MS_EXPR_TYPE_NONE;
+      emitInstruction(c, (token == MS_TOKEN_LOGICAL_OR) ? MS_EXPR_OP_OR : MS_EXPR_OP_AND, -1);
+      return MS_EXPR_TYPE_BOOLEAN;
+    case MS_TOKEN_COMPARISON_EQ:
+    case MS_TOKEN_COMPARISON_NE:
+    case MS_TOKEN_COMPARISON_GT:
+    case MS_TOKEN_COMPARISON_LT:
+    case MS_TOKEN_COMPARISON_GE:
+    case MS_TOKEN_COMPARISON_LE:
+    case MS_TOKEN_COMPARISON_IEQ:
+      if(type1 != type2) return MS_EXPR_TYPE_NONE;
+      if(type1 == MS_EXPR_TYPE_NUMBER)
+        instr = emitInstruction(c, MS_EXPR_OP_COMPARE_NUMBER, -1);
+      else if(type1 == MS_EXPR_TYPE_STRING)
+        instr = emitInstruction(c, MS_EXPR_OP_COMPARE_STRING, -1);
+      else if(type1 == MS_EXPR_TYPE_TIME)
+        instr = emitInstruction(c, MS_EXPR_OP_COMPARE_TIME, -1);
+      else
+        return MS_EXPR_TYPE_NONE;
+      instr->arg = token;
+      return MS_EXPR_TYPE_BOOLEAN;
+    case MS_TOKEN_COMPARISON_RE:
+    case MS_TOKEN_COMPARISON_IRE:
+      if(type1 != MS_EXPR_TYPE_STRING || type2 != MS_EXPR_TYPE_STRING) return MS_EXPR_TYPE_NONE;
+      status = compileConstantOperator(c, token, type1, rhsstart);
+      if(status == -1) return MS_EXPR_TYPE_NONE;
+      if(status == MS_FALSE) {
+        instr = emitInstruction(c, MS_EXPR_OP_REGEX, -1);
+        instr->arg = (token == MS_TOKEN_COMPARISON_IRE) ? MS_REG_ICASE : 0;
+      }
+      return MS_EXPR_TYPE_BOOLEAN;
+    case IN:
+      if((type1 != MS_EXPR_TYPE_STRING && type1 != MS_EXPR_TYPE_NUMBER) || type2 != MS_EXPR_TYPE_STRING) return MS_EXPR_TYPE_NONE;
+      if(compileConstantOperator(c, token, type1, rhsstart) == MS_FALSE)
+        emitInstruction(c, (type1 == MS_EXPR_TYPE_NUMBER) ? MS_EXPR_OP_IN_NUMBER : MS_EXPR_OP_IN_STRING, -1);
+      return MS_EXPR_TYPE_BOOLEAN;
+    case '+':
+      if(type1 == MS_EXPR_TYPE_STRING && type2 == MS_EXPR_TYPE_STRING) {
+        emitInstruction(c, MS_EXPR_OP_CONCAT, -1);
+        return MS_EXPR_TYPE_STRING;
+      }
+      if(type1 != MS_EXPR_TYPE_NUMBER || type2 != MS_EXPR_TYPE_NUMBER) return MS_EXPR_TYPE_NONE;
+      emitInstruction(c, MS_EXPR_OP_ADD, -1);
+      return MS_EXPR_TYPE_NUMBER;
+    case '-':
+    case '*':
+    case '/':
+    case '%':
+    case '^':
+      if(type1 != MS_EXPR_TYPE_NUMBER || type2 != MS_EXPR_TYPE_NUMBER) return MS_EXPR_TYPE_NONE;
+      switch(token) {
+        case '-':
+          emitInstruction(c, MS_EXPR_OP_SUBTRACT, -1);
+          break;
+        case '*':
+          emitInstruction(c, MS_EXPR_OP_MULTIPLY, -1);
+          break;
+        case '/':
+          emitInstruction(c, MS_EXPR_OP_DIVIDE, -1);
+          break;
+        case '%':
+          emitInstruction(c, MS_EXPR_OP_MODULO, -1);
+          break;
+        default:
+          emitInstruction(c, MS_EXPR_OP_POWER, -1);
+          break;
+      }
+      return MS_EXPR_TYPE_NUMBER;
+    default:
+      return MS_EXPR_TYPE_NONE;
+  }
+}
+
+/* precedence climbing over the token list */
+static int compileExpression(exprCompilerObj *c, int minprecedence)
+{
+  int type1, type2, token, precedence, rhsstart;
+
+  type1 = compileOperand(c);
+
+  while(type1 != MS_EXPR_TYPE_NONE && c->curtoken) {
+    token = c->curtoken->token;
+    precedence = getPrecedence(token);
+    if(precedence == 0 || precedence < minprecedence) break;
+    c->curtoken = c->curtoken->next;
+
+    rhsstart = c->program->numinstructions;
+    type2 = compileExpression(c, (token == '^') ? precedence : precedence+1); /* ^ is right associative */
+    if(type2 == MS_EXPR_TYPE_NONE) return MS_EXPR_TYPE_NONE;
+    type1 = compileBinaryOperator(c, token, type1, type2, rhsstart);
+  }
+
+  return type1;
+}
+
+void msFreeExpressionProgram(expressionObj *exp)
+{
+  int i;
+  exprProgramObj *program;
+
+  if(!exp) return;
+
+  program = exp->program;
+  if(program) {
+    for(i=0; i<program->numinstructions; i++)
+      freeInstruction(&(program->instructions[i]));
+    msFree(program->instructions);
+    msFree(program);
+  }
+
+  exp->program = NULL;
+  exp->programstatus = MS_EXPR_PROGRAM_UNKNOWN;
+}
+
+/*
+** Compiles the token list of an MS_EXPRESSION. Returns MS_SUCCESS if a program
+** was built, MS_FAILURE if the expression must be evaluated by yyparse(). The
+** outcome is cached in exp->programstatus. Not an error condition, nothing is
+** pushed on the error stack.
+*/
+int msCompileExpression(expressionObj *exp)
+{
+  exprCompilerObj c;
+  int type;
+
+  msFreeExpressionProgram(exp);
+  exp->programstatus = MS_EXPR_PROGRAM_FALLBACK;
+
+  if(!exp->tokens) return MS_FAILURE; /* empty input, yyparse() leaves the result untouched */
+
+  c.curtoken = exp->tokens;
+  c.program = (exprProgramObj *) msSmallCalloc(1, sizeof(exprProgramObj));
+  c.depth = c.maxdepth = 0;
+
+  exp->program = c.program;
+  type = compileExpression(&c, 1);
+
+  if(type == MS_EXPR_TYPE_NONE || type == MS_EXPR_TYPE_TIME || c.curtoken != NULL || c.maxdepth > MS_EXPR_MAXSTACK) {
+    msFreeExpressionProgram(exp);
+    exp->programstatus = MS_EXPR_PROGRAM_FALLBACK;
+    return MS_FAILURE;
+  }
+
+  c.program->resulttype = type;
+  exp->programstatus = MS_EXPR_PROGRAM_COMPILED;
+  return MS_SUCCESS;
+}
+
+/*
+** Program execution.
+*/
+static void releaseValue(exprValueObj *value)
+{
+  if(value->ownedstr) free(value->ownedstr);
+  value->ownedstr = NULL;
+}
+
+static int compareNumbers(int token, double a, double b)
+{
+  switch(token) {
+    case MS_TOKEN_COMPARISON_EQ:
+    case MS_TOKEN_COMPARISON_IEQ:
+      return (a == b);
+    case MS_TOKEN_COMPARISON_NE:
+      return (a != b);
+    case MS_TOKEN_COMPARISON_GT:
+      return (a > b);
+    case MS_TOKEN_COMPARISON_LT:
+      return (a < b);
+    case MS_TOKEN_COMPARISON_GE:
+      return (a >= b);
+    case MS_TOKEN_COMPARISON_LE:
+      return (a <= b);
+  }
+  return MS_FALSE;
+}
+
+static int compareOrdering(int token, int c)
+{
+  switch(token) {
+    case MS_TOKEN_COMPARISON_EQ:
+    case MS_TOKEN_COMPARISON_IEQ:
+      return (c == 0);
+    case MS_TOKEN_COMPARISON_NE:
+      return (c != 0);
+    case MS_TOKEN_COMPARISON_GT:
+      return (c > 0);
+    case MS_TOKEN_COMPARISON_LT:
+      return (c < 0);
+    case MS_TOKEN_COMPARISON_GE:
+      return (c >= 0);
+    case MS_TOKEN_COMPARISON_LE:
+      return (c <= 0);
+  }
+  return MS_FALSE;
+}
+
+/* same semantics as the IN rules in mapparser.y */
+static int evalInString(const char *value, const char *list)
+{
+  const char *start = list, *end;
+  size_t length = strlen(value);
+
+  while((end = strchr(start, ',')) != NULL) {
+    if((size_t)(end-start) == length && strncmp(start, value, length) == 0) return MS_TRUE;
+    start = end+1;
+  }
+  return (strcmp(start, value) == 0);
+}
+
+static int evalInNumber(double value, const char *list)
+{
+  const char *start = list, *end;
+
+  while((end = strchr(start, ',')) != NULL) {
+    if(value == atof(start)) return MS_TRUE; /* atof() stops at the comma */
+    start = end+1;
+  }
+  return (value == atof(start));
+}
+
+static int evalProgram(exprProgramObj *program, parseObj *p)
+{
+  exprValueObj stack[MS_EXPR_MAXSTACK];
+  exprValueObj *top = stack-1; /* top of stack, the next free slot is top+1 */
+  exprInstructionObj *instr;
+  int i, j, status = 0;
+  char *tmpstr;
+
+  for(i=0; i<program->numinstructions; i++) {
+    instr = &(program->instructions[i]);
+
+    switch(instr->op) {
+      case MS_EXPR_OP_PUSH_NUMBER:
+        top++;
+        top->ownedstr = NULL;
+        top->dblval = instr->dblval;
+        break;
+      case MS_EXPR_OP_PUSH_STRING:
+        top++;
+        top->strval = instr->strval;
+        top->ownedstr = NULL;
+        break;
+      case MS_EXPR_OP_PUSH_TIME:
+        top++;
+        top->ownedstr = NULL;
+        top->tmval = instr->tmval;
+        break;
+      case MS_EXPR_OP_BIND_NUMBER:
+        top++;
+        top->ownedstr = NULL;
+        top->dblval = msShapeGetNumericValue(p->shape, instr->arg);
+        break;
+      case MS_EXPR_OP_BIND_STRING:
+        top++;
+        top->strval = p->shape->values[instr->arg];
+        top->ownedstr = NULL;
+        break;
+      case MS_EXPR_OP_BIND_TIME:
+        top++;
+        top->ownedstr = NULL;
+        msTimeInit(&(top->tmval));
+        if(msParseTime(p->shape->values[instr->arg], &(top->tmval)) != MS_TRUE) {
+          msSetError(MS_PARSEERR, "%s", "yyparse()", "Parsing time value failed.");
+          status = -1;
+          goto done;
+        }
+        break;
+      case MS_EXPR_OP_MAP_CELLSIZE:
+        top++;
+        top->ownedstr = NULL;
+        top->dblval = p->dblval;
+        break;
+      case MS_EXPR_OP_DATA_CELLSIZE:
+        top++;
+        top->ownedstr = NULL;
+        top->dblval = p->dblval2;
+        break;
+
+      case MS_EXPR_OP_OR:
+        top--;
+        top->dblval = (top->dblval != 0 || top[1].dblval != 0) ? MS_TRUE : MS_FALSE;
+        break;
+      case MS_EXPR_OP_AND:
+        top--;
+        top->dblval = (top->dblval != 0 && top[1].dblval != 0) ? MS_TRUE : MS_FALSE;
+        break;
+      case MS_EXPR_OP_NOT:
+        top->dblval = (top->dblval != 0) ? MS_FALSE : MS_TRUE;
+        break;
+
+      case MS_EXPR_OP_COMPARE_NUMBER:
+        top--;
+        top->dblval = compareNumbers(instr->arg, top->dblval, top[1].dblval);
+        break;
+      case MS_EXPR_OP_COMPARE_STRING: {
+        int c;
+        top--;
+        if(instr->arg == MS_TOKEN_COMPARISON_IEQ)
+          c = strcasecmp(top->strval, top[1].strval);
+        else
+          c = strcmp(top->strval, top[1].strval);
+        releaseValue(top);
+        releaseValue(top+1);
+        top->dblval = compareOrdering(instr->arg, c);
+        break;
+      }
+      case MS_EXPR_OP_COMPARE_TIME:
+        top--;
+        top->dblval = compareOrdering(instr->arg, msTimeCompare(&(top->tmval), &(top[1].tmval)));
+        break;
+
+      case MS_EXPR_OP_REGEX: {
+        ms_regex_t re;
+        int matched = MS_FALSE;
+        top--;
+        if(ms_regcomp(&re, top[1].strval, MS_REG_EXTENDED|MS_REG_NOSUB|instr->arg) == 0) {
+          matched = (ms_regexec(&re, top->strval, 0, NULL, 0) == 0);
+          ms_regfree(&re);
+        }
+        releaseValue(top);
+        releaseValue(top+1);
+        top->dblval = matched;
+        break;
+      }
+      case MS_EXPR_OP_REGEX_CONST: {
+        int matched = (ms_regexec(instr->regex, top->strval, 0, NULL, 0) == 0);
+        releaseValue(top);
+        top->dblval = matched;
+        break;
+      }
+
+      case MS_EXPR_OP_IN_STRING: {
+        int found;
+        top--;
+        found = evalInString(top->strval, top[1].strval);
+        releaseValue(top);
+        releaseValue(top+1);
+        top->dblval = found;
+        break;
+      }
+      case MS_EXPR_OP_IN_NUMBER:
+        top--;
+        top->dblval = evalInNumber(top->dblval, top[1].strval);
+        releaseValue(top+1);
+        break;
+      case MS_EXPR_OP_IN_STRING_CONST: {
+        int found = MS_FALSE;
+        for(j=0; j<instr->numlistitems; j++) {
+          if(strcmp(top->strval, instr->strlist[j]) == 0) {
+            found = MS_TRUE;
+            break;
+          }
+        }
+        releaseValue(top);
+        top->dblval = found;
+        break;
+      }
+      case MS_EXPR_OP_IN_NUMBER_CONST: {
+        int found = MS_FALSE;
+        for(j=0; j<instr->numlistitems; j++) {
+          if(top->dblval == instr->dbllist[j]) {
+            found = MS_TRUE;
+            break;
+          }
+        }
+        top->dblval = found;
+        break;
+      }
+
+      case MS_EXPR_OP_ADD:
+        top--;
+        top->dblval = top->dblval + top[1].dblval;
+        break;
+      case MS_EXPR_OP_SUBTRACT:
+        top--;
+        top->dblval = top->dblval - top[1].dblval;
+        break;
+      case MS_EXPR_OP_MULTIPLY:
+        top--;
+        top->dblval = top->dblval * top[1].dblval;
+        break;
+      case MS_EXPR_OP_DIVIDE:
+        top--;
+        if(top[1].dblval == 0.0) {
+          msSetError(MS_PARSEERR, "%s", "yyparse()", "Division by zero.");
+          status = -1;
+          goto done;
+        }
+        top->dblval = top->dblval / top[1].dblval;
+        break;
+      case MS_EXPR_OP_MODULO:
+        top--;
+        top->dblval = (int)top->dblval % (int)top[1].dblval;
+        break;
+      case MS_EXPR_OP_POWER:
+        top--;
+        top->dblval = pow(top->dblval, top[1].dblval);
+        break;
+
+      case MS_EXPR_OP_CONCAT:
+        top--;
+        tmpstr = (char *) msSmallMalloc(strlen(top->strval) + strlen(top[1].strval) + 1);
+        sprintf(tmpstr, "%s%s", top->strval, top[1].strval);
+        releaseValue(top);
+        releaseValue(top+1);
+        top->strval = top->ownedstr = tmpstr;
+        break;
+      case MS_EXPR_OP_LENGTH: {
+        double length = strlen(top->strval);
+        releaseValue(top);
+        top->dblval = length;
+        break;
+      }
+      case MS_EXPR_OP_ROUND:
+        top--;
+        top->dblval = (MS_NINT(top->dblval/top[1].dblval))*top[1].dblval;
+        break;
+      case MS_EXPR_OP_TOSTRING:
+        top--;
+        tmpstr = (char *) msSmallMalloc(strlen(top[1].strval) + 64); /* as in mapparser.y */
+        sprintf(tmpstr, top[1].strval, top->dblval);
+        releaseValue(top+1);
+        top->strval = top->ownedstr = tmpstr;
+        break;
+      case MS_EXPR_OP_COMMIFY:
+        tmpstr = top->ownedstr ? top->ownedstr : msStrdup(top->strval);
+        tmpstr = msCommifyString(tmpstr);
+        top->strval = top->ownedstr = tmpstr;
+        break;
+    }
+  }
+
+  switch(p->type) {
+    case MS_PARSE_TYPE_BOOLEAN:
+      if(program->resulttype == MS_EXPR_TYPE_STRING)
+        p->result.intval = MS_TRUE; /* a string is never NULL */
+      else
+        p->result.intval = (top->dblval != 0) ? MS_TRUE : MS_FALSE;
+      break;
+    case MS_PARSE_TYPE_STRING:
+      if(program->resulttype == MS_EXPR_TYPE_BOOLEAN) {
+        p->result.strval = msStrdup((top->dblval != 0) ? "true" : "false");
+      } else if(program->resulttype == MS_EXPR_TYPE_NUMBER) {
+        p->result.strval = (char *) msSmallMalloc(64); /* large enough for a double */
+        snprintf(p->result.strval, 64, "%g", top->dblval);
+      } else {
+        p->result.strval = top->ownedstr ? top->ownedstr : msStrdup(top->strval);
+        top->ownedstr = NULL;
+      }
+      break;
+  }
+
+done:
+  for(; top >= stack; top--)
+    releaseValue(top);
+  return status;
+}
+
+/*
+** Drop-in replacement for yyparse(): runs the compiled program of p->expr,
+** compiling it on first use, and falls back on the bison parser for anything
+** the compiler does not handle. Returns 0 on success.
+*/
+int msExecuteExpression(parseObj *p)
+{
+  expressionObj *exp = p->expr;
+
+  if(p->type != MS_PARSE_TYPE_SHAPE) {
+    if(exp->programstatus == MS_EXPR_PROGRAM_UNKNOWN)
+      msCompileExpression(exp);
+    if(exp->programstatus == MS_EXPR_PROGRAM_COMPILED)
+      return evalProgram(exp->program, p);
+  }
+
+  exp->curtoken = exp->tokens; /* reset */
+  return yyparse(p);
+}
@@ -33,6 +33,8 @@
 #include <assert.h>
 #include <ctype.h>
 #include <float.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "mapserver.h"
 #include "mapfile.h"
@@ -46,29 +48,19 @@
 
 
 
-extern int msyylex(void);
-extern void msyyrestart(FILE *);
-extern int msyylex_destroy(void);
+extern int msyylex(void *scanner);
+extern void msyyrestart(FILE *input_file, void *scanner);
 
-extern double msyynumber;
-extern int msyylineno;
-extern FILE *msyyin;
-
-extern int msyysource;
-extern int msyystate;
-extern char *msyystring;
-extern char *msyybasepath;
-extern int msyyreturncomments;
-extern char *msyystring_buffer;
-extern char msyystring_icase;
-
-extern int loadSymbol(symbolObj *s, char *symbolpath); /* in mapsymbol.c */
+extern int loadSymbol(lexerObj *lexer, symbolObj *s, char *symbolpath); /* in mapsymbol.c */
 extern void writeSymbol(symbolObj *s, FILE *stream); /* in mapsymbol.c */
-static int loadGrid( layerObj *pLayer );
-static int loadStyle(styleObj *style);
+static int loadGrid(lexerObj *lexer, layerObj *pLayer );
+static int loadStyle(lexerObj *lexer, styleObj *style);
 static void writeStyle(FILE* stream, int indent, styleObj *style);
 static int resolveSymbolNames(mapObj *map);
-static int loadExpression(expressionObj *exp);
+static int lazyLayersEnabled(mapObj *map);
+static int loadLazyLayer(lexerObj *lexer, layerObj *layer);
+static int lazyLayerContains(layerObj *layer, const char *tag);
+static int loadExpression(lexerObj *lexer, expressionObj *exp);
 static void writeExpression(FILE *stream, int indent, const char *name, expressionObj *exp);
 
 
@@ -148,13 +140,13 @@ void msFreeCharArray(char **array, int num_items)
 ** Checks symbol from lexer against variable length list of
 ** legal symbols.
 */
-int getSymbol(int n, ...)
+int getSymbol(lexerObj *lexer, int n, ...)
 {
   int symbol;
   va_list argp;
   int i=0;
 
-  symbol = msyylex();
+  symbol = msLexerNextToken(lexer);
 
   va_start(argp, n);
   while(i<n) { /* check each symbol in the list */
@@ -167,20 +159,20 @@ int getSymbol(int n, ...)
 
   va_end(argp);
 
-  msSetError(MS_SYMERR, "Parsing error near (%s):(line %d)", "getSymbol()", msyystring_buffer, msyylineno);
+  msSetError(MS_SYMERR, "Parsing error near (%s):(line %d)", "getSymbol()", lexer->string_buffer, lexer->lineno);
   return(-1);
 }
 
 /*
 ** Same as getSymbol, except no error message is set on failure
 */
-int getSymbol2(int n, ...)
+int getSymbol2(lexerObj *lexer, int n, ...)
 {
   int symbol;
   va_list argp;
   int i=0;
 
-  symbol = msyylex();
+  symbol = msLexerNextToken(lexer);
 
   va_start(argp, n);
   while(i<n) { /* check each symbol in the list */
@@ -199,67 +191,67 @@ int getSymbol2(int n, ...)
 ** Get a string or symbol as a string.   Operates like getString(), but also
 ** supports symbols.
 */
-static char *getToken(void)
+static char *getToken(lexerObj *lexer)
 {
-  msyylex();
-  return msStrdup(msyystring_buffer);
+  msLexerNextToken(lexer);
+  return msStrdup(lexer->string_buffer);
 }
 
 /*
 ** Load a string from the map file. A "string" is defined in lexer.l.
 */
-int getString(char **s)
+int getString(lexerObj *lexer, char **s)
 {
   /* if (*s)
-    msSetError(MS_SYMERR, "Duplicate item (%s):(line %d)", "getString()", msyystring_buffer, msyylineno);
+    msSetError(MS_SYMERR, "Duplicate item (%s):(line %d)", "getString()", lexer->string_buffer, lexer->lineno);
     return(MS_FAILURE);
   } else */
-  if(msyylex() == MS_STRING) {
+  if(msLexerNextToken(lexer) == MS_STRING) {
     if(*s) free(*s); /* avoid leak */
-    *s = msStrdup(msyystring_buffer);
+    *s = msStrdup(lexer->string_buffer);
     return(MS_SUCCESS);
   }
 
-  msSetError(MS_SYMERR, "Parsing error near (%s):(line %d)", "getString()", msyystring_buffer, msyylineno);
+  msSetError(MS_SYMERR, "Parsing error near (%s):(line %d)", "getString()", lexer->string_buffer, lexer->lineno);
   return(MS_FAILURE);
 }
 
 /*
 ** Load a floating point number from the map file. (see lexer.l)
 */
-int getDouble(double *d)
+int getDouble(lexerObj *lexer, double *d)
 {
-  if(msyylex() == MS_NUMBER) {
-    *d = msyynumber;
+  if(msLexerNextToken(lexer) == MS_NUMBER) {
+    *d = lexer->number;
     return(0); /* success */
   }
 
-  msSetError(MS_SYMERR, "Parsing error near (%s):(line %d)", "getDouble()", msyystring_buffer, msyylineno);
+  msSetError(MS_SYMERR, "Parsing error near (%s):(line %d)", "getDouble()", lexer->string_buffer, lexer->lineno);
   return(-1);
 }
 
 /*
 ** Load a integer from the map file. (see lexer.l)
 */
-int getInteger(int *i)
+int getInteger(lexerObj *lexer, int *i)
 {
-  if(msyylex() == MS_NUMBER) {
-    *i = (int)msyynumber;
+  if(msLexerNextToken(lexer) == MS_NUMBER) {
+    *i = (int)lexer->number;
     return(0); /* success */
   }
 
-  msSetError(MS_SYMERR, "Parsing error near (%s):(line %d)", "getInteger()", msyystring_buffer, msyylineno);
+  msSetError(MS_SYMERR, "Parsing error near (%s):(line %d)", "getInteger()", lexer->string_buffer, lexer->lineno);
   return(-1);
 }
 
-int getCharacter(char *c)
+int getCharacter(lexerObj *lexer, char *c)
 {
-  if(msyylex() == MS_STRING) {
-    *c = msyystring_buffer[0];
+  if(msLexerNextToken(lexer) == MS_STRING) {
+    *c = lexer->string_buffer[0];
     return(0);
   }
 
-  msSetError(MS_SYMERR, "Parsing error near (%s):(line %d)", "getCharacter()", msyystring_buffer, msyylineno);
+  msSetError(MS_SYMERR, "Parsing error near (%s):(line %d)", "getCharacter()", lexer->string_buffer, lexer->lineno);
   return(-1);
 }
 
@@ -267,16 +259,16 @@ int getCharacter(char *c)
 ** Try to load as an integer, then try as a named symbol.
 ** Part of work on bug 490.
 */
-int getIntegerOrSymbol(int *i, int n, ...)
+int getIntegerOrSymbol(lexerObj *lexer, int *i, int n, ...)
 {
   int symbol;
   va_list argp;
   int j=0;
 
-  symbol = msyylex();
+  symbol = msLexerNextToken(lexer);
 
   if (symbol == MS_NUMBER) {
-    *i = (int)msyynumber;
+    *i = (int)lexer->number;
     return MS_SUCCESS; /* success */
   }
 
@@ -292,7 +284,7 @@ int getIntegerOrSymbol(int *i, int n, ...)
   va_end(argp);
 
   msSetError(MS_SYMERR, "Parsing error near (%s):(line %d)",
-             "getIntegerOrSymbol()", msyystring_buffer, msyylineno);
+             "getIntegerOrSymbol()", lexer->string_buffer, lexer->lineno);
   return(-1);
 }
 
@@ -327,6 +319,93 @@ int msBuildPluginLibraryPath(char **dest, const char *lib_str, mapObj *map)
   return MS_SUCCESS;
 }
 
+/*
+** Name indexes behind msGetLayerIndex(), msGetClassIndex() and
+** msGetSymbolIndex(). The index only ever grows with the array it covers:
+** elements appended since the last lookup (by the loaders, msInsertLayer(),
+** msGrowMapLayers() users, mapscript...) are added on the next lookup, and
+** the functions that shift or reorder elements drop the whole index with
+** msFreeNameIndex(). Because a name can also be changed in place, a hit is
+** checked against the element it points to and a miss is confirmed with the
+** old linear scan, which rebuilds the index if it finds the name after all.
+*/
+typedef char *(*nameIndexGetter)(void *owner, int i);
+
+void msInitNameIndex(nameIndexObj *index)
+{
+  initHashTable(&(index->names));
+  index->numindexed = 0;
+}
+
+void msFreeNameIndex(nameIndexObj *index)
+{
+  msFreeHashItems(&(index->names));
+  index->numindexed = 0;
+}
+
+static void updateNameIndex(nameIndexObj *index, void *owner, nameIndexGetter getName, int first, int count)
+{
+  char position[32], *name;
+  int i;
+
+  if(count < index->numindexed) /* elements went away behind our back */
+    msFreeNameIndex(index);
+
+  for(i=MS_MAX(index->numindexed, first); i<count; i++) {
+    name = getName(owner, i);
+    if(!name || msLookupHashTable(&(index->names), name) != NULL)
+      continue;
+    snprintf(position, sizeof(position), "%d", i);
+    msInsertHashTable(&(index->names), name, position);
+  }
+  index->numindexed = count;
+}
+
+static int lookupNameIndex(nameIndexObj *index, void *owner, nameIndexGetter getName, int first, int count, const char *name, int casesensitive)
+{
+  char *value, *candidate;
+  int i, stale = MS_FALSE;
+
+  updateNameIndex(index, owner, getName, first, count);
+
+  if((value = msLookupHashTable(&(index->names), name)) != NULL) {
+    i = atoi(value);
+    candidate = (i >= first && i < count) ? getName(owner, i) : NULL;
+    if(candidate && (casesensitive ? strcmp(candidate, name) : strcasecmp(candidate, name)) == 0)
+      return(i);
+    /* the index is case insensitive, anything else means it is out of date */
+    stale = (candidate == NULL || strcasecmp(candidate, name) != 0);
+  }
+
+  for(i=first; i<count; i++) {
+    candidate = getName(owner, i);
+    if(candidate && (casesensitive ? strcmp(candidate, name) : strcasecmp(candidate, name)) == 0)
+      break;
+  }
+  if(i == count)
+    i = -1;
+  if(stale || (value == NULL && i != -1)) { /* renamed in place */
+    msFreeNameIndex(index);
+    updateNameIndex(index, owner, getName, first, count);
+  }
+  return(i);
+}
+
+static char *getSymbolName(void *owner, int i)
+{
+  return ((symbolSetObj *) owner)->symbol[i]->name;
+}
+
+static char *getLayerName(void *owner, int i)
+{
+  return ((mapObj *) owner)->layers[i]->name; /* names are set on lazy layers too */
+}
+
+static char *getClassName(void *owner, int i)
+{
+  return ((layerObj *) owner)->class[i]->name;
+}
+
 /*
 ** Returns the index of specified symbol or -1 if not found.
 **
@@ -340,10 +419,9 @@ int msGetSymbolIndex(symbolSetObj *symbols, char *name, int try_addimage_if_notf
   if(!symbols || !name) return(-1);
 
   /* symbol 0 has no name */
-  for(i=1; i<symbols->numsymbols; i++) {
-    if(symbols->symbol[i]->name)
-      if(strcasecmp(symbols->symbol[i]->name, name) == 0) return(i);
-  }
+  i = lookupNameIndex(&(symbols->nameindex), symbols, getSymbolName, 1, symbols->numsymbols, name, MS_FALSE);
+  if(i != -1)
+    return(i);
 
   if (try_addimage_if_notfound)
     return(msAddImageSymbol(symbols, name)); /* make sure it's not a filename */
@@ -356,74 +434,58 @@ int msGetSymbolIndex(symbolSetObj *symbols, char *name, int try_addimage_if_notf
 */
 int msGetLayerIndex(mapObj *map, char *name)
 {
-  int i;
-
   if(!name) return(-1);
 
-  for(i=0; i<map->numlayers; i++) {
-    if(!GET_LAYER(map, i)->name) /* skip it */
-      continue;
-    if(strcmp(name, GET_LAYER(map, i)->name) == 0)
-      return(i);
-  }
-  return(-1);
+  return lookupNameIndex(&(map->layerindex), map, getLayerName, 0, map->numlayers, name, MS_TRUE);
 }
 
 int msGetClassIndex(layerObj *layer, char *name)
 {
-  int i;
-
   if(!name) return(-1);
 
-  for(i=0; i<layer->numclasses; i++) {
-    if(!layer->class[i]->name) /* skip it */
-      continue;
-    if(strcmp(name, layer->class[i]->name) == 0)
-      return(i);
-  }
-  return(-1);
+  return lookupNameIndex(&(layer->classindex), layer, getClassName, 0, layer->numclasses, name, MS_TRUE);
 }
 
-int loadColor(colorObj *color, attributeBindingObj *binding)
+int loadColor(lexerObj *lexer, colorObj *color, attributeBindingObj *binding)
 {
   int symbol;
   char hex[2];
 
   if(binding) {
-    if((symbol = getSymbol(3, MS_NUMBER, MS_BINDING, MS_STRING)) == -1) return MS_FAILURE;
+    if((symbol = getSymbol(lexer, 3, MS_NUMBER, MS_BINDING, MS_STRING)) == -1) return MS_FAILURE;
   } else {
-    if((symbol = getSymbol(2, MS_NUMBER, MS_STRING)) == -1) return MS_FAILURE;
+    if((symbol = getSymbol(lexer, 2, MS_NUMBER, MS_STRING)) == -1) return MS_FAILURE;
   }
 
   color->alpha=255;
   if(symbol == MS_NUMBER) {
-    color->red = (int) msyynumber;
-    if(getInteger(&(color->green)) == -1) return MS_FAILURE;
-    if(getInteger(&(color->blue)) == -1) return MS_FAILURE;
+    color->red = (int) lexer->number;
+    if(getInteger(lexer, &(color->green)) == -1) return MS_FAILURE;
+    if(getInteger(lexer, &(color->blue)) == -1) return MS_FAILURE;
   } else if(symbol == MS_STRING) {
-    int len = strlen(msyystring_buffer);
-    if(msyystring_buffer[0] == '#' && (len == 7 || len == 9)) { /* got a hex color w/optional alpha */
-      hex[0] = msyystring_buffer[1];
-      hex[1] = msyystring_buffer[2];
+    int len = strlen(lexer->string_buffer);
+    if(lexer->string_buffer[0] == '#' && (len == 7 || len == 9)) { /* got a hex color w/optional alpha */
+      hex[0] = lexer->string_buffer[1];
+      hex[1] = lexer->string_buffer[2];
       color->red = msHexToInt(hex);
-      hex[0] = msyystring_buffer[3];
-      hex[1] = msyystring_buffer[4];
+      hex[0] = lexer->string_buffer[3];
+      hex[1] = lexer->string_buffer[4];
       color->green = msHexToInt(hex);
-      hex[0] = msyystring_buffer[5];
-      hex[1] = msyystring_buffer[6];
+      hex[0] = lexer->string_buffer[5];
+      hex[1] = lexer->string_buffer[6];
       color->blue = msHexToInt(hex);
       if(len == 9) {
-        hex[0] = msyystring_buffer[7];
-        hex[1] = msyystring_buffer[8];
+        hex[0] = lexer->string_buffer[7];
+        hex[1] = lexer->string_buffer[8];
         color->alpha = msHexToInt(hex);
       }
     } else {
       /* TODO: consider named colors here */
-      msSetError(MS_SYMERR, "Invalid hex color (%s):(line %d)", "loadColor()", msyystring_buffer, msyylineno);
+      msSetError(MS_SYMERR, "Invalid hex color (%s):(line %d)", "loadColor()", lexer->string_buffer, lexer->lineno);
       return MS_FAILURE;
     }
   } else {
-    binding->item = msStrdup(msyystring_buffer);
+    binding->item = msStrdup(lexer->string_buffer);
     binding->index = -1;
   }
 
@@ -431,44 +493,44 @@ int loadColor(colorObj *color, attributeBindingObj *binding)
 }
 
 #if ALPHACOLOR_ENABLED
-int loadColorWithAlpha(colorObj *color)
+int loadColorWithAlpha(lexerObj *lexer, colorObj *color)
 {
   char hex[2];
 
-  if(getInteger(&(color->red)) == -1) {
-    if(msyystring_buffer[0] == '#' && strlen(msyystring_buffer) == 7) { /* got a hex color */
-      hex[0] = msyystring_buffer[1];
-      hex[1] = msyystring_buffer[2];
+  if(getInteger(lexer, &(color->red)) == -1) {
+    if(lexer->string_buffer[0] == '#' && strlen(lexer->string_buffer) == 7) { /* got a hex color */
+      hex[0] = lexer->string_buffer[1];
+      hex[1] = lexer->string_buffer[2];
       color->red = msHexToInt(hex);
-      hex[0] = msyystring_buffer[3];
-      hex[1] = msyystring_buffer[4];
+      hex[0] = lexer->string_buffer[3];
+      hex[1] = lexer->string_buffer[4];
       color->green = msHexToInt(hex);
-      hex[0] = msyystring_buffer[5];
-      hex[1] = msyystring_buffer[6];
+      hex[0] = lexer->string_buffer[5];
+      hex[1] = lexer->string_buffer[6];
       color->blue = msHexToInt(hex);
       color->alpha = 0;
 
       return(MS_SUCCESS);
-    } else if(msyystring_buffer[0] == '#' && strlen(msyystring_buffer) == 9) { /* got a hex color with alpha */
-      hex[0] = msyystring_buffer[1];
-      hex[1] = msyystring_buffer[2];
+    } else if(lexer->string_buffer[0] == '#' && strlen(lexer->string_buffer) == 9) { /* got a hex color with alpha */
+      hex[0] = lexer->string_buffer[1];
+      hex[1] = lexer->string_buffer[2];
       color->red = msHexToInt(hex);
-      hex[0] = msyystring_buffer[3];
-      hex[1] = msyystring_buffer[4];
+      hex[0] = lexer->string_buffer[3];
+      hex[1] = lexer->string_buffer[4];
       color->green = msHexToInt(hex);
-      hex[0] = msyystring_buffer[5];
-      hex[1] = msyystring_buffer[6];
+      hex[0] = lexer->string_buffer[5];
+      hex[1] = lexer->string_buffer[6];
       color->blue = msHexToInt(hex);
-      hex[0] = msyystring_buffer[7];
-      hex[1] = msyystring_buffer[8];
+      hex[0] = lexer->string_buffer[7];
+      hex[1] = lexer->string_buffer[8];
       color->alpha = msHexToInt(hex);
       return(MS_SUCCESS);
     }
     return(MS_FAILURE);
   }
-  if(getInteger(&(color->green)) == -1) return(MS_FAILURE);
-  if(getInteger(&(color->blue)) == -1) return(MS_FAILURE);
-  if(getInteger(&(color->alpha)) == -1) return(MS_FAILURE);
+  if(getInteger(lexer, &(color->green)) == -1) return(MS_FAILURE);
+  if(getInteger(lexer, &(color->blue)) == -1) return(MS_FAILURE);
+  if(getInteger(lexer, &(color->alpha)) == -1) return(MS_FAILURE);
 
   return(MS_SUCCESS);
 }
@@ -658,9 +720,9 @@ static void writeColor(FILE *stream, int indent, const char *name, colorObj *def
     sprintf(buffer+4, "%02x", color->blue);
     sprintf(buffer+6, "%02x", color->alpha);
     *(buffer+8) = 0;
-    fprintf(stream, "%s \"#%s\"\n", name, buffer);
+    msIO_fprintf(stream, "%s \"#%s\"\n", name, buffer);
   } else {
-    fprintf(stream, "%s %d %d %d\n", name, color->red, color->green, color->blue);
+    msIO_fprintf(stream, "%s %d %d %d\n", name, color->red, color->green, color->blue);
   }
 #endif
 }
@@ -721,17 +783,17 @@ void freeJoin(joinObj *join)
   msFree(join->connection);
 }
 
-int loadJoin(joinObj *join)
+int loadJoin(lexerObj *lexer, joinObj *join)
 {
   initJoin(join);
 
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(CONNECTION):
-        if(getString(&join->connection) == MS_FAILURE) return(-1);
+        if(getString(lexer, &join->connection) == MS_FAILURE) return(-1);
         break;
       case(CONNECTIONTYPE):
-        if((join->connectiontype = getSymbol(5, MS_DB_XBASE, MS_DB_MYSQL, MS_DB_ORACLE, MS_DB_POSTGRES, MS_DB_CSV)) == -1) return(-1);
+        if((join->connectiontype = getSymbol(lexer, 5, MS_DB_XBASE, MS_DB_MYSQL, MS_DB_ORACLE, MS_DB_POSTGRES, MS_DB_CSV)) == -1) return(-1);
         break;
       case(EOF):
         msSetError(MS_EOFERR, NULL, "loadJoin()");
@@ -747,33 +809,33 @@ int loadJoin(joinObj *join)
         }
         return(0);
       case(FOOTER):
-        if(getString(&join->footer) == MS_FAILURE) return(-1);
+        if(getString(lexer, &join->footer) == MS_FAILURE) return(-1);
         break;
       case(FROM):
-        if(getString(&join->from) == MS_FAILURE) return(-1);
+        if(getString(lexer, &join->from) == MS_FAILURE) return(-1);
         break;
       case(HEADER):
-        if(getString(&join->header) == MS_FAILURE) return(-1);
+        if(getString(lexer, &join->header) == MS_FAILURE) return(-1);
         break;
       case(JOIN):
         break; /* for string loads */
       case(NAME):
-        if(getString(&join->name) == MS_FAILURE) return(-1);
+        if(getString(lexer, &join->name) == MS_FAILURE) return(-1);
         break;
       case(TABLE):
-        if(getString(&join->table) == MS_FAILURE) return(-1);
+        if(getString(lexer, &join->table) == MS_FAILURE) return(-1);
         break;
       case(TEMPLATE):
-        if(getString(&join->template) == MS_FAILURE) return(-1);
+        if(getString(lexer, &join->template) == MS_FAILURE) return(-1);
         break;
       case(TO):
-        if(getString(&join->to) == MS_FAILURE) return(-1);
+        if(getString(lexer, &join->to) == MS_FAILURE) return(-1);
         break;
       case(TYPE):
-        if((join->type = getSymbol(2, MS_JOIN_ONE_TO_ONE, MS_JOIN_ONE_TO_MANY)) == -1) return(-1);
+        if((join->type = getSymbol(lexer, 2, MS_JOIN_ONE_TO_ONE, MS_JOIN_ONE_TO_MANY)) == -1) return(-1);
         break;
       default:
-        msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadJoin()", msyystring_buffer, msyylineno);
+        msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadJoin()", lexer->string_buffer, lexer->lineno);
         return(-1);
     }
   } /* next token */
@@ -857,7 +919,7 @@ void freeFeatureList(featureListNodeObjPtr list)
 }
 
 /* lineObj = multipointObj */
-static int loadFeaturePoints(lineObj *points)
+static int loadFeaturePoints(lexerObj *lexer, lineObj *points)
 {
   int buffer_size=0;
 
@@ -867,7 +929,7 @@ static int loadFeaturePoints(lineObj *points)
   buffer_size = MS_FEATUREINITSIZE;
 
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(EOF):
         msSetError(MS_EOFERR, NULL, "loadFeaturePoints()");
         return(MS_FAILURE);
@@ -880,19 +942,19 @@ static int loadFeaturePoints(lineObj *points)
           buffer_size+=MS_FEATUREINCREMENT;
         }
 
-        points->point[points->numpoints].x = atof(msyystring_buffer);
-        if(getDouble(&(points->point[points->numpoints].y)) == -1) return(MS_FAILURE);
+        points->point[points->numpoints].x = atof(lexer->string_buffer);
+        if(getDouble(lexer, &(points->point[points->numpoints].y)) == -1) return(MS_FAILURE);
 
         points->numpoints++;
         break;
       default:
-        msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadFeaturePoints()",  msyystring_buffer, msyylineno );
+        msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadFeaturePoints()",  lexer->string_buffer, lexer->lineno );
         return(MS_FAILURE);
     }
   }
 }
 
-static int loadFeature(layerObj *player, int type)
+static int loadFeature(lexerObj *lexer, layerObj *player, int type)
 {
   int status=MS_SUCCESS;
   featureListNodeObjPtr *list = &(player->features);
@@ -907,7 +969,7 @@ static int loadFeature(layerObj *player, int type)
   shape->type = type;
 
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(EOF):
         msSetError(MS_EOFERR, NULL, "loadFeature()");
         return(MS_FAILURE);
@@ -926,7 +988,7 @@ static int loadFeature(layerObj *player, int type)
       case(FEATURE):
         break; /* for string loads */
       case(POINTS):
-        if(loadFeaturePoints(&points) == MS_FAILURE) return(MS_FAILURE); /* no clean up necessary, just return */
+        if(loadFeaturePoints(lexer, &points) == MS_FAILURE) return(MS_FAILURE); /* no clean up necessary, just return */
         status = msAddLine(shape, &points);
 
         msFree(points.point); /* clean up */
@@ -936,7 +998,7 @@ static int loadFeature(layerObj *player, int type)
         break;
       case(ITEMS): {
         char *string=NULL;
-        if(getString(&string) == MS_FAILURE) return(MS_FAILURE);
+        if(getString(lexer, &string) == MS_FAILURE) return(MS_FAILURE);
         if (string) {
           if(shape->values) msFreeCharArray(shape->values, shape->numvalues);
           shape->values = msStringSplit(string, ';', &shape->numvalues);
@@ -945,14 +1007,14 @@ static int loadFeature(layerObj *player, int type)
         break;
       }
       case(TEXT):
-        if(getString(&shape->text) == MS_FAILURE) return(MS_FAILURE);
+        if(getString(lexer, &shape->text) == MS_FAILURE) return(MS_FAILURE);
         break;
       case(WKT): {
         char *string=NULL;
 
         /* todo, what do we do with multiple WKT property occurances? */
 
-        if(getString(&string) == MS_FAILURE) return(MS_FAILURE);
+        if(getString(lexer, &string) == MS_FAILURE) return(MS_FAILURE);
         msFreeShape(shape);
         msFree(shape);
         if((shape = msShapeFromWKT(string)) == NULL)
@@ -964,7 +1026,7 @@ static int loadFeature(layerObj *player, int type)
         break;
       }
       default:
-        msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadfeature()", msyystring_buffer, msyylineno);
+        msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadfeature()", lexer->string_buffer, lexer->lineno);
         return(MS_FAILURE);
     }
   } /* next token */
@@ -1009,10 +1071,10 @@ void initGrid( graticuleObj *pGraticule )
   memset( pGraticule, 0, sizeof( graticuleObj ) );
 }
 
-static int loadGrid( layerObj *pLayer )
+static int loadGrid(lexerObj *lexer, layerObj *pLayer )
 {
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(EOF):
         msSetError(MS_EOFERR, NULL, "loadGrid()");
         return(-1);
@@ -1021,39 +1083,39 @@ static int loadGrid( layerObj *pLayer )
       case(GRID):
         break; /* for string loads */
       case( LABELFORMAT ):
-        if(getString(&((graticuleObj *)pLayer->layerinfo)->labelformat) == MS_FAILURE) {
-          if(strcasecmp(msyystring_buffer, "DD") == 0) /* DD triggers a symbol to be returned instead of a string so check for this special case */
+        if(getString(lexer, &((graticuleObj *)pLayer->layerinfo)->labelformat) == MS_FAILURE) {
+          if(strcasecmp(lexer->string_buffer, "DD") == 0) /* DD triggers a symbol to be returned instead of a string so check for this special case */
             ((graticuleObj *)pLayer->layerinfo)->labelformat = msStrdup("DD");
           else
             return(-1);
         }
         break;
       case( MINARCS ):
-        if(getDouble(&((graticuleObj *)pLayer->layerinfo)->minarcs) == -1)
+        if(getDouble(lexer, &((graticuleObj *)pLayer->layerinfo)->minarcs) == -1)
           return(-1);
         break;
       case( MAXARCS ):
-        if(getDouble(&((graticuleObj *)pLayer->layerinfo)->maxarcs) == -1)
+        if(getDouble(lexer, &((graticuleObj *)pLayer->layerinfo)->maxarcs) == -1)
           return(-1);
         break;
       case( MININTERVAL ):
-        if(getDouble(&((graticuleObj *)pLayer->layerinfo)->minincrement) == -1)
+        if(getDouble(lexer, &((graticuleObj *)pLayer->layerinfo)->minincrement) == -1)
           return(-1);
         break;
       case( MAXINTERVAL ):
-        if(getDouble(&((graticuleObj *)pLayer->layerinfo)->maxincrement) == -1)
+        if(getDouble(lexer, &((graticuleObj *)pLayer->layerinfo)->maxincrement) == -1)
           return(-1);
         break;
       case( MINSUBDIVIDE ):
-        if(getDouble(&((graticuleObj *)pLayer->layerinfo)->minsubdivides) == -1)
+        if(getDouble(lexer, &((graticuleObj *)pLayer->layerinfo)->minsubdivides) == -1)
           return(-1);
         break;
       case( MAXSUBDIVIDE ):
-        if(getDouble(&((graticuleObj *)pLayer->layerinfo)->maxsubdivides) == -1)
+        if(getDouble(lexer, &((graticuleObj *)pLayer->layerinfo)->maxsubdivides) == -1)
           return(-1);
         break;
       default:
-        msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadGrid()", msyystring_buffer, msyylineno);
+        msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadGrid()", lexer->string_buffer, lexer->lineno);
         return(-1);
     }
   }
@@ -1309,7 +1371,7 @@ int msProcessProjection(projectionObj *p)
 #endif
 }
 
-static int loadProjection(projectionObj *p)
+static int loadProjection(lexerObj *lexer, projectionObj *p)
 {
 #ifdef USE_PROJ
   int i=0;
@@ -1321,12 +1383,12 @@ static int loadProjection(projectionObj *p)
 
   if ( p->proj != NULL ) {
     msSetError(MS_MISCERR, "Projection is already initialized. Multiple projection definitions are not allowed in this object. (line %d)",
-               "loadProjection()", msyylineno);
+               "loadProjection()", lexer->lineno);
     return(-1);
   }
 
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(EOF):
         msSetError(MS_EOFERR, NULL, "loadProjection()");
         return(-1);
@@ -1349,13 +1411,13 @@ static int loadProjection(projectionObj *p)
         break;
       case(MS_STRING):
       case(MS_AUTO):
-        p->args[i] = msStrdup(msyystring_buffer);
+        p->args[i] = msStrdup(lexer->string_buffer);
         p->automatic = MS_TRUE;
         i++;
         break;
       default:
         msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadProjection()",
-                   msyystring_buffer, msyylineno);
+                   lexer->string_buffer, lexer->lineno);
         return(-1);
     }
   } /* next token */
@@ -1805,10 +1867,10 @@ int freeLabel(labelObj *label)
   return MS_SUCCESS;
 }
 
-static int loadLeader(labelLeaderObj *leader)
+static int loadLeader(lexerObj *lexer, labelLeaderObj *leader)
 {
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(END):
         return(0);
         break;
@@ -1816,21 +1878,21 @@ static int loadLeader(labelLeaderObj *leader)
         msSetError(MS_EOFERR, NULL, "loadLeader()");
         return(-1);
       case GRIDSTEP:
-        if(getInteger(&(leader->gridstep)) == -1) return(-1);
+        if(getInteger(lexer, &(leader->gridstep)) == -1) return(-1);
         break;
       case MAXDISTANCE:
-        if(getInteger(&(leader->maxdistance)) == -1) return(-1);
+        if(getInteger(lexer, &(leader->maxdistance)) == -1) return(-1);
         break;
       case STYLE:
         if(msGrowLeaderStyles(leader) == NULL)
           return(-1);
         initStyle(leader->styles[leader->numstyles]);
-        if(loadStyle(leader->styles[leader->numstyles]) != MS_SUCCESS) return(-1);
+        if(loadStyle(lexer, leader->styles[leader->numstyles]) != MS_SUCCESS) return(-1);
         leader->numstyles++;
         break;
       default:
-        if(strlen(msyystring_buffer) > 0) {
-          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadLeader()", msyystring_buffer, msyylineno);
+        if(strlen(lexer->string_buffer) > 0) {
+          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadLeader()", lexer->string_buffer, lexer->lineno);
           return(-1);
         } else {
           return(0); /* end of a string, not an error */
@@ -1839,22 +1901,22 @@ static int loadLeader(labelLeaderObj *leader)
   }
 }
 
-static int loadLabel(labelObj *label)
+static int loadLabel(lexerObj *lexer, labelObj *label)
 {
   int symbol;
 
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(ANGLE):
-        if((symbol = getSymbol(5, MS_NUMBER,MS_AUTO,MS_AUTO2,MS_FOLLOW,MS_BINDING)) == -1)
+        if((symbol = getSymbol(lexer, 5, MS_NUMBER,MS_AUTO,MS_AUTO2,MS_FOLLOW,MS_BINDING)) == -1)
           return(-1);
 
         if(symbol == MS_NUMBER)
-          label->angle = msyynumber;
+          label->angle = lexer->number;
         else if(symbol == MS_BINDING) {
           if (label->bindings[MS_LABEL_BINDING_ANGLE].item != NULL)
             msFree(label->bindings[MS_LABEL_BINDING_ANGLE].item);
-          label->bindings[MS_LABEL_BINDING_ANGLE].item = msStrdup(msyystring_buffer);
+          label->bindings[MS_LABEL_BINDING_ANGLE].item = msStrdup(lexer->string_buffer);
           label->numbindings++;
         } else if ( symbol == MS_FOLLOW ) {
           label->anglemode = MS_FOLLOW;
@@ -1864,21 +1926,21 @@ static int loadLabel(labelObj *label)
           label->anglemode = MS_AUTO;
         break;
       case(ALIGN):
-        if((label->align = getSymbol(3, MS_ALIGN_LEFT,MS_ALIGN_CENTER,MS_ALIGN_RIGHT)) == -1) return(-1);
+        if((label->align = getSymbol(lexer, 3, MS_ALIGN_LEFT,MS_ALIGN_CENTER,MS_ALIGN_RIGHT)) == -1) return(-1);
         break;
       case(ANTIALIAS):
-        if((label->antialias = getSymbol(2, MS_TRUE,MS_FALSE)) == -1)
+        if((label->antialias = getSymbol(lexer, 2, MS_TRUE,MS_FALSE)) == -1)
           return(-1);
         break;
       case(BUFFER):
-        if(getInteger(&(label->buffer)) == -1) return(-1);
+        if(getInteger(lexer, &(label->buffer)) == -1) return(-1);
         break;
       case(COLOR):
-        if(loadColor(&(label->color), &(label->bindings[MS_LABEL_BINDING_COLOR])) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(label->color), &(label->bindings[MS_LABEL_BINDING_COLOR])) != MS_SUCCESS) return(-1);
         if(label->bindings[MS_LABEL_BINDING_COLOR].item) label->numbindings++;
         break;
       case(ENCODING):
-        if((getString(&label->encoding)) == MS_FAILURE) return(-1);
+        if((getString(lexer, &label->encoding)) == MS_FAILURE) return(-1);
         break;
       case(END):
         /* sanity check */
@@ -1893,30 +1955,30 @@ static int loadLabel(labelObj *label)
         freeLabel(label);       /* free any structures allocated before EOF */
         return(-1);
       case(EXPRESSION):
-        if(loadExpression(&(label->expression)) == -1) return(-1); /* loadExpression() cleans up previously allocated expression */
-        if(msyysource == MS_URL_TOKENS) {
+        if(loadExpression(lexer, &(label->expression)) == -1) return(-1); /* loadExpression() cleans up previously allocated expression */
+        if(lexer->source == MS_URL_TOKENS) {
           msSetError(MS_MISCERR, "URL-based EXPRESSION configuration not supported." , "loadLabel()");
           freeExpression(&(label->expression));
           return(-1);
         }
         break;
       case(FONT):
-        if((symbol = getSymbol(2, MS_STRING, MS_BINDING)) == -1)
+        if((symbol = getSymbol(lexer, 2, MS_STRING, MS_BINDING)) == -1)
           return(-1);
 
         if(symbol == MS_STRING) {
           if (label->font != NULL)
             msFree(label->font);
-          label->font = msStrdup(msyystring_buffer);
+          label->font = msStrdup(lexer->string_buffer);
         } else {
           if (label->bindings[MS_LABEL_BINDING_FONT].item != NULL)
             msFree(label->bindings[MS_LABEL_BINDING_FONT].item);
-          label->bindings[MS_LABEL_BINDING_FONT].item = msStrdup(msyystring_buffer);
+          label->bindings[MS_LABEL_BINDING_FONT].item = msStrdup(lexer->string_buffer);
           label->numbindings++;
         }
         break;
       case(FORCE):
-        switch(msyylex()) {
+        switch(msLexerNextToken(lexer)) {
           case MS_ON:
             label->force = MS_ON;
             break;
@@ -1936,70 +1998,70 @@ static int loadLabel(labelObj *label)
       case(LEADER):
         msSetError(MS_MISCERR, "LABEL LEADER not implemented. LEADER goes at the CLASS level." , "loadLabel()");
         return(-1);
-        if(loadLeader(&(label->leader)) == -1) return(-1);
+        if(loadLeader(lexer, &(label->leader)) == -1) return(-1);
         break;
       case(MAXSIZE):
-        if(getDouble(&(label->maxsize)) == -1) return(-1);
+        if(getDouble(lexer, &(label->maxsize)) == -1) return(-1);
         break;
       case(MAXSCALEDENOM):
-        if(getDouble(&(label->maxscaledenom)) == -1) return(-1);
+        if(getDouble(lexer, &(label->maxscaledenom)) == -1) return(-1);
         break;
       case(MAXLENGTH):
-        if(getInteger(&(label->maxlength)) == -1) return(-1);
+        if(getInteger(lexer, &(label->maxlength)) == -1) return(-1);
         break;
       case(MINLENGTH):
-        if(getInteger(&(label->minlength)) == -1) return(-1);
+        if(getInteger(lexer, &(label->minlength)) == -1) return(-1);
         break;
       case(MINDISTANCE):
-        if(getInteger(&(label->mindistance)) == -1) return(-1);
+        if(getInteger(lexer, &(label->mindistance)) == -1) return(-1);
         break;
       case(REPEATDISTANCE):
-        if(getInteger(&(label->repeatdistance)) == -1) return(-1);
+        if(getInteger(lexer, &(label->repeatdistance)) == -1) return(-1);
         break;
       case(MAXOVERLAPANGLE):
-        if(getDouble(&(label->maxoverlapangle)) == -1) return(-1);
+        if(getDouble(lexer, &(label->maxoverlapangle)) == -1) return(-1);
         break;
       case(MINFEATURESIZE):
-        if((symbol = getSymbol(2, MS_NUMBER,MS_AUTO)) == -1)  return(-1);
+        if((symbol = getSymbol(lexer, 2, MS_NUMBER,MS_AUTO)) == -1)  return(-1);
         if(symbol == MS_NUMBER)
-          label->minfeaturesize = (int)msyynumber;
+          label->minfeaturesize = (int)lexer->number;
         else
           label->autominfeaturesize = MS_TRUE;
         break;
       case(MINSCALEDENOM):
-        if(getDouble(&(label->minscaledenom)) == -1) return(-1);
+        if(getDouble(lexer, &(label->minscaledenom)) == -1) return(-1);
         break;
       case(MINSIZE):
-        if(getDouble(&(label->minsize)) == -1) return(-1);
+        if(getDouble(lexer, &(label->minsize)) == -1) return(-1);
         break;
       case(OFFSET):
-        if(getInteger(&(label->offsetx)) == -1) return(-1);
-        if(getInteger(&(label->offsety)) == -1) return(-1);
+        if(getInteger(lexer, &(label->offsetx)) == -1) return(-1);
+        if(getInteger(lexer, &(label->offsety)) == -1) return(-1);
         break;
       case(OUTLINECOLOR):
-        if(loadColor(&(label->outlinecolor), &(label->bindings[MS_LABEL_BINDING_OUTLINECOLOR])) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(label->outlinecolor), &(label->bindings[MS_LABEL_BINDING_OUTLINECOLOR])) != MS_SUCCESS) return(-1);
         if(label->bindings[MS_LABEL_BINDING_OUTLINECOLOR].item) label->numbindings++;
         break;
       case(OUTLINEWIDTH):
-        if(getInteger(&(label->outlinewidth)) == -1) return(-1);
+        if(getInteger(lexer, &(label->outlinewidth)) == -1) return(-1);
         break;
       case(PARTIALS):
-        if((label->partials = getSymbol(2, MS_TRUE,MS_FALSE)) == -1) return(-1);
+        if((label->partials = getSymbol(lexer, 2, MS_TRUE,MS_FALSE)) == -1) return(-1);
         break;
       case(POSITION):
-        if((label->position = getSymbol(11, MS_UL,MS_UC,MS_UR,MS_CL,MS_CC,MS_CR,MS_LL,MS_LC,MS_LR,MS_AUTO,MS_BINDING)) == -1)
+        if((label->position = getSymbol(lexer, 11, MS_UL,MS_UC,MS_UR,MS_CL,MS_CC,MS_CR,MS_LL,MS_LC,MS_LR,MS_AUTO,MS_BINDING)) == -1)
           return(-1);
         if(label->position == MS_BINDING) {
           if(label->bindings[MS_LABEL_BINDING_POSITION].item != NULL)
             msFree(label->bindings[MS_LABEL_BINDING_POSITION].item);
-          label->bindings[MS_LABEL_BINDING_POSITION].item = strdup(msyystring_buffer);
+          label->bindings[MS_LABEL_BINDING_POSITION].item = strdup(lexer->string_buffer);
           label->numbindings++;
         }
         break;
       case(PRIORITY):
-        if((symbol = getSymbol(2, MS_NUMBER,MS_BINDING)) == -1) return(-1);
+        if((symbol = getSymbol(lexer, 2, MS_NUMBER,MS_BINDING)) == -1) return(-1);
         if(symbol == MS_NUMBER) {
-          label->priority = (int) msyynumber;
+          label->priority = (int) lexer->number;
           if(label->priority < 1 || label->priority > MS_MAX_LABEL_PRIORITY) {
             msSetError(MS_MISCERR, "Invalid PRIORITY, must be an integer between 1 and %d." , "loadLabel()", MS_MAX_LABEL_PRIORITY);
             return(-1);
@@ -2007,33 +2069,33 @@ static int loadLabel(labelObj *label)
         } else {
           if (label->bindings[MS_LABEL_BINDING_PRIORITY].item != NULL)
             msFree(label->bindings[MS_LABEL_BINDING_PRIORITY].item);
-          label->bindings[MS_LABEL_BINDING_PRIORITY].item = msStrdup(msyystring_buffer);
+          label->bindings[MS_LABEL_BINDING_PRIORITY].item = msStrdup(lexer->string_buffer);
           label->numbindings++;
         }
         break;
       case(SHADOWCOLOR):
-        if(loadColor(&(label->shadowcolor), NULL) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(label->shadowcolor), NULL) != MS_SUCCESS) return(-1);
         break;
       case(SHADOWSIZE):
         /* if(getInteger(&(label->shadowsizex)) == -1) return(-1); */
-        if((symbol = getSymbol(2, MS_NUMBER,MS_BINDING)) == -1) return(-1);
+        if((symbol = getSymbol(lexer, 2, MS_NUMBER,MS_BINDING)) == -1) return(-1);
         if(symbol == MS_NUMBER) {
-          label->shadowsizex = (int) msyynumber;
+          label->shadowsizex = (int) lexer->number;
         } else {
           if (label->bindings[MS_LABEL_BINDING_SHADOWSIZEX].item != NULL)
             msFree(label->bindings[MS_LABEL_BINDING_SHADOWSIZEX].item);
-          label->bindings[MS_LABEL_BINDING_SHADOWSIZEX].item = msStrdup(msyystring_buffer);
+          label->bindings[MS_LABEL_BINDING_SHADOWSIZEX].item = msStrdup(lexer->string_buffer);
           label->numbindings++;
         }
 
         /* if(getInteger(&(label->shadowsizey)) == -1) return(-1); */
-        if((symbol = getSymbol(2, MS_NUMBER,MS_BINDING)) == -1) return(-1);
+        if((symbol = getSymbol(lexer, 2, MS_NUMBER,MS_BINDING)) == -1) return(-1);
         if(symbol == MS_NUMBER) {
-          label->shadowsizey = (int) msyynumber;
+          label->shadowsizey = (int) lexer->number;
         } else {
           if (label->bindings[MS_LABEL_BINDING_SHADOWSIZEY].item != NULL)
             msFree(label->bindings[MS_LABEL_BINDING_SHADOWSIZEY].item);
-          label->bindings[MS_LABEL_BINDING_SHADOWSIZEY].item = msStrdup(msyystring_buffer);
+          label->bindings[MS_LABEL_BINDING_SHADOWSIZEY].item = msStrdup(lexer->string_buffer);
           label->numbindings++;
         }
         break;
@@ -2044,13 +2106,13 @@ static int loadLabel(labelObj *label)
           label->numbindings--;
         }
 
-        if((symbol = getSymbol(7, MS_NUMBER,MS_BINDING,MS_TINY,MS_SMALL,MS_MEDIUM,MS_LARGE,MS_GIANT)) == -1)
+        if((symbol = getSymbol(lexer, 7, MS_NUMBER,MS_BINDING,MS_TINY,MS_SMALL,MS_MEDIUM,MS_LARGE,MS_GIANT)) == -1)
           return(-1);
 
         if(symbol == MS_NUMBER) {
-          label->size = (double) msyynumber;
+          label->size = (double) lexer->number;
         } else if(symbol == MS_BINDING) {
-          label->bindings[MS_LABEL_BINDING_SIZE].item = msStrdup(msyystring_buffer);
+          label->bindings[MS_LABEL_BINDING_SIZE].item = msStrdup(lexer->string_buffer);
           label->numbindings++;
         } else
           label->size = symbol;
@@ -2059,14 +2121,14 @@ static int loadLabel(labelObj *label)
         if(msGrowLabelStyles(label) == NULL)
           return(-1);
         initStyle(label->styles[label->numstyles]);
-        if(loadStyle(label->styles[label->numstyles]) != MS_SUCCESS) return(-1);
+        if(loadStyle(lexer, label->styles[label->numstyles]) != MS_SUCCESS) return(-1);
         if(label->styles[label->numstyles]->_geomtransform.type == MS_GEOMTRANSFORM_NONE)
           label->styles[label->numstyles]->_geomtransform.type = MS_GEOMTRANSFORM_LABELPOINT; /* set a default, a marker? */
         label->numstyles++;
         break;
       case(TEXT):
-        if(loadExpression(&(label->text)) == -1) return(-1); /* loadExpression() cleans up previously allocated expression */
-        if(msyysource == MS_URL_TOKENS) {
+        if(loadExpression(lexer, &(label->text)) == -1) return(-1); /* loadExpression() cleans up previously allocated expression */
+        if(lexer->source == MS_URL_TOKENS) {
           msSetError(MS_MISCERR, "URL-based TEXT configuration not supported for labels." , "loadLabel()");
           freeExpression(&(label->text));
           return(-1);
@@ -2077,14 +2139,14 @@ static int loadLabel(labelObj *label)
         }
         break;
       case(TYPE):
-        if((label->type = getSymbol(2, MS_TRUETYPE,MS_BITMAP)) == -1) return(-1);
+        if((label->type = getSymbol(lexer, 2, MS_TRUETYPE,MS_BITMAP)) == -1) return(-1);
         break;
       case(WRAP):
-        if(getCharacter(&(label->wrap)) == -1) return(-1);
+        if(getCharacter(lexer, &(label->wrap)) == -1) return(-1);
         break;
       default:
-        if(strlen(msyystring_buffer) > 0) {
-          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadLabel()", msyystring_buffer, msyylineno);
+        if(strlen(lexer->string_buffer) > 0) {
+          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadLabel()", lexer->string_buffer, lexer->lineno);
           return(-1);
         } else {
           return(0); /* end of a string, not an error */
@@ -2095,27 +2157,27 @@ static int loadLabel(labelObj *label)
 
 int msUpdateLabelFromString(labelObj *label, char *string, int url_string)
 {
+  lexerObj lexer;
+
   if(!label || !string) return MS_FAILURE;
 
-  msAcquireLock( TLOCK_PARSER );
-  
+  if(msInitLexer(&lexer) != MS_SUCCESS) return MS_FAILURE;
+
   if(url_string)
-    msyystate = MS_TOKENIZE_URL_STRING;
+    lexer.state = MS_TOKENIZE_URL_STRING;
   else
-    msyystate = MS_TOKENIZE_STRING;
+    lexer.state = MS_TOKENIZE_STRING;
 
-  msyystring = string;
-  msyylex(); /* sets things up, but doesn't process any tokens */
+  lexer.string = string;
+  msyylex(lexer.scanner); /* sets things up, but doesn't process any tokens */
 
-  msyylineno = 1; /* start at line 1 */
+  lexer.lineno = 1; /* start at line 1 */
 
-  if(loadLabel(label) == -1) {
-    msReleaseLock( TLOCK_PARSER );
+  if(loadLabel(&lexer, label) == -1) {
+    msFreeLexer(&lexer);
     return MS_FAILURE; /* parse error */;
   }
-  msReleaseLock( TLOCK_PARSER );
-
-  msyylex_destroy();
+  msFreeLexer(&lexer);
   return MS_SUCCESS;
 }
 
@@ -2252,6 +2314,8 @@ void initExpression(expressionObj *exp)
   exp->compiled = MS_FALSE;
   exp->flags = 0;
   exp->tokens = exp->curtoken = NULL;
+  exp->program = NULL;
+  exp->programstatus = MS_EXPR_PROGRAM_UNKNOWN;
 }
 
 void freeExpressionTokens(expressionObj *exp)
@@ -2261,6 +2325,8 @@ void freeExpressionTokens(expressionObj *exp)
 
   if(!exp) return;
 
+  msFreeExpressionProgram(exp);
+
   if(exp->tokens) {
     node = exp->tokens;
     while (node != NULL) {
@@ -2301,15 +2367,15 @@ void freeExpression(expressionObj *exp)
   initExpression(exp); /* re-initialize */
 }
 
-int loadExpression(expressionObj *exp)
+int loadExpression(lexerObj *lexer, expressionObj *exp)
 {
   /* TODO: should we fall freeExpression if exp->string != NULL? We do some checking to avoid a leak but is it enough... */
 
-  msyystring_icase = MS_TRUE;
-  if((exp->type = getSymbol(6, MS_STRING,MS_EXPRESSION,MS_REGEX,MS_ISTRING,MS_IREGEX,MS_LIST)) == -1) return(-1);
+  lexer->string_icase = MS_TRUE;
+  if((exp->type = getSymbol(lexer, 6, MS_STRING,MS_EXPRESSION,MS_REGEX,MS_ISTRING,MS_IREGEX,MS_LIST)) == -1) return(-1);
   if (exp->string != NULL)
     msFree(exp->string);
-  exp->string = msStrdup(msyystring_buffer);
+  exp->string = msStrdup(lexer->string_buffer);
 
   if(exp->type == MS_ISTRING) {
     exp->flags = exp->flags | MS_EXP_INSENSITIVE;
@@ -2325,37 +2391,32 @@ int loadExpression(expressionObj *exp)
 /* ---------------------------------------------------------------------------
    msLoadExpressionString and loadExpressionString
 
-   msLoadExpressionString wraps call to loadExpressionString with mutex
-   acquisition and release.  This function should be used everywhere outside
-   the mapfile loading phase of an application.  loadExpressionString does
-   not check for a mutex!  It should be used only within code that has
-   properly acquired a mutex.
-
-   See bug 339 for more details -- SG.
+   Both parse value into exp with a lexer of their own, so they are safe to
+   call from any thread, during or after mapfile loading.
+   msLoadExpressionString is kept for compatibility (it used to wrap
+   loadExpressionString with the parser mutex, see bug 339).
    ------------------------------------------------------------------------ */
 
 int msLoadExpressionString(expressionObj *exp, char *value)
 {
-  int retval = MS_FAILURE;
-
-  msAcquireLock( TLOCK_PARSER );
-  retval = loadExpressionString( exp, value );
-  msReleaseLock( TLOCK_PARSER );
-
-  return retval;
+  return loadExpressionString( exp, value );
 }
 
 int loadExpressionString(expressionObj *exp, char *value)
 {
-  msyystate = MS_TOKENIZE_STRING;
-  msyystring = value;
-  msyylex(); /* sets things up but processes no tokens */
+  lexerObj lexer;
+
+  if(msInitLexer(&lexer) != MS_SUCCESS) return(-1);
+
+  lexer.state = MS_TOKENIZE_STRING;
+  lexer.string = value;
+  msyylex(lexer.scanner); /* sets things up but processes no tokens */
 
   freeExpression(exp); /* we're totally replacing the old expression so free (which re-inits) to start over */
 
-  msyystring_icase = MS_TRUE;
-  if((exp->type = getSymbol2(5, MS_EXPRESSION,MS_REGEX,MS_IREGEX,MS_ISTRING,MS_LIST)) != -1) {
-    exp->string = msStrdup(msyystring_buffer);
+  lexer.string_icase = MS_TRUE;
+  if((exp->type = getSymbol2(&lexer, 5, MS_EXPRESSION,MS_REGEX,MS_IREGEX,MS_ISTRING,MS_LIST)) != -1) {
+    exp->string = msStrdup(lexer.string_buffer);
 
     if(exp->type == MS_ISTRING) {
       exp->type = MS_STRING;
@@ -2367,12 +2428,13 @@ int loadExpressionString(expressionObj *exp, char *value)
   } else {
     /* failure above is not an error since we'll consider anything not matching (like an unquoted number) as a STRING) */
     exp->type = MS_STRING;
-    if((strlen(value) - strlen(msyystring_buffer)) == 2)
-      exp->string = msStrdup(msyystring_buffer); /* value was quoted */
+    if((strlen(value) - strlen(lexer.string_buffer)) == 2)
+      exp->string = msStrdup(lexer.string_buffer); /* value was quoted */
     else
       exp->string = msStrdup(value); /* use the whole value */
   }
 
+  msFreeLexer(&lexer);
   return(0);
 }
 
@@ -2427,7 +2489,7 @@ static void writeExpression(FILE *stream, int indent, const char *name, expressi
   writeIndent(stream, ++indent);
   switch(exp->type) {
     case(MS_LIST):
-      fprintf(stream, "%s {%s}", name, exp->string);
+      msIO_fprintf(stream, "%s {%s}", name, exp->string);
       break;
     case(MS_REGEX):
       msIO_fprintf(stream, "%s /%s/", name, exp->string);
@@ -2454,22 +2516,22 @@ static void writeExpression(FILE *stream, int indent, const char *name, expressi
   writeLineFeed(stream);
 }
 
-int loadHashTable(hashTableObj *ptable)
+int loadHashTable(lexerObj *lexer, hashTableObj *ptable)
 {
   char *key=NULL, *data=NULL;
 
   if (!ptable) ptable = msCreateHashTable();
 
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(EOF):
         msSetError(MS_EOFERR, NULL, "loadHashTable()");
         return(MS_FAILURE);
       case(END):
         return(MS_SUCCESS);
       case(MS_STRING):
-        key = msStrdup(msyystring_buffer); /* the key is *always* a string */
-        if(getString(&data) == MS_FAILURE) return(MS_FAILURE);
+        key = msStrdup(lexer->string_buffer); /* the key is *always* a string */
+        if(getString(lexer, &data) == MS_FAILURE) return(MS_FAILURE);
         msInsertHashTable(ptable, key, data);
 
         free(key);
@@ -2477,7 +2539,7 @@ int loadHashTable(hashTableObj *ptable)
         data=NULL;
         break;
       default:
-        msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadHashTable()", msyystring_buffer, msyylineno );
+        msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadHashTable()", lexer->string_buffer, lexer->lineno );
         return(MS_FAILURE);
     }
   }
@@ -2495,11 +2557,10 @@ static void writeHashTable(FILE *stream, int indent, const char *title, hashTabl
 
   indent++;
   writeBlockBegin(stream, indent, title);
-  for (i=0; i<MS_HASHSIZE; i++) {
-    if (table->items[i] != NULL) {
-      for (tp=table->items[i]; tp!=NULL; tp=tp->next)
-        writeNameValuePair(stream, indent, tp->key, tp->data);
-    }
+  for (i=0; i<table->numused; i++) {
+    tp = &(table->items[i]);
+    if (tp->data != NULL) /* removed */
+      writeNameValuePair(stream, indent, tp->key, tp->data);
   }
   writeBlockEnd(stream, indent, title);
 }
@@ -2513,12 +2574,11 @@ static void writeHashTableInline(FILE *stream, int indent, char *name, hashTable
   if(msHashIsEmpty(table)) return;
 
   ++indent;
-  for (i=0; i<MS_HASHSIZE; ++i) {
-    if (table->items[i] != NULL) {
-      for (tp=table->items[i]; tp!=NULL; tp=tp->next) {
-        writeIndent(stream, indent);
-        msIO_fprintf(stream, "%s \"%s\" \"%s\"\n", name, tp->key, tp->data);
-      }
+  for (i=0; i<table->numused; ++i) {
+    tp = &(table->items[i]);
+    if (tp->data != NULL) { /* removed */
+      writeIndent(stream, indent);
+      msIO_fprintf(stream, "%s \"%s\" \"%s\"\n", name, tp->key, tp->data);
     }
   }
 }
@@ -2542,33 +2602,33 @@ void freeCluster(clusterObj *cluster)
   freeExpression(&(cluster->filter));
 }
 
-int loadCluster(clusterObj *cluster)
+int loadCluster(lexerObj *lexer, clusterObj *cluster)
 {
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(CLUSTER):
         break; /* for string loads */
       case(MAXDISTANCE):
-        if(getDouble(&(cluster->maxdistance)) == -1) return(-1);
+        if(getDouble(lexer, &(cluster->maxdistance)) == -1) return(-1);
         break;
       case(BUFFER):
-        if(getDouble(&(cluster->buffer)) == -1) return(-1);
+        if(getDouble(lexer, &(cluster->buffer)) == -1) return(-1);
         break;
       case(REGION):
-        if(getString(&cluster->region) == MS_FAILURE) return(-1);
+        if(getString(lexer, &cluster->region) == MS_FAILURE) return(-1);
         break;
       case(END):
         return(0);
         break;
       case(GROUP):
-        if(loadExpression(&(cluster->group)) == -1) return(-1);
+        if(loadExpression(lexer, &(cluster->group)) == -1) return(-1);
         break;
       case(FILTER):
-        if(loadExpression(&(cluster->filter)) == -1) return(-1);
+        if(loadExpression(lexer, &(cluster->filter)) == -1) return(-1);
         break;
       default:
-        if(strlen(msyystring_buffer) > 0) {
-          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadCluster()", msyystring_buffer, msyylineno);
+        if(strlen(lexer->string_buffer) > 0) {
+          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadCluster()", lexer->string_buffer, lexer->lineno);
           return(-1);
         } else {
           return(0); /* end of a string, not an error */
@@ -2581,23 +2641,23 @@ int loadCluster(clusterObj *cluster)
 
 int msUpdateClusterFromString(clusterObj *cluster, char *string)
 {
+  lexerObj lexer;
+
   if(!cluster || !string) return MS_FAILURE;
 
-  msAcquireLock( TLOCK_PARSER );
+  if(msInitLexer(&lexer) != MS_SUCCESS) return MS_FAILURE;
 
-  msyystate = MS_TOKENIZE_STRING;
-  msyystring = string;
-  msyylex(); /* sets things up, but doesn't process any tokens */
+  lexer.state = MS_TOKENIZE_STRING;
+  lexer.string = string;
+  msyylex(lexer.scanner); /* sets things up, but doesn't process any tokens */
 
-  msyylineno = 1; /* start at line 1 */
+  lexer.lineno = 1; /* start at line 1 */
 
-  if(loadCluster(cluster) == -1) {
-    msReleaseLock( TLOCK_PARSER );
+  if(loadCluster(&lexer, cluster) == -1) {
+    msFreeLexer(&lexer);
     return MS_FAILURE; /* parse error */;
   }
-  msReleaseLock( TLOCK_PARSER );
-
-  msyylex_destroy();
+  msFreeLexer(&lexer);
   return MS_SUCCESS;
 }
 
@@ -2698,50 +2758,50 @@ int initStyle(styleObj *style)
   return MS_SUCCESS;
 }
 
-int loadStyle(styleObj *style)
+int loadStyle(lexerObj *lexer, styleObj *style)
 {
   int symbol;
 
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
         /* New Color Range fields*/
       case (COLORRANGE):
         /*These are both in one line now*/
-        if(loadColor(&(style->mincolor), NULL) != MS_SUCCESS) return(MS_FAILURE);
-        if(loadColor(&(style->maxcolor), NULL) != MS_SUCCESS) return(MS_FAILURE);
+        if(loadColor(lexer, &(style->mincolor), NULL) != MS_SUCCESS) return(MS_FAILURE);
+        if(loadColor(lexer, &(style->maxcolor), NULL) != MS_SUCCESS) return(MS_FAILURE);
         break;
       case(DATARANGE):
         /*These are both in one line now*/
-        if(getDouble(&(style->minvalue)) == -1) return(-1);
-        if(getDouble(&(style->maxvalue)) == -1) return(-1);
+        if(getDouble(lexer, &(style->minvalue)) == -1) return(-1);
+        if(getDouble(lexer, &(style->maxvalue)) == -1) return(-1);
         break;
       case(RANGEITEM):
-        if(getString(&style->rangeitem) == MS_FAILURE) return(-1);
+        if(getString(lexer, &style->rangeitem) == MS_FAILURE) return(-1);
         break;
         /* End Range fields*/
       case(ANGLE):
-        if((symbol = getSymbol(3, MS_NUMBER,MS_BINDING,MS_AUTO)) == -1) return(MS_FAILURE);
+        if((symbol = getSymbol(lexer, 3, MS_NUMBER,MS_BINDING,MS_AUTO)) == -1) return(MS_FAILURE);
 
         if(symbol == MS_NUMBER)
-          style->angle = (double) msyynumber;
+          style->angle = (double) lexer->number;
         else if(symbol==MS_BINDING) {
           if (style->bindings[MS_STYLE_BINDING_ANGLE].item != NULL)
             msFree(style->bindings[MS_STYLE_BINDING_ANGLE].item);
-          style->bindings[MS_STYLE_BINDING_ANGLE].item = msStrdup(msyystring_buffer);
+          style->bindings[MS_STYLE_BINDING_ANGLE].item = msStrdup(lexer->string_buffer);
           style->numbindings++;
         } else {
           style->autoangle=MS_TRUE;
         }
         break;
       case(ANTIALIAS):
-        if((style->antialias = getSymbol(2, MS_TRUE,MS_FALSE)) == -1)
+        if((style->antialias = getSymbol(lexer, 2, MS_TRUE,MS_FALSE)) == -1)
           return(MS_FAILURE);
         break;
       case(BACKGROUNDCOLOR):
-        if(loadColor(&(style->backgroundcolor), NULL) != MS_SUCCESS) return(MS_FAILURE);
+        if(loadColor(lexer, &(style->backgroundcolor), NULL) != MS_SUCCESS) return(MS_FAILURE);
         break;
       case(COLOR):
-        if(loadColor(&(style->color), &(style->bindings[MS_STYLE_BINDING_COLOR])) != MS_SUCCESS) return(MS_FAILURE);
+        if(loadColor(lexer, &(style->color), &(style->bindings[MS_STYLE_BINDING_COLOR])) != MS_SUCCESS) return(MS_FAILURE);
         if(style->bindings[MS_STYLE_BINDING_COLOR].item) style->numbindings++;
         break;
       case(EOF):
@@ -2766,95 +2826,95 @@ int loadStyle(styleObj *style)
       }
       break;
       case(GAP):
-        if((getDouble(&style->gap)) == -1) return(MS_FAILURE);
+        if((getDouble(lexer, &style->gap)) == -1) return(MS_FAILURE);
         break;
       case(INITIALGAP):
-        if((getDouble(&style->initialgap)) == -1) return(MS_FAILURE);
+        if((getDouble(lexer, &style->initialgap)) == -1) return(MS_FAILURE);
         if(style->initialgap < 0) {
           msSetError(MS_MISCERR, "INITIALGAP requires a positive values", "loadStyle()");
           return(MS_FAILURE);
         }
         break;
       case(MAXSCALEDENOM):
-        if(getDouble(&(style->maxscaledenom)) == -1) return(MS_FAILURE);
+        if(getDouble(lexer, &(style->maxscaledenom)) == -1) return(MS_FAILURE);
         break;
       case(MINSCALEDENOM):
-        if(getDouble(&(style->minscaledenom)) == -1) return(MS_FAILURE);
+        if(getDouble(lexer, &(style->minscaledenom)) == -1) return(MS_FAILURE);
         break;
       case(GEOMTRANSFORM): {
         int s;
-        if((s = getSymbol(2, MS_STRING, MS_EXPRESSION)) == -1) return(MS_FAILURE);
+        if((s = getSymbol(lexer, 2, MS_STRING, MS_EXPRESSION)) == -1) return(MS_FAILURE);
         if(s == MS_STRING)
-          msStyleSetGeomTransform(style, msyystring_buffer);
+          msStyleSetGeomTransform(style, lexer->string_buffer);
         else {
           /* handle expression case here for the moment */
           msFree(style->_geomtransform.string);
-          style->_geomtransform.string = msStrdup(msyystring_buffer);
+          style->_geomtransform.string = msStrdup(lexer->string_buffer);
           style->_geomtransform.type = MS_GEOMTRANSFORM_EXPRESSION;
         }
       }
       break;
       case(LINECAP):
-        if((style->linecap = getSymbol(4,MS_CJC_BUTT, MS_CJC_ROUND, MS_CJC_SQUARE, MS_CJC_TRIANGLE)) == -1) return(MS_FAILURE);
+        if((style->linecap = getSymbol(lexer, 4,MS_CJC_BUTT, MS_CJC_ROUND, MS_CJC_SQUARE, MS_CJC_TRIANGLE)) == -1) return(MS_FAILURE);
         break;
       case(LINEJOIN):
-        if((style->linejoin = getSymbol(4,MS_CJC_NONE, MS_CJC_ROUND, MS_CJC_MITER, MS_CJC_BEVEL)) == -1) return(MS_FAILURE);
+        if((style->linejoin = getSymbol(lexer, 4,MS_CJC_NONE, MS_CJC_ROUND, MS_CJC_MITER, MS_CJC_BEVEL)) == -1) return(MS_FAILURE);
         break;
       case(LINEJOINMAXSIZE):
-        if((getDouble(&style->linejoinmaxsize)) == -1) return(MS_FAILURE);
+        if((getDouble(lexer, &style->linejoinmaxsize)) == -1) return(MS_FAILURE);
         break;
       case(MAXSIZE):
-        if(getDouble(&(style->maxsize)) == -1) return(MS_FAILURE);
+        if(getDouble(lexer, &(style->maxsize)) == -1) return(MS_FAILURE);
         break;
       case(MINSIZE):
-        if(getDouble(&(style->minsize)) == -1) return(MS_FAILURE);
+        if(getDouble(lexer, &(style->minsize)) == -1) return(MS_FAILURE);
         break;
       case(MAXWIDTH):
-        if(getDouble(&(style->maxwidth)) == -1) return(MS_FAILURE);
+        if(getDouble(lexer, &(style->maxwidth)) == -1) return(MS_FAILURE);
         break;
       case(MINWIDTH):
-        if(getDouble(&(style->minwidth)) == -1) return(MS_FAILURE);
+        if(getDouble(lexer, &(style->minwidth)) == -1) return(MS_FAILURE);
         break;
       case(OFFSET):
-        if((symbol = getSymbol(2, MS_NUMBER,MS_BINDING)) == -1) return(MS_FAILURE);
+        if((symbol = getSymbol(lexer, 2, MS_NUMBER,MS_BINDING)) == -1) return(MS_FAILURE);
         if(symbol == MS_NUMBER)
-          style->offsetx = (double) msyynumber;
+          style->offsetx = (double) lexer->number;
         else {
           if (style->bindings[MS_STYLE_BINDING_OFFSET_X].item != NULL)
             msFree(style->bindings[MS_STYLE_BINDING_OFFSET_X].item);
-          style->bindings[MS_STYLE_BINDING_OFFSET_X].item = msStrdup(msyystring_buffer);
+          style->bindings[MS_STYLE_BINDING_OFFSET_X].item = msStrdup(lexer->string_buffer);
           style->numbindings++;
         }
 
-        if((symbol = getSymbol(2, MS_NUMBER,MS_BINDING)) == -1) return(MS_FAILURE);
+        if((symbol = getSymbol(lexer, 2, MS_NUMBER,MS_BINDING)) == -1) return(MS_FAILURE);
         if(symbol == MS_NUMBER)
-          style->offsety = (double) msyynumber;
+          style->offsety = (double) lexer->number;
         else {
           if (style->bindings[MS_STYLE_BINDING_OFFSET_Y].item != NULL)
             msFree(style->bindings[MS_STYLE_BINDING_OFFSET_Y].item);
-          style->bindings[MS_STYLE_BINDING_OFFSET_Y].item = msStrdup(msyystring_buffer);
+          style->bindings[MS_STYLE_BINDING_OFFSET_Y].item = msStrdup(lexer->string_buffer);
           style->numbindings++;
         }
         break;
       case(OPACITY):
-        if((symbol = getSymbol(2, MS_NUMBER,MS_BINDING)) == -1) return(MS_FAILURE);
+        if((symbol = getSymbol(lexer, 2, MS_NUMBER,MS_BINDING)) == -1) return(MS_FAILURE);
         if(symbol == MS_NUMBER)
-          style->opacity = MS_MAX(MS_MIN((int) msyynumber, 100), 0); /* force opacity to between 0 and 100 */
+          style->opacity = MS_MAX(MS_MIN((int) lexer->number, 100), 0); /* force opacity to between 0 and 100 */
         else {
           if (style->bindings[MS_STYLE_BINDING_OPACITY].item != NULL)
             msFree(style->bindings[MS_STYLE_BINDING_OPACITY].item);
-          style->bindings[MS_STYLE_BINDING_OPACITY].item = msStrdup(msyystring_buffer);
+          style->bindings[MS_STYLE_BINDING_OPACITY].item = msStrdup(lexer->string_buffer);
           style->numbindings++;
         }
         break;
       case(OUTLINECOLOR):
-        if(loadColor(&(style->outlinecolor), &(style->bindings[MS_STYLE_BINDING_OUTLINECOLOR])) != MS_SUCCESS) return(MS_FAILURE);
+        if(loadColor(lexer, &(style->outlinecolor), &(style->bindings[MS_STYLE_BINDING_OUTLINECOLOR])) != MS_SUCCESS) return(MS_FAILURE);
         if(style->bindings[MS_STYLE_BINDING_OUTLINECOLOR].item) style->numbindings++;
         break;
       case(PATTERN): {
         int done = MS_FALSE;
         for(;;) { /* read till the next END */
-          switch(msyylex()) {
+          switch(msLexerNextToken(lexer)) {
             case(END):
               if(style->patternlength < 2) {
                 msSetError(MS_SYMERR, "Not enough pattern elements. A minimum of 2 are required", "loadStyle()");
@@ -2867,11 +2927,11 @@ int loadStyle(styleObj *style)
                 msSetError(MS_SYMERR, "Pattern too long.", "loadStyle()");
                 return(-1);
               }
-              style->pattern[style->patternlength] = atof(msyystring_buffer);
+              style->pattern[style->patternlength] = atof(lexer->string_buffer);
               style->patternlength++;
               break;
             default:
-              msSetError(MS_TYPEERR, "Parsing error near (%s):(line %d)", "loadStyle()", msyystring_buffer, msyylineno);
+              msSetError(MS_TYPEERR, "Parsing error near (%s):(line %d)", "loadStyle()", lexer->string_buffer, lexer->lineno);
               return(-1);
           }
           if(done == MS_TRUE)
@@ -2882,13 +2942,13 @@ int loadStyle(styleObj *style)
       case(POSITION):
         /* if((s->position = getSymbol(3, MS_UC,MS_CC,MS_LC)) == -1)  */
         /* return(-1); */
-        if((style->position = getSymbol(9, MS_UL,MS_UC,MS_UR,MS_CL,MS_CC,MS_CR,MS_LL,MS_LC,MS_LR)) == -1)
+        if((style->position = getSymbol(lexer, 9, MS_UL,MS_UC,MS_UR,MS_CL,MS_CC,MS_CR,MS_LL,MS_LC,MS_LR)) == -1)
           return(-1);
         break;
       case(OUTLINEWIDTH):
-        if((symbol = getSymbol(2, MS_NUMBER,MS_BINDING)) == -1) return(MS_FAILURE);
+        if((symbol = getSymbol(lexer, 2, MS_NUMBER,MS_BINDING)) == -1) return(MS_FAILURE);
         if(symbol == MS_NUMBER) {
-          style->outlinewidth = (double) msyynumber;
+          style->outlinewidth = (double) lexer->number;
           if(style->outlinewidth < 0) {
             msSetError(MS_MISCERR, "Invalid OUTLINEWIDTH, must be greater than 0" , "loadStyle()");
             return(MS_FAILURE);
@@ -2896,77 +2956,77 @@ int loadStyle(styleObj *style)
         } else {
           if (style->bindings[MS_STYLE_BINDING_OUTLINEWIDTH].item != NULL)
             msFree(style->bindings[MS_STYLE_BINDING_OUTLINEWIDTH].item);
-          style->bindings[MS_STYLE_BINDING_OUTLINEWIDTH].item = msStrdup(msyystring_buffer);
+          style->bindings[MS_STYLE_BINDING_OUTLINEWIDTH].item = msStrdup(lexer->string_buffer);
           style->numbindings++;
         }
         break;
       case(SIZE):
-        if((symbol = getSymbol(2, MS_NUMBER,MS_BINDING)) == -1) return(MS_FAILURE);
+        if((symbol = getSymbol(lexer, 2, MS_NUMBER,MS_BINDING)) == -1) return(MS_FAILURE);
         if(symbol == MS_NUMBER)
-          style->size = (double) msyynumber;
+          style->size = (double) lexer->number;
         else {
           if (style->bindings[MS_STYLE_BINDING_SIZE].item != NULL)
             msFree(style->bindings[MS_STYLE_BINDING_SIZE].item);
-          style->bindings[MS_STYLE_BINDING_SIZE].item = msStrdup(msyystring_buffer);
+          style->bindings[MS_STYLE_BINDING_SIZE].item = msStrdup(lexer->string_buffer);
           style->numbindings++;
         }
         break;
       case(STYLE):
         break; /* for string loads */
       case(SYMBOL):
-        if((symbol = getSymbol(3, MS_NUMBER,MS_STRING,MS_BINDING)) == -1) return(MS_FAILURE);
+        if((symbol = getSymbol(lexer, 3, MS_NUMBER,MS_STRING,MS_BINDING)) == -1) return(MS_FAILURE);
         if(symbol == MS_NUMBER) {
           if (style->symbolname != NULL) {
             msFree(style->symbolname);
             style->symbolname = NULL;
           }
-          style->symbol = (int) msyynumber;
+          style->symbol = (int) lexer->number;
         } else if(symbol == MS_STRING) {
           if (style->symbolname != NULL)
             msFree(style->symbolname);
-          style->symbolname = msStrdup(msyystring_buffer);
+          style->symbolname = msStrdup(lexer->string_buffer);
         } else {
           if (style->bindings[MS_STYLE_BINDING_SYMBOL].item != NULL)
             msFree(style->bindings[MS_STYLE_BINDING_SYMBOL].item);
-          style->bindings[MS_STYLE_BINDING_SYMBOL].item = msStrdup(msyystring_buffer);
+          style->bindings[MS_STYLE_BINDING_SYMBOL].item = msStrdup(lexer->string_buffer);
           style->numbindings++;
         }
         break;
       case(WIDTH):
-        if((symbol = getSymbol(2, MS_NUMBER,MS_BINDING)) == -1) return(MS_FAILURE);
+        if((symbol = getSymbol(lexer, 2, MS_NUMBER,MS_BINDING)) == -1) return(MS_FAILURE);
         if(symbol == MS_NUMBER)
-          style->width = (double) msyynumber;
+          style->width = (double) lexer->number;
         else {
           if (style->bindings[MS_STYLE_BINDING_WIDTH].item != NULL)
             msFree(style->bindings[MS_STYLE_BINDING_WIDTH].item);
-          style->bindings[MS_STYLE_BINDING_WIDTH].item = msStrdup(msyystring_buffer);
+          style->bindings[MS_STYLE_BINDING_WIDTH].item = msStrdup(lexer->string_buffer);
           style->numbindings++;
         }
         break;
       case(POLAROFFSET):
-        if((symbol = getSymbol(2, MS_NUMBER,MS_BINDING)) == -1) return(MS_FAILURE);
+        if((symbol = getSymbol(lexer, 2, MS_NUMBER,MS_BINDING)) == -1) return(MS_FAILURE);
         if(symbol == MS_NUMBER)
-          style->polaroffsetpixel = (double) msyynumber;
+          style->polaroffsetpixel = (double) lexer->number;
         else {
           if (style->bindings[MS_STYLE_BINDING_POLAROFFSET_PIXEL].item != NULL)
             msFree(style->bindings[MS_STYLE_BINDING_POLAROFFSET_PIXEL].item);
-          style->bindings[MS_STYLE_BINDING_POLAROFFSET_PIXEL].item = msStrdup(msyystring_buffer);
+          style->bindings[MS_STYLE_BINDING_POLAROFFSET_PIXEL].item = msStrdup(lexer->string_buffer);
           style->numbindings++;
         }
 
-        if((symbol = getSymbol(2, MS_NUMBER,MS_BINDING)) == -1) return(MS_FAILURE);
+        if((symbol = getSymbol(lexer, 2, MS_NUMBER,MS_BINDING)) == -1) return(MS_FAILURE);
         if(symbol == MS_NUMBER)
-          style->polaroffsetangle = (double) msyynumber;
+          style->polaroffsetangle = (double) lexer->number;
         else {
           if (style->bindings[MS_STYLE_BINDING_POLAROFFSET_ANGLE].item != NULL)
             msFree(style->bindings[MS_STYLE_BINDING_POLAROFFSET_ANGLE].item);
-          style->bindings[MS_STYLE_BINDING_POLAROFFSET_ANGLE].item = msStrdup(msyystring_buffer);
+          style->bindings[MS_STYLE_BINDING_POLAROFFSET_ANGLE].item = msStrdup(lexer->string_buffer);
           style->numbindings++;
         }
         break;
       default:
-        if(strlen(msyystring_buffer) > 0) {
-          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadStyle()", msyystring_buffer, msyylineno);
+        if(strlen(lexer->string_buffer) > 0) {
+          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadStyle()", lexer->string_buffer, lexer->lineno);
           return(MS_FAILURE);
         } else {
           return(MS_SUCCESS); /* end of a string, not an error */
@@ -2977,26 +3037,26 @@ int loadStyle(styleObj *style)
 
 int msUpdateStyleFromString(styleObj *style, char *string, int url_string)
 {
+  lexerObj lexer;
+
   if(!style || !string) return MS_FAILURE;
 
-  msAcquireLock( TLOCK_PARSER );
+  if(msInitLexer(&lexer) != MS_SUCCESS) return MS_FAILURE;
 
   if(url_string)
-    msyystate = MS_TOKENIZE_URL_STRING;
+    lexer.state = MS_TOKENIZE_URL_STRING;
   else
-    msyystate = MS_TOKENIZE_STRING;
-  msyystring = string;
-  msyylex(); /* sets things up, but doesn't process any tokens */
+    lexer.state = MS_TOKENIZE_STRING;
+  lexer.string = string;
+  msyylex(lexer.scanner); /* sets things up, but doesn't process any tokens */
 
-  msyylineno = 1; /* start at line 1 */
+  lexer.lineno = 1; /* start at line 1 */
 
-  if(loadStyle(style) == -1) {
-    msReleaseLock( TLOCK_PARSER );
+  if(loadStyle(&lexer, style) == -1) {
+    msFreeLexer(&lexer);
     return MS_FAILURE; /* parse error */;
   }
-  msReleaseLock( TLOCK_PARSER );
-
-  msyylex_destroy();
+  msFreeLexer(&lexer);
   return MS_SUCCESS;
 }
 
@@ -3448,7 +3508,7 @@ labelObj *msGrowClassLabels( classObj *class )
   return class->labels[class->numlabels];
 }
 
-int loadClass(classObj *class, layerObj *layer)
+int loadClass(lexerObj *lexer, classObj *class, layerObj *layer)
 {
   int state;
   mapObj *map=NULL;
@@ -3457,12 +3517,12 @@ int loadClass(classObj *class, layerObj *layer)
   if(layer && layer->map) map = layer->map;
 
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(CLASS):
         break; /* for string loads */
       case(DEBUG):
-        if((class->debug = getSymbol(3, MS_ON,MS_OFF, MS_NUMBER)) == -1) return(-1);
-        if(class->debug == MS_NUMBER) class->debug = (int) msyynumber;
+        if((class->debug = getSymbol(lexer, 3, MS_ON,MS_OFF, MS_NUMBER)) == -1) return(-1);
+        if(class->debug == MS_NUMBER) class->debug = (int) lexer->number;
         break;
       case(EOF):
         msSetError(MS_EOFERR, NULL, "loadClass()");
@@ -3471,8 +3531,8 @@ int loadClass(classObj *class, layerObj *layer)
         return(0);
         break;
       case(EXPRESSION):
-        if(loadExpression(&(class->expression)) == -1) return(-1); /* loadExpression() cleans up previously allocated expression */
-        if(msyysource == MS_URL_TOKENS) {
+        if(loadExpression(lexer, &(class->expression)) == -1) return(-1); /* loadExpression() cleans up previously allocated expression */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(class->expression.string, msLookupHashTable(&(class->validation), "expression"), msLookupHashTable(&(layer->validation), "expression"), msLookupHashTable(&(map->web.validation), "expression"), NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based EXPRESSION configuration failed pattern validation." , "loadClass()");
             freeExpression(&(class->expression));
@@ -3481,8 +3541,8 @@ int loadClass(classObj *class, layerObj *layer)
         }
         break;
       case(GROUP):
-        if(getString(&class->group) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &class->group) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(class->group, msLookupHashTable(&(class->validation), "group"), msLookupHashTable(&(layer->validation), "group"), msLookupHashTable(&(map->web.validation), "group"), NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based GROUP configuration failed pattern validation." , "loadClass()");
             msFree(class->group);
@@ -3492,8 +3552,8 @@ int loadClass(classObj *class, layerObj *layer)
         }
         break;
       case(KEYIMAGE):
-        if(getString(&class->keyimage) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &class->keyimage) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(class->keyimage, msLookupHashTable(&(class->validation), "keyimage"), msLookupHashTable(&(layer->validation), "keyimage"), msLookupHashTable(&(map->web.validation), "keyimage"), NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based KEYIMAGE configuration failed pattern validation." , "loadClass()");
             msFree(class->keyimage);
@@ -3506,45 +3566,45 @@ int loadClass(classObj *class, layerObj *layer)
         if(msGrowClassLabels(class) == NULL) return(-1);
         initLabel(class->labels[class->numlabels]);
         class->labels[class->numlabels]->size = MS_MEDIUM; /* only set a default if the LABEL section is present */
-        if(loadLabel(class->labels[class->numlabels]) == -1) {
+        if(loadLabel(lexer, class->labels[class->numlabels]) == -1) {
           msFree(class->labels[class->numlabels]);
           return(-1);
         }
         class->numlabels++;
         break;
       case(LEADER):
-        if(loadLeader(&(class->leader)) == -1) return(-1);
+        if(loadLeader(lexer, &(class->leader)) == -1) return(-1);
         break;
       case(MAXSCALE):
       case(MAXSCALEDENOM):
-        if(getDouble(&(class->maxscaledenom)) == -1) return(-1);
+        if(getDouble(lexer, &(class->maxscaledenom)) == -1) return(-1);
         break;
       case(METADATA):
-        if(loadHashTable(&(class->metadata)) != MS_SUCCESS) return(-1);
+        if(loadHashTable(lexer, &(class->metadata)) != MS_SUCCESS) return(-1);
         break;
       case(MINSCALE):
       case(MINSCALEDENOM):
-        if(getDouble(&(class->minscaledenom)) == -1) return(-1);
+        if(getDouble(lexer, &(class->minscaledenom)) == -1) return(-1);
         break;
       case(MINFEATURESIZE):
-        if(getInteger(&(class->minfeaturesize)) == -1) return(-1);
+        if(getInteger(lexer, &(class->minfeaturesize)) == -1) return(-1);
         break;
       case(NAME):
-        if(getString(&class->name) == MS_FAILURE) return(-1);
+        if(getString(lexer, &class->name) == MS_FAILURE) return(-1);
         break;
       case(STATUS):
-        if((class->status = getSymbol(2, MS_ON,MS_OFF)) == -1) return(-1);
+        if((class->status = getSymbol(lexer, 2, MS_ON,MS_OFF)) == -1) return(-1);
         break;
       case(STYLE):
         if(msGrowClassStyles(class) == NULL)
           return(-1);
         initStyle(class->styles[class->numstyles]);
-        if(loadStyle(class->styles[class->numstyles]) != MS_SUCCESS) return(-1);
+        if(loadStyle(lexer, class->styles[class->numstyles]) != MS_SUCCESS) return(-1);
         class->numstyles++;
         break;
       case(TEMPLATE):
-        if(getString(&class->template) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &class->template) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(class->template, msLookupHashTable(&(class->validation), "template"), msLookupHashTable(&(layer->validation), "template"), msLookupHashTable(&(map->web.validation), "template"), map->templatepattern) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based TEMPLATE configuration failed pattern validation." , "loadClass()");
             msFree(class->template);
@@ -3554,8 +3614,8 @@ int loadClass(classObj *class, layerObj *layer)
         }
         break;
       case(TEXT):
-        if(loadExpression(&(class->text)) == -1) return(-1); /* loadExpression() cleans up previously allocated expression */
-        if(msyysource == MS_URL_TOKENS) {
+        if(loadExpression(lexer, &(class->text)) == -1) return(-1); /* loadExpression() cleans up previously allocated expression */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(class->text.string, msLookupHashTable(&(class->validation), "text"), msLookupHashTable(&(layer->validation), "text"), msLookupHashTable(&(map->web.validation), "text"), NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based TEXT configuration failed pattern validation." , "loadClass()");
             freeExpression(&(class->text));
@@ -3568,8 +3628,8 @@ int loadClass(classObj *class, layerObj *layer)
         }
         break;
       case(TITLE):
-        if(getString(&class->title) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &class->title) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(class->title, msLookupHashTable(&(class->validation), "title"), msLookupHashTable(&(layer->validation), "title"), msLookupHashTable(&(map->web.validation), "title"), NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based TITLE configuration failed pattern validation." , "loadClass()");
             msFree(class->title);
@@ -3579,7 +3639,7 @@ int loadClass(classObj *class, layerObj *layer)
         }
         break;
       case(TYPE):
-        if((class->type = getSymbol(6, MS_LAYER_POINT,MS_LAYER_LINE,MS_LAYER_RASTER,MS_LAYER_POLYGON,MS_LAYER_ANNOTATION,MS_LAYER_CIRCLE)) == -1) return(-1);
+        if((class->type = getSymbol(lexer, 6, MS_LAYER_POINT,MS_LAYER_LINE,MS_LAYER_RASTER,MS_LAYER_POLYGON,MS_LAYER_ANNOTATION,MS_LAYER_CIRCLE)) == -1) return(-1);
         break;
 
         /*
@@ -3587,39 +3647,39 @@ int loadClass(classObj *class, layerObj *layer)
         */
       case(BACKGROUNDCOLOR):
         if (msMaybeAllocateClassStyle(class, 0)) return MS_FAILURE;
-        if(loadColor(&(class->styles[0]->backgroundcolor), NULL) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(class->styles[0]->backgroundcolor), NULL) != MS_SUCCESS) return(-1);
         break;
       case(COLOR):
         if (msMaybeAllocateClassStyle(class, 0)) return MS_FAILURE;
-        if(loadColor(&(class->styles[0]->color), NULL) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(class->styles[0]->color), NULL) != MS_SUCCESS) return(-1);
         class->numstyles = 1; /* must *always* set a color or outlinecolor */
         break;
       case(MAXSIZE):
         if (msMaybeAllocateClassStyle(class, 0)) return MS_FAILURE;
-        if(getDouble(&(class->styles[0]->maxsize)) == -1) return(-1);
+        if(getDouble(lexer, &(class->styles[0]->maxsize)) == -1) return(-1);
         break;
       case(MINSIZE):
         if (msMaybeAllocateClassStyle(class, 0)) return MS_FAILURE;
-        if(getDouble(&(class->styles[0]->minsize)) == -1) return(-1);
+        if(getDouble(lexer, &(class->styles[0]->minsize)) == -1) return(-1);
         break;
       case(OUTLINECOLOR):
         if (msMaybeAllocateClassStyle(class, 0)) return MS_FAILURE;
-        if(loadColor(&(class->styles[0]->outlinecolor), NULL) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(class->styles[0]->outlinecolor), NULL) != MS_SUCCESS) return(-1);
         class->numstyles = 1; /* must *always* set a color, symbol or outlinecolor */
         break;
       case(SIZE):
         if (msMaybeAllocateClassStyle(class, 0)) return MS_FAILURE;
-        if(getDouble(&(class->styles[0]->size)) == -1) return(-1);
+        if(getDouble(lexer, &(class->styles[0]->size)) == -1) return(-1);
         break;
       case(SYMBOL):
         if (msMaybeAllocateClassStyle(class, 0)) return MS_FAILURE;
-        if((state = getSymbol(2, MS_NUMBER,MS_STRING)) == -1) return(-1);
+        if((state = getSymbol(lexer, 2, MS_NUMBER,MS_STRING)) == -1) return(-1);
         if(state == MS_NUMBER)
-          class->styles[0]->symbol = (int) msyynumber;
+          class->styles[0]->symbol = (int) lexer->number;
         else {
           if (class->styles[0]->symbolname != NULL)
             msFree(class->styles[0]->symbolname);
-          class->styles[0]->symbolname = msStrdup(msyystring_buffer);
+          class->styles[0]->symbolname = msStrdup(lexer->string_buffer);
           class->numstyles = 1;
         }
         break;
@@ -3629,49 +3689,49 @@ int loadClass(classObj *class, layerObj *layer)
         */
       case(OVERLAYBACKGROUNDCOLOR):
         if (msMaybeAllocateClassStyle(class, 1)) return MS_FAILURE;
-        if(loadColor(&(class->styles[1]->backgroundcolor), NULL) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(class->styles[1]->backgroundcolor), NULL) != MS_SUCCESS) return(-1);
         break;
       case(OVERLAYCOLOR):
         if (msMaybeAllocateClassStyle(class, 1)) return MS_FAILURE;
-        if(loadColor(&(class->styles[1]->color), NULL) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(class->styles[1]->color), NULL) != MS_SUCCESS) return(-1);
         class->numstyles = 2; /* must *always* set a color, symbol or outlinecolor */
         break;
       case(OVERLAYMAXSIZE):
         if (msMaybeAllocateClassStyle(class, 1)) return MS_FAILURE;
-        if(getDouble(&(class->styles[1]->maxsize)) == -1) return(-1);
+        if(getDouble(lexer, &(class->styles[1]->maxsize)) == -1) return(-1);
         break;
       case(OVERLAYMINSIZE):
         if (msMaybeAllocateClassStyle(class, 1)) return MS_FAILURE;
-        if(getDouble(&(class->styles[1]->minsize)) == -1) return(-1);
+        if(getDouble(lexer, &(class->styles[1]->minsize)) == -1) return(-1);
         break;
       case(OVERLAYOUTLINECOLOR):
         if (msMaybeAllocateClassStyle(class, 1)) return MS_FAILURE;
-        if(loadColor(&(class->styles[1]->outlinecolor), NULL) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(class->styles[1]->outlinecolor), NULL) != MS_SUCCESS) return(-1);
         class->numstyles = 2; /* must *always* set a color, symbol or outlinecolor */
         break;
       case(OVERLAYSIZE):
         if (msMaybeAllocateClassStyle(class, 1)) return MS_FAILURE;
-        if(getDouble(&(class->styles[1]->size)) == -1) return(-1);
+        if(getDouble(lexer, &(class->styles[1]->size)) == -1) return(-1);
         break;
       case(OVERLAYSYMBOL):
         if (msMaybeAllocateClassStyle(class, 1)) return MS_FAILURE;
-        if((state = getSymbol(2, MS_NUMBER,MS_STRING)) == -1) return(-1);
+        if((state = getSymbol(lexer, 2, MS_NUMBER,MS_STRING)) == -1) return(-1);
         if(state == MS_NUMBER)
-          class->styles[1]->symbol = (int) msyynumber;
+          class->styles[1]->symbol = (int) lexer->number;
         else  {
           if (class->styles[1]->symbolname != NULL)
             msFree(class->styles[1]->symbolname);
-          class->styles[1]->symbolname = msStrdup(msyystring_buffer);
+          class->styles[1]->symbolname = msStrdup(lexer->string_buffer);
         }
         class->numstyles = 2;
         break;
 
       case(VALIDATION):
-        if(loadHashTable(&(class->validation)) != MS_SUCCESS) return(-1);
+        if(loadHashTable(lexer, &(class->validation)) != MS_SUCCESS) return(-1);
         break;
       default:
-        if(strlen(msyystring_buffer) > 0) {
-          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadClass()", msyystring_buffer, msyylineno);
+        if(strlen(lexer->string_buffer) > 0) {
+          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadClass()", lexer->string_buffer, lexer->lineno);
           return(-1);
         } else {
           return(0); /* end of a string, not an error */
@@ -3712,26 +3772,26 @@ static int classResolveSymbolNames(classObj *class)
 
 int msUpdateClassFromString(classObj *class, char *string, int url_string)
 {
+  lexerObj lexer;
+
   if(!class || !string) return MS_FAILURE;
 
-  msAcquireLock( TLOCK_PARSER );
+  if(msInitLexer(&lexer) != MS_SUCCESS) return MS_FAILURE;
 
   if(url_string)
-    msyystate = MS_TOKENIZE_URL_STRING;
+    lexer.state = MS_TOKENIZE_URL_STRING;
   else
-    msyystate = MS_TOKENIZE_STRING;
-  msyystring = string;
-  msyylex(); /* sets things up, but doesn't process any tokens */
+    lexer.state = MS_TOKENIZE_STRING;
+  lexer.string = string;
+  msyylex(lexer.scanner); /* sets things up, but doesn't process any tokens */
 
-  msyylineno = 1; /* start at line 1 */
+  lexer.lineno = 1; /* start at line 1 */
 
-  if(loadClass(class, class->layer) == -1) {
-    msReleaseLock( TLOCK_PARSER );
+  if(loadClass(&lexer, class, class->layer) == -1) {
+    msFreeLexer(&lexer);
     return MS_FAILURE; /* parse error */;
   }
-  msReleaseLock( TLOCK_PARSER );
-
-  msyylex_destroy();
+  msFreeLexer(&lexer);
 
   if(classResolveSymbolNames(class) != MS_SUCCESS) return MS_FAILURE;
 
@@ -3902,6 +3962,7 @@ int initLayer(layerObj *layer, mapObj *map)
 
   layer->styleitem = NULL;
   layer->styleitemindex = -1;
+  layer->classlookup = NULL;
 
   layer->opacity = 100; /* fully opaque */
 
@@ -3921,6 +3982,13 @@ int initLayer(layerObj *layer, mapObj *map)
 
   initExpression(&(layer->_geomtransform));
   layer->_geomtransform.type = MS_GEOMTRANSFORM_NONE;
+
+  layer->lazy = NULL;
+  layer->lazysize = 0;
+  layer->prefetch = NULL;
+  layer->clipbuffer = NULL;
+
+  msInitNameIndex(&(layer->classindex));
   
   return(0);
 }
@@ -4010,6 +4078,7 @@ int freeLayer(layerObj *layer)
   }
 
   msFree(layer->styleitem);
+  msLayerFreeClassLookup(layer);
 
   msFree(layer->filteritem);
   freeExpression(&(layer->filter));
@@ -4036,6 +4105,9 @@ int freeLayer(layerObj *layer)
     msFreeImage(layer->maskimage);
   }
 
+  msFree(layer->lazy);
+  msFreeNameIndex(&(layer->classindex));
+
   return MS_SUCCESS;
 }
 
@@ -4088,27 +4160,27 @@ scaleTokenObj *msGrowLayerScaletokens( layerObj *layer )
   return &layer->scaletokens[layer->numscaletokens];
 }
 
-int loadScaletoken(scaleTokenObj *token, layerObj *layer) {
+int loadScaletoken(lexerObj *lexer, scaleTokenObj *token, layerObj *layer) {
   for(;;) {
     int stop = 0;
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(EOF):
         msSetError(MS_EOFERR, NULL, "loadScaletoken()");
         return(MS_FAILURE);
       case(NAME):
-        if(getString(&token->name) == MS_FAILURE) return(MS_FAILURE);
+        if(getString(lexer, &token->name) == MS_FAILURE) return(MS_FAILURE);
         break;
       case(VALUES):
          for(;;) {
            if(stop) break;
-           switch(msyylex()) {
+           switch(msLexerNextToken(lexer)) {
              case(EOF):
                msSetError(MS_EOFERR, NULL, "loadScaletoken()");
                return(MS_FAILURE);
              case(END): 
                stop = 1;
                if(token->n_entries == 0) {
-                 msSetError(MS_PARSEERR,"Scaletoken (line:%d) has no VALUES defined","loadScaleToken()",msyylineno);
+                 msSetError(MS_PARSEERR,"Scaletoken (line:%d) has no VALUES defined","loadScaleToken()",lexer->lineno);
                  return(MS_FAILURE);
                }
                token->tokens[token->n_entries-1].maxscale = DBL_MAX;
@@ -4117,16 +4189,16 @@ int loadScaletoken(scaleTokenObj *token, layerObj *layer) {
                /* we have a key */
                token->tokens = msSmallRealloc(token->tokens,(token->n_entries+1)*sizeof(scaleTokenEntryObj));
                
-               if(1 != sscanf(msyystring_buffer,"%lf",&token->tokens[token->n_entries].minscale)) {
+               if(1 != sscanf(lexer->string_buffer,"%lf",&token->tokens[token->n_entries].minscale)) {
                  msSetError(MS_PARSEERR, "failed to parse SCALETOKEN VALUE (%s):(line %d), expecting \"minscale\"", "loadScaletoken()",
-                         msyystring_buffer,msyylineno);
+                         lexer->string_buffer,lexer->lineno);
                  return(MS_FAILURE);
                }
                if(token->n_entries == 0) {
                  /* check supplied value was 0*/
                  if(token->tokens[0].minscale != 0) {
                   msSetError(MS_PARSEERR, "First SCALETOKEN VALUE (%s):(line %d) must be zero, expecting \"0\"", "loadScaletoken()",
-                         msyystring_buffer,msyylineno);
+                         lexer->string_buffer,lexer->lineno);
                   return(MS_FAILURE);
                  }
                } else {
@@ -4134,58 +4206,58 @@ int loadScaletoken(scaleTokenObj *token, layerObj *layer) {
                  token->tokens[token->n_entries-1].maxscale = token->tokens[token->n_entries].minscale;
                }
                token->tokens[token->n_entries].value = NULL;
-               if(getString(&(token->tokens[token->n_entries].value)) == MS_FAILURE) return(MS_FAILURE);
+               if(getString(lexer, &(token->tokens[token->n_entries].value)) == MS_FAILURE) return(MS_FAILURE);
                token->n_entries++;
                break;
              default:
-               msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadScaletoken()",  msyystring_buffer, msyylineno );
+               msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadScaletoken()",  lexer->string_buffer, lexer->lineno );
                return(MS_FAILURE);
            }
          }
          break;
       case(END):
         if(!token->name || !*(token->name)) {
-          msSetError(MS_PARSEERR,"ScaleToken missing mandatory NAME entry (line %d)","loadScaleToken()",msyylineno);
+          msSetError(MS_PARSEERR,"ScaleToken missing mandatory NAME entry (line %d)","loadScaleToken()",lexer->lineno);
           return MS_FAILURE;
         }
         if(token->n_entries == 0) {
-          msSetError(MS_PARSEERR,"ScaleToken missing at least one VALUES entry (line %d)","loadScaleToken()",msyylineno);
+          msSetError(MS_PARSEERR,"ScaleToken missing at least one VALUES entry (line %d)","loadScaleToken()",lexer->lineno);
           return MS_FAILURE;
         }
         return MS_SUCCESS;
       default:
-        msSetError(MS_IDENTERR, "Parsing error 2 near (%s):(line %d)", "loadScaletoken()",  msyystring_buffer, msyylineno );
+        msSetError(MS_IDENTERR, "Parsing error 2 near (%s):(line %d)", "loadScaletoken()",  lexer->string_buffer, lexer->lineno );
         return(MS_FAILURE);
     }
   } /* next token*/
 }
 
-int loadLayer(layerObj *layer, mapObj *map)
+int loadLayer(lexerObj *lexer, layerObj *layer, mapObj *map)
 {
   int type;
 
   layer->map = (mapObj *)map;
 
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(BINDVALS):
-        if(loadHashTable(&(layer->bindvals)) != MS_SUCCESS) return(-1);
+        if(loadHashTable(lexer, &(layer->bindvals)) != MS_SUCCESS) return(-1);
         break;
       case(CLASS):
         if (msGrowLayerClasses(layer) == NULL)
           return(-1);
         initClass(layer->class[layer->numclasses]);
-        if(loadClass(layer->class[layer->numclasses], layer) == -1) return(-1);
+        if(loadClass(lexer, layer->class[layer->numclasses], layer) == -1) return(-1);
         if(layer->class[layer->numclasses]->type == -1) layer->class[layer->numclasses]->type = layer->type;
         layer->numclasses++;
         break;
       case(CLUSTER):
         initCluster(&layer->cluster);
-        if(loadCluster(&layer->cluster) == -1) return(-1);
+        if(loadCluster(lexer, &layer->cluster) == -1) return(-1);
         break;
       case(CLASSGROUP):
-        if(getString(&layer->classgroup) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &layer->classgroup) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->classgroup, msLookupHashTable(&(layer->validation), "classgroup"), msLookupHashTable(&(map->web.validation), "classgroup"), NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based CLASSGROUP configuration failed pattern validation." , "loadLayer()");
             msFree(layer->classgroup);
@@ -4195,8 +4267,8 @@ int loadLayer(layerObj *layer, mapObj *map)
         }
         break;
       case(CLASSITEM):
-        if(getString(&layer->classitem) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &layer->classitem) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->classitem, msLookupHashTable(&(layer->validation), "classitem"), msLookupHashTable(&(map->web.validation), "classitem"), NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based CLASSITEM configuration failed pattern validation." , "loadLayer()");
             msFree(layer->classitem);
@@ -4206,8 +4278,8 @@ int loadLayer(layerObj *layer, mapObj *map)
         }
         break;
       case(CONNECTION):
-        if(getString(&layer->connection) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &layer->connection) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->connection, msLookupHashTable(&(layer->validation), "connection"), msLookupHashTable(&(map->web.validation), "connection"), NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based CONNECTION configuration failed pattern validation." , "loadLayer()");
             msFree(layer->connection);
@@ -4217,11 +4289,11 @@ int loadLayer(layerObj *layer, mapObj *map)
         }
         break;
       case(CONNECTIONTYPE):
-        if((layer->connectiontype = getSymbol(11, MS_SDE, MS_OGR, MS_POSTGIS, MS_WMS, MS_ORACLESPATIAL, MS_WFS, MS_GRATICULE, MS_PLUGIN, MS_UNION, MS_UVRASTER, MS_CONTOUR)) == -1) return(-1);
+        if((layer->connectiontype = getSymbol(lexer, 11, MS_SDE, MS_OGR, MS_POSTGIS, MS_WMS, MS_ORACLESPATIAL, MS_WFS, MS_GRATICULE, MS_PLUGIN, MS_UNION, MS_UVRASTER, MS_CONTOUR)) == -1) return(-1);
         break;
       case(DATA):
-        if(getString(&layer->data) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &layer->data) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->data, msLookupHashTable(&(layer->validation), "data"), msLookupHashTable(&(map->web.validation), "data"), map->datapattern, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based DATA configuration failed pattern validation." , "loadLayer()");
             msFree(layer->data);
@@ -4231,11 +4303,11 @@ int loadLayer(layerObj *layer, mapObj *map)
         }
         break;
       case(DEBUG):
-        if((layer->debug = getSymbol(3, MS_ON,MS_OFF, MS_NUMBER)) == -1) return(-1);
-        if(layer->debug == MS_NUMBER) layer->debug = (int) msyynumber;
+        if((layer->debug = getSymbol(lexer, 3, MS_ON,MS_OFF, MS_NUMBER)) == -1) return(-1);
+        if(layer->debug == MS_NUMBER) layer->debug = (int) lexer->number;
         break;
       case(DUMP):
-        if((layer->dump = getSymbol(2, MS_TRUE,MS_FALSE)) == -1) return(-1);
+        if((layer->dump = getSymbol(lexer, 2, MS_TRUE,MS_FALSE)) == -1) return(-1);
         break;
       case(EOF):
         msSetError(MS_EOFERR, NULL, "loadLayer()");
@@ -4250,10 +4322,10 @@ int loadLayer(layerObj *layer, mapObj *map)
         return(0);
         break;
       case(EXTENT): {
-        if(getDouble(&(layer->extent.minx)) == -1) return(-1);
-        if(getDouble(&(layer->extent.miny)) == -1) return(-1);
-        if(getDouble(&(layer->extent.maxx)) == -1) return(-1);
-        if(getDouble(&(layer->extent.maxy)) == -1) return(-1);
+        if(getDouble(lexer, &(layer->extent.minx)) == -1) return(-1);
+        if(getDouble(lexer, &(layer->extent.miny)) == -1) return(-1);
+        if(getDouble(lexer, &(layer->extent.maxx)) == -1) return(-1);
+        if(getDouble(lexer, &(layer->extent.maxy)) == -1) return(-1);
         if (!MS_VALID_EXTENT(layer->extent)) {
           msSetError(MS_MISCERR, "Given layer extent is invalid. Check that it is in the form: minx, miny, maxx, maxy", "loadLayer()");
           return(-1);
@@ -4275,11 +4347,11 @@ int loadLayer(layerObj *layer, mapObj *map)
 
         layer->connectiontype = MS_INLINE;
 
-        if(loadFeature(layer, type) == MS_FAILURE) return(-1);
+        if(loadFeature(lexer, layer, type) == MS_FAILURE) return(-1);
         break;
       case(FILTER):
-        if(loadExpression(&(layer->filter)) == -1) return(-1); /* loadExpression() cleans up previously allocated expression */
-        if(msyysource == MS_URL_TOKENS) {
+        if(loadExpression(lexer, &(layer->filter)) == -1) return(-1); /* loadExpression() cleans up previously allocated expression */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->filter.string, msLookupHashTable(&(layer->validation), "filter"), msLookupHashTable(&(map->web.validation), "filter"), NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based FILTER configuration failed pattern validation." , "loadLayer()");
             freeExpression(&(layer->filter));
@@ -4288,8 +4360,8 @@ int loadLayer(layerObj *layer, mapObj *map)
         }
         break;
       case(FILTERITEM):
-        if(getString(&layer->filteritem) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &layer->filteritem) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->filteritem, msLookupHashTable(&(layer->validation), "filteritem"), msLookupHashTable(&(map->web.validation), "filteritem"), NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based FILTERITEM configuration failed pattern validation." , "loadLayer()");
             msFree(layer->filteritem);
@@ -4299,8 +4371,8 @@ int loadLayer(layerObj *layer, mapObj *map)
         }
         break;
       case(FOOTER):
-        if(getString(&layer->footer) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &layer->footer) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->footer, msLookupHashTable(&(layer->validation), "footer"), msLookupHashTable(&(map->web.validation), "footer"), map->templatepattern, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based FOOTER configuration failed pattern validation." , "loadLayer()");
             msFree(layer->footer);
@@ -4315,11 +4387,11 @@ int loadLayer(layerObj *layer, mapObj *map)
         MS_CHECK_ALLOC(layer->layerinfo, sizeof(graticuleObj), -1);
 
         initGrid((graticuleObj *) layer->layerinfo);
-        loadGrid(layer);
+        loadGrid(lexer, layer);
         break;
       case(GROUP):
-        if(getString(&layer->group) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &layer->group) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->group, msLookupHashTable(&(layer->validation), "group"), msLookupHashTable(&(map->web.validation), "group"), NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based GROUP configuration failed pattern validation." , "loadLayer()");
             msFree(layer->group);
@@ -4330,16 +4402,16 @@ int loadLayer(layerObj *layer, mapObj *map)
         break;
       case(GEOMTRANSFORM): {
         int s;
-        if((s = getSymbol(1, MS_EXPRESSION)) == -1) return(MS_FAILURE);
+        if((s = getSymbol(lexer, 1, MS_EXPRESSION)) == -1) return(MS_FAILURE);
         /* handle expression case here for the moment */
         msFree(layer->_geomtransform.string);
-        layer->_geomtransform.string = msStrdup(msyystring_buffer);
+        layer->_geomtransform.string = msStrdup(lexer->string_buffer);
         layer->_geomtransform.type = MS_GEOMTRANSFORM_EXPRESSION;
       }
       break;
       case(HEADER):
-        if(getString(&layer->header) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &layer->header) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->header, msLookupHashTable(&(layer->validation), "header"), msLookupHashTable(&(map->web.validation), "header"), map->templatepattern, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based HEADER configuration failed pattern validation." , "loadLayer()");
             msFree(layer->header);
@@ -4354,15 +4426,15 @@ int loadLayer(layerObj *layer, mapObj *map)
           return(-1);
         }
 
-        if(loadJoin(&(layer->joins[layer->numjoins])) == -1) return(-1);
+        if(loadJoin(lexer, &(layer->joins[layer->numjoins])) == -1) return(-1);
         layer->numjoins++;
         break;
       case(LABELCACHE):
-        if((layer->labelcache = getSymbol(2, MS_ON, MS_OFF)) == -1) return(-1);
+        if((layer->labelcache = getSymbol(lexer, 2, MS_ON, MS_OFF)) == -1) return(-1);
         break;
       case(LABELITEM):
-        if(getString(&layer->labelitem) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &layer->labelitem) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->labelitem, msLookupHashTable(&(layer->validation), "labelitem"), msLookupHashTable(&(map->web.validation), "labelitem"), NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based LABELITEM configuration failed pattern validation." , "loadLayer()");
             msFree(layer->labelitem);
@@ -4373,15 +4445,15 @@ int loadLayer(layerObj *layer, mapObj *map)
         break;
       case(LABELMAXSCALE):
       case(LABELMAXSCALEDENOM):
-        if(getDouble(&(layer->labelmaxscaledenom)) == -1) return(-1);
+        if(getDouble(lexer, &(layer->labelmaxscaledenom)) == -1) return(-1);
         break;
       case(LABELMINSCALE):
       case(LABELMINSCALEDENOM):
-        if(getDouble(&(layer->labelminscaledenom)) == -1) return(-1);
+        if(getDouble(lexer, &(layer->labelminscaledenom)) == -1) return(-1);
         break;
       case(LABELREQUIRES):
-        if(getString(&layer->labelrequires) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &layer->labelrequires) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->labelrequires, msLookupHashTable(&(layer->validation), "labelrequires"), msLookupHashTable(&(map->web.validation), "labelrequires"), NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based LABELREQUIRES configuration failed pattern validation." , "loadLayer()");
             msFree(layer->labelrequires);
@@ -4393,8 +4465,8 @@ int loadLayer(layerObj *layer, mapObj *map)
       case(LAYER):
         break; /* for string loads */
       case(MASK):
-        if(getString(&layer->mask) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &layer->mask) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->mask, msLookupHashTable(&(layer->validation), "mask"), msLookupHashTable(&(map->web.validation), "mask"), NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based MASK configuration failed pattern validation." , "loadLayer()");
             msFree(layer->mask);
@@ -4404,42 +4476,42 @@ int loadLayer(layerObj *layer, mapObj *map)
         }
         break;
       case(MAXFEATURES):
-        if(getInteger(&(layer->maxfeatures)) == -1) return(-1);
+        if(getInteger(lexer, &(layer->maxfeatures)) == -1) return(-1);
         break;
       case(MAXSCALE):
       case(MAXSCALEDENOM):
-        if(getDouble(&(layer->maxscaledenom)) == -1) return(-1);
+        if(getDouble(lexer, &(layer->maxscaledenom)) == -1) return(-1);
         break;
       case(MAXGEOWIDTH):
-        if(getDouble(&(layer->maxgeowidth)) == -1) return(-1);
+        if(getDouble(lexer, &(layer->maxgeowidth)) == -1) return(-1);
         break;
       case(METADATA):
-        if(loadHashTable(&(layer->metadata)) != MS_SUCCESS) return(-1);
+        if(loadHashTable(lexer, &(layer->metadata)) != MS_SUCCESS) return(-1);
         break;
       case(MINSCALE):
       case(MINSCALEDENOM):
-        if(getDouble(&(layer->minscaledenom)) == -1) return(-1);
+        if(getDouble(lexer, &(layer->minscaledenom)) == -1) return(-1);
         break;
       case(MINGEOWIDTH):
-        if(getDouble(&(layer->mingeowidth)) == -1) return(-1);
+        if(getDouble(lexer, &(layer->mingeowidth)) == -1) return(-1);
         break;
       case(MINFEATURESIZE):
-        if(getInteger(&(layer->minfeaturesize)) == -1) return(-1);
+        if(getInteger(lexer, &(layer->minfeaturesize)) == -1) return(-1);
         break;
       case(NAME):
-        if(getString(&layer->name) == MS_FAILURE) return(-1);
+        if(getString(lexer, &layer->name) == MS_FAILURE) return(-1);
         break;
       case(OFFSITE):
-        if(loadColor(&(layer->offsite), NULL) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(layer->offsite), NULL) != MS_SUCCESS) return(-1);
         break;
       case(OPACITY):
       case(TRANSPARENCY): /* keyword supported for mapfile backwards compatability */
-        if (getIntegerOrSymbol(&(layer->opacity), 1, MS_GD_ALPHA) == -1)
+        if (getIntegerOrSymbol(lexer, &(layer->opacity), 1, MS_GD_ALPHA) == -1)
           return(-1);
         break;
       case(MS_PLUGIN): {
         int rv;
-        if(getString(&layer->plugin_library_original) == MS_FAILURE) return(-1);
+        if(getString(lexer, &layer->plugin_library_original) == MS_FAILURE) return(-1);
         rv = msBuildPluginLibraryPath(&layer->plugin_library,
                                       layer->plugin_library_original,
                                       map);
@@ -4451,8 +4523,8 @@ int loadLayer(layerObj *layer, mapObj *map)
                  This ensure that CSL (GDAL string list) functions can be
                  used on the list for easy processing. */
         char *value=NULL;
-        if(getString(&value) == MS_FAILURE) return(-1);
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &value) == MS_FAILURE) return(-1);
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(value, msLookupHashTable(&(layer->validation), "processing"), msLookupHashTable(&(map->web.validation), "processing"), NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based PROCESSING configuration failed pattern validation." , "loadLayer()");
             free(value);
@@ -4466,17 +4538,17 @@ int loadLayer(layerObj *layer, mapObj *map)
       }
       break;
       case(POSTLABELCACHE):
-        if((layer->postlabelcache = getSymbol(2, MS_TRUE, MS_FALSE)) == -1) return(-1);
+        if((layer->postlabelcache = getSymbol(lexer, 2, MS_TRUE, MS_FALSE)) == -1) return(-1);
         if(layer->postlabelcache)
           layer->labelcache = MS_OFF;
         break;
       case(PROJECTION):
-        if(loadProjection(&(layer->projection)) == -1) return(-1);
+        if(loadProjection(lexer, &(layer->projection)) == -1) return(-1);
         layer->project = MS_TRUE;
         break;
       case(REQUIRES):
-        if(getString(&layer->requires) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &layer->requires) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->requires, msLookupHashTable(&(layer->validation), "requires"), msLookupHashTable(&(map->web.validation), "requires"), NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based REQUIRES configuration failed pattern validation." , "loadLayer()");
             msFree(layer->requires);
@@ -4489,18 +4561,18 @@ int loadLayer(layerObj *layer, mapObj *map)
         if (msGrowLayerScaletokens(layer) == NULL)
           return(-1);
         initScaleToken(&layer->scaletokens[layer->numscaletokens]);
-        if(loadScaletoken(&layer->scaletokens[layer->numscaletokens], layer) == -1) return(-1);
+        if(loadScaletoken(lexer, &layer->scaletokens[layer->numscaletokens], layer) == -1) return(-1);
         layer->numscaletokens++;
         break;
       case(SIZEUNITS):
-        if((layer->sizeunits = getSymbol(8, MS_INCHES,MS_FEET,MS_MILES,MS_METERS,MS_KILOMETERS,MS_NAUTICALMILES,MS_DD,MS_PIXELS)) == -1) return(-1);
+        if((layer->sizeunits = getSymbol(lexer, 8, MS_INCHES,MS_FEET,MS_MILES,MS_METERS,MS_KILOMETERS,MS_NAUTICALMILES,MS_DD,MS_PIXELS)) == -1) return(-1);
         break;
       case(STATUS):
-        if((layer->status = getSymbol(3, MS_ON,MS_OFF,MS_DEFAULT)) == -1) return(-1);
+        if((layer->status = getSymbol(lexer, 3, MS_ON,MS_OFF,MS_DEFAULT)) == -1) return(-1);
         break;
       case(STYLEITEM):
-        if(getString(&layer->styleitem) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &layer->styleitem) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->styleitem, msLookupHashTable(&(layer->validation), "styleitem"), msLookupHashTable(&(map->web.validation), "styleitem"), NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based STYLEITEM configuration failed pattern validation." , "loadLayer()");
             msFree(layer->styleitem);
@@ -4511,11 +4583,11 @@ int loadLayer(layerObj *layer, mapObj *map)
         break;
       case(SYMBOLSCALE):
       case(SYMBOLSCALEDENOM):
-        if(getDouble(&(layer->symbolscaledenom)) == -1) return(-1);
+        if(getDouble(lexer, &(layer->symbolscaledenom)) == -1) return(-1);
         break;
       case(TEMPLATE):
-        if(getString(&layer->template) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &layer->template) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->template, msLookupHashTable(&(layer->validation), "template"), msLookupHashTable(&(map->web.validation), "template"), map->templatepattern, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based TEMPLATE configuration failed pattern validation." , "loadLayer()");
             msFree(layer->template);
@@ -4525,8 +4597,8 @@ int loadLayer(layerObj *layer, mapObj *map)
         }
         break;
       case(TILEINDEX):
-        if(getString(&layer->tileindex) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &layer->tileindex) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->tileindex, msLookupHashTable(&(layer->validation), "tileindex"), msLookupHashTable(&(map->web.validation), "tileindex"), NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based TILEINDEX configuration failed pattern validation." , "loadLayer()");
             msFree(layer->tileindex);
@@ -4536,8 +4608,8 @@ int loadLayer(layerObj *layer, mapObj *map)
         }
         break;
       case(TILEITEM):
-        if(getString(&layer->tileitem) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &layer->tileitem) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->tileitem, msLookupHashTable(&(layer->validation), "tileitem"), msLookupHashTable(&(map->web.validation), "tileitem"), NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based TILEITEM configuration failed pattern validation." , "loadLayer()");
             msFree(layer->tileitem);
@@ -4547,8 +4619,8 @@ int loadLayer(layerObj *layer, mapObj *map)
         }
         break;
       case(TILESRS):
-        if(getString(&layer->tilesrs) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &layer->tilesrs) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(layer->tilesrs, msLookupHashTable(&(layer->validation), "tilesrs"), msLookupHashTable(&(map->web.validation), "tilesrs"), NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based TILESRS configuration failed pattern validation." , "loadLayer()");
             msFree(layer->tilesrs);
@@ -4558,27 +4630,27 @@ int loadLayer(layerObj *layer, mapObj *map)
         }
         break;
       case(TOLERANCE):
-        if(getDouble(&(layer->tolerance)) == -1) return(-1);
+        if(getDouble(lexer, &(layer->tolerance)) == -1) return(-1);
         break;
       case(TOLERANCEUNITS):
-        if((layer->toleranceunits = getSymbol(8, MS_INCHES,MS_FEET,MS_MILES,MS_METERS,MS_KILOMETERS,MS_NAUTICALMILES,MS_DD,MS_PIXELS)) == -1) return(-1);
+        if((layer->toleranceunits = getSymbol(lexer, 8, MS_INCHES,MS_FEET,MS_MILES,MS_METERS,MS_KILOMETERS,MS_NAUTICALMILES,MS_DD,MS_PIXELS)) == -1) return(-1);
         break;
       case(TRANSFORM):
-        if((layer->transform = getSymbol(11, MS_TRUE,MS_FALSE, MS_UL,MS_UC,MS_UR,MS_CL,MS_CC,MS_CR,MS_LL,MS_LC,MS_LR)) == -1) return(-1);
+        if((layer->transform = getSymbol(lexer, 11, MS_TRUE,MS_FALSE, MS_UL,MS_UC,MS_UR,MS_CL,MS_CC,MS_CR,MS_LL,MS_LC,MS_LR)) == -1) return(-1);
         break;
       case(TYPE):
-        if((layer->type = getSymbol(9, MS_LAYER_POINT,MS_LAYER_LINE,MS_LAYER_RASTER,MS_LAYER_POLYGON,MS_LAYER_ANNOTATION,MS_LAYER_QUERY,MS_LAYER_CIRCLE,MS_LAYER_CHART,TILEINDEX)) == -1) return(-1);
+        if((layer->type = getSymbol(lexer, 9, MS_LAYER_POINT,MS_LAYER_LINE,MS_LAYER_RASTER,MS_LAYER_POLYGON,MS_LAYER_ANNOTATION,MS_LAYER_QUERY,MS_LAYER_CIRCLE,MS_LAYER_CHART,TILEINDEX)) == -1) return(-1);
         if(layer->type == TILEINDEX) layer->type = MS_LAYER_TILEINDEX; /* TILEINDEX is also a parameter */
         break;
       case(UNITS):
-        if((layer->units = getSymbol(9, MS_INCHES,MS_FEET,MS_MILES,MS_METERS,MS_KILOMETERS,MS_NAUTICALMILES,MS_DD,MS_PIXELS,MS_PERCENTAGES)) == -1) return(-1);
+        if((layer->units = getSymbol(lexer, 9, MS_INCHES,MS_FEET,MS_MILES,MS_METERS,MS_KILOMETERS,MS_NAUTICALMILES,MS_DD,MS_PIXELS,MS_PERCENTAGES)) == -1) return(-1);
         break;
       case(VALIDATION):
-        if(loadHashTable(&(layer->validation)) != MS_SUCCESS) return(-1);
+        if(loadHashTable(lexer, &(layer->validation)) != MS_SUCCESS) return(-1);
         break;
       default:
-        if(strlen(msyystring_buffer) > 0) {
-          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadLayer()", msyystring_buffer, msyylineno);
+        if(strlen(lexer->string_buffer) > 0) {
+          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadLayer()", lexer->string_buffer, lexer->lineno);
           return(-1);
         } else {
           return(0); /* end of a string, not an error */
@@ -4589,28 +4661,27 @@ int loadLayer(layerObj *layer, mapObj *map)
 
 int msUpdateLayerFromString(layerObj *layer, char *string, int url_string)
 {
+  lexerObj lexer;
   int i;
 
   if(!layer || !string) return MS_FAILURE;
 
-  msAcquireLock( TLOCK_PARSER );
+  if(msInitLexer(&lexer) != MS_SUCCESS) return MS_FAILURE;
 
   if(url_string)
-    msyystate = MS_TOKENIZE_URL_STRING;
+    lexer.state = MS_TOKENIZE_URL_STRING;
   else
-    msyystate = MS_TOKENIZE_STRING;
-  msyystring = string;
-  msyylex(); /* sets things up, but doesn't process any tokens */
+    lexer.state = MS_TOKENIZE_STRING;
+  lexer.string = string;
+  msyylex(lexer.scanner); /* sets things up, but doesn't process any tokens */
 
-  msyylineno = 1; /* start at line 1 */
+  lexer.lineno = 1; /* start at line 1 */
 
-  if(loadLayer(layer, layer->map) == -1) {
-    msReleaseLock( TLOCK_PARSER );
+  if(loadLayer(&lexer, layer, layer->map) == -1) {
+    msFreeLexer(&lexer);
     return MS_FAILURE; /* parse error */;
   }
-  msReleaseLock( TLOCK_PARSER );
-
-  msyylex_destroy();
+  msFreeLexer(&lexer);
 
   /* step through classes to resolve symbol names */
   for(i=0; i<layer->numclasses; i++) {
@@ -4630,7 +4701,7 @@ static void writeLayer(FILE *stream, int indent, layerObj *layer)
 
   indent++;
   writeBlockBegin(stream, indent, "LAYER");
-  /* bindvals */
+  writeHashTable(stream, indent, "BINDVALS", &(layer->bindvals));
   /* class - see below */
   writeString(stream, indent, "CLASSGROUP", NULL, layer->classgroup);
   writeString(stream, indent, "CLASSITEM", NULL, layer->classitem);
@@ -4643,11 +4714,15 @@ static void writeLayer(FILE *stream, int indent, layerObj *layer)
   writeExpression(stream, indent, "FILTER", &(layer->filter));
   writeString(stream, indent, "FILTERITEM", NULL, layer->filteritem);
   writeString(stream, indent, "FOOTER", NULL, layer->footer);
+  if(layer->_geomtransform.type == MS_GEOMTRANSFORM_EXPRESSION) {
+    writeIndent(stream, indent + 1);
+    msIO_fprintf(stream, "GEOMTRANSFORM (%s)\n", layer->_geomtransform.string);
+  }
   writeString(stream, indent, "GROUP", NULL, layer->group);
 
   if(layer->_geomtransform.type == MS_GEOMTRANSFORM_EXPRESSION) {
     writeIndent(stream, indent + 1);
-    fprintf(stream, "GEOMTRANSFORM (%s)\n", layer->_geomtransform.string);
+    msIO_fprintf(stream, "GEOMTRANSFORM (%s)\n", layer->_geomtransform.string);
   }
   
   writeString(stream, indent, "HEADER", NULL, layer->header);
@@ -4756,14 +4831,14 @@ void freeReferenceMap(referenceMapObj *ref)
   msFree(ref->markername);
 }
 
-int loadReferenceMap(referenceMapObj *ref, mapObj *map)
+int loadReferenceMap(lexerObj *lexer, referenceMapObj *ref, mapObj *map)
 {
   int state;
 
   ref->map = (mapObj *)map;
 
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(EOF):
         msSetError(MS_EOFERR, NULL, "loadReferenceMap()");
         return(-1);
@@ -4779,13 +4854,13 @@ int loadReferenceMap(referenceMapObj *ref, mapObj *map)
         return(0);
         break;
       case(COLOR):
-        if(loadColor(&(ref->color), NULL) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(ref->color), NULL) != MS_SUCCESS) return(-1);
         break;
       case(EXTENT):
-        if(getDouble(&(ref->extent.minx)) == -1) return(-1);
-        if(getDouble(&(ref->extent.miny)) == -1) return(-1);
-        if(getDouble(&(ref->extent.maxx)) == -1) return(-1);
-        if(getDouble(&(ref->extent.maxy)) == -1) return(-1);
+        if(getDouble(lexer, &(ref->extent.minx)) == -1) return(-1);
+        if(getDouble(lexer, &(ref->extent.miny)) == -1) return(-1);
+        if(getDouble(lexer, &(ref->extent.maxx)) == -1) return(-1);
+        if(getDouble(lexer, &(ref->extent.maxy)) == -1) return(-1);
         if (!MS_VALID_EXTENT(ref->extent)) {
           msSetError(MS_MISCERR, "Given reference extent is invalid. Check that it " \
                      "is in the form: minx, miny, maxx, maxy", "loadReferenceMap()");
@@ -4793,43 +4868,43 @@ int loadReferenceMap(referenceMapObj *ref, mapObj *map)
         }
         break;
       case(IMAGE):
-        if(getString(&ref->image) == MS_FAILURE) return(-1);
+        if(getString(lexer, &ref->image) == MS_FAILURE) return(-1);
         break;
       case(OUTLINECOLOR):
-        if(loadColor(&(ref->outlinecolor), NULL) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(ref->outlinecolor), NULL) != MS_SUCCESS) return(-1);
         break;
       case(SIZE):
-        if(getInteger(&(ref->width)) == -1) return(-1);
-        if(getInteger(&(ref->height)) == -1) return(-1);
+        if(getInteger(lexer, &(ref->width)) == -1) return(-1);
+        if(getInteger(lexer, &(ref->height)) == -1) return(-1);
         break;
       case(STATUS):
-        if((ref->status = getSymbol(2, MS_ON,MS_OFF)) == -1) return(-1);
+        if((ref->status = getSymbol(lexer, 2, MS_ON,MS_OFF)) == -1) return(-1);
         break;
       case(MARKER):
-        if((state = getSymbol(2, MS_NUMBER,MS_STRING)) == -1) return(-1);
+        if((state = getSymbol(lexer, 2, MS_NUMBER,MS_STRING)) == -1) return(-1);
 
         if(state == MS_NUMBER)
-          ref->marker = (int) msyynumber;
+          ref->marker = (int) lexer->number;
         else {
           if (ref->markername != NULL)
             msFree(ref->markername);
-          ref->markername = msStrdup(msyystring_buffer);
+          ref->markername = msStrdup(lexer->string_buffer);
         }
         break;
       case(MARKERSIZE):
-        if(getInteger(&(ref->markersize)) == -1) return(-1);
+        if(getInteger(lexer, &(ref->markersize)) == -1) return(-1);
         break;
       case(MINBOXSIZE):
-        if(getInteger(&(ref->minboxsize)) == -1) return(-1);
+        if(getInteger(lexer, &(ref->minboxsize)) == -1) return(-1);
         break;
       case(MAXBOXSIZE):
-        if(getInteger(&(ref->maxboxsize)) == -1) return(-1);
+        if(getInteger(lexer, &(ref->maxboxsize)) == -1) return(-1);
         break;
       case(REFERENCE):
         break; /* for string loads */
       default:
-        if(strlen(msyystring_buffer) > 0) {
-          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadReferenceMap()", msyystring_buffer, msyylineno);
+        if(strlen(lexer->string_buffer) > 0) {
+          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadReferenceMap()", lexer->string_buffer, lexer->lineno);
           return(-1);
         } else {
           return(0); /* end of a string, not an error */
@@ -4840,26 +4915,26 @@ int loadReferenceMap(referenceMapObj *ref, mapObj *map)
 
 int msUpdateReferenceMapFromString(referenceMapObj *ref, char *string, int url_string)
 {
+  lexerObj lexer;
+
   if(!ref || !string) return MS_FAILURE;
 
-  msAcquireLock( TLOCK_PARSER );
+  if(msInitLexer(&lexer) != MS_SUCCESS) return MS_FAILURE;
 
   if(url_string)
-    msyystate = MS_TOKENIZE_URL_STRING;
+    lexer.state = MS_TOKENIZE_URL_STRING;
   else
-    msyystate = MS_TOKENIZE_STRING;
-  msyystring = string;
-  msyylex(); /* sets things up, but doesn't process any tokens */
+    lexer.state = MS_TOKENIZE_STRING;
+  lexer.string = string;
+  msyylex(lexer.scanner); /* sets things up, but doesn't process any tokens */
 
-  msyylineno = 1; /* start at line 1 */
+  lexer.lineno = 1; /* start at line 1 */
 
-  if(loadReferenceMap(ref, ref->map) == -1) {
-    msReleaseLock( TLOCK_PARSER );
+  if(loadReferenceMap(&lexer, ref, ref->map) == -1) {
+    msFreeLexer(&lexer);
     return MS_FAILURE; /* parse error */;
   }
-  msReleaseLock( TLOCK_PARSER );
-
-  msyylex_destroy();
+  msFreeLexer(&lexer);
   return MS_SUCCESS;
 }
 
@@ -4912,7 +4987,7 @@ char* msWriteReferenceMapToString(referenceMapObj *ref)
 
 #define MAX_FORMATOPTIONS 100
 
-static int loadOutputFormat(mapObj *map)
+static int loadOutputFormat(lexerObj *lexer, mapObj *map)
 {
   char *name = NULL;
   char *mimetype = NULL;
@@ -4925,7 +5000,7 @@ static int loadOutputFormat(mapObj *map)
   char *value = NULL;
 
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(EOF):
         msSetError(MS_EOFERR, NULL, "loadOutputFormat()");
         return(-1);
@@ -4937,7 +5012,7 @@ static int loadOutputFormat(mapObj *map)
           msSetError(MS_MISCERR,
                      "OUTPUTFORMAT clause lacks DRIVER keyword near (%s):(%d)",
                      "loadOutputFormat()",
-                     msyystring_buffer, msyylineno );
+                     lexer->string_buffer, lexer->lineno );
           return -1;
         }
 
@@ -5000,22 +5075,22 @@ static int loadOutputFormat(mapObj *map)
       }
       case(NAME):
         msFree( name );
-        if((name = getToken()) == NULL) return(-1);
+        if((name = getToken(lexer)) == NULL) return(-1);
         break;
       case(MIMETYPE):
-        if(getString(&mimetype) == MS_FAILURE) return(-1);
+        if(getString(lexer, &mimetype) == MS_FAILURE) return(-1);
         break;
       case(DRIVER): {
         int s;
-        if((s = getSymbol(2, MS_STRING, TEMPLATE)) == -1) return -1; /* allow the template to be quoted or not in the mapfile */
+        if((s = getSymbol(lexer, 2, MS_STRING, TEMPLATE)) == -1) return -1; /* allow the template to be quoted or not in the mapfile */
         if(s == MS_STRING)
-          driver = msStrdup(msyystring_buffer);
+          driver = msStrdup(lexer->string_buffer);
         else
           driver = msStrdup("TEMPLATE");
       }
       break;
       case(EXTENSION):
-        if(getString(&extension) == MS_FAILURE) return(-1);
+        if(getString(lexer, &extension) == MS_FAILURE) return(-1);
         if( extension[0] == '.' ) {
           char *temp = msStrdup(extension+1);
           free( extension );
@@ -5023,14 +5098,14 @@ static int loadOutputFormat(mapObj *map)
         }
         break;
       case(FORMATOPTION):
-        if(getString(&value) == MS_FAILURE) return(-1);
+        if(getString(lexer, &value) == MS_FAILURE) return(-1);
         if( numformatoptions < MAX_FORMATOPTIONS )
           formatoptions[numformatoptions++] = msStrdup(value);
         free(value);
         value=NULL;
         break;
       case(IMAGEMODE):
-        value = getToken();
+        value = getToken(lexer);
         if( strcasecmp(value,"PC256") == 0 )
           imagemode = MS_IMAGEMODE_PC256;
         else if( strcasecmp(value,"RGB") == 0 )
@@ -5048,18 +5123,18 @@ static int loadOutputFormat(mapObj *map)
         else {
           msSetError(MS_IDENTERR,
                      "Parsing error near (%s):(line %d), expected PC256, RGB, RGBA, FEATURE, BYTE, INT16, or FLOAT32 for IMAGEMODE.", "loadOutputFormat()",
-                     msyystring_buffer, msyylineno);
+                     lexer->string_buffer, lexer->lineno);
           return -1;
         }
         free(value);
         value=NULL;
         break;
       case(TRANSPARENT):
-        if((transparent = getSymbol(2, MS_ON,MS_OFF)) == -1) return(-1);
+        if((transparent = getSymbol(lexer, 2, MS_ON,MS_OFF)) == -1) return(-1);
         break;
       default:
         msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadOutputFormat()",
-                   msyystring_buffer, msyylineno);
+                   lexer->string_buffer, lexer->lineno);
         return(-1);
     }
   } /* next token */
@@ -5133,12 +5208,12 @@ void freeLegend(legendObj *legend)
   freeLabel(&(legend->label));
 }
 
-int loadLegend(legendObj *legend, mapObj *map)
+int loadLegend(lexerObj *lexer, legendObj *legend, mapObj *map)
 {
   legend->map = (mapObj *)map;
 
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(EOF):
         msSetError(MS_EOFERR, NULL, "loadLegend()");
         return(-1);
@@ -5147,46 +5222,46 @@ int loadLegend(legendObj *legend, mapObj *map)
         return(0);
         break;
       case(IMAGECOLOR):
-        if(loadColor(&(legend->imagecolor), NULL) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(legend->imagecolor), NULL) != MS_SUCCESS) return(-1);
         break;
       case(INTERLACE):
-        if((legend->interlace = getSymbol(2, MS_ON,MS_OFF)) == -1) return(-1);
+        if((legend->interlace = getSymbol(lexer, 2, MS_ON,MS_OFF)) == -1) return(-1);
         break;
       case(KEYSIZE):
-        if(getInteger(&(legend->keysizex)) == -1) return(-1);
-        if(getInteger(&(legend->keysizey)) == -1) return(-1);
+        if(getInteger(lexer, &(legend->keysizex)) == -1) return(-1);
+        if(getInteger(lexer, &(legend->keysizey)) == -1) return(-1);
         break;
       case(KEYSPACING):
-        if(getInteger(&(legend->keyspacingx)) == -1) return(-1);
-        if(getInteger(&(legend->keyspacingy)) == -1) return(-1);
+        if(getInteger(lexer, &(legend->keyspacingx)) == -1) return(-1);
+        if(getInteger(lexer, &(legend->keyspacingy)) == -1) return(-1);
         break;
       case(LABEL):
-        if(loadLabel(&(legend->label)) == -1) return(-1);
+        if(loadLabel(lexer, &(legend->label)) == -1) return(-1);
         legend->label.angle = 0; /* force */
         break;
       case(LEGEND):
         break; /* for string loads */
       case(OUTLINECOLOR):
-        if(loadColor(&(legend->outlinecolor), NULL) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(legend->outlinecolor), NULL) != MS_SUCCESS) return(-1);
         break;
       case(POSITION):
-        if((legend->position = getSymbol(6, MS_UL,MS_UR,MS_LL,MS_LR,MS_UC,MS_LC)) == -1) return(-1);
+        if((legend->position = getSymbol(lexer, 6, MS_UL,MS_UR,MS_LL,MS_LR,MS_UC,MS_LC)) == -1) return(-1);
         break;
       case(POSTLABELCACHE):
-        if((legend->postlabelcache = getSymbol(2, MS_TRUE,MS_FALSE)) == -1) return(-1);
+        if((legend->postlabelcache = getSymbol(lexer, 2, MS_TRUE,MS_FALSE)) == -1) return(-1);
         break;
       case(STATUS):
-        if((legend->status = getSymbol(3, MS_ON,MS_OFF,MS_EMBED)) == -1) return(-1);
+        if((legend->status = getSymbol(lexer, 3, MS_ON,MS_OFF,MS_EMBED)) == -1) return(-1);
         break;
       case(TRANSPARENT):
-        if((legend->transparent = getSymbol(2, MS_ON,MS_OFF)) == -1) return(-1);
+        if((legend->transparent = getSymbol(lexer, 2, MS_ON,MS_OFF)) == -1) return(-1);
         break;
       case(TEMPLATE):
-        if(getString(&legend->template) == MS_FAILURE) return(-1);
+        if(getString(lexer, &legend->template) == MS_FAILURE) return(-1);
         break;
       default:
-        if(strlen(msyystring_buffer) > 0) {
-          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadLegend()", msyystring_buffer, msyylineno);
+        if(strlen(lexer->string_buffer) > 0) {
+          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadLegend()", lexer->string_buffer, lexer->lineno);
           return(-1);
         } else {
           return(0); /* end of a string, not an error */
@@ -5197,26 +5272,26 @@ int loadLegend(legendObj *legend, mapObj *map)
 
 int msUpdateLegendFromString(legendObj *legend, char *string, int url_string)
 {
+  lexerObj lexer;
+
   if(!legend || !string) return MS_FAILURE;
 
-  msAcquireLock( TLOCK_PARSER );
+  if(msInitLexer(&lexer) != MS_SUCCESS) return MS_FAILURE;
 
   if(url_string)
-    msyystate = MS_TOKENIZE_URL_STRING;
+    lexer.state = MS_TOKENIZE_URL_STRING;
   else
-    msyystate = MS_TOKENIZE_STRING;
-  msyystring = string;
-  msyylex(); /* sets things up, but doesn't process any tokens */
+    lexer.state = MS_TOKENIZE_STRING;
+  lexer.string = string;
+  msyylex(lexer.scanner); /* sets things up, but doesn't process any tokens */
 
-  msyylineno = 1; /* start at line 1 */
+  lexer.lineno = 1; /* start at line 1 */
 
-  if(loadLegend(legend, legend->map) == -1) {
-    msReleaseLock( TLOCK_PARSER );
+  if(loadLegend(&lexer, legend, legend->map) == -1) {
+    msFreeLexer(&lexer);
     return MS_FAILURE; /* parse error */;
   }
-  msReleaseLock( TLOCK_PARSER );
-
-  msyylex_destroy();
+  msFreeLexer(&lexer);
   return MS_SUCCESS;
 }
 
@@ -5294,18 +5369,18 @@ void freeScalebar(scalebarObj *scalebar)
   freeLabel(&(scalebar->label));
 }
 
-int loadScalebar(scalebarObj *scalebar)
+int loadScalebar(lexerObj *lexer, scalebarObj *scalebar)
 {
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(ALIGN):
-        if((scalebar->align = getSymbol(3, MS_ALIGN_LEFT,MS_ALIGN_CENTER,MS_ALIGN_RIGHT)) == -1) return(-1);
+        if((scalebar->align = getSymbol(lexer, 3, MS_ALIGN_LEFT,MS_ALIGN_CENTER,MS_ALIGN_RIGHT)) == -1) return(-1);
         break;
       case(BACKGROUNDCOLOR):
-        if(loadColor(&(scalebar->backgroundcolor), NULL) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(scalebar->backgroundcolor), NULL) != MS_SUCCESS) return(-1);
         break;
       case(COLOR):
-        if(loadColor(&(scalebar->color), NULL) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(scalebar->color), NULL) != MS_SUCCESS) return(-1);
         break;
       case(EOF):
         msSetError(MS_EOFERR, NULL, "loadScalebar()");
@@ -5314,49 +5389,49 @@ int loadScalebar(scalebarObj *scalebar)
         return(0);
         break;
       case(IMAGECOLOR):
-        if(loadColor(&(scalebar->imagecolor), NULL) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(scalebar->imagecolor), NULL) != MS_SUCCESS) return(-1);
         break;
       case(INTERLACE):
-        if((scalebar->interlace = getSymbol(2, MS_ON,MS_OFF)) == -1) return(-1);
+        if((scalebar->interlace = getSymbol(lexer, 2, MS_ON,MS_OFF)) == -1) return(-1);
         break;
       case(INTERVALS):
-        if(getInteger(&(scalebar->intervals)) == -1) return(-1);
+        if(getInteger(lexer, &(scalebar->intervals)) == -1) return(-1);
         break;
       case(LABEL):
-        if(loadLabel(&(scalebar->label)) == -1) return(-1);
+        if(loadLabel(lexer, &(scalebar->label)) == -1) return(-1);
         scalebar->label.angle = 0;
         break;
       case(OUTLINECOLOR):
-        if(loadColor(&(scalebar->outlinecolor), NULL) != MS_SUCCESS) return(-1);
+        if(loadColor(lexer, &(scalebar->outlinecolor), NULL) != MS_SUCCESS) return(-1);
         break;
       case(POSITION):
-        if((scalebar->position = getSymbol(6, MS_UL,MS_UR,MS_LL,MS_LR,MS_UC,MS_LC)) == -1)
+        if((scalebar->position = getSymbol(lexer, 6, MS_UL,MS_UR,MS_LL,MS_LR,MS_UC,MS_LC)) == -1)
           return(-1);
         break;
       case(POSTLABELCACHE):
-        if((scalebar->postlabelcache = getSymbol(2, MS_TRUE,MS_FALSE)) == -1) return(-1);
+        if((scalebar->postlabelcache = getSymbol(lexer, 2, MS_TRUE,MS_FALSE)) == -1) return(-1);
         break;
       case(SCALEBAR):
         break; /* for string loads */
       case(SIZE):
-        if(getInteger(&(scalebar->width)) == -1) return(-1);
-        if(getInteger(&(scalebar->height)) == -1) return(-1);
+        if(getInteger(lexer, &(scalebar->width)) == -1) return(-1);
+        if(getInteger(lexer, &(scalebar->height)) == -1) return(-1);
         break;
       case(STATUS):
-        if((scalebar->status = getSymbol(3, MS_ON,MS_OFF,MS_EMBED)) == -1) return(-1);
+        if((scalebar->status = getSymbol(lexer, 3, MS_ON,MS_OFF,MS_EMBED)) == -1) return(-1);
         break;
       case(STYLE):
-        if(getInteger(&(scalebar->style)) == -1) return(-1);
+        if(getInteger(lexer, &(scalebar->style)) == -1) return(-1);
         break;
       case(TRANSPARENT):
-        if((scalebar->transparent = getSymbol(2, MS_ON,MS_OFF)) == -1) return(-1);
+        if((scalebar->transparent = getSymbol(lexer, 2, MS_ON,MS_OFF)) == -1) return(-1);
         break;
       case(UNITS):
-        if((scalebar->units = getSymbol(6, MS_INCHES,MS_FEET,MS_MILES,MS_METERS,MS_KILOMETERS,MS_NAUTICALMILES)) == -1) return(-1);
+        if((scalebar->units = getSymbol(lexer, 6, MS_INCHES,MS_FEET,MS_MILES,MS_METERS,MS_KILOMETERS,MS_NAUTICALMILES)) == -1) return(-1);
         break;
       default:
-        if(strlen(msyystring_buffer) > 0) {
-          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadScalebar()", msyystring_buffer, msyylineno);
+        if(strlen(lexer->string_buffer) > 0) {
+          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadScalebar()", lexer->string_buffer, lexer->lineno);
           return(-1);
         } else {
           return(0); /* end of a string, not an error */
@@ -5367,26 +5442,26 @@ int loadScalebar(scalebarObj *scalebar)
 
 int msUpdateScalebarFromString(scalebarObj *scalebar, char *string, int url_string)
 {
+  lexerObj lexer;
+
   if(!scalebar || !string) return MS_FAILURE;
 
-  msAcquireLock( TLOCK_PARSER );
+  if(msInitLexer(&lexer) != MS_SUCCESS) return MS_FAILURE;
 
   if(url_string)
-    msyystate = MS_TOKENIZE_URL_STRING;
+    lexer.state = MS_TOKENIZE_URL_STRING;
   else
-    msyystate = MS_TOKENIZE_STRING;
-  msyystring = string;
-  msyylex(); /* sets things up, but doesn't process any tokens */
+    lexer.state = MS_TOKENIZE_STRING;
+  lexer.string = string;
+  msyylex(lexer.scanner); /* sets things up, but doesn't process any tokens */
 
-  msyylineno = 1; /* start at line 1 */
+  lexer.lineno = 1; /* start at line 1 */
 
-  if(loadScalebar(scalebar) == -1) {
-    msReleaseLock( TLOCK_PARSER );
+  if(loadScalebar(&lexer, scalebar) == -1) {
+    msFreeLexer(&lexer);
     return MS_FAILURE; /* parse error */;
   }
-  msReleaseLock( TLOCK_PARSER );
-
-  msyylex_destroy();
+  msFreeLexer(&lexer);
   return MS_SUCCESS;
 }
 
@@ -5450,14 +5525,14 @@ void initQueryMap(queryMapObj *querymap)
   MS_INIT_COLOR(querymap->color, 255,255,0,255); /* yellow */
 }
 
-int loadQueryMap(queryMapObj *querymap)
+int loadQueryMap(lexerObj *lexer, queryMapObj *querymap)
 {
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(QUERYMAP):
         break; /* for string loads */
       case(COLOR):
-        loadColor(&(querymap->color), NULL);
+        loadColor(lexer, &(querymap->color), NULL);
         break;
       case(EOF):
         msSetError(MS_EOFERR, NULL, "loadQueryMap()");
@@ -5466,19 +5541,19 @@ int loadQueryMap(queryMapObj *querymap)
         return(0);
         break;
       case(SIZE):
-        if(getInteger(&(querymap->width)) == -1) return(-1);
-        if(getInteger(&(querymap->height)) == -1) return(-1);
+        if(getInteger(lexer, &(querymap->width)) == -1) return(-1);
+        if(getInteger(lexer, &(querymap->height)) == -1) return(-1);
         break;
       case(STATUS):
-        if((querymap->status = getSymbol(2, MS_ON,MS_OFF)) == -1) return(-1);
+        if((querymap->status = getSymbol(lexer, 2, MS_ON,MS_OFF)) == -1) return(-1);
         break;
       case(STYLE):
       case(TYPE):
-        if((querymap->style = getSymbol(3, MS_NORMAL,MS_HILITE,MS_SELECTED)) == -1) return(-1);
+        if((querymap->style = getSymbol(lexer, 3, MS_NORMAL,MS_HILITE,MS_SELECTED)) == -1) return(-1);
         break;
       default:
-        if(strlen(msyystring_buffer) > 0) {
-          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadQueryMap()", msyystring_buffer, msyylineno);
+        if(strlen(lexer->string_buffer) > 0) {
+          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadQueryMap()", lexer->string_buffer, lexer->lineno);
           return(-1);
         } else {
           return(0); /* end of a string, not an error */
@@ -5489,26 +5564,26 @@ int loadQueryMap(queryMapObj *querymap)
 
 int msUpdateQueryMapFromString(queryMapObj *querymap, char *string, int url_string)
 {
+  lexerObj lexer;
+
   if(!querymap || !string) return MS_FAILURE;
 
-  msAcquireLock( TLOCK_PARSER );
+  if(msInitLexer(&lexer) != MS_SUCCESS) return MS_FAILURE;
 
   if(url_string)
-    msyystate = MS_TOKENIZE_URL_STRING;
+    lexer.state = MS_TOKENIZE_URL_STRING;
   else
-    msyystate = MS_TOKENIZE_STRING;
-  msyystring = string;
-  msyylex(); /* sets things up, but doesn't process any tokens */
+    lexer.state = MS_TOKENIZE_STRING;
+  lexer.string = string;
+  msyylex(lexer.scanner); /* sets things up, but doesn't process any tokens */
 
-  msyylineno = 1; /* start at line 1 */
+  lexer.lineno = 1; /* start at line 1 */
 
-  if(loadQueryMap(querymap) == -1) {
-    msReleaseLock( TLOCK_PARSER );
+  if(loadQueryMap(&lexer, querymap) == -1) {
+    msFreeLexer(&lexer);
     return MS_FAILURE; /* parse error */;
   }
-  msReleaseLock( TLOCK_PARSER );
-
-  msyylex_destroy();
+  msFreeLexer(&lexer);
   return MS_SUCCESS;
 }
 
@@ -5645,19 +5720,19 @@ char* msWriteWebToString(webObj *web)
   return (char*)buffer.data;
 }
 
-int loadWeb(webObj *web, mapObj *map)
+int loadWeb(lexerObj *lexer, webObj *web, mapObj *map)
 {
   web->map = (mapObj *)map;
 
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(BROWSEFORMAT): /* change to use validation in 6.0 */
         free(web->browseformat);
         web->browseformat = NULL; /* there is a default */
-        if(getString(&web->browseformat) == MS_FAILURE) return(-1);
+        if(getString(lexer, &web->browseformat) == MS_FAILURE) return(-1);
         break;
       case(EMPTY):
-        if(getString(&web->empty) == MS_FAILURE) return(-1);
+        if(getString(lexer, &web->empty) == MS_FAILURE) return(-1);
         break;
       case(WEB):
         break; /* for string loads */
@@ -5668,21 +5743,21 @@ int loadWeb(webObj *web, mapObj *map)
         return(0);
         break;
       case(ERROR):
-        if(getString(&web->error) == MS_FAILURE) return(-1);
+        if(getString(lexer, &web->error) == MS_FAILURE) return(-1);
         break;
       case(EXTENT):
-        if(getDouble(&(web->extent.minx)) == -1) return(-1);
-        if(getDouble(&(web->extent.miny)) == -1) return(-1);
-        if(getDouble(&(web->extent.maxx)) == -1) return(-1);
-        if(getDouble(&(web->extent.maxy)) == -1) return(-1);
+        if(getDouble(lexer, &(web->extent.minx)) == -1) return(-1);
+        if(getDouble(lexer, &(web->extent.miny)) == -1) return(-1);
+        if(getDouble(lexer, &(web->extent.maxx)) == -1) return(-1);
+        if(getDouble(lexer, &(web->extent.maxy)) == -1) return(-1);
         if (!MS_VALID_EXTENT(web->extent)) {
           msSetError(MS_MISCERR, "Given web extent is invalid. Check that it is in the form: minx, miny, maxx, maxy", "loadWeb()");
           return(-1);
         }
         break;
       case(FOOTER):
-        if(getString(&web->footer) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &web->footer) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(web->footer, msLookupHashTable(&(web->validation), "footer"), map->templatepattern, NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based FOOTER configuration failed pattern validation." , "loadWeb()");
             msFree(web->footer);
@@ -5692,8 +5767,8 @@ int loadWeb(webObj *web, mapObj *map)
         }
         break;
       case(HEADER):
-        if(getString(&web->header) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &web->header) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(web->header, msLookupHashTable(&(web->validation), "header"), map->templatepattern, NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based HEADER configuration failed pattern validation." , "loadWeb()");
             msFree(web->header);
@@ -5703,47 +5778,47 @@ int loadWeb(webObj *web, mapObj *map)
         }
         break;
       case(IMAGEPATH):
-        if(getString(&web->imagepath) == MS_FAILURE) return(-1);
+        if(getString(lexer, &web->imagepath) == MS_FAILURE) return(-1);
         break;
       case(TEMPPATH):
-        if(getString(&web->temppath) == MS_FAILURE) return(-1);
+        if(getString(lexer, &web->temppath) == MS_FAILURE) return(-1);
         break;
       case(IMAGEURL):
-        if(getString(&web->imageurl) == MS_FAILURE) return(-1);
+        if(getString(lexer, &web->imageurl) == MS_FAILURE) return(-1);
         break;
       case(LEGENDFORMAT): /* change to use validation in 6.0 */
         free(web->legendformat);
         web->legendformat = NULL; /* there is a default */
-        if(getString(&web->legendformat) == MS_FAILURE) return(-1);
+        if(getString(lexer, &web->legendformat) == MS_FAILURE) return(-1);
         break;
       case(LOG):
-        if(getString(&web->log) == MS_FAILURE) return(-1);
+        if(getString(lexer, &web->log) == MS_FAILURE) return(-1);
         break;
       case(MAXSCALE):
       case(MAXSCALEDENOM):
-        if(getDouble(&web->maxscaledenom) == -1) return(-1);
+        if(getDouble(lexer, &web->maxscaledenom) == -1) return(-1);
         break;
       case(MAXTEMPLATE):
-        if(getString(&web->maxtemplate) == MS_FAILURE) return(-1);
+        if(getString(lexer, &web->maxtemplate) == MS_FAILURE) return(-1);
         break;
       case(METADATA):
-        if(loadHashTable(&(web->metadata)) != MS_SUCCESS) return(-1);
+        if(loadHashTable(lexer, &(web->metadata)) != MS_SUCCESS) return(-1);
         break;
       case(MINSCALE):
       case(MINSCALEDENOM):
-        if(getDouble(&web->minscaledenom) == -1) return(-1);
+        if(getDouble(lexer, &web->minscaledenom) == -1) return(-1);
         break;
       case(MINTEMPLATE):
-        if(getString(&web->mintemplate) == MS_FAILURE) return(-1);
+        if(getString(lexer, &web->mintemplate) == MS_FAILURE) return(-1);
         break;
       case(QUERYFORMAT): /* change to use validation in 6.0 */
         free(web->queryformat);
         web->queryformat = NULL; /* there is a default */
-        if(getString(&web->queryformat) == MS_FAILURE) return(-1);
+        if(getString(lexer, &web->queryformat) == MS_FAILURE) return(-1);
         break;
       case(TEMPLATE):
-        if(getString(&web->template) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
-        if(msyysource == MS_URL_TOKENS) {
+        if(getString(lexer, &web->template) == MS_FAILURE) return(-1); /* getString() cleans up previously allocated string */
+        if(lexer->source == MS_URL_TOKENS) {
           if(msValidateParameter(web->template, msLookupHashTable(&(web->validation), "template"), map->templatepattern, NULL, NULL) != MS_SUCCESS) {
             msSetError(MS_MISCERR, "URL-based TEMPLATE configuration failed pattern validation." , "loadWeb()");
             msFree(web->template);
@@ -5753,11 +5828,11 @@ int loadWeb(webObj *web, mapObj *map)
         }
         break;
       case(VALIDATION):
-        if(loadHashTable(&(web->validation)) != MS_SUCCESS) return(-1);
+        if(loadHashTable(lexer, &(web->validation)) != MS_SUCCESS) return(-1);
         break;
       default:
-        if(strlen(msyystring_buffer) > 0) {
-          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadWeb()", msyystring_buffer, msyylineno);
+        if(strlen(lexer->string_buffer) > 0) {
+          msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadWeb()", lexer->string_buffer, lexer->lineno);
           return(-1);
         } else {
           return(0); /* end of a string, not an error */
@@ -5768,26 +5843,26 @@ int loadWeb(webObj *web, mapObj *map)
 
 int msUpdateWebFromString(webObj *web, char *string, int url_string)
 {
+  lexerObj lexer;
+
   if(!web || !string) return MS_FAILURE;
 
-  msAcquireLock( TLOCK_PARSER );
+  if(msInitLexer(&lexer) != MS_SUCCESS) return MS_FAILURE;
 
   if(url_string)
-    msyystate = MS_TOKENIZE_URL_STRING;
+    lexer.state = MS_TOKENIZE_URL_STRING;
   else
-    msyystate = MS_TOKENIZE_STRING;
-  msyystring = string;
-  msyylex(); /* sets things up, but doesn't process any tokens */
+    lexer.state = MS_TOKENIZE_STRING;
+  lexer.string = string;
+  msyylex(lexer.scanner); /* sets things up, but doesn't process any tokens */
 
-  msyylineno = 1; /* start at line 1 */
+  lexer.lineno = 1; /* start at line 1 */
 
-  if(loadWeb(web, web->map) == -1) {
-    msReleaseLock( TLOCK_PARSER );
+  if(loadWeb(&lexer, web, web->map) == -1) {
+    msFreeLexer(&lexer);
     return MS_FAILURE; /* parse error */;
   }
-  msReleaseLock( TLOCK_PARSER );
-
-  msyylex_destroy();
+  msFreeLexer(&lexer);
   return MS_SUCCESS;
 }
 
@@ -5811,6 +5886,7 @@ int initMap(mapObj *map)
   map->maxlayers = 0;
   map->layers = NULL;
   map->layerorder = NULL; /* used to modify the order in which the layers are drawn */
+  msInitNameIndex(&(map->layerindex));
 
   map->status = MS_ON;
   map->name = msStrdup("MS");
@@ -5830,6 +5906,8 @@ int initMap(mapObj *map)
   map->cellsize = 0;
   map->shapepath = NULL;
   map->mappath = NULL;
+  map->filename = NULL;
+  map->filemtime = map->filesize = 0;
 
   MS_INIT_COLOR(map->imagecolor, 255,255,255,255); /* white */
 
@@ -6006,6 +6084,7 @@ int msFreeLabelCache(labelCacheObj *cache)
     if (msFreeLabelCacheSlot(&(cache->slots[p])) != MS_SUCCESS)
       return MS_FAILURE;
   }
+  msFreeLabelCacheIndex(cache);
 
   cache->numlabels = 0;
 
@@ -6041,6 +6120,7 @@ int msInitLabelCache(labelCacheObj *cache)
     if (msInitLabelCacheSlot(&(cache->slots[p])) != MS_SUCCESS)
       return MS_FAILURE;
   }
+  msFreeLabelCacheIndex(cache); /* built by msDrawLabelCache() */
   cache->numlabels = 0;
   cache->gutter = 0;
 
@@ -6146,14 +6226,14 @@ int msSaveMap(mapObj *map, char *filename)
   return(0);
 }
 
-static int loadMapInternal(mapObj *map)
+static int loadMapInternal(lexerObj *lexer, mapObj *map)
 {
   int foundMapToken=MS_FALSE;
   int token;
 
   for(;;) {
 
-    token = msyylex();
+    token = msLexerNextToken(lexer);
 
     if(!foundMapToken && token != MAP) {
       msSetError(MS_IDENTERR, "First token must be MAP, this doesn't look like a mapfile.", "msLoadMap()");
@@ -6165,10 +6245,10 @@ static int loadMapInternal(mapObj *map)
       case(CONFIG): {
         char *key=NULL, *value=NULL;
 
-        if( getString(&key) == MS_FAILURE )
+        if( getString(lexer, &key) == MS_FAILURE )
           return MS_FAILURE;
 
-        if( getString(&value) == MS_FAILURE ) {
+        if( getString(lexer, &value) == MS_FAILURE ) {
           free(key);
           return MS_FAILURE;
         }
@@ -6185,18 +6265,13 @@ static int loadMapInternal(mapObj *map)
       break;
 
       case(DATAPATTERN):
-        if(getString(&map->datapattern) == MS_FAILURE) return MS_FAILURE;
+        if(getString(lexer, &map->datapattern) == MS_FAILURE) return MS_FAILURE;
         break;
       case(DEBUG):
-        if((map->debug = getSymbol(3, MS_ON,MS_OFF, MS_NUMBER)) == -1) return MS_FAILURE;
-        if(map->debug == MS_NUMBER) map->debug = (int) msyynumber;
+        if((map->debug = getSymbol(lexer, 3, MS_ON,MS_OFF, MS_NUMBER)) == -1) return MS_FAILURE;
+        if(map->debug == MS_NUMBER) map->debug = (int) lexer->number;
         break;
       case(END):
-        if(msyyin) {
-          fclose(msyyin);
-          msyyin = NULL;
-        }
-
         /*** Make config options current ***/
         msApplyMapConfigOptions( map );
 
@@ -6220,10 +6295,10 @@ static int loadMapInternal(mapObj *map)
         msSetError(MS_EOFERR, NULL, "msLoadMap()");
         return MS_FAILURE;
       case(EXTENT): {
-        if(getDouble(&(map->extent.minx)) == -1) return MS_FAILURE;
-        if(getDouble(&(map->extent.miny)) == -1) return MS_FAILURE;
-        if(getDouble(&(map->extent.maxx)) == -1) return MS_FAILURE;
-        if(getDouble(&(map->extent.maxy)) == -1) return MS_FAILURE;
+        if(getDouble(lexer, &(map->extent.minx)) == -1) return MS_FAILURE;
+        if(getDouble(lexer, &(map->extent.miny)) == -1) return MS_FAILURE;
+        if(getDouble(lexer, &(map->extent.maxx)) == -1) return MS_FAILURE;
+        if(getDouble(lexer, &(map->extent.maxy)) == -1) return MS_FAILURE;
         if (!MS_VALID_EXTENT(map->extent)) {
           msSetError(MS_MISCERR, "Given map extent is invalid. Check that it " \
                      "is in the form: minx, miny, maxx, maxy", "loadMapInternal()");
@@ -6233,112 +6308,116 @@ static int loadMapInternal(mapObj *map)
       break;
       case(ANGLE): {
         double rotation_angle;
-        if(getDouble(&(rotation_angle)) == -1) return MS_FAILURE;
+        if(getDouble(lexer, &(rotation_angle)) == -1) return MS_FAILURE;
         msMapSetRotation( map, rotation_angle );
       }
       break;
       case(TEMPLATEPATTERN):
-        if(getString(&map->templatepattern) == MS_FAILURE) return MS_FAILURE;
+        if(getString(lexer, &map->templatepattern) == MS_FAILURE) return MS_FAILURE;
         break;
       case(FONTSET):
-        if(getString(&map->fontset.filename) == MS_FAILURE) return MS_FAILURE;
+        if(getString(lexer, &map->fontset.filename) == MS_FAILURE) return MS_FAILURE;
         break;
       case(IMAGECOLOR):
-        if(loadColor(&(map->imagecolor), NULL) != MS_SUCCESS) return MS_FAILURE;
+        if(loadColor(lexer, &(map->imagecolor), NULL) != MS_SUCCESS) return MS_FAILURE;
         break;
       case(IMAGEQUALITY):
-        if(getInteger(&(map->imagequality)) == -1) return MS_FAILURE;
+        if(getInteger(lexer, &(map->imagequality)) == -1) return MS_FAILURE;
         break;
       case(IMAGETYPE):
-        map->imagetype = getToken();
+        map->imagetype = getToken(lexer);
         break;
       case(INTERLACE):
-        if((map->interlace = getSymbol(2, MS_ON,MS_OFF)) == -1) return MS_FAILURE;
+        if((map->interlace = getSymbol(lexer, 2, MS_ON,MS_OFF)) == -1) return MS_FAILURE;
         break;
       case(LATLON):
         msFreeProjection(&map->latlon);
-        if(loadProjection(&map->latlon) == -1) return MS_FAILURE;
+        if(loadProjection(lexer, &map->latlon) == -1) return MS_FAILURE;
         break;
       case(LAYER):
         if(msGrowMapLayers(map) == NULL)
           return MS_FAILURE;
         if(initLayer((GET_LAYER(map, map->numlayers)), map) == -1) return MS_FAILURE;
-        if(loadLayer((GET_LAYER(map, map->numlayers)), map) == -1) return MS_FAILURE;
-        GET_LAYER(map, map->numlayers)->index = map->numlayers; /* save the index */
+        if(lazyLayersEnabled(map)) {
+          if(loadLazyLayer(lexer, map->layers[map->numlayers]) == -1) return MS_FAILURE;
+        } else {
+          if(loadLayer(lexer, (GET_LAYER(map, map->numlayers)), map) == -1) return MS_FAILURE;
+        }
+        map->layers[map->numlayers]->index = map->numlayers; /* save the index */
         /* Update the layer order list with the layer's index. */
         map->layerorder[map->numlayers] = map->numlayers;
         map->numlayers++;
         break;
       case(OUTPUTFORMAT):
-        if(loadOutputFormat(map) == -1) return MS_FAILURE;
+        if(loadOutputFormat(lexer, map) == -1) return MS_FAILURE;
         break;
       case(LEGEND):
-        if(loadLegend(&(map->legend), map) == -1) return MS_FAILURE;
+        if(loadLegend(lexer, &(map->legend), map) == -1) return MS_FAILURE;
         break;
       case(MAP):
         foundMapToken = MS_TRUE;
         break;
       case(MAXSIZE):
-        if(getInteger(&(map->maxsize)) == -1) return MS_FAILURE;
+        if(getInteger(lexer, &(map->maxsize)) == -1) return MS_FAILURE;
         break;
       case(NAME):
         free(map->name);
         map->name = NULL; /* erase default */
-        if(getString(&map->name) == MS_FAILURE) return MS_FAILURE;
+        if(getString(lexer, &map->name) == MS_FAILURE) return MS_FAILURE;
         break;
       case(PROJECTION):
-        if(loadProjection(&map->projection) == -1) return MS_FAILURE;
+        if(loadProjection(lexer, &map->projection) == -1) return MS_FAILURE;
         break;
       case(QUERYMAP):
-        if(loadQueryMap(&(map->querymap)) == -1) return MS_FAILURE;
+        if(loadQueryMap(lexer, &(map->querymap)) == -1) return MS_FAILURE;
         break;
       case(REFERENCE):
-        if(loadReferenceMap(&(map->reference), map) == -1) return MS_FAILURE;
+        if(loadReferenceMap(lexer, &(map->reference), map) == -1) return MS_FAILURE;
         break;
       case(RESOLUTION):
-        if(getDouble(&(map->resolution)) == -1) return MS_FAILURE;
+        if(getDouble(lexer, &(map->resolution)) == -1) return MS_FAILURE;
         break;
       case(DEFRESOLUTION):
-        if(getDouble(&(map->defresolution)) == -1) return MS_FAILURE;
+        if(getDouble(lexer, &(map->defresolution)) == -1) return MS_FAILURE;
         break;
       case(SCALE):
       case(SCALEDENOM):
-        if(getDouble(&(map->scaledenom)) == -1) return MS_FAILURE;
+        if(getDouble(lexer, &(map->scaledenom)) == -1) return MS_FAILURE;
         break;
       case(SCALEBAR):
-        if(loadScalebar(&(map->scalebar)) == -1) return MS_FAILURE;
+        if(loadScalebar(lexer, &(map->scalebar)) == -1) return MS_FAILURE;
         break;
       case(SHAPEPATH):
-        if(getString(&map->shapepath) == MS_FAILURE) return MS_FAILURE;
+        if(getString(lexer, &map->shapepath) == MS_FAILURE) return MS_FAILURE;
         break;
       case(SIZE):
-        if(getInteger(&(map->width)) == -1) return MS_FAILURE;
-        if(getInteger(&(map->height)) == -1) return MS_FAILURE;
+        if(getInteger(lexer, &(map->width)) == -1) return MS_FAILURE;
+        if(getInteger(lexer, &(map->height)) == -1) return MS_FAILURE;
         break;
       case(STATUS):
-        if((map->status = getSymbol(2, MS_ON,MS_OFF)) == -1) return MS_FAILURE;
+        if((map->status = getSymbol(lexer, 2, MS_ON,MS_OFF)) == -1) return MS_FAILURE;
         break;
       case(SYMBOL):
         if(msGrowSymbolSet(&(map->symbolset)) == NULL)
           return MS_FAILURE;
-        if((loadSymbol(map->symbolset.symbol[map->symbolset.numsymbols], map->mappath) == -1)) return MS_FAILURE;
+        if((loadSymbol(lexer, map->symbolset.symbol[map->symbolset.numsymbols], map->mappath) == -1)) return MS_FAILURE;
         map->symbolset.symbol[map->symbolset.numsymbols]->inmapfile = MS_TRUE;
         map->symbolset.numsymbols++;
         break;
       case(SYMBOLSET):
-        if(getString(&map->symbolset.filename) == MS_FAILURE) return MS_FAILURE;
+        if(getString(lexer, &map->symbolset.filename) == MS_FAILURE) return MS_FAILURE;
         break;
       case(TRANSPARENT):
-        if((map->transparent = getSymbol(2, MS_ON,MS_OFF)) == -1) return MS_FAILURE;
+        if((map->transparent = getSymbol(lexer, 2, MS_ON,MS_OFF)) == -1) return MS_FAILURE;
         break;
       case(UNITS):
-        if((map->units = getSymbol(7, MS_INCHES,MS_FEET,MS_MILES,MS_METERS,MS_KILOMETERS,MS_NAUTICALMILES,MS_DD)) == -1) return MS_FAILURE;
+        if((map->units = getSymbol(lexer, 7, MS_INCHES,MS_FEET,MS_MILES,MS_METERS,MS_KILOMETERS,MS_NAUTICALMILES,MS_DD)) == -1) return MS_FAILURE;
         break;
       case(WEB):
-        if(loadWeb(&(map->web), map) == -1) return MS_FAILURE;
+        if(loadWeb(lexer, &(map->web), map) == -1) return MS_FAILURE;
         break;
       default:
-        msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "msLoadMap()", msyystring_buffer, msyylineno);
+        msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "msLoadMap()", lexer->string_buffer, lexer->lineno);
         return MS_FAILURE;
     }
   } /* next token */
@@ -6354,6 +6433,7 @@ mapObj *msLoadMapFromString(char *buffer, char *new_mappath)
   char szPath[MS_MAXPATHLEN], szCWDPath[MS_MAXPATHLEN];
   char *mappath=NULL;
   int debuglevel;
+  lexerObj lexer;
 
   debuglevel = (int)msGetGlobalDebugLevel();
 
@@ -6378,19 +6458,23 @@ mapObj *msLoadMapFromString(char *buffer, char *new_mappath)
     return(NULL);
   }
 
-  msAcquireLock( TLOCK_PARSER ); /* might need to move this lock a bit higher, yup (bug 2108) */
+  if(msInitLexer(&lexer) != MS_SUCCESS) {
+    msFreeMap(map);
+    return(NULL);
+  }
 
-  msyystate = MS_TOKENIZE_STRING;
-  msyystring = buffer;
-  msyylex(); /* sets things up, but doesn't process any tokens */
+  lexer.state = MS_TOKENIZE_STRING;
+  lexer.string = buffer;
+  msyylex(lexer.scanner); /* sets things up, but doesn't process any tokens */
 
-  msyylineno = 1; /* start at line 1 (do lines mean anything here?) */
+  lexer.lineno = 1; /* start at line 1 (do lines mean anything here?) */
 
   /* If new_mappath is provided then use it, otherwise use the CWD */
   if(NULL == getcwd(szCWDPath, MS_MAXPATHLEN)) {
     msSetError(MS_MISCERR, "getcwd() returned a too long path", "msLoadMapFromString()");
     msFreeMap(map);
-    msReleaseLock( TLOCK_PARSER );
+    msFreeLexer(&lexer);
+    return(NULL);
   }
   if (new_mappath) {
     mappath = msStrdup(new_mappath);
@@ -6398,19 +6482,17 @@ mapObj *msLoadMapFromString(char *buffer, char *new_mappath)
   } else
     map->mappath = msStrdup(szCWDPath);
 
-  msyybasepath = map->mappath; /* for INCLUDEs */
+  lexer.basepath = map->mappath; /* for INCLUDEs */
 
-  if(loadMapInternal(map) != MS_SUCCESS) {
+  if(loadMapInternal(&lexer, map) != MS_SUCCESS) {
     msFreeMap(map);
-    msReleaseLock( TLOCK_PARSER );
+    msFreeLexer(&lexer);
     if(mappath != NULL) free(mappath);
     return NULL;
   }
 
   if (mappath != NULL) free(mappath);
-  msyylex_destroy();
-
-  msReleaseLock( TLOCK_PARSER );
+  msFreeLexer(&lexer);
 
   if (debuglevel >= MS_DEBUGLEVEL_TUNING) {
     /* In debug mode, report time spent loading/parsing mapfile. */
@@ -6425,6 +6507,309 @@ mapObj *msLoadMapFromString(char *buffer, char *new_mappath)
   return map;
 }
 
+/*
+** Compiled mapfiles (see msCompileMap()) start with MS_COMPILED_MAP_MAGIC,
+** which no text mapfile does, followed by the format version, a byte order
+** check and the MapServer version they were written by, as native ints.
+** Then come the token records: token, line number and string length (ints),
+** a double for MS_NUMBERs, and the nul terminated string.
+*/
+#define MS_COMPILED_MAP_MAGIC "\211MSMAPC\n"
+#define MS_COMPILED_MAP_MAGIC_SIZE 8
+#define MS_COMPILED_MAP_VERSION 1
+#define MS_COMPILED_MAP_BYTEORDER 0x01020304
+#define MS_COMPILED_MAP_HEADER_SIZE (MS_COMPILED_MAP_MAGIC_SIZE + 3*sizeof(int))
+
+/*
+** Reads the token records of filename into lexer if mapfile, just opened,
+** is a compiled mapfile. msLexerNextToken() then returns them instead of
+** scanning.
+** Returns MS_DONE, with mapfile rewound, for a text mapfile.
+*/
+static int loadCompiledTokens(lexerObj *lexer, FILE *mapfile, char *filename)
+{
+  char magic[MS_COMPILED_MAP_MAGIC_SIZE], *p, *end;
+  int header[3], token, length;
+  long size;
+  FILE *fp;
+
+  if(fread(magic, 1, MS_COMPILED_MAP_MAGIC_SIZE, mapfile) != MS_COMPILED_MAP_MAGIC_SIZE ||
+      memcmp(magic, MS_COMPILED_MAP_MAGIC, MS_COMPILED_MAP_MAGIC_SIZE) != 0) {
+    rewind(mapfile);
+    return MS_DONE;
+  }
+
+  /* mapfile is open in text mode, read the records again in binary */
+  if((fp = fopen(filename, "rb")) == NULL || fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < (long) MS_COMPILED_MAP_HEADER_SIZE) {
+    msSetError(MS_IOERR, "Failed to read compiled mapfile (%s).", "msLoadMap()", filename);
+    if(fp) fclose(fp);
+    return MS_FAILURE;
+  }
+  lexer->compiled = (char *) msSmallMalloc(size);
+  rewind(fp);
+  if(fread(lexer->compiled, 1, size, fp) != (size_t) size) {
+    msSetError(MS_IOERR, "Failed to read compiled mapfile (%s).", "msLoadMap()", filename);
+    fclose(fp);
+    return MS_FAILURE;
+  }
+  fclose(fp);
+
+  memcpy(header, lexer->compiled + MS_COMPILED_MAP_MAGIC_SIZE, sizeof(header));
+  if(header[0] != MS_COMPILED_MAP_VERSION || header[1] != MS_COMPILED_MAP_BYTEORDER || header[2] != MS_VERSION_NUM) {
+    msSetError(MS_MISCERR, "Compiled mapfile (%s) was written by another MapServer version or platform, compile it again with mapcompile.", "msLoadMap()", filename);
+    return MS_FAILURE;
+  }
+
+  /* check the records once so msLexerNextCompiledToken() can trust them */
+  p = lexer->compiled + MS_COMPILED_MAP_HEADER_SIZE;
+  end = lexer->compiled + size;
+  while(p < end) {
+    if(end - p < (long) (3*sizeof(int))) break;
+    memcpy(&token, p, sizeof(int));
+    memcpy(&length, p + 2*sizeof(int), sizeof(int));
+    p += 3*sizeof(int) + ((token == MS_NUMBER) ? sizeof(double) : 0);
+    if(length < 0 || end - p < (long) length + 1 || p[length] != '\0') break;
+    p += length + 1;
+  }
+  if(p != end) {
+    msSetError(MS_MISCERR, "Compiled mapfile (%s) is corrupt.", "msLoadMap()", filename);
+    return MS_FAILURE;
+  }
+
+  lexer->compiled_ptr = lexer->compiled + MS_COMPILED_MAP_HEADER_SIZE;
+  lexer->compiled_end = end;
+
+  return MS_SUCCESS;
+}
+
+/*
+** Returns the next token of a compiled mapfile, its string, number and line
+** number set as if it had just been scanned. Like the scanner, strings
+** compiled as MS_ISTRING are case insensitive only when asked for
+** (string_icase), plain MS_STRING otherwise.
+*/
+static int msLexerNextCompiledToken(lexerObj *lexer)
+{
+  int token, length;
+
+  if(lexer->compiled_ptr >= lexer->compiled_end)
+    return(EOF);
+
+  memcpy(&token, lexer->compiled_ptr, sizeof(int));
+  memcpy(&lexer->lineno, lexer->compiled_ptr + sizeof(int), sizeof(int));
+  memcpy(&length, lexer->compiled_ptr + 2*sizeof(int), sizeof(int));
+  lexer->compiled_ptr += 3*sizeof(int);
+
+  if(token == MS_NUMBER) {
+    memcpy(&lexer->number, lexer->compiled_ptr, sizeof(double));
+    lexer->compiled_ptr += sizeof(double);
+  }
+
+  if(!lexer->string_buffer || length >= lexer->string_buffer_size) {
+    lexer->string_buffer_size = MS_MAX(lexer->string_buffer_size*2, length+1);
+    lexer->string_buffer = (char *) msSmallRealloc(lexer->string_buffer, lexer->string_buffer_size);
+  }
+  memcpy(lexer->string_buffer, lexer->compiled_ptr, length+1);
+  lexer->compiled_ptr += length+1;
+
+  if(token == MS_ISTRING) {
+    if(lexer->string_icase)
+      lexer->string_icase = MS_FALSE;
+    else
+      token = MS_STRING;
+  }
+
+  return(token);
+}
+
+/*
+** Returns the next token of a mapfile: replayed from its token records when
+** lexer holds a compiled mapfile or lazy layer, scanned by msyylex()
+** otherwise. Mapfile parsing goes through here rather than msyylex() so
+** maplexer.c stays as flex generates it.
+*/
+int msLexerNextToken(lexerObj *lexer)
+{
+  if(lexer->compiled && lexer->state == MS_TOKENIZE_DEFAULT)
+    return(msLexerNextCompiledToken(lexer));
+
+  return(msyylex(lexer->scanner));
+}
+
+/*
+** Appends the token lexer just returned to buffer as a compiled token record.
+*/
+static void writeCompiledToken(msIOBuffer *buffer, lexerObj *lexer, int token)
+{
+  int length = strlen(lexer->string_buffer);
+
+  msIO_bufferWrite(buffer, &token, sizeof(int));
+  msIO_bufferWrite(buffer, &lexer->lineno, sizeof(int));
+  msIO_bufferWrite(buffer, &length, sizeof(int));
+  if(token == MS_NUMBER)
+    msIO_bufferWrite(buffer, &lexer->number, sizeof(double));
+  msIO_bufferWrite(buffer, lexer->string_buffer, length+1);
+}
+
+/*
+** Lazy layers are turned on with MS_LAZY_LAYERS=ON, in the environment or as
+** a CONFIG option set before the first LAYER. Each LAYER block is then only
+** scanned at load time: its NAME, GROUP, STATUS, REQUIRES, LABELREQUIRES
+** and METADATA are read, enough to select layers and answer most OWS
+** checks, and the other tokens are kept as compiled token records. The
+** layer is parsed from those by msLoadLazyLayer() when first used through
+** GET_LAYER(), so errors in it only show up then.
+*/
+static int lazyLayersEnabled(mapObj *map)
+{
+  const char *value = getenv("MS_LAZY_LAYERS");
+  int enabled = value && (strcasecmp(value, "ON") == 0 || strcasecmp(value, "YES") == 0 || strcasecmp(value, "TRUE") == 0);
+
+  return msTestConfigOption(map, "MS_LAZY_LAYERS", enabled);
+}
+
+static int loadLazyLayer(lexerObj *lexer, layerObj *layer)
+{
+  msIOBuffer buffer = {NULL, 0, 0};
+  int token, depth = 1;
+
+  while(depth > 0) {
+    lexer->string_icase = MS_TRUE; /* as msCompileMap() */
+    token = msLexerNextToken(lexer);
+    lexer->string_icase = MS_FALSE;
+
+    if(depth == 1) {
+      int status = MS_DONE;
+
+      switch(token) {
+        case(GROUP):
+          status = getString(lexer, &layer->group);
+          break;
+        case(LABELREQUIRES):
+          status = getString(lexer, &layer->labelrequires);
+          break;
+        case(METADATA):
+          status = loadHashTable(lexer, &(layer->metadata));
+          break;
+        case(NAME):
+          status = getString(lexer, &layer->name);
+          break;
+        case(REQUIRES):
+          status = getString(lexer, &layer->requires);
+          break;
+        case(STATUS):
+          status = ((layer->status = getSymbol(lexer, 3, MS_ON,MS_OFF,MS_DEFAULT)) == -1) ? MS_FAILURE : MS_SUCCESS;
+          break;
+      }
+      if(status == MS_FAILURE) {
+        msFree(buffer.data);
+        return(-1);
+      }
+      if(status == MS_SUCCESS) continue; /* read, not recorded */
+    }
+
+    switch(token) {
+      case(EOF):
+        msSetError(MS_EOFERR, NULL, "loadLayer()");
+        msFree(buffer.data);
+        return(-1);
+      case(BINDVALS): /* same value as MS_EXPRESSION */
+        if(strcasecmp(lexer->string_buffer, "BINDVALS") == 0)
+          depth++;
+        break;
+      case(CLASS):
+      case(CLUSTER):
+      case(FEATURE):
+      case(GRID):
+      case(JOIN):
+      case(LABEL):
+      case(LEADER):
+      case(METADATA):
+      case(PATTERN):
+      case(POINTS):
+      case(PROJECTION):
+      case(SCALETOKEN):
+      case(STYLE):
+      case(VALIDATION):
+      case(VALUES):
+        depth++;
+        break;
+      case(END):
+        depth--;
+        break;
+    }
+
+    writeCompiledToken(&buffer, lexer, token);
+  }
+
+  layer->lazy = (char *) msSmallRealloc(buffer.data, buffer.data_offset);
+  layer->lazysize = buffer.data_offset;
+
+  return(0);
+}
+
+/*
+** Loads the rest of a lazy layer, in place, from the tokens recorded at load
+** time. The layer keeps what was set on it since. Used by GET_LAYER(), so
+** it can't fail: a layer that doesn't parse is reported and turned OFF.
+*/
+layerObj *msLoadLazyLayer(layerObj *layer)
+{
+  lexerObj lexer;
+  int i;
+
+  if(!layer->lazy)
+    return layer;
+
+  if(layer->map->debug >= MS_DEBUGLEVEL_V) /* layer DEBUG is not read yet */
+    msDebug("msLoadLazyLayer(): parsing layer %s.\n", layer->name ? layer->name : "(null)");
+
+  if(msInitLexer(&lexer) != MS_SUCCESS) {
+    layer->status = MS_OFF;
+    return layer;
+  }
+
+  /* the records are freed with the lexer */
+  lexer.source = MS_FILE_TOKENS;
+  lexer.compiled = lexer.compiled_ptr = layer->lazy;
+  lexer.compiled_end = layer->lazy + layer->lazysize;
+  layer->lazy = NULL;
+  layer->lazysize = 0;
+
+  if(loadLayer(&lexer, layer, layer->map) == -1) {
+    msSetError(MS_MISCERR, "Failed to parse layer %s, turning it off.", "msLoadLazyLayer()", layer->name ? layer->name : "(null)");
+    layer->status = MS_OFF;
+  } else {
+    for(i=0; i<layer->numclasses; i++)
+      classResolveSymbolNames(layer->class[i]);
+  }
+
+  msFreeLexer(&lexer);
+  msFree(lexer.compiled);
+
+  return layer;
+}
+
+/*
+** True if one of the strings recorded for a lazy layer contains tag, ignoring
+** case, so substitutions only parse the layers they change.
+*/
+static int lazyLayerContains(layerObj *layer, const char *tag)
+{
+  char *p = layer->lazy, *end = layer->lazy + layer->lazysize;
+  int token, length;
+
+  while(p < end) {
+    memcpy(&token, p, sizeof(int));
+    memcpy(&length, p + 2*sizeof(int), sizeof(int));
+    p += 3*sizeof(int) + ((token == MS_NUMBER) ? sizeof(double) : 0);
+    if(strcasestr(p, tag)) return MS_TRUE;
+    p += length + 1;
+  }
+
+  return MS_FALSE;
+}
+
 /*
 ** Sets up file-based mapfile loading and calls loadMapInternal to do the work.
 */
@@ -6433,7 +6818,10 @@ mapObj *msLoadMap(char *filename, char *new_mappath)
   mapObj *map;
   struct mstimeval starttime, endtime;
   char szPath[MS_MAXPATHLEN], szCWDPath[MS_MAXPATHLEN];
-  int debuglevel;
+  int debuglevel, status;
+  FILE *mapfile;
+  lexerObj lexer;
+  struct stat sb;
 
   debuglevel = (int)msGetGlobalDebugLevel();
 
@@ -6470,47 +6858,70 @@ mapObj *msLoadMap(char *filename, char *new_mappath)
     return(NULL);
   }
 
-  msAcquireLock( TLOCK_PARSER );  /* Steve: might need to move this lock a bit higher; Umberto: done */
-
 #ifdef USE_XMLMAPFILE
   /* If the mapfile is an xml mapfile, transform it */
   if ((getenv("MS_XMLMAPFILE_XSLT")) &&
       (msEvalRegex(MS_DEFAULT_XMLMAPFILE_PATTERN, filename) == MS_TRUE)) {
 
-    msyyin = tmpfile();
-    if (msyyin == NULL) {
+    mapfile = tmpfile();
+    if (mapfile == NULL) {
       msSetError(MS_IOERR, "tmpfile() failed to create temporary file", "msLoadMap()");
-      msReleaseLock( TLOCK_PARSER );
+      msFreeMap(map);
+      return NULL;
     }
 
-    if (msTransformXmlMapfile(getenv("MS_XMLMAPFILE_XSLT"), filename, msyyin) != MS_SUCCESS) {
-      fclose(msyyin);
+    if (msTransformXmlMapfile(getenv("MS_XMLMAPFILE_XSLT"), filename, mapfile) != MS_SUCCESS) {
+      fclose(mapfile);
+      msFreeMap(map);
       return NULL;
     }
-    fseek ( msyyin , 0 , SEEK_SET );
+    fseek ( mapfile , 0 , SEEK_SET );
   } else {
 #endif
-    if((msyyin = fopen(filename,"r")) == NULL) {
+    if((mapfile = fopen(filename,"r")) == NULL) {
       msSetError(MS_IOERR, "(%s)", "msLoadMap()", filename);
-      msReleaseLock( TLOCK_PARSER );
+      msFreeMap(map);
       return NULL;
     }
+    if(fstat(fileno(mapfile), &sb) == 0) { /* identifies this version of the file */
+      map->filename = msStrdup(filename);
+      map->filemtime = (long) sb.st_mtime;
+      map->filesize = (long) sb.st_size;
+    }
 #ifdef USE_XMLMAPFILE
   }
 #endif
 
-  msyystate = MS_TOKENIZE_FILE;
-  msyylex(); /* sets things up, but doesn't process any tokens */
+  if(msInitLexer(&lexer) != MS_SUCCESS) {
+    fclose(mapfile);
+    msFreeMap(map);
+    return NULL;
+  }
+
+  lexer.state = MS_TOKENIZE_FILE;
+  msyylex(lexer.scanner); /* sets things up, but doesn't process any tokens */
 
-  msyyrestart(msyyin); /* start at line begining, line 1 */
-  msyylineno = 1;
+  status = loadCompiledTokens(&lexer, mapfile, filename);
+  if(status == MS_FAILURE) {
+    msFreeMap(map);
+    fclose(mapfile);
+    msFreeLexer(&lexer);
+    msFree(lexer.compiled);
+    return NULL;
+  }
+  if(status == MS_DONE)
+    msyyrestart(mapfile, lexer.scanner); /* start at line begining, line 1 */
+  lexer.lineno = 1;
 
   /* If new_mappath is provided then use it, otherwise use the location */
   /* of the mapfile as the default path */
   if(NULL == getcwd(szCWDPath, MS_MAXPATHLEN)) {
     msSetError(MS_MISCERR, "getcwd() returned a too long path", "msLoadMap()");
     msFreeMap(map);
-    msReleaseLock( TLOCK_PARSER );
+    fclose(mapfile);
+    msFreeLexer(&lexer);
+    msFree(lexer.compiled);
+    return NULL;
   }
 
   if (new_mappath)
@@ -6521,18 +6932,18 @@ mapObj *msLoadMap(char *filename, char *new_mappath)
     if( path ) free( path );
   }
 
-  msyybasepath = map->mappath; /* for INCLUDEs */
+  lexer.basepath = map->mappath; /* for INCLUDEs */
 
-  if(loadMapInternal(map) != MS_SUCCESS) {
+  if(loadMapInternal(&lexer, map) != MS_SUCCESS) {
     msFreeMap(map);
-    msReleaseLock( TLOCK_PARSER );
-    if( msyyin ) {
-      fclose(msyyin);
-      msyyin = NULL;
-    }
+    msFreeLexer(&lexer);
+    msFree(lexer.compiled);
+    fclose(mapfile);
     return NULL;
   }
-  msReleaseLock( TLOCK_PARSER );
+  msFreeLexer(&lexer);
+  msFree(lexer.compiled);
+  fclose(mapfile);
 
   if (debuglevel >= MS_DEBUGLEVEL_TUNING) {
     /* In debug mode, report time spent loading/parsing mapfile. */
@@ -6546,47 +6957,282 @@ mapObj *msLoadMap(char *filename, char *new_mappath)
 }
 
 /*
-** Loads mapfile snippets via a URL (only via the CGI so don't worry about thread locks)
+** Parsed mapfiles kept across requests by msLoadMapCached(), most recently
+** used first. The MS_MAPFILE_CACHE_SIZE environment variable sets how many
+** are kept, the default of 0 disables the cache. A mapfile is parsed again when its modification
+** time or size change (INCLUDEd files are not checked).
 */
-int msUpdateMapFromURL(mapObj *map, char *variable, char *string)
+typedef struct mapCacheEntryObj {
+  char *filename;
+  char *mappath; /* new_mappath the map was loaded with */
+  time_t mtime;
+  long filesize;
+  mapObj *map; /* never handed out, callers get copies */
+  int refcount; /* the list holds one, each copy in progress another */
+  struct mapCacheEntryObj *next;
+} mapCacheEntryObj;
+
+static mapCacheEntryObj *mapCacheHead = NULL;
+static int mapCacheMaxCount = 0;
+static int mapCacheConfigured = MS_FALSE;
+
+static int mapCacheGetMaxCount(void)
+{
+  int maxcount;
+
+  msAcquireLock(TLOCK_MAPCACHE);
+  if(!mapCacheConfigured) {
+    const char *value = getenv("MS_MAPFILE_CACHE_SIZE");
+    mapCacheMaxCount = value ? MS_MAX(atoi(value), 0) : 0;
+    mapCacheConfigured = MS_TRUE;
+  }
+  maxcount = mapCacheMaxCount;
+  msReleaseLock(TLOCK_MAPCACHE);
+
+  return maxcount;
+}
+
+static int mapCacheMatch(mapCacheEntryObj *entry, const char *filename, const char *mappath)
+{
+  if(strcmp(entry->filename, filename) != 0)
+    return MS_FALSE;
+  if(entry->mappath == NULL || mappath == NULL)
+    return entry->mappath == mappath;
+  return strcmp(entry->mappath, mappath) == 0;
+}
+
+static void mapCacheFreeList(mapCacheEntryObj *entry)
+{
+  mapCacheEntryObj *next;
+
+  for( ; entry; entry=next) {
+    next = entry->next;
+    msFreeMap(entry->map);
+    msFree(entry->filename);
+    msFree(entry->mappath);
+    free(entry);
+  }
+}
+
+/*
+** Unlinks the entries past the maximum count, or any entry matching
+** filename/mappath, returns those no copy is being made from. The others are
+** freed by mapCacheRelease() when their copy is done.
+*/
+static mapCacheEntryObj *mapCacheUnlink(const char *filename, const char *mappath, int maxcount)
+{
+  mapCacheEntryObj **link = &mapCacheHead, *entry, *unlinked = NULL;
+  int count = 0;
+
+  while((entry = *link) != NULL) {
+    if((filename && mapCacheMatch(entry, filename, mappath)) || (!filename && count >= maxcount)) {
+      *link = entry->next;
+      if(--entry->refcount == 0) {
+        entry->next = unlinked;
+        unlinked = entry;
+      }
+    } else {
+      link = &entry->next;
+      count++;
+    }
+  }
+
+  return unlinked;
+}
+
+/* drops the reference taken to copy entry->map, frees entry if it was unlinked meanwhile */
+static void mapCacheRelease(mapCacheEntryObj *entry)
+{
+  int refcount;
+
+  msAcquireLock(TLOCK_MAPCACHE);
+  refcount = --entry->refcount;
+  msReleaseLock(TLOCK_MAPCACHE);
+
+  if(refcount == 0) {
+    entry->next = NULL;
+    mapCacheFreeList(entry);
+  }
+}
+
+static mapObj *mapCacheCopy(mapObj *src)
+{
+  mapObj *map;
+
+  map = msNewMapObj();
+  if(!map)
+    return NULL;
+
+  if(msCopyMap(map, src) != MS_SUCCESS) {
+    msFreeMap(map);
+    return NULL;
+  }
+
+  return map;
+}
+
+/*
+** Same as msLoadMap(), from a copy of the map parsed by an earlier call
+** when the mapfile is cached (see above). The copy belongs to the caller,
+** changes made to it don't affect later calls.
+*/
+mapObj *msLoadMapCached(char *filename, char *new_mappath)
+{
+  mapCacheEntryObj *entry, *evicted;
+  struct mstimeval starttime, endtime;
+  struct stat sb;
+  mapObj *map = NULL, *template;
+  int debuglevel;
+
+  if(!filename || mapCacheGetMaxCount() == 0 || stat(filename, &sb) != 0)
+    return msLoadMap(filename, new_mappath);
+
+  debuglevel = (int)msGetGlobalDebugLevel();
+  if (debuglevel >= MS_DEBUGLEVEL_TUNING)
+    msGettimeofday(&starttime, NULL);
+
+  msAcquireLock(TLOCK_MAPCACHE);
+  for(entry=mapCacheHead; entry; entry=entry->next) {
+    if(mapCacheMatch(entry, filename, new_mappath))
+      break;
+  }
+  if(entry && (entry->mtime != sb.st_mtime || entry->filesize != (long) sb.st_size))
+    entry = NULL;
+  if(entry) {
+    entry->refcount++; /* cached maps are only read, copy it out of the lock */
+    if(entry != mapCacheHead) { /* most recently used first */
+      mapCacheEntryObj *previous = mapCacheHead;
+      while(previous->next != entry)
+        previous = previous->next;
+      previous->next = entry->next;
+      entry->next = mapCacheHead;
+      mapCacheHead = entry;
+    }
+  }
+  msReleaseLock(TLOCK_MAPCACHE);
+
+  if(entry) {
+    map = mapCacheCopy(entry->map);
+    mapCacheRelease(entry);
+  }
+
+  if(map) {
+    msApplyMapConfigOptions(map);
+
+    if (debuglevel >= MS_DEBUGLEVEL_TUNING) {
+      msGettimeofday(&endtime, NULL);
+      msDebug("msLoadMapCached(): copy of %s, %.3fs\n", filename,
+              (endtime.tv_sec+endtime.tv_usec/1.0e6)-
+              (starttime.tv_sec+starttime.tv_usec/1.0e6) );
+    }
+    return map;
+  }
+
+  /* -------------------------------------------------------------------- */
+  /*      Not cached, or changed on disk: parse it and keep it.           */
+  /* -------------------------------------------------------------------- */
+  template = msLoadMap(filename, new_mappath);
+  if(!template)
+    return NULL;
+
+  map = mapCacheCopy(template);
+  if(!map)
+    return template; /* not cached then */
+
+  entry = (mapCacheEntryObj *) msSmallMalloc(sizeof(mapCacheEntryObj));
+  entry->filename = msStrdup(filename);
+  entry->mappath = new_mappath ? msStrdup(new_mappath) : NULL;
+  entry->mtime = sb.st_mtime;
+  entry->filesize = (long) sb.st_size;
+  entry->map = template;
+  entry->refcount = 1;
+
+  msAcquireLock(TLOCK_MAPCACHE);
+  evicted = mapCacheUnlink(filename, new_mappath, 0);
+  entry->next = mapCacheHead;
+  mapCacheHead = entry;
+  entry = mapCacheUnlink(NULL, NULL, mapCacheMaxCount);
+  msReleaseLock(TLOCK_MAPCACHE);
+
+  mapCacheFreeList(evicted);
+  mapCacheFreeList(entry);
+
+  return map;
+}
+
+/*
+** Set the number of parsed mapfiles kept by msLoadMapCached(), "0"
+** disables the cache and frees everything it holds. For programs embedding
+** MapServer, this overrides MS_MAPFILE_CACHE_SIZE.
+*/
+void msSetMapCacheSize(const char *value)
+{
+  mapCacheEntryObj *evicted;
+
+  msAcquireLock(TLOCK_MAPCACHE);
+  mapCacheMaxCount = value ? MS_MAX(atoi(value), 0) : 0;
+  mapCacheConfigured = MS_TRUE;
+  evicted = mapCacheUnlink(NULL, NULL, mapCacheMaxCount);
+  msReleaseLock(TLOCK_MAPCACHE);
+
+  mapCacheFreeList(evicted);
+}
+
+void msMapCacheCleanup(void)
+{
+  mapCacheEntryObj *evicted;
+
+  msAcquireLock(TLOCK_MAPCACHE);
+  evicted = mapCacheHead;
+  mapCacheHead = NULL;
+  mapCacheConfigured = MS_FALSE;
+  msReleaseLock(TLOCK_MAPCACHE);
+
+  mapCacheFreeList(evicted);
+}
+
+/*
+** Loads mapfile snippets via a URL (only via the CGI).
+*/
+static int updateMapFromURL(lexerObj *lexer, mapObj *map, char *variable, char *string)
 {
   int i, j, k, s;
   errorObj *ms_error;
 
-  /* make sure this configuration can be modified */
-  if(msLookupHashTable(&(map->web.validation), "immutable"))
-    return(MS_SUCCESS); /* fail silently */
-
-  msyystate = MS_TOKENIZE_URL_VARIABLE; /* set lexer state and input to tokenize */
-  msyystring = variable;
-  msyylineno = 1;
+  lexer->state = MS_TOKENIZE_URL_VARIABLE; /* set lexer state and input to tokenize */
+  lexer->string = variable;
+  lexer->lineno = 1;
 
   ms_error = msGetErrorObj();
   ms_error->code = MS_NOERR; /* init error code */
 
-  switch(msyylex()) {
+  switch(msLexerNextToken(lexer)) {
     case(MAP):
-      switch(msyylex()) {
+      switch(msLexerNextToken(lexer)) {
         case(CONFIG): {
           char *key=NULL, *value=NULL;
-          if((getString(&key) != MS_FAILURE) && (getString(&value) != MS_FAILURE)) {
-            msSetConfigOption( map, key, value );
-            free( key );
-            key=NULL;
-            free( value );
-            value=NULL;
+          if((getString(lexer, &key) != MS_FAILURE) && (getString(lexer, &value) != MS_FAILURE)) {
+            /* files are written there, only the mapfile or the environment may name it */
+            if(strcasecmp(key, "MS_CAPABILITIES_CACHE_DIR") == 0)
+              msSetError(MS_WEBERR, "CONFIG %s cannot be set from a URL.", "msUpdateMapFromURL()", key);
+            else
+              msSetConfigOption( map, key, value );
           }
+          free( key );
+          key=NULL;
+          free( value );
+          value=NULL;
         }
         break;
         case(EXTENT):
-          msyystate = MS_TOKENIZE_URL_STRING;
-          msyystring = string;
-          msyylex();
-
-          if(getDouble(&(map->extent.minx)) == -1) break;
-          if(getDouble(&(map->extent.miny)) == -1) break;
-          if(getDouble(&(map->extent.maxx)) == -1) break;
-          if(getDouble(&(map->extent.maxy)) == -1) break;
+          lexer->state = MS_TOKENIZE_URL_STRING;
+          lexer->string = string;
+          msLexerNextToken(lexer);
+
+          if(getDouble(lexer, &(map->extent.minx)) == -1) break;
+          if(getDouble(lexer, &(map->extent.miny)) == -1) break;
+          if(getDouble(lexer, &(map->extent.maxx)) == -1) break;
+          if(getDouble(lexer, &(map->extent.maxy)) == -1) break;
           if (!MS_VALID_EXTENT(map->extent)) {
             msSetError(MS_MISCERR, "Given map extent is invalid. Check that it is in the form: minx, miny, maxx, maxy", "msLoadMapParameterFromUrl()");
             break;
@@ -6595,39 +7241,39 @@ int msUpdateMapFromURL(mapObj *map, char *variable, char *string)
           break;
         case(ANGLE): {
           double rotation_angle;
-          msyystate = MS_TOKENIZE_URL_STRING;
-          msyystring = string;
-          msyylex();
+          lexer->state = MS_TOKENIZE_URL_STRING;
+          lexer->string = string;
+          msLexerNextToken(lexer);
 
-          if(getDouble(&(rotation_angle)) == -1) break;
+          if(getDouble(lexer, &(rotation_angle)) == -1) break;
           msMapSetRotation( map, rotation_angle );
         }
         break;
         case(IMAGECOLOR):
-          msyystate = MS_TOKENIZE_URL_STRING;
-          msyystring = string;
-          msyylex();
+          lexer->state = MS_TOKENIZE_URL_STRING;
+          lexer->string = string;
+          msLexerNextToken(lexer);
 
-          if(loadColor(&(map->imagecolor), NULL) != MS_SUCCESS) break;
+          if(loadColor(lexer, &(map->imagecolor), NULL) != MS_SUCCESS) break;
           break;
         case(IMAGETYPE):
-          msyystate = MS_TOKENIZE_URL_STRING;
-          msyystring = string;
-          msyylex();
+          lexer->state = MS_TOKENIZE_URL_STRING;
+          lexer->string = string;
+          msLexerNextToken(lexer);
 
           /* TODO: should validate or does msPostMapParseOutputFormatSetup() do enough? */
 
-          map->imagetype = getToken();
+          map->imagetype = getToken(lexer);
           msPostMapParseOutputFormatSetup( map );
           break;
         case(LAYER):
-          if((s = getSymbol(2, MS_NUMBER, MS_STRING)) == -1) {
+          if((s = getSymbol(lexer, 2, MS_NUMBER, MS_STRING)) == -1) {
             return MS_FAILURE;
           }
           if(s == MS_STRING)
-            i = msGetLayerIndex(map, msyystring_buffer);
+            i = msGetLayerIndex(map, lexer->string_buffer);
           else
-            i = (int) msyynumber;
+            i = (int) lexer->number;
 
           if(i>=map->numlayers || i<0) {
             msSetError(MS_MISCERR, "Layer to be modified not valid.", "msUpdateMapFromURL()");
@@ -6638,12 +7284,12 @@ int msUpdateMapFromURL(mapObj *map, char *variable, char *string)
           if(msLookupHashTable(&(GET_LAYER(map, i)->validation), "immutable"))
             return(MS_SUCCESS); /* fail silently */
 
-          if(msyylex() == CLASS) {
-            if((s = getSymbol(2, MS_NUMBER, MS_STRING)) == -1) return MS_FAILURE;
+          if(msLexerNextToken(lexer) == CLASS) {
+            if((s = getSymbol(lexer, 2, MS_NUMBER, MS_STRING)) == -1) return MS_FAILURE;
             if(s == MS_STRING)
-              j = msGetClassIndex(GET_LAYER(map, i), msyystring_buffer);
+              j = msGetClassIndex(GET_LAYER(map, i), lexer->string_buffer);
             else
-              j = (int) msyynumber;
+              j = (int) lexer->number;
 
             if(j>=GET_LAYER(map, i)->numclasses || j<0) {
               msSetError(MS_MISCERR, "Class to be modified not valid.", "msUpdateMapFromURL()");
@@ -6654,9 +7300,9 @@ int msUpdateMapFromURL(mapObj *map, char *variable, char *string)
             if(msLookupHashTable(&(GET_LAYER(map, i)->class[j]->validation), "immutable"))
               return(MS_SUCCESS); /* fail silently */
 
-            switch(msyylex()) {
+            switch(msLexerNextToken(lexer)) {
               case STYLE:
-                if(getInteger(&k) == -1) return MS_FAILURE;
+                if(getInteger(lexer, &k) == -1) return MS_FAILURE;
                 if(k>=GET_LAYER(map, i)->class[j]->numstyles || k<0) {
                   msSetError(MS_MISCERR, "Style to be modified not valid.", "msUpdateMapFromURL()");
                   return MS_FAILURE;
@@ -6664,7 +7310,7 @@ int msUpdateMapFromURL(mapObj *map, char *variable, char *string)
                 if(msUpdateStyleFromString((GET_LAYER(map, i))->class[j]->styles[k], string, MS_TRUE) != MS_SUCCESS) return MS_FAILURE;
                 break;
               case LABEL:
-                if(getInteger(&k) == -1) return MS_FAILURE;
+                if(getInteger(lexer, &k) == -1) return MS_FAILURE;
                 if(k>=GET_LAYER(map, i)->class[j]->numlabels || k<0) {
                   msSetError(MS_MISCERR, "Label to be modified not valid.", "msUpdateMapFromURL()");
                   return MS_FAILURE;
@@ -6696,7 +7342,7 @@ int msUpdateMapFromURL(mapObj *map, char *variable, char *string)
 
           break;
         case(LEGEND):
-          if(msyylex() == LABEL) {
+          if(msLexerNextToken(lexer) == LABEL) {
             return msUpdateLabelFromString(&map->legend.label, string, MS_TRUE);
           } else {
             return msUpdateLegendFromString(&(map->legend), string, MS_TRUE);
@@ -6709,28 +7355,28 @@ int msUpdateMapFromURL(mapObj *map, char *variable, char *string)
         case(REFERENCE):
           return msUpdateReferenceMapFromString(&(map->reference), string, MS_TRUE);
         case(RESOLUTION):
-          msyystate = MS_TOKENIZE_URL_STRING;
-          msyystring = string;
-          msyylex();
+          lexer->state = MS_TOKENIZE_URL_STRING;
+          lexer->string = string;
+          msLexerNextToken(lexer);
 
-          if(getDouble(&(map->resolution)) == -1) break;
+          if(getDouble(lexer, &(map->resolution)) == -1) break;
           break;
         case(DEFRESOLUTION):
-          msyystate = MS_TOKENIZE_URL_STRING;
-          msyystring = string;
-          msyylex();
+          lexer->state = MS_TOKENIZE_URL_STRING;
+          lexer->string = string;
+          msLexerNextToken(lexer);
 
-          if(getDouble(&(map->defresolution)) == -1) break;
+          if(getDouble(lexer, &(map->defresolution)) == -1) break;
           break;
         case(SCALEBAR):
           return msUpdateScalebarFromString(&(map->scalebar), string, MS_TRUE);
         case(SIZE):
-          msyystate = MS_TOKENIZE_URL_STRING;
-          msyystring = string;
-          msyylex();
+          lexer->state = MS_TOKENIZE_URL_STRING;
+          lexer->string = string;
+          msLexerNextToken(lexer);
 
-          if(getInteger(&(map->width)) == -1) break;
-          if(getInteger(&(map->height)) == -1) break;
+          if(getInteger(lexer, &(map->width)) == -1) break;
+          if(getInteger(lexer, &(map->height)) == -1) break;
 
           if(map->width > map->maxsize || map->height > map->maxsize || map->width < 0 || map->height < 0) {
             msSetError(MS_WEBERR, "Image size out of range.", "msUpdateMapFromURL()");
@@ -6739,19 +7385,19 @@ int msUpdateMapFromURL(mapObj *map, char *variable, char *string)
           msMapComputeGeotransform( map );
           break;
         case(TRANSPARENT):
-          msyystate = MS_TOKENIZE_URL_STRING;
-          msyystring = string;
-          msyylex();
+          lexer->state = MS_TOKENIZE_URL_STRING;
+          lexer->string = string;
+          msLexerNextToken(lexer);
 
-          if((map->transparent = getSymbol(2, MS_ON,MS_OFF)) == -1) break;
+          if((map->transparent = getSymbol(lexer, 2, MS_ON,MS_OFF)) == -1) break;
           msPostMapParseOutputFormatSetup( map );
           break;
         case(UNITS):
-          msyystate = MS_TOKENIZE_URL_STRING;
-          msyystring = string;
-          msyylex();
+          lexer->state = MS_TOKENIZE_URL_STRING;
+          lexer->string = string;
+          msLexerNextToken(lexer);
 
-          if((map->units = getSymbol(7, MS_INCHES,MS_FEET,MS_MILES,MS_METERS,MS_KILOMETERS,MS_NAUTICALMILES,MS_DD)) == -1) break;
+          if((map->units = getSymbol(lexer, 7, MS_INCHES,MS_FEET,MS_MILES,MS_METERS,MS_KILOMETERS,MS_NAUTICALMILES,MS_DD)) == -1) break;
           break;
         case(WEB):
           return msUpdateWebFromString(&(map->web), string, MS_TRUE);
@@ -6763,14 +7409,27 @@ int msUpdateMapFromURL(mapObj *map, char *variable, char *string)
       break;
   }
 
-  /* msyystate = 3; */ /* restore lexer state */
-  /* msyylex(); */
-
   if(ms_error->code != MS_NOERR) return(MS_FAILURE);
 
   return(MS_SUCCESS);
 }
 
+int msUpdateMapFromURL(mapObj *map, char *variable, char *string)
+{
+  lexerObj lexer;
+  int status;
+
+  /* make sure this configuration can be modified */
+  if(msLookupHashTable(&(map->web.validation), "immutable"))
+    return(MS_SUCCESS); /* fail silently */
+
+  if(msInitLexer(&lexer) != MS_SUCCESS) return(MS_FAILURE);
+  status = updateMapFromURL(&lexer, map, variable, string);
+  msFreeLexer(&lexer);
+
+  return(status);
+}
+
 static int classNeedsSubstitutions(classObj *class, char *from) {
   if(class->expression.string && (strcasestr(class->expression.string, from) != NULL)) return MS_TRUE;
   if(class->text.string && (strcasestr(class->text.string, from) != NULL)) return MS_TRUE;
@@ -6898,7 +7557,10 @@ void msApplyDefaultSubstitutions(mapObj *map)
   }
 
   for(i=0; i<map->numlayers; i++) {
-    layerObj *layer = GET_LAYER(map, i);
+    layerObj *layer;
+
+    if(map->layers[i]->lazy && !lazyLayerContains(map->layers[i], "%")) continue; /* nothing to substitute */
+    layer = GET_LAYER(map, i);
 
     for(j=0; j<layer->numclasses; j++) {    /* class settings take precedence...  */
       classObj *class = GET_CLASS(map, i, j);
@@ -6936,7 +7598,10 @@ void msApplySubstitutions(mapObj *map, char **names, char **values, int npairs)
     }
 
     for(j=0; j<map->numlayers; j++) {
-      layerObj *layer = GET_LAYER(map, j);
+      layerObj *layer;
+
+      if(map->layers[j]->lazy && !lazyLayerContains(map->layers[j], tag)) continue; /* nothing to substitute */
+      layer = GET_LAYER(map, j);
 
       /* perform class level substitutions (#4596) */
       for(k=0; k<layer->numclasses; k++) {
@@ -7005,9 +7670,10 @@ void msApplySubstitutions(mapObj *map, char **names, char **values, int npairs)
 **
 ** The returned array should be freed using msFreeCharArray().
 */
-static char **tokenizeMapInternal(char *filename, int *ret_numtokens)
+static char **tokenizeMapInternal(lexerObj *lexer, char *filename, int *ret_numtokens)
 {
   char **tokens = NULL;
+  FILE *mapfile;
   int  numtokens=0, numtokens_allocated=0;
   size_t buffer_size = 0;
 
@@ -7033,24 +7699,31 @@ static char **tokenizeMapInternal(char *filename, int *ret_numtokens)
     }
   }
 
-  if((msyyin = fopen(filename,"r")) == NULL) {
+  if((mapfile = fopen(filename,"r")) == NULL) {
     msSetError(MS_IOERR, "(%s)", "msTokenizeMap()", filename);
     return NULL;
   }
 
-  msyystate = MS_TOKENIZE_FILE; /* restore lexer state to INITIAL, and do return comments */
-  msyylex();
-  msyyreturncomments = 1; /* want all tokens, including comments */
+  lexer->state = MS_TOKENIZE_FILE; /* restore lexer state to INITIAL, and do return comments */
+  msLexerNextToken(lexer);
+  lexer->returncomments = 1; /* want all tokens, including comments */
 
-  msyyrestart(msyyin); /* start at line begining, line 1 */
-  msyylineno = 1;
+  switch(loadCompiledTokens(lexer, mapfile, filename)) {
+    case(MS_FAILURE):
+      fclose(mapfile);
+      return NULL;
+    case(MS_DONE):
+      msyyrestart(mapfile, lexer->scanner); /* start at line begining, line 1 */
+      break;
+  }
+  lexer->lineno = 1;
 
   numtokens = 0;
   numtokens_allocated = 256;
   tokens = (char **) malloc(numtokens_allocated*sizeof(char*));
   if(tokens == NULL) {
     msSetError(MS_MEMERR, NULL, "msTokenizeMap()");
-    fclose(msyyin);
+    fclose(mapfile);
     return NULL;
   }
 
@@ -7061,40 +7734,40 @@ static char **tokenizeMapInternal(char *filename, int *ret_numtokens)
       tokens = (char **)realloc(tokens, numtokens_allocated*sizeof(char*));
       if(tokens == NULL) {
         msSetError(MS_MEMERR, "Realloc() error.", "msTokenizeMap()");
-        fclose(msyyin);
+        fclose(mapfile);
         return NULL;
       }
     }
 
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(EOF): /* This is the normal way out... cleanup and exit */
-        fclose(msyyin);
+        fclose(mapfile);
         *ret_numtokens = numtokens;
         return(tokens);
         break;
       case(MS_STRING):
-        buffer_size = strlen(msyystring_buffer)+2+1;
+        buffer_size = strlen(lexer->string_buffer)+2+1;
         tokens[numtokens] = (char*) msSmallMalloc(buffer_size);
-        snprintf(tokens[numtokens], buffer_size, "\"%s\"", msyystring_buffer);
+        snprintf(tokens[numtokens], buffer_size, "\"%s\"", lexer->string_buffer);
         break;
       case(MS_EXPRESSION):
-        buffer_size = strlen(msyystring_buffer)+2+1;
+        buffer_size = strlen(lexer->string_buffer)+2+1;
         tokens[numtokens] = (char*) msSmallMalloc(buffer_size);
-        snprintf(tokens[numtokens], buffer_size, "(%s)", msyystring_buffer);
+        snprintf(tokens[numtokens], buffer_size, "(%s)", lexer->string_buffer);
         break;
       case(MS_REGEX):
-        buffer_size = strlen(msyystring_buffer)+2+1;
+        buffer_size = strlen(lexer->string_buffer)+2+1;
         tokens[numtokens] = (char*) msSmallMalloc(buffer_size);
-        snprintf(tokens[numtokens], buffer_size, "/%s/", msyystring_buffer);
+        snprintf(tokens[numtokens], buffer_size, "/%s/", lexer->string_buffer);
         break;
       default:
-        tokens[numtokens] = msStrdup(msyystring_buffer);
+        tokens[numtokens] = msStrdup(lexer->string_buffer);
         break;
     }
 
     if(tokens[numtokens] == NULL) {
       msSetError(MS_MEMERR, NULL, "msTokenizeMap()");
-      fclose(msyyin);
+      fclose(mapfile);
       return NULL;
     }
 
@@ -7110,21 +7783,125 @@ static char **tokenizeMapInternal(char *filename, int *ret_numtokens)
 char **msTokenizeMap(char *filename, int *numtokens)
 {
   char **tokens;
+  lexerObj lexer;
 
-  msAcquireLock( TLOCK_PARSER );
-  tokens = tokenizeMapInternal( filename, numtokens );
-  msReleaseLock( TLOCK_PARSER );
+  if(msInitLexer(&lexer) != MS_SUCCESS) {
+    *numtokens = 0;
+    return NULL;
+  }
+  tokens = tokenizeMapInternal( &lexer, filename, numtokens );
+  msFreeLexer(&lexer);
 
   return tokens;
 }
 
+/*
+** Writes the tokens of a mapfile, with INCLUDEs inlined and without
+** comments, to outfile as a compiled mapfile that msLoadMap() reads without
+** scanning any text (see loadCompiledTokens()). The mapfile is loaded first
+** so only valid mapfiles get compiled. A compiled mapfile only works with
+** the MapServer version and platform that wrote it, and its relative paths
+** are taken from its own location, so write it next to the mapfile.
+*/
+int msCompileMap(char *filename, char *outfile)
+{
+  mapObj *map;
+  lexerObj lexer;
+  FILE *mapfile, *stream;
+  char szPath[MS_MAXPATHLEN], szCWDPath[MS_MAXPATHLEN], *path;
+  int token, header[3], status;
+  msIOBuffer buffer = {NULL, 0, 0};
+
+  if((map = msLoadMap(filename, NULL)) == NULL)
+    return MS_FAILURE;
+  msFreeMap(map);
+
+  if(NULL == getcwd(szCWDPath, MS_MAXPATHLEN)) {
+    msSetError(MS_MISCERR, "getcwd() returned a too long path", "msCompileMap()");
+    return MS_FAILURE;
+  }
+
+  if((mapfile = fopen(filename, "r")) == NULL) {
+    msSetError(MS_IOERR, "(%s)", "msCompileMap()", filename);
+    return MS_FAILURE;
+  }
+
+  if(msInitLexer(&lexer) != MS_SUCCESS) {
+    fclose(mapfile);
+    return MS_FAILURE;
+  }
+
+  lexer.state = MS_TOKENIZE_FILE;
+  msyylex(lexer.scanner);
+
+  status = loadCompiledTokens(&lexer, mapfile, filename);
+  if(status == MS_FAILURE) {
+    fclose(mapfile);
+    msFreeLexer(&lexer);
+    msFree(lexer.compiled);
+    return MS_FAILURE;
+  }
+  if(status == MS_DONE)
+    msyyrestart(mapfile, lexer.scanner);
+  lexer.lineno = 1;
+
+  path = msGetPath(filename);
+  lexer.basepath = msBuildPath(szPath, szCWDPath, path); /* for INCLUDEs */
+  free(path);
+
+  if((stream = fopen(outfile, "wb")) == NULL) {
+    msSetError(MS_IOERR, "(%s)", "msCompileMap()", outfile);
+    fclose(mapfile);
+    msFreeLexer(&lexer);
+    msFree(lexer.compiled);
+    return MS_FAILURE;
+  }
+
+  header[0] = MS_COMPILED_MAP_VERSION;
+  header[1] = MS_COMPILED_MAP_BYTEORDER;
+  header[2] = MS_VERSION_NUM;
+  fwrite(MS_COMPILED_MAP_MAGIC, 1, MS_COMPILED_MAP_MAGIC_SIZE, stream);
+  fwrite(header, sizeof(int), 3, stream);
+
+  status = MS_SUCCESS;
+  for(;;) {
+    lexer.string_icase = MS_TRUE; /* keep "..."i strings apart, msLexerNextCompiledToken() sorts them out */
+    token = msLexerNextToken(&lexer);
+    if(token == EOF) {
+      if(!lexer.compiled && lexer.include_stack_ptr >= 0) /* a failed INCLUDE, not the end of the mapfile */
+        status = MS_FAILURE;
+      break;
+    }
+
+    writeCompiledToken(&buffer, &lexer, token);
+    if(buffer.data_offset >= 65536) {
+      fwrite(buffer.data, 1, buffer.data_offset, stream);
+      buffer.data_offset = 0;
+    }
+  }
+  fwrite(buffer.data, 1, buffer.data_offset, stream);
+  msFree(buffer.data);
+
+  if(ferror(stream)) {
+    msSetError(MS_IOERR, "Failed to write compiled mapfile (%s).", "msCompileMap()", outfile);
+    status = MS_FAILURE;
+  }
+  if(fclose(stream) != 0)
+    status = MS_FAILURE;
+  fclose(mapfile);
+  msFreeLexer(&lexer);
+  msFree(lexer.compiled);
+
+  return status;
+}
+
 void msCloseConnections(mapObj *map)
 {
   int i;
   layerObj *lp;
 
   for (i=0; i<map->numlayers; i++) {
-    lp = (GET_LAYER(map, i));
+    lp = map->layers[i]; /* a lazy layer was never opened */
 
     /* If the vtable is null, then the layer is never accessed or used -> skip it
      */
@@ -7149,10 +7926,10 @@ static int resolveSymbolNames(mapObj* map)
 {
   int i, j;
 
-  /* step through layers and classes to resolve symbol names */
+  /* step through layers and classes to resolve symbol names, lazy layers have no classes yet */
   for(i=0; i<map->numlayers; i++) {
-    for(j=0; j<GET_LAYER(map, i)->numclasses; j++) {
-      if(classResolveSymbolNames(GET_LAYER(map, i)->class[j]) != MS_SUCCESS) return MS_FAILURE;
+    for(j=0; j<map->layers[i]->numclasses; j++) {
+      if(classResolveSymbolNames(map->layers[i]->class[j]) != MS_SUCCESS) return MS_FAILURE;
     }
   }
 
@@ -30,8 +30,6 @@
 #include "mapserver.h"
 #include "mapthread.h"
 
-extern int yyparse(parseObj *p);
-
 void msStyleSetGeomTransform(styleObj *s, char *transform)
 {
   msFree(s->_geomtransform.string);
@@ -183,7 +181,7 @@ int msDrawTransformedShape(mapObj *map, symbolSetObj *symbolset, imageObj *image
       p.expr->curtoken = p.expr->tokens; /* reset */
       p.type = MS_PARSE_TYPE_SHAPE;
 
-      status = yyparse(&p);
+      status = msExecuteExpression(&p);
       if (status != 0) {
         msSetError(MS_PARSEERR, "Failed to process shape expression: %s", "msDrawTransformedShape", style->_geomtransform.string);
         return MS_FAILURE;
@@ -243,7 +241,7 @@ int msGeomTransformShape(mapObj *map, layerObj *layer, shapeObj *shape)
           p.dblval2 = atof(value);
       }
           
-      status = yyparse(&p);
+      status = msExecuteExpression(&p);
       if (status != 0) {
         msSetError(MS_PARSEERR, "Failed to process shape expression: %s", "msGeomTransformShape()", e->string);
         return MS_FAILURE;
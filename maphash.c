@@ -27,47 +27,139 @@
  * DEALINGS IN THE SOFTWARE.
  ****************************************************************************/
 
-#include <ctype.h>
-
 #include "mapserver.h"
 #include "maphash.h"
 
+#define MS_HASH_EMPTY -1    /* slot never used, ends a probe */
+#define MS_HASH_REMOVED -2  /* slot of a removed item, probes go on */
+#define MS_HASH_MINSLOTS 8
+
+/*
+** Keys are case insensitive for ASCII letters only, whatever the locale, so
+** that keys that compare equal always hash the same.
+*/
+#define MS_HASH_FOLD(c) (((c) >= 'A' && (c) <= 'Z') ? (c) + ('a' - 'A') : (c))
+
+static int keyEqual(const char *a, const char *b)
+{
+  unsigned ca, cb;
 
+  do {
+    ca = (unsigned char) *a++;
+    cb = (unsigned char) *b++;
+    if(MS_HASH_FOLD(ca) != MS_HASH_FOLD(cb))
+      return MS_FALSE;
+  } while(ca != '\0');
 
+  return MS_TRUE;
+}
+
+/*
+** One multiply-add per character keeps short keys cheap, the bits are mixed
+** once at the end since slots are picked with the low ones.
+*/
 static unsigned hash(const char *key)
 {
-  unsigned hashval;
+  unsigned hashval = 0, c;
+
+  for(; *key!='\0'; key++) {
+    c = (unsigned char) *key;
+    hashval = MS_HASH_FOLD(c) + 31 * hashval;
+  }
+
+  hashval ^= hashval >> 16;
+  hashval *= 0x45d9f3bU;
+  hashval ^= hashval >> 16;
+
+  return(hashval);
+}
+
+/* position in table->items of the item with key, -1 if there is none */
+static int findItem(hashTableObj *table, const char *key, unsigned hashval, int *slot)
+{
+  unsigned mask, i;
+  int item;
+
+  if(table->numslots == 0)
+    return -1;
+
+  mask = table->numslots - 1;
+  for(i = hashval & mask; (item = table->slots[i].item) != MS_HASH_EMPTY; i = (i + 1) & mask) {
+    if(table->slots[i].hash == hashval && item >= 0 && keyEqual(key, table->items[item].key)) {
+      if(slot) *slot = i;
+      return item;
+    }
+  }
+
+  return -1;
+}
+
+/*
+** Drops removed items, freeing their keys, and rebuilds the slots with room
+** for the items left and as many again. Slots are never more than 3/4 used,
+** so probes always end on an empty one.
+*/
+static int resizeTable(hashTableObj *table)
+{
+  int i, n, numslots = MS_HASH_MINSLOTS;
+  struct hashSlot *slots;
+  unsigned mask, j;
+
+  for(i=0, n=0; i<table->numused; i++) {
+    if(table->items[i].data != NULL)
+      table->items[n++] = table->items[i];
+    else
+      msFree(table->items[i].key);
+  }
+  table->numused = n;
+
+  while(numslots < 2 * (n + 1))
+    numslots *= 2;
 
-  for(hashval=0; *key!='\0'; key++)
-    hashval = tolower(*key) + 31 * hashval;
+  if(numslots != table->numslots) {
+    struct hashObj *items = (struct hashObj *) realloc(table->items, sizeof(struct hashObj) * (numslots / 4 * 3));
+    MS_CHECK_ALLOC(items, sizeof(struct hashObj) * (numslots / 4 * 3), MS_FAILURE);
+    table->items = items;
+    table->maxitems = numslots / 4 * 3;
+
+    slots = (struct hashSlot *) realloc(table->slots, sizeof(struct hashSlot) * numslots);
+    MS_CHECK_ALLOC(slots, sizeof(struct hashSlot) * numslots, MS_FAILURE);
+    table->slots = slots;
+    table->numslots = numslots;
+  }
+
+  for(i=0; i<table->numslots; i++)
+    table->slots[i].item = MS_HASH_EMPTY;
+
+  mask = table->numslots - 1;
+  for(i=0; i<n; i++) {
+    for(j = table->items[i].hash & mask; table->slots[j].item != MS_HASH_EMPTY; j = (j + 1) & mask) {}
+    table->slots[j].item = i;
+    table->slots[j].hash = table->items[i].hash;
+  }
 
-  return(hashval % MS_HASHSIZE);
+  return MS_SUCCESS;
 }
 
 hashTableObj *msCreateHashTable()
 {
-  int i;
   hashTableObj *table;
 
   table = (hashTableObj *) msSmallMalloc(sizeof(hashTableObj));
-  table->items = (struct hashObj **) msSmallMalloc(sizeof(struct hashObj *)*MS_HASHSIZE);
-
-  for (i=0; i<MS_HASHSIZE; i++)
-    table->items[i] = NULL;
-  table->numitems = 0;
+  initHashTable(table);
 
   return table;
 }
 
+/* the items and slots are only allocated with the first item, most tables stay empty */
 int initHashTable( hashTableObj *table )
 {
-  int i;
-
-  table->items = (struct hashObj **) malloc(sizeof(struct hashObj *)*MS_HASHSIZE);
-  MS_CHECK_ALLOC(table->items, sizeof(struct hashObj *)*MS_HASHSIZE, MS_FAILURE);
-
-  for (i=0; i<MS_HASHSIZE; i++)
-    table->items[i] = NULL;
+  table->items = NULL;
+  table->numused = 0;
+  table->maxitems = 0;
+  table->slots = NULL;
+  table->numslots = 0;
+  table->lastitem = 0;
   table->numitems = 0;
   return MS_SUCCESS;
 }
@@ -93,25 +185,15 @@ int msHashIsEmpty( hashTableObj *table )
 void msFreeHashItems( hashTableObj *table )
 {
   int i;
-  struct hashObj *tp=NULL;
-  struct hashObj *prev_tp=NULL;
 
   if (table) {
-    if(table->items) {
-      for (i=0; i<MS_HASHSIZE; i++) {
-        if (table->items[i] != NULL) {
-          for (tp=table->items[i]; tp!=NULL; prev_tp=tp,tp=tp->next,free(prev_tp)) {
-            msFree(tp->key);
-            msFree(tp->data);
-          }
-        }
-        if (tp) free(tp);
-      }
-      free(table->items);
-      table->items = NULL;
-    } else {
-      msSetError(MS_HASHERR, "No items allocated.", "msFreeHashItems()");
+    for (i=0; i<table->numused; i++) {
+      msFree(table->items[i].key);
+      msFree(table->items[i].data);
     }
+    msFree(table->items);
+    msFree(table->slots);
+    initHashTable(table);
   } else {
     msSetError(MS_HASHERR, "Can't free NULL table", "msFreeHashItems()");
   }
@@ -120,7 +202,9 @@ void msFreeHashItems( hashTableObj *table )
 struct hashObj *msInsertHashTable(hashTableObj *table,
                                   const char *key, const char *value) {
   struct hashObj *tp;
-  unsigned hashval;
+  unsigned hashval, mask, i;
+  int item;
+  char *data;
 
   if (!table || !key || !value) {
     msSetError(MS_HASHERR, "Invalid hash table or key",
@@ -128,96 +212,92 @@ struct hashObj *msInsertHashTable(hashTableObj *table,
     return NULL;
   }
 
-  for (tp=table->items[hash(key)]; tp!=NULL; tp=tp->next)
-    if(strcasecmp(key, tp->key) == 0)
-      break;
+  hashval = hash(key);
+  item = findItem(table, key, hashval, NULL);
 
-  if (tp == NULL) { /* not found */
-    tp = (struct hashObj *) malloc(sizeof(*tp));
-    MS_CHECK_ALLOC(tp, sizeof(*tp), NULL);
-    tp->key = msStrdup(key);
-    hashval = hash(key);
-    tp->next = table->items[hashval];
-    table->items[hashval] = tp;
+  /* key and value may belong to this table, copy them before it changes */
+  data = msStrdup(value);
+
+  if (item == -1) { /* not found */
+    char *newkey = msStrdup(key);
+
+    if (table->numused == table->maxitems && resizeTable(table) != MS_SUCCESS) {
+      msFree(newkey);
+      msFree(data);
+      return NULL;
+    }
+
+    mask = table->numslots - 1;
+    for (i = hashval & mask; table->slots[i].item >= 0; i = (i + 1) & mask) {}
+    item = table->numused++;
+    table->slots[i].item = item;
+    table->slots[i].hash = hashval;
+
+    tp = &(table->items[item]);
+    tp->key = newkey;
+    tp->hash = hashval;
     table->numitems++;
   } else {
+    tp = &(table->items[item]);
     free(tp->data);
   }
 
-  if ((tp->data = msStrdup(value)) == NULL)
-    return NULL;
+  tp->data = data;
 
   return tp;
 }
 
 char *msLookupHashTable(hashTableObj *table, const char *key)
 {
-  struct hashObj *tp;
+  int item;
 
   if (!table || !key) {
     return(NULL);
   }
 
-  for (tp=table->items[hash(key)]; tp!=NULL; tp=tp->next)
-    if (strcasecmp(key, tp->key) == 0)
-      return(tp->data);
+  if ((item = findItem(table, key, hash(key), NULL)) == -1)
+    return NULL;
 
-  return NULL;
+  return(table->items[item].data);
 }
 
 int msRemoveHashTable(hashTableObj *table, const char *key)
 {
-  struct hashObj *tp;
-  struct hashObj *prev_tp=NULL;
-  int status = MS_FAILURE;
+  int item, slot;
 
   if (!table || !key) {
     msSetError(MS_HASHERR, "No hash table", "msRemoveHashTable");
     return MS_FAILURE;
   }
 
-  tp=table->items[hash(key)];
-  if (!tp) {
+  if ((item = findItem(table, key, hash(key), &slot)) == -1) {
     msSetError(MS_HASHERR, "No such hash entry", "msRemoveHashTable");
     return MS_FAILURE;
   }
 
-  prev_tp = NULL;
-  while (tp != NULL) {
-    if (strcasecmp(key, tp->key) == 0) {
-      status = MS_SUCCESS;
-      if (prev_tp) {
-        prev_tp->next = tp->next;
-        free(tp);
-        break;
-      } else {
-        table->items[hash(key)] = tp->next;
-        free(tp);
-        break;
-      }
-    }
-    prev_tp = tp;
-    tp = tp->next;
-  }
-
-  if (status == MS_SUCCESS)
-    table->numitems--;
+  /* the key stays until the items are compacted, callers may still hold it */
+  table->slots[slot].item = MS_HASH_REMOVED;
+  msFree(table->items[item].data);
+  table->items[item].data = NULL;
+  table->numitems--;
 
-  return status;
+  return MS_SUCCESS;
 }
 
 const char *msFirstKeyFromHashTable( hashTableObj *table )
 {
-  int hash_index;
+  int i;
 
   if (!table) {
     msSetError(MS_HASHERR, "No hash table", "msFirstKeyFromHashTable");
     return NULL;
   }
 
-  for (hash_index = 0; hash_index < MS_HASHSIZE; hash_index++ ) {
-    if (table->items[hash_index] != NULL )
-      return table->items[hash_index]->key;
+  for (i = 0; i < table->numused; i++) {
+    if (table->items[i].data != NULL) {
+      table->lastitem = i;
+      return table->items[i].key;
+    }
   }
 
   return NULL;
@@ -225,8 +305,7 @@ const char *msFirstKeyFromHashTable( hashTableObj *table )
 
 const char *msNextKeyFromHashTable( hashTableObj *table, const char *lastKey )
 {
-  int hash_index;
-  struct hashObj *link;
+  int i;
 
   if (!table) {
     msSetError(MS_HASHERR, "No hash table", "msNextKeyFromHashTable");
@@ -236,19 +315,17 @@ const char *msNextKeyFromHashTable( hashTableObj *table, const char *lastKey )
   if ( lastKey == NULL )
     return msFirstKeyFromHashTable( table );
 
-  hash_index = hash(lastKey);
-  for ( link = table->items[hash_index];
-        link != NULL && strcasecmp(lastKey,link->key) != 0;
-        link = link->next ) {}
-
-  if ( link != NULL && link->next != NULL )
-    return link->next->key;
+  i = table->lastitem;
+  if ((i >= table->numused || table->items[i].key != lastKey) &&
+      (i = findItem(table, lastKey, hash(lastKey), NULL)) == -1)
+    return NULL;
 
-  while ( ++hash_index < MS_HASHSIZE ) {
-    if ( table->items[hash_index] != NULL )
-      return table->items[hash_index]->key;
+  while ( ++i < table->numused ) {
+    if ( table->items[i].data != NULL ) {
+      table->lastitem = i;
+      return table->items[i].key;
+    }
   }
 
   return NULL;
 }
-
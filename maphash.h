@@ -40,23 +40,45 @@ extern "C" {
 #define  MS_DLL_EXPORT
 #endif
 
-#define MS_HASHSIZE 41
-
   /* =========================================================================
    * Structs
    * ========================================================================= */
 
+  /*
+  ** Items live in insertion order in one array, found through an open
+  ** addressing index of slots (linear probing) holding their positions. The
+  ** hash of each key is kept with the item and its slot, so probes only
+  ** compare keys when hashes match and growing the index doesn't rehash
+  ** strings. Keys are case insensitive for ASCII letters, in any locale.
+  **
+  ** The table owns copies of the keys and values it is given. A removed item
+  ** keeps its key until the items are compacted, which only happens when
+  ** msInsertHashTable() adds a new key, so a key obtained from the table
+  ** stays valid across msRemoveHashTable() and iteration can go on from a key
+  ** that was just removed.
+  */
+
 #ifndef SWIG
   struct hashObj {
-    struct hashObj *next;  /* pointer to next item */
-    char           *key;   /* string key that is hashed */
-    char           *data;  /* string stored in this item */
+    char           *key;   /* string key that is hashed, kept until removed items are compacted */
+    char           *data;  /* string stored in this item, NULL once removed */
+    unsigned        hash;  /* hash of key */
+  };
+
+  struct hashSlot {
+    int             item;  /* position in items, or empty or removed (< 0) */
+    unsigned        hash;  /* hash of the item key, probes only look at items that match */
   };
 #endif /*SWIG*/
 
   typedef struct {
 #ifndef SWIG
-    struct hashObj **items;  /* the hash table */
+    struct hashObj *items;     /* the items, in insertion order, removed ones included */
+    int             numused;   /* number of items used, removed ones included */
+    int             maxitems;  /* number of items allocated */
+    struct hashSlot *slots;    /* index of the items, numslots long (a power of 2) */
+    int             numslots;
+    int             lastitem;  /* position of the last key iterated over, saves looking it up again */
 #endif
 #ifdef SWIG
     %immutable;
@@ -94,13 +116,13 @@ extern "C" {
   /* Free only the items for hashTableObj structure members (metadata, &c) */
   MS_DLL_EXPORT void msFreeHashItems( hashTableObj *table );
 
-  /* msInsertHashTable - insert new item
+  /* msInsertHashTable - insert new item, or replace the value of an item
    * ARGS:
    *     table - the target hash table
-   *     key   - key string for new item
-   *     value - data string for new item
+   *     key   - key string for new item, copied (may be a key of the table)
+   *     value - data string for new item, copied (may be a value of the table)
    * RETURNS:
-   *     pointer to the new item or NULL
+   *     pointer to the new item or NULL, valid until the table changes
    * EXCEPTIONS:
    *     raise MS_HASHERR on failure
    */
@@ -120,9 +142,10 @@ extern "C" {
   /* msRemoveHashTable - remove item from table at key
    * ARGS:
    *     table - target hash table
-   *     key   - key string
+   *     key   - key string, never freed (may be a key of the table)
    * RETURNS:
-   *     MS_SUCCESS or MS_FAILURE
+   *     MS_SUCCESS or MS_FAILURE, the value of the item is freed but its
+   *     key stays valid until msInsertHashTable() adds a new key
    */
   MS_DLL_EXPORT int msRemoveHashTable( hashTableObj *table, const char *key);
 
@@ -130,7 +153,8 @@ extern "C" {
    * ARGS:
    *     table - target hash table
    * RETURNS:
-   *     first key as a string
+   *     first key as a string, keys come in insertion order. The key
+   *     belongs to the table, see msRemoveHashTable() for how long it lasts
    */
   MS_DLL_EXPORT const char *msFirstKeyFromHashTable( hashTableObj *table );
 
@@ -32,6 +32,7 @@
 */
 
 #include "mapserver.h"
+#include "mapthread.h"
 
 
 
@@ -742,6 +743,305 @@ static int labelInImage(int width, int height, shapeObj *lpoly, int gutter)
   return(MS_TRUE);
 }
 
+/*
+** Label cache index: a uniform grid of LABELCACHE_INDEX_CELLSIZE pixel cells
+** over the image, holding the markers of the cache and the labels placed so
+** far, each in every cell its bounds touch. The bounds of a placed label
+** cover its polygon, its leader line and its label point, so a query over
+** the bounds of a candidate, its leader and its MINDISTANCE reach finds
+** every member msTestLabelCacheCollisions() could reject it for. Coordinates
+** outside the image fall in the border cells. msDrawLabelCache() builds the
+** index with msBuildLabelCacheIndex(), adds labels as it places them with
+** msLabelCacheIndexAddLabel() and frees it when done. Without an index
+** msTestLabelCacheCollisions() scans the whole cache as before.
+*/
+#define LABELCACHE_INDEX_CELLSIZE 32
+
+typedef struct labelCacheIndexObj labelCacheIndexObj;
+
+typedef struct {
+  int priority; /* slot of the member */
+  int index; /* in the labels, or the markers of the slot */
+  int marker; /* MS_TRUE for a marker */
+  unsigned int query; /* last query that returned this entry */
+} labelCacheIndexEntryObj;
+
+typedef struct {
+  int *entries;
+  int numentries, maxentries;
+} labelCacheIndexCellObj;
+
+struct labelCacheIndexObj {
+  int ncols, nrows;
+  labelCacheIndexCellObj *cells;
+  labelCacheIndexEntryObj *entries;
+  int numentries, maxentries;
+  unsigned int query;
+};
+
+static int labelCacheIndexCol(labelCacheIndexObj *index, double x)
+{
+  if(!(x >= 0)) return 0; /* NaN as well */
+  if(x >= (double) index->ncols*LABELCACHE_INDEX_CELLSIZE) return index->ncols-1;
+  return (int) (x / LABELCACHE_INDEX_CELLSIZE);
+}
+
+static int labelCacheIndexRow(labelCacheIndexObj *index, double y)
+{
+  if(!(y >= 0)) return 0;
+  if(y >= (double) index->nrows*LABELCACHE_INDEX_CELLSIZE) return index->nrows-1;
+  return (int) (y / LABELCACHE_INDEX_CELLSIZE);
+}
+
+static void labelCacheIndexInsert(labelCacheIndexObj *index, int priority, int i, int marker, rectObj *bounds)
+{
+  int id, col, row, mincol, maxcol, minrow, maxrow;
+
+  if(index->numentries == index->maxentries) {
+    index->maxentries = MS_MAX(64, index->maxentries*2);
+    index->entries = (labelCacheIndexEntryObj *) msSmallRealloc(index->entries, index->maxentries*sizeof(labelCacheIndexEntryObj));
+  }
+  id = index->numentries++;
+  index->entries[id].priority = priority;
+  index->entries[id].index = i;
+  index->entries[id].marker = marker;
+  index->entries[id].query = 0;
+
+  mincol = labelCacheIndexCol(index, bounds->minx);
+  maxcol = labelCacheIndexCol(index, bounds->maxx);
+  minrow = labelCacheIndexRow(index, bounds->miny);
+  maxrow = labelCacheIndexRow(index, bounds->maxy);
+  for(row=minrow; row<=maxrow; row++) {
+    for(col=mincol; col<=maxcol; col++) {
+      labelCacheIndexCellObj *cell = &(index->cells[row*index->ncols + col]);
+      if(cell->numentries == cell->maxentries) {
+        cell->maxentries = MS_MAX(8, cell->maxentries*2);
+        cell->entries = (int *) msSmallRealloc(cell->entries, cell->maxentries*sizeof(int));
+      }
+      cell->entries[cell->numentries++] = id;
+    }
+  }
+}
+
+static void rectMerge(rectObj *rect, rectObj *other)
+{
+  rect->minx = MS_MIN(rect->minx, other->minx);
+  rect->miny = MS_MIN(rect->miny, other->miny);
+  rect->maxx = MS_MAX(rect->maxx, other->maxx);
+  rect->maxy = MS_MAX(rect->maxy, other->maxy);
+}
+
+/*
+** Add a label of the cache to the index once it is placed (status MS_TRUE)
+** and its polygon, leader and point are final.
+*/
+void msLabelCacheIndexAddLabel(labelCacheObj *labelcache, int priority, int label)
+{
+  labelCacheMemberObj *cachePtr;
+  rectObj bounds;
+
+  if(!labelcache->index)
+    return;
+
+  cachePtr = &(labelcache->slots[priority].labels[label]);
+  if(!cachePtr->poly)
+    return;
+
+  bounds = cachePtr->poly->bounds;
+  if(cachePtr->leaderline)
+    rectMerge(&bounds, cachePtr->leaderbbox);
+  bounds.minx = MS_MIN(bounds.minx, cachePtr->point.x);
+  bounds.miny = MS_MIN(bounds.miny, cachePtr->point.y);
+  bounds.maxx = MS_MAX(bounds.maxx, cachePtr->point.x);
+  bounds.maxy = MS_MAX(bounds.maxy, cachePtr->point.y);
+
+  labelCacheIndexInsert(labelcache->index, priority, label, MS_FALSE, &bounds);
+}
+
+void msFreeLabelCacheIndex(labelCacheObj *labelcache)
+{
+  labelCacheIndexObj *index = labelcache->index;
+  int i;
+
+  if(!index)
+    return;
+
+  for(i=0; i<index->ncols*index->nrows; i++)
+    msFree(index->cells[i].entries);
+  msFree(index->cells);
+  msFree(index->entries);
+  msFree(index);
+  labelcache->index = NULL;
+}
+
+/*
+** Index the markers of the label cache and the labels already placed, for
+** an image of the map size.
+*/
+int msBuildLabelCacheIndex(mapObj *map)
+{
+  labelCacheObj *labelcache = &(map->labelcache);
+  labelCacheIndexObj *index;
+  int p, i;
+
+  msFreeLabelCacheIndex(labelcache);
+
+  index = (labelCacheIndexObj *) msSmallCalloc(1, sizeof(labelCacheIndexObj));
+  index->ncols = MS_MAX(1, (map->width + LABELCACHE_INDEX_CELLSIZE - 1) / LABELCACHE_INDEX_CELLSIZE);
+  index->nrows = MS_MAX(1, (map->height + LABELCACHE_INDEX_CELLSIZE - 1) / LABELCACHE_INDEX_CELLSIZE);
+  index->cells = (labelCacheIndexCellObj *) msSmallCalloc(index->ncols*index->nrows, sizeof(labelCacheIndexCellObj));
+  labelcache->index = index;
+
+  for(p=0; p<MS_MAX_LABEL_PRIORITY; p++) {
+    labelCacheSlotObj *cacheslot = &(labelcache->slots[p]);
+
+    for(i=0; i<cacheslot->nummarkers; i++)
+      labelCacheIndexInsert(index, p, i, MS_TRUE, &(cacheslot->markers[i].poly->bounds));
+    for(i=0; i<cacheslot->numlabels; i++) {
+      if(cacheslot->labels[i].status == MS_TRUE)
+        msLabelCacheIndexAddLabel(labelcache, p, i);
+    }
+  }
+
+  return MS_SUCCESS;
+}
+
+/*
+** Does the candidate label cachePtr, with polygon poly, collide with the
+** placed label curCachePtr, or duplicate it within mindistance?
+*/
+static int labelCacheMemberCollides(labelCacheMemberObj *cachePtr, shapeObj *poly, labelCacheMemberObj *curCachePtr,
+                                    int mindistance, double label_width)
+{
+  int ll, pp;
+
+  /*
+  ** Note 1: We add the label_size to the mindistance value when comparing because we do want the mindistance
+  ** value between the labels and not only from point to point.
+  **
+  ** Note 2: We only check the first label (could be multiples (RFC 77)) since that is *by far* the most common
+  ** use case. Could change in the future but it's not worth the overhead at this point.
+  */
+  if(mindistance >0  &&
+      (cachePtr->layerindex == curCachePtr->layerindex) &&
+      (cachePtr->classindex == curCachePtr->classindex) &&
+      (cachePtr->labels[0].annotext && curCachePtr->labels[0].annotext &&
+       strcmp(cachePtr->labels[0].annotext, curCachePtr->labels[0].annotext) == 0) &&
+      (msDistancePointToPoint(&(cachePtr->point), &(curCachePtr->point)) <= (mindistance + label_width))) { /* label is a duplicate */
+    return MS_TRUE;
+  }
+
+  if(intersectLabelPolygons(curCachePtr->poly, poly) == MS_TRUE) { /* polys intersect */
+    return MS_TRUE;
+  }
+  if(curCachePtr->leaderline) {
+    /* our poly against rendered leader lines */
+    /* first do a bbox check */
+    if(msRectOverlap(curCachePtr->leaderbbox, &(poly->bounds))) {
+      /* look for intersecting line segments */
+      for(ll=0; ll<poly->numlines; ll++)
+        for(pp=1; pp<poly->line[ll].numpoints; pp++)
+          if(msIntersectSegments(
+                &(poly->line[ll].point[pp-1]),
+                &(poly->line[ll].point[pp]),
+                &(curCachePtr->leaderline->point[0]),
+                &(curCachePtr->leaderline->point[1])) ==  MS_TRUE) {
+            return(MS_TRUE);
+          }
+    }
+
+  }
+  if(cachePtr->leaderline) {
+    /* does our leader intersect current label */
+    /* first do a bbox check */
+    if(msRectOverlap(cachePtr->leaderbbox, &(curCachePtr->poly->bounds))) {
+      /* look for intersecting line segments */
+      for(ll=0; ll<curCachePtr->poly->numlines; ll++)
+        for(pp=1; pp<curCachePtr->poly->line[ll].numpoints; pp++)
+          if(msIntersectSegments(
+                &(curCachePtr->poly->line[ll].point[pp-1]),
+                &(curCachePtr->poly->line[ll].point[pp]),
+                &(cachePtr->leaderline->point[0]),
+                &(cachePtr->leaderline->point[1])) ==  MS_TRUE) {
+            return(MS_TRUE);
+          }
+
+    }
+    if(curCachePtr->leaderline) {
+      /* TODO: check intersection of leader lines, not only bbox test ? */
+      if(msRectOverlap(curCachePtr->leaderbbox, cachePtr->leaderbbox)) {
+        return MS_TRUE;
+      }
+
+    }
+  }
+
+  return MS_FALSE;
+}
+
+/* msTestLabelCacheCollisions() through the label cache index */
+static int testLabelCacheIndexCollisions(labelCacheObj *labelcache, labelCacheMemberObj *cachePtr, shapeObj *poly,
+    int mindistance, double label_width, int current_priority, int current_label, int first_label)
+{
+  labelCacheIndexObj *index = labelcache->index;
+  rectObj rect = poly->bounds;
+  int col, row, mincol, maxcol, minrow, maxrow, k;
+
+  if(cachePtr->leaderline)
+    rectMerge(&rect, cachePtr->leaderbbox);
+  if(mindistance > 0) {
+    rectObj reach;
+    reach.minx = cachePtr->point.x - (mindistance + label_width);
+    reach.miny = cachePtr->point.y - (mindistance + label_width);
+    reach.maxx = cachePtr->point.x + (mindistance + label_width);
+    reach.maxy = cachePtr->point.y + (mindistance + label_width);
+    rectMerge(&rect, &reach);
+  }
+
+  if(++index->query == 0) { /* wrapped around, forget the old marks */
+    for(k=0; k<index->numentries; k++)
+      index->entries[k].query = 0;
+    index->query = 1;
+  }
+
+  mincol = labelCacheIndexCol(index, rect.minx);
+  maxcol = labelCacheIndexCol(index, rect.maxx);
+  minrow = labelCacheIndexRow(index, rect.miny);
+  maxrow = labelCacheIndexRow(index, rect.maxy);
+  for(row=minrow; row<=maxrow; row++) {
+    for(col=mincol; col<=maxcol; col++) {
+      labelCacheIndexCellObj *cell = &(index->cells[row*index->ncols + col]);
+
+      for(k=0; k<cell->numentries; k++) {
+        labelCacheIndexEntryObj *entry = &(index->entries[cell->entries[k]]);
+        labelCacheSlotObj *cacheslot;
+
+        if(entry->query == index->query) continue; /* seen in another cell */
+        entry->query = index->query;
+
+        /* the same members as the scans of msTestLabelCacheCollisions() */
+        if(entry->priority < current_priority) continue;
+        cacheslot = &(labelcache->slots[entry->priority]);
+
+        if(entry->marker) {
+          if(entry->priority == current_priority && current_label == cacheslot->markers[entry->index].id)
+            continue; /* labels can overlap their own marker */
+          if(intersectLabelPolygons(cacheslot->markers[entry->index].poly, poly) == MS_TRUE)
+            return MS_FALSE;
+        } else {
+          labelCacheMemberObj *curCachePtr = &(cacheslot->labels[entry->index]);
+          if(entry->priority == current_priority && entry->index < first_label) continue;
+          if(curCachePtr->status != MS_TRUE) continue;
+          if(labelCacheMemberCollides(cachePtr, poly, curCachePtr, mindistance, label_width))
+            return MS_FALSE;
+        }
+      }
+    }
+  }
+
+  return MS_TRUE;
+}
+
 /* msTestLabelCacheCollisions()
 **
 ** Compares current label against labels already drawn and markers from cache and discards it
@@ -760,7 +1060,7 @@ int msTestLabelCacheCollisions(mapObj *map, labelCacheMemberObj *cachePtr, shape
                                int mindistance, int current_priority, int current_label)
 {
   labelCacheObj *labelcache = &(map->labelcache);
-  int i, p, ll, pp;
+  int i, p, ll;
   double label_width = 0;
   labelCacheMemberObj *curCachePtr=NULL;
 
@@ -781,6 +1081,12 @@ int msTestLabelCacheCollisions(mapObj *map, labelCacheMemberObj *cachePtr, shape
     current_label = -current_label;
   }
 
+  if(mindistance > 0)
+    label_width = poly->bounds.maxx - poly->bounds.minx;
+
+  if(labelcache->index)
+    return testLabelCacheIndexCollisions(labelcache, cachePtr, poly, mindistance, label_width, current_priority, current_label, i);
+
   /* Compare against all rendered markers from this priority level and higher.
   ** Labels can overlap their own marker and markers from lower priority levels
   */
@@ -797,9 +1103,6 @@ int msTestLabelCacheCollisions(mapObj *map, labelCacheMemberObj *cachePtr, shape
     }
   }
 
-  if(mindistance > 0)
-    label_width = poly->bounds.maxx - poly->bounds.minx;
-
   for(p=current_priority; p<MS_MAX_LABEL_PRIORITY; p++) {
     labelCacheSlotObj *cacheslot;
     cacheslot = &(labelcache->slots[p]);
@@ -812,66 +1115,8 @@ int msTestLabelCacheCollisions(mapObj *map, labelCacheMemberObj *cachePtr, shape
         /* skip testing against ourself */
         assert(p!=current_priority || i != current_label);
 
-        /*
-        ** Note 1: We add the label_size to the mindistance value when comparing because we do want the mindistance
-        ** value between the labels and not only from point to point.
-        **
-        ** Note 2: We only check the first label (could be multiples (RFC 77)) since that is *by far* the most common
-        ** use case. Could change in the future but it's not worth the overhead at this point.
-        */
-        if(mindistance >0  &&
-            (cachePtr->layerindex == curCachePtr->layerindex) &&
-            (cachePtr->classindex == curCachePtr->classindex) &&
-            (cachePtr->labels[0].annotext && curCachePtr->labels[0].annotext &&
-             strcmp(cachePtr->labels[0].annotext, curCachePtr->labels[0].annotext) == 0) &&
-            (msDistancePointToPoint(&(cachePtr->point), &(curCachePtr->point)) <= (mindistance + label_width))) { /* label is a duplicate */
+        if(labelCacheMemberCollides(cachePtr, poly, curCachePtr, mindistance, label_width))
           return MS_FALSE;
-        }
-
-        if(intersectLabelPolygons(curCachePtr->poly, poly) == MS_TRUE) { /* polys intersect */
-          return MS_FALSE;
-        }
-        if(curCachePtr->leaderline) {
-          /* our poly against rendered leader lines */
-          /* first do a bbox check */
-          if(msRectOverlap(curCachePtr->leaderbbox, &(poly->bounds))) {
-            /* look for intersecting line segments */
-            for(ll=0; ll<poly->numlines; ll++)
-              for(pp=1; pp<poly->line[ll].numpoints; pp++)
-                if(msIntersectSegments(
-                      &(poly->line[ll].point[pp-1]),
-                      &(poly->line[ll].point[pp]),
-                      &(curCachePtr->leaderline->point[0]),
-                      &(curCachePtr->leaderline->point[1])) ==  MS_TRUE) {
-                  return(MS_FALSE);
-                }
-          }
-
-        }
-        if(cachePtr->leaderline) {
-          /* does our leader intersect current label */
-          /* first do a bbox check */
-          if(msRectOverlap(cachePtr->leaderbbox, &(curCachePtr->poly->bounds))) {
-            /* look for intersecting line segments */
-            for(ll=0; ll<curCachePtr->poly->numlines; ll++)
-              for(pp=1; pp<curCachePtr->poly->line[ll].numpoints; pp++)
-                if(msIntersectSegments(
-                      &(curCachePtr->poly->line[ll].point[pp-1]),
-                      &(curCachePtr->poly->line[ll].point[pp]),
-                      &(cachePtr->leaderline->point[0]),
-                      &(cachePtr->leaderline->point[1])) ==  MS_TRUE) {
-                  return(MS_FALSE);
-                }
-
-          }
-          if(curCachePtr->leaderline) {
-            /* TODO: check intersection of leader lines, not only bbox test ? */
-            if(msRectOverlap(curCachePtr->leaderbbox, cachePtr->leaderbbox)) {
-              return MS_FALSE;
-            }
-
-          }
-        }
       }
     } /* i */
 
@@ -1008,6 +1253,330 @@ int msLoadFontSet(fontSetObj *fontset, mapObj *map)
   return(0);
 }
 
+/*
+** Text extents kept across requests by msGetCachedTruetypeTextBBox(): the
+** bounds and glyph advances a renderer returned for a list of font files, a
+** size and a string. Labels repeat the same strings many times per map and
+** measuring them walks every glyph through FreeType. Entries are found by
+** hash and evicted least recently used first. Text is only kept the second
+** time it is seen, so that one-off strings (ids, numbers) do not flush the
+** rest. The MS_TEXT_CACHE_SIZE environment variable sets how many entries are
+** kept, "0" disables the cache.
+*/
+#define TEXTCACHE_DEFAULT_SIZE 10000
+
+typedef int (*textBBoxFunc)(rendererVTableObj *renderer, char **fonts, int numfonts, double size,
+                            char *string, rectObj *rect, double **advances, int bAdjustBaseline);
+
+typedef struct textCacheEntryObj {
+  unsigned hashval;
+  textBBoxFunc measure; /* getTruetypeTextBBox of the renderer, results differ between renderers */
+  int numfonts;
+  double size;
+  int adjustbaseline;
+  rectObj rect;
+  double *advances; /* NULL if they were not asked for */
+  int numadvances;
+  char *key; /* the font files then the string, '\n' separated */
+  struct textCacheEntryObj *chain; /* next in the same bucket */
+  struct textCacheEntryObj *prev, *next; /* most recently used first */
+} textCacheEntryObj;
+
+static textCacheEntryObj **textCacheBuckets = NULL;
+static unsigned textCacheNumBuckets = 0;
+static unsigned char *textCacheSeen = NULL; /* one bit per hash value seen once */
+static unsigned textCacheNumSeen = 0;
+static textCacheEntryObj *textCacheHead = NULL, *textCacheTail = NULL;
+static int textCacheCount = 0;
+static int textCacheMaxCount = TEXTCACHE_DEFAULT_SIZE;
+static int textCacheConfigured = MS_FALSE;
+static long textCacheHits = 0, textCacheMisses = 0;
+
+static unsigned textCacheHash(char **fonts, int numfonts, const char *string, double size)
+{
+  unsigned h = 5381;
+  const char *c;
+  int i;
+
+  for(i=0; i<numfonts; i++) {
+    for(c = fonts[i]; *c; c++)
+      h = ((h << 5) + h) ^ (unsigned char) *c;
+    h = ((h << 5) + h) ^ '\n';
+  }
+  for(c = string; *c; c++)
+    h = ((h << 5) + h) ^ (unsigned char) *c;
+  h ^= (unsigned)(size * 64);
+  h ^= h >> 16;
+  h *= 0x45d9f3bU;
+  h ^= h >> 16;
+
+  return h;
+}
+
+static int textCacheMatch(textCacheEntryObj *entry, char **fonts, int numfonts, const char *string)
+{
+  const char *key = entry->key;
+  int i;
+  size_t length;
+
+  for(i=0; i<numfonts; i++) {
+    length = strlen(fonts[i]);
+    if(strncmp(key, fonts[i], length) != 0 || key[length] != '\n')
+      return MS_FALSE;
+    key += length + 1;
+  }
+
+  return strcmp(key, string) == 0;
+}
+
+/* the following textCache*() helpers expect TLOCK_TEXTCACHE to be held */
+static int textCacheGetMaxCount(void)
+{
+  if(!textCacheConfigured) {
+    const char *value = getenv("MS_TEXT_CACHE_SIZE");
+    textCacheMaxCount = value ? MS_MAX(atoi(value), 0) : TEXTCACHE_DEFAULT_SIZE;
+    textCacheConfigured = MS_TRUE;
+  }
+  return textCacheMaxCount;
+}
+
+static textCacheEntryObj *textCacheFind(unsigned hashval, textBBoxFunc measure, char **fonts, int numfonts,
+                                        const char *string, double size, int adjustbaseline)
+{
+  textCacheEntryObj *entry;
+
+  if(!textCacheBuckets)
+    return NULL;
+
+  for(entry = textCacheBuckets[hashval & (textCacheNumBuckets-1)]; entry; entry = entry->chain) {
+    if(entry->hashval == hashval && entry->measure == measure && entry->numfonts == numfonts &&
+        entry->size == size && entry->adjustbaseline == adjustbaseline &&
+        textCacheMatch(entry, fonts, numfonts, string))
+      return entry;
+  }
+
+  return NULL;
+}
+
+static void textCacheListRemove(textCacheEntryObj *entry)
+{
+  if(entry->prev) entry->prev->next = entry->next;
+  else textCacheHead = entry->next;
+  if(entry->next) entry->next->prev = entry->prev;
+  else textCacheTail = entry->prev;
+}
+
+static void textCacheListPrepend(textCacheEntryObj *entry)
+{
+  entry->prev = NULL;
+  entry->next = textCacheHead;
+  if(textCacheHead) textCacheHead->prev = entry;
+  else textCacheTail = entry;
+  textCacheHead = entry;
+}
+
+/* unlinks and frees entry */
+static void textCacheRemove(textCacheEntryObj *entry)
+{
+  textCacheEntryObj **link = &textCacheBuckets[entry->hashval & (textCacheNumBuckets-1)];
+
+  while(*link != entry)
+    link = &(*link)->chain;
+  *link = entry->chain;
+  textCacheListRemove(entry);
+  textCacheCount--;
+  free(entry);
+}
+
+static void textCacheFlush(void)
+{
+  textCacheEntryObj *entry, *next;
+
+  for(entry = textCacheHead; entry; entry = next) {
+    next = entry->next;
+    free(entry);
+  }
+  msFree(textCacheBuckets);
+  msFree(textCacheSeen);
+  textCacheBuckets = NULL;
+  textCacheSeen = NULL;
+  textCacheNumBuckets = textCacheNumSeen = 0;
+  textCacheHead = textCacheTail = NULL;
+  textCacheCount = 0;
+}
+
+/*
+** Returns MS_TRUE if the text with this hash value was seen before, and
+** remembers it otherwise. The bits are cleared once an eighth of them are
+** set, which keeps false positives (text kept the first time) rare.
+*/
+static int textCacheSeenBefore(unsigned hashval)
+{
+  unsigned numbits, bit;
+
+  if(!textCacheBuckets) {
+    textCacheNumBuckets = 64;
+    while(textCacheNumBuckets < (unsigned) textCacheMaxCount && textCacheNumBuckets < (1U << 24))
+      textCacheNumBuckets <<= 1;
+    textCacheBuckets = (textCacheEntryObj **) msSmallCalloc(textCacheNumBuckets, sizeof(textCacheEntryObj *));
+    textCacheSeen = (unsigned char *) msSmallCalloc(textCacheNumBuckets * 2, 1); /* 16 bits per bucket */
+    textCacheNumSeen = 0;
+  }
+
+  numbits = textCacheNumBuckets * 16;
+  bit = (hashval >> 8) % numbits; /* the low bits pick the bucket */
+  if(textCacheSeen[bit / 8] & (1 << (bit % 8)))
+    return MS_TRUE;
+
+  if(++textCacheNumSeen > numbits / 8) {
+    memset(textCacheSeen, 0, numbits / 8);
+    textCacheNumSeen = 1;
+  }
+  textCacheSeen[bit / 8] |= (1 << (bit % 8));
+
+  return MS_FALSE;
+}
+
+static void textCacheInsert(textCacheEntryObj *entry)
+{
+  textCacheEntryObj **bucket;
+
+  bucket = &textCacheBuckets[entry->hashval & (textCacheNumBuckets-1)];
+  entry->chain = *bucket;
+  *bucket = entry;
+  textCacheListPrepend(entry);
+  textCacheCount++;
+
+  while(textCacheCount > textCacheMaxCount)
+    textCacheRemove(textCacheTail);
+}
+
+/* one allocation holding the entry, its advances and its key */
+static textCacheEntryObj *textCacheNewEntry(unsigned hashval, textBBoxFunc measure, char **fonts, int numfonts,
+    const char *string, double size, int adjustbaseline, rectObj *rect, double *advances)
+{
+  textCacheEntryObj *entry;
+  size_t length = strlen(string) + 1, offset = 0;
+  int i, numadvances = advances ? msGetNumGlyphs(string) : 0;
+  char *key;
+
+  for(i=0; i<numfonts; i++)
+    length += strlen(fonts[i]) + 1;
+  entry = (textCacheEntryObj *) msSmallMalloc(sizeof(textCacheEntryObj) + numadvances * sizeof(double) + length);
+  entry->hashval = hashval;
+  entry->measure = measure;
+  entry->numfonts = numfonts;
+  entry->size = size;
+  entry->adjustbaseline = adjustbaseline;
+  entry->rect = *rect;
+  entry->numadvances = numadvances;
+  entry->advances = NULL;
+  if(advances) {
+    /* renderers return at least one advance per glyph */
+    entry->advances = (double *) (entry + 1);
+    memcpy(entry->advances, advances, numadvances * sizeof(double));
+  }
+
+  key = entry->key = (char *) (entry + 1) + numadvances * sizeof(double);
+  for(i=0; i<numfonts; i++) {
+    strcpy(key + offset, fonts[i]);
+    offset += strlen(fonts[i]);
+    key[offset++] = '\n';
+  }
+  strcpy(key + offset, string);
+
+  return entry;
+}
+
+/*
+** Same as renderer->getTruetypeTextBBox() (fonts are font files), answered
+** from the text cache when the same text was measured before.
+*/
+int msGetCachedTruetypeTextBBox(rendererVTableObj *renderer, char **fonts, int numfonts, double size,
+                                char *string, rectObj *rect, double **advances, int bAdjustBaseline)
+{
+  textCacheEntryObj *entry;
+  unsigned hashval;
+  int status;
+
+  hashval = textCacheHash(fonts, numfonts, string, size);
+
+  msAcquireLock(TLOCK_TEXTCACHE);
+  if(textCacheGetMaxCount() == 0) {
+    msReleaseLock(TLOCK_TEXTCACHE);
+    return renderer->getTruetypeTextBBox(renderer, fonts, numfonts, size, string, rect, advances, bAdjustBaseline);
+  }
+  entry = textCacheFind(hashval, renderer->getTruetypeTextBBox, fonts, numfonts, string, size, bAdjustBaseline);
+  if(entry && (!advances || entry->advances)) {
+    *rect = entry->rect;
+    if(advances) {
+      *advances = (double *) msSmallMalloc(MS_MAX(entry->numadvances, 1) * sizeof(double));
+      memcpy(*advances, entry->advances, entry->numadvances * sizeof(double));
+    }
+    if(entry != textCacheHead) {
+      textCacheListRemove(entry);
+      textCacheListPrepend(entry);
+    }
+    textCacheHits++;
+    msReleaseLock(TLOCK_TEXTCACHE);
+    return MS_SUCCESS;
+  }
+  textCacheMisses++;
+  msReleaseLock(TLOCK_TEXTCACHE);
+
+  status = renderer->getTruetypeTextBBox(renderer, fonts, numfonts, size, string, rect, advances, bAdjustBaseline);
+  if(status != MS_SUCCESS)
+    return status;
+
+  msAcquireLock(TLOCK_TEXTCACHE);
+  if(textCacheGetMaxCount() > 0 && (entry || textCacheSeenBefore(hashval))) {
+    /* entry lacks the advances, another thread may also have measured the text meanwhile */
+    entry = textCacheFind(hashval, renderer->getTruetypeTextBBox, fonts, numfonts, string, size, bAdjustBaseline);
+    if(entry)
+      textCacheRemove(entry);
+    textCacheInsert(textCacheNewEntry(hashval, renderer->getTruetypeTextBBox, fonts, numfonts, string, size,
+                                      bAdjustBaseline, rect, advances ? *advances : NULL));
+  }
+  msReleaseLock(TLOCK_TEXTCACHE);
+
+  return status;
+}
+
+void msGetTextCacheStats(long *hits, long *misses, int *count)
+{
+  msAcquireLock(TLOCK_TEXTCACHE);
+  *hits = textCacheHits;
+  *misses = textCacheMisses;
+  *count = textCacheCount;
+  msReleaseLock(TLOCK_TEXTCACHE);
+}
+
+/*
+** Set the number of text extents kept by msGetCachedTruetypeTextBBox(),
+** "0" disables the cache and frees everything it holds. For programs
+** embedding MapServer, this overrides MS_TEXT_CACHE_SIZE.
+*/
+void msSetTextCacheSize(const char *value)
+{
+  msAcquireLock(TLOCK_TEXTCACHE);
+  textCacheMaxCount = value ? MS_MAX(atoi(value), 0) : 0;
+  textCacheConfigured = MS_TRUE;
+  if(textCacheMaxCount == 0)
+    textCacheFlush();
+  while(textCacheCount > textCacheMaxCount)
+    textCacheRemove(textCacheTail);
+  msReleaseLock(TLOCK_TEXTCACHE);
+}
+
+void msTextCacheCleanup(void)
+{
+  msAcquireLock(TLOCK_TEXTCACHE);
+  textCacheFlush();
+  textCacheConfigured = MS_FALSE;
+  textCacheHits = textCacheMisses = 0;
+  msReleaseLock(TLOCK_TEXTCACHE);
+}
+
 int msGetTruetypeTextBBox(rendererVTableObj *renderer, char* fontstring, fontSetObj *fontset,
                           double size, char *string, rectObj *rect, double **advances, int bAdjustbaseline)
 {
@@ -1025,7 +1594,7 @@ int msGetTruetypeTextBBox(rendererVTableObj *renderer, char* fontstring, fontSet
   }
   if(MS_FAILURE == msFontsetLookupFonts(fontstring, &numfonts, fontset, lookedUpFonts))
     goto tt_cleanup;
-  ret = renderer->getTruetypeTextBBox(renderer,lookedUpFonts,numfonts,size,string,rect,advances,bAdjustbaseline);
+  ret = msGetCachedTruetypeTextBBox(renderer,lookedUpFonts,numfonts,size,string,rect,advances,bAdjustbaseline);
 tt_cleanup:
   if(format) {
     msFreeOutputFormat(format);
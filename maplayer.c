@@ -341,6 +341,7 @@ void msLayerClose(layerObj *layer)
 
   /* no need for items once the layer is closed */
   msLayerFreeItemInfo(layer);
+  msLayerFreeClassLookup(layer);
   if(layer->items) {
     msFreeCharArray(layer->items, layer->numitems);
     layer->items = NULL;
@@ -474,28 +475,24 @@ static int string2list(char **list, int *listsize, char *string)
   return(i);
 }
 
-extern int msyylex(void);
-extern int msyylex_destroy(void);
-
-extern int msyystate;
-extern char *msyystring; /* string to tokenize */
-
-extern double msyynumber; /* token containers */
-extern char *msyystring_buffer;
+extern int msyylex(void *scanner); /* lexer, see maplexer.l */
 
 int msTokenizeExpression(expressionObj *expression, char **list, int *listsize)
 {
   tokenListNodeObjPtr node;
   int token;
+  lexerObj lexer;
 
   /* TODO: make sure the constants can't somehow reference invalid expression types */
   /* if(expression->type != MS_EXPRESSION && expression->type != MS_GEOMTRANSFORM_EXPRESSION) return MS_SUCCESS; */
 
-  msAcquireLock(TLOCK_PARSER);
-  msyystate = MS_TOKENIZE_EXPRESSION;
-  msyystring = expression->string; /* the thing we're tokenizing */
+  msFreeExpressionProgram(expression); /* the token list is about to change */
 
-  while((token = msyylex()) != 0) { /* keep processing tokens until the end of the string (\0) */
+  if(msInitLexer(&lexer) != MS_SUCCESS) return MS_FAILURE;
+  lexer.state = MS_TOKENIZE_EXPRESSION;
+  lexer.string = expression->string; /* the thing we're tokenizing */
+
+  while((token = msyylex(lexer.scanner)) != 0) { /* keep processing tokens until the end of the string (\0) */
 
     if((node = (tokenListNodeObjPtr) malloc(sizeof(tokenListNodeObj))) == NULL) {
       msSetError(MS_MEMERR, NULL, "msTokenizeExpression()");
@@ -508,16 +505,16 @@ int msTokenizeExpression(expressionObj *expression, char **list, int *listsize)
     switch(token) {
       case MS_TOKEN_LITERAL_NUMBER:
         node->token = token;
-        node->tokenval.dblval = msyynumber;
+        node->tokenval.dblval = lexer.number;
         break;
       case MS_TOKEN_LITERAL_STRING:
         node->token = token;
-        node->tokenval.strval = msStrdup(msyystring_buffer);
+        node->tokenval.strval = msStrdup(lexer.string_buffer);
         break;
       case MS_TOKEN_LITERAL_TIME:
         node->token = token;
         msTimeInit(&(node->tokenval.tmval));
-        if(msParseTime(msyystring_buffer, &(node->tokenval.tmval)) != MS_TRUE) {
+        if(msParseTime(lexer.string_buffer, &(node->tokenval.tmval)) != MS_TRUE) {
           msSetError(MS_PARSEERR, "Parsing time value failed.", "msTokenizeExpression()");
           goto parse_error;
         }
@@ -527,8 +524,8 @@ int msTokenizeExpression(expressionObj *expression, char **list, int *listsize)
       case MS_TOKEN_BINDING_STRING:
       case MS_TOKEN_BINDING_TIME:
         node->token = token; /* binding type */
-        node->tokenval.bindval.item = msStrdup(msyystring_buffer);
-        if(list) node->tokenval.bindval.index = string2list(list, listsize, msyystring_buffer);
+        node->tokenval.bindval.item = msStrdup(lexer.string_buffer);
+        if(list) node->tokenval.bindval.index = string2list(list, listsize, lexer.string_buffer);
         break;
       case MS_TOKEN_BINDING_SHAPE:
         node->token = token;
@@ -540,18 +537,18 @@ int msTokenizeExpression(expressionObj *expression, char **list, int *listsize)
         node->token = token;
         break;        
       case MS_TOKEN_FUNCTION_FROMTEXT: /* we want to process a shape from WKT once and not for every feature being evaluated */
-        if((token = msyylex()) != 40) { /* ( */
+        if((token = msyylex(lexer.scanner)) != 40) { /* ( */
           msSetError(MS_PARSEERR, "Parsing fromText function failed.", "msTokenizeExpression()");
           goto parse_error;
         }
 
-        if((token = msyylex()) != MS_TOKEN_LITERAL_STRING) {
+        if((token = msyylex(lexer.scanner)) != MS_TOKEN_LITERAL_STRING) {
           msSetError(MS_PARSEERR, "Parsing fromText function failed.", "msTokenizeExpression()");
           goto parse_error;
         }
 
         node->token = MS_TOKEN_LITERAL_SHAPE;
-        node->tokenval.shpval = msShapeFromWKT(msyystring_buffer);
+        node->tokenval.shpval = msShapeFromWKT(lexer.string_buffer);
 
         if(!node->tokenval.shpval) {
           msSetError(MS_PARSEERR, "Parsing fromText function failed, WKT processing failed.", "msTokenizeExpression()");
@@ -560,7 +557,7 @@ int msTokenizeExpression(expressionObj *expression, char **list, int *listsize)
 
         /* todo: perhaps process optional args (e.g. projection) */
 
-        if((token = msyylex()) != 41) { /* ) */
+        if((token = msyylex(lexer.scanner)) != 41) { /* ) */
           msSetError(MS_PARSEERR, "Parsing fromText function failed.", "msTokenizeExpression()");
           goto parse_error;
         }
@@ -586,11 +583,11 @@ int msTokenizeExpression(expressionObj *expression, char **list, int *listsize)
 
   expression->curtoken = expression->tokens; /* point at the first token */
 
-  msReleaseLock(TLOCK_PARSER);
+  msFreeLexer(&lexer);
   return MS_SUCCESS;
 
 parse_error:
-  msReleaseLock(TLOCK_PARSER);
+  msFreeLexer(&lexer);
   return MS_FAILURE;
 }
 
@@ -778,6 +775,9 @@ int msLayerWhichItems(layerObj *layer, int get_all, char *metadata)
     }
   }
 
+  /* hashed class selection on CLASSITEM, if the classes allow it */
+  msLayerBuildClassLookup(layer);
+
   /* populate the iteminfo array */
   if(layer->numitems == 0)
     return(MS_SUCCESS);
@@ -669,14 +669,14 @@ imageObj *msDrawLegend(mapObj *map, int scale_independent, map_hittest *hittest)
     class_hittest *ch = NULL;
 
     /* set the scale factor so that scale dependant symbols are drawn in the legend with their default size */
-    if(map->layers[cur->layerindex]->sizeunits != MS_PIXELS) {
+    if(GET_LAYER(map, cur->layerindex)->sizeunits != MS_PIXELS) {
       map->cellsize = msAdjustExtent(&(map->extent), map->width, map->height);
-      map->layers[cur->layerindex]->scalefactor = (msInchesPerUnit(map->layers[cur->layerindex]->sizeunits,0)/msInchesPerUnit(map->units,0)) / map->cellsize;
+      GET_LAYER(map, cur->layerindex)->scalefactor = (msInchesPerUnit(GET_LAYER(map, cur->layerindex)->sizeunits,0)/msInchesPerUnit(map->units,0)) / map->cellsize;
     }
     if(hittest) {
       ch = &hittest->layerhits[cur->layerindex].classhits[cur->classindex];
     }
-    if(msDrawLegendIcon(map, map->layers[cur->layerindex], map->layers[cur->layerindex]->class[cur->classindex],  map->legend.keysizex,  map->legend.keysizey, image, HMARGIN, (int) pnt.y, scale_independent, ch) != MS_SUCCESS)
+    if(msDrawLegendIcon(map, GET_LAYER(map, cur->layerindex), GET_LAYER(map, cur->layerindex)->class[cur->classindex],  map->legend.keysizex,  map->legend.keysizey, image, HMARGIN, (int) pnt.y, scale_independent, ch) != MS_SUCCESS)
       return NULL;
 
     /*
@@ -6,25 +6,6 @@
 
 /* A lexical scanner generated by flex */
 
-#define yy_create_buffer msyy_create_buffer
-#define yy_delete_buffer msyy_delete_buffer
-#define yy_flex_debug msyy_flex_debug
-#define yy_init_buffer msyy_init_buffer
-#define yy_flush_buffer msyy_flush_buffer
-#define yy_load_buffer_state msyy_load_buffer_state
-#define yy_switch_to_buffer msyy_switch_to_buffer
-#define yyin msyyin
-#define yyleng msyyleng
-#define yylex msyylex
-#define yylineno msyylineno
-#define yyout msyyout
-#define yyrestart msyyrestart
-#define yytext msyytext
-#define yywrap msyywrap
-#define yyalloc msyyalloc
-#define yyrealloc msyyrealloc
-#define yyfree msyyfree
-
 #define FLEX_SCANNER
 #define YY_FLEX_MAJOR_VERSION 2
 #define YY_FLEX_MINOR_VERSION 5
@@ -138,24 +119,41 @@ typedef unsigned int flex_uint32_t;
  */
 #define YY_SC_TO_UI(c) ((unsigned int) (unsigned char) c)
 
+/* An opaque pointer. */
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
+
+/* For convenience, these vars (plus the bison vars far below)
+   are macros in the reentrant scanner. */
+#define yyin yyg->yyin_r
+#define yyout yyg->yyout_r
+#define yyextra yyg->yyextra_r
+#define yyleng yyg->yyleng_r
+#define yytext yyg->yytext_r
+#define yylineno (YY_CURRENT_BUFFER_LVALUE->yy_bs_lineno)
+#define yycolumn (YY_CURRENT_BUFFER_LVALUE->yy_bs_column)
+#define yy_flex_debug yyg->yy_flex_debug_r
+
 /* Enter a start condition.  This macro really ought to take a parameter,
  * but we do it the disgusting crufty way forced on us by the ()-less
  * definition of BEGIN.
  */
-#define BEGIN (yy_start) = 1 + 2 *
+#define BEGIN yyg->yy_start = 1 + 2 *
 
 /* Translate the current start state into a value that can be later handed
  * to BEGIN to return to the state.  The YYSTATE alias is for lex
  * compatibility.
  */
-#define YY_START (((yy_start) - 1) / 2)
+#define YY_START ((yyg->yy_start - 1) / 2)
 #define YYSTATE YY_START
 
 /* Action number for EOF rule of a given start state. */
 #define YY_STATE_EOF(state) (YY_END_OF_BUFFER + state + 1)
 
 /* Special action meaning "start processing a new file". */
-#define YY_NEW_FILE msyyrestart(msyyin  )
+#define YY_NEW_FILE msyyrestart(yyin ,yyscanner )
 
 #define YY_END_OF_BUFFER_CHAR 0
 
@@ -181,10 +179,6 @@ typedef unsigned int flex_uint32_t;
 typedef struct yy_buffer_state *YY_BUFFER_STATE;
 #endif
 
-extern int msyyleng;
-
-extern FILE *msyyin, *msyyout;
-
 #define EOB_ACT_CONTINUE_SCAN 0
 #define EOB_ACT_END_OF_FILE 1
 #define EOB_ACT_LAST_MATCH 2
@@ -195,17 +189,17 @@ extern FILE *msyyin, *msyyout;
 #define yyless(n) \
 	do \
 		{ \
-		/* Undo effects of setting up msyytext. */ \
+		/* Undo effects of setting up yytext. */ \
         int yyless_macro_arg = (n); \
         YY_LESS_LINENO(yyless_macro_arg);\
-		*yy_cp = (yy_hold_char); \
+		*yy_cp = yyg->yy_hold_char; \
 		YY_RESTORE_YY_MORE_OFFSET \
-		(yy_c_buf_p) = yy_cp = yy_bp + yyless_macro_arg - YY_MORE_ADJ; \
-		YY_DO_BEFORE_ACTION; /* set up msyytext again */ \
+		yyg->yy_c_buf_p = yy_cp = yy_bp + yyless_macro_arg - YY_MORE_ADJ; \
+		YY_DO_BEFORE_ACTION; /* set up yytext again */ \
 		} \
 	while ( 0 )
 
-#define unput(c) yyunput( c, (yytext_ptr)  )
+#define unput(c) yyunput( c, yyg->yytext_ptr , yyscanner )
 
 #ifndef YY_TYPEDEF_YY_SIZE_T
 #define YY_TYPEDEF_YY_SIZE_T
@@ -270,78 +264,58 @@ struct yy_buffer_state
 	 *
 	 * When we actually see the EOF, we change the status to "new"
 	 * (via msyyrestart()), so that the user can continue scanning by
-	 * just pointing msyyin at a new input file.
+	 * just pointing yyin at a new input file.
 	 */
 #define YY_BUFFER_EOF_PENDING 2
 
 	};
 #endif /* !YY_STRUCT_YY_BUFFER_STATE */
 
-/* Stack of input buffers. */
-static size_t yy_buffer_stack_top = 0; /**< index of top of stack. */
-static size_t yy_buffer_stack_max = 0; /**< capacity of stack. */
-static YY_BUFFER_STATE * yy_buffer_stack = 0; /**< Stack as an array. */
-
 /* We provide macros for accessing buffer states in case in the
  * future we want to put the buffer states in a more general
  * "scanner state".
  *
  * Returns the top of the stack, or NULL.
  */
-#define YY_CURRENT_BUFFER ( (yy_buffer_stack) \
-                          ? (yy_buffer_stack)[(yy_buffer_stack_top)] \
+#define YY_CURRENT_BUFFER ( yyg->yy_buffer_stack \
+                          ? yyg->yy_buffer_stack[yyg->yy_buffer_stack_top] \
                           : NULL)
 
 /* Same as previous macro, but useful when we know that the buffer stack is not
  * NULL or when we need an lvalue. For internal use only.
  */
-#define YY_CURRENT_BUFFER_LVALUE (yy_buffer_stack)[(yy_buffer_stack_top)]
-
-/* yy_hold_char holds the character lost when msyytext is formed. */
-static char yy_hold_char;
-static int yy_n_chars;		/* number of characters read into yy_ch_buf */
-int msyyleng;
-
-/* Points to current character in buffer. */
-static char *yy_c_buf_p = (char *) 0;
-static int yy_init = 0;		/* whether we need to initialize */
-static int yy_start = 0;	/* start state number */
-
-/* Flag which is used to allow msyywrap()'s to do buffer switches
- * instead of setting up a fresh msyyin.  A bit of a hack ...
- */
-static int yy_did_buffer_switch_on_eof;
+#define YY_CURRENT_BUFFER_LVALUE yyg->yy_buffer_stack[yyg->yy_buffer_stack_top]
 
-void msyyrestart (FILE *input_file  );
-void msyy_switch_to_buffer (YY_BUFFER_STATE new_buffer  );
-YY_BUFFER_STATE msyy_create_buffer (FILE *file,int size  );
-void msyy_delete_buffer (YY_BUFFER_STATE b  );
-void msyy_flush_buffer (YY_BUFFER_STATE b  );
-void msyypush_buffer_state (YY_BUFFER_STATE new_buffer  );
-void msyypop_buffer_state (void );
+void msyyrestart (FILE *input_file ,yyscan_t yyscanner );
+void msyy_switch_to_buffer (YY_BUFFER_STATE new_buffer ,yyscan_t yyscanner );
+YY_BUFFER_STATE msyy_create_buffer (FILE *file,int size ,yyscan_t yyscanner );
+void msyy_delete_buffer (YY_BUFFER_STATE b ,yyscan_t yyscanner );
+void msyy_flush_buffer (YY_BUFFER_STATE b ,yyscan_t yyscanner );
+void msyypush_buffer_state (YY_BUFFER_STATE new_buffer ,yyscan_t yyscanner );
+void msyypop_buffer_state (yyscan_t yyscanner );
 
-static void msyyensure_buffer_stack (void );
-static void msyy_load_buffer_state (void );
-static void msyy_init_buffer (YY_BUFFER_STATE b,FILE *file  );
+static void msyyensure_buffer_stack (yyscan_t yyscanner );
+static void msyy_load_buffer_state (yyscan_t yyscanner );
+static void msyy_init_buffer (YY_BUFFER_STATE b,FILE *file ,yyscan_t yyscanner );
 
-#define YY_FLUSH_BUFFER msyy_flush_buffer(YY_CURRENT_BUFFER )
+#define YY_FLUSH_BUFFER msyy_flush_buffer(YY_CURRENT_BUFFER ,yyscanner)
 
-YY_BUFFER_STATE msyy_scan_buffer (char *base,yy_size_t size  );
-YY_BUFFER_STATE msyy_scan_string (yyconst char *yy_str  );
-YY_BUFFER_STATE msyy_scan_bytes (yyconst char *bytes,int len  );
+YY_BUFFER_STATE msyy_scan_buffer (char *base,yy_size_t size ,yyscan_t yyscanner );
+YY_BUFFER_STATE msyy_scan_string (yyconst char *yy_str ,yyscan_t yyscanner );
+YY_BUFFER_STATE msyy_scan_bytes (yyconst char *bytes,int len ,yyscan_t yyscanner );
 
-void *msyyalloc (yy_size_t  );
-void *msyyrealloc (void *,yy_size_t  );
-void msyyfree (void *  );
+void *msyyalloc (yy_size_t ,yyscan_t yyscanner );
+void *msyyrealloc (void *,yy_size_t ,yyscan_t yyscanner );
+void msyyfree (void * ,yyscan_t yyscanner );
 
 #define yy_new_buffer msyy_create_buffer
 
 #define yy_set_interactive(is_interactive) \
 	{ \
 	if ( ! YY_CURRENT_BUFFER ){ \
-        msyyensure_buffer_stack (); \
+        msyyensure_buffer_stack (yyscanner); \
 		YY_CURRENT_BUFFER_LVALUE =    \
-            msyy_create_buffer(msyyin,YY_BUF_SIZE ); \
+            msyy_create_buffer(yyin,YY_BUF_SIZE ,yyscanner); \
 	} \
 	YY_CURRENT_BUFFER_LVALUE->yy_is_interactive = is_interactive; \
 	}
@@ -349,9 +323,9 @@ void msyyfree (void *  );
 #define yy_set_bol(at_bol) \
 	{ \
 	if ( ! YY_CURRENT_BUFFER ){\
-        msyyensure_buffer_stack (); \
+        msyyensure_buffer_stack (yyscanner); \
 		YY_CURRENT_BUFFER_LVALUE =    \
-            msyy_create_buffer(msyyin,YY_BUF_SIZE ); \
+            msyy_create_buffer(yyin,YY_BUF_SIZE ,yyscanner); \
 	} \
 	YY_CURRENT_BUFFER_LVALUE->yy_at_bol = at_bol; \
 	}
@@ -362,31 +336,24 @@ void msyyfree (void *  );
 
 typedef unsigned char YY_CHAR;
 
-FILE *msyyin = (FILE *) 0, *msyyout = (FILE *) 0;
-
 typedef int yy_state_type;
 
-extern int msyylineno;
+#define yytext_ptr yytext_r
 
-int msyylineno = 1;
-
-extern char *msyytext;
-#define yytext_ptr msyytext
-
-static yy_state_type yy_get_previous_state (void );
-static yy_state_type yy_try_NUL_trans (yy_state_type current_state  );
-static int yy_get_next_buffer (void );
-static void yy_fatal_error (yyconst char msg[]  );
+static yy_state_type yy_get_previous_state (yyscan_t yyscanner );
+static yy_state_type yy_try_NUL_trans (yy_state_type current_state  ,yyscan_t yyscanner);
+static int yy_get_next_buffer (yyscan_t yyscanner );
+static void yy_fatal_error (yyconst char msg[] ,yyscan_t yyscanner );
 
 /* Done after the current pattern has been matched and before the
- * corresponding action - sets up msyytext.
+ * corresponding action - sets up yytext.
  */
 #define YY_DO_BEFORE_ACTION \
-	(yytext_ptr) = yy_bp; \
-	msyyleng = (size_t) (yy_cp - yy_bp); \
-	(yy_hold_char) = *yy_cp; \
+	yyg->yytext_ptr = yy_bp; \
+	yyleng = (size_t) (yy_cp - yy_bp); \
+	yyg->yy_hold_char = *yy_cp; \
 	*yy_cp = '\0'; \
-	(yy_c_buf_p) = yy_cp;
+	yyg->yy_c_buf_p = yy_cp;
 
 #define YY_NUM_RULES 333
 #define YY_END_OF_BUFFER 334
@@ -2092,12 +2059,6 @@ static yyconst flex_int16_t yy_chk[4493] =
 
     } ;
 
-static yy_state_type yy_last_accepting_state;
-static char *yy_last_accepting_cpos;
-
-extern int msyy_flex_debug;
-int msyy_flex_debug = 0;
-
 /* The intent behind this definition is that it'll catch
  * any uses of REJECT which flex missed.
  */
@@ -2105,7 +2066,6 @@ int msyy_flex_debug = 0;
 #define yymore() yymore_used_but_not_detected
 #define YY_MORE_ADJ 0
 #define YY_RESTORE_YY_MORE_OFFSET
-char *msyytext;
 #line 1 "/home/even/mapserver/git/mapserver/maplexer.l"
 #line 2 "/home/even/mapserver/git/mapserver/maplexer.l"
 /*
@@ -2133,62 +2093,33 @@ char *msyytext;
 #include "mapparser.h"
 #include "mapprimitive.h"
 
-/* msyylineno is required for flex 2.5.4 and older, but is already defined by
- * flex 2.5.31 (bug 975).
- * Unfortunately there is no clean way to differenciate the two versions,
- * so we use the symbol YY_CURRENT_BUFFER_LVALUE to base our test since it
- * was not present in 2.5.4 and is present in 2.5.31. Hopefully that won't
- * put us in trouble with other versions. If that happens then we can
- * switch to using autoconf to detect the version.
- */
-#ifndef YY_CURRENT_BUFFER_LVALUE
-int msyylineno = 1;
-#endif
-
-int msyysource=MS_STRING_TOKENS;
-double msyynumber;
-int msyystate=MS_TOKENIZE_DEFAULT;
-char *msyystring=NULL;
-char *msyybasepath=NULL;
-char *msyystring_buffer_ptr;
-int  msyystring_buffer_size = 256;
-int  msyystring_size;
-char msyystring_begin;
-char *msyystring_buffer = NULL;
-int  msyystring_icase = MS_FALSE;
-int  msyystring_return_state;
-int  msyystring_begin_state;
-int  msyystring_size_tmp;
-
-int msyyreturncomments = 0;
+/*
+** The scanner is reentrant: all of its state, and the token containers the
+** mapfile, symbolset and expression readers look at, live in the lexerObj
+** (yyextra) of each scanner, see msInitLexer().
+*/
 
 #define MS_LEXER_STRING_REALLOC(string, string_size, max_size, string_ptr)   \
    if (string_size >= max_size) {         \
-       msyystring_size_tmp = max_size;     \
+       lexer->string_size_tmp = max_size;     \
        max_size = ((max_size*2) > string_size) ? max_size*2 : string_size+1;                     \
        string = (char *) msSmallRealloc(string, sizeof(char *) * max_size);  \
        string_ptr = string;    \
-       string_ptr += msyystring_size_tmp; \
+       string_ptr += lexer->string_size_tmp; \
    }
 
 #define MS_LEXER_RETURN_TOKEN(token) \
-   MS_LEXER_STRING_REALLOC(msyystring_buffer, strlen(msyytext),  \
-                           msyystring_buffer_size, msyystring_buffer_ptr); \
-   strcpy(msyystring_buffer, msyytext); \
+   MS_LEXER_STRING_REALLOC(lexer->string_buffer, strlen(yytext),  \
+                           lexer->string_buffer_size, lexer->string_buffer_ptr); \
+   strcpy(lexer->string_buffer, yytext); \
    return(token); 
 
-#define MAX_INCLUDE_DEPTH 5
-YY_BUFFER_STATE include_stack[MAX_INCLUDE_DEPTH];
-int include_lineno[MAX_INCLUDE_DEPTH];
-int include_stack_ptr = 0;
-char path[MS_MAXPATHLEN];
-
 
 
 
 
 
-#line 2192 "/home/even/mapserver/git/mapserver/maplexer.c"
+#line 2123 "/home/even/mapserver/git/mapserver/maplexer.c"
 
 #define INITIAL 0
 #define URL_VARIABLE 1
@@ -2197,40 +2128,76 @@ char path[MS_MAXPATHLEN];
 #define INCLUDE 4
 #define MSSTRING 5
 
-#ifndef YY_EXTRA_TYPE
-#define YY_EXTRA_TYPE void *
-#endif
+#define YY_EXTRA_TYPE lexerObj *
+
+/* Holds the entire state of the reentrant scanner. */
+struct yyguts_t
+    {
 
-static int yy_init_globals (void );
+    /* User-defined. Not touched by flex. */
+    YY_EXTRA_TYPE yyextra_r;
+
+    /* The rest are the same as the globals declared in the non-reentrant scanner. */
+    FILE *yyin_r, *yyout_r;
+    size_t yy_buffer_stack_top; /**< index of top of stack. */
+    size_t yy_buffer_stack_max; /**< capacity of stack. */
+    YY_BUFFER_STATE * yy_buffer_stack; /**< Stack as an array. */
+    char yy_hold_char;
+    int yy_n_chars;
+    int yyleng_r;
+    char *yy_c_buf_p;
+    int yy_init;
+    int yy_start;
+    int yy_did_buffer_switch_on_eof;
+    int yy_start_stack_ptr;
+    int yy_start_stack_depth;
+    int *yy_start_stack;
+    yy_state_type yy_last_accepting_state;
+    char* yy_last_accepting_cpos;
+
+    int yylineno_r;
+    int yy_flex_debug_r;
+
+    char *yytext_r;
+    int yy_more_flag;
+    int yy_more_len;
+
+    }; /* end struct yyguts_t */
+
+static int yy_init_globals (yyscan_t yyscanner );
+
+int msyylex_init (yyscan_t* scanner);
+
+int msyylex_init_extra (YY_EXTRA_TYPE user_defined,yyscan_t* scanner);
 
 /* Accessor methods to globals.
    These are made visible to non-reentrant scanners for convenience. */
 
-int msyylex_destroy (void );
+int msyylex_destroy (yyscan_t yyscanner );
 
-int msyyget_debug (void );
+int msyyget_debug (yyscan_t yyscanner );
 
-void msyyset_debug (int debug_flag  );
+void msyyset_debug (int debug_flag ,yyscan_t yyscanner );
 
-YY_EXTRA_TYPE msyyget_extra (void );
+YY_EXTRA_TYPE msyyget_extra (yyscan_t yyscanner );
 
-void msyyset_extra (YY_EXTRA_TYPE user_defined  );
+void msyyset_extra (YY_EXTRA_TYPE user_defined ,yyscan_t yyscanner );
 
-FILE *msyyget_in (void );
+FILE *msyyget_in (yyscan_t yyscanner );
 
-void msyyset_in  (FILE * in_str  );
+void msyyset_in  (FILE * in_str ,yyscan_t yyscanner );
 
-FILE *msyyget_out (void );
+FILE *msyyget_out (yyscan_t yyscanner );
 
-void msyyset_out  (FILE * out_str  );
+void msyyset_out  (FILE * out_str ,yyscan_t yyscanner );
 
-int msyyget_leng (void );
+int msyyget_leng (yyscan_t yyscanner );
 
-char *msyyget_text (void );
+char *msyyget_text (yyscan_t yyscanner );
 
-int msyyget_lineno (void );
+int msyyget_lineno (yyscan_t yyscanner );
 
-void msyyset_lineno (int line_number  );
+void msyyset_lineno (int line_number ,yyscan_t yyscanner );
 
 /* Macros after this point can all be overridden by user definitions in
  * section 1.
@@ -2238,28 +2205,28 @@ void msyyset_lineno (int line_number  );
 
 #ifndef YY_SKIP_YYWRAP
 #ifdef __cplusplus
-extern "C" int msyywrap (void );
+extern "C" int msyywrap (yyscan_t yyscanner );
 #else
-extern int msyywrap (void );
+extern int msyywrap (yyscan_t yyscanner );
 #endif
 #endif
 
-    static void yyunput (int c,char *buf_ptr  );
+    static void yyunput (int c,char *buf_ptr  ,yyscan_t yyscanner);
     
 #ifndef yytext_ptr
-static void yy_flex_strncpy (char *,yyconst char *,int );
+static void yy_flex_strncpy (char *,yyconst char *,int ,yyscan_t yyscanner);
 #endif
 
 #ifdef YY_NEED_STRLEN
-static int yy_flex_strlen (yyconst char * );
+static int yy_flex_strlen (yyconst char * ,yyscan_t yyscanner);
 #endif
 
 #ifndef YY_NO_INPUT
 
 #ifdef __cplusplus
-static int yyinput (void );
+static int yyinput (yyscan_t yyscanner );
 #else
-static int input (void );
+static int input (yyscan_t yyscanner );
 #endif
 
 #endif
@@ -2279,7 +2246,7 @@ static int input (void );
 /* This used to be an fputs(), but since the string might contain NUL's,
  * we now use fwrite().
  */
-#define ECHO do { if (fwrite( msyytext, msyyleng, 1, msyyout )) {} } while (0)
+#define ECHO do { if (fwrite( yytext, yyleng, 1, yyout )) {} } while (0)
 #endif
 
 /* Gets input and stuffs it into "buf".  number of characters read, or YY_NULL,
@@ -2292,18 +2259,18 @@ static int input (void );
 		int c = '*'; \
 		size_t n; \
 		for ( n = 0; n < max_size && \
-			     (c = getc( msyyin )) != EOF && c != '\n'; ++n ) \
+			     (c = getc( yyin )) != EOF && c != '\n'; ++n ) \
 			buf[n] = (char) c; \
 		if ( c == '\n' ) \
 			buf[n++] = (char) c; \
-		if ( c == EOF && ferror( msyyin ) ) \
+		if ( c == EOF && ferror( yyin ) ) \
 			YY_FATAL_ERROR( "input in flex scanner failed" ); \
 		result = n; \
 		} \
 	else \
 		{ \
 		errno=0; \
-		while ( (result = fread(buf, 1, max_size, msyyin))==0 && ferror(msyyin)) \
+		while ( (result = fread(buf, 1, max_size, yyin))==0 && ferror(yyin)) \
 			{ \
 			if( errno != EINTR) \
 				{ \
@@ -2311,7 +2278,7 @@ static int input (void );
 				break; \
 				} \
 			errno=0; \
-			clearerr(msyyin); \
+			clearerr(yyin); \
 			} \
 		}\
 \
@@ -2333,7 +2300,7 @@ static int input (void );
 
 /* Report a fatal error. */
 #ifndef YY_FATAL_ERROR
-#define YY_FATAL_ERROR(msg) yy_fatal_error( msg )
+#define YY_FATAL_ERROR(msg) yy_fatal_error( msg , yyscanner)
 #endif
 
 /* end tables serialization structures and prototypes */
@@ -2344,12 +2311,12 @@ static int input (void );
 #ifndef YY_DECL
 #define YY_DECL_IS_OURS 1
 
-extern int msyylex (void);
+extern int msyylex (yyscan_t yyscanner);
 
-#define YY_DECL int msyylex (void)
+#define YY_DECL int msyylex (yyscan_t yyscanner)
 #endif /* !YY_DECL */
 
-/* Code executed at the beginning of each rule, after msyytext and msyyleng
+/* Code executed at the beginning of each rule, after yytext and yyleng
  * have been set up.
  */
 #ifndef YY_USER_ACTION
@@ -2371,130 +2338,132 @@ YY_DECL
 	register yy_state_type yy_current_state;
 	register char *yy_cp, *yy_bp;
 	register int yy_act;
-    
-#line 85 "/home/even/mapserver/git/mapserver/maplexer.l"
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 
-       if (msyystring_buffer == NULL)
-           msyystring_buffer = (char*) msSmallMalloc(sizeof(char) * msyystring_buffer_size);
+#line 60 "/home/even/mapserver/git/mapserver/maplexer.l"
+       lexerObj *lexer = yyextra;
 
-       msyystring_buffer[0] = '\0';
-       msyystring_buffer_size = 0;
-       switch(msyystate) {
+       if (lexer->string_buffer == NULL)
+           lexer->string_buffer = (char*) msSmallMalloc(sizeof(char) * lexer->string_buffer_size);
+
+       lexer->string_buffer[0] = '\0';
+       lexer->string_buffer_size = 0;
+       switch(lexer->state) {
        case(MS_TOKENIZE_DEFAULT):
          break;
        case(MS_TOKENIZE_FILE):
          BEGIN(INITIAL);
-         msyystring_begin_state = INITIAL;
-         msyysource=MS_FILE_TOKENS;
-         msyystate=MS_TOKENIZE_DEFAULT;
-         msyystring=NULL;
-         msyyreturncomments=0;
-         include_stack_ptr=0;
+         lexer->string_begin_state = INITIAL;
+         lexer->source=MS_FILE_TOKENS;
+         lexer->state=MS_TOKENIZE_DEFAULT;
+         lexer->string=NULL;
+         lexer->returncomments=0;
+         lexer->include_stack_ptr=0;
          return(0);
          break;
        case(MS_TOKENIZE_STRING):
          BEGIN(INITIAL);
-         msyystring_begin_state = INITIAL;
-         msyy_delete_buffer(YY_CURRENT_BUFFER);
-         msyy_scan_string(msyystring);
-         msyysource=MS_STRING_TOKENS;
-         msyystate=MS_TOKENIZE_DEFAULT;
-         msyyin=NULL;
-         msyyreturncomments=0;
-         include_stack_ptr=0;
+         lexer->string_begin_state = INITIAL;
+         msyy_delete_buffer(YY_CURRENT_BUFFER, yyscanner);
+         msyy_scan_string(lexer->string, yyscanner);
+         lexer->source=MS_STRING_TOKENS;
+         lexer->state=MS_TOKENIZE_DEFAULT;
+         yyin=NULL;
+         lexer->returncomments=0;
+         lexer->include_stack_ptr=0;
          return(0);
          break;
        case(MS_TOKENIZE_URL_VARIABLE):
          BEGIN(URL_VARIABLE);
-         msyystring_begin_state = URL_VARIABLE;
-         msyy_delete_buffer(YY_CURRENT_BUFFER);
-         msyy_scan_string(msyystring);
-         msyysource=MS_URL_TOKENS;
-         msyystate=MS_TOKENIZE_DEFAULT;
-         msyyreturncomments=0; 
+         lexer->string_begin_state = URL_VARIABLE;
+         msyy_delete_buffer(YY_CURRENT_BUFFER, yyscanner);
+         msyy_scan_string(lexer->string, yyscanner);
+         lexer->source=MS_URL_TOKENS;
+         lexer->state=MS_TOKENIZE_DEFAULT;
+         lexer->returncomments=0; 
          (void) yyunput; /* just to avoid warning about it being unrefed */
          break;
        case(MS_TOKENIZE_URL_STRING):
          BEGIN(URL_STRING);
-         msyystring_begin_state = URL_STRING;
-         msyy_delete_buffer(YY_CURRENT_BUFFER);
-         msyy_scan_string(msyystring);
-         msyysource=MS_URL_TOKENS;
-         msyystate=MS_TOKENIZE_DEFAULT;
-         msyyin=NULL;
-         msyyreturncomments=0; 
+         lexer->string_begin_state = URL_STRING;
+         msyy_delete_buffer(YY_CURRENT_BUFFER, yyscanner);
+         msyy_scan_string(lexer->string, yyscanner);
+         lexer->source=MS_URL_TOKENS;
+         lexer->state=MS_TOKENIZE_DEFAULT;
+         yyin=NULL;
+         lexer->returncomments=0; 
          return(0);
          break;
        case(MS_TOKENIZE_EXPRESSION):
          BEGIN(EXPRESSION_STRING);
-         msyystring_begin_state = EXPRESSION_STRING;
-         msyy_delete_buffer(YY_CURRENT_BUFFER);
-         msyy_scan_string(msyystring);
-         msyystate=MS_TOKENIZE_DEFAULT;
-         msyyreturncomments=0;
+         lexer->string_begin_state = EXPRESSION_STRING;
+         msyy_delete_buffer(YY_CURRENT_BUFFER, yyscanner);
+         msyy_scan_string(lexer->string, yyscanner);
+         lexer->state=MS_TOKENIZE_DEFAULT;
+         lexer->returncomments=0;
          break;
        case(99):
          BEGIN(INITIAL); /* may not need this one */
-         msyystring_begin_state = INITIAL;
-         msyy_delete_buffer(YY_CURRENT_BUFFER);
-         msyystate=MS_TOKENIZE_DEFAULT;
-         msyystring=NULL;
-         msyyreturncomments=0; 
+         lexer->string_begin_state = INITIAL;
+         msyy_delete_buffer(YY_CURRENT_BUFFER, yyscanner);
+         lexer->state=MS_TOKENIZE_DEFAULT;
+         lexer->string=NULL;
+         lexer->returncomments=0; 
          return(0);
          break;
        default:
          break;
        }
 
-#line 2450 "/home/even/mapserver/git/mapserver/maplexer.c"
+#line 2419 "/home/even/mapserver/git/mapserver/maplexer.c"
 
-	if ( !(yy_init) )
+	if ( !yyg->yy_init )
 		{
-		(yy_init) = 1;
+		yyg->yy_init = 1;
 
 #ifdef YY_USER_INIT
 		YY_USER_INIT;
 #endif
 
-		if ( ! (yy_start) )
-			(yy_start) = 1;	/* first start state */
+		if ( ! yyg->yy_start )
+			yyg->yy_start = 1;	/* first start state */
 
-		if ( ! msyyin )
-			msyyin = stdin;
+		if ( ! yyin )
+			yyin = stdin;
 
-		if ( ! msyyout )
-			msyyout = stdout;
+		if ( ! yyout )
+			yyout = stdout;
 
 		if ( ! YY_CURRENT_BUFFER ) {
-			msyyensure_buffer_stack ();
+			msyyensure_buffer_stack (yyscanner);
 			YY_CURRENT_BUFFER_LVALUE =
-				msyy_create_buffer(msyyin,YY_BUF_SIZE );
+				msyy_create_buffer(yyin,YY_BUF_SIZE ,yyscanner);
 		}
 
-		msyy_load_buffer_state( );
+		msyy_load_buffer_state(yyscanner );
 		}
 
 	while ( 1 )		/* loops until end-of-file is reached */
 		{
-		yy_cp = (yy_c_buf_p);
+		yy_cp = yyg->yy_c_buf_p;
 
-		/* Support of msyytext. */
-		*yy_cp = (yy_hold_char);
+		/* Support of yytext. */
+		*yy_cp = yyg->yy_hold_char;
 
 		/* yy_bp points to the position in yy_ch_buf of the start of
 		 * the current run.
 		 */
 		yy_bp = yy_cp;
 
-		yy_current_state = (yy_start);
+		yy_current_state = yyg->yy_start;
 yy_match:
 		do
 			{
 			register YY_CHAR yy_c = yy_ec[YY_SC_TO_UI(*yy_cp)];
 			if ( yy_accept[yy_current_state] )
 				{
-				(yy_last_accepting_state) = yy_current_state;
-				(yy_last_accepting_cpos) = yy_cp;
+				yyg->yy_last_accepting_state = yy_current_state;
+				yyg->yy_last_accepting_cpos = yy_cp;
 				}
 			while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 				{
@@ -2511,8 +2480,8 @@ yy_find_action:
 		yy_act = yy_accept[yy_current_state];
 		if ( yy_act == 0 )
 			{ /* have to back up */
-			yy_cp = (yy_last_accepting_cpos);
-			yy_current_state = (yy_last_accepting_state);
+			yy_cp = yyg->yy_last_accepting_cpos;
+			yy_current_state = yyg->yy_last_accepting_state;
 			yy_act = yy_accept[yy_current_state];
 			}
 
@@ -2524,1577 +2493,1577 @@ do_action:	/* This label is used only to access EOF actions. */
 	{ /* beginning of action switch */
 			case 0: /* must back up */
 			/* undo the effects of YY_DO_BEFORE_ACTION */
-			*yy_cp = (yy_hold_char);
-			yy_cp = (yy_last_accepting_cpos);
-			yy_current_state = (yy_last_accepting_state);
+			*yy_cp = yyg->yy_hold_char;
+			yy_cp = yyg->yy_last_accepting_cpos;
+			yy_current_state = yyg->yy_last_accepting_state;
 			goto yy_find_action;
 
 case 1:
 YY_RULE_SETUP
-#line 158 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 134 "/home/even/mapserver/git/mapserver/maplexer.l"
 ;
 	YY_BREAK
 case 2:
 YY_RULE_SETUP
-#line 160 "/home/even/mapserver/git/mapserver/maplexer.l"
-{ if (msyyreturncomments) return(MS_COMMENT); }
+#line 136 "/home/even/mapserver/git/mapserver/maplexer.l"
+{ if (lexer->returncomments) return(MS_COMMENT); }
 	YY_BREAK
 case 3:
 YY_RULE_SETUP
-#line 162 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 138 "/home/even/mapserver/git/mapserver/maplexer.l"
 ;
 	YY_BREAK
 case 4:
 YY_RULE_SETUP
-#line 164 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 140 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_LOGICAL_OR); }
 	YY_BREAK
 case 5:
 YY_RULE_SETUP
-#line 165 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 141 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_LOGICAL_AND); }
 	YY_BREAK
 case 6:
 YY_RULE_SETUP
-#line 166 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 142 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_LOGICAL_NOT); }
 	YY_BREAK
 case 7:
 YY_RULE_SETUP
-#line 167 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 143 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_EQ); }
 	YY_BREAK
 case 8:
 YY_RULE_SETUP
-#line 168 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 144 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_NE); }
 	YY_BREAK
 case 9:
 YY_RULE_SETUP
-#line 169 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 145 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_GT); }
 	YY_BREAK
 case 10:
 YY_RULE_SETUP
-#line 170 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 146 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_LT); }
 	YY_BREAK
 case 11:
 YY_RULE_SETUP
-#line 171 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 147 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_GE); }
 	YY_BREAK
 case 12:
 YY_RULE_SETUP
-#line 172 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 148 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_LE); }
 	YY_BREAK
 case 13:
 YY_RULE_SETUP
-#line 173 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 149 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_RE); }
 	YY_BREAK
 case 14:
 YY_RULE_SETUP
-#line 175 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 151 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_IEQ); }
 	YY_BREAK
 case 15:
 YY_RULE_SETUP
-#line 176 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 152 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_IRE); }
 	YY_BREAK
 case 16:
 YY_RULE_SETUP
-#line 178 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 154 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(IN); }
 	YY_BREAK
 case 17:
 YY_RULE_SETUP
-#line 180 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 156 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_FUNCTION_AREA); }
 	YY_BREAK
 case 18:
 YY_RULE_SETUP
-#line 181 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 157 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_FUNCTION_LENGTH); }
 	YY_BREAK
 case 19:
 YY_RULE_SETUP
-#line 182 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 158 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_FUNCTION_TOSTRING); }
 	YY_BREAK
 case 20:
 YY_RULE_SETUP
-#line 183 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 159 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_FUNCTION_COMMIFY); }
 	YY_BREAK
 case 21:
 YY_RULE_SETUP
-#line 184 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 160 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_FUNCTION_ROUND); }
 	YY_BREAK
 case 22:
 YY_RULE_SETUP
-#line 186 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 162 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_FUNCTION_BUFFER); }
 	YY_BREAK
 case 23:
 YY_RULE_SETUP
-#line 187 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 163 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_FUNCTION_DIFFERENCE); }
 	YY_BREAK
 case 24:
 YY_RULE_SETUP
-#line 188 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 164 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_FUNCTION_SIMPLIFY); }
 	YY_BREAK
 case 25:
 YY_RULE_SETUP
-#line 189 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 165 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_FUNCTION_SIMPLIFYPT); }
 	YY_BREAK
 case 26:
 YY_RULE_SETUP
-#line 190 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 166 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_FUNCTION_GENERALIZE); }
 	YY_BREAK
 case 27:
 YY_RULE_SETUP
-#line 191 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 167 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_FUNCTION_SMOOTHSIA); }
 	YY_BREAK
 case 28:
 YY_RULE_SETUP
-#line 193 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 169 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_INTERSECTS); }
 	YY_BREAK
 case 29:
 YY_RULE_SETUP
-#line 194 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 170 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_DISJOINT); }
 	YY_BREAK
 case 30:
 YY_RULE_SETUP
-#line 195 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 171 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_TOUCHES); }
 	YY_BREAK
 case 31:
 YY_RULE_SETUP
-#line 196 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 172 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_OVERLAPS); }
 	YY_BREAK
 case 32:
 YY_RULE_SETUP
-#line 197 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 173 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_CROSSES); }
 	YY_BREAK
 case 33:
 YY_RULE_SETUP
-#line 198 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 174 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_WITHIN); }
 	YY_BREAK
 case 34:
 YY_RULE_SETUP
-#line 199 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 175 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_CONTAINS); }
 	YY_BREAK
 case 35:
 YY_RULE_SETUP
-#line 200 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 176 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_BEYOND); }
 	YY_BREAK
 case 36:
 YY_RULE_SETUP
-#line 201 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 177 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_COMPARISON_DWITHIN); }
 	YY_BREAK
 case 37:
 YY_RULE_SETUP
-#line 203 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 179 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TOKEN_FUNCTION_FROMTEXT); }
 	YY_BREAK
 case 38:
 YY_RULE_SETUP
-#line 205 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 181 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(COLORRANGE); }
 	YY_BREAK
 case 39:
 YY_RULE_SETUP
-#line 206 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 182 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(DATARANGE); }
 	YY_BREAK
 case 40:
 YY_RULE_SETUP
-#line 207 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 183 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(RANGEITEM); }
 	YY_BREAK
 case 41:
 YY_RULE_SETUP
-#line 209 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 185 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(ALIGN); }
 	YY_BREAK
 case 42:
 YY_RULE_SETUP
-#line 210 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 186 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(ANCHORPOINT); }
 	YY_BREAK
 case 43:
 YY_RULE_SETUP
-#line 211 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 187 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(ANGLE); }
 	YY_BREAK
 case 44:
 YY_RULE_SETUP
-#line 212 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 188 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(ANTIALIAS); }
 	YY_BREAK
 case 45:
 YY_RULE_SETUP
-#line 213 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 189 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(BACKGROUNDCOLOR); }
 	YY_BREAK
 case 46:
 YY_RULE_SETUP
-#line 214 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 190 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(BANDSITEM); }
 	YY_BREAK
 case 47:
 YY_RULE_SETUP
-#line 215 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 191 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(BINDVALS); }
 	YY_BREAK
 case 48:
 YY_RULE_SETUP
-#line 216 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 192 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(BROWSEFORMAT); }
 	YY_BREAK
 case 49:
 YY_RULE_SETUP
-#line 217 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 193 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(BUFFER); }
 	YY_BREAK
 case 50:
 YY_RULE_SETUP
-#line 218 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 194 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(CHARACTER); }
 	YY_BREAK
 case 51:
 YY_RULE_SETUP
-#line 219 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 195 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(CLASS); }
 	YY_BREAK
 case 52:
 YY_RULE_SETUP
-#line 220 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 196 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(CLASSITEM); }
 	YY_BREAK
 case 53:
 YY_RULE_SETUP
-#line 221 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 197 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(CLASSGROUP); }
 	YY_BREAK
 case 54:
 YY_RULE_SETUP
-#line 222 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 198 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(CLUSTER); }
 	YY_BREAK
 case 55:
 YY_RULE_SETUP
-#line 223 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 199 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(COLOR); }
 	YY_BREAK
 case 56:
 YY_RULE_SETUP
-#line 224 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 200 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(CONFIG); }
 	YY_BREAK
 case 57:
 YY_RULE_SETUP
-#line 225 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 201 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(CONNECTION); }
 	YY_BREAK
 case 58:
 YY_RULE_SETUP
-#line 226 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 202 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(CONNECTIONTYPE); }
 	YY_BREAK
 case 59:
 YY_RULE_SETUP
-#line 227 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 203 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(DATA); }
 	YY_BREAK
 case 60:
 YY_RULE_SETUP
-#line 228 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 204 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(DATAPATTERN); }
 	YY_BREAK
 case 61:
 YY_RULE_SETUP
-#line 229 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 205 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(DEBUG); }
 	YY_BREAK
 case 62:
 YY_RULE_SETUP
-#line 230 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 206 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(DRIVER); }
 	YY_BREAK
 case 63:
 YY_RULE_SETUP
-#line 231 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 207 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(DUMP); }
 	YY_BREAK
 case 64:
 YY_RULE_SETUP
-#line 232 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 208 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(EMPTY); }
 	YY_BREAK
 case 65:
 YY_RULE_SETUP
-#line 233 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 209 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(ENCODING); }
 	YY_BREAK
 case 66:
 YY_RULE_SETUP
-#line 234 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 210 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(END); }
 	YY_BREAK
 case 67:
 YY_RULE_SETUP
-#line 235 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 211 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(ERROR); }
 	YY_BREAK
 case 68:
 YY_RULE_SETUP
-#line 236 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 212 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(EXPRESSION); }
 	YY_BREAK
 case 69:
 YY_RULE_SETUP
-#line 237 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 213 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(EXTENT); }
 	YY_BREAK
 case 70:
 YY_RULE_SETUP
-#line 238 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 214 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(EXTENSION); }
 	YY_BREAK
 case 71:
 YY_RULE_SETUP
-#line 239 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 215 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(FEATURE); }
 	YY_BREAK
 case 72:
 YY_RULE_SETUP
-#line 240 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 216 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(FILLED); }
 	YY_BREAK
 case 73:
 YY_RULE_SETUP
-#line 241 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 217 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(FILTER); }
 	YY_BREAK
 case 74:
 YY_RULE_SETUP
-#line 242 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 218 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(FILTERITEM); }
 	YY_BREAK
 case 75:
 YY_RULE_SETUP
-#line 243 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 219 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(FOOTER); }
 	YY_BREAK
 case 76:
 YY_RULE_SETUP
-#line 244 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 220 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(FONT); }
 	YY_BREAK
 case 77:
 YY_RULE_SETUP
-#line 245 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 221 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(FONTSET); }
 	YY_BREAK
 case 78:
 YY_RULE_SETUP
-#line 246 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 222 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(FORCE); }
 	YY_BREAK
 case 79:
 YY_RULE_SETUP
-#line 247 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 223 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(FORMATOPTION); }
 	YY_BREAK
 case 80:
 YY_RULE_SETUP
-#line 248 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 224 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(FROM); }
 	YY_BREAK
 case 81:
 YY_RULE_SETUP
-#line 249 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 225 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(GAP); }
 	YY_BREAK
 case 82:
 YY_RULE_SETUP
-#line 250 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 226 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(GEOMTRANSFORM); }
 	YY_BREAK
 case 83:
 YY_RULE_SETUP
-#line 251 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 227 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(GRID); }
 	YY_BREAK
 case 84:
 YY_RULE_SETUP
-#line 252 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 228 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(GRIDSTEP); }
 	YY_BREAK
 case 85:
 YY_RULE_SETUP
-#line 253 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 229 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(GRATICULE); }
 	YY_BREAK
 case 86:
 YY_RULE_SETUP
-#line 254 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 230 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(GROUP); }
 	YY_BREAK
 case 87:
 YY_RULE_SETUP
-#line 255 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 231 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(HEADER); }
 	YY_BREAK
 case 88:
 YY_RULE_SETUP
-#line 256 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 232 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(IMAGE); }
 	YY_BREAK
 case 89:
 YY_RULE_SETUP
-#line 257 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 233 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(IMAGECOLOR); }
 	YY_BREAK
 case 90:
 YY_RULE_SETUP
-#line 258 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 234 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(IMAGETYPE); }
 	YY_BREAK
 case 91:
 YY_RULE_SETUP
-#line 259 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 235 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(IMAGEQUALITY); }
 	YY_BREAK
 case 92:
 YY_RULE_SETUP
-#line 260 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 236 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(IMAGEMODE); }
 	YY_BREAK
 case 93:
 YY_RULE_SETUP
-#line 261 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 237 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(IMAGEPATH); }
 	YY_BREAK
 case 94:
 YY_RULE_SETUP
-#line 262 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 238 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(TEMPPATH); }
 	YY_BREAK
 case 95:
 YY_RULE_SETUP
-#line 263 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 239 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(IMAGEURL); }
 	YY_BREAK
 case 96:
 YY_RULE_SETUP
-#line 264 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 240 "/home/even/mapserver/git/mapserver/maplexer.l"
 { BEGIN(INCLUDE); }
 	YY_BREAK
 case 97:
 YY_RULE_SETUP
-#line 265 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 241 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(INDEX); }
 	YY_BREAK
 case 98:
 YY_RULE_SETUP
-#line 266 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 242 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(INITIALGAP); }
 	YY_BREAK
 case 99:
 YY_RULE_SETUP
-#line 267 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 243 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(INTERLACE); }
 	YY_BREAK
 case 100:
 YY_RULE_SETUP
-#line 268 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 244 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(INTERVALS); } 
 	YY_BREAK
 case 101:
 YY_RULE_SETUP
-#line 269 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 245 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(JOIN); }
 	YY_BREAK
 case 102:
 YY_RULE_SETUP
-#line 270 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 246 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(KEYIMAGE); }
 	YY_BREAK
 case 103:
 YY_RULE_SETUP
-#line 271 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 247 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(KEYSIZE); }
 	YY_BREAK
 case 104:
 YY_RULE_SETUP
-#line 272 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 248 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(KEYSPACING); }
 	YY_BREAK
 case 105:
 YY_RULE_SETUP
-#line 273 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 249 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LABEL); }
 	YY_BREAK
 case 106:
 YY_RULE_SETUP
-#line 274 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 250 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LABELCACHE); }
 	YY_BREAK
 case 107:
 YY_RULE_SETUP
-#line 275 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 251 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LABELFORMAT); }
 	YY_BREAK
 case 108:
 YY_RULE_SETUP
-#line 276 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 252 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LABELITEM); }
 	YY_BREAK
 case 109:
 YY_RULE_SETUP
-#line 277 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 253 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LABELMAXSCALE); }
 	YY_BREAK
 case 110:
 YY_RULE_SETUP
-#line 278 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 254 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LABELMAXSCALEDENOM); }
 	YY_BREAK
 case 111:
 YY_RULE_SETUP
-#line 279 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 255 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LABELMINSCALE); }
 	YY_BREAK
 case 112:
 YY_RULE_SETUP
-#line 280 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 256 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LABELMINSCALEDENOM); }
 	YY_BREAK
 case 113:
 YY_RULE_SETUP
-#line 281 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 257 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LABELREQUIRES); }
 	YY_BREAK
 case 114:
 YY_RULE_SETUP
-#line 282 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 258 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LATLON); }
 	YY_BREAK
 case 115:
 YY_RULE_SETUP
-#line 283 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 259 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LAYER); }
 	YY_BREAK
 case 116:
 YY_RULE_SETUP
-#line 284 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 260 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LEADER); }
 	YY_BREAK
 case 117:
 YY_RULE_SETUP
-#line 285 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 261 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LEGEND); }
 	YY_BREAK
 case 118:
 YY_RULE_SETUP
-#line 286 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 262 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LEGENDFORMAT); }
 	YY_BREAK
 case 119:
 YY_RULE_SETUP
-#line 287 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 263 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LINECAP); }
 	YY_BREAK
 case 120:
 YY_RULE_SETUP
-#line 288 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 264 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LINEJOIN); }
 	YY_BREAK
 case 121:
 YY_RULE_SETUP
-#line 289 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 265 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LINEJOINMAXSIZE); }
 	YY_BREAK
 case 122:
 YY_RULE_SETUP
-#line 290 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 266 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(LOG); }
 	YY_BREAK
 case 123:
 YY_RULE_SETUP
-#line 291 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 267 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MAP); }
 	YY_BREAK
 case 124:
 YY_RULE_SETUP
-#line 292 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 268 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MARKER); }
 	YY_BREAK
 case 125:
 YY_RULE_SETUP
-#line 293 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 269 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MARKERSIZE); }
 	YY_BREAK
 case 126:
 YY_RULE_SETUP
-#line 294 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 270 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MASK); }
 	YY_BREAK
 case 127:
 YY_RULE_SETUP
-#line 295 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 271 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MAXARCS); }
 	YY_BREAK
 case 128:
 YY_RULE_SETUP
-#line 296 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 272 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MAXBOXSIZE); }
 	YY_BREAK
 case 129:
 YY_RULE_SETUP
-#line 297 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 273 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MAXDISTANCE); }
 	YY_BREAK
 case 130:
 YY_RULE_SETUP
-#line 298 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 274 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MAXFEATURES); }
 	YY_BREAK
 case 131:
 YY_RULE_SETUP
-#line 299 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 275 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MAXINTERVAL); }
 	YY_BREAK
 case 132:
 YY_RULE_SETUP
-#line 300 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 276 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MAXSCALE); }
 	YY_BREAK
 case 133:
 YY_RULE_SETUP
-#line 301 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 277 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MAXSCALEDENOM); }
 	YY_BREAK
 case 134:
 YY_RULE_SETUP
-#line 302 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 278 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MAXGEOWIDTH); }
 	YY_BREAK
 case 135:
 YY_RULE_SETUP
-#line 303 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 279 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MAXLENGTH); }
 	YY_BREAK
 case 136:
 YY_RULE_SETUP
-#line 304 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 280 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MAXSIZE); }
 	YY_BREAK
 case 137:
 YY_RULE_SETUP
-#line 305 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 281 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MAXSUBDIVIDE); }
 	YY_BREAK
 case 138:
 YY_RULE_SETUP
-#line 306 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 282 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MAXTEMPLATE); }
 	YY_BREAK
 case 139:
 YY_RULE_SETUP
-#line 307 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 283 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MAXWIDTH); }
 	YY_BREAK
 case 140:
 YY_RULE_SETUP
-#line 308 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 284 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(METADATA); }
 	YY_BREAK
 case 141:
 YY_RULE_SETUP
-#line 309 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 285 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MIMETYPE); }
 	YY_BREAK
 case 142:
 YY_RULE_SETUP
-#line 310 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 286 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MINARCS); }
 	YY_BREAK
 case 143:
 YY_RULE_SETUP
-#line 311 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 287 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MINBOXSIZE); }
 	YY_BREAK
 case 144:
 YY_RULE_SETUP
-#line 312 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 288 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MINDISTANCE); }
 	YY_BREAK
 case 145:
 YY_RULE_SETUP
-#line 313 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 289 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(REPEATDISTANCE); }
 	YY_BREAK
 case 146:
 YY_RULE_SETUP
-#line 314 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 290 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MAXOVERLAPANGLE); } 
 	YY_BREAK
 case 147:
 YY_RULE_SETUP
-#line 315 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 291 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MINFEATURESIZE); }
 	YY_BREAK
 case 148:
 YY_RULE_SETUP
-#line 316 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 292 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MININTERVAL); }
 	YY_BREAK
 case 149:
 YY_RULE_SETUP
-#line 317 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 293 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MINSCALE); }
 	YY_BREAK
 case 150:
 YY_RULE_SETUP
-#line 318 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 294 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MINSCALEDENOM); }
 	YY_BREAK
 case 151:
 YY_RULE_SETUP
-#line 319 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 295 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MINGEOWIDTH); }
 	YY_BREAK
 case 152:
 YY_RULE_SETUP
-#line 320 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 296 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MINLENGTH); }
 	YY_BREAK
 case 153:
 YY_RULE_SETUP
-#line 321 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 297 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MINSIZE); }
 	YY_BREAK
 case 154:
 YY_RULE_SETUP
-#line 322 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 298 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MINSUBDIVIDE); }
 	YY_BREAK
 case 155:
 YY_RULE_SETUP
-#line 323 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 299 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MINTEMPLATE); }
 	YY_BREAK
 case 156:
 YY_RULE_SETUP
-#line 324 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 300 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MINWIDTH); }
 	YY_BREAK
 case 157:
 YY_RULE_SETUP
-#line 325 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 301 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(NAME); }
 	YY_BREAK
 case 158:
 YY_RULE_SETUP
-#line 326 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 302 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(OFFSET); }
 	YY_BREAK
 case 159:
 YY_RULE_SETUP
-#line 327 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 303 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(OFFSITE); }
 	YY_BREAK
 case 160:
 YY_RULE_SETUP
-#line 328 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 304 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(OPACITY); }
 	YY_BREAK
 case 161:
 YY_RULE_SETUP
-#line 329 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 305 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(OUTLINECOLOR); }
 	YY_BREAK
 case 162:
 YY_RULE_SETUP
-#line 330 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 306 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(OUTLINEWIDTH); }
 	YY_BREAK
 case 163:
 YY_RULE_SETUP
-#line 331 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 307 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(OUTPUTFORMAT); }
 	YY_BREAK
 case 164:
 YY_RULE_SETUP
-#line 332 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 308 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(OVERLAYBACKGROUNDCOLOR); }
 	YY_BREAK
 case 165:
 YY_RULE_SETUP
-#line 333 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 309 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(OVERLAYCOLOR); }
 	YY_BREAK
 case 166:
 YY_RULE_SETUP
-#line 334 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 310 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(OVERLAYMAXSIZE); }
 	YY_BREAK
 case 167:
 YY_RULE_SETUP
-#line 335 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 311 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(OVERLAYMINSIZE); }
 	YY_BREAK
 case 168:
 YY_RULE_SETUP
-#line 336 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 312 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(OVERLAYOUTLINECOLOR); }
 	YY_BREAK
 case 169:
 YY_RULE_SETUP
-#line 337 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 313 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(OVERLAYSIZE); }
 	YY_BREAK
 case 170:
 YY_RULE_SETUP
-#line 338 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 314 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(OVERLAYSYMBOL); }
 	YY_BREAK
 case 171:
 YY_RULE_SETUP
-#line 339 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 315 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(PARTIALS); }
 	YY_BREAK
 case 172:
 YY_RULE_SETUP
-#line 340 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 316 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(PATTERN); }
 	YY_BREAK
 case 173:
 YY_RULE_SETUP
-#line 341 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 317 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(POINTS); }
 	YY_BREAK
 case 174:
 YY_RULE_SETUP
-#line 342 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 318 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(ITEMS); }
 	YY_BREAK
 case 175:
 YY_RULE_SETUP
-#line 343 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 319 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(POSITION); }
 	YY_BREAK
 case 176:
 YY_RULE_SETUP
-#line 344 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 320 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(POSTLABELCACHE); }
 	YY_BREAK
 case 177:
 YY_RULE_SETUP
-#line 345 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 321 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(PRIORITY); }
 	YY_BREAK
 case 178:
 YY_RULE_SETUP
-#line 346 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 322 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(PROCESSING); }
 	YY_BREAK
 case 179:
 YY_RULE_SETUP
-#line 347 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 323 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(PROJECTION); }
 	YY_BREAK
 case 180:
 YY_RULE_SETUP
-#line 348 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 324 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(QUERYFORMAT); }
 	YY_BREAK
 case 181:
 YY_RULE_SETUP
-#line 349 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 325 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(QUERYMAP); }
 	YY_BREAK
 case 182:
 YY_RULE_SETUP
-#line 350 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 326 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(REFERENCE); }
 	YY_BREAK
 case 183:
 YY_RULE_SETUP
-#line 351 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 327 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(REGION); }
 	YY_BREAK
 case 184:
 YY_RULE_SETUP
-#line 352 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 328 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(RELATIVETO); }
 	YY_BREAK
 case 185:
 YY_RULE_SETUP
-#line 353 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 329 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(REQUIRES); }
 	YY_BREAK
 case 186:
 YY_RULE_SETUP
-#line 354 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 330 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(RESOLUTION); }
 	YY_BREAK
 case 187:
 YY_RULE_SETUP
-#line 355 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 331 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(DEFRESOLUTION); }
 	YY_BREAK
 case 188:
 YY_RULE_SETUP
-#line 356 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 332 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(SCALE); }
 	YY_BREAK
 case 189:
 YY_RULE_SETUP
-#line 357 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 333 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(SCALEDENOM); }
 	YY_BREAK
 case 190:
 YY_RULE_SETUP
-#line 358 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 334 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(SCALEBAR); }
 	YY_BREAK
 case 191:
 YY_RULE_SETUP
-#line 359 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 335 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(SCALETOKEN); }
 	YY_BREAK
 case 192:
 YY_RULE_SETUP
-#line 360 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 336 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(SHADOWCOLOR); }
 	YY_BREAK
 case 193:
 YY_RULE_SETUP
-#line 361 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 337 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(SHADOWSIZE); }
 	YY_BREAK
 case 194:
 YY_RULE_SETUP
-#line 362 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 338 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(SHAPEPATH); }
 	YY_BREAK
 case 195:
 YY_RULE_SETUP
-#line 363 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 339 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(SIZE); }
 	YY_BREAK
 case 196:
 YY_RULE_SETUP
-#line 364 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 340 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(SIZEUNITS); }
 	YY_BREAK
 case 197:
 YY_RULE_SETUP
-#line 365 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 341 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(STATUS); }
 	YY_BREAK
 case 198:
 YY_RULE_SETUP
-#line 366 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 342 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(STYLE); }
 	YY_BREAK
 case 199:
 YY_RULE_SETUP
-#line 367 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 343 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(STYLEITEM); }
 	YY_BREAK
 case 200:
 YY_RULE_SETUP
-#line 368 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 344 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(SYMBOL); }
 	YY_BREAK
 case 201:
 YY_RULE_SETUP
-#line 369 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 345 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(SYMBOLSCALE); }
 	YY_BREAK
 case 202:
 YY_RULE_SETUP
-#line 370 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 346 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(SYMBOLSCALEDENOM); }
 	YY_BREAK
 case 203:
 YY_RULE_SETUP
-#line 371 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 347 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(SYMBOLSET); }
 	YY_BREAK
 case 204:
 YY_RULE_SETUP
-#line 372 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 348 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(TABLE); }
 	YY_BREAK
 case 205:
 YY_RULE_SETUP
-#line 373 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 349 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(TEMPLATE); }
 	YY_BREAK
 case 206:
 YY_RULE_SETUP
-#line 374 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 350 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(TEMPLATEPATTERN); }
 	YY_BREAK
 case 207:
 YY_RULE_SETUP
-#line 375 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 351 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(TEXT); }
 	YY_BREAK
 case 208:
 YY_RULE_SETUP
-#line 376 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 352 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(TILEINDEX); }
 	YY_BREAK
 case 209:
 YY_RULE_SETUP
-#line 377 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 353 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(TILEITEM); }
 	YY_BREAK
 case 210:
 YY_RULE_SETUP
-#line 378 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 354 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(TILESRS); }
 	YY_BREAK
 case 211:
 YY_RULE_SETUP
-#line 379 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 355 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(TITLE); }
 	YY_BREAK
 case 212:
 YY_RULE_SETUP
-#line 380 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 356 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(TO); }
 	YY_BREAK
 case 213:
 YY_RULE_SETUP
-#line 381 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 357 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(TOLERANCE); }
 	YY_BREAK
 case 214:
 YY_RULE_SETUP
-#line 382 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 358 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(TOLERANCEUNITS); }
 	YY_BREAK
 case 215:
 YY_RULE_SETUP
-#line 383 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 359 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(TRANSPARENCY); }
 	YY_BREAK
 case 216:
 YY_RULE_SETUP
-#line 384 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 360 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(TRANSPARENT); }
 	YY_BREAK
 case 217:
 YY_RULE_SETUP
-#line 385 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 361 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(TRANSFORM); }
 	YY_BREAK
 case 218:
 YY_RULE_SETUP
-#line 386 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 362 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(TYPE); }
 	YY_BREAK
 case 219:
 YY_RULE_SETUP
-#line 387 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 363 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(UNITS); }
 	YY_BREAK
 case 220:
 YY_RULE_SETUP
-#line 388 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 364 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(VALIDATION); }
 	YY_BREAK
 case 221:
 YY_RULE_SETUP
-#line 389 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 365 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(VALUES); }
 	YY_BREAK
 case 222:
 YY_RULE_SETUP
-#line 390 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 366 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(WEB); }
 	YY_BREAK
 case 223:
 YY_RULE_SETUP
-#line 391 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 367 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(WIDTH); }
 	YY_BREAK
 case 224:
 YY_RULE_SETUP
-#line 392 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 368 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(WKT); }
 	YY_BREAK
 case 225:
 YY_RULE_SETUP
-#line 393 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 369 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(WRAP); }
 	YY_BREAK
 case 226:
 YY_RULE_SETUP
-#line 395 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 371 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_LAYER_ANNOTATION); }
 	YY_BREAK
 case 227:
 YY_RULE_SETUP
-#line 396 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 372 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_AUTO); }
 	YY_BREAK
 case 228:
 YY_RULE_SETUP
-#line 397 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 373 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_AUTO2); }
 	YY_BREAK
 case 229:
 YY_RULE_SETUP
-#line 398 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 374 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_CJC_BEVEL); }
 	YY_BREAK
 case 230:
 YY_RULE_SETUP
-#line 399 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 375 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_BITMAP); }
 	YY_BREAK
 case 231:
 YY_RULE_SETUP
-#line 400 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 376 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_CJC_BUTT); }
 	YY_BREAK
 case 232:
 YY_RULE_SETUP
-#line 401 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 377 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_CC); }
 	YY_BREAK
 case 233:
 YY_RULE_SETUP
-#line 402 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 378 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_ALIGN_CENTER); }
 	YY_BREAK
 case 234:
 YY_RULE_SETUP
-#line 403 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 379 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_LAYER_CHART); }
 	YY_BREAK
 case 235:
 YY_RULE_SETUP
-#line 404 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 380 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_LAYER_CIRCLE); }
 	YY_BREAK
 case 236:
 YY_RULE_SETUP
-#line 405 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 381 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_CL); }
 	YY_BREAK
 case 237:
 YY_RULE_SETUP
-#line 406 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 382 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_CR); }
 	YY_BREAK
 case 238:
 YY_RULE_SETUP
-#line 407 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 383 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_DB_CSV); }
 	YY_BREAK
 case 239:
 YY_RULE_SETUP
-#line 408 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 384 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_DB_POSTGRES); }
 	YY_BREAK
 case 240:
 YY_RULE_SETUP
-#line 409 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 385 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_DB_MYSQL); }
 	YY_BREAK
 case 241:
 YY_RULE_SETUP
-#line 410 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 386 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_DEFAULT); }
 	YY_BREAK
 case 242:
 YY_RULE_SETUP
-#line 411 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 387 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_DD); }
 	YY_BREAK
 case 243:
 YY_RULE_SETUP
-#line 412 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 388 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_SYMBOL_ELLIPSE); }
 	YY_BREAK
 case 244:
 YY_RULE_SETUP
-#line 413 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 389 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_EMBED); }
 	YY_BREAK
 case 245:
 YY_RULE_SETUP
-#line 414 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 390 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_FALSE); }
 	YY_BREAK
 case 246:
 YY_RULE_SETUP
-#line 415 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 391 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_FEET); }
 	YY_BREAK
 case 247:
 YY_RULE_SETUP
-#line 416 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 392 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_FOLLOW); }
 	YY_BREAK
 case 248:
 YY_RULE_SETUP
-#line 417 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 393 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_GIANT); }
 	YY_BREAK
 case 249:
 YY_RULE_SETUP
-#line 418 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 394 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_SYMBOL_HATCH); }
 	YY_BREAK
 case 250:
 YY_RULE_SETUP
-#line 419 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 395 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_HILITE); }
 	YY_BREAK
 case 251:
 YY_RULE_SETUP
-#line 420 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 396 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_INCHES); }
 	YY_BREAK
 case 252:
 YY_RULE_SETUP
-#line 421 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 397 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_KILOMETERS); }
 	YY_BREAK
 case 253:
 YY_RULE_SETUP
-#line 422 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 398 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_LARGE); }
 	YY_BREAK
 case 254:
 YY_RULE_SETUP
-#line 423 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 399 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_LC); }
 	YY_BREAK
 case 255:
 YY_RULE_SETUP
-#line 424 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 400 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_ALIGN_LEFT); }
 	YY_BREAK
 case 256:
 YY_RULE_SETUP
-#line 425 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 401 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_LAYER_LINE); }
 	YY_BREAK
 case 257:
 YY_RULE_SETUP
-#line 426 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 402 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_LL); }
 	YY_BREAK
 case 258:
 YY_RULE_SETUP
-#line 427 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 403 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_LR); }
 	YY_BREAK
 case 259:
 YY_RULE_SETUP
-#line 428 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 404 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_MEDIUM); }
 	YY_BREAK
 case 260:
 YY_RULE_SETUP
-#line 429 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 405 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_METERS); }
 	YY_BREAK
 case 261:
 YY_RULE_SETUP
-#line 430 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 406 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_NAUTICALMILES); }
 	YY_BREAK
 case 262:
 YY_RULE_SETUP
-#line 431 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 407 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_MILES); }
 	YY_BREAK
 case 263:
 YY_RULE_SETUP
-#line 432 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 408 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_CJC_MITER); }
 	YY_BREAK
 case 264:
 YY_RULE_SETUP
-#line 433 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 409 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_MULTIPLE); }
 	YY_BREAK
 case 265:
 YY_RULE_SETUP
-#line 434 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 410 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_CJC_NONE); }
 	YY_BREAK
 case 266:
 YY_RULE_SETUP
-#line 435 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 411 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_NORMAL); }
 	YY_BREAK
 case 267:
 YY_RULE_SETUP
-#line 436 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 412 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_OFF); }
 	YY_BREAK
 case 268:
 YY_RULE_SETUP
-#line 437 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 413 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_OGR); }
 	YY_BREAK
 case 269:
 YY_RULE_SETUP
-#line 438 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 414 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_ON); }
 	YY_BREAK
 case 270:
 YY_RULE_SETUP
-#line 439 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 415 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_JOIN_ONE_TO_ONE); }
 	YY_BREAK
 case 271:
 YY_RULE_SETUP
-#line 440 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 416 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_JOIN_ONE_TO_MANY); }
 	YY_BREAK
 case 272:
 YY_RULE_SETUP
-#line 441 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 417 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_ORACLESPATIAL); }
 	YY_BREAK
 case 273:
 YY_RULE_SETUP
-#line 442 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 418 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_PERCENTAGES); }
 	YY_BREAK
 case 274:
 YY_RULE_SETUP
-#line 443 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 419 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_SYMBOL_PIXMAP); }
 	YY_BREAK
 case 275:
 YY_RULE_SETUP
-#line 444 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 420 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_PIXELS); }
 	YY_BREAK
 case 276:
 YY_RULE_SETUP
-#line 445 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 421 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_LAYER_POINT); }
 	YY_BREAK
 case 277:
 YY_RULE_SETUP
-#line 446 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 422 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_LAYER_POLYGON); }
 	YY_BREAK
 case 278:
 YY_RULE_SETUP
-#line 447 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 423 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_POSTGIS); }
 	YY_BREAK
 case 279:
 YY_RULE_SETUP
-#line 448 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 424 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_PLUGIN); }
 	YY_BREAK
 case 280:
 YY_RULE_SETUP
-#line 449 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 425 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_LAYER_QUERY); }
 	YY_BREAK
 case 281:
 YY_RULE_SETUP
-#line 450 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 426 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_LAYER_RASTER); }
 	YY_BREAK
 case 282:
 YY_RULE_SETUP
-#line 451 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 427 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_ALIGN_RIGHT); }
 	YY_BREAK
 case 283:
 YY_RULE_SETUP
-#line 452 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 428 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_CJC_ROUND); }
 	YY_BREAK
 case 284:
 YY_RULE_SETUP
-#line 453 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 429 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_SDE); }
 	YY_BREAK
 case 285:
 YY_RULE_SETUP
-#line 454 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 430 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_SELECTED); }
 	YY_BREAK
 case 286:
 YY_RULE_SETUP
-#line 455 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 431 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_SYMBOL_SIMPLE); }
 	YY_BREAK
 case 287:
 YY_RULE_SETUP
-#line 456 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 432 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_SINGLE); }
 	YY_BREAK
 case 288:
 YY_RULE_SETUP
-#line 457 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 433 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_SMALL); }
 	YY_BREAK
 case 289:
 YY_RULE_SETUP
-#line 458 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 434 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_CJC_SQUARE); }
 	YY_BREAK
 case 290:
 YY_RULE_SETUP
-#line 459 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 435 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_SYMBOL_SVG); }
 	YY_BREAK
 case 291:
 YY_RULE_SETUP
-#line 460 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 436 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(POLAROFFSET); }
 	YY_BREAK
 case 292:
 YY_RULE_SETUP
-#line 461 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 437 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TINY); }
 	YY_BREAK
 case 293:
 YY_RULE_SETUP
-#line 462 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 438 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_CJC_TRIANGLE); }
 	YY_BREAK
 case 294:
 YY_RULE_SETUP
-#line 463 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 439 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TRUE); }
 	YY_BREAK
 case 295:
 YY_RULE_SETUP
-#line 464 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 440 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_TRUETYPE); }
 	YY_BREAK
 case 296:
 YY_RULE_SETUP
-#line 465 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 441 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_UC); }
 	YY_BREAK
 case 297:
 YY_RULE_SETUP
-#line 466 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 442 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_UL); }
 	YY_BREAK
 case 298:
 YY_RULE_SETUP
-#line 467 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 443 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_UR); }
 	YY_BREAK
 case 299:
 YY_RULE_SETUP
-#line 468 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 444 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_UNION); }
 	YY_BREAK
 case 300:
 YY_RULE_SETUP
-#line 469 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 445 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_UVRASTER); }
 	YY_BREAK
 case 301:
 YY_RULE_SETUP
-#line 470 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 446 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_CONTOUR); }
 	YY_BREAK
 case 302:
 YY_RULE_SETUP
-#line 471 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 447 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_SYMBOL_VECTOR); }
 	YY_BREAK
 case 303:
 YY_RULE_SETUP
-#line 472 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 448 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_WFS); }
 	YY_BREAK
 case 304:
 YY_RULE_SETUP
-#line 473 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 449 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_WMS); }
 	YY_BREAK
 case 305:
 YY_RULE_SETUP
-#line 474 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 450 "/home/even/mapserver/git/mapserver/maplexer.l"
 { MS_LEXER_RETURN_TOKEN(MS_GD_ALPHA); }
 	YY_BREAK
 case 306:
 YY_RULE_SETUP
-#line 476 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 452 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
-                                                 msyytext++;
-                                                 msyytext[strlen(msyytext)-1] = '\0';
-                                                 MS_LEXER_STRING_REALLOC(msyystring_buffer, strlen(msyytext), 
-                                                                         msyystring_buffer_size, msyystring_buffer_ptr);
-                                                 strcpy(msyystring_buffer,msyytext);
+                                                 yytext++;
+                                                 yytext[strlen(yytext)-1] = '\0';
+                                                 MS_LEXER_STRING_REALLOC(lexer->string_buffer, strlen(yytext), 
+                                                                         lexer->string_buffer_size, lexer->string_buffer_ptr);
+                                                 strcpy(lexer->string_buffer,yytext);
                                                  return(MS_STRING);
                                                }
 	YY_BREAK
 case 307:
 YY_RULE_SETUP
-#line 484 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 460 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
-                                                 msyytext++;
-                                                 msyytext[strlen(msyytext)-1] = '\0';
-                                                 MS_LEXER_STRING_REALLOC(msyystring_buffer, strlen(msyytext), 
-                                                                         msyystring_buffer_size, msyystring_buffer_ptr);
-                                                 strcpy(msyystring_buffer,msyytext);                                                 
-                                                 msyynumber = atof(msyytext);
+                                                 yytext++;
+                                                 yytext[strlen(yytext)-1] = '\0';
+                                                 MS_LEXER_STRING_REALLOC(lexer->string_buffer, strlen(yytext), 
+                                                                         lexer->string_buffer_size, lexer->string_buffer_ptr);
+                                                 strcpy(lexer->string_buffer,yytext);                                                 
+                                                 lexer->number = atof(yytext);
                                                  return(MS_NUMBER);
                                                }
 	YY_BREAK
 case 308:
 /* rule 308 can match eol */
 YY_RULE_SETUP
-#line 494 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 470 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
-                                                 msyytext++;
-                                                 msyytext[strlen(msyytext)-1] = '\0';
-                                                 MS_LEXER_STRING_REALLOC(msyystring_buffer, strlen(msyytext), 
-                                                                         msyystring_buffer_size, msyystring_buffer_ptr);
-                                                 strcpy(msyystring_buffer,msyytext);
+                                                 yytext++;
+                                                 yytext[strlen(yytext)-1] = '\0';
+                                                 MS_LEXER_STRING_REALLOC(lexer->string_buffer, strlen(yytext), 
+                                                                         lexer->string_buffer_size, lexer->string_buffer_ptr);
+                                                 strcpy(lexer->string_buffer,yytext);
                                                  return(MS_BINDING);
                                                }
 	YY_BREAK
 case 309:
 YY_RULE_SETUP
-#line 503 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 479 "/home/even/mapserver/git/mapserver/maplexer.l"
 { 
   /* attribute binding - shape (fixed value) */
   return(MS_TOKEN_BINDING_SHAPE);
@@ -4102,7 +4071,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 310:
 YY_RULE_SETUP
-#line 507 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 483 "/home/even/mapserver/git/mapserver/maplexer.l"
 { 
   /* attribute binding - map cellsize */
   return(MS_TOKEN_BINDING_MAP_CELLSIZE);
@@ -4110,7 +4079,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 311:
 YY_RULE_SETUP
-#line 511 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 487 "/home/even/mapserver/git/mapserver/maplexer.l"
 { 
   /* attribute binding - data cellsize */
   return(MS_TOKEN_BINDING_DATA_CELLSIZE);
@@ -4119,300 +4088,302 @@ YY_RULE_SETUP
 case 312:
 /* rule 312 can match eol */
 YY_RULE_SETUP
-#line 515 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 491 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
   /* attribute binding - numeric (no quotes) */
-  msyytext++;
-  msyytext[strlen(msyytext)-1] = '\0';
-  MS_LEXER_STRING_REALLOC(msyystring_buffer, strlen(msyytext), 
-                          msyystring_buffer_size, msyystring_buffer_ptr);
-  strcpy(msyystring_buffer, msyytext);
+  yytext++;
+  yytext[strlen(yytext)-1] = '\0';
+  MS_LEXER_STRING_REALLOC(lexer->string_buffer, strlen(yytext), 
+                          lexer->string_buffer_size, lexer->string_buffer_ptr);
+  strcpy(lexer->string_buffer, yytext);
   return(MS_TOKEN_BINDING_DOUBLE);
 }
 	YY_BREAK
 case 313:
 /* rule 313 can match eol */
 YY_RULE_SETUP
-#line 524 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 500 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
   /* attribute binding - string (single or double quotes) */
-  msyytext+=2;
-  msyytext[strlen(msyytext)-2] = '\0';
-  MS_LEXER_STRING_REALLOC(msyystring_buffer, strlen(msyytext), 
-                          msyystring_buffer_size, msyystring_buffer_ptr);
-  strcpy(msyystring_buffer, msyytext);
+  yytext+=2;
+  yytext[strlen(yytext)-2] = '\0';
+  MS_LEXER_STRING_REALLOC(lexer->string_buffer, strlen(yytext), 
+                          lexer->string_buffer_size, lexer->string_buffer_ptr);
+  strcpy(lexer->string_buffer, yytext);
   return(MS_TOKEN_BINDING_STRING);
 }
 	YY_BREAK
 case 314:
 /* rule 314 can match eol */
 YY_RULE_SETUP
-#line 533 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 509 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
   /* attribute binding - time */
-  msyytext+=2;
-  msyytext[strlen(msyytext)-2] = '\0';
-  MS_LEXER_STRING_REALLOC(msyystring_buffer, strlen(msyytext),
-                          msyystring_buffer_size, msyystring_buffer_ptr);
-  strcpy(msyystring_buffer, msyytext);
+  yytext+=2;
+  yytext[strlen(yytext)-2] = '\0';
+  MS_LEXER_STRING_REALLOC(lexer->string_buffer, strlen(yytext),
+                          lexer->string_buffer_size, lexer->string_buffer_ptr);
+  strcpy(lexer->string_buffer, yytext);
   return(MS_TOKEN_BINDING_TIME);
 }
 	YY_BREAK
 case 315:
 YY_RULE_SETUP
-#line 543 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 519 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
-  MS_LEXER_STRING_REALLOC(msyystring_buffer, strlen(msyytext), 
-                          msyystring_buffer_size, msyystring_buffer_ptr);
-  strcpy(msyystring_buffer,msyytext);
-  msyynumber = atof(msyytext);
+  MS_LEXER_STRING_REALLOC(lexer->string_buffer, strlen(yytext), 
+                          lexer->string_buffer_size, lexer->string_buffer_ptr);
+  strcpy(lexer->string_buffer,yytext);
+  lexer->number = atof(yytext);
   return(MS_NUMBER); 
 }
 	YY_BREAK
 case 316:
 YY_RULE_SETUP
-#line 551 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 527 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
-  MS_LEXER_STRING_REALLOC(msyystring_buffer, strlen(msyytext), 
-                          msyystring_buffer_size, msyystring_buffer_ptr);
-  strcpy(msyystring_buffer,msyytext);
-  msyynumber = atof(msyytext);
+  MS_LEXER_STRING_REALLOC(lexer->string_buffer, strlen(yytext), 
+                          lexer->string_buffer_size, lexer->string_buffer_ptr);
+  strcpy(lexer->string_buffer,yytext);
+  lexer->number = atof(yytext);
   return(MS_TOKEN_LITERAL_NUMBER);
 }
 	YY_BREAK
 case 317:
 /* rule 317 can match eol */
 YY_RULE_SETUP
-#line 559 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 535 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
-  msyytext++;
-  msyytext[strlen(msyytext)-1] = '\0';
-  MS_LEXER_STRING_REALLOC(msyystring_buffer, strlen(msyytext), 
-                          msyystring_buffer_size, msyystring_buffer_ptr);
-  strcpy(msyystring_buffer, msyytext);
+  yytext++;
+  yytext[strlen(yytext)-1] = '\0';
+  MS_LEXER_STRING_REALLOC(lexer->string_buffer, strlen(yytext), 
+                          lexer->string_buffer_size, lexer->string_buffer_ptr);
+  strcpy(lexer->string_buffer, yytext);
   return(MS_TOKEN_LITERAL_TIME);
 }
 	YY_BREAK
 case 318:
 /* rule 318 can match eol */
 YY_RULE_SETUP
-#line 568 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 544 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
-                                                 msyytext++;
-                                                 msyytext[strlen(msyytext)-2] = '\0';
-                                                 MS_LEXER_STRING_REALLOC(msyystring_buffer, strlen(msyytext), 
-                                                                         msyystring_buffer_size, msyystring_buffer_ptr);
-                                                 strcpy(msyystring_buffer, msyytext);
+                                                 yytext++;
+                                                 yytext[strlen(yytext)-2] = '\0';
+                                                 MS_LEXER_STRING_REALLOC(lexer->string_buffer, strlen(yytext), 
+                                                                         lexer->string_buffer_size, lexer->string_buffer_ptr);
+                                                 strcpy(lexer->string_buffer, yytext);
                                                  return(MS_IREGEX);
                                                }
 	YY_BREAK
 case 319:
 /* rule 319 can match eol */
 YY_RULE_SETUP
-#line 577 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 553 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
-                                                 msyytext++;
-                                                 msyytext[strlen(msyytext)-1] = '\0';
-                                                 MS_LEXER_STRING_REALLOC(msyystring_buffer, strlen(msyytext), 
-                                                                         msyystring_buffer_size, msyystring_buffer_ptr);
-                                                 strcpy(msyystring_buffer, msyytext);
+                                                 yytext++;
+                                                 yytext[strlen(yytext)-1] = '\0';
+                                                 MS_LEXER_STRING_REALLOC(lexer->string_buffer, strlen(yytext), 
+                                                                         lexer->string_buffer_size, lexer->string_buffer_ptr);
+                                                 strcpy(lexer->string_buffer, yytext);
                                                  return(MS_REGEX);
                                                }
 	YY_BREAK
 case 320:
 YY_RULE_SETUP
-#line 586 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 562 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
-                                                 msyytext++;
-                                                 msyytext[strlen(msyytext)-1] = '\0';
-                                                 MS_LEXER_STRING_REALLOC(msyystring_buffer, strlen(msyytext), 
-                                                                         msyystring_buffer_size, msyystring_buffer_ptr);
-                                                 strcpy(msyystring_buffer, msyytext);
+                                                 yytext++;
+                                                 yytext[strlen(yytext)-1] = '\0';
+                                                 MS_LEXER_STRING_REALLOC(lexer->string_buffer, strlen(yytext), 
+                                                                         lexer->string_buffer_size, lexer->string_buffer_ptr);
+                                                 strcpy(lexer->string_buffer, yytext);
                                                  return(MS_EXPRESSION);
                                                }
 	YY_BREAK
 case 321:
 YY_RULE_SETUP
-#line 595 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 571 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
-                                                 msyytext++;
-                                                 msyytext[strlen(msyytext)-1] = '\0';
-                                                 MS_LEXER_STRING_REALLOC(msyystring_buffer, strlen(msyytext), 
-                                                                         msyystring_buffer_size, msyystring_buffer_ptr);
-                                                 strcpy(msyystring_buffer, msyytext);
+                                                 yytext++;
+                                                 yytext[strlen(yytext)-1] = '\0';
+                                                 MS_LEXER_STRING_REALLOC(lexer->string_buffer, strlen(yytext), 
+                                                                         lexer->string_buffer_size, lexer->string_buffer_ptr);
+                                                 strcpy(lexer->string_buffer, yytext);
                                                  return(MS_LIST);
                                                }
 	YY_BREAK
 case 322:
 YY_RULE_SETUP
-#line 604 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 580 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
-                                                 msyystring_return_state = MS_STRING;
-                                                 msyystring_begin = msyytext[0]; 
-                                                 msyystring_size = 0;
-                                                 msyystring_buffer_ptr = msyystring_buffer;
+                                                 lexer->string_return_state = MS_STRING;
+                                                 lexer->string_begin = yytext[0]; 
+                                                 lexer->string_size = 0;
+                                                 lexer->string_buffer_ptr = lexer->string_buffer;
                                                  BEGIN(MSSTRING);
                                               }
 	YY_BREAK
 case 323:
 YY_RULE_SETUP
-#line 612 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 588 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
-                                                MS_LEXER_STRING_REALLOC(msyystring_buffer, msyystring_size, 
-                                                                                           msyystring_buffer_size, msyystring_buffer_ptr);
-                                                if (msyystring_begin == msyytext[0]) {
-                                                   BEGIN(msyystring_begin_state);
+                                                MS_LEXER_STRING_REALLOC(lexer->string_buffer, lexer->string_size, 
+                                                                                           lexer->string_buffer_size, lexer->string_buffer_ptr);
+                                                if (lexer->string_begin == yytext[0]) {
+                                                   BEGIN(lexer->string_begin_state);
 
-                                                   *msyystring_buffer_ptr = '\0';
+                                                   *lexer->string_buffer_ptr = '\0';
 
-                                                   if (msyystring_return_state == MS_STRING) {
-                                                      if (msyystring_icase && strlen(msyytext)==2) {
-                                                         msyystring_icase = MS_FALSE; // reset
+                                                   if (lexer->string_return_state == MS_STRING) {
+                                                      if (lexer->string_icase && strlen(yytext)==2) {
+                                                         lexer->string_icase = MS_FALSE; // reset
                                                          return MS_ISTRING;
                                                       } else
                                                         return MS_STRING;
                                                    }
-                                                   return msyystring_return_state;
+                                                   return lexer->string_return_state;
 
                                                 }
                                                 else {
-                                                  ++msyystring_size;
-                                                  *msyystring_buffer_ptr++ = *msyytext;
-                                                  if (strlen(msyytext)==2) {
-                                                      MS_LEXER_STRING_REALLOC(msyystring_buffer, msyystring_size, 
-                                                                              msyystring_buffer_size, msyystring_buffer_ptr);
-                                                     ++msyystring_size;
-                                                     *msyystring_buffer_ptr++ = msyytext[1];
+                                                  ++lexer->string_size;
+                                                  *lexer->string_buffer_ptr++ = *yytext;
+                                                  if (strlen(yytext)==2) {
+                                                      MS_LEXER_STRING_REALLOC(lexer->string_buffer, lexer->string_size, 
+                                                                              lexer->string_buffer_size, lexer->string_buffer_ptr);
+                                                     ++lexer->string_size;
+                                                     *lexer->string_buffer_ptr++ = yytext[1];
                                                   }
                                                 }
                                               }
 	YY_BREAK
 case 324:
 YY_RULE_SETUP
-#line 642 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 618 "/home/even/mapserver/git/mapserver/maplexer.l"
 { 
-                                                MS_LEXER_STRING_REALLOC(msyystring_buffer, msyystring_size, 
-                                                                                           msyystring_buffer_size, msyystring_buffer_ptr);
+                                                MS_LEXER_STRING_REALLOC(lexer->string_buffer, lexer->string_size, 
+                                                                                           lexer->string_buffer_size, lexer->string_buffer_ptr);
 
-                                                ++msyystring_size;
-                                                if (strlen(msyytext) == 2)
-                                                    *msyystring_buffer_ptr++ = msyytext[1]; 
+                                                ++lexer->string_size;
+                                                if (strlen(yytext) == 2)
+                                                    *lexer->string_buffer_ptr++ = yytext[1]; 
                                                 else
-                                                    *msyystring_buffer_ptr++ = msyytext[0];
+                                                    *lexer->string_buffer_ptr++ = yytext[0];
                                              }
 	YY_BREAK
 case 325:
 /* rule 325 can match eol */
 YY_RULE_SETUP
-#line 653 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 629 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
-                                                 char *yptr = msyytext;
+                                                 char *yptr = yytext;
                                                  while ( *yptr ) { 
-                                                   MS_LEXER_STRING_REALLOC(msyystring_buffer, msyystring_size, 
-                                                                           msyystring_buffer_size, msyystring_buffer_ptr);
-                                                   ++msyystring_size;
-                                                   *msyystring_buffer_ptr++ = *yptr++;
+                                                   MS_LEXER_STRING_REALLOC(lexer->string_buffer, lexer->string_size, 
+                                                                           lexer->string_buffer_size, lexer->string_buffer_ptr);
+                                                   ++lexer->string_size;
+                                                   *lexer->string_buffer_ptr++ = *yptr++;
                                                  }
                                              }
 	YY_BREAK
 case 326:
 /* rule 326 can match eol */
 YY_RULE_SETUP
-#line 663 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 639 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
-                                                 msyytext++;
-                                                 msyytext[strlen(msyytext)-1] = '\0';
+                                                 FILE *include_file;
+
+                                                 yytext++;
+                                                 yytext[strlen(yytext)-1] = '\0';
 
-                                                 if(include_stack_ptr >= MAX_INCLUDE_DEPTH) {
+                                                 if(lexer->include_stack_ptr >= MS_MAXINCLUDEDEPTH) {
                                                    msSetError(MS_IOERR, "Includes nested to deeply.", "msyylex()");
                                                    return(-1);
                                                  }
 
-                                                 include_stack[include_stack_ptr] = YY_CURRENT_BUFFER; /* save state */
-                                                 include_lineno[include_stack_ptr] = msyylineno;
-                                                 include_stack_ptr++;
-
-                                                 msyyin = fopen(msBuildPath(path, msyybasepath, msyytext), "r");
-                                                 if(!msyyin) {
-                                                   msSetError(MS_IOERR, "Error opening included file \"%s\".", "msyylex()", msyytext);
+                                                 include_file = fopen(msBuildPath(lexer->path, lexer->basepath, yytext), "r");
+                                                 if(!include_file) {
+                                                   msSetError(MS_IOERR, "Error opening included file \"%s\".", "msyylex()", yytext);
                                                    return(-1);
                                                  }
 
-                                                 msyy_switch_to_buffer( msyy_create_buffer(msyyin, YY_BUF_SIZE) );
-                                                 msyylineno = 1;
+                                                 lexer->include_stack[lexer->include_stack_ptr] = YY_CURRENT_BUFFER; /* save state */
+                                                 lexer->include_lineno[lexer->include_stack_ptr] = lexer->lineno;
+                                                 lexer->include_stack_ptr++;
+
+                                                 msyy_switch_to_buffer(msyy_create_buffer(include_file, YY_BUF_SIZE, yyscanner), yyscanner);
+                                                 lexer->lineno = 1;
 
                                                  BEGIN(INITIAL);
                                                }
 	YY_BREAK
 case 327:
 YY_RULE_SETUP
-#line 688 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 666 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
-                                                 msyystring_return_state = MS_TOKEN_LITERAL_STRING;
-                                                 msyystring_begin = msyytext[0]; 
-                                                 msyystring_size = 0;
-                                                 msyystring_buffer_ptr = msyystring_buffer;
+                                                 lexer->string_return_state = MS_TOKEN_LITERAL_STRING;
+                                                 lexer->string_begin = yytext[0]; 
+                                                 lexer->string_size = 0;
+                                                 lexer->string_buffer_ptr = lexer->string_buffer;
                                                  BEGIN(MSSTRING);
                                               }
 	YY_BREAK
 case 328:
 YY_RULE_SETUP
-#line 696 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 674 "/home/even/mapserver/git/mapserver/maplexer.l"
 { 
-                                                    MS_LEXER_STRING_REALLOC(msyystring_buffer, strlen(msyytext), 
-                                                                            msyystring_buffer_size, msyystring_buffer_ptr);
-                                                    strcpy(msyystring_buffer, msyytext); 
+                                                    MS_LEXER_STRING_REALLOC(lexer->string_buffer, strlen(yytext), 
+                                                                            lexer->string_buffer_size, lexer->string_buffer_ptr);
+                                                    strcpy(lexer->string_buffer, yytext); 
                                                     return(MS_STRING); 
                                                 }
 	YY_BREAK
 case 329:
 /* rule 329 can match eol */
 YY_RULE_SETUP
-#line 703 "/home/even/mapserver/git/mapserver/maplexer.l"
-{ msyylineno++; }
+#line 681 "/home/even/mapserver/git/mapserver/maplexer.l"
+{ lexer->lineno++; }
 	YY_BREAK
 case YY_STATE_EOF(INITIAL):
-#line 705 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 683 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
-                                                  if( --include_stack_ptr < 0 )
+                                                  if( --lexer->include_stack_ptr < 0 )
                                                     return(EOF); /* end of main file */
                                                   else {
                                                     fclose(YY_CURRENT_BUFFER->yy_input_file);
-                                                    msyy_delete_buffer( YY_CURRENT_BUFFER );
-                                                    msyy_switch_to_buffer(include_stack[include_stack_ptr]);
-                                                    msyylineno = include_lineno[include_stack_ptr];
+                                                    msyy_delete_buffer(YY_CURRENT_BUFFER, yyscanner);
+                                                    msyy_switch_to_buffer(lexer->include_stack[lexer->include_stack_ptr], yyscanner);
+                                                    lexer->lineno = lexer->include_lineno[lexer->include_stack_ptr];
                                                   }
                                                 }
 	YY_BREAK
 case 330:
 /* rule 330 can match eol */
 YY_RULE_SETUP
-#line 716 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 694 "/home/even/mapserver/git/mapserver/maplexer.l"
 {
   return(0); 
 }
 	YY_BREAK
 case 331:
 YY_RULE_SETUP
-#line 720 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 698 "/home/even/mapserver/git/mapserver/maplexer.l"
 { 
-                                                  MS_LEXER_STRING_REALLOC(msyystring_buffer, strlen(msyytext), 
-                                                                          msyystring_buffer_size, msyystring_buffer_ptr);
-                                                  strcpy(msyystring_buffer, msyytext); 
+                                                  MS_LEXER_STRING_REALLOC(lexer->string_buffer, strlen(yytext), 
+                                                                          lexer->string_buffer_size, lexer->string_buffer_ptr);
+                                                  strcpy(lexer->string_buffer, yytext); 
                                                   return(0); 
                                                 }
 	YY_BREAK
 case 332:
 YY_RULE_SETUP
-#line 726 "/home/even/mapserver/git/mapserver/maplexer.l"
-{ return(msyytext[0]); }
+#line 704 "/home/even/mapserver/git/mapserver/maplexer.l"
+{ return(yytext[0]); }
 	YY_BREAK
 case 333:
 YY_RULE_SETUP
-#line 727 "/home/even/mapserver/git/mapserver/maplexer.l"
+#line 705 "/home/even/mapserver/git/mapserver/maplexer.l"
 ECHO;
 	YY_BREAK
-#line 4416 "/home/even/mapserver/git/mapserver/maplexer.c"
+#line 4387 "/home/even/mapserver/git/mapserver/maplexer.c"
 case YY_STATE_EOF(URL_VARIABLE):
 case YY_STATE_EOF(URL_STRING):
 case YY_STATE_EOF(EXPRESSION_STRING):
@@ -4423,25 +4394,25 @@ case YY_STATE_EOF(MSSTRING):
 	case YY_END_OF_BUFFER:
 		{
 		/* Amount of text matched not including the EOB char. */
-		int yy_amount_of_matched_text = (int) (yy_cp - (yytext_ptr)) - 1;
+		int yy_amount_of_matched_text = (int) (yy_cp - yyg->yytext_ptr) - 1;
 
 		/* Undo the effects of YY_DO_BEFORE_ACTION. */
-		*yy_cp = (yy_hold_char);
+		*yy_cp = yyg->yy_hold_char;
 		YY_RESTORE_YY_MORE_OFFSET
 
 		if ( YY_CURRENT_BUFFER_LVALUE->yy_buffer_status == YY_BUFFER_NEW )
 			{
 			/* We're scanning a new file or input source.  It's
 			 * possible that this happened because the user
-			 * just pointed msyyin at a new source and called
+			 * just pointed yyin at a new source and called
 			 * msyylex().  If so, then we have to assure
 			 * consistency between YY_CURRENT_BUFFER and our
 			 * globals.  Here is the right place to do so, because
 			 * this is the first action (other than possibly a
 			 * back-up) that will match for the new input source.
 			 */
-			(yy_n_chars) = YY_CURRENT_BUFFER_LVALUE->yy_n_chars;
-			YY_CURRENT_BUFFER_LVALUE->yy_input_file = msyyin;
+			yyg->yy_n_chars = YY_CURRENT_BUFFER_LVALUE->yy_n_chars;
+			YY_CURRENT_BUFFER_LVALUE->yy_input_file = yyin;
 			YY_CURRENT_BUFFER_LVALUE->yy_buffer_status = YY_BUFFER_NORMAL;
 			}
 
@@ -4452,13 +4423,13 @@ case YY_STATE_EOF(MSSTRING):
 		 * end-of-buffer state).  Contrast this with the test
 		 * in input().
 		 */
-		if ( (yy_c_buf_p) <= &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars)] )
+		if ( yyg->yy_c_buf_p <= &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars] )
 			{ /* This was really a NUL. */
 			yy_state_type yy_next_state;
 
-			(yy_c_buf_p) = (yytext_ptr) + yy_amount_of_matched_text;
+			yyg->yy_c_buf_p = yyg->yytext_ptr + yy_amount_of_matched_text;
 
-			yy_current_state = yy_get_previous_state(  );
+			yy_current_state = yy_get_previous_state( yyscanner );
 
 			/* Okay, we're now positioned to make the NUL
 			 * transition.  We couldn't have
@@ -4469,43 +4440,43 @@ case YY_STATE_EOF(MSSTRING):
 			 * will run more slowly).
 			 */
 
-			yy_next_state = yy_try_NUL_trans( yy_current_state );
+			yy_next_state = yy_try_NUL_trans( yy_current_state , yyscanner);
 
-			yy_bp = (yytext_ptr) + YY_MORE_ADJ;
+			yy_bp = yyg->yytext_ptr + YY_MORE_ADJ;
 
 			if ( yy_next_state )
 				{
 				/* Consume the NUL. */
-				yy_cp = ++(yy_c_buf_p);
+				yy_cp = ++yyg->yy_c_buf_p;
 				yy_current_state = yy_next_state;
 				goto yy_match;
 				}
 
 			else
 				{
-				yy_cp = (yy_c_buf_p);
+				yy_cp = yyg->yy_c_buf_p;
 				goto yy_find_action;
 				}
 			}
 
-		else switch ( yy_get_next_buffer(  ) )
+		else switch ( yy_get_next_buffer( yyscanner ) )
 			{
 			case EOB_ACT_END_OF_FILE:
 				{
-				(yy_did_buffer_switch_on_eof) = 0;
+				yyg->yy_did_buffer_switch_on_eof = 0;
 
-				if ( msyywrap( ) )
+				if ( msyywrap(yyscanner ) )
 					{
 					/* Note: because we've taken care in
 					 * yy_get_next_buffer() to have set up
-					 * msyytext, we can now set up
+					 * yytext, we can now set up
 					 * yy_c_buf_p so that if some total
 					 * hoser (like flex itself) wants to
 					 * call the scanner after we return the
 					 * YY_NULL, it'll still work - another
 					 * YY_NULL will get returned.
 					 */
-					(yy_c_buf_p) = (yytext_ptr) + YY_MORE_ADJ;
+					yyg->yy_c_buf_p = yyg->yytext_ptr + YY_MORE_ADJ;
 
 					yy_act = YY_STATE_EOF(YY_START);
 					goto do_action;
@@ -4513,30 +4484,30 @@ case YY_STATE_EOF(MSSTRING):
 
 				else
 					{
-					if ( ! (yy_did_buffer_switch_on_eof) )
+					if ( ! yyg->yy_did_buffer_switch_on_eof )
 						YY_NEW_FILE;
 					}
 				break;
 				}
 
 			case EOB_ACT_CONTINUE_SCAN:
-				(yy_c_buf_p) =
-					(yytext_ptr) + yy_amount_of_matched_text;
+				yyg->yy_c_buf_p =
+					yyg->yytext_ptr + yy_amount_of_matched_text;
 
-				yy_current_state = yy_get_previous_state(  );
+				yy_current_state = yy_get_previous_state( yyscanner );
 
-				yy_cp = (yy_c_buf_p);
-				yy_bp = (yytext_ptr) + YY_MORE_ADJ;
+				yy_cp = yyg->yy_c_buf_p;
+				yy_bp = yyg->yytext_ptr + YY_MORE_ADJ;
 				goto yy_match;
 
 			case EOB_ACT_LAST_MATCH:
-				(yy_c_buf_p) =
-				&YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars)];
+				yyg->yy_c_buf_p =
+				&YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars];
 
-				yy_current_state = yy_get_previous_state(  );
+				yy_current_state = yy_get_previous_state( yyscanner );
 
-				yy_cp = (yy_c_buf_p);
-				yy_bp = (yytext_ptr) + YY_MORE_ADJ;
+				yy_cp = yyg->yy_c_buf_p;
+				yy_bp = yyg->yytext_ptr + YY_MORE_ADJ;
 				goto yy_find_action;
 			}
 		break;
@@ -4556,20 +4527,21 @@ case YY_STATE_EOF(MSSTRING):
  *	EOB_ACT_CONTINUE_SCAN - continue scanning from current position
  *	EOB_ACT_END_OF_FILE - end of file
  */
-static int yy_get_next_buffer (void)
+static int yy_get_next_buffer (yyscan_t yyscanner)
 {
-    	register char *dest = YY_CURRENT_BUFFER_LVALUE->yy_ch_buf;
-	register char *source = (yytext_ptr);
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	register char *dest = YY_CURRENT_BUFFER_LVALUE->yy_ch_buf;
+	register char *source = yyg->yytext_ptr;
 	register int number_to_move, i;
 	int ret_val;
 
-	if ( (yy_c_buf_p) > &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars) + 1] )
+	if ( yyg->yy_c_buf_p > &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars + 1] )
 		YY_FATAL_ERROR(
 		"fatal flex scanner internal error--end of buffer missed" );
 
 	if ( YY_CURRENT_BUFFER_LVALUE->yy_fill_buffer == 0 )
 		{ /* Don't try to fill the buffer, so this is an EOF. */
-		if ( (yy_c_buf_p) - (yytext_ptr) - YY_MORE_ADJ == 1 )
+		if ( yyg->yy_c_buf_p - yyg->yytext_ptr - YY_MORE_ADJ == 1 )
 			{
 			/* We matched a single character, the EOB, so
 			 * treat this as a final EOF.
@@ -4589,7 +4561,7 @@ static int yy_get_next_buffer (void)
 	/* Try to read more data. */
 
 	/* First move last chars to start of buffer. */
-	number_to_move = (int) ((yy_c_buf_p) - (yytext_ptr)) - 1;
+	number_to_move = (int) (yyg->yy_c_buf_p - yyg->yytext_ptr) - 1;
 
 	for ( i = 0; i < number_to_move; ++i )
 		*(dest++) = *(source++);
@@ -4598,7 +4570,7 @@ static int yy_get_next_buffer (void)
 		/* don't do the read, it's not guaranteed to return an EOF,
 		 * just force an EOF
 		 */
-		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars) = 0;
+		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = yyg->yy_n_chars = 0;
 
 	else
 		{
@@ -4612,7 +4584,7 @@ static int yy_get_next_buffer (void)
 			YY_BUFFER_STATE b = YY_CURRENT_BUFFER;
 
 			int yy_c_buf_p_offset =
-				(int) ((yy_c_buf_p) - b->yy_ch_buf);
+				(int) (yyg->yy_c_buf_p - b->yy_ch_buf);
 
 			if ( b->yy_is_our_buffer )
 				{
@@ -4625,7 +4597,7 @@ static int yy_get_next_buffer (void)
 
 				b->yy_ch_buf = (char *)
 					/* Include room in for 2 EOB chars. */
-					msyyrealloc((void *) b->yy_ch_buf,b->yy_buf_size + 2  );
+					msyyrealloc((void *) b->yy_ch_buf,b->yy_buf_size + 2 ,yyscanner );
 				}
 			else
 				/* Can't grow it, we don't own it. */
@@ -4635,7 +4607,7 @@ static int yy_get_next_buffer (void)
 				YY_FATAL_ERROR(
 				"fatal error - scanner input buffer overflow" );
 
-			(yy_c_buf_p) = &b->yy_ch_buf[yy_c_buf_p_offset];
+			yyg->yy_c_buf_p = &b->yy_ch_buf[yy_c_buf_p_offset];
 
 			num_to_read = YY_CURRENT_BUFFER_LVALUE->yy_buf_size -
 						number_to_move - 1;
@@ -4647,17 +4619,17 @@ static int yy_get_next_buffer (void)
 
 		/* Read in more data. */
 		YY_INPUT( (&YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[number_to_move]),
-			(yy_n_chars), (size_t) num_to_read );
+			yyg->yy_n_chars, (size_t) num_to_read );
 
-		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars);
+		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = yyg->yy_n_chars;
 		}
 
-	if ( (yy_n_chars) == 0 )
+	if ( yyg->yy_n_chars == 0 )
 		{
 		if ( number_to_move == YY_MORE_ADJ )
 			{
 			ret_val = EOB_ACT_END_OF_FILE;
-			msyyrestart(msyyin  );
+			msyyrestart(yyin ,yyscanner );
 			}
 
 		else
@@ -4671,39 +4643,40 @@ static int yy_get_next_buffer (void)
 	else
 		ret_val = EOB_ACT_CONTINUE_SCAN;
 
-	if ((yy_size_t) ((yy_n_chars) + number_to_move) > YY_CURRENT_BUFFER_LVALUE->yy_buf_size) {
+	if ((yy_size_t) (yyg->yy_n_chars + number_to_move) > YY_CURRENT_BUFFER_LVALUE->yy_buf_size) {
 		/* Extend the array by 50%, plus the number we really need. */
-		yy_size_t new_size = (yy_n_chars) + number_to_move + ((yy_n_chars) >> 1);
-		YY_CURRENT_BUFFER_LVALUE->yy_ch_buf = (char *) msyyrealloc((void *) YY_CURRENT_BUFFER_LVALUE->yy_ch_buf,new_size  );
+		yy_size_t new_size = yyg->yy_n_chars + number_to_move + (yyg->yy_n_chars >> 1);
+		YY_CURRENT_BUFFER_LVALUE->yy_ch_buf = (char *) msyyrealloc((void *) YY_CURRENT_BUFFER_LVALUE->yy_ch_buf,new_size ,yyscanner );
 		if ( ! YY_CURRENT_BUFFER_LVALUE->yy_ch_buf )
 			YY_FATAL_ERROR( "out of dynamic memory in yy_get_next_buffer()" );
 	}
 
-	(yy_n_chars) += number_to_move;
-	YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars)] = YY_END_OF_BUFFER_CHAR;
-	YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars) + 1] = YY_END_OF_BUFFER_CHAR;
+	yyg->yy_n_chars += number_to_move;
+	YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars] = YY_END_OF_BUFFER_CHAR;
+	YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars + 1] = YY_END_OF_BUFFER_CHAR;
 
-	(yytext_ptr) = &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[0];
+	yyg->yytext_ptr = &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[0];
 
 	return ret_val;
 }
 
 /* yy_get_previous_state - get the state just before the EOB char was reached */
 
-    static yy_state_type yy_get_previous_state (void)
+    static yy_state_type yy_get_previous_state (yyscan_t yyscanner)
 {
 	register yy_state_type yy_current_state;
 	register char *yy_cp;
-    
-	yy_current_state = (yy_start);
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 
-	for ( yy_cp = (yytext_ptr) + YY_MORE_ADJ; yy_cp < (yy_c_buf_p); ++yy_cp )
+	yy_current_state = yyg->yy_start;
+
+	for ( yy_cp = yyg->yytext_ptr + YY_MORE_ADJ; yy_cp < yyg->yy_c_buf_p; ++yy_cp )
 		{
 		register YY_CHAR yy_c = (*yy_cp ? yy_ec[YY_SC_TO_UI(*yy_cp)] : 84);
 		if ( yy_accept[yy_current_state] )
 			{
-			(yy_last_accepting_state) = yy_current_state;
-			(yy_last_accepting_cpos) = yy_cp;
+			yyg->yy_last_accepting_state = yy_current_state;
+			yyg->yy_last_accepting_cpos = yy_cp;
 			}
 		while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 			{
@@ -4722,16 +4695,17 @@ static int yy_get_next_buffer (void)
  * synopsis
  *	next_state = yy_try_NUL_trans( current_state );
  */
-    static yy_state_type yy_try_NUL_trans  (yy_state_type yy_current_state )
+    static yy_state_type yy_try_NUL_trans  (yy_state_type yy_current_state , yyscan_t yyscanner)
 {
 	register int yy_is_jam;
-    	register char *yy_cp = (yy_c_buf_p);
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner; /* This var may be unused depending upon options. */
+	register char *yy_cp = yyg->yy_c_buf_p;
 
 	register YY_CHAR yy_c = 84;
 	if ( yy_accept[yy_current_state] )
 		{
-		(yy_last_accepting_state) = yy_current_state;
-		(yy_last_accepting_cpos) = yy_cp;
+		yyg->yy_last_accepting_state = yy_current_state;
+		yyg->yy_last_accepting_cpos = yy_cp;
 		}
 	while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 		{
@@ -4745,19 +4719,20 @@ static int yy_get_next_buffer (void)
 	return yy_is_jam ? 0 : yy_current_state;
 }
 
-    static void yyunput (int c, register char * yy_bp )
+    static void yyunput (int c, register char * yy_bp , yyscan_t yyscanner)
 {
 	register char *yy_cp;
-    
-    yy_cp = (yy_c_buf_p);
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 
-	/* undo effects of setting up msyytext */
-	*yy_cp = (yy_hold_char);
+    yy_cp = yyg->yy_c_buf_p;
+
+	/* undo effects of setting up yytext */
+	*yy_cp = yyg->yy_hold_char;
 
 	if ( yy_cp < YY_CURRENT_BUFFER_LVALUE->yy_ch_buf + 2 )
 		{ /* need to shift things up to make room */
 		/* +2 for EOB chars. */
-		register int number_to_move = (yy_n_chars) + 2;
+		register int number_to_move = yyg->yy_n_chars + 2;
 		register char *dest = &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[
 					YY_CURRENT_BUFFER_LVALUE->yy_buf_size + 2];
 		register char *source =
@@ -4769,7 +4744,7 @@ static int yy_get_next_buffer (void)
 		yy_cp += (int) (dest - source);
 		yy_bp += (int) (dest - source);
 		YY_CURRENT_BUFFER_LVALUE->yy_n_chars =
-			(yy_n_chars) = YY_CURRENT_BUFFER_LVALUE->yy_buf_size;
+			yyg->yy_n_chars = YY_CURRENT_BUFFER_LVALUE->yy_buf_size;
 
 		if ( yy_cp < YY_CURRENT_BUFFER_LVALUE->yy_ch_buf + 2 )
 			YY_FATAL_ERROR( "flex scanner push-back overflow" );
@@ -4777,39 +4752,40 @@ static int yy_get_next_buffer (void)
 
 	*--yy_cp = (char) c;
 
-	(yytext_ptr) = yy_bp;
-	(yy_hold_char) = *yy_cp;
-	(yy_c_buf_p) = yy_cp;
+	yyg->yytext_ptr = yy_bp;
+	yyg->yy_hold_char = *yy_cp;
+	yyg->yy_c_buf_p = yy_cp;
 }
 
 #ifndef YY_NO_INPUT
 #ifdef __cplusplus
-    static int yyinput (void)
+    static int yyinput (yyscan_t yyscanner)
 #else
-    static int input  (void)
+    static int input  (yyscan_t yyscanner)
 #endif
 
 {
 	int c;
-    
-	*(yy_c_buf_p) = (yy_hold_char);
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 
-	if ( *(yy_c_buf_p) == YY_END_OF_BUFFER_CHAR )
+	*yyg->yy_c_buf_p = yyg->yy_hold_char;
+
+	if ( *yyg->yy_c_buf_p == YY_END_OF_BUFFER_CHAR )
 		{
 		/* yy_c_buf_p now points to the character we want to return.
 		 * If this occurs *before* the EOB characters, then it's a
 		 * valid NUL; if not, then we've hit the end of the buffer.
 		 */
-		if ( (yy_c_buf_p) < &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars)] )
+		if ( yyg->yy_c_buf_p < &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars] )
 			/* This was really a NUL. */
-			*(yy_c_buf_p) = '\0';
+			*yyg->yy_c_buf_p = '\0';
 
 		else
 			{ /* need more input */
-			int offset = (yy_c_buf_p) - (yytext_ptr);
-			++(yy_c_buf_p);
+			int offset = yyg->yy_c_buf_p - yyg->yytext_ptr;
+			++yyg->yy_c_buf_p;
 
-			switch ( yy_get_next_buffer(  ) )
+			switch ( yy_get_next_buffer( yyscanner ) )
 				{
 				case EOB_ACT_LAST_MATCH:
 					/* This happens because yy_g_n_b()
@@ -4823,34 +4799,34 @@ static int yy_get_next_buffer (void)
 					 */
 
 					/* Reset buffer status. */
-					msyyrestart(msyyin );
+					msyyrestart(yyin ,yyscanner);
 
 					/*FALLTHROUGH*/
 
 				case EOB_ACT_END_OF_FILE:
 					{
-					if ( msyywrap( ) )
+					if ( msyywrap(yyscanner ) )
 						return EOF;
 
-					if ( ! (yy_did_buffer_switch_on_eof) )
+					if ( ! yyg->yy_did_buffer_switch_on_eof )
 						YY_NEW_FILE;
 #ifdef __cplusplus
-					return yyinput();
+					return yyinput(yyscanner);
 #else
-					return input();
+					return input(yyscanner);
 #endif
 					}
 
 				case EOB_ACT_CONTINUE_SCAN:
-					(yy_c_buf_p) = (yytext_ptr) + offset;
+					yyg->yy_c_buf_p = yyg->yytext_ptr + offset;
 					break;
 				}
 			}
 		}
 
-	c = *(unsigned char *) (yy_c_buf_p);	/* cast for 8-bit char's */
-	*(yy_c_buf_p) = '\0';	/* preserve msyytext */
-	(yy_hold_char) = *++(yy_c_buf_p);
+	c = *(unsigned char *) yyg->yy_c_buf_p;	/* cast for 8-bit char's */
+	*yyg->yy_c_buf_p = '\0';	/* preserve yytext */
+	yyg->yy_hold_char = *++yyg->yy_c_buf_p;
 
 	return c;
 }
@@ -4858,63 +4834,66 @@ static int yy_get_next_buffer (void)
 
 /** Immediately switch to a different input stream.
  * @param input_file A readable stream.
- * 
+ * @param yyscanner The scanner object.
  * @note This function does not reset the start condition to @c INITIAL .
  */
-    void msyyrestart  (FILE * input_file )
+    void msyyrestart  (FILE * input_file , yyscan_t yyscanner)
 {
-    
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+
 	if ( ! YY_CURRENT_BUFFER ){
-        msyyensure_buffer_stack ();
+        msyyensure_buffer_stack (yyscanner);
 		YY_CURRENT_BUFFER_LVALUE =
-            msyy_create_buffer(msyyin,YY_BUF_SIZE );
+            msyy_create_buffer(yyin,YY_BUF_SIZE ,yyscanner);
 	}
 
-	msyy_init_buffer(YY_CURRENT_BUFFER,input_file );
-	msyy_load_buffer_state( );
+	msyy_init_buffer(YY_CURRENT_BUFFER,input_file ,yyscanner);
+	msyy_load_buffer_state(yyscanner );
 }
 
 /** Switch to a different input buffer.
  * @param new_buffer The new input buffer.
  * 
  */
-    void msyy_switch_to_buffer  (YY_BUFFER_STATE  new_buffer )
+    void msyy_switch_to_buffer  (YY_BUFFER_STATE  new_buffer , yyscan_t yyscanner)
 {
-    
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+
 	/* TODO. We should be able to replace this entire function body
 	 * with
-	 *		msyypop_buffer_state();
+	 *		msyypop_buffer_state(yyscanner);
 	 *		msyypush_buffer_state(new_buffer);
      */
-	msyyensure_buffer_stack ();
+	msyyensure_buffer_stack (yyscanner);
 	if ( YY_CURRENT_BUFFER == new_buffer )
 		return;
 
 	if ( YY_CURRENT_BUFFER )
 		{
 		/* Flush out information for old buffer. */
-		*(yy_c_buf_p) = (yy_hold_char);
-		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = (yy_c_buf_p);
-		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars);
+		*yyg->yy_c_buf_p = yyg->yy_hold_char;
+		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = yyg->yy_c_buf_p;
+		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = yyg->yy_n_chars;
 		}
 
 	YY_CURRENT_BUFFER_LVALUE = new_buffer;
-	msyy_load_buffer_state( );
+	msyy_load_buffer_state(yyscanner );
 
 	/* We don't actually know whether we did this switch during
 	 * EOF (msyywrap()) processing, but the only time this flag
 	 * is looked at is after msyywrap() is called, so it's safe
 	 * to go ahead and always set it.
 	 */
-	(yy_did_buffer_switch_on_eof) = 1;
+	yyg->yy_did_buffer_switch_on_eof = 1;
 }
 
-static void msyy_load_buffer_state  (void)
+static void msyy_load_buffer_state  (yyscan_t yyscanner)
 {
-    	(yy_n_chars) = YY_CURRENT_BUFFER_LVALUE->yy_n_chars;
-	(yytext_ptr) = (yy_c_buf_p) = YY_CURRENT_BUFFER_LVALUE->yy_buf_pos;
-	msyyin = YY_CURRENT_BUFFER_LVALUE->yy_input_file;
-	(yy_hold_char) = *(yy_c_buf_p);
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	yyg->yy_n_chars = YY_CURRENT_BUFFER_LVALUE->yy_n_chars;
+	yyg->yytext_ptr = yyg->yy_c_buf_p = YY_CURRENT_BUFFER_LVALUE->yy_buf_pos;
+	yyin = YY_CURRENT_BUFFER_LVALUE->yy_input_file;
+	yyg->yy_hold_char = *yyg->yy_c_buf_p;
 }
 
 /** Allocate and initialize an input buffer state.
@@ -4923,11 +4902,11 @@ static void msyy_load_buffer_state  (void)
  * 
  * @return the allocated buffer state.
  */
-    YY_BUFFER_STATE msyy_create_buffer  (FILE * file, int  size )
+    YY_BUFFER_STATE msyy_create_buffer  (FILE * file, int  size , yyscan_t yyscanner)
 {
 	YY_BUFFER_STATE b;
     
-	b = (YY_BUFFER_STATE) msyyalloc(sizeof( struct yy_buffer_state )  );
+	b = (YY_BUFFER_STATE) msyyalloc(sizeof( struct yy_buffer_state ) ,yyscanner );
 	if ( ! b )
 		YY_FATAL_ERROR( "out of dynamic memory in msyy_create_buffer()" );
 
@@ -4936,13 +4915,13 @@ static void msyy_load_buffer_state  (void)
 	/* yy_ch_buf has to be 2 characters longer than the size given because
 	 * we need to put in 2 end-of-buffer characters.
 	 */
-	b->yy_ch_buf = (char *) msyyalloc(b->yy_buf_size + 2  );
+	b->yy_ch_buf = (char *) msyyalloc(b->yy_buf_size + 2 ,yyscanner );
 	if ( ! b->yy_ch_buf )
 		YY_FATAL_ERROR( "out of dynamic memory in msyy_create_buffer()" );
 
 	b->yy_is_our_buffer = 1;
 
-	msyy_init_buffer(b,file );
+	msyy_init_buffer(b,file ,yyscanner);
 
 	return b;
 }
@@ -4951,9 +4930,10 @@ static void msyy_load_buffer_state  (void)
  * @param b a buffer created with msyy_create_buffer()
  * 
  */
-    void msyy_delete_buffer (YY_BUFFER_STATE  b )
+    void msyy_delete_buffer (YY_BUFFER_STATE  b , yyscan_t yyscanner)
 {
-    
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+
 	if ( ! b )
 		return;
 
@@ -4961,9 +4941,9 @@ static void msyy_load_buffer_state  (void)
 		YY_CURRENT_BUFFER_LVALUE = (YY_BUFFER_STATE) 0;
 
 	if ( b->yy_is_our_buffer )
-		msyyfree((void *) b->yy_ch_buf  );
+		msyyfree((void *) b->yy_ch_buf ,yyscanner );
 
-	msyyfree((void *) b  );
+	msyyfree((void *) b ,yyscanner );
 }
 
 #ifndef __cplusplus
@@ -4974,12 +4954,13 @@ extern int isatty (int );
  * This function is sometimes called more than once on the same buffer,
  * such as during a msyyrestart() or at EOF.
  */
-    static void msyy_init_buffer  (YY_BUFFER_STATE  b, FILE * file )
+    static void msyy_init_buffer  (YY_BUFFER_STATE  b, FILE * file , yyscan_t yyscanner)
 
 {
 	int oerrno = errno;
-    
-	msyy_flush_buffer(b );
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+
+	msyy_flush_buffer(b ,yyscanner);
 
 	b->yy_input_file = file;
 	b->yy_fill_buffer = 1;
@@ -5002,9 +4983,10 @@ extern int isatty (int );
  * @param b the buffer state to be flushed, usually @c YY_CURRENT_BUFFER.
  * 
  */
-    void msyy_flush_buffer (YY_BUFFER_STATE  b )
+    void msyy_flush_buffer (YY_BUFFER_STATE  b , yyscan_t yyscanner)
 {
-    	if ( ! b )
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	if ( ! b )
 		return;
 
 	b->yy_n_chars = 0;
@@ -5022,7 +5004,7 @@ extern int isatty (int );
 	b->yy_buffer_status = YY_BUFFER_NEW;
 
 	if ( b == YY_CURRENT_BUFFER )
-		msyy_load_buffer_state( );
+		msyy_load_buffer_state(yyscanner );
 }
 
 /** Pushes the new state onto the stack. The new state becomes
@@ -5031,95 +5013,98 @@ extern int isatty (int );
  *  @param new_buffer The new state.
  *  
  */
-void msyypush_buffer_state (YY_BUFFER_STATE new_buffer )
+void msyypush_buffer_state (YY_BUFFER_STATE new_buffer , yyscan_t yyscanner)
 {
-    	if (new_buffer == NULL)
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	if (new_buffer == NULL)
 		return;
 
-	msyyensure_buffer_stack();
+	msyyensure_buffer_stack(yyscanner);
 
 	/* This block is copied from msyy_switch_to_buffer. */
 	if ( YY_CURRENT_BUFFER )
 		{
 		/* Flush out information for old buffer. */
-		*(yy_c_buf_p) = (yy_hold_char);
-		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = (yy_c_buf_p);
-		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars);
+		*yyg->yy_c_buf_p = yyg->yy_hold_char;
+		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = yyg->yy_c_buf_p;
+		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = yyg->yy_n_chars;
 		}
 
 	/* Only push if top exists. Otherwise, replace top. */
 	if (YY_CURRENT_BUFFER)
-		(yy_buffer_stack_top)++;
+		yyg->yy_buffer_stack_top++;
 	YY_CURRENT_BUFFER_LVALUE = new_buffer;
 
 	/* copied from msyy_switch_to_buffer. */
-	msyy_load_buffer_state( );
-	(yy_did_buffer_switch_on_eof) = 1;
+	msyy_load_buffer_state(yyscanner );
+	yyg->yy_did_buffer_switch_on_eof = 1;
 }
 
 /** Removes and deletes the top of the stack, if present.
  *  The next element becomes the new top.
  *  
  */
-void msyypop_buffer_state (void)
+void msyypop_buffer_state (yyscan_t yyscanner)
 {
-    	if (!YY_CURRENT_BUFFER)
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	if (!YY_CURRENT_BUFFER)
 		return;
 
-	msyy_delete_buffer(YY_CURRENT_BUFFER );
+	msyy_delete_buffer(YY_CURRENT_BUFFER ,yyscanner);
 	YY_CURRENT_BUFFER_LVALUE = NULL;
-	if ((yy_buffer_stack_top) > 0)
-		--(yy_buffer_stack_top);
+	if (yyg->yy_buffer_stack_top > 0)
+		--yyg->yy_buffer_stack_top;
 
 	if (YY_CURRENT_BUFFER) {
-		msyy_load_buffer_state( );
-		(yy_did_buffer_switch_on_eof) = 1;
+		msyy_load_buffer_state(yyscanner );
+		yyg->yy_did_buffer_switch_on_eof = 1;
 	}
 }
 
 /* Allocates the stack if it does not exist.
  *  Guarantees space for at least one push.
  */
-static void msyyensure_buffer_stack (void)
+static void msyyensure_buffer_stack (yyscan_t yyscanner)
 {
 	int num_to_alloc;
-    
-	if (!(yy_buffer_stack)) {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+
+	if (!yyg->yy_buffer_stack) {
 
 		/* First allocation is just for 2 elements, since we don't know if this
 		 * scanner will even need a stack. We use 2 instead of 1 to avoid an
 		 * immediate realloc on the next call.
          */
 		num_to_alloc = 1;
-		(yy_buffer_stack) = (struct yy_buffer_state**)msyyalloc
+		yyg->yy_buffer_stack = (struct yy_buffer_state**)msyyalloc
 								(num_to_alloc * sizeof(struct yy_buffer_state*)
-								);
-		if ( ! (yy_buffer_stack) )
-			YY_FATAL_ERROR( "out of dynamic memory in msyyensure_buffer_stack()" );
+								,yyscanner);
+		if ( ! yyg->yy_buffer_stack )
+			YY_FATAL_ERROR( "out of dynamic memory in msyyensure_buffer_stack(yyscanner)" );
 								  
-		memset((yy_buffer_stack), 0, num_to_alloc * sizeof(struct yy_buffer_state*));
+		memset(yyg->yy_buffer_stack, 0, num_to_alloc * sizeof(struct yy_buffer_state*));
 				
-		(yy_buffer_stack_max) = num_to_alloc;
-		(yy_buffer_stack_top) = 0;
+		yyg->yy_buffer_stack_max = num_to_alloc;
+		yyg->yy_buffer_stack_top = 0;
 		return;
 	}
 
-	if ((yy_buffer_stack_top) >= ((yy_buffer_stack_max)) - 1){
+	if (yyg->yy_buffer_stack_top >= (yyg->yy_buffer_stack_max) - 1){
 
 		/* Increase the buffer to prepare for a possible push. */
 		int grow_size = 8 /* arbitrary grow size */;
 
-		num_to_alloc = (yy_buffer_stack_max) + grow_size;
-		(yy_buffer_stack) = (struct yy_buffer_state**)msyyrealloc
-								((yy_buffer_stack),
+		num_to_alloc = yyg->yy_buffer_stack_max + grow_size;
+		yyg->yy_buffer_stack = (struct yy_buffer_state**)msyyrealloc
+								(yyg->yy_buffer_stack,
 								num_to_alloc * sizeof(struct yy_buffer_state*)
-								);
-		if ( ! (yy_buffer_stack) )
-			YY_FATAL_ERROR( "out of dynamic memory in msyyensure_buffer_stack()" );
+								,yyscanner);
+		if ( ! yyg->yy_buffer_stack )
+			YY_FATAL_ERROR( "out of dynamic memory in msyyensure_buffer_stack(yyscanner)" );
 
 		/* zero only the new slots.*/
-		memset((yy_buffer_stack) + (yy_buffer_stack_max), 0, grow_size * sizeof(struct yy_buffer_state*));
-		(yy_buffer_stack_max) = num_to_alloc;
+		memset(yyg->yy_buffer_stack + yyg->yy_buffer_stack_max, 0, grow_size * sizeof(struct yy_buffer_state*));
+		yyg->yy_buffer_stack_max = num_to_alloc;
 	}
 }
 
@@ -5129,7 +5114,7 @@ static void msyyensure_buffer_stack (void)
  * 
  * @return the newly allocated buffer state object. 
  */
-YY_BUFFER_STATE msyy_scan_buffer  (char * base, yy_size_t  size )
+YY_BUFFER_STATE msyy_scan_buffer  (char * base, yy_size_t  size , yyscan_t yyscanner)
 {
 	YY_BUFFER_STATE b;
     
@@ -5139,7 +5124,7 @@ YY_BUFFER_STATE msyy_scan_buffer  (char * base, yy_size_t  size )
 		/* They forgot to leave room for the EOB's. */
 		return 0;
 
-	b = (YY_BUFFER_STATE) msyyalloc(sizeof( struct yy_buffer_state )  );
+	b = (YY_BUFFER_STATE) msyyalloc(sizeof( struct yy_buffer_state ) ,yyscanner );
 	if ( ! b )
 		YY_FATAL_ERROR( "out of dynamic memory in msyy_scan_buffer()" );
 
@@ -5153,7 +5138,7 @@ YY_BUFFER_STATE msyy_scan_buffer  (char * base, yy_size_t  size )
 	b->yy_fill_buffer = 0;
 	b->yy_buffer_status = YY_BUFFER_NEW;
 
-	msyy_switch_to_buffer(b  );
+	msyy_switch_to_buffer(b ,yyscanner);
 
 	return b;
 }
@@ -5166,10 +5151,10 @@ YY_BUFFER_STATE msyy_scan_buffer  (char * base, yy_size_t  size )
  * @note If you want to scan bytes that may contain NUL values, then use
  *       msyy_scan_bytes() instead.
  */
-YY_BUFFER_STATE msyy_scan_string (yyconst char * yystr )
+YY_BUFFER_STATE msyy_scan_string (yyconst char * yystr , yyscan_t yyscanner)
 {
     
-	return msyy_scan_bytes(yystr,strlen(yystr) );
+	return msyy_scan_bytes(yystr,strlen(yystr) ,yyscanner);
 }
 
 /** Setup the input buffer state to scan the given bytes. The next call to msyylex() will
@@ -5179,7 +5164,7 @@ YY_BUFFER_STATE msyy_scan_string (yyconst char * yystr )
  * 
  * @return the newly allocated buffer state object.
  */
-YY_BUFFER_STATE msyy_scan_bytes  (yyconst char * yybytes, int  _yybytes_len )
+YY_BUFFER_STATE msyy_scan_bytes  (yyconst char * yybytes, int  _yybytes_len , yyscan_t yyscanner)
 {
 	YY_BUFFER_STATE b;
 	char *buf;
@@ -5188,7 +5173,7 @@ YY_BUFFER_STATE msyy_scan_bytes  (yyconst char * yybytes, int  _yybytes_len )
     
 	/* Get memory for full buffer, including space for trailing EOB's. */
 	n = _yybytes_len + 2;
-	buf = (char *) msyyalloc(n  );
+	buf = (char *) msyyalloc(n ,yyscanner );
 	if ( ! buf )
 		YY_FATAL_ERROR( "out of dynamic memory in msyy_scan_bytes()" );
 
@@ -5197,7 +5182,7 @@ YY_BUFFER_STATE msyy_scan_bytes  (yyconst char * yybytes, int  _yybytes_len )
 
 	buf[_yybytes_len] = buf[_yybytes_len+1] = YY_END_OF_BUFFER_CHAR;
 
-	b = msyy_scan_buffer(buf,n );
+	b = msyy_scan_buffer(buf,n ,yyscanner);
 	if ( ! b )
 		YY_FATAL_ERROR( "bad buffer in msyy_scan_bytes()" );
 
@@ -5213,7 +5198,7 @@ YY_BUFFER_STATE msyy_scan_bytes  (yyconst char * yybytes, int  _yybytes_len )
 #define YY_EXIT_FAILURE 2
 #endif
 
-static void yy_fatal_error (yyconst char* msg )
+static void yy_fatal_error (yyconst char* msg , yyscan_t yyscanner)
 {
     	(void) fprintf( stderr, "%s\n", msg );
 	exit( YY_EXIT_FAILURE );
@@ -5225,117 +5210,252 @@ static void yy_fatal_error (yyconst char* msg )
 #define yyless(n) \
 	do \
 		{ \
-		/* Undo effects of setting up msyytext. */ \
+		/* Undo effects of setting up yytext. */ \
         int yyless_macro_arg = (n); \
         YY_LESS_LINENO(yyless_macro_arg);\
-		msyytext[msyyleng] = (yy_hold_char); \
-		(yy_c_buf_p) = msyytext + yyless_macro_arg; \
-		(yy_hold_char) = *(yy_c_buf_p); \
-		*(yy_c_buf_p) = '\0'; \
-		msyyleng = yyless_macro_arg; \
+		yytext[yyleng] = yyg->yy_hold_char; \
+		yyg->yy_c_buf_p = yytext + yyless_macro_arg; \
+		yyg->yy_hold_char = *yyg->yy_c_buf_p; \
+		*yyg->yy_c_buf_p = '\0'; \
+		yyleng = yyless_macro_arg; \
 		} \
 	while ( 0 )
 
 /* Accessor  methods (get/set functions) to struct members. */
 
+/** Get the user-defined data for this scanner.
+ * @param yyscanner The scanner object.
+ */
+YY_EXTRA_TYPE msyyget_extra  (yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yyextra;
+}
+
 /** Get the current line number.
- * 
+ * @param yyscanner The scanner object.
  */
-int msyyget_lineno  (void)
+int msyyget_lineno  (yyscan_t yyscanner)
 {
-        
-    return msyylineno;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    
+        if (! YY_CURRENT_BUFFER)
+            return 0;
+    
+    return yylineno;
+}
+
+/** Get the current column number.
+ * @param yyscanner The scanner object.
+ */
+int msyyget_column  (yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    
+        if (! YY_CURRENT_BUFFER)
+            return 0;
+    
+    return yycolumn;
 }
 
 /** Get the input stream.
- * 
+ * @param yyscanner The scanner object.
  */
-FILE *msyyget_in  (void)
+FILE *msyyget_in  (yyscan_t yyscanner)
 {
-        return msyyin;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yyin;
 }
 
 /** Get the output stream.
- * 
+ * @param yyscanner The scanner object.
  */
-FILE *msyyget_out  (void)
+FILE *msyyget_out  (yyscan_t yyscanner)
 {
-        return msyyout;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yyout;
 }
 
 /** Get the length of the current token.
- * 
+ * @param yyscanner The scanner object.
  */
-int msyyget_leng  (void)
+int msyyget_leng  (yyscan_t yyscanner)
 {
-        return msyyleng;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yyleng;
 }
 
 /** Get the current token.
- * 
+ * @param yyscanner The scanner object.
  */
 
-char *msyyget_text  (void)
+char *msyyget_text  (yyscan_t yyscanner)
 {
-        return msyytext;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yytext;
+}
+
+/** Set the user-defined data. This data is never touched by the scanner.
+ * @param user_defined The data to be associated with this scanner.
+ * @param yyscanner The scanner object.
+ */
+void msyyset_extra (YY_EXTRA_TYPE  user_defined , yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    yyextra = user_defined ;
 }
 
 /** Set the current line number.
  * @param line_number
- * 
+ * @param yyscanner The scanner object.
  */
-void msyyset_lineno (int  line_number )
+void msyyset_lineno (int  line_number , yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+
+        /* lineno is only valid if an input buffer exists. */
+        if (! YY_CURRENT_BUFFER )
+           yy_fatal_error( "msyyset_lineno called with no buffer" , yyscanner); 
     
-    msyylineno = line_number;
+    yylineno = line_number;
+}
+
+/** Set the current column.
+ * @param line_number
+ * @param yyscanner The scanner object.
+ */
+void msyyset_column (int  column_no , yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+
+        /* column is only valid if an input buffer exists. */
+        if (! YY_CURRENT_BUFFER )
+           yy_fatal_error( "msyyset_column called with no buffer" , yyscanner); 
+    
+    yycolumn = column_no;
 }
 
 /** Set the input stream. This does not discard the current
  * input buffer.
  * @param in_str A readable stream.
- * 
+ * @param yyscanner The scanner object.
  * @see msyy_switch_to_buffer
  */
-void msyyset_in (FILE *  in_str )
+void msyyset_in (FILE *  in_str , yyscan_t yyscanner)
 {
-        msyyin = in_str ;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    yyin = in_str ;
 }
 
-void msyyset_out (FILE *  out_str )
+void msyyset_out (FILE *  out_str , yyscan_t yyscanner)
 {
-        msyyout = out_str ;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    yyout = out_str ;
 }
 
-int msyyget_debug  (void)
+int msyyget_debug  (yyscan_t yyscanner)
 {
-        return msyy_flex_debug;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yy_flex_debug;
 }
 
-void msyyset_debug (int  bdebug )
+void msyyset_debug (int  bdebug , yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    yy_flex_debug = bdebug ;
+}
+
+/* Accessor methods for yylval and yylloc */
+
+/* User-visible API */
+
+/* msyylex_init is special because it creates the scanner itself, so it is
+ * the ONLY reentrant function that doesn't take the scanner as the last argument.
+ * That's why we explicitly handle the declaration, instead of using our macros.
+ */
+
+int msyylex_init(yyscan_t* ptr_yy_globals)
+
+{
+    if (ptr_yy_globals == NULL){
+        errno = EINVAL;
+        return 1;
+    }
+
+    *ptr_yy_globals = (yyscan_t) msyyalloc ( sizeof( struct yyguts_t ), NULL );
+
+    if (*ptr_yy_globals == NULL){
+        errno = ENOMEM;
+        return 1;
+    }
+
+    /* By setting to 0xAA, we expose bugs in yy_init_globals. Leave at 0x00 for releases. */
+    memset(*ptr_yy_globals,0x00,sizeof(struct yyguts_t));
+
+    return yy_init_globals ( *ptr_yy_globals );
+}
+
+/* msyylex_init_extra has the same functionality as msyylex_init, but follows the
+ * convention of taking the scanner as the last argument. Note however, that
+ * this is a *pointer* to a scanner, as it will be allocated by this call (and
+ * is the reason, too, why this function also must handle its own declaration).
+ * The user defined value in the first argument will be available to msyyalloc in
+ * the yyextra field.
+ */
+
+int msyylex_init_extra(YY_EXTRA_TYPE yy_user_defined,yyscan_t* ptr_yy_globals )
+
 {
-        msyy_flex_debug = bdebug ;
+    struct yyguts_t dummy_yyguts;
+
+    msyyset_extra (yy_user_defined, &dummy_yyguts);
+
+    if (ptr_yy_globals == NULL){
+        errno = EINVAL;
+        return 1;
+    }
+	
+    *ptr_yy_globals = (yyscan_t) msyyalloc ( sizeof( struct yyguts_t ), &dummy_yyguts );
+	
+    if (*ptr_yy_globals == NULL){
+        errno = ENOMEM;
+        return 1;
+    }
+    
+    /* By setting to 0xAA, we expose bugs in
+    yy_init_globals. Leave at 0x00 for releases. */
+    memset(*ptr_yy_globals,0x00,sizeof(struct yyguts_t));
+    
+    msyyset_extra (yy_user_defined, *ptr_yy_globals);
+    
+    return yy_init_globals ( *ptr_yy_globals );
 }
 
-static int yy_init_globals (void)
+static int yy_init_globals (yyscan_t yyscanner)
 {
-        /* Initialization is the same as for the non-reentrant scanner.
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    /* Initialization is the same as for the non-reentrant scanner.
      * This function is called from msyylex_destroy(), so don't allocate here.
      */
 
-    (yy_buffer_stack) = 0;
-    (yy_buffer_stack_top) = 0;
-    (yy_buffer_stack_max) = 0;
-    (yy_c_buf_p) = (char *) 0;
-    (yy_init) = 0;
-    (yy_start) = 0;
+    yyg->yy_buffer_stack = 0;
+    yyg->yy_buffer_stack_top = 0;
+    yyg->yy_buffer_stack_max = 0;
+    yyg->yy_c_buf_p = (char *) 0;
+    yyg->yy_init = 0;
+    yyg->yy_start = 0;
+
+    yyg->yy_start_stack_ptr = 0;
+    yyg->yy_start_stack_depth = 0;
+    yyg->yy_start_stack =  NULL;
 
 /* Defined in main.c */
 #ifdef YY_STDINIT
-    msyyin = stdin;
-    msyyout = stdout;
+    yyin = stdin;
+    yyout = stdout;
 #else
-    msyyin = (FILE *) 0;
-    msyyout = (FILE *) 0;
+    yyin = (FILE *) 0;
+    yyout = (FILE *) 0;
 #endif
 
     /* For future reference: Set errno on error, since we are called by
@@ -5345,24 +5465,32 @@ static int yy_init_globals (void)
 }
 
 /* msyylex_destroy is for both reentrant and non-reentrant scanners. */
-int msyylex_destroy  (void)
+int msyylex_destroy  (yyscan_t yyscanner)
 {
-    
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+
     /* Pop the buffer stack, destroying each element. */
 	while(YY_CURRENT_BUFFER){
-		msyy_delete_buffer(YY_CURRENT_BUFFER  );
+		msyy_delete_buffer(YY_CURRENT_BUFFER ,yyscanner );
 		YY_CURRENT_BUFFER_LVALUE = NULL;
-		msyypop_buffer_state();
+		msyypop_buffer_state(yyscanner);
 	}
 
 	/* Destroy the stack itself. */
-	msyyfree((yy_buffer_stack) );
-	(yy_buffer_stack) = NULL;
+	msyyfree(yyg->yy_buffer_stack ,yyscanner);
+	yyg->yy_buffer_stack = NULL;
+
+    /* Destroy the start condition stack. */
+        msyyfree(yyg->yy_start_stack ,yyscanner );
+        yyg->yy_start_stack = NULL;
 
     /* Reset the globals. This is important in a non-reentrant scanner so the next time
      * msyylex() is called, initialization will occur. */
-    yy_init_globals( );
+    yy_init_globals( yyscanner);
 
+    /* Destroy the main struct (reentrant only). */
+    msyyfree ( yyscanner , yyscanner );
+    yyscanner = NULL;
     return 0;
 }
 
@@ -5371,7 +5499,7 @@ int msyylex_destroy  (void)
  */
 
 #ifndef yytext_ptr
-static void yy_flex_strncpy (char* s1, yyconst char * s2, int n )
+static void yy_flex_strncpy (char* s1, yyconst char * s2, int n , yyscan_t yyscanner)
 {
 	register int i;
 	for ( i = 0; i < n; ++i )
@@ -5380,7 +5508,7 @@ static void yy_flex_strncpy (char* s1, yyconst char * s2, int n )
 #endif
 
 #ifdef YY_NEED_STRLEN
-static int yy_flex_strlen (yyconst char * s )
+static int yy_flex_strlen (yyconst char * s , yyscan_t yyscanner)
 {
 	register int n;
 	for ( n = 0; s[n]; ++n )
@@ -5390,12 +5518,12 @@ static int yy_flex_strlen (yyconst char * s )
 }
 #endif
 
-void *msyyalloc (yy_size_t  size )
+void *msyyalloc (yy_size_t  size , yyscan_t yyscanner)
 {
 	return (void *) malloc( size );
 }
 
-void *msyyrealloc  (void * ptr, yy_size_t  size )
+void *msyyrealloc  (void * ptr, yy_size_t  size , yyscan_t yyscanner)
 {
 	/* The cast to (char *) in the following accommodates both
 	 * implementations that use char* generic pointers, and those
@@ -5407,22 +5535,20 @@ void *msyyrealloc  (void * ptr, yy_size_t  size )
 	return (void *) realloc( (char *) ptr, size );
 }
 
-void msyyfree (void * ptr )
+void msyyfree (void * ptr , yyscan_t yyscanner)
 {
 	free( (char *) ptr );	/* see msyyrealloc() for (char *) cast */
 }
 
 #define YYTABLES_NAME "yytables"
 
-#line 727 "/home/even/mapserver/git/mapserver/maplexer.l"
-
-
+#line 705 "/home/even/mapserver/git/mapserver/maplexer.l"
 
 /*
 ** Any extra C functions
 */
 
-int msyywrap() /* override */
+int msyywrap(yyscan_t yyscanner) /* override */
 {
   return(1);
 }
@@ -5432,3 +5558,48 @@ int msyyerror(char *s) {
   return(0);
 }
 
+/*
+** Sets up a scanner for lexer, to be released with msFreeLexer(). Then set
+** lexer->state (and lexer->string or the input file) and call msyylex()
+** once, as usual, to start tokenizing.
+*/
+int msInitLexer(lexerObj *lexer)
+{
+  memset(lexer, 0, sizeof(lexerObj));
+  lexer->state = MS_TOKENIZE_DEFAULT;
+  lexer->source = MS_STRING_TOKENS;
+  lexer->string_buffer_size = 256;
+  lexer->string_icase = MS_FALSE;
+
+  if(msyylex_init_extra(lexer, &(lexer->scanner)) != 0) {
+    msSetError(MS_MEMERR, "Failed to allocate scanner.", "msInitLexer()");
+    return(MS_FAILURE);
+  }
+
+  return(MS_SUCCESS);
+}
+
+/*
+** Releases the scanner and buffers of lexer, closing the INCLUDEd files a
+** parse error left open. The input file, if any, is up to the caller.
+*/
+void msFreeLexer(lexerObj *lexer)
+{
+  struct yyguts_t *yyg;
+
+  if(!lexer || !lexer->scanner) return;
+
+  yyg = (struct yyguts_t *) lexer->scanner;
+  while(lexer->include_stack_ptr > 0) {
+    lexer->include_stack_ptr--;
+    fclose(YY_CURRENT_BUFFER->yy_input_file);
+    msyy_delete_buffer(YY_CURRENT_BUFFER, lexer->scanner);
+    msyy_switch_to_buffer(lexer->include_stack[lexer->include_stack_ptr], lexer->scanner);
+  }
+
+  msyylex_destroy(lexer->scanner);
+  lexer->scanner = NULL;
+
+  msFree(lexer->string_buffer);
+  lexer->string_buffer = NULL;
+}
@@ -91,6 +91,7 @@ void msFreeMap(mapObj *map)
   msFree(map->name);
   msFree(map->shapepath);
   msFree(map->mappath);
+  msFree(map->filename);
 
   msFreeProjection(&(map->projection));
   msFreeProjection(&(map->latlon));
@@ -111,13 +112,14 @@ void msFreeMap(mapObj *map)
   freeLegend(&(map->legend));
 
   for(i=0; i<map->maxlayers; i++) {
-    if(GET_LAYER(map, i) != NULL) {
-      GET_LAYER(map, i)->map = NULL;
-      if(freeLayer((GET_LAYER(map, i))) == MS_SUCCESS)
-        free(GET_LAYER(map, i));
+    if(map->layers[i] != NULL) {
+      map->layers[i]->map = NULL;
+      if(freeLayer(map->layers[i]) == MS_SUCCESS)
+        free(map->layers[i]);
     }
   }
   msFree(map->layers);
+  msFreeNameIndex(&(map->layerindex));
 
   if(map->layerorder)
     free(map->layerorder);
@@ -173,8 +175,7 @@ int msSetConfigOption( mapObj *map, const char *key, const char *value)
       return MS_FAILURE;
   }
 
-  if( msLookupHashTable( &(map->configoptions), key ) != NULL )
-    msRemoveHashTable( &(map->configoptions), key );
+  /* replaces any previous value, key and value may come from the table itself */
   msInsertHashTable( &(map->configoptions), key, value );
 
   return MS_SUCCESS;
@@ -542,9 +543,9 @@ int msInsertLayer(mapObj *map, layerObj *layer, int nIndex)
     return -1;
   } else if (nIndex < 0) { /* Insert at the end by default */
     map->layerorder[map->numlayers] = map->numlayers;
-    GET_LAYER(map, map->numlayers) = layer;
-    GET_LAYER(map, map->numlayers)->index = map->numlayers;
-    GET_LAYER(map, map->numlayers)->map = map;
+    map->layers[map->numlayers] = layer;
+    map->layers[map->numlayers]->index = map->numlayers;
+    map->layers[map->numlayers]->map = map;
     MS_REFCNT_INCR(layer);
     map->numlayers++;
     return map->numlayers-1;
@@ -553,14 +554,14 @@ int msInsertLayer(mapObj *map, layerObj *layer, int nIndex)
     /* to an index one higher */
     int i;
     for (i=map->numlayers; i>nIndex; i--) {
-      GET_LAYER(map, i)=GET_LAYER(map, i-1);
-      GET_LAYER(map, i)->index = i;
+      map->layers[i]=map->layers[i-1];
+      map->layers[i]->index = i;
     }
 
     /* assign new layer to specified index */
-    GET_LAYER(map, nIndex)=layer;
-    GET_LAYER(map, nIndex)->index = nIndex;
-    GET_LAYER(map, nIndex)->map = map;
+    map->layers[nIndex]=layer;
+    map->layers[nIndex]->index = nIndex;
+    map->layers[nIndex]->map = map;
 
     /* adjust layers drawing order */
     for (i=map->numlayers; i>nIndex; i--) {
@@ -575,6 +576,7 @@ int msInsertLayer(mapObj *map, layerObj *layer, int nIndex)
     /* increment number of layers and return */
     MS_REFCNT_INCR(layer);
     map->numlayers++;
+    msFreeNameIndex(&(map->layerindex)); /* positions have shifted */
     return nIndex;
   } else {
     msSetError(MS_CHILDERR, "Invalid index", "msInsertLayer()");
@@ -604,12 +606,12 @@ layerObj *msRemoveLayer(mapObj *map, int nIndex)
       /* freeLayer((GET_LAYER(map, i))); */
       /* initLayer((GET_LAYER(map, i)), map); */
       /* msCopyLayer(GET_LAYER(map, i), GET_LAYER(map, i+1)); */
-      GET_LAYER(map, i)=GET_LAYER(map, i+1);
-      GET_LAYER(map, i)->index = i;
+      map->layers[i]=map->layers[i+1];
+      map->layers[i]->index = i;
     }
     /* Free the extra layer at the end */
     /* freeLayer((GET_LAYER(map, map->numlayers-1))); */
-    GET_LAYER(map, map->numlayers-1)=NULL;
+    map->layers[map->numlayers-1]=NULL;
 
     /* Adjust drawing order */
     order_index = 0;
@@ -627,6 +629,7 @@ layerObj *msRemoveLayer(mapObj *map, int nIndex)
 
     /* decrement number of layers and return copy of removed layer */
     map->numlayers--;
+    msFreeNameIndex(&(map->layerindex));
     layer->map=NULL;
     MS_REFCNT_DECR(layer);
     return layer;
@@ -30,6 +30,7 @@
 #include "mapserver.h"
 #include "maptime.h"
 #include "maptemplate.h"
+#include "mapthread.h"
 
 #if defined(USE_LIBXML2)
 #include "maplibxml2.h"
@@ -198,6 +199,439 @@ static int msOWSPreParseRequest(cgiRequestObj *request,
   return MS_SUCCESS;
 }
 
+/*
+** GetCapabilities documents kept across requests by msOWSDispatch(), most
+** recently used first. The MS_CAPABILITIES_CACHE_SIZE environment variable
+** sets how many are kept in memory; MS_CAPABILITIES_CACHE_DIR, in the
+** environment or as a mapfile CONFIG (relative to the mapfile, and refused
+** from a URL, see updateMapFromURL()), names a directory where a copy of
+** each document is also written, for processes that only serve one request.
+** Both are unset by default, which disables the cache. The directory holds
+** at most MS_CAPABILITIES_CACHE_DIR_SIZE files (100 by default): a document
+** goes to the file its key hashes to, replacing whatever was there.
+**
+** A document is kept with everything written to stdout, headers included, and
+** is keyed by the mapfile it was built from (path, modification time and size
+** at load time, so editing the mapfile invalidates it), the online resource
+** and the request parameters that shape the document (see
+** capabilitiesCacheKey()). Other parameters are left out so that they cannot
+** fill the cache; UPDATESEQUENCE is negotiated against the map before a
+** cached document is used. Only documents built for GET
+** requests on maps loaded from a file are kept, and only if the service did
+** not fail. Changes made to the mapObj by code rather than by the request
+** (mapscript) are not seen by the cache.
+*/
+typedef struct capabilitiesCacheEntryObj {
+  char *key;
+  char *document;
+  int size;
+  struct capabilitiesCacheEntryObj *next;
+} capabilitiesCacheEntryObj;
+
+static capabilitiesCacheEntryObj *capabilitiesCacheHead = NULL;
+static int capabilitiesCacheMaxCount = 0;
+static int capabilitiesCacheConfigured = MS_FALSE;
+
+static void capabilitiesCacheFreeList(capabilitiesCacheEntryObj *entry)
+{
+  capabilitiesCacheEntryObj *next;
+
+  for( ; entry; entry=next) {
+    next = entry->next;
+    msFree(entry->key);
+    msFree(entry->document);
+    free(entry);
+  }
+}
+
+/* unlinks the entries past the maximum count, or the entry for key, returns them */
+static capabilitiesCacheEntryObj *capabilitiesCacheUnlink(const char *key, int maxcount)
+{
+  capabilitiesCacheEntryObj **link = &capabilitiesCacheHead, *entry, *unlinked = NULL;
+  int count = 0;
+
+  while((entry = *link) != NULL) {
+    if((key && strcmp(entry->key, key) == 0) || (!key && count >= maxcount)) {
+      *link = entry->next;
+      entry->next = unlinked;
+      unlinked = entry;
+    } else {
+      link = &entry->next;
+      count++;
+    }
+  }
+
+  return unlinked;
+}
+
+#if defined(USE_WMS_SVR) || defined (USE_WFS_SVR) || defined (USE_WCS_SVR)
+static int capabilitiesCacheGetMaxCount(void)
+{
+  int maxcount;
+
+  msAcquireLock(TLOCK_CAPSCACHE);
+  if(!capabilitiesCacheConfigured) {
+    const char *value = getenv("MS_CAPABILITIES_CACHE_SIZE");
+    capabilitiesCacheMaxCount = value ? MS_MAX(atoi(value), 0) : 0;
+    capabilitiesCacheConfigured = MS_TRUE;
+  }
+  maxcount = capabilitiesCacheMaxCount;
+  msReleaseLock(TLOCK_CAPSCACHE);
+
+  return maxcount;
+}
+
+#define MS_CAPABILITIES_CACHE_DIR_SIZE 100
+
+/* full path of the on-disk copy of the document for key, or NULL */
+static char *capabilitiesCacheFile(mapObj *map, const char *key)
+{
+  char szPath[MS_MAXPATHLEN], szName[64];
+  const char *dir, *value;
+  unsigned h = 5381, numfiles = MS_CAPABILITIES_CACHE_DIR_SIZE;
+  const unsigned char *c;
+
+  if((dir = msGetConfigOption(map, "MS_CAPABILITIES_CACHE_DIR")) == NULL &&
+      (dir = getenv("MS_CAPABILITIES_CACHE_DIR")) == NULL)
+    return NULL;
+  if((value = getenv("MS_CAPABILITIES_CACHE_DIR_SIZE")) != NULL && atoi(value) > 0)
+    numfiles = atoi(value);
+
+  /* keys share the files, the key stored in the file tells them apart */
+  for(c = (const unsigned char *) key; *c; c++)
+    h = (h * 33) ^ *c;
+  snprintf(szName, sizeof(szName), "capabilities_%u.cache", h % numfiles);
+
+  if(msBuildPath3(szPath, map->mappath, dir, szName) == NULL) {
+    msResetErrorList();
+    return NULL;
+  }
+  return msStrdup(szPath);
+}
+
+static int capabilitiesCacheReadFile(const char *path, const char *key, char **document, int *size)
+{
+  FILE *stream;
+  char *data;
+  long length;
+  int keylength, offset;
+
+  if((stream = fopen(path, "rb")) == NULL)
+    return MS_FAILURE;
+
+  if(fseek(stream, 0, SEEK_END) != 0 || (length = ftell(stream)) <= 0 || fseek(stream, 0, SEEK_SET) != 0) {
+    fclose(stream);
+    return MS_FAILURE;
+  }
+
+  data = (char *) msSmallMalloc(length + 1);
+  if(fread(data, 1, length, stream) != (size_t) length) {
+    fclose(stream);
+    free(data);
+    return MS_FAILURE;
+  }
+  fclose(stream);
+  data[length] = '\0';
+
+  /* "<key length>\n<key><document>" */
+  keylength = atoi(data);
+  offset = (int)(strchr(data, '\n') ? strchr(data, '\n') - data + 1 : length);
+  if(keylength != (int) strlen(key) || offset + keylength > length ||
+      strncmp(data + offset, key, keylength) != 0) {
+    free(data);
+    return MS_FAILURE;
+  }
+
+  offset += keylength;
+  *size = (int)(length - offset);
+  memmove(data, data + offset, *size);
+  *document = data;
+
+  return MS_SUCCESS;
+}
+
+static void capabilitiesCacheWriteFile(const char *path, const char *key, const char *document, int size)
+{
+  char *tmppath;
+  FILE *stream;
+  int status;
+
+  /* written aside and renamed so that readers never see half a document */
+  tmppath = (char *) msSmallMalloc(strlen(path) + 32);
+  sprintf(tmppath, "%s.%d.tmp", path, (int) getpid());
+
+  if((stream = fopen(tmppath, "wb")) == NULL) {
+    msDebug("capabilitiesCacheWriteFile(): cannot write %s.\n", tmppath);
+    free(tmppath);
+    return;
+  }
+  status = (fprintf(stream, "%d\n%s", (int) strlen(key), key) > 0 &&
+            fwrite(document, 1, size, stream) == (size_t) size);
+  status = (fclose(stream) == 0) && status;
+
+  if(!status || rename(tmppath, path) != 0) {
+    msDebug("capabilitiesCacheWriteFile(): cannot write %s.\n", path);
+    remove(tmppath);
+  }
+  free(tmppath);
+}
+
+/* keeps a copy of document in memory, if the memory cache is enabled */
+static void capabilitiesCacheInsert(const char *key, const char *document, int size)
+{
+  capabilitiesCacheEntryObj *entry, *evicted;
+
+  if(capabilitiesCacheGetMaxCount() == 0)
+    return;
+
+  entry = (capabilitiesCacheEntryObj *) msSmallMalloc(sizeof(capabilitiesCacheEntryObj));
+  entry->key = msStrdup(key);
+  entry->document = (char *) msSmallMalloc(size);
+  memcpy(entry->document, document, size);
+  entry->size = size;
+
+  msAcquireLock(TLOCK_CAPSCACHE);
+  evicted = capabilitiesCacheUnlink(key, 0);
+  entry->next = capabilitiesCacheHead;
+  capabilitiesCacheHead = entry;
+  entry = capabilitiesCacheUnlink(NULL, capabilitiesCacheMaxCount);
+  msReleaseLock(TLOCK_CAPSCACHE);
+
+  capabilitiesCacheFreeList(evicted);
+  capabilitiesCacheFreeList(entry);
+}
+
+/*
+** Returns a copy of the document cached for key, from memory or from the
+** cache directory, or NULL.
+*/
+static char *capabilitiesCacheLookup(mapObj *map, const char *key, int *size)
+{
+  capabilitiesCacheEntryObj *entry, *previous = NULL;
+  char *document = NULL, *path;
+
+  msAcquireLock(TLOCK_CAPSCACHE);
+  for(entry=capabilitiesCacheHead; entry; previous=entry, entry=entry->next) {
+    if(strcmp(entry->key, key) == 0)
+      break;
+  }
+  if(entry) {
+    document = (char *) msSmallMalloc(entry->size);
+    memcpy(document, entry->document, entry->size);
+    *size = entry->size;
+    if(previous) { /* most recently used first */
+      previous->next = entry->next;
+      entry->next = capabilitiesCacheHead;
+      capabilitiesCacheHead = entry;
+    }
+  }
+  msReleaseLock(TLOCK_CAPSCACHE);
+
+  if(document || (path = capabilitiesCacheFile(map, key)) == NULL)
+    return document;
+
+  if(capabilitiesCacheReadFile(path, key, &document, size) == MS_SUCCESS)
+    capabilitiesCacheInsert(key, document, *size);
+  free(path);
+
+  return document;
+}
+
+static void capabilitiesCacheStore(mapObj *map, const char *key, const char *document, int size)
+{
+  char *path;
+
+  if((path = capabilitiesCacheFile(map, key)) != NULL) {
+    capabilitiesCacheWriteFile(path, key, document, size);
+    free(path);
+  }
+
+  capabilitiesCacheInsert(key, document, size);
+}
+
+/*
+** Writes a document captured from stdout. The headers it starts with are
+** sent again with msIO_setHeader() so that they reach the web server the
+** same way as when the document was built (e.g. mod_mapserver).
+*/
+static void capabilitiesCacheSend(const char *document, int size)
+{
+  const char *line = document, *end = document + size, *eol, *c;
+  char *header;
+  int length;
+
+  /* make sure there is a header block before interpreting any of it */
+  while(line < end && (eol = (const char *) memchr(line, '\n', end - line)) != NULL) {
+    length = (int)(eol - line);
+    if(length > 0 && line[length-1] == '\r')
+      length--;
+    if(length == 0)
+      break;
+    for(c = line; c < line + length && (isalnum((unsigned char) *c) || *c == '-'); c++) {}
+    if(c == line || c + 1 >= line + length || c[0] != ':' || c[1] != ' ')
+      break;
+    line = eol + 1;
+  }
+
+  if(line < end && line > document && (*line == '\n' || *line == '\r')) {
+    end = line; /* the blank line */
+    for(line = document; line < end; line = eol + 1) {
+      eol = (const char *) memchr(line, '\n', end - line);
+      length = (int)(eol - line);
+      if(length > 0 && line[length-1] == '\r')
+        length--;
+      header = (char *) msSmallMalloc(length + 1);
+      memcpy(header, line, length);
+      header[length] = '\0';
+      c = strchr(header, ':');
+      header[c - header] = '\0';
+      msIO_setHeader(header, "%s", c + 2);
+      free(header);
+    }
+    msIO_sendHeaders();
+    line = (const char *) memchr(end, '\n', document + size - end) + 1;
+  } else {
+    line = document;
+  }
+
+  msIO_fwrite(line, 1, document + size - line, stdout);
+}
+
+/* request parameters a GetCapabilities document depends on */
+static const char *capabilitiesCacheParams[] = {
+  "SERVICE", "REQUEST", "VERSION", "WMTVER", "ACCEPTVERSIONS", "LANGUAGE", "ACCEPTLANGUAGES",
+  "SECTIONS", "SECTION", "FORMAT", "ACCEPTFORMATS",
+  "CONTEXT", "CLASSGROUP", /* change the map in msCGILoadMap() */
+  NULL
+};
+
+/*
+** Parameters changing the map: map.* and map_* snippets, and runtime
+** substitutions, which need a validation pattern at the map, layer or class
+** level. Layers a substitution applied to were parsed by then, so lazy ones
+** need not be looked at.
+*/
+static int capabilitiesCacheMapParam(mapObj *map, const char *name)
+{
+  int i, j;
+
+  if(strncasecmp(name, "map_", 4) == 0 || strncasecmp(name, "map.", 4) == 0)
+    return MS_TRUE;
+  if(msLookupHashTable(&(map->web.validation), name))
+    return MS_TRUE;
+  for(i=0; i<map->numlayers; i++) {
+    layerObj *layer = map->layers[i];
+    if(layer->lazy)
+      continue;
+    if(msLookupHashTable(&(layer->validation), name))
+      return MS_TRUE;
+    for(j=0; j<layer->numclasses; j++)
+      if(msLookupHashTable(&(layer->class[j]->validation), name))
+        return MS_TRUE;
+  }
+
+  return MS_FALSE;
+}
+
+/*
+** Builds the cache key of a GetCapabilities request, see above, or returns
+** NULL if the request cannot be cached. *namespaces is set to the metadata
+** namespaces of the service.
+*/
+static char *capabilitiesCacheKey(mapObj *map, cgiRequestObj *request, owsRequestObj *ows_request, const char **namespaces)
+{
+  char *key, *online_resource, number[64];
+  const char *remote_ip;
+  int i, j;
+
+  if(!map->filename || request->type != MS_GET_REQUEST ||
+      !ows_request->service || !ows_request->request ||
+      !EQUAL(ows_request->request, "GetCapabilities"))
+    return NULL;
+
+  if(EQUAL(ows_request->service, "WMS"))
+    *namespaces = "MO";
+  else if(EQUAL(ows_request->service, "WFS"))
+    *namespaces = "FO";
+  else if(EQUAL(ows_request->service, "WCS"))
+    *namespaces = "CO";
+  else
+    return NULL;
+
+  if((online_resource = msOWSGetOnlineResource(map, *namespaces, "onlineresource", request)) == NULL) {
+    msResetErrorList(); /* the service will report it */
+    return NULL;
+  }
+
+  key = msStringConcatenate(msStrdup(map->filename), "\n");
+  snprintf(number, sizeof(number), "%ld %ld\n", map->filemtime, map->filesize);
+  key = msStringConcatenate(key, number);
+  key = msStringConcatenate(key, online_resource);
+  key = msStringConcatenate(key, "\n");
+  free(online_resource);
+
+  for(i=0; i<request->NumParams; i++) {
+    for(j=0; capabilitiesCacheParams[j]; j++)
+      if(EQUAL(request->ParamNames[i], capabilitiesCacheParams[j]))
+        break;
+    if(!capabilitiesCacheParams[j] && !capabilitiesCacheMapParam(map, request->ParamNames[i]))
+      continue;
+    key = msStringConcatenate(key, request->ParamNames[i]);
+    key = msStringConcatenate(key, "=");
+    key = msStringConcatenate(key, request->ParamValues[i]);
+    key = msStringConcatenate(key, "\n");
+  }
+
+  /* the layers advertised then depend on the client */
+  remote_ip = getenv("REMOTE_ADDR");
+  if(remote_ip) {
+    int iplists = (msOWSLookupMetadata(&(map->web.metadata), *namespaces, "allowed_ip_list") ||
+                   msOWSLookupMetadata(&(map->web.metadata), *namespaces, "denied_ip_list"));
+    for(i=0; !iplists && i<map->numlayers; i++) /* metadata is set on lazy layers too */
+      iplists = (msOWSLookupMetadata(&(map->layers[i]->metadata), *namespaces, "allowed_ip_list") ||
+                 msOWSLookupMetadata(&(map->layers[i]->metadata), *namespaces, "denied_ip_list"));
+    if(iplists) {
+      key = msStringConcatenate(key, "REMOTE_ADDR=");
+      key = msStringConcatenate(key, remote_ip);
+      key = msStringConcatenate(key, "\n");
+    }
+  }
+
+  return key;
+}
+#endif
+
+/*
+** Set the number of GetCapabilities documents kept in memory by
+** msOWSDispatch(), "0" disables the memory cache and frees it. For programs
+** embedding MapServer, this overrides MS_CAPABILITIES_CACHE_SIZE.
+*/
+void msSetCapabilitiesCacheSize(const char *value)
+{
+  capabilitiesCacheEntryObj *evicted;
+
+  msAcquireLock(TLOCK_CAPSCACHE);
+  capabilitiesCacheMaxCount = value ? MS_MAX(atoi(value), 0) : 0;
+  capabilitiesCacheConfigured = MS_TRUE;
+  evicted = capabilitiesCacheUnlink(NULL, capabilitiesCacheMaxCount);
+  msReleaseLock(TLOCK_CAPSCACHE);
+
+  capabilitiesCacheFreeList(evicted);
+}
+
+void msCapabilitiesCacheCleanup(void)
+{
+  capabilitiesCacheEntryObj *evicted;
+
+  msAcquireLock(TLOCK_CAPSCACHE);
+  evicted = capabilitiesCacheHead;
+  capabilitiesCacheHead = NULL;
+  capabilitiesCacheConfigured = MS_FALSE;
+  msReleaseLock(TLOCK_CAPSCACHE);
+
+  capabilitiesCacheFreeList(evicted);
+}
+
 /*
 ** msOWSDispatch() is the entry point for any OWS request (WMS, WFS, ...)
 ** - If this is a valid request then it is processed and MS_SUCCESS is returned
@@ -212,6 +646,10 @@ int msOWSDispatch(mapObj *map, cgiRequestObj *request, int ows_mode)
 {
   int status = MS_DONE, force_ows_mode = 0;
   owsRequestObj ows_request;
+#if defined(USE_WMS_SVR) || defined (USE_WFS_SVR) || defined (USE_WCS_SVR)
+  char *cachekey = NULL;
+  msIOContext stdout_context;
+#endif
 
   if (!request) {
     return status;
@@ -229,6 +667,46 @@ int msOWSDispatch(mapObj *map, cgiRequestObj *request, int ows_mode)
       status = MS_DONE;
   }
 
+#if defined(USE_WMS_SVR) || defined (USE_WFS_SVR) || defined (USE_WCS_SVR)
+  if (capabilitiesCacheGetMaxCount() > 0 ||
+      msGetConfigOption(map, "MS_CAPABILITIES_CACHE_DIR") || getenv("MS_CAPABILITIES_CACHE_DIR")) {
+    const char *namespaces = NULL, *updatesequence = NULL;
+    int i;
+
+    cachekey = capabilitiesCacheKey(map, request, &ows_request, &namespaces);
+
+    /* a cached document is only right if the full document is asked for */
+    for (i = 0; cachekey && i < request->NumParams; i++) {
+      if (EQUAL(request->ParamNames[i], "UPDATESEQUENCE"))
+        updatesequence = request->ParamValues[i];
+    }
+    if (cachekey && updatesequence &&
+        msOWSNegotiateUpdateSequence(updatesequence, msOWSLookupMetadata(&(map->web.metadata), namespaces, "updatesequence")) != -1) {
+      msFree(cachekey);
+      cachekey = NULL;
+    }
+  }
+
+  if (cachekey) {
+    int size;
+    char *document = capabilitiesCacheLookup(map, cachekey, &size);
+
+    if (document) {
+      if (map->debug >= MS_DEBUGLEVEL_V)
+        msDebug("msOWSDispatch(): %s GetCapabilities served from cache.\n", ows_request.service);
+      capabilitiesCacheSend(document, size);
+      free(document);
+      msFree(cachekey);
+      msOWSClearRequestObj(&ows_request);
+      return MS_SUCCESS;
+    }
+
+    /* capture the document, it is written out below */
+    stdout_context = *msIO_getHandler(stdout);
+    msIO_installStdoutToBuffer();
+  }
+#endif
+
   if (ows_request.service == NULL) {
     /* exit if service is not set */
     if(force_ows_mode) {
@@ -278,6 +756,21 @@ int msOWSDispatch(mapObj *map, cgiRequestObj *request, int ows_mode)
     status = MS_FAILURE;
   }
 
+#if defined(USE_WMS_SVR) || defined (USE_WFS_SVR) || defined (USE_WCS_SVR)
+  if (cachekey) {
+    msIOBuffer *buffer = (msIOBuffer *) msIO_getHandler(stdout)->cbData;
+
+    msIO_installHandlers(msIO_getHandler(stdin), &stdout_context, msIO_getHandler(stderr));
+    if (status == MS_SUCCESS && buffer->data_offset > 0)
+      capabilitiesCacheStore(map, cachekey, (char *) buffer->data, buffer->data_offset);
+    capabilitiesCacheSend((char *) buffer->data, buffer->data_offset);
+
+    msFree(buffer->data);
+    free(buffer);
+    msFree(cachekey);
+  }
+#endif
+
   msOWSClearRequestObj(&ows_request);
   return status;
 }
@@ -590,7 +1083,7 @@ int msOWSRequestIsEnabled(mapObj *map, layerObj *layer,
     for(i=0; i<map->numlayers; i++) {
       int result = MS_FALSE;
       layerObj *lp;
-      lp = (GET_LAYER(map, i));
+      lp = map->layers[i]; /* metadata and index only, lazy layers need not be parsed */
 
       enable_request = msOWSLookupMetadata(&lp->metadata, namespaces, "enable_request");
       result = msOWSParseRequestMetadata(enable_request, request, &disabled);
@@ -668,7 +1161,7 @@ void msOWSRequestLayersEnabled(mapObj *map, const char *namespaces,
     for(i=0; i<map->numlayers; i++) {
       int result = MS_FALSE;
       layerObj *lp;
-      lp = (GET_LAYER(map, i));
+      lp = map->layers[i]; /* metadata and index only, lazy layers need not be parsed */
 
       enable_request = msOWSLookupMetadata(&lp->metadata, namespaces, "enable_request");
       result = msOWSParseRequestMetadata(enable_request, request, &disabled);
@@ -114,6 +114,8 @@ typedef struct {
 } owsRequestObj;
 
 MS_DLL_EXPORT int msOWSDispatch(mapObj *map, cgiRequestObj *request, int ows_mode);
+MS_DLL_EXPORT void msSetCapabilitiesCacheSize(const char *value);
+MS_DLL_EXPORT void msCapabilitiesCacheCleanup(void);
 
 MS_DLL_EXPORT const char * msOWSLookupMetadata(hashTableObj *metadata,
     const char *namespaces, const char *name);
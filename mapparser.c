@@ -1798,13 +1798,13 @@ yyreduce:
 
                                          if(ms_regcomp(&re, (yyvsp[(3) - (3)].strval), MS_REG_EXTENDED|MS_REG_NOSUB) != 0) 
                                            (yyval.intval) = MS_FALSE;
-
-                                         if(ms_regexec(&re, (yyvsp[(1) - (3)].strval), 0, NULL, 0) == 0)
-                                  	   (yyval.intval) = MS_TRUE;
-			                 else
-			                   (yyval.intval) = MS_FALSE;
-
-                                         ms_regfree(&re);
+                                         else {
+                                           if(ms_regexec(&re, (yyvsp[(1) - (3)].strval), 0, NULL, 0) == 0)
+                                             (yyval.intval) = MS_TRUE;
+                                           else
+                                             (yyval.intval) = MS_FALSE;
+                                           ms_regfree(&re);
+                                         }
                                          free((yyvsp[(1) - (3)].strval));
                                          free((yyvsp[(3) - (3)].strval));
                                        ;}
@@ -1819,13 +1819,13 @@ yyreduce:
 
                                          if(ms_regcomp(&re, (yyvsp[(3) - (3)].strval), MS_REG_EXTENDED|MS_REG_NOSUB|MS_REG_ICASE) != 0) 
                                            (yyval.intval) = MS_FALSE;
-
-                                         if(ms_regexec(&re, (yyvsp[(1) - (3)].strval), 0, NULL, 0) == 0)
-                                  	   (yyval.intval) = MS_TRUE;
-			                 else
-			                   (yyval.intval) = MS_FALSE;
-
-                                         ms_regfree(&re);
+                                         else {
+                                           if(ms_regexec(&re, (yyvsp[(1) - (3)].strval), 0, NULL, 0) == 0)
+                                             (yyval.intval) = MS_TRUE;
+                                           else
+                                             (yyval.intval) = MS_FALSE;
+                                           ms_regfree(&re);
+                                         }
                                          free((yyvsp[(1) - (3)].strval));
                                          free((yyvsp[(3) - (3)].strval));
                                        ;}
@@ -2891,7 +2891,7 @@ int yylex(YYSTYPE *lvalp, parseObj *p)
   case MS_TOKEN_BINDING_DOUBLE:
   case MS_TOKEN_BINDING_INTEGER:
     token = NUMBER;
-    (*lvalp).dblval = atof(p->shape->values[p->expr->curtoken->tokenval.bindval.index]);
+    (*lvalp).dblval = msShapeGetNumericValue(p->shape, p->expr->curtoken->tokenval.bindval.index);
     break;
   case MS_TOKEN_BINDING_STRING:
     token = STRING;
@@ -189,13 +189,13 @@ logical_exp:
 
                                          if(ms_regcomp(&re, $3, MS_REG_EXTENDED|MS_REG_NOSUB) != 0) 
                                            $$ = MS_FALSE;
-
-                                         if(ms_regexec(&re, $1, 0, NULL, 0) == 0)
-                                  	   $$ = MS_TRUE;
-			                 else
-			                   $$ = MS_FALSE;
-
-                                         ms_regfree(&re);
+                                         else {
+                                           if(ms_regexec(&re, $1, 0, NULL, 0) == 0)
+                                             $$ = MS_TRUE;
+                                           else
+                                             $$ = MS_FALSE;
+                                           ms_regfree(&re);
+                                         }
                                          free($1);
                                          free($3);
                                        }
@@ -204,13 +204,13 @@ logical_exp:
 
                                          if(ms_regcomp(&re, $3, MS_REG_EXTENDED|MS_REG_NOSUB|MS_REG_ICASE) != 0) 
                                            $$ = MS_FALSE;
-
-                                         if(ms_regexec(&re, $1, 0, NULL, 0) == 0)
-                                  	   $$ = MS_TRUE;
-			                 else
-			                   $$ = MS_FALSE;
-
-                                         ms_regfree(&re);
+                                         else {
+                                           if(ms_regexec(&re, $1, 0, NULL, 0) == 0)
+                                             $$ = MS_TRUE;
+                                           else
+                                             $$ = MS_FALSE;
+                                           ms_regfree(&re);
+                                         }
                                          free($1);
                                          free($3);
                                        }
@@ -713,7 +713,7 @@ int yylex(YYSTYPE *lvalp, parseObj *p)
   case MS_TOKEN_BINDING_DOUBLE:
   case MS_TOKEN_BINDING_INTEGER:
     token = NUMBER;
-    (*lvalp).dblval = atof(p->shape->values[p->expr->curtoken->tokenval.bindval.index]);
+    (*lvalp).dblval = msShapeGetNumericValue(p->shape, p->expr->curtoken->tokenval.bindval.index);
     break;
   case MS_TOKEN_BINDING_STRING:
     token = STRING;
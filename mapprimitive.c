@@ -32,6 +32,11 @@
 #include <assert.h>
 #include <locale.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MS_VERTICES_SSE2
+#include <emmintrin.h>
+#endif
+
 
 
 typedef enum {CLIP_LEFT, CLIP_MIDDLE, CLIP_RIGHT} CLIP_STATE;
@@ -100,6 +105,8 @@ void msInitShape(shapeObj *shape)
   /* attribute component */
   shape->values = NULL;
   shape->numvalues = 0;
+  shape->numericvalues = NULL;
+  shape->valuesborrowed = MS_FALSE;
 
   shape->geometry = NULL;
   shape->renderer_cache = NULL;
@@ -142,6 +149,8 @@ int msCopyShape(shapeObj *from, shapeObj *to)
     for(i=0; i<from->numvalues; i++)
       to->values[i] = msStrdup(from->values[i]);
     to->numvalues = from->numvalues;
+    to->numericvalues = NULL;
+    to->valuesborrowed = MS_FALSE;
   }
 
   to->geometry = NULL; /* GEOS code will build automatically if necessary */
@@ -160,7 +169,7 @@ void msFreeShape(shapeObj *shape)
     free(shape->line[c].point);
 
   if (shape->line) free(shape->line);
-  if(shape->values) msFreeCharArray(shape->values, shape->numvalues);
+  msFreeShapeValues(shape);
   if(shape->text) free(shape->text);
 
 #ifdef USE_GEOS
@@ -170,6 +179,50 @@ void msFreeShape(shapeObj *shape)
   msInitShape(shape); /* now reset */
 }
 
+/*
+** Shapefile layers decode the attributes of a shape into a buffer they reuse
+** for the next shape (see msDBFReadValues()), the shape only borrows them.
+** Code that keeps a shape past the next read from its layer, or changes its
+** values, has to give the shape its own copy first.
+*/
+void msShapeOwnValues(shapeObj *shape)
+{
+  int i;
+  char **values;
+
+  if(!shape->valuesborrowed) return;
+
+  values = (char **)msSmallMalloc(sizeof(char *)*shape->numvalues);
+  for(i=0; i<shape->numvalues; i++)
+    values[i] = msStrdup(shape->values[i]);
+
+  shape->values = values;
+  shape->numericvalues = NULL; /* no longer matches once values change */
+  shape->valuesborrowed = MS_FALSE;
+}
+
+void msFreeShapeValues(shapeObj *shape)
+{
+  if(shape->values && !shape->valuesborrowed)
+    msFreeCharArray(shape->values, shape->numvalues);
+
+  shape->values = NULL;
+  shape->numvalues = 0;
+  shape->numericvalues = NULL;
+  shape->valuesborrowed = MS_FALSE;
+}
+
+/*
+** Value of attribute i as a number, as atof() would return it, using the
+** parsed value when the layer provided one.
+*/
+double msShapeGetNumericValue(shapeObj *shape, int i)
+{
+  if(shape->numericvalues && !msIsNan(shape->numericvalues[i]))
+    return shape->numericvalues[i];
+  return atof(shape->values[i]);
+}
+
 void msFreeLabelPathObj(labelPathObj *path)
 {
   msFreeShape(&(path->bounds));
@@ -543,14 +596,112 @@ void msClipPolylineRect(shapeObj *shape, rectObj rect)
 }
 
 /*
-** Slightly modified version of the Liang-Barsky polygon clipping algorithm
+** Slightly modified version of the Liang-Barsky polygon clipping algorithm.
+** clipPolygonEdge() clips the edge (x1,y1)-(x2,y2) of a ring, writes the 0
+** to 3 points it adds to the clipped ring to point and returns how many.
 */
-void msClipPolygonRect(shapeObj *shape, rectObj rect)
+static int clipPolygonEdge(double x1, double y1, double x2, double y2, rectObj rect, pointObj *point)
 {
-  int i, j;
   double deltax, deltay, xin,xout,  yin,yout;
   double tinx,tiny,  toutx,touty,  tin1, tin2,  tout;
-  double x1,y1, x2,y2;
+  int n = 0;
+
+  deltax = x2-x1;
+  if (deltax == 0) { /* bump off of the vertical */
+    deltax = (x1 > rect.minx) ? -NEARZERO : NEARZERO ;
+  }
+  deltay = y2-y1;
+  if (deltay == 0) { /* bump off of the horizontal */
+    deltay = (y1 > rect.miny) ? -NEARZERO : NEARZERO ;
+  }
+
+  if (deltax > 0) { /*  points to right */
+    xin = rect.minx;
+    xout = rect.maxx;
+  } else {
+    xin = rect.maxx;
+    xout = rect.minx;
+  }
+  if (deltay > 0) { /*  points up */
+    yin = rect.miny;
+    yout = rect.maxy;
+  } else {
+    yin = rect.maxy;
+    yout = rect.miny;
+  }
+
+  tinx = (xin - x1)/deltax;
+  tiny = (yin - y1)/deltay;
+
+  if (tinx < tiny) { /* hits x first */
+    tin1 = tinx;
+    tin2 = tiny;
+  } else {            /* hits y first */
+    tin1 = tiny;
+    tin2 = tinx;
+  }
+
+  if (1 >= tin1) {
+    if (0 < tin1) {
+      point[n].x = xin;
+      point[n].y = yin;
+      n++;
+    }
+    if (1 >= tin2) {
+      toutx = (xout - x1)/deltax;
+      touty = (yout - y1)/deltay;
+
+      tout = (toutx < touty) ? toutx : touty ;
+
+      if (0 < tin2 || 0 < tout) {
+        if (tin2 <= tout) {
+          if (0 < tin2) {
+            if (tinx > tiny) {
+              point[n].x = xin;
+              point[n].y = y1 + tinx*deltay;
+              n++;
+            } else {
+              point[n].x = x1 + tiny*deltax;
+              point[n].y = yin;
+              n++;
+            }
+          }
+          if (1 > tout) {
+            if (toutx < touty) {
+              point[n].x = xout;
+              point[n].y = y1 + toutx*deltay;
+              n++;
+            } else {
+              point[n].x = x1 + touty*deltax;
+              point[n].y = yout;
+              n++;
+            }
+          } else {
+            point[n].x = x2;
+            point[n].y = y2;
+            n++;
+          }
+        } else {
+          if (tinx > tiny) {
+            point[n].x = xin;
+            point[n].y = yout;
+            n++;
+          } else {
+            point[n].x = xout;
+            point[n].y = yin;
+            n++;
+          }
+        }
+      }
+    }
+  }
+
+  return n;
+}
+
+void msClipPolygonRect(shapeObj *shape, rectObj rect)
+{
+  int i, j;
 
   shapeObj tmp;
   lineObj line= {0,NULL};
@@ -576,105 +727,13 @@ void msClipPolygonRect(shapeObj *shape, rectObj rect)
 
   for(j=0; j<shape->numlines; j++) {
 
-    line.point = (pointObj *)msSmallMalloc(sizeof(pointObj)*2*shape->line[j].numpoints+1); /* worst case scenario, +1 allows us to duplicate the 1st and last point */
+    line.point = (pointObj *)msSmallMalloc(sizeof(pointObj)*(3*shape->line[j].numpoints+1)); /* worst case scenario, an edge crossing a corner adds 3 points, +1 allows us to duplicate the 1st and last point */
     line.numpoints = 0;
 
     for (i = 0; i < shape->line[j].numpoints-1; i++) {
-
-      x1 = shape->line[j].point[i].x;
-      y1 = shape->line[j].point[i].y;
-      x2 = shape->line[j].point[i+1].x;
-      y2 = shape->line[j].point[i+1].y;
-
-      deltax = x2-x1;
-      if (deltax == 0) { /* bump off of the vertical */
-        deltax = (x1 > rect.minx) ? -NEARZERO : NEARZERO ;
-      }
-      deltay = y2-y1;
-      if (deltay == 0) { /* bump off of the horizontal */
-        deltay = (y1 > rect.miny) ? -NEARZERO : NEARZERO ;
-      }
-
-      if (deltax > 0) { /*  points to right */
-        xin = rect.minx;
-        xout = rect.maxx;
-      } else {
-        xin = rect.maxx;
-        xout = rect.minx;
-      }
-      if (deltay > 0) { /*  points up */
-        yin = rect.miny;
-        yout = rect.maxy;
-      } else {
-        yin = rect.maxy;
-        yout = rect.miny;
-      }
-
-      tinx = (xin - x1)/deltax;
-      tiny = (yin - y1)/deltay;
-
-      if (tinx < tiny) { /* hits x first */
-        tin1 = tinx;
-        tin2 = tiny;
-      } else {            /* hits y first */
-        tin1 = tiny;
-        tin2 = tinx;
-      }
-
-      if (1 >= tin1) {
-        if (0 < tin1) {
-          line.point[line.numpoints].x = xin;
-          line.point[line.numpoints].y = yin;
-          line.numpoints++;
-        }
-        if (1 >= tin2) {
-          toutx = (xout - x1)/deltax;
-          touty = (yout - y1)/deltay;
-
-          tout = (toutx < touty) ? toutx : touty ;
-
-          if (0 < tin2 || 0 < tout) {
-            if (tin2 <= tout) {
-              if (0 < tin2) {
-                if (tinx > tiny) {
-                  line.point[line.numpoints].x = xin;
-                  line.point[line.numpoints].y = y1 + tinx*deltay;
-                  line.numpoints++;
-                } else {
-                  line.point[line.numpoints].x = x1 + tiny*deltax;
-                  line.point[line.numpoints].y = yin;
-                  line.numpoints++;
-                }
-              }
-              if (1 > tout) {
-                if (toutx < touty) {
-                  line.point[line.numpoints].x = xout;
-                  line.point[line.numpoints].y = y1 + toutx*deltay;
-                  line.numpoints++;
-                } else {
-                  line.point[line.numpoints].x = x1 + touty*deltax;
-                  line.point[line.numpoints].y = yout;
-                  line.numpoints++;
-                }
-              } else {
-                line.point[line.numpoints].x = x2;
-                line.point[line.numpoints].y = y2;
-                line.numpoints++;
-              }
-            } else {
-              if (tinx > tiny) {
-                line.point[line.numpoints].x = xin;
-                line.point[line.numpoints].y = yout;
-                line.numpoints++;
-              } else {
-                line.point[line.numpoints].x = xout;
-                line.point[line.numpoints].y = yin;
-                line.numpoints++;
-              }
-            }
-          }
-        }
-      }
+      line.numpoints += clipPolygonEdge(shape->line[j].point[i].x, shape->line[j].point[i].y,
+                                        shape->line[j].point[i+1].x, shape->line[j].point[i+1].y,
+                                        rect, line.point + line.numpoints);
     }
 
     if(line.numpoints > 0) {
@@ -959,6 +1018,464 @@ void  msTransformShape(shapeObj *shape, rectObj extent, double cellsize, imageOb
   msTransformShapeToPixelRound(shape, extent, cellsize);
 }
 
+/*
+** Single pass clipping, transformation and simplification.
+**
+** msDrawShape() needs shapes clipped by msClipPolylineRect() or
+** msClipPolygonRect(), converted to pixels by msTransformShape() and their
+** bounds from msComputeBounds(). Run in a row these make a pass over every
+** vertex each, allocate new points for every clipped line and compute the
+** bounds twice. For the MS_TRANSFORM_SIMPLIFY mode of the AGG and cairo
+** renderers msClipTransformShape() streams each line through all of these
+** steps at once and gives exactly the same points. The transform, the
+** bounds and the inside tests work on a whole vertex at once with SSE2
+** where the compiler targets it.
+*/
+#ifdef MS_VERTICES_SSE2
+typedef __m128d vertexObj;
+
+#define vertexLoad(p) _mm_loadu_pd(&(p)->x)
+#define vertexStore(p, v) _mm_storeu_pd(&(p)->x, (v))
+#define vertexSet(x, y) _mm_set_pd((y), (x))
+#define vertexTransform(v, origin, scale) _mm_mul_pd(_mm_sub_pd((v), (origin)), (scale))
+#define vertexMin(a, b) _mm_min_pd((a), (b))
+#define vertexMax(a, b) _mm_max_pd((a), (b))
+
+/* more than a pixel apart, as in msTransformShapeSimplify() */
+static int vertexFar(vertexObj a, vertexObj b)
+{
+  vertexObj d = _mm_sub_pd(a, b);
+  d = _mm_mul_pd(d, d);
+  return _mm_cvtsd_f64(_mm_add_sd(d, _mm_unpackhi_pd(d, d))) > 1;
+}
+
+static int vertexEqual(vertexObj a, vertexObj b)
+{
+  return _mm_movemask_pd(_mm_cmpeq_pd(a, b)) == 3;
+}
+
+/* strictly inside, where neither clipping routine moves a vertex */
+static int vertexInside(vertexObj v, vertexObj min, vertexObj max)
+{
+  return _mm_movemask_pd(_mm_and_pd(_mm_cmpgt_pd(v, min), _mm_cmplt_pd(v, max))) == 3;
+}
+#else
+typedef struct {
+  double x, y;
+} vertexObj;
+
+static vertexObj vertexLoad(const pointObj *p)
+{
+  vertexObj v;
+  v.x = p->x;
+  v.y = p->y;
+  return v;
+}
+
+#define vertexStore(p, v) ((p)->x = (v).x, (p)->y = (v).y)
+
+static vertexObj vertexSet(double x, double y)
+{
+  vertexObj v;
+  v.x = x;
+  v.y = y;
+  return v;
+}
+
+static vertexObj vertexTransform(vertexObj v, vertexObj origin, vertexObj scale)
+{
+  v.x = (v.x - origin.x)*scale.x;
+  v.y = (v.y - origin.y)*scale.y;
+  return v;
+}
+
+static vertexObj vertexMin(vertexObj a, vertexObj b)
+{
+  a.x = MS_MIN(a.x, b.x);
+  a.y = MS_MIN(a.y, b.y);
+  return a;
+}
+
+static vertexObj vertexMax(vertexObj a, vertexObj b)
+{
+  a.x = MS_MAX(a.x, b.x);
+  a.y = MS_MAX(a.y, b.y);
+  return a;
+}
+
+static int vertexFar(vertexObj a, vertexObj b)
+{
+  double dx = a.x - b.x, dy = a.y - b.y;
+  return dx*dx+dy*dy > 1;
+}
+
+static int vertexEqual(vertexObj a, vertexObj b)
+{
+  return a.x == b.x && a.y == b.y;
+}
+
+static int vertexInside(vertexObj v, vertexObj min, vertexObj max)
+{
+  return v.x > min.x && v.y > min.y && v.x < max.x && v.y < max.y;
+}
+#endif
+
+/*
+** Simplifies a line as msTransformShapeSimplify() does, one pixel vertex at
+** a time. Lines keep their first and last vertex, rings their first two and
+** last two; as which vertices are the last ones is only known at the end,
+** they wait in pending until a later vertex comes in.
+*/
+typedef struct {
+  pointObj *point; /* the simplified line */
+  int numpoints;
+  int count; /* vertices streamed in */
+  int keep; /* 1 for lines, 2 for rings */
+  vertexObj pending[2];
+  vertexObj last; /* point[numpoints-1] */
+  vertexObj min, max; /* bounds of point[0..numpoints-1] */
+} simplifyStreamObj;
+
+static void simplifyBegin(simplifyStreamObj *stream, pointObj *point, int keep)
+{
+  stream->point = point;
+  stream->numpoints = 0;
+  stream->count = 0;
+  stream->keep = keep;
+}
+
+static void simplifyAdd(simplifyStreamObj *stream, vertexObj v)
+{
+  int slot;
+
+  if(stream->count < stream->keep) { /* leading vertices are always kept */
+    vertexStore(&(stream->point[stream->numpoints]), v);
+    stream->numpoints++;
+    if(stream->count == 0) {
+      stream->min = stream->max = v;
+    } else {
+      stream->min = vertexMin(stream->min, v);
+      stream->max = vertexMax(stream->max, v);
+    }
+    stream->last = v;
+    stream->count++;
+    return;
+  }
+
+  slot = stream->count & (stream->keep - 1);
+  if(stream->count >= 2*stream->keep) { /* the vertex in slot is not one of the last ones */
+    vertexObj p = stream->pending[slot];
+    vertexStore(&(stream->point[stream->numpoints]), p);
+    if(vertexFar(p, stream->last)) {
+      stream->numpoints++;
+      stream->min = vertexMin(stream->min, p);
+      stream->max = vertexMax(stream->max, p);
+      stream->last = p;
+    }
+  }
+  stream->pending[slot] = v;
+  stream->count++;
+}
+
+/* returns the number of points of the simplified line, 0 for a degenerate one */
+static int simplifyEnd(simplifyStreamObj *stream)
+{
+  int i, slot;
+
+  if(stream->count < 2*stream->keep) /* fewer than 2 points, or 4 for a ring */
+    return stream->numpoints = 0;
+
+  for(i=stream->keep; i>0; i--) {
+    vertexObj p;
+    slot = (stream->count - i) & (stream->keep - 1);
+    p = stream->pending[slot];
+    vertexStore(&(stream->point[stream->numpoints]), p);
+    if(stream->keep == 1 && vertexEqual(p, stream->last)) /* discard last point if equal to the one before it */
+      break;
+    stream->numpoints++;
+    stream->min = vertexMin(stream->min, p);
+    stream->max = vertexMax(stream->max, p);
+  }
+
+  if(stream->numpoints < 2)
+    stream->numpoints = 0;
+  return stream->numpoints;
+}
+
+/*
+** The same as a simplifyStreamObj for a line that needs no clipping, in
+** place: vertex j is only written to position j or before, once read.
+*/
+static int simplifyLineInPlace(pointObj *point, int numpoints, vertexObj origin, vertexObj scale, vertexObj *min, vertexObj *max)
+{
+  vertexObj v, last;
+  int j, k;
+
+  if(numpoints < 2) return 0;
+
+  last = vertexTransform(vertexLoad(&(point[0])), origin, scale);
+  vertexStore(&(point[0]), last);
+  *min = *max = last;
+  for(j=1, k=1; j<numpoints-1; j++) {
+    v = vertexTransform(vertexLoad(&(point[j])), origin, scale);
+    vertexStore(&(point[k]), v);
+    if(vertexFar(v, last)) {
+      k++;
+      *min = vertexMin(*min, v);
+      *max = vertexMax(*max, v);
+      last = v;
+    }
+  }
+  v = vertexTransform(vertexLoad(&(point[j])), origin, scale);
+  vertexStore(&(point[k]), v);
+  if(!vertexEqual(v, last)) { /* discard last point if equal to the one before it */
+    k++;
+    *min = vertexMin(*min, v);
+    *max = vertexMax(*max, v);
+  }
+  return (k < 2) ? 0 : k;
+}
+
+static int simplifyRingInPlace(pointObj *point, int numpoints, vertexObj origin, vertexObj scale, vertexObj *min, vertexObj *max)
+{
+  vertexObj v, last;
+  int j, k;
+
+  if(numpoints < 4) return 0;
+
+  v = vertexTransform(vertexLoad(&(point[0])), origin, scale);
+  vertexStore(&(point[0]), v);
+  *min = *max = v;
+  last = vertexTransform(vertexLoad(&(point[1])), origin, scale);
+  vertexStore(&(point[1]), last);
+  *min = vertexMin(*min, last);
+  *max = vertexMax(*max, last);
+  for(j=2, k=2; j<numpoints-2; j++) {
+    v = vertexTransform(vertexLoad(&(point[j])), origin, scale);
+    vertexStore(&(point[k]), v);
+    if(vertexFar(v, last)) {
+      k++;
+      *min = vertexMin(*min, v);
+      *max = vertexMax(*max, v);
+      last = v;
+    }
+  }
+  for(; j<numpoints; j++, k++) { /* always keep the last two points */
+    v = vertexTransform(vertexLoad(&(point[j])), origin, scale);
+    vertexStore(&(point[k]), v);
+    *min = vertexMin(*min, v);
+    *max = vertexMax(*max, v);
+  }
+  return k;
+}
+
+/*
+** Stores the clipped line in buffer as line n of shape. Lines before
+** current have been read and their points are reused when large enough.
+** While current is still being read (reading is true) it and the lines
+** after it are moved up one if n reaches it.
+*/
+static void clipTransformPlace(shapeObj *shape, int n, int *current, int reading, const pointObj *buffer, int numpoints)
+{
+  lineObj *line;
+
+  if(reading && n == *current) {
+    shape->line = (lineObj *) msSmallRealloc(shape->line, sizeof(lineObj)*(shape->numlines+1));
+    memmove(&(shape->line[n+1]), &(shape->line[n]), sizeof(lineObj)*(shape->numlines-n));
+    shape->numlines++;
+    (*current)++;
+    shape->line[n].point = NULL;
+    shape->line[n].numpoints = 0;
+  }
+
+  line = &(shape->line[n]);
+  if(line->point == NULL || line->numpoints < numpoints) {
+    free(line->point);
+    line->point = (pointObj *) msSmallMalloc(sizeof(pointObj)*MS_MAX(numpoints, 1));
+  }
+  memcpy(line->point, buffer, sizeof(pointObj)*numpoints);
+  line->numpoints = numpoints;
+}
+
+/*
+** Clips shape to cliprect (in map units, NULL to skip clipping), transforms
+** it to pixels for image and computes its bounds, with the same result as
+** msClipPolygonRect()/msClipPolylineRect(), msTransformShape() and
+** msComputeBounds() in a row. Lines that need no clipping are rewritten in
+** place; clipped lines are built in buffer, which callers keep from one
+** shape to the next (NULL for a temporary one).
+*/
+void msClipTransformShape(shapeObj *shape, rectObj *cliprect, rectObj extent, double cellsize, imageObj *image, pointBufferObj *buffer)
+{
+  int i, j, n, numout, keep, clip, ok = 0, hasbounds = 0;
+  double inv_cs;
+  vertexObj origin, scale, clipmin, clipmax, min, max, v;
+  pointBufferObj tmpbuffer = {NULL, 0};
+  simplifyStreamObj stream;
+
+  if(image == NULL || !MS_RENDERER_PLUGIN(image->format) ||
+      MS_IMAGE_RENDERER(image)->transform_mode != MS_TRANSFORM_SIMPLIFY ||
+      (shape->type != MS_SHAPE_LINE && shape->type != MS_SHAPE_POLYGON)) {
+    if(cliprect) {
+      if(shape->type == MS_SHAPE_POLYGON)
+        msClipPolygonRect(shape, *cliprect);
+      else
+        msClipPolylineRect(shape, *cliprect);
+    }
+    msTransformShape(shape, extent, cellsize, image);
+    msComputeBounds(shape);
+    return;
+  }
+
+  if(shape->numlines == 0) return;
+
+  clip = (cliprect != NULL &&
+          !(shape->bounds.maxx <= cliprect->maxx && shape->bounds.minx >= cliprect->minx &&
+            shape->bounds.maxy <= cliprect->maxy && shape->bounds.miny >= cliprect->miny));
+  if(clip) {
+    clipmin = vertexSet(cliprect->minx, cliprect->miny);
+    clipmax = vertexSet(cliprect->maxx, cliprect->maxy);
+    if(buffer == NULL)
+      buffer = &tmpbuffer;
+  }
+
+  inv_cs = 1.0 / cellsize; /* invert and multiply much faster */
+  origin = vertexSet(extent.minx, extent.maxy);
+  scale = vertexSet(inv_cs, -inv_cs); /* (y-maxy)*-inv_cs is exactly (maxy-y)*inv_cs */
+  keep = (shape->type == MS_SHAPE_POLYGON) ? 2 : 1;
+  min = max = origin; /* set with the first line kept */
+
+  numout = 0;
+  for(i=0; i<shape->numlines; i++) {
+    pointObj *point = shape->line[i].point;
+    int numpoints = shape->line[i].numpoints;
+
+    if(!clip) { /* output never gets ahead of input, transform in place */
+      if(keep == 2)
+        n = simplifyRingInPlace(point, numpoints, origin, scale, &(stream.min), &(stream.max));
+      else
+        n = simplifyLineInPlace(point, numpoints, origin, scale, &(stream.min), &(stream.max));
+      shape->line[i].numpoints = n;
+      numout++;
+      if(n > 0) {
+        min = hasbounds ? vertexMin(min, stream.min) : stream.min;
+        max = hasbounds ? vertexMax(max, stream.max) : stream.max;
+        hasbounds = ok = 1;
+      }
+      continue;
+    }
+
+    if(buffer->size < 3*numpoints+1) { /* clipped rings grow to 3n+1 points at most */
+      buffer->size = 3*numpoints+1;
+      free(buffer->point);
+      buffer->point = (pointObj *) msSmallMalloc(sizeof(pointObj)*buffer->size);
+    }
+
+    if(shape->type == MS_SHAPE_POLYGON) {
+      pointObj edge[3];
+      vertexObj first = origin;
+      int inside1, inside2, started = 0;
+
+      inside1 = (numpoints > 0) && vertexInside(vertexLoad(&(point[0])), clipmin, clipmax);
+      for(j=0; j<numpoints-1; j++) {
+        int k, numedge;
+        v = vertexLoad(&(point[j+1]));
+        inside2 = vertexInside(v, clipmin, clipmax);
+        if(inside1 && inside2) { /* clipPolygonEdge() adds the end point only */
+          numedge = 1;
+          vertexStore(&(edge[0]), v);
+        } else {
+          numedge = clipPolygonEdge(point[j].x, point[j].y, point[j+1].x, point[j+1].y, *cliprect, edge);
+        }
+        for(k=0; k<numedge; k++) {
+          v = vertexLoad(&(edge[k]));
+          if(!started) {
+            simplifyBegin(&stream, buffer->point, keep);
+            first = v;
+            started = 1;
+          }
+          simplifyAdd(&stream, vertexTransform(v, origin, scale));
+        }
+        inside1 = inside2;
+      }
+      if(started) {
+        simplifyAdd(&stream, vertexTransform(first, origin, scale)); /* force closure */
+        n = simplifyEnd(&stream);
+        clipTransformPlace(shape, numout++, &i, MS_FALSE, buffer->point, n);
+        if(n > 0) {
+          min = hasbounds ? vertexMin(min, stream.min) : stream.min;
+          max = hasbounds ? vertexMax(max, stream.max) : stream.max;
+          hasbounds = ok = 1;
+        }
+      }
+    } else {
+      double x1, y1, x2, y2;
+      int inside1, inside2, started = 0;
+
+      inside1 = (numpoints > 0) && vertexInside(vertexLoad(&(point[0])), clipmin, clipmax);
+      for(j=1; j<numpoints; j++) {
+        v = vertexLoad(&(point[j]));
+        inside2 = vertexInside(v, clipmin, clipmax);
+        x1 = point[j-1].x;
+        y1 = point[j-1].y;
+        x2 = point[j].x;
+        y2 = point[j].y;
+        if((inside1 && inside2) || clipLine(&x1,&y1,&x2,&y2,*cliprect) == MS_TRUE) {
+          if(!started) { /* first segment, add both points */
+            simplifyBegin(&stream, buffer->point, keep);
+            simplifyAdd(&stream, vertexTransform(vertexSet(x1, y1), origin, scale));
+            started = 1;
+          }
+          simplifyAdd(&stream, vertexTransform(vertexSet(x2, y2), origin, scale));
+
+          if((x2 != point[j].x) || (y2 != point[j].y)) { /* leaves the rectangle, new line */
+            n = simplifyEnd(&stream);
+            clipTransformPlace(shape, numout++, &i, MS_TRUE, buffer->point, n);
+            if(n > 0) {
+              min = hasbounds ? vertexMin(min, stream.min) : stream.min;
+              max = hasbounds ? vertexMax(max, stream.max) : stream.max;
+              hasbounds = ok = 1;
+            }
+            started = 0;
+          }
+        }
+        inside1 = inside2;
+      }
+      if(started) {
+        n = simplifyEnd(&stream);
+        clipTransformPlace(shape, numout++, &i, MS_FALSE, buffer->point, n);
+        if(n > 0) {
+          min = hasbounds ? vertexMin(min, stream.min) : stream.min;
+          max = hasbounds ? vertexMax(max, stream.max) : stream.max;
+          hasbounds = ok = 1;
+        }
+      }
+    }
+  }
+
+  for(i=numout; i<shape->numlines; i++) /* read, but clipped away or not reused */
+    free(shape->line[i].point);
+  shape->numlines = numout;
+  free(tmpbuffer.point);
+
+  if(!ok) {
+    for(i=0; i<shape->numlines; i++)
+      free(shape->line[i].point);
+    shape->numlines = 0;
+    return;
+  }
+
+  if(hasbounds) {
+    pointObj p;
+    vertexStore(&p, min);
+    shape->bounds.minx = p.x;
+    shape->bounds.miny = p.y;
+    vertexStore(&p, max);
+    shape->bounds.maxx = p.x;
+    shape->bounds.maxy = p.y;
+  }
+}
+
 void msTransformShapeToPixelSnapToGrid(shapeObj *shape, rectObj extent, double cellsize, double grid_resolution)
 {
   int i,j,k; /* loop counters */
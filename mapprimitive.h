@@ -51,6 +51,14 @@ typedef struct {
 #endif
 } pointObj;
 
+#ifndef SWIG
+/* points kept from one call to the next, see msClipTransformShape() */
+typedef struct {
+  pointObj *point;
+  int size;
+} pointBufferObj;
+#endif /*SWIG*/
+
 typedef struct {
 #ifdef SWIG
   %immutable;
@@ -73,6 +81,8 @@ typedef struct {
 #ifndef SWIG
   lineObj *line;
   char **values;
+  double *numericvalues; /* values of numeric attributes already parsed, NaN for the others, may be NULL */
+  int valuesborrowed; /* values belong to the layer and last until its next read, see msShapeOwnValues() */
   void *geometry;
   void *renderer_cache;
 #endif
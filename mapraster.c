@@ -37,9 +37,6 @@
 
 
 
-extern int msyylex_destroy(void);
-extern int yyparse(parseObj *);
-
 extern parseResultObj yypresult; /* result of parsing, true/false */
 
 #ifdef USE_GDAL
@@ -141,6 +138,7 @@ static int msGetClass_String( layerObj *layer, colorObj *color, const char *pixe
         shapeObj dummy_shape;
         expressionObj *expression = &(layer->class[i]->expression);
 
+        msInitShape(&dummy_shape);
         dummy_shape.numvalues = numitems;
         dummy_shape.values = item_values;
 
@@ -152,7 +150,7 @@ static int msGetClass_String( layerObj *layer, colorObj *color, const char *pixe
         p.expr->curtoken = p.expr->tokens; /* reset */
         p.type = MS_PARSE_TYPE_BOOLEAN;
 
-        status = yyparse(&p);
+        status = msExecuteExpression(&p);
 
         if (status != 0) {
           msSetError(MS_PARSEERR, "Failed to parse expression: %s", "msGetClass_FloatRGB", expression->string);
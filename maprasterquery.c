@@ -1454,7 +1454,7 @@ int msRASTERLayerSetTimeFilter(layerObj *layer, const char *timestring,
   /* -------------------------------------------------------------------- */
   if ( msCheckParentPointer(layer->map,"map")==MS_FAILURE )
     return MS_FAILURE;
-  return msLayerSetTimeFilter( layer->GET_LAYER(map,tilelayerindex),
+  return msLayerSetTimeFilter( GET_LAYER(layer->map, tilelayerindex),
                                timestring, timefield );
 }
 
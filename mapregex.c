@@ -55,10 +55,15 @@
 
 MS_API_EXPORT(int) ms_regcomp(ms_regex_t *regex, const char *expr, int cflags)
 {
-  /* Must free in regfree() */
+  /* Must free in regfree(), unless compiling fails */
   regex_t* sys_regex = (regex_t*) msSmallMalloc(sizeof(regex_t));
+  int status = regcomp(sys_regex, expr, cflags);
+  if(status != 0) {
+    msFree(sys_regex);
+    sys_regex = NULL;
+  }
   regex->sys_regex = (void*) sys_regex;
-  return regcomp(sys_regex, expr, cflags);
+  return status;
 }
 
 MS_API_EXPORT(size_t) ms_regerror(int errcode, const ms_regex_t *regex, char *errbuf, size_t errbuf_size)
@@ -322,7 +322,7 @@ int msImagePolylineMarkers(imageObj *image, shapeObj *p, symbolObj *symbol,
     symbol_height = MS_MAX(1,symbol->sizey*style->scale);
   } else {
     rectObj rect;
-    if(MS_SUCCESS != renderer->getTruetypeTextBBox(renderer,&symbol->full_font_path,1,style->scale,
+    if(MS_SUCCESS != msGetCachedTruetypeTextBBox(renderer,&symbol->full_font_path,1,style->scale,
         symbol->character,&rect,NULL,0))
       return MS_FAILURE;
     symbol_width=rect.maxx-rect.minx;
@@ -0,0 +1,508 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  MapServer
+ * Purpose:  Packed Hilbert R-tree spatial index (.prt), a static alternative
+ *           to the .qix quadtree.
+ * Author:   Steve Lime and the MapServer team.
+ *
+ ******************************************************************************
+ * Copyright (c) 1996-2005 Regents of the University of Minnesota.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies of this Software or works derived from this Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "mapserver.h"
+#include "maptree.h"
+
+/*
+** The shapes' bounding boxes are sorted along a Hilbert curve and packed
+** bottom up into full nodes of a fixed size, so the tree is balanced
+** whatever the data distribution. The file is laid out so it can be used
+** straight from a memory mapping:
+**
+**   header      64 bytes, see below
+**   levelends   numlevels int32, padded to a multiple of 8 bytes
+**   boxes       numnodes * 4 doubles (minx, miny, maxx, maxy)
+**   indices     numnodes int32
+**
+** Nodes are stored level by level, the leaves (one per indexed shape)
+** first and the root last. The index of a leaf is its shape id, the index
+** of an inner node is the position of its first child, its children being
+** the following nodesize entries (or up to the end of their level).
+**
+** The header holds the "SPR" signature and a version byte, then as int32
+** the node size, number of indexed shapes, number of records of the
+** shapefile, number of nodes and number of levels, followed by the bounds
+** of the index as 4 doubles. Everything is little endian.
+*/
+
+#define MS_RTREE_VERSION 1
+#define MS_RTREE_HEADER_SIZE 64
+#define MS_RTREE_DEFAULT_NODESIZE 16
+
+#define MS_HILBERT_MAX 65535
+
+typedef struct {
+  unsigned int hilbert;
+  ms_int32 id;
+} rtreeItemObj;
+
+static int rtreeIsBigEndian(void)
+{
+  int i = 1;
+  return (*((uchar *) &i) == 1) ? MS_FALSE : MS_TRUE;
+}
+
+static void rtreeSwapWord(int length, void *wordP)
+{
+  int i;
+  uchar temp;
+
+  for(i=0; i < length/2; i++) {
+    temp = ((uchar *) wordP)[i];
+    ((uchar *)wordP)[i] = ((uchar *) wordP)[length-i-1];
+    ((uchar *) wordP)[length-i-1] = temp;
+  }
+}
+
+/*
+** Position of (x, y) along the Hilbert curve filling a 2^16 x 2^16 grid,
+** using the branch free formulation from "Hacker's Delight" as
+** popularized by Flatbush.
+*/
+static unsigned int hilbertXYToIndex(unsigned int x, unsigned int y)
+{
+  unsigned int a = x ^ y;
+  unsigned int b = 0xFFFF ^ a;
+  unsigned int c = 0xFFFF ^ (x | y);
+  unsigned int d = x & (y ^ 0xFFFF);
+
+  unsigned int A = a | (b >> 1);
+  unsigned int B = (a >> 1) ^ a;
+  unsigned int C = ((c >> 1) ^ (b & (d >> 1))) ^ c;
+  unsigned int D = ((a & (c >> 1)) ^ (d >> 1)) ^ d;
+
+  unsigned int i0, i1;
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  A = ((a & (a >> 2)) ^ (b & (b >> 2)));
+  B = ((a & (b >> 2)) ^ (b & ((a ^ b) >> 2)));
+  C ^= ((a & (c >> 2)) ^ (b & (d >> 2)));
+  D ^= ((b & (c >> 2)) ^ ((a ^ b) & (d >> 2)));
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  A = ((a & (a >> 4)) ^ (b & (b >> 4)));
+  B = ((a & (b >> 4)) ^ (b & ((a ^ b) >> 4)));
+  C ^= ((a & (c >> 4)) ^ (b & (d >> 4)));
+  D ^= ((b & (c >> 4)) ^ ((a ^ b) & (d >> 4)));
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  C ^= ((a & (c >> 8)) ^ (b & (d >> 8)));
+  D ^= ((b & (c >> 8)) ^ ((a ^ b) & (d >> 8)));
+
+  a = C ^ (C >> 1);
+  b = D ^ (D >> 1);
+
+  i0 = x ^ y;
+  i1 = b | (0xFFFF ^ (i0 | a));
+
+  i0 = (i0 | (i0 << 8)) & 0x00FF00FF;
+  i0 = (i0 | (i0 << 4)) & 0x0F0F0F0F;
+  i0 = (i0 | (i0 << 2)) & 0x33333333;
+  i0 = (i0 | (i0 << 1)) & 0x55555555;
+
+  i1 = (i1 | (i1 << 8)) & 0x00FF00FF;
+  i1 = (i1 | (i1 << 4)) & 0x0F0F0F0F;
+  i1 = (i1 | (i1 << 2)) & 0x33333333;
+  i1 = (i1 | (i1 << 1)) & 0x55555555;
+
+  return (i1 << 1) | i0;
+}
+
+/*
+** Hilbert key of the center of rect within extent, shared with sortshp so
+** a shapefile sorted with -hilbert is stored in the order the packed
+** R-tree leaves are built in.
+*/
+unsigned int msHilbertKey(rectObj *extent, rectObj *rect)
+{
+  double width = extent->maxx - extent->minx, height = extent->maxy - extent->miny;
+  double x = 0, y = 0;
+
+  if(width > 0) x = MS_HILBERT_MAX * ((rect->minx + rect->maxx)/2 - extent->minx) / width;
+  if(height > 0) y = MS_HILBERT_MAX * ((rect->miny + rect->maxy)/2 - extent->miny) / height;
+
+  /* centers outside of extent (a stale header) go to the nearest edge */
+  x = MS_MAX(0, MS_MIN(x, MS_HILBERT_MAX));
+  y = MS_MAX(0, MS_MIN(y, MS_HILBERT_MAX));
+
+  return hilbertXYToIndex((unsigned int) x, (unsigned int) y);
+}
+
+static int rtreeItemCompare(const void *a, const void *b)
+{
+  const rtreeItemObj *ia = (const rtreeItemObj *) a, *ib = (const rtreeItemObj *) b;
+
+  if(ia->hilbert != ib->hilbert)
+    return (ia->hilbert < ib->hilbert) ? -1 : 1;
+  return ia->id - ib->id; /* keep the order stable */
+}
+
+static void rtreeWriteInt32(FILE *fp, ms_int32 value, int swap)
+{
+  if(swap) rtreeSwapWord(4, &value);
+  fwrite(&value, 4, 1, fp);
+}
+
+static void rtreeWriteDouble(FILE *fp, double value, int swap)
+{
+  if(swap) rtreeSwapWord(8, &value);
+  fwrite(&value, 8, 1, fp);
+}
+
+/*
+** Build the packed R-tree of a shapefile in memory, in the layout of the
+** file but in native byte order. Shapes without bounds (NULL shapes) are
+** not indexed. A nodesize of 0 selects the default.
+*/
+packedRTreeObj *msCreatePackedRTree(shapefileObj *shapefile, int nodesize)
+{
+  packedRTreeObj *tree;
+  rtreeItemObj *items;
+  rectObj *rects, *boxes, bounds;
+  ms_int32 *indices, *levelends;
+  int i, j, numitems=0, numnodes, numlevels, n, pos;
+  size_t offset;
+
+  if(nodesize <= 0) nodesize = MS_RTREE_DEFAULT_NODESIZE;
+  if(nodesize < 2 || nodesize > 65535) {
+    msSetError(MS_MISCERR, "Invalid node size %d.", "msCreatePackedRTree()", nodesize);
+    return NULL;
+  }
+
+  rects = (rectObj *) msSmallMalloc(sizeof(rectObj) * (shapefile->numshapes > 0 ? shapefile->numshapes : 1));
+  items = (rtreeItemObj *) msSmallMalloc(sizeof(rtreeItemObj) * (shapefile->numshapes > 0 ? shapefile->numshapes : 1));
+
+  bounds.minx = bounds.miny = bounds.maxx = bounds.maxy = 0;
+  for(i=0; i<shapefile->numshapes; i++) {
+    if(msSHPReadBounds(shapefile->hSHP, i, &rects[i]) != MS_SUCCESS)
+      continue;
+    if(numitems == 0)
+      bounds = rects[i];
+    else
+      msMergeRect(&bounds, &rects[i]);
+    items[numitems++].id = i;
+  }
+
+  /* -------------------------------------------------------------------- */
+  /*      Sort the shapes along the Hilbert curve of their centers.       */
+  /* -------------------------------------------------------------------- */
+  for(i=0; i<numitems; i++)
+    items[i].hilbert = msHilbertKey(&bounds, &rects[items[i].id]);
+  qsort(items, numitems, sizeof(rtreeItemObj), rtreeItemCompare);
+
+  /* -------------------------------------------------------------------- */
+  /*      Count the levels and nodes, there is always at least one        */
+  /*      level above the leaves.                                         */
+  /* -------------------------------------------------------------------- */
+  numnodes = n = numitems;
+  numlevels = 1;
+  if(numitems > 0) {
+    do {
+      n = (n + nodesize - 1) / nodesize;
+      numnodes += n;
+      numlevels++;
+    } while(n != 1);
+  }
+
+  tree = (packedRTreeObj *) msSmallCalloc(1, sizeof(packedRTreeObj));
+  tree->nodesize = nodesize;
+  tree->numitems = numitems;
+  tree->numshapes = shapefile->numshapes;
+  tree->numnodes = numnodes;
+  tree->numlevels = numlevels;
+  tree->bounds = bounds;
+
+  offset = MS_RTREE_HEADER_SIZE + 4*(size_t)(numlevels + numlevels%2);
+  tree->size = offset + (size_t)numnodes * (sizeof(rectObj) + 4);
+  tree->data = (uchar *) msSmallCalloc(1, tree->size);
+  memcpy(tree->data, "SPR", 3);
+  tree->data[3] = MS_RTREE_VERSION;
+  memcpy(tree->data+4, &tree->nodesize, 4);
+  memcpy(tree->data+8, &tree->numitems, 4);
+  memcpy(tree->data+12, &tree->numshapes, 4);
+  memcpy(tree->data+16, &tree->numnodes, 4);
+  memcpy(tree->data+20, &tree->numlevels, 4);
+  memcpy(tree->data+24, &tree->bounds, sizeof(rectObj));
+
+  tree->levelends = levelends = (ms_int32 *) (tree->data + MS_RTREE_HEADER_SIZE);
+  tree->boxes = (double *) (tree->data + offset);
+  tree->indices = indices = (ms_int32 *) (tree->data + offset + (size_t)numnodes * sizeof(rectObj));
+  boxes = (rectObj *) tree->boxes;
+
+  for(i=0; i<numitems; i++) {
+    boxes[i] = rects[items[i].id];
+    indices[i] = items[i].id;
+  }
+  levelends[0] = numitems;
+
+  /* -------------------------------------------------------------------- */
+  /*      Pack each level into parent nodes.                              */
+  /* -------------------------------------------------------------------- */
+  pos = 0;
+  for(j=1; j<numlevels; j++) {
+    int end = levelends[j-1], parent = end;
+    while(pos < end) {
+      int first = pos;
+      rectObj box = boxes[pos];
+      for(i=0; i<nodesize && pos < end; i++, pos++)
+        msMergeRect(&box, &boxes[pos]);
+      boxes[parent] = box;
+      indices[parent] = first;
+      parent++;
+    }
+    levelends[j] = parent;
+  }
+
+  free(rects);
+  free(items);
+
+  return tree;
+}
+
+/*
+** Build the packed R-tree of a shapefile and write it to filename, see
+** msCreatePackedRTree().
+*/
+int msWritePackedRTree(shapefileObj *shapefile, char *filename, int nodesize)
+{
+  packedRTreeObj *tree;
+  int i, swap;
+  FILE *fp;
+
+  tree = msCreatePackedRTree(shapefile, nodesize);
+  if(!tree)
+    return MS_FAILURE;
+
+  fp = fopen(filename, "wb");
+  if(!fp) {
+    msSetError(MS_IOERR, "(%s)", "msWritePackedRTree()", filename);
+    msPackedRTreeClose(tree);
+    return MS_FAILURE;
+  }
+
+  swap = rtreeIsBigEndian();
+
+  fwrite("SPR", 3, 1, fp);
+  fputc(MS_RTREE_VERSION, fp);
+  rtreeWriteInt32(fp, tree->nodesize, swap);
+  rtreeWriteInt32(fp, tree->numitems, swap);
+  rtreeWriteInt32(fp, tree->numshapes, swap);
+  rtreeWriteInt32(fp, tree->numnodes, swap);
+  rtreeWriteInt32(fp, tree->numlevels, swap);
+  rtreeWriteDouble(fp, tree->bounds.minx, swap);
+  rtreeWriteDouble(fp, tree->bounds.miny, swap);
+  rtreeWriteDouble(fp, tree->bounds.maxx, swap);
+  rtreeWriteDouble(fp, tree->bounds.maxy, swap);
+  for(i=56; i<MS_RTREE_HEADER_SIZE; i++)
+    fputc(0, fp);
+
+  for(i=0; i<tree->numlevels; i++)
+    rtreeWriteInt32(fp, tree->levelends[i], swap);
+  if(tree->numlevels % 2)
+    rtreeWriteInt32(fp, 0, swap);
+
+  for(i=0; i<tree->numnodes*4; i++)
+    rtreeWriteDouble(fp, tree->boxes[i], swap);
+  for(i=0; i<tree->numnodes; i++)
+    rtreeWriteInt32(fp, tree->indices[i], swap);
+
+  msPackedRTreeClose(tree);
+
+  if(fclose(fp) != 0) {
+    msSetError(MS_IOERR, "Error writing %s.", "msWritePackedRTree()", filename);
+    return MS_FAILURE;
+  }
+
+  return MS_SUCCESS;
+}
+
+/*
+** Open a packed R-tree, mapping it in memory where possible. Returns NULL
+** without setting an error if there is no such file.
+*/
+packedRTreeObj *msPackedRTreeOpen(const char *filename, int debug)
+{
+  packedRTreeObj *tree;
+  FILE *fp;
+  size_t offset;
+  int i;
+
+  fp = fopen(filename, "rb");
+  if(!fp)
+    return NULL;
+
+  tree = (packedRTreeObj *) msSmallCalloc(1, sizeof(packedRTreeObj));
+
+  /* big endian hosts need a private, byte swapped, copy */
+  if(!rtreeIsBigEndian())
+    tree->data = msSHPMapFile(fp, &tree->size);
+
+  if(tree->data) {
+    tree->mapped = MS_TRUE;
+  } else {
+    long size;
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if(size > 0) {
+      tree->size = (size_t) size;
+      tree->data = (uchar *) malloc(tree->size);
+      if(tree->data && fread(tree->data, tree->size, 1, fp) != 1) {
+        free(tree->data);
+        tree->data = NULL;
+      }
+    }
+  }
+  fclose(fp);
+
+  if(!tree->data || tree->size < MS_RTREE_HEADER_SIZE || memcmp(tree->data, "SPR", 3) != 0 || tree->data[3] != MS_RTREE_VERSION) {
+    if(debug)
+      msDebug("msPackedRTreeOpen(): %s is not a packed R-tree index, ignoring it.\n", filename);
+    msPackedRTreeClose(tree);
+    return NULL;
+  }
+
+  if(rtreeIsBigEndian()) {
+    for(i=4; i<24; i+=4) rtreeSwapWord(4, tree->data+i);
+    for(i=24; i<56; i+=8) rtreeSwapWord(8, tree->data+i);
+  }
+
+  memcpy(&tree->nodesize, tree->data+4, 4);
+  memcpy(&tree->numitems, tree->data+8, 4);
+  memcpy(&tree->numshapes, tree->data+12, 4);
+  memcpy(&tree->numnodes, tree->data+16, 4);
+  memcpy(&tree->numlevels, tree->data+20, 4);
+  memcpy(&tree->bounds, tree->data+24, sizeof(rectObj));
+
+  offset = MS_RTREE_HEADER_SIZE + 4*(size_t)(tree->numlevels + tree->numlevels%2);
+  if(tree->nodesize < 2 || tree->numitems < 0 || tree->numshapes < tree->numitems ||
+      tree->numnodes < tree->numitems || tree->numlevels < 1 || tree->numlevels > tree->numnodes + 1 ||
+      tree->size < offset + (size_t)tree->numnodes * (sizeof(rectObj) + 4)) {
+    if(debug)
+      msDebug("msPackedRTreeOpen(): %s is corrupted, ignoring it.\n", filename);
+    msPackedRTreeClose(tree);
+    return NULL;
+  }
+
+  tree->levelends = (ms_int32 *) (tree->data + MS_RTREE_HEADER_SIZE);
+  tree->boxes = (double *) (tree->data + offset);
+  tree->indices = (ms_int32 *) (tree->data + offset + (size_t)tree->numnodes * sizeof(rectObj));
+
+  if(rtreeIsBigEndian()) {
+    for(i=0; i<tree->numlevels; i++) rtreeSwapWord(4, &tree->levelends[i]);
+    for(i=0; i<tree->numnodes*4; i++) rtreeSwapWord(8, &tree->boxes[i]);
+    for(i=0; i<tree->numnodes; i++) rtreeSwapWord(4, &tree->indices[i]);
+  }
+
+  for(i=0; i<tree->numlevels; i++) {
+    if(tree->levelends[i] < (i ? tree->levelends[i-1] : 0) || tree->levelends[i] > tree->numnodes) {
+      if(debug)
+        msDebug("msPackedRTreeOpen(): %s is corrupted, ignoring it.\n", filename);
+      msPackedRTreeClose(tree);
+      return NULL;
+    }
+  }
+
+  return tree;
+}
+
+void msPackedRTreeClose(packedRTreeObj *tree)
+{
+  if(!tree) return;
+  if(tree->mapped)
+    msSHPUnmapFile(tree->data, tree->size);
+  else
+    msFree(tree->data);
+  msFree(tree);
+}
+
+/*
+** Collect the ids of all shapes whose bounds overlap aoi into set. Since
+** leaves hold the exact shape bounds no further filtering is needed.
+*/
+void msSearchPackedRTreeIds(packedRTreeObj *tree, rectObj aoi, shapeIdSetObj *set)
+{
+  ms_int32 *stack;
+  int sp = 0, node, end, level, pos;
+
+  msInitShapeIdSet(set, tree->numshapes);
+  if(tree->numitems == 0)
+    return;
+
+  /* at most nodesize (node, level) pairs pending per level */
+  stack = (ms_int32 *) msSmallMalloc(sizeof(ms_int32) * 2 * tree->numlevels * tree->nodesize);
+
+  node = tree->numnodes - 1; /* the root */
+  level = tree->numlevels - 1;
+  for(;;) {
+    /* children of a node run up to nodesize entries, within its level */
+    end = node + tree->nodesize;
+    if(end > tree->levelends[level]) end = tree->levelends[level];
+
+    for(pos = node; pos < end; pos++) {
+      const double *box = tree->boxes + 4*(size_t)pos;
+      ms_int32 index = tree->indices[pos];
+
+      if(box[0] > aoi.maxx || box[2] < aoi.minx || box[1] > aoi.maxy || box[3] < aoi.miny)
+        continue;
+
+      if(level == 0) {
+        msAddShapeId(set, index);
+      } else if(index >= 0 && index < pos) { /* children always come first */
+        stack[sp++] = index;
+        stack[sp++] = level - 1;
+      }
+    }
+
+    if(sp == 0) break;
+    level = stack[--sp];
+    node = stack[--sp];
+  }
+
+  free(stack);
+}
+
+ms_bitarray msSearchPackedRTree(packedRTreeObj *tree, rectObj aoi)
+{
+  shapeIdSetObj set;
+
+  msSearchPackedRTreeIds(tree, aoi, &set);
+  return msShapeIdSetToBitArray(&set);
+}
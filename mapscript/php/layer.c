@@ -2040,6 +2040,7 @@ PHP_METHOD(layerObj, getShape)
     mapscript_throw_mapserver_exception("" TSRMLS_CC);
     return;
   }
+  msShapeOwnValues(shape); /* scripts keep shapes as long as they like */
 
   /* Return valid object */
   MAPSCRIPT_MAKE_PARENT(NULL, NULL);
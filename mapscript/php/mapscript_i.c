@@ -87,7 +87,7 @@ int mapObj_setRotation(mapObj* self, double rotation_angle )
 layerObj *mapObj_getLayer(mapObj* self, int i)
 {
   if(i >= 0 && i < self->numlayers)
-    return (self->layers[i]); /* returns an EXISTING layer */
+    return (GET_LAYER(self, i)); /* returns an EXISTING layer, parsed if lazy */
   else
     return NULL;
 }
@@ -99,7 +99,7 @@ layerObj *mapObj_getLayerByName(mapObj* self, char *name)
   i = msGetLayerIndex(self, name);
 
   if(i != -1)
-    return (self->layers[i]); /* returns an EXISTING layer */
+    return (GET_LAYER(self, i)); /* returns an EXISTING layer, parsed if lazy */
   else
     return NULL;
 }
@@ -553,8 +553,10 @@ shapeObj *layerObj_nextShape(layerObj *self)
     msFreeShape(shape);
     free(shape);
     return NULL;
-  } else
+  } else {
+    msShapeOwnValues(shape); /* scripts keep shapes as long as they like */
     return shape;
+  }
 }
 
 void layerObj_close(layerObj *self)
@@ -189,8 +189,10 @@
          msFreeShape(shape);
 	 free(shape);
 	 return NULL;
-       } else
+       } else {
+         msShapeOwnValues(shape); /* scripts keep shapes as long as they like */
          return shape;
+       }
     }
 
     void close() 
@@ -213,6 +215,7 @@
         shape->type = self->type; /* is this right? */
 
         retval = msLayerGetShape(self, shape, record);
+        msShapeOwnValues(shape); /* scripts keep shapes as long as they like */
         return shape;
     }
 
@@ -115,7 +115,7 @@
   layerObj *getLayer(int i) {
     if(i >= 0 && i < self->numlayers) {
     	MS_REFCNT_INCR(self->layers[i]);
-      	return (self->layers[i]); /* returns an EXISTING layer */
+      	return (GET_LAYER(self, i)); /* returns an EXISTING layer, parsed if lazy */
     } else {
       return NULL;
     }
@@ -129,7 +129,7 @@
 
     if(i != -1) {
       MS_REFCNT_INCR(self->layers[i]);
-      return (self->layers[i]); /* returns an EXISTING layer */
+      return (GET_LAYER(self, i)); /* returns an EXISTING layer, parsed if lazy */
     }
     else
       return NULL;
@@ -213,6 +213,7 @@
         }
         if (i >= 0 && i < self->numvalues)
         {
+            msShapeOwnValues(self);
             msFree(self->values[i]);
             self->values[i] = strdup(value);
             if (!self->values[i])
@@ -233,9 +234,7 @@
     {
         int i;
         
-        if(self->values) msFreeCharArray(self->values, self->numvalues);
-        self->values = NULL;
-        self->numvalues = 0;
+        msFreeShapeValues(self);
         
         /* Allocate memory for the values */
         if (numvalues > 0) {
@@ -228,6 +228,8 @@ extern "C" {
 #define MS_TEMPLATE_EXPR "\\.(xml|wml|html|htm|svg|kml|gml|js|tmpl)$"
 
 #define MS_INDEX_EXTENSION ".qix"
+#define MS_RTREE_INDEX_EXTENSION ".prt"
+#define MS_ATTRIBUTE_INDEX_EXTENSION ".aix"
 
 #define MS_QUERY_RESULTS_MAGIC_STRING "MapServer Query Results"
 #define MS_QUERY_PARAMS_MAGIC_STRING "MapServer Query Params"
@@ -256,6 +258,7 @@ extern "C" {
 
 #define MS_MAXPROJARGS 20
 #define MS_MAXJOINS 20
+#define MS_MAXINCLUDEDEPTH 5 /* nested mapfile INCLUDEs */
 #define MS_ITEMNAMELEN 32
 #define MS_NAMELEN 20
 
@@ -433,7 +436,14 @@ extern "C" {
 
 #define MS_ENCRYPTION_KEY_SIZE  16   /* Key size: 128 bits = 16 bytes */
 
-#define GET_LAYER(map, pos) map->layers[pos]
+/*
+** GET_LAYER() parses a lazy layer (see msLoadLazyLayer()) on first use. Code
+** visiting every layer can read map->layers[] directly for the name, group,
+** status, requires, labelrequires and metadata, which lazy layers have, and
+** skip lazy layers that are OFF with MS_LAZY_LAYER_OFF().
+*/
+#define GET_LAYER(map, pos) ((map)->layers[pos]->lazy ? msLoadLazyLayer((map)->layers[pos]) : (map)->layers[pos])
+#define MS_LAZY_LAYER_OFF(map, pos) ((map)->layers[pos]->lazy && (map)->layers[pos]->status == MS_OFF)
 #define GET_CLASS(map, lid, cid) map->layers[lid]->class[cid]
 
 #if defined(HAVE_SYNC_FETCH_AND_ADD)
@@ -673,6 +683,10 @@ extern "C" {
 
   typedef tokenListNodeObj * tokenListNodeObjPtr;
 
+  /* compiled form of an expression token list, see mapexprcompile.c */
+  typedef struct exprProgramObj exprProgramObj;
+  enum MS_EXPR_PROGRAM_ENUM { MS_EXPR_PROGRAM_UNKNOWN, MS_EXPR_PROGRAM_COMPILED, MS_EXPR_PROGRAM_FALLBACK };
+
   typedef struct {
     char *string;
     int type;
@@ -687,6 +701,10 @@ extern "C" {
     /* regular expression options */
     ms_regex_t regex; /* compiled regular expression to be matched */
     int compiled;
+
+    /* compiled token list, built on first evaluation */
+    exprProgramObj *program;
+    int programstatus; /* one of MS_EXPR_PROGRAM_ENUM */
   } expressionObj;
 
   typedef struct {
@@ -698,6 +716,46 @@ extern "C" {
     int type; /* type of parse: boolean, string/text or shape/geometry */
     parseResultObj result; /* parse result */
   } parseObj;
+
+  /*
+  ** Tokenizer state (see maplexer.l). Each mapfile, symbolset, snippet or
+  ** expression is read through its own lexerObj, so they can be read from
+  ** several threads at once. Set state (and string or the input file) then
+  ** call msyylex() once to start tokenizing.
+  */
+  typedef struct {
+    void *scanner; /* the flex scanner (yyscan_t) */
+
+    int state; /* one of MS_LEXER_STATES, applied by the next msyylex() */
+    int source; /* one of MS_TOKEN_SOURCES */
+    char *string; /* string to tokenize */
+    char *basepath; /* INCLUDEs are relative to this */
+    int returncomments;
+    int lineno;
+
+    /* token containers */
+    double number;
+    char *string_buffer;
+    char *string_buffer_ptr;
+    int string_buffer_size;
+    int string_size;
+    int string_size_tmp;
+    char string_begin;
+    int string_icase;
+    int string_return_state;
+    int string_begin_state;
+
+    /* INCLUDEd files being read */
+    void *include_stack[MS_MAXINCLUDEDEPTH];
+    int include_lineno[MS_MAXINCLUDEDEPTH];
+    int include_stack_ptr;
+    char path[MS_MAXPATHLEN];
+
+    /* token records of a compiled mapfile, replayed instead of scanning (see msCompileMap()) */
+    char *compiled;
+    char *compiled_ptr;
+    char *compiled_end;
+  } lexerObj;
 #endif
 
   /* MS RFC 69*/
@@ -1207,6 +1265,9 @@ extern "C" {
      */
     int numlabels;
     int gutter; /* space in pixels around the image where labels cannot be placed */
+#ifndef SWIG
+    struct labelCacheIndexObj *index; /* placed labels and markers, see msBuildLabelCacheIndex() */
+#endif
   } labelCacheObj;
 
   /************************************************************************/
@@ -1249,6 +1310,23 @@ extern "C" {
   } resultCacheObj;
 
 
+#ifndef SWIG
+  /************************************************************************/
+  /*                             nameIndexObj                             */
+  /*                                                                      */
+  /*      Maps the names of the layers of a map, the classes of a layer   */
+  /*      or the symbols of a symbolset to their position. Entries are    */
+  /*      added as the array grows and the whole index is dropped by the  */
+  /*      functions that insert, remove or reorder elements. Names can    */
+  /*      still be changed in place, so a hit is always checked against  */
+  /*      the array. See msGetLayerIndex().                               */
+  /************************************************************************/
+  typedef struct {
+    hashTableObj names; /* name -> position, first occurrence wins */
+    int numindexed; /* elements 0..numindexed-1 are in names */
+  } nameIndexObj;
+#endif /* not SWIG */
+
   /************************************************************************/
   /*                             symbolSetObj                             */
   /************************************************************************/
@@ -1269,6 +1347,7 @@ extern "C" {
     struct mapObj *map;
     fontSetObj *fontset; /* a pointer to the main mapObj version */
     struct imageCacheObj *imagecache;
+    nameIndexObj nameindex; /* see msGetSymbolIndex() */
 #endif /* not SWIG */
   } symbolSetObj;
 
@@ -1465,7 +1544,12 @@ extern "C" {
      int n_entries;
      scaleTokenEntryObj *tokens;
   } scaleTokenObj;
-  
+
+#ifndef SWIG
+  /* hashed class selection, see msLayerBuildClassLookup() in maputil.c */
+  typedef struct classLookupObj classLookupObj;
+#endif
+
   struct layerObj {
 
     char *classitem; /* .DBF item to be used for symbol lookup */
@@ -1480,6 +1564,7 @@ extern "C" {
 #else /* __cplusplus */
     classObj **_class;
 #endif /* __cplusplus */
+    nameIndexObj classindex; /* see msGetClassIndex() */
 #endif /* not SWIG */
 
 #ifdef SWIG
@@ -1596,6 +1681,7 @@ extern "C" {
     int bandsitemindex;
     int filteritemindex;
     int styleitemindex;
+    classLookupObj *classlookup; /* CLASSITEM value to class table, see msLayerBuildClassLookup() */
 #endif /* not SWIG */
 
     char *bandsitem; /* which item in a tile contains bands to use (tiled raster data only) */
@@ -1645,6 +1731,16 @@ extern "C" {
 
 #ifndef SWIG    
     expressionObj _geomtransform;
+
+    /* token records of a layer not parsed yet, see msLoadLazyLayer() */
+    char *lazy;
+    int lazysize;
+
+    /* features read ahead of drawing by msDrawMap(), see msDrawVectorLayer() */
+    struct layerPrefetchObj *prefetch;
+
+    /* scratch points for msClipTransformShape(), see msDrawVectorLayer() */
+    pointBufferObj *clipbuffer;
 #endif    
   };
 
@@ -1664,6 +1760,7 @@ extern "C" {
 
 #ifndef SWIG
     layerObj **layers;
+    nameIndexObj layerindex; /* see msGetLayerIndex() */
 #endif /* SWIG */
 
 #ifdef SWIG
@@ -1761,6 +1858,12 @@ extern "C" {
     unsigned char encryption_key[MS_ENCRYPTION_KEY_SIZE]; /* 128bits encryption key */
 
     queryObj query;
+
+    /* mapfile the map was loaded from (NULL if not loaded from a file), */
+    /* with its modification time and size at the time, see msOWSDispatch() */
+    char *filename;
+    long filemtime;
+    long filesize;
 #endif
   };
 
@@ -1813,11 +1916,16 @@ extern "C" {
   ** helper functions not part of the general API but needed in
   ** a few other places (like mapscript)... found in mapfile.c
   */
-  int getString(char **s);
-  int getDouble(double *d);
-  int getInteger(int *i);
-  int getSymbol(int n, ...);
-  int getCharacter(char *c);
+  int getString(lexerObj *lexer, char **s);
+  int getDouble(lexerObj *lexer, double *d);
+  int getInteger(lexerObj *lexer, int *i);
+  int getSymbol(lexerObj *lexer, int n, ...);
+  int getCharacter(lexerObj *lexer, char *c);
+  int msLexerNextToken(lexerObj *lexer);
+
+  /* found in maplexer.c */
+  MS_DLL_EXPORT int msInitLexer(lexerObj *lexer);
+  MS_DLL_EXPORT void msFreeLexer(lexerObj *lexer);
 
   int msBuildPluginLibraryPath(char **dest, const char *lib_str, mapObj *map);
 
@@ -1911,8 +2019,14 @@ extern "C" {
 
   MS_DLL_EXPORT int msValidateParameter(char *value, char *pattern1, char *pattern2, char *pattern3, char *pattern4);
   MS_DLL_EXPORT int msGetLayerIndex(mapObj *map, char *name);
+  MS_DLL_EXPORT void msInitNameIndex(nameIndexObj *index);
+  MS_DLL_EXPORT void msFreeNameIndex(nameIndexObj *index);
   MS_DLL_EXPORT int msGetSymbolIndex(symbolSetObj *set, char *name, int try_addimage_if_notfound);
   MS_DLL_EXPORT mapObj  *msLoadMap(char *filename, char *new_mappath);
+  MS_DLL_EXPORT mapObj  *msLoadMapCached(char *filename, char *new_mappath);
+  MS_DLL_EXPORT layerObj *msLoadLazyLayer(layerObj *layer);
+  MS_DLL_EXPORT void msSetMapCacheSize(const char *value);
+  MS_DLL_EXPORT void msMapCacheCleanup(void);
   MS_DLL_EXPORT int msTransformXmlMapfile(const char *stylesheet, const char *xmlMapfile, FILE *tmpfile);
   MS_DLL_EXPORT int msSaveMap(mapObj *map, char *filename);
   MS_DLL_EXPORT void msFreeCharArray(char **array, int num_items);
@@ -1945,6 +2059,7 @@ extern "C" {
 #define msFree free
 #endif
   MS_DLL_EXPORT char **msTokenizeMap(char *filename, int *numtokens);
+  MS_DLL_EXPORT int msCompileMap(char *filename, char *outfile);
   MS_DLL_EXPORT int msInitLabelCache(labelCacheObj *cache);
   MS_DLL_EXPORT int msFreeLabelCache(labelCacheObj *cache);
   MS_DLL_EXPORT int msCheckConnection(layerObj * layer); /* connection pooling functions (mapfile.c) */
@@ -2132,12 +2247,19 @@ extern "C" {
 
   MS_DLL_EXPORT char *msTransformLabelText(mapObj *map, labelObj *label, char *text);
   MS_DLL_EXPORT int msGetTruetypeTextBBox(rendererVTableObj *renderer, char* fontstring, fontSetObj *fontset, double size, char *string, rectObj *rect, double **advances, int bAdjustBaseline);
+  MS_DLL_EXPORT int msGetCachedTruetypeTextBBox(rendererVTableObj *renderer, char **fonts, int numfonts, double size, char *string, rectObj *rect, double **advances, int bAdjustBaseline);
+  MS_DLL_EXPORT void msGetTextCacheStats(long *hits, long *misses, int *count);
+  MS_DLL_EXPORT void msSetTextCacheSize(const char *value);
+  MS_DLL_EXPORT void msTextCacheCleanup(void);
 
   MS_DLL_EXPORT int msGetLabelSize(mapObj *map, labelObj *label, char *string, double size, rectObj *rect, double **advances);
 
   MS_DLL_EXPORT int msAddLabel(mapObj *map, labelObj *label, int layerindex, int classindex, shapeObj *shape, pointObj *point, labelPathObj *labelpath, double featuresize);
   MS_DLL_EXPORT int msAddLabelGroup(mapObj *map, int layerindex, int classindex, shapeObj *shape, pointObj *point, double featuresize);
   MS_DLL_EXPORT int msTestLabelCacheCollisions(mapObj *map, labelCacheMemberObj *cachePtr, shapeObj *poly, int mindistance, int current_priority, int current_label);
+  MS_DLL_EXPORT int msBuildLabelCacheIndex(mapObj *map);
+  MS_DLL_EXPORT void msLabelCacheIndexAddLabel(labelCacheObj *labelcache, int priority, int label);
+  MS_DLL_EXPORT void msFreeLabelCacheIndex(labelCacheObj *labelcache);
   MS_DLL_EXPORT labelCacheMemberObj *msGetLabelCacheMember(labelCacheObj *labelcache, int i);
 
   MS_DLL_EXPORT void msFreeShape(shapeObj *shape); /* in mapprimitive.c */
@@ -2147,6 +2269,9 @@ extern "C" {
   MS_DLL_EXPORT void msInitShape(shapeObj *shape);
   MS_DLL_EXPORT void msShapeDeleteLine( shapeObj *shape, int line );
   MS_DLL_EXPORT int msCopyShape(shapeObj *from, shapeObj *to);
+  MS_DLL_EXPORT void msShapeOwnValues(shapeObj *shape);
+  MS_DLL_EXPORT void msFreeShapeValues(shapeObj *shape);
+  MS_DLL_EXPORT double msShapeGetNumericValue(shapeObj *shape, int i);
   MS_DLL_EXPORT int msIsOuterRing(shapeObj *shape, int r);
   MS_DLL_EXPORT int *msGetOuterList(shapeObj *shape);
   MS_DLL_EXPORT int *msGetInnerList(shapeObj *shape, int r, int *outerlist);
@@ -2155,6 +2280,7 @@ extern "C" {
   MS_DLL_EXPORT void msClipPolylineRect(shapeObj *shape, rectObj rect);
   MS_DLL_EXPORT void msClipPolygonRect(shapeObj *shape, rectObj rect);
   MS_DLL_EXPORT void msTransformShape(shapeObj *shape, rectObj extent, double cellsize, imageObj *image);
+  MS_DLL_EXPORT void msClipTransformShape(shapeObj *shape, rectObj *cliprect, rectObj extent, double cellsize, imageObj *image, pointBufferObj *buffer);
   MS_DLL_EXPORT void msTransformPoint(pointObj *point, rectObj *extent, double cellsize, imageObj *image);
 
   MS_DLL_EXPORT void msOffsetPointRelativeTo(pointObj *point, layerObj *layer);
@@ -2201,6 +2327,16 @@ extern "C" {
   MS_DLL_EXPORT void msFlipBit(ms_bitarray array, int index);
   MS_DLL_EXPORT int msGetNextBit(ms_bitarray array, int index, int size);
 
+#ifndef SWIG
+  MS_DLL_EXPORT void msInitShapeIdSet(shapeIdSetObj *set, int numshapes);
+  MS_DLL_EXPORT void msAddShapeId(shapeIdSetObj *set, int id);
+  MS_DLL_EXPORT void msSortShapeIdSet(shapeIdSetObj *set);
+  MS_DLL_EXPORT ms_bitarray msShapeIdSetToBitArray(shapeIdSetObj *set);
+  MS_DLL_EXPORT void msFreeShapeIdSet(shapeIdSetObj *set);
+
+  MS_DLL_EXPORT int msSearchAttributeIndex(layerObj *layer, const char *basename, int numshapes, shapeIdSetObj *set); /* in mapattrindex.c */
+#endif
+
   /* maplayer.c - layerObj  api */
 
   MS_DLL_EXPORT int msLayerInitItemInfo(layerObj *layer);
@@ -2234,6 +2370,11 @@ extern "C" {
   MS_DLL_EXPORT int msLayerSupportsCommonFilters(layerObj *layer);
   MS_DLL_EXPORT int msTokenizeExpression(expressionObj *expression, char **list, int *listsize);
 
+  /* mapexprcompile.c */
+  MS_DLL_EXPORT int msCompileExpression(expressionObj *exp);
+  MS_DLL_EXPORT void msFreeExpressionProgram(expressionObj *exp);
+  MS_DLL_EXPORT int msExecuteExpression(parseObj *p);
+
   MS_DLL_EXPORT int msLayerSetTimeFilter(layerObj *lp, const char *timestring,
                                          const char *timefield);
   /* Helper functions for layers */
@@ -2437,6 +2578,8 @@ extern "C" {
   MS_DLL_EXPORT int msEvalContext(mapObj *map, layerObj *layer, char *context);
   MS_DLL_EXPORT int msEvalExpression(layerObj *layer, shapeObj *shape, expressionObj *expression, int itemindex);
   MS_DLL_EXPORT int msShapeGetClass(layerObj *layer, mapObj *map, shapeObj *shape, int *classgroup, int numclasses);
+  MS_DLL_EXPORT int msLayerBuildClassLookup(layerObj *layer);
+  MS_DLL_EXPORT void msLayerFreeClassLookup(layerObj *layer);
   MS_DLL_EXPORT int msShapeGetAnnotation(layerObj *layer, shapeObj *shape);
   MS_DLL_EXPORT int msShapeCheckSize(shapeObj *shape, double minfeaturesize);
   MS_DLL_EXPORT int msAdjustImage(rectObj rect, int *width, int *height);
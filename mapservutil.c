@@ -196,14 +196,14 @@ mapObj *msCGILoadMap(mapservObj *mapserv)
   if(i == mapserv->request->NumParams) {
     char *ms_mapfile = getenv("MS_MAPFILE");
     if(ms_mapfile) {
-      map = msLoadMap(ms_mapfile,NULL);
+      map = msLoadMapCached(ms_mapfile,NULL);
     } else {
       msSetError(MS_WEBERR, "CGI variable \"map\" is not set.", "msCGILoadMap()"); /* no default, outta here */
       return NULL;
     }
   } else {
     if(getenv(mapserv->request->ParamValues[i])) /* an environment variable references the actual file to use */
-      map = msLoadMap(getenv(mapserv->request->ParamValues[i]), NULL);
+      map = msLoadMapCached(getenv(mapserv->request->ParamValues[i]), NULL);
     else {
       /* by here we know the request isn't for something in an environment variable */
       if(getenv("MS_MAP_NO_PATH")) {
@@ -217,7 +217,7 @@ mapObj *msCGILoadMap(mapservObj *mapserv)
       }
 
       /* ok to try to load now */
-      map = msLoadMap(mapserv->request->ParamValues[i], NULL);
+      map = msLoadMapCached(mapserv->request->ParamValues[i], NULL);
     }
   }
   
@@ -1696,11 +1696,11 @@ int msCGIDispatchRequest(mapservObj *mapserv)
   ** For each layer let's set layer status
   */
   for(i=0; i<mapserv->map->numlayers; i++) {
-    if((GET_LAYER(mapserv->map, i)->status != MS_DEFAULT)) {
-      if(isOn(mapserv,  GET_LAYER(mapserv->map, i)->name, GET_LAYER(mapserv->map, i)->group) == MS_TRUE) /* Set layer status */
-        GET_LAYER(mapserv->map, i)->status = MS_ON;
+    if((mapserv->map->layers[i]->status != MS_DEFAULT)) {
+      if(isOn(mapserv,  mapserv->map->layers[i]->name, mapserv->map->layers[i]->group) == MS_TRUE) /* Set layer status */
+        mapserv->map->layers[i]->status = MS_ON;
       else
-        GET_LAYER(mapserv->map, i)->status = MS_OFF;
+        mapserv->map->layers[i]->status = MS_OFF;
     }
   }
 
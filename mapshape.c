@@ -37,12 +37,21 @@
 #include <limits.h>
 #include <assert.h>
 #include "mapserver.h"
+#include "mapthread.h"
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #if defined(USE_GDAL) || defined(USE_OGR)
 #include <cpl_conv.h>
 #include <ogr_srs_api.h>
 #endif
 
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <fcntl.h>
+#define SHAPEFILE_USE_MMAP
+#endif
+
 /* Only use this macro on 32-bit integers! */
 #define SWAP_FOUR_BYTES(data) \
   ( ((data >> 24) & 0x000000FF) | ((data >>  8) & 0x0000FF00) | \
@@ -51,6 +60,9 @@
 
 #define ByteCopy( a, b, c )     memcpy( b, a, c )
 
+/* shapes decoded at a time by the shapefile layers' NextShape */
+#define MS_SHAPEFILE_READAHEAD 256
+
 static int      bBigEndian;
 
 /************************************************************************/
@@ -232,6 +244,9 @@ SHPHandle msSHPOpen( const char * pszLayer, const char * pszAccess )
   psSHP->panParts = NULL;
   psSHP->nBufSize = psSHP->nPartMax = 0;
 
+  psSHP->pabySHPMap = psSHP->pabySHXMap = NULL;
+  psSHP->nSHPMapSize = psSHP->nSHXMapSize = 0;
+
   /* -------------------------------------------------------------------- */
   /*  Compute the base (layer) name.  If there is any extension     */
   /*  on the passed in filename we will strip it off.         */
@@ -408,6 +423,9 @@ void msSHPClose(SHPHandle psSHP )
   if(psSHP->pabyRec) free(psSHP->pabyRec);
   if(psSHP->panParts) free(psSHP->panParts);
 
+  msSHPUnmapFile(psSHP->pabySHPMap, psSHP->nSHPMapSize);
+  msSHPUnmapFile(psSHP->pabySHXMap, psSHP->nSHXMapSize);
+
   fclose( psSHP->fpSHX );
   fclose( psSHP->fpSHP );
 
@@ -428,6 +446,109 @@ void msSHPGetInfo(SHPHandle psSHP, int * pnEntities, int * pnShapeType )
     *pnShapeType = psSHP->nShapeType;
 }
 
+/************************************************************************/
+/*                             msSHPMapFile()                           */
+/*                                                                      */
+/*      Map a whole file opened read-only into memory.  The mapping     */
+/*      is shared so all processes reading the same shapefile use       */
+/*      the same pages of the OS cache.  Returns NULL if the file       */
+/*      cannot (or should not) be mapped, the caller then keeps         */
+/*      reading through stdio.                                          */
+/************************************************************************/
+uchar *msSHPMapFile( FILE *fp, size_t *pnSize )
+{
+#ifdef SHAPEFILE_USE_MMAP
+  struct stat sStat;
+  void *pMap;
+  int fd, nFlags;
+
+  *pnSize = 0;
+  if( fp == NULL )
+    return NULL;
+
+  fd = fileno(fp);
+
+  /* never map a handle we might write through, stdio would not see the mapping */
+  nFlags = fcntl(fd, F_GETFL);
+  if( nFlags == -1 || (nFlags & O_ACCMODE) != O_RDONLY )
+    return NULL;
+
+  if( fstat(fd, &sStat) != 0 || sStat.st_size <= 0 )
+    return NULL;
+
+  /* file too large for the address space (32 bit builds) */
+  if( (unsigned long long) sStat.st_size > (size_t) -1 )
+    return NULL;
+
+  pMap = mmap(NULL, (size_t) sStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if( pMap == MAP_FAILED )
+    return NULL;
+
+  *pnSize = (size_t) sStat.st_size;
+  return (uchar *) pMap;
+#else
+  *pnSize = 0;
+  return NULL;
+#endif
+}
+
+void msSHPUnmapFile( uchar *pabyMap, size_t nSize )
+{
+#ifdef SHAPEFILE_USE_MMAP
+  if( pabyMap )
+    munmap(pabyMap, nSize);
+#endif
+}
+
+/************************************************************************/
+/*                             msSHPMapFiles()                          */
+/*                                                                      */
+/*      Switch a read-only handle to decode records straight from      */
+/*      memory mappings of the .shp and .shx instead of going           */
+/*      through fseek()/fread() and the record buffer.  On failure      */
+/*      the handle is left untouched and keeps using stdio.             */
+/************************************************************************/
+int msSHPMapFiles( SHPHandle psSHP )
+{
+  if( psSHP->pabySHPMap )
+    return MS_SUCCESS; /* already mapped */
+
+  psSHP->pabySHXMap = msSHPMapFile(psSHP->fpSHX, &psSHP->nSHXMapSize);
+  if( psSHP->pabySHXMap == NULL )
+    return MS_FAILURE;
+
+  /* make sure the index really holds nRecords entries before trusting it */
+  if( psSHP->nSHXMapSize < 100 + 8 * (size_t) psSHP->nRecords ) {
+    msSHPUnmapFile(psSHP->pabySHXMap, psSHP->nSHXMapSize);
+    psSHP->pabySHXMap = NULL;
+    psSHP->nSHXMapSize = 0;
+    return MS_FAILURE;
+  }
+
+  psSHP->pabySHPMap = msSHPMapFile(psSHP->fpSHP, &psSHP->nSHPMapSize);
+  if( psSHP->pabySHPMap == NULL ) {
+    msSHPUnmapFile(psSHP->pabySHXMap, psSHP->nSHXMapSize);
+    psSHP->pabySHXMap = NULL;
+    psSHP->nSHXMapSize = 0;
+    return MS_FAILURE;
+  }
+
+  return MS_SUCCESS;
+}
+
+/*
+** msSHPMapRecord() - Return a pointer to nSize bytes at nOffset in the
+** mapped .shp, or NULL if the range falls outside of the file.
+*/
+static uchar *msSHPMapRecord( SHPHandle psSHP, int nOffset, int nSize )
+{
+  if( nOffset < 0 || nSize < 0 ||
+      (size_t) nOffset + (size_t) nSize > psSHP->nSHPMapSize )
+    return NULL;
+
+  return psSHP->pabySHPMap + nOffset;
+}
+
 /************************************************************************/
 /*                             msSHPCreate()                            */
 /*                                                                      */
@@ -1020,6 +1141,7 @@ static int msSHPReadAllocateBuffer( SHPHandle psSHP, int hEntity, const char* ps
 int msSHPReadPoint( SHPHandle psSHP, int hEntity, pointObj *point )
 {
   int nEntitySize;
+  uchar *pabyRec;
 
   /* -------------------------------------------------------------------- */
   /*      Only valid for point shapefiles                                 */
@@ -1048,18 +1170,28 @@ int msSHPReadPoint( SHPHandle psSHP, int hEntity, pointObj *point )
     return(MS_FAILURE);
   }
 
-  if (msSHPReadAllocateBuffer(psSHP, hEntity, "msSHPReadPoint()") == MS_FAILURE) {
-    return MS_FAILURE;
-  }
-
   /* -------------------------------------------------------------------- */
   /*      Read the record.                                                */
   /* -------------------------------------------------------------------- */
-  fseek( psSHP->fpSHP, msSHXReadOffset( psSHP, hEntity), 0 );
-  fread( psSHP->pabyRec, nEntitySize, 1, psSHP->fpSHP );
+  if( psSHP->pabySHPMap ) {
+    pabyRec = msSHPMapRecord( psSHP, msSHXReadOffset( psSHP, hEntity), nEntitySize );
+    if( pabyRec == NULL ) {
+      msSetError(MS_SHPERR, "Corrupted feature encountered.  hEntity=%d, nEntitySize=%d", "msSHPReadPoint()",
+                 hEntity, nEntitySize);
+      return(MS_FAILURE);
+    }
+  } else {
+    if (msSHPReadAllocateBuffer(psSHP, hEntity, "msSHPReadPoint()") == MS_FAILURE) {
+      return MS_FAILURE;
+    }
+
+    fseek( psSHP->fpSHP, msSHXReadOffset( psSHP, hEntity), 0 );
+    fread( psSHP->pabyRec, nEntitySize, 1, psSHP->fpSHP );
+    pabyRec = psSHP->pabyRec;
+  }
 
-  memcpy( &(point->x), psSHP->pabyRec + 12, 8 );
-  memcpy( &(point->y), psSHP->pabyRec + 20, 8 );
+  memcpy( &(point->x), pabyRec + 12, 8 );
+  memcpy( &(point->y), pabyRec + 20, 8 );
 
   if( bBigEndian ) {
     SwapWord( 8, &(point->x));
@@ -1154,6 +1286,20 @@ int msSHXLoadAll( SHPHandle psSHP )
 
 }
 
+/*
+** msSHXMapEntry() - Decode one of the two big endian words of an index
+** entry straight from the mapped SHX, converted to bytes.
+*/
+static int msSHXMapEntry( SHPHandle psSHP, int hEntity, int nWord )
+{
+  ms_int32 nValue;
+
+  memcpy( &nValue, psSHP->pabySHXMap + 100 + 8 * (size_t) hEntity + 4 * nWord, 4 );
+  if( !bBigEndian ) nValue = SWAP_FOUR_BYTES(nValue);
+
+  return nValue * 2;
+}
+
 int msSHXReadOffset( SHPHandle psSHP, int hEntity )
 {
 
@@ -1163,6 +1309,9 @@ int msSHXReadOffset( SHPHandle psSHP, int hEntity )
   if( hEntity < 0 || hEntity >= psSHP->nRecords )
     return(MS_FAILURE);
 
+  if( psSHP->pabySHXMap )
+    return msSHXMapEntry( psSHP, hEntity, 0 );
+
   if( ! (psSHP->panRecAllLoaded || msGetBit(psSHP->panRecLoaded, shxBufferPage)) ) {
     msSHXLoadPage( psSHP, shxBufferPage );
   }
@@ -1180,6 +1329,9 @@ int msSHXReadSize( SHPHandle psSHP, int hEntity )
   if( hEntity < 0 || hEntity >= psSHP->nRecords )
     return(MS_FAILURE);
 
+  if( psSHP->pabySHXMap )
+    return msSHXMapEntry( psSHP, hEntity, 1 );
+
   if( ! (psSHP->panRecAllLoaded || msGetBit(psSHP->panRecLoaded, shxBufferPage)) ) {
     msSHXLoadPage( psSHP, shxBufferPage );
   }
@@ -1189,40 +1341,16 @@ int msSHXReadSize( SHPHandle psSHP, int hEntity )
 }
 
 /*
-** msSHPReadShape() - Reads the vertices for one shape from a shape file.
+** msSHPDecodeShape() - Decodes the vertices of one shape record, pabyRec
+** points at its nEntitySize bytes (record header included).
 */
-void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape )
+static void msSHPDecodeShape( SHPHandle psSHP, int hEntity, uchar *pabyRec, int nEntitySize, shapeObj *shape )
 {
   int i, j, k;
 #ifdef USE_POINT_Z_M
   int nOffset = 0;
 #endif
-  int nEntitySize, nRequiredSize;
-
-  msInitShape(shape); /* initialize the shape */
-
-  /* -------------------------------------------------------------------- */
-  /*      Validate the record/entity number.                              */
-  /* -------------------------------------------------------------------- */
-  if( hEntity < 0 || hEntity >= psSHP->nRecords )
-    return;
-
-  if( msSHXReadSize(psSHP, hEntity) == 4 ) {
-    shape->type = MS_SHAPE_NULL;
-    return;
-  }
-
-  nEntitySize = msSHXReadSize(psSHP, hEntity) + 8;
-  if (msSHPReadAllocateBuffer(psSHP, hEntity, "msSHPReadShape()") == MS_FAILURE) {
-    shape->type = MS_SHAPE_NULL;
-    return;
-  }
-
-  /* -------------------------------------------------------------------- */
-  /*      Read the record.                                                */
-  /* -------------------------------------------------------------------- */
-  fseek( psSHP->fpSHP, msSHXReadOffset(psSHP, hEntity), 0 );
-  fread( psSHP->pabyRec, nEntitySize, 1, psSHP->fpSHP );
+  int nRequiredSize;
 
   /* -------------------------------------------------------------------- */
   /*  Extract vertices for a Polygon or Arc.            */
@@ -1240,10 +1368,10 @@ void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape )
     }
 
     /* copy the bounding box */
-    memcpy( &shape->bounds.minx, psSHP->pabyRec + 8 + 4, 8 );
-    memcpy( &shape->bounds.miny, psSHP->pabyRec + 8 + 12, 8 );
-    memcpy( &shape->bounds.maxx, psSHP->pabyRec + 8 + 20, 8 );
-    memcpy( &shape->bounds.maxy, psSHP->pabyRec + 8 + 28, 8 );
+    memcpy( &shape->bounds.minx, pabyRec + 8 + 4, 8 );
+    memcpy( &shape->bounds.miny, pabyRec + 8 + 12, 8 );
+    memcpy( &shape->bounds.maxx, pabyRec + 8 + 20, 8 );
+    memcpy( &shape->bounds.maxy, pabyRec + 8 + 28, 8 );
 
     if( bBigEndian ) {
       SwapWord( 8, &shape->bounds.minx);
@@ -1252,8 +1380,8 @@ void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape )
       SwapWord( 8, &shape->bounds.maxy);
     }
 
-    memcpy( &nPoints, psSHP->pabyRec + 40 + 8, 4 );
-    memcpy( &nParts, psSHP->pabyRec + 36 + 8, 4 );
+    memcpy( &nPoints, pabyRec + 40 + 8, 4 );
+    memcpy( &nParts, pabyRec + 36 + 8, 4 );
 
     if( bBigEndian ) {
       nPoints = SWAP_FOUR_BYTES(nPoints);
@@ -1300,7 +1428,7 @@ void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape )
       return;
     }
 
-    memcpy( psSHP->panParts, psSHP->pabyRec + 44 + 8, 4 * nParts );
+    memcpy( psSHP->panParts, pabyRec + 44 + 8, 4 * nParts );
     if( bBigEndian ) {
       for( i = 0; i < nParts; i++ ) {
         *(psSHP->panParts+i) = SWAP_FOUR_BYTES(*(psSHP->panParts+i));
@@ -1345,8 +1473,8 @@ void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape )
 
       /* nOffset = 44 + 8 + 4*nParts; */
       for( j = 0; j < shape->line[i].numpoints; j++ ) {
-        memcpy(&(shape->line[i].point[j].x), psSHP->pabyRec + 44 + 4*nParts + 8 + k * 16, 8 );
-        memcpy(&(shape->line[i].point[j].y), psSHP->pabyRec + 44 + 4*nParts + 8 + k * 16 + 8, 8 );
+        memcpy(&(shape->line[i].point[j].x), pabyRec + 44 + 4*nParts + 8 + k * 16, 8 );
+        memcpy(&(shape->line[i].point[j].y), pabyRec + 44 + 4*nParts + 8 + k * 16 + 8, 8 );
 
         if( bBigEndian ) {
           SwapWord( 8, &(shape->line[i].point[j].x) );
@@ -1361,7 +1489,7 @@ void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape )
         if (psSHP->nShapeType == SHP_POLYGONZ || psSHP->nShapeType == SHP_ARCZ) {
           nOffset = 44 + 8 + (4*nParts) + (16*nPoints) ;
           if( nEntitySize >= nOffset + 16 + 8*nPoints ) {
-            memcpy(&(shape->line[i].point[j].z), psSHP->pabyRec + nOffset + 16 + k*8, 8 );
+            memcpy(&(shape->line[i].point[j].z), pabyRec + nOffset + 16 + k*8, 8 );
             if( bBigEndian ) SwapWord( 8, &(shape->line[i].point[j].z) );
           }
         }
@@ -1373,7 +1501,7 @@ void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape )
         if (psSHP->nShapeType == SHP_POLYGONM || psSHP->nShapeType == SHP_ARCM) {
           nOffset = 44 + 8 + (4*nParts) + (16*nPoints) ;
           if( nEntitySize >= nOffset + 16 + 8*nPoints ) {
-            memcpy(&(shape->line[i].point[j].m), psSHP->pabyRec + nOffset + 16 + k*8, 8 );
+            memcpy(&(shape->line[i].point[j].m), pabyRec + nOffset + 16 + k*8, 8 );
             if( bBigEndian ) SwapWord( 8, &(shape->line[i].point[j].m) );
           }
         }
@@ -1406,10 +1534,10 @@ void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape )
     }
 
     /* copy the bounding box */
-    memcpy( &shape->bounds.minx, psSHP->pabyRec + 8 + 4, 8 );
-    memcpy( &shape->bounds.miny, psSHP->pabyRec + 8 + 12, 8 );
-    memcpy( &shape->bounds.maxx, psSHP->pabyRec + 8 + 20, 8 );
-    memcpy( &shape->bounds.maxy, psSHP->pabyRec + 8 + 28, 8 );
+    memcpy( &shape->bounds.minx, pabyRec + 8 + 4, 8 );
+    memcpy( &shape->bounds.miny, pabyRec + 8 + 12, 8 );
+    memcpy( &shape->bounds.maxx, pabyRec + 8 + 20, 8 );
+    memcpy( &shape->bounds.maxy, pabyRec + 8 + 28, 8 );
 
     if( bBigEndian ) {
       SwapWord( 8, &shape->bounds.minx);
@@ -1418,7 +1546,7 @@ void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape )
       SwapWord( 8, &shape->bounds.maxy);
     }
 
-    memcpy( &nPoints, psSHP->pabyRec + 44, 4 );
+    memcpy( &nPoints, pabyRec + 44, 4 );
     if( bBigEndian ) nPoints = SWAP_FOUR_BYTES(nPoints);
 
     /* -------------------------------------------------------------------- */
@@ -1461,8 +1589,8 @@ void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape )
     }
 
     for( i = 0; i < nPoints; i++ ) {
-      memcpy(&(shape->line[0].point[i].x), psSHP->pabyRec + 48 + 16 * i, 8 );
-      memcpy(&(shape->line[0].point[i].y), psSHP->pabyRec + 48 + 16 * i + 8, 8 );
+      memcpy(&(shape->line[0].point[i].x), pabyRec + 48 + 16 * i, 8 );
+      memcpy(&(shape->line[0].point[i].y), pabyRec + 48 + 16 * i + 8, 8 );
 
       if( bBigEndian ) {
         SwapWord( 8, &(shape->line[0].point[i].x) );
@@ -1476,7 +1604,7 @@ void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape )
       shape->line[0].point[i].z = 0; /* initialize */
       if (psSHP->nShapeType == SHP_MULTIPOINTZ) {
         nOffset = 48 + 16*nPoints;
-        memcpy(&(shape->line[0].point[i].z), psSHP->pabyRec + nOffset + 16 + i*8, 8 );
+        memcpy(&(shape->line[0].point[i].z), pabyRec + nOffset + 16 + i*8, 8 );
         if( bBigEndian ) SwapWord( 8, &(shape->line[0].point[i].z));
       }
 
@@ -1486,7 +1614,7 @@ void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape )
       shape->line[0].point[i].m = 0; /* initialize */
       if (psSHP->nShapeType == SHP_MULTIPOINTM) {
         nOffset = 48 + 16*nPoints;
-        memcpy(&(shape->line[0].point[i].m), psSHP->pabyRec + nOffset + 16 + i*8, 8 );
+        memcpy(&(shape->line[0].point[i].m), pabyRec + nOffset + 16 + i*8, 8 );
         if( bBigEndian ) SwapWord( 8, &(shape->line[0].point[i].m));
       }
 #endif /* USE_POINT_Z_M */
@@ -1518,8 +1646,8 @@ void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape )
     shape->line[0].numpoints = 1;
     shape->line[0].point = (pointObj *) msSmallMalloc(sizeof(pointObj));
 
-    memcpy( &(shape->line[0].point[0].x), psSHP->pabyRec + 12, 8 );
-    memcpy( &(shape->line[0].point[0].y), psSHP->pabyRec + 20, 8 );
+    memcpy( &(shape->line[0].point[0].x), pabyRec + 12, 8 );
+    memcpy( &(shape->line[0].point[0].y), pabyRec + 20, 8 );
 
     if( bBigEndian ) {
       SwapWord( 8, &(shape->line[0].point[0].x));
@@ -1534,7 +1662,7 @@ void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape )
     if (psSHP->nShapeType == SHP_POINTZ) {
       nOffset = 20 + 8;
       if( nEntitySize >= nOffset + 8 ) {
-        memcpy(&(shape->line[0].point[0].z), psSHP->pabyRec + nOffset, 8 );
+        memcpy(&(shape->line[0].point[0].z), pabyRec + nOffset, 8 );
         if( bBigEndian ) SwapWord( 8, &(shape->line[0].point[0].z));
       }
     }
@@ -1546,7 +1674,7 @@ void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape )
     if (psSHP->nShapeType == SHP_POINTM) {
       nOffset = 20 + 8;
       if( nEntitySize >= nOffset + 8 ) {
-        memcpy(&(shape->line[0].point[0].m), psSHP->pabyRec + nOffset, 8 );
+        memcpy(&(shape->line[0].point[0].m), pabyRec + nOffset, 8 );
         if( bBigEndian ) SwapWord( 8, &(shape->line[0].point[0].m));
       }
     }
@@ -1564,6 +1692,125 @@ void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape )
   return;
 }
 
+/*
+** msSHPReadShape() - Reads the vertices for one shape from a shape file.
+*/
+void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape )
+{
+  int nEntitySize;
+  uchar *pabyRec;
+
+  msInitShape(shape); /* initialize the shape */
+
+  /* -------------------------------------------------------------------- */
+  /*      Validate the record/entity number.                              */
+  /* -------------------------------------------------------------------- */
+  if( hEntity < 0 || hEntity >= psSHP->nRecords )
+    return;
+
+  if( msSHXReadSize(psSHP, hEntity) == 4 ) {
+    shape->type = MS_SHAPE_NULL;
+    return;
+  }
+
+  nEntitySize = msSHXReadSize(psSHP, hEntity) + 8;
+
+  /* -------------------------------------------------------------------- */
+  /*      Read the record, or point into the mapped file.                 */
+  /* -------------------------------------------------------------------- */
+  if( psSHP->pabySHPMap ) {
+    pabyRec = msSHPMapRecord( psSHP, msSHXReadOffset(psSHP, hEntity), nEntitySize );
+    if( pabyRec == NULL ) {
+      shape->type = MS_SHAPE_NULL;
+      msSetError(MS_SHPERR, "Corrupted feature encountered.  hEntity = %d, nEntitySize=%d", "msSHPReadShape()",
+                 hEntity, nEntitySize);
+      return;
+    }
+  } else {
+    if (msSHPReadAllocateBuffer(psSHP, hEntity, "msSHPReadShape()") == MS_FAILURE) {
+      shape->type = MS_SHAPE_NULL;
+      return;
+    }
+
+    fseek( psSHP->fpSHP, msSHXReadOffset(psSHP, hEntity), 0 );
+    fread( psSHP->pabyRec, nEntitySize, 1, psSHP->fpSHP );
+    pabyRec = psSHP->pabyRec;
+  }
+
+  msSHPDecodeShape( psSHP, hEntity, pabyRec, nEntitySize, shape );
+}
+
+/*
+** msSHPReadShapes() - Reads the shapes listed in panEntities, in that
+** order, handing each one to pfnShape. Runs of records lying one after
+** another in the .shp (ascending ids after sortshp, with at most
+** SHP_BATCH_READ_GAP bytes between them) are fetched with a single read
+** and decoded from the record buffer. Returns MS_SUCCESS, or whatever
+** stopped the read.
+*/
+int msSHPReadShapes( SHPHandle psSHP, const int *panEntities, int nEntities, SHPReadShapesFunc pfnShape, void *pUserData )
+{
+  int i, j, k, status;
+  int nStart, nEnd, nOffset, nSize, nRead;
+  shapeObj shape;
+
+  for( i = 0; i < nEntities; i = j ) {
+    j = i + 1;
+
+    /* extend the run while the next record follows closely enough */
+    if( psSHP->pabySHPMap == NULL &&
+        panEntities[i] >= 0 && panEntities[i] < psSHP->nRecords ) {
+      nStart = msSHXReadOffset( psSHP, panEntities[i] );
+      nEnd = nStart + msSHXReadSize( psSHP, panEntities[i] ) + 8;
+
+      while( j < nEntities && panEntities[j] >= 0 && panEntities[j] < psSHP->nRecords ) {
+        nOffset = msSHXReadOffset( psSHP, panEntities[j] );
+        nSize = msSHXReadSize( psSHP, panEntities[j] ) + 8;
+        if( nOffset < nEnd || nSize < 12 || nOffset - nEnd > SHP_BATCH_READ_GAP ||
+            nOffset + nSize - nStart > SHP_BATCH_READ_SIZE )
+          break;
+        nEnd = nOffset + nSize;
+        j++;
+      }
+    }
+
+    if( j == i + 1 ) { /* a lone record, nothing to merge */
+      msSHPReadShape( psSHP, panEntities[i], &shape );
+      status = pfnShape( pUserData, panEntities[i], &shape );
+      if( status != MS_SUCCESS )
+        return status;
+      continue;
+    }
+
+    if( nEnd - nStart > psSHP->nBufSize ) {
+      psSHP->pabyRec = (uchar *) msSmallRealloc( psSHP->pabyRec, nEnd - nStart );
+      psSHP->nBufSize = nEnd - nStart;
+    }
+
+    fseek( psSHP->fpSHP, nStart, 0 );
+    nRead = (int) fread( psSHP->pabyRec, 1, nEnd - nStart, psSHP->fpSHP );
+
+    for( k = i; k < j; k++ ) {
+      msInitShape( &shape );
+      nOffset = msSHXReadOffset( psSHP, panEntities[k] ) - nStart;
+      nSize = msSHXReadSize( psSHP, panEntities[k] ) + 8;
+
+      if( nOffset + nSize > nRead ) {
+        msSetError(MS_SHPERR, "Corrupted feature encountered.  hEntity = %d, nEntitySize=%d", "msSHPReadShapes()",
+                   panEntities[k], nSize);
+      } else if( nSize > 12 ) { /* else a NULL shape */
+        msSHPDecodeShape( psSHP, panEntities[k], psSHP->pabyRec + nOffset, nSize, &shape );
+      }
+
+      status = pfnShape( pUserData, panEntities[k], &shape );
+      if( status != MS_SUCCESS )
+        return status;
+    }
+  }
+
+  return MS_SUCCESS;
+}
+
 int msSHPReadBounds( SHPHandle psSHP, int hEntity, rectObj *padBounds)
 {
   /* -------------------------------------------------------------------- */
@@ -1590,8 +1837,17 @@ int msSHPReadBounds( SHPHandle psSHP, int hEntity, rectObj *padBounds)
     }
 
     if( psSHP->nShapeType != SHP_POINT && psSHP->nShapeType != SHP_POINTZ && psSHP->nShapeType != SHP_POINTM) {
-      fseek( psSHP->fpSHP, msSHXReadOffset(psSHP, hEntity) + 12, 0 );
-      fread( padBounds, sizeof(double)*4, 1, psSHP->fpSHP );
+      if( psSHP->pabySHPMap ) {
+        uchar *pabyRec = msSHPMapRecord( psSHP, msSHXReadOffset(psSHP, hEntity) + 12, sizeof(double)*4 );
+        if( pabyRec == NULL ) {
+          padBounds->minx = padBounds->miny = padBounds->maxx = padBounds->maxy = 0.0;
+          return MS_FAILURE;
+        }
+        memcpy( padBounds, pabyRec, sizeof(double)*4 );
+      } else {
+        fseek( psSHP->fpSHP, msSHXReadOffset(psSHP, hEntity) + 12, 0 );
+        fread( padBounds, sizeof(double)*4, 1, psSHP->fpSHP );
+      }
 
       if( bBigEndian ) {
         SwapWord( 8, &(padBounds->minx) );
@@ -1610,8 +1866,17 @@ int msSHPReadBounds( SHPHandle psSHP, int hEntity, rectObj *padBounds)
       /*      minimum and maximum bound.                                      */
       /* -------------------------------------------------------------------- */
 
-      fseek( psSHP->fpSHP, msSHXReadOffset(psSHP, hEntity) + 12, 0 );
-      fread( padBounds, sizeof(double)*2, 1, psSHP->fpSHP );
+      if( psSHP->pabySHPMap ) {
+        uchar *pabyRec = msSHPMapRecord( psSHP, msSHXReadOffset(psSHP, hEntity) + 12, sizeof(double)*2 );
+        if( pabyRec == NULL ) {
+          padBounds->minx = padBounds->miny = padBounds->maxx = padBounds->maxy = 0.0;
+          return MS_FAILURE;
+        }
+        memcpy( padBounds, pabyRec, sizeof(double)*2 );
+      } else {
+        fseek( psSHP->fpSHP, msSHXReadOffset(psSHP, hEntity) + 12, 0 );
+        fread( padBounds, sizeof(double)*2, 1, psSHP->fpSHP );
+      }
 
       if( bBigEndian ) {
         SwapWord( 8, &(padBounds->minx) );
@@ -1626,6 +1891,107 @@ int msSHPReadBounds( SHPHandle psSHP, int hEntity, rectObj *padBounds)
   return MS_SUCCESS;
 }
 
+/*
+** msSHPReadBoundsRange() - Same as msSHPReadBounds() for the nCount records
+** from hStart on, setting pabyValid[i] to whether padBounds[i] could be
+** read. The bounds of records close to each other are fetched with one
+** read, like msSHPReadShapes() does, so scanning a file of small shapes
+** does not cost a seek and a read per record.
+*/
+int msSHPReadBoundsRange( SHPHandle psSHP, int hStart, int nCount, rectObj *padBounds, uchar *pabyValid )
+{
+  int i, j, k, nStart = 0, nEnd = 0, nOffset, nRead, nBoundsSize;
+  rectObj *psBounds;
+
+  if( hStart < 0 || nCount < 0 || hStart + nCount > psSHP->nRecords )
+    return MS_FAILURE;
+
+  if( psSHP->nShapeType == SHP_POINT || psSHP->nShapeType == SHP_POINTZ || psSHP->nShapeType == SHP_POINTM )
+    nBoundsSize = sizeof(double)*2;
+  else
+    nBoundsSize = sizeof(double)*4;
+
+  for( i = 0; i < nCount; i = j ) {
+    j = i + 1;
+
+    /* extend the run while the next record follows closely enough */
+    if( psSHP->pabySHPMap == NULL && msSHXReadSize(psSHP, hStart+i) != 4 ) {
+      nStart = msSHXReadOffset( psSHP, hStart+i ) + 12;
+      nEnd = nStart + nBoundsSize;
+
+      while( j < nCount && msSHXReadSize(psSHP, hStart+j) != 4 ) {
+        nOffset = msSHXReadOffset( psSHP, hStart+j ) + 12;
+        if( nOffset < nEnd || nOffset - nEnd > SHP_BATCH_READ_GAP ||
+            nOffset + nBoundsSize - nStart > SHP_BATCH_READ_SIZE )
+          break;
+        nEnd = nOffset + nBoundsSize;
+        j++;
+      }
+    }
+
+    if( j == i + 1 ) { /* a lone record, nothing to merge */
+      pabyValid[i] = (msSHPReadBounds( psSHP, hStart+i, padBounds+i ) == MS_SUCCESS);
+      continue;
+    }
+
+    if( nEnd - nStart > psSHP->nBufSize ) {
+      psSHP->pabyRec = (uchar *) msSmallRealloc( psSHP->pabyRec, nEnd - nStart );
+      psSHP->nBufSize = nEnd - nStart;
+    }
+
+    fseek( psSHP->fpSHP, nStart, 0 );
+    nRead = (int) fread( psSHP->pabyRec, 1, nEnd - nStart, psSHP->fpSHP );
+
+    for( k = i; k < j; k++ ) {
+      psBounds = padBounds + k;
+      nOffset = msSHXReadOffset( psSHP, hStart+k ) + 12 - nStart;
+      pabyValid[k] = MS_FALSE;
+      psBounds->minx = psBounds->miny = psBounds->maxx = psBounds->maxy = 0.0;
+
+      if( nOffset + nBoundsSize > nRead )
+        continue;
+
+      memcpy( psBounds, psSHP->pabyRec + nOffset, nBoundsSize );
+      if( bBigEndian ) {
+        SwapWord( 8, &(psBounds->minx) );
+        SwapWord( 8, &(psBounds->miny) );
+        if( nBoundsSize > (int) sizeof(double)*2 ) {
+          SwapWord( 8, &(psBounds->maxx) );
+          SwapWord( 8, &(psBounds->maxy) );
+        }
+      }
+
+      if( nBoundsSize == (int) sizeof(double)*2 ) {
+        psBounds->maxx = psBounds->minx;
+        psBounds->maxy = psBounds->miny;
+      } else if( msIsNan(psBounds->minx) ) { /* empty shape */
+        psBounds->minx = psBounds->miny = psBounds->maxx = psBounds->maxy = 0.0;
+        continue;
+      }
+
+      pabyValid[k] = MS_TRUE;
+    }
+  }
+
+  return MS_SUCCESS;
+}
+
+/* search and read state of a newly opened shapefile */
+static void msShapefileInitState(shapefileObj *shpfile)
+{
+  shpfile->status = NULL;
+  shpfile->statusids = NULL;
+  shpfile->numstatusids = 0;
+  shpfile->batch = NULL;
+  shpfile->batchids = NULL;
+  shpfile->numbatch = shpfile->batchpos = 0;
+  msDBFInitValues(&shpfile->nextvalues);
+  msDBFInitValues(&shpfile->getvalues);
+  shpfile->lastshape = -1;
+  shpfile->overview = 0;
+  shpfile->pooled = MS_FALSE;
+}
+
 int msShapefileOpen(shapefileObj *shpfile, char *mode, char *filename, int log_failures)
 {
   int i;
@@ -1639,8 +2005,7 @@ int msShapefileOpen(shapefileObj *shpfile, char *mode, char *filename, int log_f
   }
 
   /* initialize a few things */
-  shpfile->status = NULL;
-  shpfile->lastshape = -1;
+  msShapefileInitState(shpfile);
   shpfile->isopen = MS_FALSE;
 
   /* open the shapefile file (appending ok) and get basic info */
@@ -1715,87 +2080,462 @@ int msShapefileCreate(shapefileObj *shpfile, char *filename, int type)
   msSHPReadBounds( shpfile->hSHP, -1, &(shpfile->bounds));
 
   /* initialize a few other things */
-  shpfile->status = NULL;
-  shpfile->lastshape = -1;
+  msShapefileInitState(shpfile);
   shpfile->isopen = MS_TRUE;
 
   shpfile->hDBF = NULL; /* XBase file is NOT created here... */
   return(0);
 }
 
+/*
+** Frees the shapes read ahead by msShapefileNextShape() but not returned yet.
+*/
+static void msShapefileDiscardBatch(shapefileObj *shpfile)
+{
+  for(; shpfile->batchpos < shpfile->numbatch; shpfile->batchpos++)
+    msFreeShape(&shpfile->batch[shpfile->batchpos]);
+  shpfile->numbatch = shpfile->batchpos = 0;
+}
+
+static void msShapefileFreeState(shapefileObj *shpfile)
+{
+  if(shpfile->status) free(shpfile->status);
+  msFree(shpfile->statusids);
+  shpfile->status = NULL;
+  shpfile->statusids = NULL;
+  shpfile->numstatusids = 0;
+  msShapefileDiscardBatch(shpfile);
+  msFree(shpfile->batch);
+  msFree(shpfile->batchids);
+  shpfile->batch = NULL;
+  shpfile->batchids = NULL;
+  msDBFFreeValues(&shpfile->nextvalues);
+  msDBFFreeValues(&shpfile->getvalues);
+}
+
 void msShapefileClose(shapefileObj *shpfile)
 {
   if (shpfile && shpfile->isopen == MS_TRUE) { /* Silently return if called with NULL shpfile by freeLayer() */
     if(shpfile->hSHP) msSHPClose(shpfile->hSHP);
     if(shpfile->hDBF) msDBFClose(shpfile->hDBF);
-    if(shpfile->status) free(shpfile->status);
+    msShapefileFreeState(shpfile);
     shpfile->isopen = MS_FALSE;
   }
 }
 
-/* status array lives in the shpfile, can return MS_SUCCESS/MS_FAILURE/MS_DONE */
-int msShapefileWhichShapes(shapefileObj *shpfile, rectObj rect, int debug)
+/* -------------------------------------------------------------------- */
+/*      Shapefile pool.                                                 */
+/*                                                                      */
+/*      Tiled layers open and close a shapefile per tile on every       */
+/*      request, each open costing three open() calls and a read of     */
+/*      the headers. When the MS_SHAPEFILE_POOL_SIZE environment        */
+/*      variable is set, shapefiles opened through                      */
+/*      msShapefilePoolOpen() keep their SHP/DBF handles open once      */
+/*      closed and the next open of the same path takes them back, as   */
+/*      long as the .shp mtime and size did not change. At most that    */
+/*      many idle shapefiles are kept, three file descriptors each,     */
+/*      least recently used first out. Handles in use are not shared.  */
+/*      The same setting enables the tile index cache, see              */
+/*      msTiledSHPWhichTiles().                                         */
+/* -------------------------------------------------------------------- */
+
+typedef struct shapefilePoolEntryObj {
+  char *filename; /* as passed to msShapefilePoolOpen() */
+  time_t mtime;
+  long filesize;
+  SHPHandle hSHP;
+  DBFHandle hDBF;
+  struct shapefilePoolEntryObj *prev, *next; /* most recently used first */
+} shapefilePoolEntryObj;
+
+static shapefilePoolEntryObj *shapefilePoolHead = NULL, *shapefilePoolTail = NULL;
+static int shapefilePoolCount = 0;
+static int shapefilePoolMaxCount = 0;
+static int shapefilePoolConfigured = MS_FALSE;
+
+static void shapefilePoolUnlink(shapefilePoolEntryObj *entry)
 {
-  int i;
-  rectObj shaperect;
-  char *filename;
-  char *sourcename = 0; /* shape file source string from map file */
-  char *s = 0; /* pointer to start of '.shp' in source string */
+  if(entry->prev) entry->prev->next = entry->next;
+  else shapefilePoolHead = entry->next;
+  if(entry->next) entry->next->prev = entry->prev;
+  else shapefilePoolTail = entry->prev;
+  entry->prev = entry->next = NULL;
 
-  if(shpfile->status) {
-    free(shpfile->status);
-    shpfile->status = NULL;
-  }
+  shapefilePoolCount--;
+}
 
-  shpfile->statusbounds = rect; /* save the search extent */
+static void shapefilePoolFreeEntry(shapefilePoolEntryObj *entry)
+{
+  if(entry->hSHP) msSHPClose(entry->hSHP);
+  if(entry->hDBF) msDBFClose(entry->hDBF);
+  msFree(entry->filename);
+  msFree(entry);
+}
 
-  /* rect and shapefile DON'T overlap... */
-  if(msRectOverlap(&shpfile->bounds, &rect) != MS_TRUE)
-    return(MS_DONE);
+/* caller holds TLOCK_SHPPOOL, returns the evicted entries for the caller to free */
+static shapefilePoolEntryObj *shapefilePoolTrim(int maxcount)
+{
+  shapefilePoolEntryObj *entry, *evicted = NULL;
 
-  if(msRectContained(&shpfile->bounds, &rect) == MS_TRUE) {
-    shpfile->status = msAllocBitArray(shpfile->numshapes);
-    if(!shpfile->status) {
-      msSetError(MS_MEMERR, NULL, "msShapefileWhichShapes()");
-      return(MS_FAILURE);
-    }
-    msSetAllBits(shpfile->status, shpfile->numshapes, 1);
-  } else {
+  while(shapefilePoolTail && shapefilePoolCount > maxcount) {
+    entry = shapefilePoolTail;
+    shapefilePoolUnlink(entry);
+    entry->next = evicted;
+    evicted = entry;
+  }
 
-    /* deal with case where sourcename is of the form 'file.shp' */
-    sourcename = msStrdup(shpfile->source);
-    s = strstr(sourcename, ".shp");
-    if( s )
-      *s = '\0';
-    else {
-      s = strstr(sourcename, ".SHP");
-      if( s )
-        *s = '\0';
-    }
+  return evicted;
+}
 
-    filename = (char *)malloc(strlen(sourcename)+strlen(MS_INDEX_EXTENSION)+1);
-    MS_CHECK_ALLOC(filename, strlen(sourcename)+strlen(MS_INDEX_EXTENSION)+1, MS_FAILURE);
+static void shapefilePoolFreeList(shapefilePoolEntryObj *entry)
+{
+  shapefilePoolEntryObj *next;
 
-    sprintf(filename, "%s%s", sourcename, MS_INDEX_EXTENSION);
+  for(; entry; entry=next) {
+    next = entry->next;
+    shapefilePoolFreeEntry(entry);
+  }
+}
 
-    shpfile->status = msSearchDiskTree(filename, rect, debug);
-    free(filename);
-    free(sourcename);
+static int shapefilePoolGetMaxCount(void)
+{
+  int maxcount;
 
-    if(shpfile->status) { /* index  */
-      msFilterTreeSearch(shpfile, shpfile->status, rect);
-    } else { /* no index  */
-      shpfile->status = msAllocBitArray(shpfile->numshapes);
-      if(!shpfile->status) {
-        msSetError(MS_MEMERR, NULL, "msShapefileWhichShapes()");
-        return(MS_FAILURE);
-      }
+  msAcquireLock(TLOCK_SHPPOOL);
+  if(!shapefilePoolConfigured) {
+    const char *value = getenv("MS_SHAPEFILE_POOL_SIZE");
+    shapefilePoolMaxCount = value ? MS_MAX(atoi(value), 0) : 0;
+    shapefilePoolConfigured = MS_TRUE;
+  }
+  maxcount = shapefilePoolMaxCount;
+  msReleaseLock(TLOCK_SHPPOOL);
 
+  return maxcount;
+}
+
+/*
+** Set the number of idle shapefiles kept open by the process wide pool,
+** "0" disables the pool and closes everything it holds. For programs
+** embedding MapServer, this overrides MS_SHAPEFILE_POOL_SIZE.
+*/
+void msSetShapefilePoolSize(const char *value)
+{
+  shapefilePoolEntryObj *evicted;
+
+  msAcquireLock(TLOCK_SHPPOOL);
+  shapefilePoolMaxCount = value ? MS_MAX(atoi(value), 0) : 0;
+  shapefilePoolConfigured = MS_TRUE;
+  evicted = shapefilePoolTrim(shapefilePoolMaxCount);
+  msReleaseLock(TLOCK_SHPPOOL);
+
+  shapefilePoolFreeList(evicted);
+}
+
+static void msTileIndexCacheCleanup(void);
+
+void msShapefilePoolCleanup(void)
+{
+  shapefilePoolEntryObj *evicted;
+
+  msAcquireLock(TLOCK_SHPPOOL);
+  evicted = shapefilePoolTrim(0);
+  msReleaseLock(TLOCK_SHPPOOL);
+
+  shapefilePoolFreeList(evicted);
+  msTileIndexCacheCleanup();
+}
+
+/* locate the .shp the way msSHPOpen() does, without opening it */
+static int shapefilePoolStat(const char *filename, struct stat *sb)
+{
+  char *path;
+  int i, status = MS_FAILURE;
+
+  path = (char *) msSmallMalloc(strlen(filename) + 5);
+  strcpy(path, filename);
+  for(i = strlen(path)-1; i > 0 && path[i] != '.' && path[i] != '/' && path[i] != '\\'; i--) {}
+  if(path[i] == '.')
+    path[i] = '\0';
+  i = strlen(path);
+
+  strcpy(path+i, ".shp");
+  if(stat(path, sb) == 0)
+    status = MS_SUCCESS;
+  else {
+    strcpy(path+i, ".SHP");
+    if(stat(path, sb) == 0)
+      status = MS_SUCCESS;
+  }
+
+  msFree(path);
+  return status;
+}
+
+/*
+** Same as msShapefileOpen(shpfile, "rb", filename, log_failures), taking
+** the handles from the pool when it holds that file. Close the shapefile
+** with msShapefilePoolClose() to give them back.
+*/
+int msShapefilePoolOpen(shapefileObj *shpfile, char *filename, int log_failures)
+{
+  shapefilePoolEntryObj *entry;
+  struct stat sb;
+
+  if(!filename || shapefilePoolGetMaxCount() == 0)
+    return msShapefileOpen(shpfile, "rb", filename, log_failures);
+
+  if(shapefilePoolStat(filename, &sb) != MS_SUCCESS) {
+    shpfile->isopen = MS_FALSE;
+    if( log_failures )
+      msSetError(MS_IOERR, "(%s)", "msShapefileOpen()", filename);
+    return(-1);
+  }
+
+  msAcquireLock(TLOCK_SHPPOOL);
+  for(entry=shapefilePoolHead; entry; entry=entry->next) {
+    if(strcmp(entry->filename, filename) == 0) {
+      shapefilePoolUnlink(entry);
+      break;
+    }
+  }
+  msReleaseLock(TLOCK_SHPPOOL);
+
+  if(entry && (entry->mtime != sb.st_mtime || entry->filesize != (long) sb.st_size)) {
+    shapefilePoolFreeEntry(entry); /* changed on disk */
+    entry = NULL;
+  }
+
+  if(entry) {
+    msShapefileInitState(shpfile);
+    shpfile->hSHP = entry->hSHP;
+    shpfile->hDBF = entry->hDBF;
+    strlcpy(shpfile->source, filename, sizeof(shpfile->source));
+    msSHPGetInfo(shpfile->hSHP, &shpfile->numshapes, &shpfile->type);
+    msSHPReadBounds(shpfile->hSHP, -1, &(shpfile->bounds));
+    shpfile->isopen = MS_TRUE;
+
+    entry->hSHP = NULL;
+    entry->hDBF = NULL;
+    shapefilePoolFreeEntry(entry);
+  } else if(msShapefileOpen(shpfile, "rb", filename, log_failures) == -1) {
+    return(-1);
+  }
+
+  shpfile->pooled = MS_TRUE;
+  shpfile->mtime = sb.st_mtime;
+  shpfile->filesize = (long) sb.st_size;
+
+  return(0);
+}
+
+/*
+** Close a shapefile, handing its handles to the pool if it was opened by
+** msShapefilePoolOpen() and the pool is enabled.
+*/
+void msShapefilePoolClose(shapefileObj *shpfile)
+{
+  shapefilePoolEntryObj *entry, *evicted;
+
+  if(!shpfile || shpfile->isopen != MS_TRUE)
+    return;
+
+  if(!shpfile->pooled || !shpfile->hSHP || !shpfile->hDBF || shapefilePoolGetMaxCount() == 0) {
+    msShapefileClose(shpfile);
+    return;
+  }
+
+  msShapefileFreeState(shpfile);
+
+  entry = (shapefilePoolEntryObj *) msSmallCalloc(1, sizeof(shapefilePoolEntryObj));
+  entry->filename = msStrdup(shpfile->source);
+  entry->mtime = shpfile->mtime;
+  entry->filesize = shpfile->filesize;
+  entry->hSHP = shpfile->hSHP;
+  entry->hDBF = shpfile->hDBF;
+  shpfile->hSHP = NULL;
+  shpfile->hDBF = NULL;
+  shpfile->isopen = MS_FALSE;
+
+  msAcquireLock(TLOCK_SHPPOOL);
+  entry->next = shapefilePoolHead;
+  if(shapefilePoolHead) shapefilePoolHead->prev = entry;
+  else shapefilePoolTail = entry;
+  shapefilePoolHead = entry;
+  shapefilePoolCount++;
+  evicted = shapefilePoolTrim(shapefilePoolMaxCount);
+  msReleaseLock(TLOCK_SHPPOOL);
+
+  shapefilePoolFreeList(evicted);
+}
+
+/*
+** Switch an open shapefile to memory mapped reads of the .shp, .shx and
+** .dbf. Each file falls back to stdio on its own if it cannot be mapped,
+** MS_FAILURE is returned if any of them could not.
+*/
+int msShapefileMap(shapefileObj *shpfile)
+{
+  int status = MS_SUCCESS;
+
+  if(!shpfile || shpfile->isopen != MS_TRUE) return MS_FAILURE;
+
+  if(shpfile->hSHP && msSHPMapFiles(shpfile->hSHP) != MS_SUCCESS)
+    status = MS_FAILURE;
+  if(shpfile->hDBF && msDBFMapFile(shpfile->hDBF) != MS_SUCCESS)
+    status = MS_FAILURE;
+
+  return status;
+}
+
+/*
+** Same as msFilterTreeSearch(), for a sparse id list.
+*/
+static void msFilterTreeSearchIds(shapefileObj *shp, shapeIdSetObj *set, rectObj search_rect)
+{
+  int i, n;
+  rectObj shape_rect;
+
+  for(i=0, n=0; i<set->numids; i++) {
+    if(msSHPReadBounds(shp->hSHP, set->ids[i], &shape_rect) == MS_SUCCESS &&
+        msRectOverlap(&shape_rect, &search_rect) != MS_TRUE)
+      continue;
+    set->ids[n++] = set->ids[i];
+  }
+  set->numids = n;
+}
+
+/* source without the .shp extension, index files are named after it */
+static char *msShapefileBasename(shapefileObj *shpfile)
+{
+  char *sourcename, *s;
+
+  /* deal with case where sourcename is of the form 'file.shp' */
+  sourcename = msStrdup(shpfile->source);
+  s = strstr(sourcename, ".shp");
+  if( s )
+    *s = '\0';
+  else {
+    s = strstr(sourcename, ".SHP");
+    if( s )
+      *s = '\0';
+  }
+
+  return sourcename;
+}
+
+/* hands the search result over to the shapefile, in whichever form it is in */
+static void msShapefileSetStatus(shapefileObj *shpfile, shapeIdSetObj *set, int debug)
+{
+  msFree(shpfile->status);
+  msFree(shpfile->statusids);
+  shpfile->status = NULL;
+  shpfile->statusids = NULL;
+  shpfile->numstatusids = 0;
+
+  if(set->bits) {
+    shpfile->status = set->bits;
+  } else {
+    msSortShapeIdSet(set);
+    shpfile->statusids = set->ids;
+    shpfile->numstatusids = set->numids;
+    if(debug >= MS_DEBUGLEVEL_VVV)
+      msDebug("msShapefileWhichShapes(): %d of %d shapes selected, using a sparse id list.\n", set->numids, shpfile->numshapes);
+  }
+  set->bits = NULL;
+  set->ids = NULL;
+}
+
+/*
+** Status lives in the shpfile, can return MS_SUCCESS/MS_FAILURE/MS_DONE.
+** Searches finding few shapes keep them as a sorted id list (statusids)
+** instead of a bit array over the whole file, use
+** msShapefileNextShapeIndex() to walk either form.
+*/
+/*
+** Same as msShapefileWhichShapes(), searching the given in-memory tree
+** instead of the index files when there is one.
+*/
+static int msShapefileWhichShapesTree(shapefileObj *shpfile, packedRTreeObj *tree, rectObj rect, int debug)
+{
+  int i, found = MS_FALSE;
+  rectObj shaperect;
+  char *filename;
+  char *sourcename = 0; /* shape file source string from map file */
+  packedRTreeObj *rtree;
+  shapeIdSetObj set;
+
+  if(shpfile->status) {
+    free(shpfile->status);
+    shpfile->status = NULL;
+  }
+  msFree(shpfile->statusids);
+  shpfile->statusids = NULL;
+  shpfile->numstatusids = 0;
+  msShapefileDiscardBatch(shpfile);
+
+  shpfile->statusbounds = rect; /* save the search extent */
+
+  /* rect and shapefile DON'T overlap... */
+  if(msRectOverlap(&shpfile->bounds, &rect) != MS_TRUE)
+    return(MS_DONE);
+
+  if(msRectContained(&shpfile->bounds, &rect) == MS_TRUE) {
+    shpfile->status = msAllocBitArray(shpfile->numshapes);
+    if(!shpfile->status) {
+      msSetError(MS_MEMERR, NULL, "msShapefileWhichShapes()");
+      return(MS_FAILURE);
+    }
+    msSetAllBits(shpfile->status, shpfile->numshapes, 1);
+  } else {
+
+    if(tree) {
+      msSearchPackedRTreeIds(tree, rect, &set);
+      msShapefileSetStatus(shpfile, &set, debug);
+      shpfile->lastshape = -1;
+      return(MS_SUCCESS);
+    }
+
+    sourcename = msShapefileBasename(shpfile);
+
+    filename = (char *)malloc(strlen(sourcename)+strlen(MS_INDEX_EXTENSION)+strlen(MS_RTREE_INDEX_EXTENSION)+1);
+    MS_CHECK_ALLOC(filename, strlen(sourcename)+strlen(MS_INDEX_EXTENSION)+strlen(MS_RTREE_INDEX_EXTENSION)+1, MS_FAILURE);
+
+    /* prefer a packed R-tree, its leaves hold the exact shape bounds so no filtering is needed */
+    sprintf(filename, "%s%s", sourcename, MS_RTREE_INDEX_EXTENSION);
+    rtree = msPackedRTreeOpen(filename, debug);
+    if(rtree && rtree->numshapes != shpfile->numshapes) {
+      if(debug)
+        msDebug("msShapefileWhichShapes(): %s indexes %d shapes instead of %d, ignoring it.\n", filename, rtree->numshapes, shpfile->numshapes);
+      msPackedRTreeClose(rtree);
+      rtree = NULL;
+    }
+    if(rtree) {
+      msSearchPackedRTreeIds(rtree, rect, &set);
+      msPackedRTreeClose(rtree);
+      found = MS_TRUE;
+    } else {
+      sprintf(filename, "%s%s", sourcename, MS_INDEX_EXTENSION);
+
+      if(msSearchDiskTreeIds(filename, rect, debug, shpfile->numshapes, &set) == MS_SUCCESS) { /* index */
+        if(set.bits)
+          msFilterTreeSearch(shpfile, set.bits, rect);
+        else
+          msFilterTreeSearchIds(shpfile, &set, rect);
+        found = MS_TRUE;
+      }
+    }
+    free(filename);
+    free(sourcename);
+
+    if(!found) { /* no index  */
+      msInitShapeIdSet(&set, shpfile->numshapes);
       for(i=0; i<shpfile->numshapes; i++) {
         if(msSHPReadBounds(shpfile->hSHP, i, &shaperect) == MS_SUCCESS)
-          if(msRectOverlap(&shaperect, &rect) == MS_TRUE) msSetBit(shpfile->status, i, 1);
+          if(msRectOverlap(&shaperect, &rect) == MS_TRUE) msAddShapeId(&set, i);
       }
     }
+
+    msShapefileSetStatus(shpfile, &set, debug);
   }
 
   shpfile->lastshape = -1;
@@ -1803,6 +2543,84 @@ int msShapefileWhichShapes(shapefileObj *shpfile, rectObj rect, int debug)
   return(MS_SUCCESS); /* success */
 }
 
+int msShapefileWhichShapes(shapefileObj *shpfile, rectObj rect, int debug)
+{
+  return msShapefileWhichShapesTree(shpfile, NULL, rect, debug);
+}
+
+/*
+** Returns the first shape at or after index selected by the last
+** msShapefileWhichShapes() call, or -1 if there are no more.
+*/
+int msShapefileNextShapeIndex(shapefileObj *shpfile, int index)
+{
+  int lo, hi, mid;
+
+  if(index < 0) index = 0;
+
+  if(shpfile->status)
+    return msGetNextBit(shpfile->status, index, shpfile->numshapes);
+
+  /* first id >= index in the sorted list */
+  lo = 0;
+  hi = shpfile->numstatusids;
+  while(lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if(shpfile->statusids[mid] < index)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return (lo < shpfile->numstatusids) ? shpfile->statusids[lo] : -1;
+}
+
+static int msShapefileBatchShape(void *pUserData, int hEntity, shapeObj *shape)
+{
+  shapefileObj *shpfile = (shapefileObj *) pUserData;
+
+  shpfile->batchids[shpfile->numbatch] = hEntity;
+  shpfile->batch[shpfile->numbatch++] = *shape;
+  return MS_SUCCESS;
+}
+
+/*
+** Reads the next shape selected by msShapefileWhichShapes(), after
+** lastshape, and returns its index or -1 if there are no more. Shapes are
+** read MS_SHAPEFILE_READAHEAD at a time through msSHPReadShapes() so runs
+** of neighbouring records cost one read. The caller updates lastshape.
+*/
+static int msShapefileNextShape(shapefileObj *shpfile, shapeObj *shape)
+{
+  int i, n;
+
+  /* lastshape moved (msSHPLayerGetShape() sets it too), start over from there */
+  if(shpfile->batchpos < shpfile->numbatch &&
+      (shpfile->batchpos == 0 || shpfile->batchids[shpfile->batchpos-1] != shpfile->lastshape))
+    msShapefileDiscardBatch(shpfile);
+
+  if(shpfile->batchpos == shpfile->numbatch) {
+    if(!shpfile->batch) {
+      shpfile->batch = (shapeObj *) msSmallMalloc(sizeof(shapeObj) * MS_SHAPEFILE_READAHEAD);
+      shpfile->batchids = (int *) msSmallMalloc(sizeof(int) * MS_SHAPEFILE_READAHEAD);
+    }
+    shpfile->numbatch = shpfile->batchpos = 0;
+
+    /* the ids go straight into batchids, the callback writes them back in place */
+    i = shpfile->lastshape;
+    for(n=0; n<MS_SHAPEFILE_READAHEAD; n++) {
+      i = msShapefileNextShapeIndex(shpfile, i + 1);
+      if(i == -1) break;
+      shpfile->batchids[n] = i;
+    }
+    if(n == 0) return -1;
+
+    msSHPReadShapes(shpfile->hSHP, shpfile->batchids, n, msShapefileBatchShape, shpfile);
+  }
+
+  *shape = shpfile->batch[shpfile->batchpos];
+  return shpfile->batchids[shpfile->batchpos++];
+}
+
 /* Return the absolute path to the given layer's tileindex file's directory */
 void msTileIndexAbsoluteDir(char *tiFileAbsDir, layerObj *layer)
 {
@@ -1815,6 +2633,246 @@ void msTileIndexAbsoluteDir(char *tiFileAbsDir, layerObj *layer)
   free(tiFileAbsDirTmp);
 }
 
+/*
+** Use memory mapped reads for a shapefile opened on behalf of a layer if
+** PROCESSING "SHAPEFILE_MMAP=ON" is set, or by default when built with
+** WITH_SHAPEFILE_MMAP (PROCESSING "SHAPEFILE_MMAP=OFF" turns it off).
+*/
+static void msSHPLayerMapShapefile(layerObj *layer, shapefileObj *shpfile)
+{
+  const char *value = msLayerGetProcessingKey(layer, "SHAPEFILE_MMAP");
+#ifdef USE_SHAPEFILE_MMAP
+  int use_mmap = MS_TRUE;
+#else
+  int use_mmap = MS_FALSE;
+#endif
+
+  if(value)
+    use_mmap = (strcasecmp(value, "ON") == 0 || strcasecmp(value, "YES") == 0 || strcasecmp(value, "TRUE") == 0);
+
+  if(!use_mmap)
+    return;
+
+  if(msShapefileMap(shpfile) != MS_SUCCESS && layer->debug >= MS_DEBUGLEVEL_V)
+    msDebug("msSHPLayerMapShapefile(): unable to map all of %s, reading through stdio.\n", shpfile->source);
+}
+
+/*
+** Narrows the shapes selected by msShapefileWhichShapes() down to those an
+** attribute index (see mapattrindex.c) says may pass the layer filter. The
+** filter is still evaluated on every shape read. Returns MS_DONE when no
+** shape is left.
+*/
+static int msSHPLayerSearchAttributeIndex(layerObj *layer, shapefileObj *shpfile)
+{
+  shapeIdSetObj found, set;
+  char *basename;
+  int i, j, status, numselected=0;
+
+  /* shapes are only filtered when the layer has items */
+  if(!layer->filter.string || layer->numitems == 0 || !layer->iteminfo)
+    return MS_SUCCESS;
+
+  basename = msShapefileBasename(shpfile);
+  if(shpfile->overview > 0) { /* overviews share the record numbers, and indexes, of the data */
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), "_ov%d", shpfile->overview);
+    if(strlen(basename) > strlen(suffix))
+      basename[strlen(basename) - strlen(suffix)] = '\0';
+  }
+  status = msSearchAttributeIndex(layer, basename, shpfile->numshapes, &found);
+  free(basename);
+  if(status != MS_SUCCESS)
+    return MS_SUCCESS; /* no usable index */
+
+  /* keep the shapes found by both searches */
+  msSortShapeIdSet(&found);
+  msInitShapeIdSet(&set, shpfile->numshapes);
+  i = found.bits ? msGetNextBit(found.bits, 0, found.numshapes) : (found.numids > 0 ? found.ids[0] : -1);
+  for(j=1; i != -1; j++) {
+    if(shpfile->status ? msGetBit(shpfile->status, i) : (msShapefileNextShapeIndex(shpfile, i) == i)) {
+      msAddShapeId(&set, i);
+      numselected++;
+    }
+    if(found.bits)
+      i = msGetNextBit(found.bits, i+1, found.numshapes);
+    else
+      i = (j < found.numids) ? found.ids[j] : -1;
+  }
+  msFreeShapeIdSet(&found);
+
+  if(layer->debug >= MS_DEBUGLEVEL_VV)
+    msDebug("msSHPLayerSearchAttributeIndex(): %d shapes left after the attribute index search.\n", numselected);
+
+  msShapefileSetStatus(shpfile, &set, layer->debug);
+  shpfile->lastshape = -1;
+
+  return (numselected > 0) ? MS_SUCCESS : MS_DONE;
+}
+
+/*
+** Decode the layer items of a record into values and let the shape point at
+** them, the shape borrows the strings until the next read into values (see
+** msShapeOwnValues()).
+*/
+static int msSHPLayerBorrowValues(layerObj *layer, DBFHandle hDBF, int record, dbfValuesObj *values, shapeObj *shape)
+{
+  msFreeShapeValues(shape);
+
+  if(layer->numitems == 0)
+    return MS_SUCCESS;
+  if(msDBFReadValues(hDBF, record, layer->iteminfo, layer->numitems, values) != MS_SUCCESS)
+    return MS_FAILURE;
+
+  shape->values = values->values;
+  shape->numericvalues = values->numericvalues;
+  shape->numvalues = values->numvalues;
+  shape->valuesborrowed = MS_TRUE;
+
+  return MS_SUCCESS;
+}
+
+/* -------------------------------------------------------------------- */
+/*      Tile index cache.                                               */
+/*                                                                      */
+/*      With the shapefile pool enabled, the bounds of a tile index     */
+/*      opened through it are loaded once into an in-memory packed      */
+/*      R-tree (see maprtree.c) and later searches of that tile index   */
+/*      use it instead of reading the .qix/.prt or scanning the .shx.   */
+/*      Entries are keyed by path, mtime and size like the pool.        */
+/* -------------------------------------------------------------------- */
+
+#define MS_TILEINDEX_CACHE_SIZE 16
+
+typedef struct tileIndexCacheEntryObj {
+  char *filename;
+  time_t mtime;
+  long filesize;
+  packedRTreeObj *tree;
+  struct tileIndexCacheEntryObj *next; /* most recently used first */
+} tileIndexCacheEntryObj;
+
+static tileIndexCacheEntryObj *tileIndexCacheHead = NULL;
+
+static void tileIndexCacheFreeEntry(tileIndexCacheEntryObj *entry)
+{
+  msPackedRTreeClose(entry->tree);
+  msFree(entry->filename);
+  msFree(entry);
+}
+
+static void tileIndexCacheFreeList(tileIndexCacheEntryObj *entry)
+{
+  tileIndexCacheEntryObj *next;
+
+  for(; entry; entry=next) {
+    next = entry->next;
+    tileIndexCacheFreeEntry(entry);
+  }
+}
+
+static void msTileIndexCacheCleanup(void)
+{
+  tileIndexCacheEntryObj *entry;
+
+  msAcquireLock(TLOCK_SHPPOOL);
+  entry = tileIndexCacheHead;
+  tileIndexCacheHead = NULL;
+  msReleaseLock(TLOCK_SHPPOOL);
+
+  tileIndexCacheFreeList(entry);
+}
+
+/*
+** Finds the cached tree of a tile index, moving it to the front. Stale
+** entries for the same path are unlinked and returned through stale. The
+** caller holds TLOCK_SHPPOOL.
+*/
+static tileIndexCacheEntryObj *tileIndexCacheFind(shapefileObj *tileshpfile, tileIndexCacheEntryObj **stale)
+{
+  tileIndexCacheEntryObj *entry, **link;
+
+  for(link=&tileIndexCacheHead; (entry = *link) != NULL; link=&entry->next) {
+    if(strcmp(entry->filename, tileshpfile->source) != 0)
+      continue;
+
+    *link = entry->next;
+    if(entry->mtime != tileshpfile->mtime || entry->filesize != tileshpfile->filesize || entry->tree->numshapes != tileshpfile->numshapes) {
+      entry->next = *stale;
+      *stale = entry;
+      return NULL;
+    }
+
+    entry->next = tileIndexCacheHead;
+    tileIndexCacheHead = entry;
+    return entry;
+  }
+
+  return NULL;
+}
+
+/*
+** Same as msShapefileWhichShapes() for a tile index, searching its cached
+** tree when the tile index came from the shapefile pool.
+*/
+static int msTiledSHPWhichTiles(shapefileObj *tileshpfile, rectObj rect, int debug)
+{
+  tileIndexCacheEntryObj *entry, *stale = NULL, *next;
+  packedRTreeObj *tree;
+  int i, status;
+
+  if(!tileshpfile->pooled || shapefilePoolGetMaxCount() == 0)
+    return msShapefileWhichShapes(tileshpfile, rect, debug);
+
+  msAcquireLock(TLOCK_SHPPOOL);
+  entry = tileIndexCacheFind(tileshpfile, &stale);
+  if(entry) { /* searched under the lock, another thread could evict it */
+    status = msShapefileWhichShapesTree(tileshpfile, entry->tree, rect, debug);
+    msReleaseLock(TLOCK_SHPPOOL);
+    tileIndexCacheFreeList(stale);
+    return status;
+  }
+  msReleaseLock(TLOCK_SHPPOOL);
+
+  /* build the tree outside the lock, a thread racing us just builds its own */
+  tree = msCreatePackedRTree(tileshpfile, 0);
+  if(!tree) {
+    tileIndexCacheFreeList(stale);
+    return msShapefileWhichShapes(tileshpfile, rect, debug);
+  }
+
+  if(debug >= MS_DEBUGLEVEL_VVV)
+    msDebug("msTiledSHPWhichTiles(): caching the bounds of %d tiles from %s.\n", tileshpfile->numshapes, tileshpfile->source);
+
+  entry = (tileIndexCacheEntryObj *) msSmallCalloc(1, sizeof(tileIndexCacheEntryObj));
+  entry->filename = msStrdup(tileshpfile->source);
+  entry->mtime = tileshpfile->mtime;
+  entry->filesize = tileshpfile->filesize;
+  entry->tree = tree;
+
+  msAcquireLock(TLOCK_SHPPOOL);
+  if((next = tileIndexCacheFind(tileshpfile, &stale)) != NULL) { /* drop a copy built meanwhile */
+    tileIndexCacheHead = next->next;
+    next->next = stale;
+    stale = next;
+  }
+  entry->next = tileIndexCacheHead;
+  tileIndexCacheHead = entry;
+  status = msShapefileWhichShapesTree(tileshpfile, tree, rect, debug);
+
+  /* trim, the oldest entries go */
+  for(i=1; entry->next && i<MS_TILEINDEX_CACHE_SIZE; i++)
+    entry = entry->next;
+  next = entry->next;
+  entry->next = NULL;
+  msReleaseLock(TLOCK_SHPPOOL);
+
+  tileIndexCacheFreeList(next);
+  tileIndexCacheFreeList(stale);
+
+  return status;
+}
+
 /*
 ** Build possible paths we might find the tile file at:
 **   map dir + shape path + filename?
@@ -1835,9 +2893,9 @@ int msTiledSHPTryOpen(shapefileObj *shpfile, layerObj *layer, char *tiFileAbsDir
   if( ignore_missing == MS_MISSING_DATA_IGNORE )
     log_failures = MS_FALSE;
 
-  if(msShapefileOpen(shpfile, "rb", msBuildPath3(szPath, layer->map->mappath, layer->map->shapepath, filename), log_failures) == -1) {
-    if(msShapefileOpen(shpfile, "rb", msBuildPath3(szPath, tiFileAbsDir, layer->map->shapepath, filename), log_failures) == -1) {
-      if(msShapefileOpen(shpfile, "rb", msBuildPath(szPath, layer->map->mappath, filename), log_failures) == -1) {
+  if(msShapefilePoolOpen(shpfile, msBuildPath3(szPath, layer->map->mappath, layer->map->shapepath, filename), log_failures) == -1) {
+    if(msShapefilePoolOpen(shpfile, msBuildPath3(szPath, tiFileAbsDir, layer->map->shapepath, filename), log_failures) == -1) {
+      if(msShapefilePoolOpen(shpfile, msBuildPath(szPath, layer->map->mappath, filename), log_failures) == -1) {
         if(ignore_missing == MS_MISSING_DATA_FAIL) {
           msSetError(MS_IOERR, "Unable to open shapefile '%s' for layer '%s' ... fatal error.", "msTiledSHPTryOpen()", filename, layer->name);
           return(MS_FAILURE);
@@ -1856,6 +2914,7 @@ int msTiledSHPTryOpen(shapefileObj *shpfile, layerObj *layer, char *tiFileAbsDir
       }
     }
   }
+  msSHPLayerMapShapefile(layer, shpfile);
   return(MS_SUCCESS);
 }
 
@@ -1884,6 +2943,8 @@ int msTiledSHPOpenFile(layerObj *layer)
   
   tSHP->shpfile->isopen = MS_FALSE; /* in case of error: do not try to close the shpfile */
   tSHP->tileshpfile = NULL; /* may need this if not using a tile layer, look for malloc later */
+  msDBFInitValues(&tSHP->nextvalues);
+  msDBFInitValues(&tSHP->getvalues);
   layer->layerinfo = tSHP;
 
   tSHP->tilelayerindex = msGetLayerIndex(layer->map, layer->tileindex);
@@ -1921,8 +2982,8 @@ int msTiledSHPOpenFile(layerObj *layer)
     }
 
 
-    if(msShapefileOpen(tSHP->tileshpfile, "rb", msBuildPath3(szPath, layer->map->mappath, layer->map->shapepath, layer->tileindex), MS_TRUE) == -1)
-      if(msShapefileOpen(tSHP->tileshpfile, "rb", msBuildPath(szPath, layer->map->mappath, layer->tileindex), MS_TRUE) == -1)
+    if(msShapefilePoolOpen(tSHP->tileshpfile, msBuildPath3(szPath, layer->map->mappath, layer->map->shapepath, layer->tileindex), MS_TRUE) == -1)
+      if(msShapefilePoolOpen(tSHP->tileshpfile, msBuildPath(szPath, layer->map->mappath, layer->tileindex), MS_TRUE) == -1)
         return(MS_FAILURE);
   }
 
@@ -1981,7 +3042,7 @@ int msTiledSHPWhichShapes(layerObj *layer, rectObj rect, int isQuery)
     return(MS_FAILURE);
   }
 
-  msShapefileClose(tSHP->shpfile); /* close previously opened files */
+  msShapefilePoolClose(tSHP->shpfile); /* close previously opened files */
 
   if(tSHP->tilelayerindex != -1) {  /* does the tileindex reference another layer */
     layerObj *tlp;
@@ -2014,12 +3075,13 @@ int msTiledSHPWhichShapes(layerObj *layer, rectObj rect, int isQuery)
         return(MS_FAILURE);
 
       status = msShapefileWhichShapes(tSHP->shpfile, rect, layer->debug);
+      if(status == MS_SUCCESS) status = msSHPLayerSearchAttributeIndex(layer, tSHP->shpfile);
       if(status == MS_DONE) {
         /* Close and continue to next tile */
-        msShapefileClose(tSHP->shpfile);
+        msShapefilePoolClose(tSHP->shpfile);
         continue;
       } else if(status != MS_SUCCESS) {
-        msShapefileClose(tSHP->shpfile);
+        msShapefilePoolClose(tSHP->shpfile);
         return(MS_FAILURE);
       }
 
@@ -2032,45 +3094,44 @@ int msTiledSHPWhichShapes(layerObj *layer, rectObj rect, int isQuery)
   } else { /* or reference a shapefile directly */
     int try_open;
 
-    status = msShapefileWhichShapes(tSHP->tileshpfile, rect, layer->debug);
+    status = msTiledSHPWhichTiles(tSHP->tileshpfile, rect, layer->debug);
     if(status != MS_SUCCESS) return(status); /* could be MS_DONE or MS_FAILURE */
 
     msTileIndexAbsoluteDir(tiFileAbsDir, layer);
 
     /* position the source at the FIRST shapefile */
-    for(i=0; i<tSHP->tileshpfile->numshapes; i++) {
-      if(msGetBit(tSHP->tileshpfile->status,i)) {
-        if(!layer->data) /* assume whole filename is in attribute field */
-          filename = (char *) msDBFReadStringAttribute(tSHP->tileshpfile->hDBF, i, layer->tileitemindex);
-        else {
-          snprintf(tilename, sizeof(tilename), "%s/%s", msDBFReadStringAttribute(tSHP->tileshpfile->hDBF, i, layer->tileitemindex) , layer->data);
-          filename = tilename;
-        }
-
-        if(strlen(filename) == 0) continue; /* check again */
+    for(i=msShapefileNextShapeIndex(tSHP->tileshpfile, 0); i != -1; i=msShapefileNextShapeIndex(tSHP->tileshpfile, i+1)) {
+      if(!layer->data) /* assume whole filename is in attribute field */
+        filename = (char *) msDBFReadStringAttribute(tSHP->tileshpfile->hDBF, i, layer->tileitemindex);
+      else {
+        snprintf(tilename, sizeof(tilename), "%s/%s", msDBFReadStringAttribute(tSHP->tileshpfile->hDBF, i, layer->tileitemindex) , layer->data);
+        filename = tilename;
+      }
 
-        try_open = msTiledSHPTryOpen(tSHP->shpfile, layer, tiFileAbsDir, filename);
-        if( try_open == MS_DONE )
-          continue;
-        else if (try_open == MS_FAILURE )
-          return(MS_FAILURE);
+      if(strlen(filename) == 0) continue; /* check again */
 
-        status = msShapefileWhichShapes(tSHP->shpfile, rect, layer->debug);
-        if(status == MS_DONE) {
-          /* Close and continue to next tile */
-          msShapefileClose(tSHP->shpfile);
-          continue;
-        } else if(status != MS_SUCCESS) {
-          msShapefileClose(tSHP->shpfile);
-          return(MS_FAILURE);
-        }
+      try_open = msTiledSHPTryOpen(tSHP->shpfile, layer, tiFileAbsDir, filename);
+      if( try_open == MS_DONE )
+        continue;
+      else if (try_open == MS_FAILURE )
+        return(MS_FAILURE);
 
-        tSHP->tileshpfile->lastshape = i;
-        break;
+      status = msShapefileWhichShapes(tSHP->shpfile, rect, layer->debug);
+      if(status == MS_SUCCESS) status = msSHPLayerSearchAttributeIndex(layer, tSHP->shpfile);
+      if(status == MS_DONE) {
+        /* Close and continue to next tile */
+        msShapefilePoolClose(tSHP->shpfile);
+        continue;
+      } else if(status != MS_SUCCESS) {
+        msShapefilePoolClose(tSHP->shpfile);
+        return(MS_FAILURE);
       }
+
+      tSHP->tileshpfile->lastshape = i;
+      break;
     }
 
-    if(i == tSHP->tileshpfile->numshapes)
+    if(i == -1)
       return(MS_DONE); /* no more tiles */
     else
       return(MS_SUCCESS);
@@ -2099,11 +3160,10 @@ int msTiledSHPNextShape(layerObj *layer, shapeObj *shape)
   msTileIndexAbsoluteDir(tiFileAbsDir, layer);
 
   do {
-    i = tSHP->shpfile->lastshape + 1;
-    while(i<tSHP->shpfile->numshapes && !msGetBit(tSHP->shpfile->status,i)) i++; /* next "in" shape */
+    i = msShapefileNextShape(tSHP->shpfile, shape); /* next "in" shape */
 
-    if(i == tSHP->shpfile->numshapes) { /* done with this tile, need a new one */
-      msShapefileClose(tSHP->shpfile); /* clean up */
+    if(i == -1) { /* done with this tile, need a new one */
+      msShapefilePoolClose(tSHP->shpfile); /* clean up */
 
       /* position the source to the NEXT shapefile based on the tileindex */
       if(tSHP->tilelayerindex != -1) { /* does the tileindex reference another layer */
@@ -2133,12 +3193,13 @@ int msTiledSHPNextShape(layerObj *layer, shapeObj *shape)
             return(MS_FAILURE);
 
           status = msShapefileWhichShapes(tSHP->shpfile, tSHP->tileshpfile->statusbounds, layer->debug);
+          if(status == MS_SUCCESS) status = msSHPLayerSearchAttributeIndex(layer, tSHP->shpfile);
           if(status == MS_DONE) {
             /* Close and continue to next tile */
-            msShapefileClose(tSHP->shpfile);
+            msShapefilePoolClose(tSHP->shpfile);
             continue;
           } else if(status != MS_SUCCESS) {
-            msShapefileClose(tSHP->shpfile);
+            msShapefilePoolClose(tSHP->shpfile);
             return(MS_FAILURE);
           }
 
@@ -2155,56 +3216,52 @@ int msTiledSHPNextShape(layerObj *layer, shapeObj *shape)
 
       } else { /* or reference a shapefile directly   */
 
-        for(i=(tSHP->tileshpfile->lastshape + 1); i<tSHP->tileshpfile->numshapes; i++) {
-          if(msGetBit(tSHP->tileshpfile->status,i)) {
-            int try_open;
+        for(i=msShapefileNextShapeIndex(tSHP->tileshpfile, tSHP->tileshpfile->lastshape + 1); i != -1; i=msShapefileNextShapeIndex(tSHP->tileshpfile, i+1)) {
+          int try_open;
 
-            if(!layer->data) /* assume whole filename is in attribute field */
-              filename = (char*)msDBFReadStringAttribute(tSHP->tileshpfile->hDBF, i, layer->tileitemindex);
-            else {
-              snprintf(tilename, sizeof(tilename),"%s/%s", msDBFReadStringAttribute(tSHP->tileshpfile->hDBF, i, layer->tileitemindex) , layer->data);
-              filename = tilename;
-            }
+          if(!layer->data) /* assume whole filename is in attribute field */
+            filename = (char*)msDBFReadStringAttribute(tSHP->tileshpfile->hDBF, i, layer->tileitemindex);
+          else {
+            snprintf(tilename, sizeof(tilename),"%s/%s", msDBFReadStringAttribute(tSHP->tileshpfile->hDBF, i, layer->tileitemindex) , layer->data);
+            filename = tilename;
+          }
 
-            if(strlen(filename) == 0) continue; /* check again */
-
-            try_open = msTiledSHPTryOpen(tSHP->shpfile, layer, tiFileAbsDir, filename);
-            if( try_open == MS_DONE )
-              continue;
-            else if (try_open == MS_FAILURE )
-              return(MS_FAILURE);
-
-            status = msShapefileWhichShapes(tSHP->shpfile, tSHP->tileshpfile->statusbounds, layer->debug);
-            if(status == MS_DONE) {
-              /* Close and continue to next tile */
-              msShapefileClose(tSHP->shpfile);
-              continue;
-            } else if(status != MS_SUCCESS) {
-              msShapefileClose(tSHP->shpfile);
-              return(MS_FAILURE);
-            }
+          if(strlen(filename) == 0) continue; /* check again */
+
+          try_open = msTiledSHPTryOpen(tSHP->shpfile, layer, tiFileAbsDir, filename);
+          if( try_open == MS_DONE )
+            continue;
+          else if (try_open == MS_FAILURE )
+            return(MS_FAILURE);
 
-            tSHP->tileshpfile->lastshape = i;
-            break;
+          status = msShapefileWhichShapes(tSHP->shpfile, tSHP->tileshpfile->statusbounds, layer->debug);
+          if(status == MS_SUCCESS) status = msSHPLayerSearchAttributeIndex(layer, tSHP->shpfile);
+          if(status == MS_DONE) {
+            /* Close and continue to next tile */
+            msShapefilePoolClose(tSHP->shpfile);
+            continue;
+          } else if(status != MS_SUCCESS) {
+            msShapefilePoolClose(tSHP->shpfile);
+            return(MS_FAILURE);
           }
+
+          tSHP->tileshpfile->lastshape = i;
+          break;
         } /* end for loop */
 
-        if(i == tSHP->tileshpfile->numshapes) return(MS_DONE); /* no more tiles */
+        if(i == -1) return(MS_DONE); /* no more tiles */
         else continue; /* we've got shapes */
       }
     }
 
     tSHP->shpfile->lastshape = i;
 
-    msSHPReadShape(tSHP->shpfile->hSHP, i, shape);
     if(shape->type == MS_SHAPE_NULL) {
       msFreeShape(shape);
       continue; /* skip NULL shapes */
     }
     shape->tileindex = tSHP->tileshpfile->lastshape;
-    shape->numvalues = layer->numitems;
-    shape->values = msDBFGetValueList(tSHP->shpfile->hDBF, i, layer->iteminfo, layer->numitems);
-    if(!shape->values) shape->numvalues = 0;
+    msSHPLayerBorrowValues(layer, tSHP->shpfile->hDBF, i, &tSHP->nextvalues, shape);
 
     filter_passed = MS_TRUE;  /* By default accept ANY shape */
     if(layer->numitems > 0 && layer->iteminfo) {
@@ -2240,7 +3297,7 @@ int msTiledSHPGetShape(layerObj *layer, shapeObj *shape, resultObj *record)
   if((tileindex < 0) || (tileindex >= tSHP->tileshpfile->numshapes)) return(MS_FAILURE); /* invalid tile id */
 
   if(tileindex != tSHP->tileshpfile->lastshape) { /* correct tile is not currenly open so open the correct tile */
-    msShapefileClose(tSHP->shpfile); /* close current tile */
+    msShapefilePoolClose(tSHP->shpfile); /* close current tile */
 
     if(!layer->data) /* assume whole filename is in attribute field */
       filename = (char*) msDBFReadStringAttribute(tSHP->tileshpfile->hDBF, tileindex, layer->tileitemindex);
@@ -2251,13 +3308,14 @@ int msTiledSHPGetShape(layerObj *layer, shapeObj *shape, resultObj *record)
 
     /* open the shapefile, since a specific tile was request an error should be generated if that tile does not exist */
     if(strlen(filename) == 0) return(MS_FAILURE);
-    if(msShapefileOpen(tSHP->shpfile, "rb", msBuildPath3(szPath, tiFileAbsDir, layer->map->shapepath, filename), MS_TRUE) == -1) {
-      if(msShapefileOpen(tSHP->shpfile, "rb", msBuildPath3(szPath, layer->map->mappath, layer->map->shapepath, filename), MS_TRUE) == -1) {
-        if(msShapefileOpen(tSHP->shpfile, "rb", msBuildPath(szPath, layer->map->mappath, filename), MS_TRUE) == -1) {
+    if(msShapefilePoolOpen(tSHP->shpfile, msBuildPath3(szPath, tiFileAbsDir, layer->map->shapepath, filename), MS_TRUE) == -1) {
+      if(msShapefilePoolOpen(tSHP->shpfile, msBuildPath3(szPath, layer->map->mappath, layer->map->shapepath, filename), MS_TRUE) == -1) {
+        if(msShapefilePoolOpen(tSHP->shpfile, msBuildPath(szPath, layer->map->mappath, filename), MS_TRUE) == -1) {
           return(MS_FAILURE);
         }
       }
     }
+    msSHPLayerMapShapefile(layer, tSHP->shpfile);
 
   }
 
@@ -2267,9 +3325,8 @@ int msTiledSHPGetShape(layerObj *layer, shapeObj *shape, resultObj *record)
   tSHP->shpfile->lastshape = shapeindex;
 
   if(layer->numitems > 0 && layer->iteminfo) {
-    shape->numvalues = layer->numitems;
-    shape->values = msDBFGetValueList(tSHP->shpfile->hDBF, shapeindex, layer->iteminfo, layer->numitems);
-    if(!shape->values) return(MS_FAILURE);
+    if(msSHPLayerBorrowValues(layer, tSHP->shpfile->hDBF, shapeindex, &tSHP->getvalues, shape) != MS_SUCCESS)
+      return(MS_FAILURE);
   }
 
   shape->tileindex = tileindex;
@@ -2283,7 +3340,7 @@ void msTiledSHPClose(layerObj *layer)
 
   tSHP = layer->layerinfo;
   if(tSHP) {
-    msShapefileClose(tSHP->shpfile);
+    msShapefilePoolClose(tSHP->shpfile);
     free(tSHP->shpfile);
 
     if(tSHP->tilelayerindex != -1) {
@@ -2293,10 +3350,12 @@ void msTiledSHPClose(layerObj *layer)
       tlp = (GET_LAYER(layer->map, tSHP->tilelayerindex));
       msLayerClose(tlp);
     } else {
-      msShapefileClose(tSHP->tileshpfile);
+      msShapefilePoolClose(tSHP->tileshpfile);
       free(tSHP->tileshpfile);
     }
 
+    msDBFFreeValues(&tSHP->nextvalues);
+    msDBFFreeValues(&tSHP->getvalues);
     free(tSHP);
   }
   layer->layerinfo = NULL;
@@ -2499,6 +3558,109 @@ int msSHPLayerInitItemInfo(layerObj *layer)
   return MS_SUCCESS;
 }
 
+/*
+** Opens the layer data, or its overview at the given level, looking in the
+** same places msSHPLayerOpen() always has. The path tried last is left in
+** szPath.
+*/
+static int msSHPLayerOpenShapefile(layerObj *layer, shapefileObj *shpfile, int level, char *szPath, int log_failures)
+{
+  char filename[MS_MAXPATHLEN];
+  int i, status;
+
+  strlcpy(filename, layer->data, sizeof(filename));
+  if(level > 0) { /* overviews are written by shpoverviews as <data>_ov<level>.shp */
+    for(i = strlen(filename)-1; i > 0 && filename[i] != '.' && filename[i] != '/' && filename[i] != '\\'; i--) {}
+    if(filename[i] == '.')
+      filename[i] = '\0';
+    snprintf(filename + strlen(filename), sizeof(filename) - strlen(filename), "_ov%d", level);
+  }
+
+  status = msShapefileOpen(shpfile, "rb", msBuildPath3(szPath, layer->map->mappath, layer->map->shapepath, filename), log_failures);
+  if(status == -1)
+    status = msShapefileOpen(shpfile, "rb", msBuildPath(szPath, layer->map->mappath, filename), log_failures);
+  if(status == -1)
+    return -1;
+
+  shpfile->overview = level;
+  msSHPLayerMapShapefile(layer, shpfile);
+  return 0;
+}
+
+/*
+** PROCESSING "SHAPEFILE_OVERVIEWS=<cellsize>,<cellsize>,..." lists, in
+** increasing order, the map cellsize from which each overview level
+** written by shpoverviews is drawn instead of the data. Usually these are
+** the tolerances the overviews were simplified with, so the vertices
+** dropped never move a line by more than a pixel.
+*/
+static int msSHPLayerOverviewLevel(layerObj *layer)
+{
+  const char *value;
+  char **tokens;
+  int i, numtokens, level=0;
+
+  value = msLayerGetProcessingKey(layer, "SHAPEFILE_OVERVIEWS");
+  if(!value || !layer->map || layer->map->cellsize <= 0)
+    return 0;
+
+  tokens = msStringSplit(value, ',', &numtokens);
+  for(i=0; i<numtokens; i++) {
+    if(atof(tokens[i]) > layer->map->cellsize)
+      break;
+    level = i+1;
+  }
+  msFreeCharArray(tokens, numtokens);
+
+  return level;
+}
+
+/*
+** Switches the open shapefile to the overview level suiting the map
+** cellsize, or back to the data for queries. Missing overviews, or ones
+** whose record count does not match, are skipped for the next level down.
+*/
+static int msSHPLayerSelectOverview(layerObj *layer, shapefileObj *shpfile, int isQuery)
+{
+  char szPath[MS_MAXPATHLEN];
+  shapefileObj overview;
+  int level;
+
+  for(level = isQuery ? 0 : msSHPLayerOverviewLevel(layer); level > 0; level--) {
+    if(level == shpfile->overview)
+      return MS_SUCCESS;
+
+    if(msSHPLayerOpenShapefile(layer, &overview, level, szPath, MS_FALSE) == -1) {
+      if(layer->debug)
+        msDebug("msSHPLayerSelectOverview(): unable to open overview %d of layer %s (%s).\n", level, layer->name?layer->name:"(null)", szPath);
+      continue;
+    }
+
+    if(overview.numshapes != shpfile->numshapes) {
+      if(layer->debug)
+        msDebug("msSHPLayerSelectOverview(): %s has %d shapes instead of %d, ignoring it.\n", overview.source, overview.numshapes, shpfile->numshapes);
+      msShapefileClose(&overview);
+      continue;
+    }
+
+    break;
+  }
+
+  if(level == shpfile->overview)
+    return MS_SUCCESS;
+
+  if(level == 0 && msSHPLayerOpenShapefile(layer, &overview, 0, szPath, MS_TRUE) == -1)
+    return MS_FAILURE;
+
+  if(layer->debug >= MS_DEBUGLEVEL_VV)
+    msDebug("msSHPLayerSelectOverview(): layer %s reads %s.\n", layer->name?layer->name:"(null)", overview.source);
+
+  msShapefileClose(shpfile);
+  *shpfile = overview;
+
+  return MS_SUCCESS;
+}
+
 int msSHPLayerOpen(layerObj *layer)
 {
   char szPath[MS_MAXPATHLEN];
@@ -2516,14 +3678,12 @@ int msSHPLayerOpen(layerObj *layer)
 
   layer->layerinfo = shpfile;
 
-  if(msShapefileOpen(shpfile, "rb", msBuildPath3(szPath, layer->map->mappath, layer->map->shapepath, layer->data), MS_TRUE) == -1) {
-    if(msShapefileOpen(shpfile, "rb", msBuildPath(szPath, layer->map->mappath, layer->data), MS_TRUE) == -1) {
-      layer->layerinfo = NULL;
-      free(shpfile);
-      return MS_FAILURE;
-    }
+  if(msSHPLayerOpenShapefile(layer, shpfile, 0, szPath, MS_TRUE) == -1) {
+    layer->layerinfo = NULL;
+    free(shpfile);
+    return MS_FAILURE;
   }
-  
+
   if (layer->projection.numargs > 0 &&
       EQUAL(layer->projection.args[0], "auto"))
   {
@@ -2596,11 +3756,16 @@ int msSHPLayerWhichShapes(layerObj *layer, rectObj rect, int isQuery)
     return MS_FAILURE;
   }
 
+  if(msSHPLayerSelectOverview(layer, shpfile, isQuery) != MS_SUCCESS)
+    return MS_FAILURE;
+
   status = msShapefileWhichShapes(shpfile, rect, layer->debug);
   if(status != MS_SUCCESS) {
     return status;
   }
 
+  msSHPLayerSearchAttributeIndex(layer, shpfile); /* an empty result is not an error here */
+
   return MS_SUCCESS;
 }
 
@@ -2617,20 +3782,15 @@ int msSHPLayerNextShape(layerObj *layer, shapeObj *shape)
   }
 
   do {
-    i = msGetNextBit(shpfile->status, shpfile->lastshape + 1, shpfile->numshapes);
+    i = msShapefileNextShape(shpfile, shape);
     shpfile->lastshape = i;
     if(i == -1) return(MS_DONE); /* nothing else to read */
 
-    msSHPReadShape(shpfile->hSHP, i, shape);
     if(shape->type == MS_SHAPE_NULL) {
       msFreeShape(shape);
       continue; /* skip NULL shapes */
     }
-    shape->numvalues = layer->numitems;
-    shape->values = msDBFGetValueList(shpfile->hDBF, i, layer->iteminfo, layer->numitems);
-    if(!shape->values) {
-      shape->numvalues = 0;
-    }
+    msSHPLayerBorrowValues(layer, shpfile->hDBF, i, &shpfile->nextvalues, shape);
 
     filter_passed = MS_TRUE;  /* By default accept ANY shape */
     if(layer->numitems > 0 && layer->iteminfo) {
@@ -2665,9 +3825,8 @@ int msSHPLayerGetShape(layerObj *layer, shapeObj *shape, resultObj *record)
 
   msSHPReadShape(shpfile->hSHP, shapeindex, shape);
   if(layer->numitems > 0 && layer->iteminfo) {
-    shape->numvalues = layer->numitems;
-    shape->values = msDBFGetValueList(shpfile->hDBF, shapeindex, layer->iteminfo, layer->numitems);
-    if(!shape->values) return MS_FAILURE;
+    if(msSHPLayerBorrowValues(layer, shpfile->hDBF, shapeindex, &shpfile->getvalues, shape) != MS_SUCCESS)
+      return MS_FAILURE;
   }
 
   shpfile->lastshape = shapeindex;
@@ -42,6 +42,11 @@ extern "C" {
 #ifndef SWIG
 #define MS_PATH_LENGTH 1024
 
+  /* msSHPReadShapes() merges records into reads of up to this many bytes, */
+  /* reading through gaps of up to SHP_BATCH_READ_GAP bytes between them   */
+#define SHP_BATCH_READ_SIZE 262144
+#define SHP_BATCH_READ_GAP 8192
+
   /* Shapefile types */
 #define SHP_POINT 1
 #define SHP_ARC 3
@@ -102,8 +107,17 @@ extern "C" {
     int   nPartMax;
     int   *panParts;
 
+    uchar   *pabySHPMap; /* read-only mappings of the .shp and .shx, NULL when reading through stdio */
+    size_t  nSHPMapSize;
+    uchar   *pabySHXMap;
+    size_t  nSHXMapSize;
+
   } SHPInfo;
   typedef SHPInfo * SHPHandle;
+
+  /* Receives the shapes read by msSHPReadShapes() and takes ownership of  */
+  /* their contents, anything but MS_SUCCESS stops the read.               */
+  typedef int (*SHPReadShapesFunc)( void *pUserData, int hEntity, shapeObj *shape );
 #endif
 
 
@@ -135,6 +149,11 @@ extern "C" {
 
     char  *pszStringField;
     int   nStringFieldLen;
+
+#ifndef SWIG
+    uchar *pabyMap; /* read-only mapping of the .dbf, NULL when reading through stdio */
+    size_t nMapSize;
+#endif
 #ifdef SWIG
     %mutable;
 #endif
@@ -143,6 +162,32 @@ extern "C" {
 
   typedef enum {FTString, FTInteger, FTDouble, FTInvalid} DBFFieldType;
 
+#ifndef SWIG
+  /* Attribute values of one record decoded by msDBFReadValues(). The
+     strings share one buffer that is reused by the next read, so shapes
+     only borrow them. */
+  typedef struct {
+    char **values;
+    double *numericvalues; /* parsed N and F fields, NaN for the others */
+    int numvalues, maxvalues;
+    char *buffer;
+    int buffersize;
+  } dbfValuesObj;
+#endif
+
+#ifndef SWIG
+  /* Ids of the shapes found by a search. They are kept as a list while
+     few compared to the number of shapes and switch to a bit array once
+     the list would be larger than one, see msAddShapeId(). */
+  typedef struct {
+    int numshapes;
+    ms_bitarray bits; /* dense form, NULL while sparse */
+    int *ids; /* sparse form, sorted by msSortShapeIdSet() */
+    int numids;
+    int maxids;
+  } shapeIdSetObj;
+#endif
+
   /* Shapefile object, no write access via scripts */
   typedef struct {
 #ifdef SWIG
@@ -167,6 +212,24 @@ extern "C" {
     ms_bitarray status;
     rectObj statusbounds; /* holds extent associated with the status vector */
 
+#ifndef SWIG
+    int *statusids; /* sorted ids when the search result is sparse, status is NULL then */
+    int numstatusids;
+
+    shapeObj *batch; /* shapes read ahead of msSHPLayerNextShape() */
+    int *batchids;
+    int numbatch, batchpos;
+
+    dbfValuesObj nextvalues; /* attributes of the last shape from msSHPLayerNextShape() */
+    dbfValuesObj getvalues; /* attributes of the last shape from msSHPLayerGetShape() */
+
+    int overview; /* overview level opened by a shapefile layer, 0 for the data itself */
+
+    int pooled; /* opened by msShapefilePoolOpen(), with the .shp as it was then */
+    time_t mtime;
+    long filesize;
+#endif
+
     int isopen;
 #ifdef SWIG
     %mutable;
@@ -179,6 +242,8 @@ extern "C" {
     shapefileObj *shpfile;
     shapefileObj *tileshpfile;
     int tilelayerindex;
+    dbfValuesObj nextvalues; /* outlive the tile shapefiles, see shapefileObj */
+    dbfValuesObj getvalues;
   } msTiledSHPLayerInfo;
 
   /* shapefileObj function prototypes  */
@@ -186,6 +251,12 @@ extern "C" {
   MS_DLL_EXPORT int msShapefileCreate(shapefileObj *shpfile, char *filename, int type);
   MS_DLL_EXPORT void msShapefileClose(shapefileObj *shpfile);
   MS_DLL_EXPORT int msShapefileWhichShapes(shapefileObj *shpfile, rectObj rect, int debug);
+  MS_DLL_EXPORT int msShapefileMap(shapefileObj *shpfile);
+  MS_DLL_EXPORT int msShapefileNextShapeIndex(shapefileObj *shpfile, int index);
+  MS_DLL_EXPORT int msShapefilePoolOpen(shapefileObj *shpfile, char *filename, int log_failures);
+  MS_DLL_EXPORT void msShapefilePoolClose(shapefileObj *shpfile);
+  MS_DLL_EXPORT void msSetShapefilePoolSize(const char *value);
+  MS_DLL_EXPORT void msShapefilePoolCleanup(void);
 
   /* SHP/SHX function prototypes */
   MS_DLL_EXPORT SHPHandle msSHPOpen( const char * pszShapeFile, const char * pszAccess );
@@ -193,10 +264,15 @@ extern "C" {
   MS_DLL_EXPORT void msSHPClose( SHPHandle hSHP );
   MS_DLL_EXPORT void msSHPGetInfo( SHPHandle hSHP, int * pnEntities, int * pnShapeType );
   MS_DLL_EXPORT int msSHPReadBounds( SHPHandle psSHP, int hEntity, rectObj *padBounds );
+  MS_DLL_EXPORT int msSHPReadBoundsRange( SHPHandle psSHP, int hStart, int nCount, rectObj *padBounds, uchar *pabyValid );
   MS_DLL_EXPORT void msSHPReadShape( SHPHandle psSHP, int hEntity, shapeObj *shape );
+  MS_DLL_EXPORT int msSHPReadShapes( SHPHandle psSHP, const int *panEntities, int nEntities, SHPReadShapesFunc pfnShape, void *pUserData );
   MS_DLL_EXPORT int msSHPReadPoint(SHPHandle psSHP, int hEntity, pointObj *point );
   MS_DLL_EXPORT int msSHPWriteShape( SHPHandle psSHP, shapeObj *shape );
   MS_DLL_EXPORT int msSHPWritePoint(SHPHandle psSHP, pointObj *point );
+  MS_DLL_EXPORT int msSHPMapFiles( SHPHandle psSHP );
+  MS_DLL_EXPORT uchar *msSHPMapFile( FILE *fp, size_t *pnSize );
+  MS_DLL_EXPORT void msSHPUnmapFile( uchar *pabyMap, size_t nSize );
   /* SHX reading */
   MS_DLL_EXPORT int msSHXLoadAll( SHPHandle psSHP );
   MS_DLL_EXPORT int msSHXLoadPage( SHPHandle psSHP, int shxBufferPage );
@@ -210,6 +286,7 @@ extern "C" {
   MS_DLL_EXPORT DBFHandle msDBFOpen( const char * pszDBFFile, const char * pszAccess );
   MS_DLL_EXPORT void msDBFClose( DBFHandle hDBF );
   MS_DLL_EXPORT DBFHandle msDBFCreate( const char * pszDBFFile );
+  MS_DLL_EXPORT int msDBFMapFile( DBFHandle psDBF );
 
   MS_DLL_EXPORT int msDBFGetFieldCount( DBFHandle psDBF );
   MS_DLL_EXPORT int msDBFGetRecordCount( DBFHandle psDBF );
@@ -228,6 +305,9 @@ extern "C" {
   MS_DLL_EXPORT char **msDBFGetItems(DBFHandle dbffile);
   MS_DLL_EXPORT char **msDBFGetValues(DBFHandle dbffile, int record);
   MS_DLL_EXPORT char **msDBFGetValueList(DBFHandle dbffile, int record, int *itemindexes, int numitems);
+  MS_DLL_EXPORT void msDBFInitValues(dbfValuesObj *values);
+  MS_DLL_EXPORT int msDBFReadValues(DBFHandle dbffile, int record, int *itemindexes, int numitems, dbfValuesObj *values);
+  MS_DLL_EXPORT void msDBFFreeValues(dbfValuesObj *values);
   MS_DLL_EXPORT int *msDBFGetItemIndexes(DBFHandle dbffile, char **items, int numitems);
   MS_DLL_EXPORT int msDBFGetItemIndex(DBFHandle dbffile, char *name);
 
@@ -37,14 +37,8 @@
 
 
 
-extern int msyylex(void); /* lexer globals */
-extern void msyyrestart(FILE *);
-extern double msyynumber;
-extern char *msyystring_buffer;
-extern int msyylineno;
-extern FILE *msyyin;
-
-extern int msyystate;
+extern int msyylex(void *scanner); /* lexer, see maplexer.l */
+extern void msyyrestart(FILE *input_file, void *scanner);
 
 static const unsigned char PNGsig[8] = {137, 80, 78, 71, 13, 10, 26, 10}; /* 89 50 4E 47 0D 0A 1A 0A hex */
 static const unsigned char JPEGsig[3] = {255, 216, 255}; /* FF D8 FF hex */
@@ -157,7 +151,7 @@ int msFreeSymbol(symbolObj *s)
   return MS_SUCCESS;
 }
 
-int loadSymbol(symbolObj *s, char *symbolpath)
+int loadSymbol(lexerObj *lexer, symbolObj *s, char *symbolpath)
 {
   int done=MS_FALSE;
   char szPath[MS_MAXPATHLEN];
@@ -165,21 +159,21 @@ int loadSymbol(symbolObj *s, char *symbolpath)
   initSymbol(s);
 
   for(;;) {
-    switch(msyylex()) {
+    switch(msLexerNextToken(lexer)) {
       case(ANCHORPOINT):
-        if(getDouble(&(s->anchorpoint_x)) == -1) return MS_FAILURE;
-        if(getDouble(&(s->anchorpoint_y)) == -1) return MS_FAILURE;
+        if(getDouble(lexer, &(s->anchorpoint_x)) == -1) return MS_FAILURE;
+        if(getDouble(lexer, &(s->anchorpoint_y)) == -1) return MS_FAILURE;
         if(s->anchorpoint_x<0 || s->anchorpoint_x>1 || s->anchorpoint_y<0 || s->anchorpoint_y>1) {
           msSetError(MS_SYMERR, "ANCHORPOINT must be between 0 and 1", "loadSymbol()");
           return(-1);
         }
         break;
       case(ANTIALIAS):
-        if((s->antialias = getSymbol(2,MS_TRUE,MS_FALSE)) == -1)
+        if((s->antialias = getSymbol(lexer, 2,MS_TRUE,MS_FALSE)) == -1)
           return(-1);
         break;
       case(CHARACTER):
-        if(getString(&s->character) == MS_FAILURE) return(-1);
+        if(getString(lexer, &s->character) == MS_FAILURE) return(-1);
         break;
       case(END): /* do some error checking */
         if((s->type == MS_SYMBOL_SVG) && (s->imagepath == NULL)) {
@@ -225,36 +219,36 @@ int loadSymbol(symbolObj *s, char *symbolpath)
         return(-1);
         break;
       case(FILLED):
-        if((s->filled = getSymbol(2,MS_TRUE,MS_FALSE)) == -1)
+        if((s->filled = getSymbol(lexer, 2,MS_TRUE,MS_FALSE)) == -1)
           return(-1);
         break;
       case(FONT):
-        if(getString(&s->font) == MS_FAILURE) return(-1);
+        if(getString(lexer, &s->font) == MS_FAILURE) return(-1);
         break;
       case(IMAGE):
-        if(msyylex() != MS_STRING) { /* get image location from next token */
-          msSetError(MS_TYPEERR, "Parsing error near (%s):(line %d)", "loadSymbol()", msyystring_buffer, msyylineno);
+        if(msLexerNextToken(lexer) != MS_STRING) { /* get image location from next token */
+          msSetError(MS_TYPEERR, "Parsing error near (%s):(line %d)", "loadSymbol()", lexer->string_buffer, lexer->lineno);
           return(-1);
         }
-        s->full_pixmap_path = msStrdup(msBuildPath(szPath, symbolpath, msyystring_buffer));
+        s->full_pixmap_path = msStrdup(msBuildPath(szPath, symbolpath, lexer->string_buffer));
         /* Set imagepath */
-        s->imagepath = msStrdup(msyystring_buffer);
+        s->imagepath = msStrdup(lexer->string_buffer);
         break;
       case(NAME):
-        if(getString(&s->name) == MS_FAILURE) return(-1);
+        if(getString(lexer, &s->name) == MS_FAILURE) return(-1);
         break;
       case(POINTS):
         done = MS_FALSE;
         s->sizex = 0;
         s->sizey = 0;
         for(;;) {
-          switch(msyylex()) {
+          switch(msLexerNextToken(lexer)) {
             case(END):
               done = MS_TRUE;
               break;
             case(MS_NUMBER):
-              s->points[s->numpoints].x = atof(msyystring_buffer); /* grab the x */
-              if(getDouble(&(s->points[s->numpoints].y)) == -1) return(-1); /* grab the y */
+              s->points[s->numpoints].x = atof(lexer->string_buffer); /* grab the x */
+              if(getDouble(lexer, &(s->points[s->numpoints].y)) == -1) return(-1); /* grab the y */
               if(s->points[s->numpoints].x!=-99) {
                 s->sizex = MS_MAX(s->sizex, s->points[s->numpoints].x);
                 s->sizey = MS_MAX(s->sizey, s->points[s->numpoints].y);
@@ -262,7 +256,7 @@ int loadSymbol(symbolObj *s, char *symbolpath)
               s->numpoints++;
               break;
             default:
-              msSetError(MS_TYPEERR, "Parsing error near (%s):(line %d)", "loadSymbol()", msyystring_buffer, msyylineno);
+              msSetError(MS_TYPEERR, "Parsing error near (%s):(line %d)", "loadSymbol()", lexer->string_buffer, lexer->lineno);
               return(-1);
           }
 
@@ -272,16 +266,16 @@ int loadSymbol(symbolObj *s, char *symbolpath)
         break;
       case(TRANSPARENT):
         s->transparent = MS_TRUE;
-        if(getInteger(&(s->transparentcolor)) == -1) return(-1);
+        if(getInteger(lexer, &(s->transparentcolor)) == -1) return(-1);
         break;
       case(TYPE):
-        if((s->type = getSymbol(8,MS_SYMBOL_VECTOR,MS_SYMBOL_ELLIPSE,MS_SYMBOL_PIXMAP,MS_SYMBOL_SIMPLE,MS_TRUETYPE,MS_SYMBOL_HATCH,MS_SYMBOL_SVG)) == -1)
+        if((s->type = getSymbol(lexer, 8,MS_SYMBOL_VECTOR,MS_SYMBOL_ELLIPSE,MS_SYMBOL_PIXMAP,MS_SYMBOL_SIMPLE,MS_TRUETYPE,MS_SYMBOL_HATCH,MS_SYMBOL_SVG)) == -1)
           return(-1);
         if(s->type == MS_TRUETYPE) /* TrueType keyword is valid several place in map files and symbol files, this simplifies the lexer */
           s->type = MS_SYMBOL_TRUETYPE;
         break;
       default:
-        msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadSymbol()", msyystring_buffer, msyylineno);
+        msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadSymbol()", lexer->string_buffer, lexer->lineno);
         return(-1);
     } /* end switch */
   } /* end for */
@@ -418,6 +412,7 @@ int msFreeSymbolSet(symbolSetObj *symbolset)
     }
   }
   msFree(symbolset->symbol);
+  msFreeNameIndex(&(symbolset->nameindex));
 
   /* no need to deal with fontset, it's a pointer */
   return MS_SUCCESS;
@@ -436,6 +431,7 @@ void msInitSymbolSet(symbolSetObj *symbolset)
   symbolset->numsymbols = 0;
   symbolset->maxsymbols = 0;
   symbolset->symbol = NULL;
+  msInitNameIndex(&(symbolset->nameindex));
 
   /* Alloc symbol[] array and ensure there is at least 1 symbol:
    * symbol 0 which is the default symbol with all default params.
@@ -513,23 +509,14 @@ symbolObj *msGrowSymbolSet( symbolSetObj *symbolset )
 /* ---------------------------------------------------------------------------
    msLoadSymbolSet and loadSymbolSet
 
-   msLoadSymbolSet wraps calls to loadSymbolSet with mutex acquisition and
-   release.  It should be used everywhere outside the mapfile loading
-   phase of an application.  loadSymbolSet should only be used when a mutex
-   exists.  It does not check for existence of a mutex!
-
-   See bug 339 for more details -- SG.
+   msLoadSymbolSet and loadSymbolSet are the same thing: symbol files are
+   read with a lexer of their own, so no mutex is needed anymore (it used
+   to be, see bug 339).
    ------------------------------------------------------------------------ */
 
 int msLoadSymbolSet(symbolSetObj *symbolset, mapObj *map)
 {
-  int retval = MS_FAILURE;
-
-  msAcquireLock( TLOCK_PARSER );
-  retval = loadSymbolSet( symbolset, map );
-  msReleaseLock( TLOCK_PARSER );
-
-  return retval;
+  return loadSymbolSet( symbolset, map );
 }
 
 int loadSymbolSet(symbolSetObj *symbolset, mapObj *map)
@@ -539,6 +526,8 @@ int loadSymbolSet(symbolSetObj *symbolset, mapObj *map)
 
   int foundSymbolSetToken=MS_FALSE;
   int token;
+  FILE *symbolfile;
+  lexerObj lexer;
 
   if(!symbolset) {
     msSetError(MS_SYMERR, "Symbol structure unallocated.", "loadSymbolSet()");
@@ -552,28 +541,34 @@ int loadSymbolSet(symbolSetObj *symbolset, mapObj *map)
   /*
   ** Open the file
   */
-  if((msyyin = fopen(msBuildPath(szPath, symbolset->map->mappath, symbolset->filename), "r")) == NULL) {
+  if((symbolfile = fopen(msBuildPath(szPath, symbolset->map->mappath, symbolset->filename), "r")) == NULL) {
     msSetError(MS_IOERR, "(%s)", "loadSymbolSet()", symbolset->filename);
     return(-1);
   }
 
+  if(msInitLexer(&lexer) != MS_SUCCESS) {
+    fclose(symbolfile);
+    return(-1);
+  }
+
   pszSymbolPath = msGetPath(szPath);
 
-  msyystate = MS_TOKENIZE_FILE; /* restore lexer state to INITIAL, and do return comments */
-  msyylex(); /* sets things up, but doesn't process any tokens */
+  lexer.state = MS_TOKENIZE_FILE; /* restore lexer state to INITIAL, and do return comments */
+  msyylex(lexer.scanner); /* sets things up, but doesn't process any tokens */
 
-  msyylineno = 0; /* reset line counter */
-  msyyrestart(msyyin); /* flush the scanner - there's a better way but this works for now */
+  lexer.lineno = 0; /* reset line counter */
+  msyyrestart(symbolfile, lexer.scanner); /* flush the scanner - there's a better way but this works for now */
 
   /*
   ** Read the symbol file
   */
   for(;;) {
-    token = msyylex();
+    token = msyylex(lexer.scanner);
 
     if(!foundSymbolSetToken && token != SYMBOLSET) {
       msSetError(MS_IDENTERR, "First token must be SYMBOLSET, this doesn't look like a symbol file.", "msLoadSymbolSet()");
-      return(-1);
+      status = -1;
+      break;
     }
 
     switch(token) {
@@ -585,7 +580,7 @@ int loadSymbolSet(symbolSetObj *symbolset, mapObj *map)
         /* Allocate/init memory for new symbol if needed */
         if (msGrowSymbolSet(symbolset) == NULL) {
           status = -1;
-        } else if((loadSymbol((symbolset->symbol[symbolset->numsymbols]), pszSymbolPath) == -1))
+        } else if((loadSymbol(&lexer, (symbolset->symbol[symbolset->numsymbols]), pszSymbolPath) == -1))
           status = -1;
         else
           symbolset->numsymbols++;
@@ -594,15 +589,15 @@ int loadSymbolSet(symbolSetObj *symbolset, mapObj *map)
         foundSymbolSetToken = MS_TRUE;
         break;
       default:
-        msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadSymbolSet()", msyystring_buffer, msyylineno);
+        msSetError(MS_IDENTERR, "Parsing error near (%s):(line %d)", "loadSymbolSet()", lexer.string_buffer, lexer.lineno);
         status = -1;
     } /* end switch */
 
     if(status != 1) break;
   } /* end for */
 
-  fclose(msyyin);
-  msyyin = NULL;
+  msFreeLexer(&lexer);
+  fclose(symbolfile);
   free(pszSymbolPath);
   return(status);
 }
@@ -752,6 +747,7 @@ symbolObj *msRemoveSymbol(symbolSetObj *symbolset, int nSymbolIndex)
     }
     symbolset->symbol[i-1]=NULL;
     symbolset->numsymbols--;
+    msFreeNameIndex(&(symbolset->nameindex));
     MS_REFCNT_DECR(symbol);
     /* update symbol references in the map */
     if (symbolset->map) {
@@ -1281,7 +1281,7 @@ static int processItemTag(layerObj *layer, char **line, shapeObj *shape)
 
         itemValue = (char *) msSmallMalloc(64); /* plenty big */
         snprintf(numberFormat, sizeof(numberFormat), "%%.%dlf", precision);
-        snprintf(itemValue, 64, numberFormat, atof(shape->values[i]));
+        snprintf(itemValue, 64, numberFormat, msShapeGetNumericValue(shape, i));
       } else
         itemValue = msStrdup(shape->values[i]);
 
@@ -3709,17 +3709,16 @@ static char *processLine(mapservObj *mapserv, char *instr, FILE *stream, int mod
    */
 
   if(&(mapserv->map->web.metadata) && strstr(outstr, "web_")) {
-    for (j=0; j<MS_HASHSIZE; j++) {
-      if(mapserv->map->web.metadata.items[j] != NULL) {
-        for(tp=mapserv->map->web.metadata.items[j]; tp!=NULL; tp=tp->next) {
-          snprintf(substr, PROCESSLINE_BUFLEN, "[web_%s]", tp->key);
-          outstr = msReplaceSubstring(outstr, substr, tp->data);
-          snprintf(substr, PROCESSLINE_BUFLEN, "[web_%s_esc]", tp->key);
-
-          encodedstr = msEncodeUrl(tp->data);
-          outstr = msReplaceSubstring(outstr, substr, encodedstr);
-          free(encodedstr);
-        }
+    for (j=0; j<mapserv->map->web.metadata.numused; j++) {
+      tp = &(mapserv->map->web.metadata.items[j]);
+      if(tp->data != NULL) {
+        snprintf(substr, PROCESSLINE_BUFLEN, "[web_%s]", tp->key);
+        outstr = msReplaceSubstring(outstr, substr, tp->data);
+        snprintf(substr, PROCESSLINE_BUFLEN, "[web_%s_esc]", tp->key);
+
+        encodedstr = msEncodeUrl(tp->data);
+        outstr = msReplaceSubstring(outstr, substr, encodedstr);
+        free(encodedstr);
       }
     }
   }
@@ -3727,22 +3726,21 @@ static char *processLine(mapservObj *mapserv, char *instr, FILE *stream, int mod
   /* allow layer metadata access in template */
   for(i=0; i<mapserv->map->numlayers; i++) {
     if(&(GET_LAYER(mapserv->map, i)->metadata) && GET_LAYER(mapserv->map, i)->name && strstr(outstr, GET_LAYER(mapserv->map, i)->name)) {
-      for(j=0; j<MS_HASHSIZE; j++) {
-        if(GET_LAYER(mapserv->map, i)->metadata.items[j] != NULL) {
-          for(tp=GET_LAYER(mapserv->map, i)->metadata.items[j]; tp!=NULL; tp=tp->next) {
-            snprintf(substr, PROCESSLINE_BUFLEN, "[%s_%s]", GET_LAYER(mapserv->map, i)->name, tp->key);
-            if(GET_LAYER(mapserv->map, i)->status == MS_ON)
-              outstr = msReplaceSubstring(outstr, substr, tp->data);
-            else
-              outstr = msReplaceSubstring(outstr, substr, "");
-            snprintf(substr, PROCESSLINE_BUFLEN, "[%s_%s_esc]", GET_LAYER(mapserv->map, i)->name, tp->key);
-            if(GET_LAYER(mapserv->map, i)->status == MS_ON) {
-              encodedstr = msEncodeUrl(tp->data);
-              outstr = msReplaceSubstring(outstr, substr, encodedstr);
-              free(encodedstr);
-            } else
-              outstr = msReplaceSubstring(outstr, substr, "");
-          }
+      for(j=0; j<GET_LAYER(mapserv->map, i)->metadata.numused; j++) {
+        tp = &(GET_LAYER(mapserv->map, i)->metadata.items[j]);
+        if(tp->data != NULL) {
+          snprintf(substr, PROCESSLINE_BUFLEN, "[%s_%s]", GET_LAYER(mapserv->map, i)->name, tp->key);
+          if(GET_LAYER(mapserv->map, i)->status == MS_ON)
+            outstr = msReplaceSubstring(outstr, substr, tp->data);
+          else
+            outstr = msReplaceSubstring(outstr, substr, "");
+          snprintf(substr, PROCESSLINE_BUFLEN, "[%s_%s_esc]", GET_LAYER(mapserv->map, i)->name, tp->key);
+          if(GET_LAYER(mapserv->map, i)->status == MS_ON) {
+            encodedstr = msEncodeUrl(tp->data);
+            outstr = msReplaceSubstring(outstr, substr, encodedstr);
+            free(encodedstr);
+          } else
+            outstr = msReplaceSubstring(outstr, substr, "");
         }
       }
     }
@@ -3894,17 +3892,16 @@ static char *processLine(mapservObj *mapserv, char *instr, FILE *stream, int mod
 
     /* allow layer metadata access in a query template, within the context of a query no layer name is necessary */
     if(&(mapserv->resultlayer->metadata) && strstr(outstr, "[metadata_")) {
-      for(i=0; i<MS_HASHSIZE; i++) {
-        if(mapserv->resultlayer->metadata.items[i] != NULL) {
-          for(tp=mapserv->resultlayer->metadata.items[i]; tp!=NULL; tp=tp->next) {
-            snprintf(substr, PROCESSLINE_BUFLEN, "[metadata_%s]", tp->key);
-            outstr = msReplaceSubstring(outstr, substr, tp->data);
+      for(i=0; i<mapserv->resultlayer->metadata.numused; i++) {
+        tp = &(mapserv->resultlayer->metadata.items[i]);
+        if(tp->data != NULL) {
+          snprintf(substr, PROCESSLINE_BUFLEN, "[metadata_%s]", tp->key);
+          outstr = msReplaceSubstring(outstr, substr, tp->data);
 
-            snprintf(substr, PROCESSLINE_BUFLEN, "[metadata_%s_esc]", tp->key);
-            encodedstr = msEncodeUrl(tp->data);
-            outstr = msReplaceSubstring(outstr, substr, encodedstr);
-            free(encodedstr);
-          }
+          snprintf(substr, PROCESSLINE_BUFLEN, "[metadata_%s_esc]", tp->key);
+          encodedstr = msEncodeUrl(tp->data);
+          outstr = msReplaceSubstring(outstr, substr, encodedstr);
+          free(encodedstr);
         }
       }
     }
@@ -144,7 +144,7 @@ static int thread_debug = 0;
 
 static char *lock_names[] = {
   NULL, "PARSER", "GDAL", "ERROROBJ", "PROJ", "TTF", "POOL", "SDE",
-  "ORACLE", "OWS", "LAYER_VTABLE", "IOCONTEXT", "TMPFILE", "DEBUGOBJ", "OGR", "TIME", "FRIBIDI", "WXS", "GEOS", NULL
+  "ORACLE", "OWS", "LAYER_VTABLE", "IOCONTEXT", "TMPFILE", "DEBUGOBJ", "OGR", "TIME", "FRIBIDI", "WXS", "GEOS", "QIXCACHE", "SHPPOOL", "MAPCACHE", "CAPSCACHE", "TEXTCACHE", NULL
 };
 #endif
 
@@ -157,6 +157,7 @@ static char *lock_names[] = {
 #if defined(USE_THREAD) && !defined(_WIN32)
 
 #include "pthread.h"
+#include <unistd.h>
 
 static int mutexes_initialized = 0;
 static pthread_mutex_t mutex_locks[TLOCK_MAX];
@@ -227,6 +228,82 @@ void msReleaseLock( int nLockId )
   pthread_mutex_unlock( mutex_locks + nLockId );
 }
 
+/************************************************************************/
+/*                          msRunThreadTasks()                          */
+/************************************************************************/
+
+typedef struct {
+  pthread_mutex_t lock;
+  void **tasks;
+  int numtasks;
+  int next;
+  msThreadTaskFunc func;
+} threadTaskQueue;
+
+static void *threadTaskWorker( void *arg )
+
+{
+  threadTaskQueue *queue = (threadTaskQueue *) arg;
+  int i;
+
+  for( ;; ) {
+    pthread_mutex_lock( &queue->lock );
+    i = queue->next++;
+    pthread_mutex_unlock( &queue->lock );
+
+    if( i >= queue->numtasks )
+      break;
+    queue->func( queue->tasks[i] );
+  }
+
+  return NULL;
+}
+
+void msRunThreadTasks( void **tasks, int numtasks, msThreadTaskFunc func, int numthreads )
+
+{
+  threadTaskQueue queue;
+  pthread_t *threads;
+  int i, numstarted = 0;
+
+  if( numthreads > numtasks )
+    numthreads = numtasks;
+
+  pthread_mutex_init( &queue.lock, NULL );
+  queue.tasks = tasks;
+  queue.numtasks = numtasks;
+  queue.next = 0;
+  queue.func = func;
+
+  /* the calling thread is one of the workers */
+  threads = (pthread_t *) msSmallMalloc( sizeof(pthread_t) * (numthreads > 1 ? numthreads : 1) );
+  for( i = 1; i < numthreads; i++ ) {
+    if( pthread_create( threads + numstarted, NULL, threadTaskWorker, &queue ) != 0 )
+      break; /* the others pick up the slack */
+    numstarted++;
+  }
+
+  threadTaskWorker( &queue );
+
+  for( i = 0; i < numstarted; i++ )
+    pthread_join( threads[i], NULL );
+
+  free( threads );
+  pthread_mutex_destroy( &queue.lock );
+}
+
+/************************************************************************/
+/*                        msGetProcessorCount()                         */
+/************************************************************************/
+
+int msGetProcessorCount()
+
+{
+  long count = sysconf( _SC_NPROCESSORS_ONLN );
+
+  return (count > 0) ? (int) count : 1;
+}
+
 #endif /* defined(USE_THREAD) && !defined(_WIN32) */
 
 /************************************************************************/
@@ -315,4 +392,105 @@ void msReleaseLock( int nLockId )
   ReleaseMutex( mutex_locks[nLockId] );
 }
 
+/************************************************************************/
+/*                          msRunThreadTasks()                          */
+/************************************************************************/
+
+typedef struct {
+  void **tasks;
+  LONG numtasks;
+  volatile LONG next;
+  msThreadTaskFunc func;
+} threadTaskQueue;
+
+static DWORD WINAPI threadTaskWorker( LPVOID arg )
+
+{
+  threadTaskQueue *queue = (threadTaskQueue *) arg;
+  LONG i;
+
+  while( (i = InterlockedIncrement( &queue->next ) - 1) < queue->numtasks )
+    queue->func( queue->tasks[i] );
+
+  return 0;
+}
+
+void msRunThreadTasks( void **tasks, int numtasks, msThreadTaskFunc func, int numthreads )
+
+{
+  threadTaskQueue queue;
+  HANDLE *threads;
+  int i, numstarted = 0;
+
+  if( numthreads > numtasks )
+    numthreads = numtasks;
+
+  queue.tasks = tasks;
+  queue.numtasks = numtasks;
+  queue.next = 0;
+  queue.func = func;
+
+  /* the calling thread is one of the workers */
+  threads = (HANDLE *) msSmallMalloc( sizeof(HANDLE) * (numthreads > 1 ? numthreads : 1) );
+  for( i = 1; i < numthreads; i++ ) {
+    threads[numstarted] = CreateThread( NULL, 0, threadTaskWorker, &queue, 0, NULL );
+    if( threads[numstarted] == NULL )
+      break; /* the others pick up the slack */
+    numstarted++;
+  }
+
+  threadTaskWorker( &queue );
+
+  for( i = 0; i < numstarted; i++ ) {
+    WaitForSingleObject( threads[i], INFINITE );
+    CloseHandle( threads[i] );
+  }
+
+  free( threads );
+}
+
+/************************************************************************/
+/*                        msGetProcessorCount()                         */
+/************************************************************************/
+
+int msGetProcessorCount()
+
+{
+  SYSTEM_INFO info;
+
+  GetSystemInfo( &info );
+  return (info.dwNumberOfProcessors > 0) ? (int) info.dwNumberOfProcessors : 1;
+}
+
 #endif /* defined(USE_THREAD) && defined(_WIN32) */
+
+/************************************************************************/
+/* ==================================================================== */
+/*                          NO THREAD SUPPORT                           */
+/* ==================================================================== */
+/************************************************************************/
+
+#if !defined(USE_THREAD)
+
+/************************************************************************/
+/*                          msRunThreadTasks()                          */
+/*                                                                      */
+/*      Without thread support the tasks run one after the other.      */
+/************************************************************************/
+
+void msRunThreadTasks( void **tasks, int numtasks, msThreadTaskFunc func, int numthreads )
+
+{
+  int i;
+
+  for( i = 0; i < numtasks; i++ )
+    func( tasks[i] );
+}
+
+int msGetProcessorCount()
+
+{
+  return 1;
+}
+
+#endif /* !defined(USE_THREAD) */
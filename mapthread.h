@@ -34,6 +34,12 @@
 extern "C" {
 #endif
 
+  /* runs func(tasks[i]) for every task, see msRunThreadTasks() */
+  typedef void (*msThreadTaskFunc)(void *task);
+
+  MS_DLL_EXPORT void msRunThreadTasks(void **tasks, int numtasks, msThreadTaskFunc func, int numthreads);
+  MS_DLL_EXPORT int msGetProcessorCount(void);
+
 #ifdef USE_THREAD
   void msThreadInit(void);
   int msGetThreadId(void);
@@ -51,7 +57,7 @@ extern "C" {
   ** mapthread.c that needs to be extended when new ids are added.
   */
 
-#define TLOCK_PARSER  1
+#define TLOCK_PARSER  1 /* unused, the mapfile lexer is reentrant */
 #define TLOCK_GDAL  2
 #define TLOCK_ERROROBJ  3
 #define TLOCK_PROJ      4
@@ -69,8 +75,13 @@ extern "C" {
 #define TLOCK_FRIBIDI   16
 #define TLOCK_WxS       17
 #define TLOCK_GEOS       18
+#define TLOCK_QIXCACHE   19
+#define TLOCK_SHPPOOL    20
+#define TLOCK_MAPCACHE   21
+#define TLOCK_CAPSCACHE  22
+#define TLOCK_TEXTCACHE  23
 
-#define TLOCK_STATIC_MAX 20
+#define TLOCK_STATIC_MAX 24
 #define TLOCK_MAX       100
 
 #ifdef __cplusplus
@@ -30,6 +30,10 @@
 
 #include "mapserver.h"
 #include "maptree.h"
+#include "mapthread.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
 
 
 
@@ -195,6 +199,18 @@ void msSHPDiskTreeClose(SHPTreeHandle disktree)
 }
 
 
+static int treeDefaultDepth(int numshapes)
+{
+  int maxdepth = 0, numnodes = 1;
+
+  while(numnodes*4 < numshapes) {
+    maxdepth += 1;
+    numnodes = numnodes * 2;
+  }
+
+  return maxdepth;
+}
+
 treeObj *msCreateTree(shapefileObj *shapefile, int maxdepth)
 {
   int i;
@@ -215,14 +231,8 @@ treeObj *msCreateTree(shapefileObj *shapefile, int maxdepth)
   /*      If no max depth was defined, try to select a reasonable one     */
   /*      that implies approximately 8 shapes per node.                   */
   /* -------------------------------------------------------------------- */
-  if( tree->maxdepth == 0 ) {
-    int numnodes = 1;
-
-    while(numnodes*4 < shapefile->numshapes) {
-      tree->maxdepth += 1;
-      numnodes = numnodes * 2;
-    }
-  }
+  if( tree->maxdepth == 0 )
+    tree->maxdepth = treeDefaultDepth(shapefile->numshapes);
 
   /* -------------------------------------------------------------------- */
   /*      Allocate the root node.                                         */
@@ -460,7 +470,7 @@ void msTreeTrim(treeObj *tree)
   treeNodeTrim(tree->root);
 }
 
-static void searchDiskTreeNode(SHPTreeHandle disktree, rectObj aoi, ms_bitarray status)
+static void searchDiskTreeNode(SHPTreeHandle disktree, rectObj aoi, shapeIdSetObj *set)
 {
   int i;
   ms_int32 offset;
@@ -493,11 +503,11 @@ static void searchDiskTreeNode(SHPTreeHandle disktree, rectObj aoi, ms_bitarray
     if (disktree->needswap ) {
       for( i=0; i<numshapes; i++ ) {
         SwapWord( 4, &ids[i] );
-        msSetBit(status, ids[i], 1);
+        msAddShapeId(set, ids[i]);
       }
     } else {
       for(i=0; i<numshapes; i++)
-        msSetBit(status, ids[i], 1);
+        msAddShapeId(set, ids[i]);
     }
     free(ids);
   }
@@ -506,15 +516,366 @@ static void searchDiskTreeNode(SHPTreeHandle disktree, rectObj aoi, ms_bitarray
   if ( disktree->needswap ) SwapWord ( 4, &numsubnodes );
 
   for(i=0; i<numsubnodes; i++)
-    searchDiskTreeNode(disktree, aoi, status);
+    searchDiskTreeNode(disktree, aoi, set);
 
   return;
 }
 
-ms_bitarray msSearchDiskTree(char *filename, rectObj aoi, int debug)
+/* -------------------------------------------------------------------- */
+/*      Process wide cache of .qix files.                               */
+/*                                                                      */
+/*      Long running processes (FastCGI, mapscript) search the same     */
+/*      indexes over and over again. When a budget is configured        */
+/*      (MS_QIX_CACHE_SIZE environment variable, in bytes with an       */
+/*      optional K, M or G suffix) whole index files are kept in        */
+/*      memory, byte swapped to native order, and searched in place.    */
+/*      Entries are validated against the file's mtime and size on      */
+/*      every use and evicted least recently used first once the        */
+/*      budget is exceeded. The budget is process wide, so it is not    */
+/*      taken from a mapfile CONFIG which a URL can also set.           */
+/* -------------------------------------------------------------------- */
+
+#define MS_QIX_CACHE_MAXDEPTH 64 /* sanity limit when validating a file */
+
+typedef struct treeCacheEntryObj {
+  char *filename; /* as passed to msSearchDiskTree() */
+  char *path; /* the file actually read (.qix or .QIX) */
+  time_t mtime;
+  long filesize;
+
+  uchar *data; /* whole file, native byte order */
+  size_t size;
+  size_t root; /* offset of the root node */
+  ms_int32 nShapes;
+
+  int refcount; /* searches in progress, entry is freed once 0 if evicted */
+  int evicted;
+  struct treeCacheEntryObj *prev, *next; /* most recently used first */
+} treeCacheEntryObj;
+
+static treeCacheEntryObj *treeCacheHead = NULL, *treeCacheTail = NULL;
+static size_t treeCacheBytes = 0;
+static size_t treeCacheMaxBytes = 0;
+static int treeCacheConfigured = MS_FALSE;
+static long treeCacheHits = 0, treeCacheMisses = 0;
+
+static size_t parseCacheSize(const char *value)
+{
+  char *end;
+  double size = strtod(value, &end);
+
+  if(size <= 0) return 0;
+  if(*end == 'k' || *end == 'K') size *= 1024;
+  else if(*end == 'm' || *end == 'M') size *= 1024*1024;
+  else if(*end == 'g' || *end == 'G') size *= 1024.0*1024*1024;
+
+  return (size_t) size;
+}
+
+static void treeCacheUnlink(treeCacheEntryObj *entry)
+{
+  if(entry->prev) entry->prev->next = entry->next;
+  else treeCacheHead = entry->next;
+  if(entry->next) entry->next->prev = entry->prev;
+  else treeCacheTail = entry->prev;
+  entry->prev = entry->next = NULL;
+
+  treeCacheBytes -= entry->size;
+}
+
+static void treeCacheFreeEntry(treeCacheEntryObj *entry)
+{
+  msFree(entry->filename);
+  msFree(entry->path);
+  msFree(entry->data);
+  msFree(entry);
+}
+
+/* caller holds TLOCK_QIXCACHE */
+static void treeCacheEvict(treeCacheEntryObj *entry)
+{
+  treeCacheUnlink(entry);
+  entry->evicted = MS_TRUE;
+  if(entry->refcount == 0)
+    treeCacheFreeEntry(entry);
+}
+
+/* caller holds TLOCK_QIXCACHE */
+static void treeCacheTrim(size_t maxbytes)
+{
+  while(treeCacheTail && treeCacheBytes > maxbytes)
+    treeCacheEvict(treeCacheTail);
+}
+
+/*
+** Set the process wide .qix cache budget, "0" disables the cache and
+** releases everything it holds. For programs embedding MapServer, this
+** overrides MS_QIX_CACHE_SIZE.
+*/
+void msSetDiskTreeCacheSize(const char *value)
+{
+  msAcquireLock(TLOCK_QIXCACHE);
+  treeCacheMaxBytes = value ? parseCacheSize(value) : 0;
+  treeCacheConfigured = MS_TRUE;
+  treeCacheTrim(treeCacheMaxBytes);
+  msReleaseLock(TLOCK_QIXCACHE);
+}
+
+void msDiskTreeCacheCleanup(void)
+{
+  msAcquireLock(TLOCK_QIXCACHE);
+  treeCacheTrim(0);
+  treeCacheHits = treeCacheMisses = 0;
+  msReleaseLock(TLOCK_QIXCACHE);
+}
+
+/*
+** Walk one node of a cached file, checking that it lies within the
+** buffer and swapping it to native order if needed. Returns the offset
+** just past the node and its subnodes, or 0 if the file is damaged.
+*/
+static size_t prepareCachedTreeNode(uchar *data, size_t size, size_t pos, int needswap, ms_int32 nShapes, int depth)
+{
+  ms_int32 offset, numshapes, numsubnodes, id;
+  size_t end;
+  int i;
+
+  if(depth > MS_QIX_CACHE_MAXDEPTH || pos + 4 + sizeof(rectObj) + 4 > size)
+    return 0;
+
+  if(needswap) {
+    SwapWord(4, data+pos);
+    for(i=0; i<4; i++)
+      SwapWord(8, data+pos+4+i*8);
+    SwapWord(4, data+pos+4+sizeof(rectObj));
+  }
+  memcpy(&offset, data+pos, 4);
+  memcpy(&numshapes, data+pos+4+sizeof(rectObj), 4);
+  pos += 4 + sizeof(rectObj) + 4;
+
+  if(offset < 0 || numshapes < 0 || numshapes > nShapes ||
+      pos + (size_t)numshapes*4 + 4 + (size_t)offset > size)
+    return 0;
+  end = pos + (size_t)numshapes*4 + 4 + (size_t)offset;
+
+  for(i=0; i<numshapes; i++, pos+=4) {
+    if(needswap) SwapWord(4, data+pos);
+    memcpy(&id, data+pos, 4);
+    if(id < 0 || id >= nShapes) return 0;
+  }
+
+  if(needswap) SwapWord(4, data+pos);
+  memcpy(&numsubnodes, data+pos, 4);
+  pos += 4;
+  if(numsubnodes < 0 || numsubnodes > MAX_SUBNODES)
+    return 0;
+
+  for(i=0; i<numsubnodes; i++) {
+    pos = prepareCachedTreeNode(data, size, pos, needswap, nShapes, depth+1);
+    if(pos == 0) return 0;
+  }
+
+  return (pos == end) ? pos : 0;
+}
+
+/* same walk as searchDiskTreeNode(), on a validated native order buffer */
+static size_t searchCachedTreeNode(const uchar *data, size_t pos, rectObj aoi, shapeIdSetObj *set)
+{
+  int i;
+  ms_int32 offset, numshapes, numsubnodes, id;
+  rectObj rect;
+
+  memcpy(&offset, data+pos, 4);
+  memcpy(&rect, data+pos+4, sizeof(rectObj));
+  memcpy(&numshapes, data+pos+4+sizeof(rectObj), 4);
+  pos += 4 + sizeof(rectObj) + 4;
+
+  if(!msRectOverlap(&rect, &aoi)) /* skip rest of this node and sub-nodes */
+    return pos + numshapes*sizeof(ms_int32) + sizeof(ms_int32) + offset;
+
+  for(i=0; i<numshapes; i++, pos+=4) {
+    memcpy(&id, data+pos, 4);
+    msAddShapeId(set, id);
+  }
+
+  memcpy(&numsubnodes, data+pos, 4);
+  pos += 4;
+
+  for(i=0; i<numsubnodes; i++)
+    pos = searchCachedTreeNode(data, pos, aoi, set);
+
+  return pos;
+}
+
+/* locate the index file the way msSHPDiskTreeOpen() does, without opening it */
+static char *treeCacheStat(const char *filename, struct stat *sb)
+{
+  char *path;
+  int i;
+
+  path = (char *) msSmallMalloc(strlen(filename) + strlen(MS_INDEX_EXTENSION) + 1);
+  strcpy(path, filename);
+  for(i = strlen(path)-1; i > 0 && path[i] != '.' && path[i] != '/' && path[i] != '\\'; i--) {}
+  if(path[i] == '.')
+    path[i] = '\0';
+  i = strlen(path);
+
+  strcpy(path+i, MS_INDEX_EXTENSION);
+  if(stat(path, sb) == 0) return path;
+  strcpy(path+i, ".QIX");
+  if(stat(path, sb) == 0) return path;
+
+  msFree(path);
+  return NULL;
+}
+
+/* read and validate a whole index file, NULL if it can't be cached */
+static treeCacheEntryObj *treeCacheLoad(const char *filename, const char *path, struct stat *sb, int debug)
 {
   SHPTreeHandle disktree;
-  ms_bitarray status=NULL;
+  treeCacheEntryObj *entry;
+  long root;
+
+  if(sb->st_size <= 0 || (size_t) sb->st_size > treeCacheMaxBytes)
+    return NULL;
+
+  disktree = msSHPDiskTreeOpen(path, debug);
+  if(!disktree)
+    return NULL;
+
+  entry = (treeCacheEntryObj *) msSmallCalloc(1, sizeof(treeCacheEntryObj));
+  entry->size = (size_t) sb->st_size;
+  entry->data = (uchar *) malloc(entry->size);
+  root = ftell(disktree->fp);
+  entry->root = (size_t) root;
+  entry->nShapes = disktree->nShapes;
+
+  if(!entry->data || root <= 0 || fseek(disktree->fp, 0, SEEK_SET) != 0 ||
+      fread(entry->data, entry->size, 1, disktree->fp) != 1 ||
+      prepareCachedTreeNode(entry->data, entry->size, entry->root, disktree->needswap, disktree->nShapes, 0) == 0) {
+    if(debug)
+      msDebug("msSearchDiskTree(): not caching %s, unable to read or validate it.\n", path);
+    msSHPDiskTreeClose(disktree);
+    treeCacheFreeEntry(entry);
+    return NULL;
+  }
+  msSHPDiskTreeClose(disktree);
+
+  entry->filename = msStrdup(filename);
+  entry->path = msStrdup(path);
+  entry->mtime = sb->st_mtime;
+  entry->filesize = (long) sb->st_size;
+  return entry;
+}
+
+/*
+** Search through the cache. Returns MS_DONE if the cache can't serve the
+** request (disabled, file missing or not cacheable) and the caller should
+** read the file from disk.
+*/
+static int searchCachedDiskTree(char *filename, rectObj aoi, int debug, int numshapes, shapeIdSetObj *set)
+{
+  treeCacheEntryObj *entry, *loaded;
+  struct stat sb;
+  char *path;
+
+  msAcquireLock(TLOCK_QIXCACHE);
+  if(!treeCacheConfigured) {
+    const char *value = getenv("MS_QIX_CACHE_SIZE");
+    treeCacheMaxBytes = value ? parseCacheSize(value) : 0;
+    treeCacheConfigured = MS_TRUE;
+  }
+  if(treeCacheMaxBytes == 0) {
+    msReleaseLock(TLOCK_QIXCACHE);
+    return MS_DONE;
+  }
+  msReleaseLock(TLOCK_QIXCACHE);
+
+  path = treeCacheStat(filename, &sb);
+  if(!path)
+    return MS_DONE;
+
+  msAcquireLock(TLOCK_QIXCACHE);
+  for(entry=treeCacheHead; entry; entry=entry->next) {
+    if(strcmp(entry->filename, filename) == 0)
+      break;
+  }
+  if(entry && (entry->mtime != sb.st_mtime || entry->filesize != (long) sb.st_size || strcmp(entry->path, path) != 0)) {
+    if(debug) msDebug("msSearchDiskTree(): %s changed on disk, reloading.\n", path);
+    treeCacheEvict(entry);
+    entry = NULL;
+  }
+  if(entry) {
+    treeCacheUnlink(entry); /* move to the front */
+    treeCacheBytes += entry->size;
+    entry->next = treeCacheHead;
+    if(treeCacheHead) treeCacheHead->prev = entry;
+    treeCacheHead = entry;
+    if(!treeCacheTail) treeCacheTail = entry;
+    entry->refcount++;
+    treeCacheHits++;
+  } else
+    treeCacheMisses++;
+  msReleaseLock(TLOCK_QIXCACHE);
+
+  if(!entry) {
+    /* read outside of the lock, another thread may be loading the same file */
+    loaded = treeCacheLoad(filename, path, &sb, debug);
+    if(!loaded) {
+      msFree(path);
+      return MS_DONE;
+    }
+
+    msAcquireLock(TLOCK_QIXCACHE);
+    for(entry=treeCacheHead; entry; entry=entry->next) {
+      if(strcmp(entry->filename, filename) == 0) {
+        treeCacheEvict(entry);
+        break;
+      }
+    }
+    loaded->refcount++;
+    entry = loaded;
+    if(loaded->size > treeCacheMaxBytes) {
+      loaded->evicted = MS_TRUE; /* budget was lowered meanwhile, use it once */
+    } else {
+      treeCacheTrim(treeCacheMaxBytes - loaded->size);
+      loaded->next = treeCacheHead;
+      if(treeCacheHead) treeCacheHead->prev = loaded;
+      treeCacheHead = loaded;
+      if(!treeCacheTail) treeCacheTail = loaded;
+      treeCacheBytes += loaded->size;
+      if(debug)
+        msDebug("msSearchDiskTree(): cached %s (%ld bytes), cache holds %ld of %ld bytes.\n",
+                path, (long) loaded->size, (long) treeCacheBytes, (long) treeCacheMaxBytes);
+    }
+    msReleaseLock(TLOCK_QIXCACHE);
+  }
+  msFree(path);
+
+  msInitShapeIdSet(set, (numshapes < 0) ? entry->nShapes : numshapes);
+  searchCachedTreeNode(entry->data, entry->root, aoi, set);
+
+  msAcquireLock(TLOCK_QIXCACHE);
+  if(--entry->refcount == 0 && entry->evicted)
+    treeCacheFreeEntry(entry);
+  if(debug >= MS_DEBUGLEVEL_VV)
+    msDebug("msSearchDiskTree(): cache hits %ld, misses %ld.\n", treeCacheHits, treeCacheMisses);
+  msReleaseLock(TLOCK_QIXCACHE);
+
+  return MS_SUCCESS;
+}
+
+/*
+** Collects the ids of the shapes in index nodes overlapping aoi into set,
+** sized for numshapes shapes (the count stored in the index when -1). Returns
+** MS_FAILURE, leaving set empty, when there is no usable index.
+*/
+int msSearchDiskTreeIds(char *filename, rectObj aoi, int debug, int numshapes, shapeIdSetObj *set)
+{
+  SHPTreeHandle disktree;
+
+  if(searchCachedDiskTree(filename, aoi, debug, numshapes, set) != MS_DONE)
+    return MS_SUCCESS;
 
   disktree = msSHPDiskTreeOpen (filename, debug);
   if(!disktree) {
@@ -522,20 +883,25 @@ ms_bitarray msSearchDiskTree(char *filename, rectObj aoi, int debug)
     /* only set this error IF debugging is turned on, gets annoying otherwise */
     if(debug) msSetError(MS_NOTFOUND, "Unable to open spatial index for %s. In most cases you can safely ignore this message, otherwise check file names and permissions.", "msSearchDiskTree()", filename);
 
-    return(NULL);
-  }
-
-  status = msAllocBitArray(disktree->nShapes);
-  if(!status) {
-    msSetError(MS_MEMERR, NULL, "msSearchDiskTree()");
-    msSHPDiskTreeClose( disktree );
-    return(NULL);
+    msInitShapeIdSet(set, 0);
+    return MS_FAILURE;
   }
 
-  searchDiskTreeNode(disktree, aoi, status);
+  msInitShapeIdSet(set, (numshapes < 0) ? disktree->nShapes : numshapes);
+  searchDiskTreeNode(disktree, aoi, set);
 
   msSHPDiskTreeClose( disktree );
-  return(status);
+  return MS_SUCCESS;
+}
+
+ms_bitarray msSearchDiskTree(char *filename, rectObj aoi, int debug)
+{
+  shapeIdSetObj set;
+
+  if(msSearchDiskTreeIds(filename, aoi, debug, -1, &set) != MS_SUCCESS)
+    return(NULL);
+
+  return msShapeIdSetToBitArray(&set);
 }
 
 treeNodeObj *readTreeNode( SHPTreeHandle disktree )
@@ -621,14 +987,11 @@ static ms_int32 getSubNodeOffset(treeNodeObj *node)
 }
 
 
-static void writeTreeNode(SHPTreeHandle disktree, treeNodeObj *node)
+static void writeTreeNodeRecord(SHPTreeHandle disktree, treeNodeObj *node, ms_int32 offset)
 {
   int i,j;
-  ms_int32 offset;
   char *pabyRec = NULL;
 
-  offset = getSubNodeOffset(node);
-
   pabyRec = msSmallMalloc(sizeof(rectObj) + (3 * sizeof(ms_int32)) + (node->numshapes * sizeof(ms_int32)) );
 
   memcpy( pabyRec, &offset, 4);
@@ -651,6 +1014,13 @@ static void writeTreeNode(SHPTreeHandle disktree, treeNodeObj *node)
 
   fwrite( pabyRec, 44+j, 1, disktree->fp);
   free (pabyRec);
+}
+
+static void writeTreeNode(SHPTreeHandle disktree, treeNodeObj *node)
+{
+  int i;
+
+  writeTreeNodeRecord(disktree, node, getSubNodeOffset(node));
 
   for(i=0; i<node->numsubnodes; i++ ) {
     if(node->subnode[i])
@@ -662,7 +1032,8 @@ static void writeTreeNode(SHPTreeHandle disktree, treeNodeObj *node)
 
 }
 
-int msWriteTree(treeObj *tree, char *filename, int B_order)
+/* opens filename's .qix for writing and writes the header */
+static SHPTreeHandle treeCreateDiskTree(char *filename, int B_order, ms_int32 numshapes, ms_int32 maxdepth, const char *routine)
 {
   char    signature[3] = "SQT";
   char    version = 1;
@@ -675,7 +1046,7 @@ int msWriteTree(treeObj *tree, char *filename, int B_order)
 
 
   disktree = (SHPTreeHandle) malloc(sizeof(SHPTreeInfo));
-  MS_CHECK_ALLOC(disktree, sizeof(SHPTreeInfo), MS_FALSE);
+  MS_CHECK_ALLOC(disktree, sizeof(SHPTreeInfo), NULL);
 
   /* -------------------------------------------------------------------- */
   /*  Compute the base (layer) name.  If there is any extension     */
@@ -704,14 +1075,10 @@ int msWriteTree(treeObj *tree, char *filename, int B_order)
 
   if(!disktree->fp) {
     msFree(disktree);
-    msSetError(MS_IOERR, NULL, "msWriteTree()");
-    return(MS_FALSE);
+    msSetError(MS_IOERR, NULL, routine);
+    return(NULL);
   }
 
-
-  /* for efficiency, trim the tree */
-  msTreeTrim(tree);
-
   /* -------------------------------------------------------------------- */
   /*  Establish the byte order on this machine.         */
   /* -------------------------------------------------------------------- */
@@ -744,18 +1111,33 @@ int msWriteTree(treeObj *tree, char *filename, int B_order)
     fwrite( pabyBuf, 8, 1, disktree->fp );
   }
 
-  memcpy( pabyBuf, &tree->numshapes, 4 );
+  memcpy( pabyBuf, &numshapes, 4 );
   if( disktree->needswap ) SwapWord( 4, pabyBuf );
 
-  memcpy( pabyBuf+4, &tree->maxdepth, 4 );
+  memcpy( pabyBuf+4, &maxdepth, 4 );
   if( disktree->needswap ) SwapWord( 4, pabyBuf+4 );
 
   i = fwrite( pabyBuf, 8, 1, disktree->fp );
   if( !i ) {
     fprintf (stderr, "unable to write to index file ... exiting \n");
-    return (MS_FALSE);
+    msSHPDiskTreeClose( disktree );
+    return (NULL);
   }
 
+  return disktree;
+}
+
+int msWriteTree(treeObj *tree, char *filename, int B_order)
+{
+  SHPTreeHandle disktree;
+
+  disktree = treeCreateDiskTree(filename, B_order, tree->numshapes, tree->maxdepth, "msWriteTree()");
+  if(!disktree)
+    return(MS_FALSE);
+
+  /* for efficiency, trim the tree */
+  msTreeTrim(tree);
+
   writeTreeNode(disktree, tree->root);
 
   msSHPDiskTreeClose( disktree );
@@ -763,6 +1145,575 @@ int msWriteTree(treeObj *tree, char *filename, int B_order)
   return(MS_TRUE);
 }
 
+/* -------------------------------------------------------------------- */
+/*      msWriteShapefileTree() writes the same .qix as msCreateTree()   */
+/*      and msWriteTree() without holding the whole tree in memory on   */
+/*      a single thread. Where a shape lands only depends on its        */
+/*      bounds, so the top levels of the tree (the skeleton) are laid   */
+/*      out up front, every shape is routed to the deepest skeleton     */
+/*      node holding it and the subtrees under the skeleton leaves      */
+/*      (the cells) are built in parallel. When the shapes would take   */
+/*      more than maxmemory bytes, the routed bounds are sorted by cell */
+/*      in runs on a temporary file and merged back a batch of cells at */
+/*      a time, built cells being spooled to a second temporary file    */
+/*      until the skeleton above them is known.                         */
+/* -------------------------------------------------------------------- */
+#define TREE_BUILD_MAX_LEVELS 8 /* at most 4^8 cells */
+#define TREE_BUILD_CHUNK 65536 /* shapes whose bounds are read at once */
+#define TREE_BUILD_SHAPE_SIZE 64 /* about what a shape takes in an in-memory build */
+
+typedef struct {
+  ms_int32 cell;
+  ms_int32 id;
+  rectObj rect;
+} treeBuildRecord;
+
+typedef struct {
+  rectObj rect;
+  ms_int32 numshapes, maxshapes;
+  ms_int32 *ids;
+
+  /* set by treeSkeletonTrim() */
+  int trimmed, empty;
+  int cell; /* the cell this node stands for, -1 if none */
+  int numsubnodes;
+  int subnode[MAX_SUBNODES];
+  long size; /* bytes of the node and its subnodes on disk */
+} treeSkeletonNode;
+
+typedef struct {
+  rectObj rect;
+  int maxdepth;
+
+  /* count records from first on, following next if set */
+  treeBuildRecord *records;
+  ms_int32 *next;
+  ms_int32 first, last, count;
+
+  treeNodeObj *root; /* NULL once spooled */
+  int empty;
+  long offset, size; /* where the cell is spooled and its bytes on disk */
+} treeCellTask;
+
+typedef struct {
+  long offset; /* of the next record to read */
+  ms_int32 remaining; /* records left on file */
+  treeBuildRecord *records;
+  int numrecords, current;
+} treeBuildRun;
+
+static void treeBuildCell(void *task)
+{
+  treeCellTask *cell = (treeCellTask *) task;
+  ms_int32 i, r;
+
+  cell->root = treeNodeCreate(cell->rect);
+  for(i=0, r=cell->first; i<cell->count; i++) {
+    treeNodeAddShapeId(cell->root, cell->records[r].id, cell->records[r].rect, cell->maxdepth);
+    r = cell->next ? cell->next[r] : r+1;
+  }
+
+  cell->empty = treeNodeTrim(cell->root);
+  cell->size = sizeof(rectObj) + (cell->root->numshapes+3)*sizeof(ms_int32) + getSubNodeOffset(cell->root);
+}
+
+static void treeBuildCells(treeCellTask **tasks, int numtasks, int numthreads)
+{
+  msRunThreadTasks((void **) tasks, numtasks, treeBuildCell, numthreads);
+}
+
+/* the skeleton is a full quadtree numlevels deep, the subnodes of node n are 4n+1 to 4n+4 */
+static treeSkeletonNode *treeSkeletonCreate(rectObj bounds, int numlevels, int *numnodes)
+{
+  treeSkeletonNode *nodes;
+  rectObj half1, half2;
+  int i, n = 1;
+
+  for(i=0; i<numlevels; i++)
+    n = n*4 + 1;
+  *numnodes = n;
+
+  nodes = (treeSkeletonNode *) msSmallCalloc(n, sizeof(treeSkeletonNode));
+  nodes[0].rect = bounds;
+  for(i=0; 4*i+4 < n; i++) {
+    treeSplitBounds(&nodes[i].rect, &half1, &half2);
+    treeSplitBounds(&half1, &nodes[4*i+1].rect, &nodes[4*i+2].rect);
+    treeSplitBounds(&half2, &nodes[4*i+3].rect, &nodes[4*i+4].rect);
+  }
+
+  return nodes;
+}
+
+/* the node treeNodeAddShapeId() would leave rect in, or the cell under which it goes */
+static int treeSkeletonRoute(treeSkeletonNode *nodes, int numlevels, rectObj *rect)
+{
+  int level, i, n = 0;
+
+  for(level=0; level<numlevels; level++) {
+    for(i=1; i<=4; i++) {
+      if(msRectContained(rect, &nodes[4*n+i].rect))
+        break;
+    }
+    if(i > 4)
+      break;
+    n = 4*n + i;
+  }
+
+  return n;
+}
+
+static void treeSkeletonAddShapeId(treeSkeletonNode *node, ms_int32 id)
+{
+  if(node->numshapes == node->maxshapes) {
+    node->maxshapes = node->maxshapes ? node->maxshapes*2 : 16;
+    node->ids = (ms_int32 *) msSmallRealloc(node->ids, sizeof(ms_int32) * node->maxshapes);
+  }
+  node->ids[node->numshapes++] = id;
+}
+
+/* routes the bounds of shapes start to start+count-1, returning the number of cell records */
+static int treeRouteShapes(treeSkeletonNode *nodes, int numlevels, int firstcell, int start, int count,
+                           rectObj *bounds, uchar *valid, treeBuildRecord *records)
+{
+  int i, n, numrecords = 0;
+
+  for(i=0; i<count; i++) {
+    if(!valid[i])
+      continue;
+
+    n = treeSkeletonRoute(nodes, numlevels, &bounds[i]);
+    if(n < firstcell) {
+      treeSkeletonAddShapeId(&nodes[n], start+i);
+    } else {
+      records[numrecords].cell = n - firstcell;
+      records[numrecords].id = start+i;
+      records[numrecords].rect = bounds[i];
+      numrecords++;
+    }
+  }
+
+  return numrecords;
+}
+
+/* same as treeNodeTrim(), cells are already trimmed */
+static int treeSkeletonTrim(treeSkeletonNode *nodes, int n, int firstcell, treeCellTask *cells)
+{
+  treeSkeletonNode *node = &nodes[n], *sub;
+  int i;
+
+  if(node->trimmed)
+    return node->empty;
+  node->trimmed = MS_TRUE;
+
+  if(n >= firstcell) {
+    node->cell = n - firstcell;
+    node->size = cells[node->cell].size;
+    node->empty = cells[node->cell].empty;
+    return node->empty;
+  }
+
+  node->cell = -1;
+  node->numsubnodes = 4;
+  for(i=0; i<4; i++)
+    node->subnode[i] = 4*n + 1 + i;
+
+  for(i=0; i<node->numsubnodes; i++) {
+    if(treeSkeletonTrim(nodes, node->subnode[i], firstcell, cells)) {
+      node->subnode[i] = node->subnode[node->numsubnodes-1];
+      node->numsubnodes--;
+      i--;
+    }
+  }
+
+  if(node->numsubnodes == 1 && node->numshapes == 0) {
+    sub = &nodes[node->subnode[0]];
+    node->rect = sub->rect;
+    node->numshapes = sub->numshapes;
+    msFree(node->ids);
+    node->ids = sub->ids;
+    sub->ids = NULL;
+    node->cell = sub->cell;
+    node->numsubnodes = sub->numsubnodes;
+    for(i=0; i<sub->numsubnodes; i++)
+      node->subnode[i] = sub->subnode[i];
+    node->size = sub->size;
+    node->empty = sub->empty;
+    return node->empty;
+  }
+
+  node->size = sizeof(rectObj) + (node->numshapes+3)*sizeof(ms_int32);
+  for(i=0; i<node->numsubnodes; i++)
+    node->size += nodes[node->subnode[i]].size;
+  node->empty = (node->numsubnodes == 0 && node->numshapes == 0);
+  return node->empty;
+}
+
+static int treeCopySpool(FILE *spool, long offset, long size, FILE *fp)
+{
+  char buffer[65536];
+  size_t n;
+
+  if(fseek(spool, offset, SEEK_SET) != 0)
+    return MS_FAILURE;
+
+  while(size > 0) {
+    n = (size > (long) sizeof(buffer)) ? sizeof(buffer) : (size_t) size;
+    if(fread(buffer, 1, n, spool) != n || fwrite(buffer, 1, n, fp) != n)
+      return MS_FAILURE;
+    size -= n;
+  }
+
+  return MS_SUCCESS;
+}
+
+static int treeSkeletonWrite(SHPTreeHandle disktree, treeSkeletonNode *nodes, int n, treeCellTask *cells, FILE *spool)
+{
+  treeSkeletonNode *node = &nodes[n];
+  treeNodeObj record;
+  int i;
+
+  if(node->cell >= 0) {
+    treeCellTask *cell = &cells[node->cell];
+
+    if(cell->root) {
+      writeTreeNode(disktree, cell->root);
+      return MS_SUCCESS;
+    }
+    if(cell->size > 0)
+      return treeCopySpool(spool, cell->offset, cell->size, disktree->fp);
+    /* never built, only the root gets here */
+  }
+
+  record.rect = node->rect;
+  record.numshapes = node->numshapes;
+  record.ids = node->ids;
+  if(node->cell >= 0) {
+    record.numsubnodes = 0;
+    writeTreeNodeRecord(disktree, &record, 0);
+    return MS_SUCCESS;
+  }
+  record.numsubnodes = node->numsubnodes;
+  writeTreeNodeRecord(disktree, &record, node->size - (long) (sizeof(rectObj) + (node->numshapes+3)*sizeof(ms_int32)));
+
+  for(i=0; i<record.numsubnodes; i++) {
+    if(treeSkeletonWrite(disktree, nodes, node->subnode[i], cells, spool) != MS_SUCCESS)
+      return MS_FAILURE;
+  }
+
+  return MS_SUCCESS;
+}
+
+/* every cell record in memory, linked in id order per cell */
+static int treeBuildInMemory(shapefileObj *shapefile, treeSkeletonNode *nodes, int numlevels, int firstcell,
+                             treeCellTask *cells, int numcells, int numthreads)
+{
+  treeBuildRecord *records;
+  treeCellTask **tasks, *cell;
+  ms_int32 *next;
+  rectObj *bounds;
+  uchar *valid;
+  int start, count, i, n, numrecords = 0, numtasks = 0;
+
+  records = (treeBuildRecord *) msSmallMalloc(sizeof(treeBuildRecord) * MS_MAX(shapefile->numshapes, 1));
+  next = (ms_int32 *) msSmallMalloc(sizeof(ms_int32) * MS_MAX(shapefile->numshapes, 1));
+  bounds = (rectObj *) msSmallMalloc(sizeof(rectObj) * TREE_BUILD_CHUNK);
+  valid = (uchar *) msSmallMalloc(TREE_BUILD_CHUNK);
+
+  for(start=0; start<shapefile->numshapes; start+=count) {
+    count = MS_MIN(TREE_BUILD_CHUNK, shapefile->numshapes - start);
+    msSHPReadBoundsRange(shapefile->hSHP, start, count, bounds, valid);
+
+    n = treeRouteShapes(nodes, numlevels, firstcell, start, count, bounds, valid, records + numrecords);
+    for(i=numrecords; i<numrecords+n; i++) {
+      cell = &cells[records[i].cell];
+      if(cell->count == 0)
+        cell->first = i;
+      else
+        next[cell->last] = i;
+      cell->last = i;
+      cell->count++;
+    }
+    numrecords += n;
+  }
+  free(bounds);
+  free(valid);
+
+  tasks = (treeCellTask **) msSmallMalloc(sizeof(treeCellTask *) * numcells);
+  for(i=0; i<numcells; i++) {
+    if(cells[i].count > 0) {
+      cells[i].records = records;
+      cells[i].next = next;
+      tasks[numtasks++] = &cells[i];
+    }
+  }
+  treeBuildCells(tasks, numtasks, numthreads);
+
+  free(tasks);
+  free(records);
+  free(next);
+
+  return MS_SUCCESS;
+}
+
+static int treeBuildRecordCompare(const void *a, const void *b)
+{
+  const treeBuildRecord *ra = (const treeBuildRecord *) a, *rb = (const treeBuildRecord *) b;
+
+  if(ra->cell != rb->cell)
+    return (ra->cell < rb->cell) ? -1 : 1;
+  return (ra->id < rb->id) ? -1 : (ra->id > rb->id);
+}
+
+static int treeBuildRunFill(FILE *fp, treeBuildRun *run, int capacity)
+{
+  run->numrecords = MS_MIN(capacity, run->remaining);
+  run->current = 0;
+  if(run->numrecords == 0)
+    return MS_SUCCESS;
+
+  if(fseek(fp, run->offset, SEEK_SET) != 0 ||
+      fread(run->records, sizeof(treeBuildRecord), run->numrecords, fp) != (size_t) run->numrecords)
+    return MS_FAILURE;
+
+  run->offset += run->numrecords * sizeof(treeBuildRecord);
+  run->remaining -= run->numrecords;
+  return MS_SUCCESS;
+}
+
+/* min-heap of runs on their current record */
+static void treeBuildHeapDown(treeBuildRun *runs, int *heap, int numheap, int i)
+{
+  int child, top;
+
+  for(;;) {
+    top = i;
+    child = 2*i + 1;
+    if(child < numheap && treeBuildRecordCompare(&runs[heap[child]].records[runs[heap[child]].current],
+        &runs[heap[top]].records[runs[heap[top]].current]) < 0)
+      top = child;
+    child++;
+    if(child < numheap && treeBuildRecordCompare(&runs[heap[child]].records[runs[heap[child]].current],
+        &runs[heap[top]].records[runs[heap[top]].current]) < 0)
+      top = child;
+    if(top == i)
+      break;
+    child = heap[i];
+    heap[i] = heap[top];
+    heap[top] = child;
+    i = top;
+  }
+}
+
+/* builds the cells of a batch and spools them */
+static int treeBuildBatch(treeCellTask **batch, int numbatch, treeBuildRecord *records, int numthreads, SHPTreeHandle spooltree)
+{
+  int i;
+
+  for(i=0; i<numbatch; i++)
+    batch[i]->records = records;
+  treeBuildCells(batch, numbatch, numthreads);
+
+  for(i=0; i<numbatch; i++) {
+    batch[i]->offset = ftell(spooltree->fp);
+    writeTreeNode(spooltree, batch[i]->root);
+    destroyTreeNode(batch[i]->root);
+    batch[i]->root = NULL;
+  }
+
+  return ferror(spooltree->fp) ? MS_FAILURE : MS_SUCCESS;
+}
+
+/* cell records sorted in runs on a temporary file, cells built and spooled a batch at a time */
+static int treeBuildExternal(shapefileObj *shapefile, treeSkeletonNode *nodes, int numlevels, int firstcell,
+                             treeCellTask *cells, int numcells, int numthreads, size_t maxmemory,
+                             char needswap, FILE **spool)
+{
+  FILE *fp;
+  SHPTreeInfo spooltree;
+  treeBuildRecord *records, *record;
+  treeBuildRun *runs = NULL;
+  treeCellTask **batch;
+  rectObj *bounds;
+  uchar *valid;
+  int *heap, numheap, numruns = 0, numbatch = 0, numrecords = 0, capacity, start, count, i;
+  int status = MS_SUCCESS;
+
+  if((fp = tmpfile()) == NULL || (*spool = tmpfile()) == NULL) {
+    if(fp) fclose(fp);
+    msSetError(MS_IOERR, "Unable to create a temporary file.", "msWriteShapefileTree()");
+    return MS_FAILURE;
+  }
+
+  /* -------------------------------------------------------------------- */
+  /*      Route the shapes, writing sorted runs of cell records.          */
+  /* -------------------------------------------------------------------- */
+  capacity = (int) MS_MAX(TREE_BUILD_CHUNK, maxmemory / 2 / sizeof(treeBuildRecord));
+  records = (treeBuildRecord *) msSmallMalloc(sizeof(treeBuildRecord) * capacity);
+  bounds = (rectObj *) msSmallMalloc(sizeof(rectObj) * TREE_BUILD_CHUNK);
+  valid = (uchar *) msSmallMalloc(TREE_BUILD_CHUNK);
+
+  for(start=0; start<=shapefile->numshapes && status == MS_SUCCESS; start+=count) {
+    count = MS_MIN(TREE_BUILD_CHUNK, shapefile->numshapes - start);
+
+    if(numrecords + count > capacity || (count == 0 && numrecords > 0)) {
+      qsort(records, numrecords, sizeof(treeBuildRecord), treeBuildRecordCompare);
+      runs = (treeBuildRun *) msSmallRealloc(runs, sizeof(treeBuildRun) * (numruns+1));
+      runs[numruns].offset = ftell(fp);
+      runs[numruns].remaining = numrecords;
+      runs[numruns].records = NULL;
+      numruns++;
+      if(fwrite(records, sizeof(treeBuildRecord), numrecords, fp) != (size_t) numrecords)
+        status = MS_FAILURE;
+      numrecords = 0;
+    }
+    if(count == 0)
+      break;
+
+    msSHPReadBoundsRange(shapefile->hSHP, start, count, bounds, valid);
+    numrecords += treeRouteShapes(nodes, numlevels, firstcell, start, count, bounds, valid, records + numrecords);
+  }
+  free(bounds);
+  free(valid);
+  free(records);
+
+  /* -------------------------------------------------------------------- */
+  /*      Merge the runs, building whole cells a batch at a time.         */
+  /* -------------------------------------------------------------------- */
+  spooltree.fp = *spool;
+  spooltree.needswap = needswap;
+
+  count = (int) MS_MAX(256, maxmemory / 4 / sizeof(treeBuildRecord) / MS_MAX(numruns, 1));
+  heap = (int *) msSmallMalloc(sizeof(int) * MS_MAX(numruns, 1));
+  numheap = 0;
+  for(i=0; i<numruns && status == MS_SUCCESS; i++) {
+    runs[i].records = (treeBuildRecord *) msSmallMalloc(sizeof(treeBuildRecord) * count);
+    status = treeBuildRunFill(fp, &runs[i], count);
+    if(runs[i].numrecords > 0)
+      heap[numheap++] = i;
+  }
+  for(i=numheap/2-1; i>=0; i--)
+    treeBuildHeapDown(runs, heap, numheap, i);
+
+  capacity = (int) MS_MAX(TREE_BUILD_CHUNK, maxmemory / 4 / sizeof(treeBuildRecord));
+  records = (treeBuildRecord *) msSmallMalloc(sizeof(treeBuildRecord) * capacity);
+  batch = (treeCellTask **) msSmallMalloc(sizeof(treeCellTask *) * numcells);
+  numrecords = 0;
+
+  while(numheap > 0 && status == MS_SUCCESS) {
+    treeBuildRun *run = &runs[heap[0]];
+    record = &run->records[run->current];
+
+    if(numbatch == 0 || batch[numbatch-1] != &cells[record->cell]) {
+      if(numrecords >= capacity) {
+        status = treeBuildBatch(batch, numbatch, records, numthreads, &spooltree);
+        numbatch = numrecords = 0;
+      }
+      batch[numbatch] = &cells[record->cell];
+      batch[numbatch]->first = numrecords;
+      numbatch++;
+    }
+
+    if(numrecords == capacity) { /* a cell larger than a batch */
+      capacity *= 2;
+      records = (treeBuildRecord *) msSmallRealloc(records, sizeof(treeBuildRecord) * capacity);
+    }
+    records[numrecords++] = *record;
+    batch[numbatch-1]->count++;
+
+    if(++run->current == run->numrecords) {
+      status = treeBuildRunFill(fp, run, count);
+      if(run->numrecords == 0)
+        heap[0] = heap[--numheap];
+    }
+    treeBuildHeapDown(runs, heap, numheap, 0);
+  }
+  if(numbatch > 0 && status == MS_SUCCESS)
+    status = treeBuildBatch(batch, numbatch, records, numthreads, &spooltree);
+
+  for(i=0; i<numruns; i++)
+    msFree(runs[i].records);
+  msFree(runs);
+  free(heap);
+  free(records);
+  free(batch);
+  fclose(fp);
+
+  if(status != MS_SUCCESS)
+    msSetError(MS_IOERR, "Unable to write a temporary file.", "msWriteShapefileTree()");
+  return status;
+}
+
+int msWriteShapefileTree(shapefileObj *shapefile, char *filename, int maxdepth, int B_order, int numthreads, size_t maxmemory)
+{
+  SHPTreeHandle disktree;
+  treeSkeletonNode *nodes;
+  treeCellTask *cells;
+  FILE *spool = NULL;
+  int numlevels, numnodes, numcells, firstcell, external, i, status;
+
+  if(!shapefile) return MS_FAILURE;
+
+  if(maxdepth == 0)
+    maxdepth = treeDefaultDepth(shapefile->numshapes);
+  if(numthreads < 1)
+    numthreads = 1;
+  external = (maxmemory > 0 && (double) shapefile->numshapes * TREE_BUILD_SHAPE_SIZE > maxmemory);
+
+  /* -------------------------------------------------------------------- */
+  /*      Enough cells to keep every thread busy and, sorting on disk,    */
+  /*      for a batch to hold a good number of them.                      */
+  /* -------------------------------------------------------------------- */
+  numlevels = 0;
+  numcells = 1;
+  while(numlevels < maxdepth-1 && numlevels < TREE_BUILD_MAX_LEVELS &&
+        (numcells < 16*numthreads ||
+         (external && (double) shapefile->numshapes * sizeof(treeBuildRecord) / numcells > maxmemory / 64))) {
+    numlevels++;
+    numcells *= 4;
+  }
+
+  nodes = treeSkeletonCreate(shapefile->bounds, numlevels, &numnodes);
+  firstcell = numnodes - numcells;
+  cells = (treeCellTask *) msSmallCalloc(numcells, sizeof(treeCellTask));
+  for(i=0; i<numcells; i++) {
+    cells[i].rect = nodes[firstcell+i].rect;
+    cells[i].maxdepth = maxdepth - numlevels;
+    cells[i].empty = MS_TRUE;
+  }
+
+  disktree = treeCreateDiskTree(filename, B_order, shapefile->numshapes, maxdepth, "msWriteShapefileTree()");
+  if(!disktree) {
+    status = MS_FAILURE;
+  } else {
+    if(external)
+      status = treeBuildExternal(shapefile, nodes, numlevels, firstcell, cells, numcells, numthreads, maxmemory, disktree->needswap, &spool);
+    else
+      status = treeBuildInMemory(shapefile, nodes, numlevels, firstcell, cells, numcells, numthreads);
+
+    if(status == MS_SUCCESS) {
+      treeSkeletonTrim(nodes, 0, firstcell, cells);
+      if(treeSkeletonWrite(disktree, nodes, 0, cells, spool) != MS_SUCCESS || ferror(disktree->fp)) {
+        msSetError(MS_IOERR, "Unable to write %s.", "msWriteShapefileTree()", filename);
+        status = MS_FAILURE;
+      }
+    }
+    msSHPDiskTreeClose(disktree);
+  }
+
+  for(i=0; i<numcells; i++) {
+    if(cells[i].root)
+      destroyTreeNode(cells[i].root);
+  }
+  for(i=0; i<numnodes; i++)
+    msFree(nodes[i].ids);
+  free(cells);
+  free(nodes);
+  if(spool)
+    fclose(spool);
+
+  return status;
+}
+
 /* Function to filter search results further against feature bboxes */
 void msFilterTreeSearch(shapefileObj *shp, ms_bitarray status, rectObj search_rect)
 {
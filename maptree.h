@@ -69,6 +69,39 @@ extern "C" {
   } SHPTreeInfo;
   typedef SHPTreeInfo * SHPTreeHandle;
 
+  /* packed Hilbert R-tree (.prt), see maprtree.c for the file layout */
+  typedef struct {
+    ms_int32 nodesize;
+    ms_int32 numitems; /* indexed shapes */
+    ms_int32 numshapes; /* records in the shapefile */
+    ms_int32 numnodes;
+    ms_int32 numlevels;
+    rectObj bounds;
+
+    ms_int32 *levelends; /* these point into data */
+    double *boxes;
+    ms_int32 *indices;
+
+    uchar *data;
+    size_t size;
+    int mapped;
+  } packedRTreeObj;
+
+  /* sorted attribute index (.aix), see mapattrindex.c for the file layout */
+  typedef struct {
+    FILE *fp;
+    char type; /* 'N' for numeric keys, 'C' for strings */
+    char needswap;
+    ms_int32 keysize;
+    ms_int32 numrecords; /* records in the .dbf */
+    ms_int32 numkeys;
+    ms_int32 dbfversion[3]; /* size (low, high) and mtime of the .dbf indexed */
+
+    int entrysize;
+    uchar *entry; /* last entry read */
+    int position; /* entry the file is positioned at, -1 if unknown */
+  } attributeIndexObj;
+
 #define MS_LSB_ORDER -1
 #define MS_MSB_ORDER -2
 #define MS_NATIVE_ORDER 0
@@ -86,12 +119,29 @@ extern "C" {
 
   MS_DLL_EXPORT ms_bitarray msSearchTree(treeObj *tree, rectObj aoi);
   MS_DLL_EXPORT ms_bitarray msSearchDiskTree(char *filename, rectObj aoi, int debug);
+  MS_DLL_EXPORT int msSearchDiskTreeIds(char *filename, rectObj aoi, int debug, int numshapes, shapeIdSetObj *set);
+  MS_DLL_EXPORT void msSetDiskTreeCacheSize(const char *value);
+  MS_DLL_EXPORT void msDiskTreeCacheCleanup(void);
 
   MS_DLL_EXPORT treeObj *msReadTree(char *filename, int debug);
   MS_DLL_EXPORT int msWriteTree(treeObj *tree, char *filename, int LSB_order);
+  MS_DLL_EXPORT int msWriteShapefileTree(shapefileObj *shapefile, char *filename, int maxdepth, int LSB_order, int numthreads, size_t maxmemory);
 
   MS_DLL_EXPORT void msFilterTreeSearch(shapefileObj *shp, ms_bitarray status, rectObj search_rect);
 
+  MS_DLL_EXPORT packedRTreeObj *msCreatePackedRTree(shapefileObj *shapefile, int nodesize);
+  MS_DLL_EXPORT int msWritePackedRTree(shapefileObj *shapefile, char *filename, int nodesize);
+  MS_DLL_EXPORT packedRTreeObj *msPackedRTreeOpen(const char *filename, int debug);
+  MS_DLL_EXPORT void msPackedRTreeClose(packedRTreeObj *tree);
+  MS_DLL_EXPORT ms_bitarray msSearchPackedRTree(packedRTreeObj *tree, rectObj aoi);
+  MS_DLL_EXPORT void msSearchPackedRTreeIds(packedRTreeObj *tree, rectObj aoi, shapeIdSetObj *set);
+  MS_DLL_EXPORT unsigned int msHilbertKey(rectObj *extent, rectObj *rect);
+
+  MS_DLL_EXPORT char *msAttributeIndexFilename(const char *basename, const char *item);
+  MS_DLL_EXPORT int msWriteAttributeIndex(DBFHandle hDBF, int item, char *filename);
+  MS_DLL_EXPORT attributeIndexObj *msAttributeIndexOpen(const char *filename, int debug);
+  MS_DLL_EXPORT void msAttributeIndexClose(attributeIndexObj *index);
+
 #ifdef __cplusplus
 }
 #endif
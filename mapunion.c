@@ -190,7 +190,7 @@ int msUnionLayerOpen(layerObj *layer)
   for(i=0; i < layerCount; i++) {
     int layerindex = msGetLayerIndex(map, layerNames[i]);
     if (layerindex >= 0 && layerindex < map->numlayers) {
-      layerObj* srclayer = map->layers[layerindex];
+      layerObj* srclayer = GET_LAYER(map, layerindex);
 
       if (srclayer->type != layer->type) {
         msSetError(MS_MISCERR, "The type of the source layer doesn't match with the union layer: %s", "msUnionLayerOpen()", srclayer->name);
@@ -450,8 +450,7 @@ static int BuildFeatureAttributes(layerObj *layer, layerObj* srclayer, shapeObj
       values[i] = msStrdup("");
   }
 
-  if (shape->values)
-    msFreeCharArray(shape->values, shape->numvalues);
+  msFreeShapeValues(shape);
 
   shape->values = values;
   shape->numvalues = layer->numitems;
@@ -32,6 +32,7 @@
  *****************************************************************************/
 
 #include <time.h>
+#include <ctype.h>
 
 #include "mapserver.h"
 #include "maptime.h"
@@ -54,8 +55,6 @@
 #endif
 
 
-extern char *msyystring_buffer;
-extern int msyylex_destroy(void);
 extern int yyparse(parseObj *);
 
 int msScaleInBounds(double scale, double minscale, double maxscale)
@@ -70,17 +69,19 @@ int msScaleInBounds(double scale, double minscale, double maxscale)
 /*
 ** Helper functions to convert from strings to other types or objects.
 */
-static int bindIntegerAttribute(int *attribute, char *value)
+static int bindIntegerAttribute(int *attribute, shapeObj *shape, int index)
 {
+  char *value = shape->values[index];
   if(!value || strlen(value) == 0) return MS_FAILURE;
-  *attribute = MS_NINT(atof(value)); /*use atof instead of atoi as a fix for bug 2394*/
+  *attribute = MS_NINT(msShapeGetNumericValue(shape, index)); /*use atof instead of atoi as a fix for bug 2394*/
   return MS_SUCCESS;
 }
 
-static int bindDoubleAttribute(double *attribute, char *value)
+static int bindDoubleAttribute(double *attribute, shapeObj *shape, int index)
 {
+  char *value = shape->values[index];
   if(!value || strlen(value) == 0) return MS_FAILURE;
-  *attribute = atof(value);
+  *attribute = msShapeGetNumericValue(shape, index);
   return MS_SUCCESS;
 }
 
@@ -139,15 +140,15 @@ static void bindStyle(layerObj *layer, shapeObj *shape, styleObj *style, int dra
     }
     if(style->bindings[MS_STYLE_BINDING_ANGLE].index != -1) {
       style->angle = 360.0;
-      bindDoubleAttribute(&style->angle, shape->values[style->bindings[MS_STYLE_BINDING_ANGLE].index]);
+      bindDoubleAttribute(&style->angle, shape, style->bindings[MS_STYLE_BINDING_ANGLE].index);
     }
     if(style->bindings[MS_STYLE_BINDING_SIZE].index != -1) {
       style->size = 1;
-      bindDoubleAttribute(&style->size, shape->values[style->bindings[MS_STYLE_BINDING_SIZE].index]);
+      bindDoubleAttribute(&style->size, shape, style->bindings[MS_STYLE_BINDING_SIZE].index);
     }
     if(style->bindings[MS_STYLE_BINDING_WIDTH].index != -1) {
       style->width = 1;
-      bindDoubleAttribute(&style->width, shape->values[style->bindings[MS_STYLE_BINDING_WIDTH].index]);
+      bindDoubleAttribute(&style->width, shape, style->bindings[MS_STYLE_BINDING_WIDTH].index);
     }
     if(style->bindings[MS_STYLE_BINDING_COLOR].index != -1 && !MS_DRAW_QUERY(drawmode)) {
       MS_INIT_COLOR(style->color, -1,-1,-1,255);
@@ -159,31 +160,31 @@ static void bindStyle(layerObj *layer, shapeObj *shape, styleObj *style, int dra
     }
     if(style->bindings[MS_STYLE_BINDING_OUTLINEWIDTH].index != -1) {
       style->outlinewidth = 1;
-      bindDoubleAttribute(&style->outlinewidth, shape->values[style->bindings[MS_STYLE_BINDING_OUTLINEWIDTH].index]);
+      bindDoubleAttribute(&style->outlinewidth, shape, style->bindings[MS_STYLE_BINDING_OUTLINEWIDTH].index);
     }
     if(style->bindings[MS_STYLE_BINDING_OPACITY].index != -1) {
       style->opacity = 100;
-      bindIntegerAttribute(&style->opacity, shape->values[style->bindings[MS_STYLE_BINDING_OPACITY].index]);
+      bindIntegerAttribute(&style->opacity, shape, style->bindings[MS_STYLE_BINDING_OPACITY].index);
     }
     if(style->bindings[MS_STYLE_BINDING_OFFSET_X].index != -1) {
       style->offsetx = 0;
-      bindDoubleAttribute(&style->offsetx, shape->values[style->bindings[MS_STYLE_BINDING_OFFSET_X].index]);
+      bindDoubleAttribute(&style->offsetx, shape, style->bindings[MS_STYLE_BINDING_OFFSET_X].index);
     }
     if(style->bindings[MS_STYLE_BINDING_OFFSET_Y].index != -1) {
       style->offsety = 0;
-      bindDoubleAttribute(&style->offsety, shape->values[style->bindings[MS_STYLE_BINDING_OFFSET_Y].index]);
+      bindDoubleAttribute(&style->offsety, shape, style->bindings[MS_STYLE_BINDING_OFFSET_Y].index);
     }
     if(style->bindings[MS_STYLE_BINDING_POLAROFFSET_PIXEL].index != -1) {
       style->polaroffsetpixel = 0;
-      bindDoubleAttribute(&style->polaroffsetpixel, shape->values[style->bindings[MS_STYLE_BINDING_POLAROFFSET_PIXEL].index]);
+      bindDoubleAttribute(&style->polaroffsetpixel, shape, style->bindings[MS_STYLE_BINDING_POLAROFFSET_PIXEL].index);
     }
     if(style->bindings[MS_STYLE_BINDING_POLAROFFSET_ANGLE].index != -1) {
       style->polaroffsetangle = 0;
-      bindDoubleAttribute(&style->polaroffsetangle, shape->values[style->bindings[MS_STYLE_BINDING_POLAROFFSET_ANGLE].index]);
+      bindDoubleAttribute(&style->polaroffsetangle, shape, style->bindings[MS_STYLE_BINDING_POLAROFFSET_ANGLE].index);
     }
     if(style->bindings[MS_STYLE_BINDING_OUTLINEWIDTH].index != -1) {
       style->outlinewidth = 1;
-      bindDoubleAttribute(&style->outlinewidth, shape->values[style->bindings[MS_STYLE_BINDING_OUTLINEWIDTH].index]);
+      bindDoubleAttribute(&style->outlinewidth, shape, style->bindings[MS_STYLE_BINDING_OUTLINEWIDTH].index);
     }
     if(style->opacity < 100 || style->color.alpha != 255 ) {
       int alpha;
@@ -211,12 +212,12 @@ static void bindLabel(layerObj *layer, shapeObj *shape, labelObj *label, int dra
   if(label->numbindings > 0) {
     if(label->bindings[MS_LABEL_BINDING_ANGLE].index != -1) {
       label->angle = 0.0;
-      bindDoubleAttribute(&label->angle, shape->values[label->bindings[MS_LABEL_BINDING_ANGLE].index]);
+      bindDoubleAttribute(&label->angle, shape, label->bindings[MS_LABEL_BINDING_ANGLE].index);
     }
 
     if(label->bindings[MS_LABEL_BINDING_SIZE].index != -1) {
       label->size = 1;
-      bindDoubleAttribute(&label->size, shape->values[label->bindings[MS_LABEL_BINDING_SIZE].index]);
+      bindDoubleAttribute(&label->size, shape, label->bindings[MS_LABEL_BINDING_SIZE].index);
     }
 
     if(label->bindings[MS_LABEL_BINDING_COLOR].index != -1) {
@@ -236,21 +237,21 @@ static void bindLabel(layerObj *layer, shapeObj *shape, labelObj *label, int dra
 
     if(label->bindings[MS_LABEL_BINDING_PRIORITY].index != -1) {
       label->priority = MS_DEFAULT_LABEL_PRIORITY;
-      bindIntegerAttribute(&label->priority, shape->values[label->bindings[MS_LABEL_BINDING_PRIORITY].index]);
+      bindIntegerAttribute(&label->priority, shape, label->bindings[MS_LABEL_BINDING_PRIORITY].index);
     }
 
     if(label->bindings[MS_LABEL_BINDING_SHADOWSIZEX].index != -1) {
       label->shadowsizex = 1;
-      bindIntegerAttribute(&label->shadowsizex, shape->values[label->bindings[MS_LABEL_BINDING_SHADOWSIZEX].index]);
+      bindIntegerAttribute(&label->shadowsizex, shape, label->bindings[MS_LABEL_BINDING_SHADOWSIZEX].index);
     }
     if(label->bindings[MS_LABEL_BINDING_SHADOWSIZEY].index != -1) {
       label->shadowsizey = 1;
-      bindIntegerAttribute(&label->shadowsizey, shape->values[label->bindings[MS_LABEL_BINDING_SHADOWSIZEY].index]);
+      bindIntegerAttribute(&label->shadowsizey, shape, label->bindings[MS_LABEL_BINDING_SHADOWSIZEY].index);
     }
 
     if(label->bindings[MS_LABEL_BINDING_POSITION].index != -1) {
       int tmpPosition;
-      bindIntegerAttribute(&tmpPosition, shape->values[label->bindings[MS_LABEL_BINDING_POSITION].index]);
+      bindIntegerAttribute(&tmpPosition, shape, label->bindings[MS_LABEL_BINDING_POSITION].index);
       if(tmpPosition != 0) { /* is this test sufficient? */
         label->position = tmpPosition;
       } else { /* Integer binding failed, look for strings like cc, ul, lr, etc... */
@@ -339,9 +340,9 @@ static int searchContextForTag(mapObj *map, char **ltags, char *tag, char *conte
   for(i=0; i<map->numlayers; i++) {
     if(strstr(context, ltags[i]) != NULL) { /* need to check this layer */
       if(requires == MS_TRUE) {
-        if(searchContextForTag(map, ltags, tag, GET_LAYER(map, i)->requires, MS_TRUE) == MS_SUCCESS) return MS_SUCCESS;
+        if(searchContextForTag(map, ltags, tag, map->layers[i]->requires, MS_TRUE) == MS_SUCCESS) return MS_SUCCESS;
       } else {
-        if(searchContextForTag(map, ltags, tag, GET_LAYER(map, i)->labelrequires, MS_FALSE) == MS_SUCCESS) return MS_SUCCESS;
+        if(searchContextForTag(map, ltags, tag, map->layers[i]->labelrequires, MS_FALSE) == MS_SUCCESS) return MS_SUCCESS;
       }
     }
   }
@@ -362,28 +363,28 @@ int msValidateContexts(mapObj *map)
 
   ltags = (char **) msSmallMalloc(map->numlayers*sizeof(char *));
   for(i=0; i<map->numlayers; i++) {
-    if(GET_LAYER(map, i)->name == NULL) {
+    if(map->layers[i]->name == NULL) {
       ltags[i] = msStrdup("[NULL]");
     } else {
-      ltags[i] = (char *) msSmallMalloc(sizeof(char)*strlen(GET_LAYER(map, i)->name) + 3);
-      sprintf(ltags[i], "[%s]", GET_LAYER(map, i)->name);
+      ltags[i] = (char *) msSmallMalloc(sizeof(char)*strlen(map->layers[i]->name) + 3);
+      sprintf(ltags[i], "[%s]", map->layers[i]->name);
     }
   }
 
   /* check each layer's REQUIRES and LABELREQUIRES parameters */
   for(i=0; i<map->numlayers; i++) {
-    /* printf("working on layer %s, looking for references to %s\n", GET_LAYER(map, i)->name, ltags[i]); */
-    if(searchContextForTag(map, ltags, ltags[i], GET_LAYER(map, i)->requires, MS_TRUE) == MS_SUCCESS) {
-      msSetError(MS_PARSEERR, "Recursion error found for REQUIRES parameter for layer %s.", "msValidateContexts", GET_LAYER(map, i)->name);
+    /* printf("working on layer %s, looking for references to %s\n", map->layers[i]->name, ltags[i]); */
+    if(searchContextForTag(map, ltags, ltags[i], map->layers[i]->requires, MS_TRUE) == MS_SUCCESS) {
+      msSetError(MS_PARSEERR, "Recursion error found for REQUIRES parameter for layer %s.", "msValidateContexts", map->layers[i]->name);
       status = MS_FAILURE;
       break;
     }
-    if(searchContextForTag(map, ltags, ltags[i], GET_LAYER(map, i)->labelrequires, MS_FALSE) == MS_SUCCESS) {
-      msSetError(MS_PARSEERR, "Recursion error found for LABELREQUIRES parameter for layer %s.", "msValidateContexts", GET_LAYER(map, i)->name);
+    if(searchContextForTag(map, ltags, ltags[i], map->layers[i]->labelrequires, MS_FALSE) == MS_SUCCESS) {
+      msSetError(MS_PARSEERR, "Recursion error found for LABELREQUIRES parameter for layer %s.", "msValidateContexts", map->layers[i]->name);
       status = MS_FAILURE;
       break;
     }
-    /* printf("done layer %s\n", GET_LAYER(map, i)->name); */
+    /* printf("done layer %s\n", map->layers[i]->name); */
   }
 
   /* clean up */
@@ -410,13 +411,13 @@ int msEvalContext(mapObj *map, layerObj *layer, char *context)
 
   for(i=0; i<map->numlayers; i++) { /* step through all the layers */
     if(layer->index == i) continue; /* skip the layer in question */
-    if (GET_LAYER(map, i)->name == NULL) continue; /* Layer without name cannot be used in contexts */
+    if (map->layers[i]->name == NULL) continue; /* Layer without name cannot be used in contexts */
 
-    tag = (char *)msSmallMalloc(sizeof(char)*strlen(GET_LAYER(map, i)->name) + 3);
-    sprintf(tag, "[%s]", GET_LAYER(map, i)->name);
+    tag = (char *)msSmallMalloc(sizeof(char)*strlen(map->layers[i]->name) + 3);
+    sprintf(tag, "[%s]", map->layers[i]->name);
 
     if(strstr(e.string, tag)) {
-      if(msLayerIsVisible(map, (GET_LAYER(map, i))))
+      if(!MS_LAZY_LAYER_OFF(map, i) && msLayerIsVisible(map, (GET_LAYER(map, i))))
         e.string = msReplaceSubstring(e.string, tag, "1");
       else
         e.string = msReplaceSubstring(e.string, tag, "0");
@@ -432,7 +433,7 @@ int msEvalContext(mapObj *map, layerObj *layer, char *context)
   p.expr->curtoken = p.expr->tokens; /* reset */
   p.type = MS_PARSE_TYPE_BOOLEAN;
 
-  status = yyparse(&p);
+  status = yyparse(&p); /* one-shot expression, not worth compiling */
 
   freeExpression(&e);
 
@@ -483,9 +484,10 @@ int msEvalExpression(layerObj *layer, shapeObj *shape, expressionObj *expression
       }
       {
         char *start,*end;
+        size_t length = strlen(shape->values[itemindex]);
         start = expression->string;
         while((end = strchr(start,',')) != NULL) {
-          if(!strncmp(start,shape->values[itemindex],end-start)) return MS_TRUE;
+          if((size_t)(end-start) == length && !strncmp(start,shape->values[itemindex],end-start)) return MS_TRUE;
           start = end+1;
         }
         if(!strcmp(start,shape->values[itemindex])) return MS_TRUE;
@@ -500,7 +502,7 @@ int msEvalExpression(layerObj *layer, shapeObj *shape, expressionObj *expression
       p.expr->curtoken = p.expr->tokens; /* reset */
       p.type = MS_PARSE_TYPE_BOOLEAN;
 
-      status = yyparse(&p);
+      status = msExecuteExpression(&p);
 
       if (status != 0) {
         msSetError(MS_PARSEERR, "Failed to parse expression: %s", "msEvalExpression", expression->string);
@@ -571,6 +573,223 @@ int *msAllocateValidClassGroups(layerObj *lp, int *nclasses)
 
 }
 
+/*
+** Hashed class lookup. When many classes of a layer compare CLASSITEM against
+** a plain string or list (EXPRESSION "value" or {value1,value2}), the attribute
+** value of a shape is looked up in a table giving, in class order, the classes
+** that may match. Classes that cannot be hashed (regex, logical expressions,
+** no expression) are kept aside and still tested in order so that the first
+** match wins exactly as with the linear scan in msShapeGetClass().
+*/
+#define MS_CLASSLOOKUP_MINCLASSES 8
+
+typedef struct {
+  char *key; /* CLASSITEM value, keys are compared case insensitively */
+  unsigned int hash;
+  int *classes; /* ascending class indexes */
+  int numclasses;
+} classLookupEntryObj;
+
+struct classLookupObj {
+  classLookupEntryObj *entries; /* open addressing, size is a power of 2 */
+  int size;
+  int *others; /* ascending indexes of classes that cannot be hashed */
+  int numothers;
+  int numclasses; /* layer->numclasses when the table was built */
+  int numlookups; /* number of shapes classified through the table */
+};
+
+static unsigned int classLookupHash(const char *key)
+{
+  unsigned int hash = 2166136261u;
+  for(; *key; key++)
+    hash = (hash ^ (unsigned char) tolower((unsigned char) *key)) * 16777619u;
+  return hash;
+}
+
+static classLookupEntryObj *classLookupFind(classLookupObj *lookup, const char *key, unsigned int hash)
+{
+  classLookupEntryObj *entry;
+  unsigned int i = hash & (lookup->size-1);
+
+  for(;;) { /* the table is never full */
+    entry = &(lookup->entries[i]);
+    if(!entry->key || (entry->hash == hash && strcasecmp(entry->key, key) == 0))
+      return entry;
+    i = (i+1) & (lookup->size-1);
+  }
+}
+
+static void classLookupAdd(classLookupObj *lookup, const char *key, int length, int iclass)
+{
+  classLookupEntryObj *entry;
+  char *tmpkey;
+  unsigned int hash;
+
+  tmpkey = (char *) msSmallMalloc(length+1);
+  strncpy(tmpkey, key, length);
+  tmpkey[length] = '\0';
+  hash = classLookupHash(tmpkey);
+
+  entry = classLookupFind(lookup, tmpkey, hash);
+  if(!entry->key) {
+    entry->key = tmpkey;
+    entry->hash = hash;
+  } else {
+    msFree(tmpkey);
+    if(entry->classes[entry->numclasses-1] == iclass) return; /* duplicate list item */
+  }
+
+  entry->classes = (int *) msSmallRealloc(entry->classes, sizeof(int)*(entry->numclasses+1));
+  entry->classes[entry->numclasses++] = iclass;
+}
+
+void msLayerFreeClassLookup(layerObj *layer)
+{
+  int i;
+  classLookupObj *lookup = layer->classlookup;
+
+  if(!lookup) return;
+
+  if(layer->debug >= MS_DEBUGLEVEL_V)
+    msDebug("msLayerFreeClassLookup(): layer %s classified %d shape(s) through the class lookup table.\n", layer->name?layer->name:"(null)", lookup->numlookups);
+
+  for(i=0; i<lookup->size; i++) {
+    msFree(lookup->entries[i].key);
+    msFree(lookup->entries[i].classes);
+  }
+  msFree(lookup->entries);
+  msFree(lookup->others);
+  msFree(lookup);
+  layer->classlookup = NULL;
+}
+
+/*
+** Builds layer->classlookup if enough of the classes are simple CLASSITEM
+** comparisons. Needs layer->classitemindex, so call after the items are set.
+*/
+int msLayerBuildClassLookup(layerObj *layer)
+{
+  int i, numkeys=0, numhashed=0;
+  classLookupObj *lookup;
+  expressionObj *e;
+
+  msLayerFreeClassLookup(layer);
+
+  if(layer->classitemindex < 0 || layer->numclasses < MS_CLASSLOOKUP_MINCLASSES) return MS_SUCCESS;
+
+  for(i=0; i<layer->numclasses; i++) {
+    e = &(layer->class[i]->expression);
+    if(!e->string) continue;
+    if(e->type == MS_STRING) {
+      numhashed++;
+      numkeys++;
+    } else if(e->type == MS_LIST) {
+      numhashed++;
+      numkeys += msCountChars(e->string, ',') + 1;
+    }
+  }
+  if(numhashed < MS_CLASSLOOKUP_MINCLASSES) return MS_SUCCESS;
+
+  lookup = (classLookupObj *) msSmallCalloc(1, sizeof(classLookupObj));
+  lookup->size = 16;
+  while(lookup->size < numkeys*2) lookup->size *= 2;
+  lookup->entries = (classLookupEntryObj *) msSmallCalloc(lookup->size, sizeof(classLookupEntryObj));
+  lookup->others = (int *) msSmallMalloc(sizeof(int)*layer->numclasses);
+  lookup->numclasses = layer->numclasses;
+
+  for(i=0; i<layer->numclasses; i++) {
+    e = &(layer->class[i]->expression);
+    if(e->string && e->type == MS_STRING) {
+      classLookupAdd(lookup, e->string, strlen(e->string), i);
+    } else if(e->string && e->type == MS_LIST) {
+      char *start = e->string, *end;
+      while((end = strchr(start, ',')) != NULL) {
+        classLookupAdd(lookup, start, end-start, i);
+        start = end+1;
+      }
+      classLookupAdd(lookup, start, strlen(start), i);
+    } else {
+      lookup->others[lookup->numothers++] = i;
+    }
+  }
+
+  layer->classlookup = lookup;
+
+  if(layer->debug >= MS_DEBUGLEVEL_V)
+    msDebug("msLayerBuildClassLookup(): layer %s uses a class lookup table on %s for %d of %d classes.\n", layer->name?layer->name:"(null)", layer->classitem, numhashed, layer->numclasses);
+
+  return MS_SUCCESS;
+}
+
+static int msClassMatchesShape(layerObj *layer, mapObj *map, shapeObj *shape, int iclass)
+{
+  if(map->scaledenom > 0) { /* verify scaledenom here  */
+    if((layer->class[iclass]->maxscaledenom > 0) && (map->scaledenom > layer->class[iclass]->maxscaledenom))
+      return MS_FALSE; /* can skip this one, next class */
+    if((layer->class[iclass]->minscaledenom > 0) && (map->scaledenom <= layer->class[iclass]->minscaledenom))
+      return MS_FALSE; /* can skip this one, next class */
+  }
+
+  /* verify the minfeaturesize */
+  if ((shape->type == MS_SHAPE_LINE || shape->type == MS_SHAPE_POLYGON) && (layer->class[iclass]->minfeaturesize > 0)) {
+    double minfeaturesize = Pix2LayerGeoref(map, layer,
+                                            layer->class[iclass]->minfeaturesize);
+    if (msShapeCheckSize(shape, minfeaturesize) == MS_FALSE)
+      return MS_FALSE; /* skip this one, next class */
+  }
+
+  if(layer->class[iclass]->status != MS_DELETE && msEvalExpression(layer, shape, &(layer->class[iclass]->expression), layer->classitemindex) == MS_TRUE)
+    return MS_TRUE;
+
+  return MS_FALSE;
+}
+
+/* classgroup lists come from msAllocateValidClassGroups() and are in ascending order */
+static int classGroupContains(int *classgroup, int numclasses, int iclass)
+{
+  int lo=0, hi=numclasses-1, mid;
+
+  if(!classgroup) return MS_TRUE;
+
+  while(lo <= hi) {
+    mid = (lo+hi)/2;
+    if(classgroup[mid] == iclass) return MS_TRUE;
+    if(classgroup[mid] < iclass) lo = mid+1;
+    else hi = mid-1;
+  }
+  return MS_FALSE;
+}
+
+static int msShapeGetClassFromLookup(layerObj *layer, mapObj *map, shapeObj *shape, int *classgroup, int numclasses)
+{
+  classLookupObj *lookup = layer->classlookup;
+  classLookupEntryObj *entry;
+  const char *value = shape->values[layer->classitemindex];
+  int i, iclass = -1;
+
+  lookup->numlookups++;
+
+  entry = classLookupFind(lookup, value, classLookupHash(value));
+  if(entry->key) {
+    for(i=0; i<entry->numclasses; i++) {
+      if(classGroupContains(classgroup, numclasses, entry->classes[i]) && msClassMatchesShape(layer, map, shape, entry->classes[i])) {
+        iclass = entry->classes[i];
+        break;
+      }
+    }
+  }
+
+  /* classes that cannot be hashed still win if they come first */
+  for(i=0; i<lookup->numothers; i++) {
+    if(iclass != -1 && lookup->others[i] > iclass) break;
+    if(classGroupContains(classgroup, numclasses, lookup->others[i]) && msClassMatchesShape(layer, map, shape, lookup->others[i]))
+      return lookup->others[i];
+  }
+
+  return iclass;
+}
+
 int msShapeGetClass(layerObj *layer, mapObj *map, shapeObj *shape, int *classgroup, int numclasses)
 {
   int i, iclass;
@@ -579,6 +798,10 @@ int msShapeGetClass(layerObj *layer, mapObj *map, shapeObj *shape, int *classgro
     if (classgroup == NULL || numclasses <=0)
       numclasses = layer->numclasses;
 
+    if(layer->classlookup && layer->classlookup->numclasses == layer->numclasses && layer->classitemindex >= 0 &&
+        layer->classitemindex < layer->numitems && layer->classitemindex < shape->numvalues)
+      return msShapeGetClassFromLookup(layer, map, shape, classgroup, numclasses);
+
     for(i=0; i<numclasses; i++) {
       if (classgroup)
         iclass = classgroup[i];
@@ -588,22 +811,7 @@ int msShapeGetClass(layerObj *layer, mapObj *map, shapeObj *shape, int *classgro
       if (iclass < 0 || iclass >= layer->numclasses)
         continue; /* this should never happen but just in case */
 
-      if(map->scaledenom > 0) { /* verify scaledenom here  */
-        if((layer->class[iclass]->maxscaledenom > 0) && (map->scaledenom > layer->class[iclass]->maxscaledenom))
-          continue; /* can skip this one, next class */
-        if((layer->class[iclass]->minscaledenom > 0) && (map->scaledenom <= layer->class[iclass]->minscaledenom))
-          continue; /* can skip this one, next class */
-      }
-
-      /* verify the minfeaturesize */
-      if ((shape->type == MS_SHAPE_LINE || shape->type == MS_SHAPE_POLYGON) && (layer->class[iclass]->minfeaturesize > 0)) {
-        double minfeaturesize = Pix2LayerGeoref(map, layer,
-                                                layer->class[iclass]->minfeaturesize);
-        if (msShapeCheckSize(shape, minfeaturesize) == MS_FALSE)
-          continue; /* skip this one, next class */
-      }
-
-      if(layer->class[iclass]->status != MS_DELETE && msEvalExpression(layer, shape, &(layer->class[iclass]->expression), layer->classitemindex) == MS_TRUE)
+      if(msClassMatchesShape(layer, map, shape, iclass))
         return(iclass);
     }
   }
@@ -653,7 +861,7 @@ static char *evalTextExpression(expressionObj *expr, shapeObj *shape)
       p.expr->curtoken = p.expr->tokens; /* reset */
       p.type = MS_PARSE_TYPE_STRING;
 
-      status = yyparse(&p);
+      status = msExecuteExpression(&p);
 
       if (status != 0) {
         msSetError(MS_PARSEERR, "Failed to process text expression: %s", "evalTextExpression", expr->string);
@@ -1002,9 +1210,9 @@ int *msGetLayersIndexByGroup(mapObj *map, char *groupname, int *pnCount)
   aiIndex = (int *)msSmallMalloc(sizeof(int) * map->numlayers);
 
   for(i=0; i<map->numlayers; i++) {
-    if(!GET_LAYER(map, i)->group) /* skip it */
+    if(!map->layers[i]->group) /* skip it */
       continue;
-    if(strcmp(groupname, GET_LAYER(map, i)->group) == 0) {
+    if(strcmp(groupname, map->layers[i]->group) == 0) {
       aiIndex[iLayer] = i;
       iLayer++;
     }
@@ -1926,12 +2134,11 @@ void msCleanup(int signal)
 {
   msForceTmpFileBase( NULL );
   msConnPoolFinalCleanup();
-  /* Lexer string parsing variable */
-  if (msyystring_buffer != NULL) {
-    msFree(msyystring_buffer);
-    msyystring_buffer = NULL;
-  }
-  msyylex_destroy();
+  msDiskTreeCacheCleanup();
+  msShapefilePoolCleanup();
+  msMapCacheCleanup();
+  msCapabilitiesCacheCleanup();
+  msTextCacheCleanup();
 
 #ifdef USE_OGR
   msOGRCleanup();
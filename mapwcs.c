@@ -2237,7 +2237,7 @@ int msWCSDispatch(mapObj *map, cgiRequestObj *request, owsRequestObj *ows_reques
 
     /* check if all layer names are valid NCNames */
     for(i = 0; i < map->numlayers; ++i) {
-      if(!msWCSIsLayerSupported(map->layers[i]))
+      if(!msWCSIsLayerSupported(GET_LAYER(map, i)))
         continue;
 
       /* Check if each layers name is a valid NCName. */
@@ -412,7 +412,7 @@ int msWCSGetCapabilities11(mapObj *map, wcsParamsObj *params,
   /* -------------------------------------------------------------------- */
   identifier_list = msStrdup("");
   for(i=0; i<map->numlayers; i++) {
-    layerObj *layer = map->layers[i];
+    layerObj *layer = GET_LAYER(map, i);
     int       new_length;
 
     if(!msWCSIsLayerSupported(layer))
@@ -576,7 +576,7 @@ int msWCSGetCapabilities11(mapObj *map, wcsParamsObj *params,
                                 "Check wcs/ows_enable_request settings."));
     } else {
       for(i=0; i<map->numlayers; i++) {
-        layerObj *layer = map->layers[i];
+        layerObj *layer = GET_LAYER(map, i);
         int       status;
 
         if(!msWCSIsLayerSupported(layer))
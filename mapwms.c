@@ -373,9 +373,9 @@ void msWMSPrepareNestedGroups(mapObj* map, int nVersion, char*** nestedGroups, i
     numNestedGroups[i] = 0; /* default */
     isUsedInNestedGroup[i] = 0; /* default */
 
-    groups = msOWSLookupMetadata(&(GET_LAYER(map, i)->metadata), "MO", "layer_group");
+    groups = msOWSLookupMetadata(&(map->layers[i]->metadata), "MO", "layer_group");
     if ((groups != NULL) && (strlen(groups) != 0)) {
-      if (GET_LAYER(map, i)->group != NULL && strlen(GET_LAYER(map, i)->group) != 0) {
+      if (map->layers[i]->group != NULL && strlen(map->layers[i]->group) != 0) {
         errorMsg = "It is not allowed to set both the GROUP and WMS_LAYER_GROUP for a layer";
         msSetError(MS_WMSERR, errorMsg, "msWMSPrepareNestedGroups()", NULL);
         msIO_fprintf(stdout, "<!-- ERROR: %s -->\n", errorMsg);
@@ -395,7 +395,7 @@ void msWMSPrepareNestedGroups(mapObj* map, int nVersion, char*** nestedGroups, i
               continue;
 
             for (k=0; k<numNestedGroups[i]; k++) {
-              if ( GET_LAYER(map, j)->name && strcasecmp(GET_LAYER(map, j)->name, nestedGroups[i][k]) == 0 ) {
+              if ( map->layers[j]->name && strcasecmp(map->layers[j]->name, nestedGroups[i][k]) == 0 ) {
                 isUsedInNestedGroup[j] = 1;
                 break;
               }
@@ -907,8 +907,8 @@ int msWMSLoadGetMapParams(mapObj *map, int nVersion,
       for(j=0; j<map->numlayers; j++) {
         /* Keep only layers with status=DEFAULT by default */
         /* Layer with status DEFAULT is drawn first. */
-        if (GET_LAYER(map, j)->status != MS_DEFAULT)
-          GET_LAYER(map, j)->status = MS_OFF;
+        if (map->layers[j]->status != MS_DEFAULT)
+          map->layers[j]->status = MS_OFF;
         else {
           map->layerorder[nLayerOrder++] = j;
           layerOrder[j] = 1;
@@ -924,17 +924,17 @@ int msWMSLoadGetMapParams(mapObj *map, int nVersion,
         layerfound = 0;
         for (j=0; j<map->numlayers; j++) {
           /* Turn on selected layers only. */
-          if ( ((GET_LAYER(map, j)->name &&
-                 strcasecmp(GET_LAYER(map, j)->name, layers[k]) == 0) ||
+          if ( ((map->layers[j]->name &&
+                 strcasecmp(map->layers[j]->name, layers[k]) == 0) ||
                 (map->name && strcasecmp(map->name, layers[k]) == 0) ||
-                (GET_LAYER(map, j)->group && strcasecmp(GET_LAYER(map, j)->group, layers[k]) == 0) ||
+                (map->layers[j]->group && strcasecmp(map->layers[j]->group, layers[k]) == 0) ||
                 ((numNestedGroups[j] >0) && msStringInArray(layers[k], nestedGroups[j], numNestedGroups[j]))) &&
-               ((msIntegerInArray(GET_LAYER(map, j)->index, ows_request->enabled_layers, ows_request->numlayers))) ) {
-            if (GET_LAYER(map, j)->status != MS_DEFAULT) {
+               ((msIntegerInArray(map->layers[j]->index, ows_request->enabled_layers, ows_request->numlayers))) ) {
+            if (map->layers[j]->status != MS_DEFAULT) {
               if (layerOrder[j] == 0) {
                 map->layerorder[nLayerOrder++] = j;
                 layerOrder[j] = 1;
-                GET_LAYER(map, j)->status = MS_ON;
+                map->layers[j]->status = MS_ON;
               }
             }
             validlayers++;
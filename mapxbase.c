@@ -289,6 +289,7 @@ void  msDBFClose(DBFHandle psDBF)
   /* -------------------------------------------------------------------- */
   /*      Close, and free resources.                                      */
   /* -------------------------------------------------------------------- */
+  msSHPUnmapFile( psDBF->pabyMap, psDBF->nMapSize );
   fclose( psDBF->fp );
 
   if( psDBF->panFieldOffset != NULL ) {
@@ -489,6 +490,66 @@ int DBFIsValueNULL( const char* pszValue, char type )
   }
 }
 
+/************************************************************************/
+/*                             msDBFMapFile()                           */
+/*                                                                      */
+/*      Read records straight from a memory mapping of a read-only      */
+/*      .dbf instead of through fseek()/fread() into the current        */
+/*      record buffer.  The handle keeps using stdio on failure.        */
+/************************************************************************/
+int msDBFMapFile( DBFHandle psDBF )
+{
+  if( psDBF->pabyMap )
+    return MS_SUCCESS; /* already mapped */
+
+  psDBF->pabyMap = msSHPMapFile( psDBF->fp, &psDBF->nMapSize );
+  if( psDBF->pabyMap == NULL )
+    return MS_FAILURE;
+
+  /* the header must not promise more records than the file holds, nor */
+  /* fields reaching past the end of a record */
+  if( psDBF->nHeaderLength < 0 || psDBF->nRecords < 0 ||
+      psDBF->nMapSize < (size_t) psDBF->nHeaderLength + (size_t) psDBF->nRecordLength * (size_t) psDBF->nRecords ||
+      (psDBF->nFields > 0 &&
+       (unsigned int) (psDBF->panFieldOffset[psDBF->nFields-1] + psDBF->panFieldSize[psDBF->nFields-1]) > psDBF->nRecordLength) ) {
+    msSHPUnmapFile( psDBF->pabyMap, psDBF->nMapSize );
+    psDBF->pabyMap = NULL;
+    psDBF->nMapSize = 0;
+    return MS_FAILURE;
+  }
+
+  return MS_SUCCESS;
+}
+
+/************************************************************************/
+/*                            msDBFGetRecord()                          */
+/*                                                                      */
+/*      Return the raw bytes of a record, either from the mapping or    */
+/*      read into the current record buffer.                            */
+/************************************************************************/
+static uchar *msDBFGetRecord( DBFHandle psDBF, int hEntity )
+{
+  unsigned int nRecordOffset;
+
+  if( psDBF->pabyMap ) {
+    /* mapped files are read-only, simply point at the record */
+    return psDBF->pabyMap + psDBF->nHeaderLength + (size_t) psDBF->nRecordLength * hEntity;
+  }
+
+  if( psDBF->nCurrentRecord != hEntity ) {
+    flushRecord( psDBF );
+
+    nRecordOffset = psDBF->nRecordLength * hEntity + psDBF->nHeaderLength;
+
+    safe_fseek( psDBF->fp, nRecordOffset, 0 );
+    fread( psDBF->pszCurrentRecord, psDBF->nRecordLength, 1, psDBF->fp );
+
+    psDBF->nCurrentRecord = hEntity;
+  }
+
+  return (uchar *) psDBF->pszCurrentRecord;
+}
+
 /************************************************************************/
 /*                          msDBFReadAttribute()                        */
 /*                                                                      */
@@ -498,7 +559,6 @@ static char *msDBFReadAttribute(DBFHandle psDBF, int hEntity, int iField )
 
 {
   int         i;
-  unsigned int nRecordOffset;
   uchar *pabyRec;
   char  *pReturnField = NULL;
 
@@ -518,18 +578,7 @@ static char *msDBFReadAttribute(DBFHandle psDBF, int hEntity, int iField )
   /* -------------------------------------------------------------------- */
   /*  Have we read the record?              */
   /* -------------------------------------------------------------------- */
-  if( psDBF->nCurrentRecord != hEntity ) {
-    flushRecord( psDBF );
-
-    nRecordOffset = psDBF->nRecordLength * hEntity + psDBF->nHeaderLength;
-
-    safe_fseek( psDBF->fp, nRecordOffset, 0 );
-    fread( psDBF->pszCurrentRecord, psDBF->nRecordLength, 1, psDBF->fp );
-
-    psDBF->nCurrentRecord = hEntity;
-  }
-
-  pabyRec = (uchar *) psDBF->pszCurrentRecord;
+  pabyRec = msDBFGetRecord( psDBF, hEntity );
   /* DEBUG */
   /* printf("CurrentRecord(%c):%s\n", psDBF->pachFieldType[iField], pabyRec); */
 
@@ -903,3 +952,99 @@ char **msDBFGetValueList(DBFHandle dbffile, int record, int *itemindexes, int nu
 
   return(values);
 }
+
+/* NaN marks values that are not numbers, 0.0/0.0 is refused by some compilers */
+static double msDBFNotANumber(void)
+{
+  static double zero = 0.0;
+  return zero/zero;
+}
+
+void msDBFInitValues(dbfValuesObj *values)
+{
+  values->values = NULL;
+  values->numericvalues = NULL;
+  values->numvalues = values->maxvalues = 0;
+  values->buffer = NULL;
+  values->buffersize = 0;
+}
+
+/*
+** Decode the fields of a record listed in itemindexes into values. The
+** strings are trimmed like msDBFReadStringAttribute() does but written to a
+** buffer reused from one record to the next, so unlike msDBFGetValueList()
+** nothing is allocated per record. N and F fields are parsed as well.
+*/
+int msDBFReadValues(DBFHandle dbffile, int record, int *itemindexes, int numitems, dbfValuesObj *values)
+{
+  uchar *pabyRec;
+  char *src, *end, *field, *value;
+  char type;
+  double notanumber;
+  int i, size, length, buffersize=0;
+
+  if( record < 0 || record >= dbffile->nRecords ) {
+    msSetError(MS_DBFERR, "Invalid record number %d.", "msDBFReadValues()", record );
+    return(MS_FAILURE);
+  }
+
+  for(i=0; i<numitems; i++) {
+    if( itemindexes[i] < 0 || itemindexes[i] >= dbffile->nFields ) {
+      msSetError(MS_DBFERR, "Invalid field index %d.", "msDBFReadValues()", itemindexes[i] );
+      return(MS_FAILURE);
+    }
+    buffersize += dbffile->panFieldSize[itemindexes[i]] + 2; /* room for "0" even in empty fields */
+  }
+
+  if(numitems > values->maxvalues) {
+    values->values = (char **) msSmallRealloc(values->values, sizeof(char *)*numitems);
+    values->numericvalues = (double *) msSmallRealloc(values->numericvalues, sizeof(double)*numitems);
+    values->maxvalues = numitems;
+  }
+  if(buffersize > values->buffersize) {
+    values->buffer = (char *) msSmallRealloc(values->buffer, buffersize);
+    values->buffersize = buffersize;
+  }
+
+  pabyRec = msDBFGetRecord( dbffile, record );
+  notanumber = msDBFNotANumber();
+
+  field = values->buffer;
+  for(i=0; i<numitems; i++) {
+    size = dbffile->panFieldSize[itemindexes[i]];
+    type = dbffile->pachFieldType[itemindexes[i]];
+
+    /* copy up to the first NUL, as strncpy() would */
+    src = (char *) pabyRec + dbffile->panFieldOffset[itemindexes[i]];
+    end = memchr(src, '\0', size);
+    length = end ? end - src : size;
+    memcpy(field, src, length);
+
+    while(length > 0 && field[length-1] == ' ') length--; /* trim trailing blanks */
+    field[length] = '\0';
+
+    value = field;
+    if(type == 'N' || type == 'F' || type == 'D') {
+      while(*value == ' ') value++; /* skip leading blanks */
+      if(DBFIsValueNULL(value, type)) {
+        strcpy(field, "0");
+        value = field;
+      }
+    }
+
+    values->values[i] = value;
+    values->numericvalues[i] = (type == 'N' || type == 'F') ? atof(value) : notanumber;
+    field += size + 2;
+  }
+  values->numvalues = numitems;
+
+  return(MS_SUCCESS);
+}
+
+void msDBFFreeValues(dbfValuesObj *values)
+{
+  free(values->values);
+  free(values->numericvalues);
+  free(values->buffer);
+  msDBFInitValues(values);
+}
@@ -181,7 +181,7 @@ int main(int argc, char *argv[])
 
       if(strcmp(argv[i],"-d") == 0) { /* swap layer data */
         for(j=0; j<map->numlayers; j++) {
-          if(strcmp(GET_LAYER(map, j)->name, argv[i+1]) == 0) {
+          if(strcmp(map->layers[j]->name, argv[i+1]) == 0) {
             free(GET_LAYER(map, j)->data);
             GET_LAYER(map, j)->data = msStrdup(argv[i+2]);
             break;
@@ -217,7 +217,7 @@ int main(int argc, char *argv[])
         int got_layer = 0;
 
         for(j=0; j<map->numlayers; j++) {
-          if(strcmp(GET_LAYER(map, j)->name,layer_name) == 0 ) {
+          if(strcmp(map->layers[j]->name,layer_name) == 0 ) {
             GET_LAYER(map, j)->debug = debug_level;
             got_layer = 1;
           }
@@ -257,7 +257,7 @@ int main(int argc, char *argv[])
         for(j=0; j<num_layers; j++) { /* loop over -l */
           layer_found=0;
           for(k=0; k<map->numlayers; k++) {
-            if((GET_LAYER(map, k)->name && strcasecmp(GET_LAYER(map, k)->name, layers[j]) == 0) || (GET_LAYER(map, k)->group && strcasecmp(GET_LAYER(map, k)->group, layers[j]) == 0)) {
+            if((map->layers[k]->name && strcasecmp(map->layers[k]->name, layers[j]) == 0) || (map->layers[k]->group && strcasecmp(map->layers[k]->group, layers[j]) == 0)) {
               layer_found = 1;
               break;
             }
@@ -270,14 +270,14 @@ int main(int argc, char *argv[])
         }
 
         for(j=0; j<map->numlayers; j++) {
-          if(GET_LAYER(map, j)->status == MS_DEFAULT)
+          if(map->layers[j]->status == MS_DEFAULT)
             continue;
           else {
-            GET_LAYER(map, j)->status = MS_OFF;
+            map->layers[j]->status = MS_OFF;
             for(k=0; k<num_layers; k++) {
-              if((GET_LAYER(map, j)->name && strcasecmp(GET_LAYER(map, j)->name, layers[k]) == 0) ||
-                  (GET_LAYER(map, j)->group && strcasecmp(GET_LAYER(map, j)->group, layers[k]) == 0)) {
-                GET_LAYER(map, j)->status = MS_ON;
+              if((map->layers[j]->name && strcasecmp(map->layers[j]->name, layers[k]) == 0) ||
+                  (map->layers[j]->group && strcasecmp(map->layers[j]->group, layers[k]) == 0)) {
+                map->layers[j]->status = MS_ON;
                 break;
               }
             }
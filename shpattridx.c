@@ -0,0 +1,87 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  MapServer
+ * Purpose:  Commandline utility to generate .aix shapefile attribute
+ *           indexes.
+ * Author:   Steve Lime and the MapServer team.
+ *
+ ******************************************************************************
+ * Copyright (c) 1996-2005 Regents of the University of Minnesota.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies of this Software or works derived from this Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+
+#include "mapserver.h"
+#include "maptree.h"
+
+int main(int argc, char *argv[])
+{
+  shapefileObj shapefile;
+  char *basename, *filename, *s;
+  int i, item;
+
+  if(argc > 1 && strcmp(argv[1], "-v") == 0) {
+    printf("%s\n", msGetVersion());
+    exit(0);
+  }
+
+  if(argc < 3) {
+    fprintf(stdout,"Syntax:\n");
+    fprintf(stdout,"    shpattridx <shpfile> <item> [<item>...]\n" );
+    fprintf(stdout,"Where:\n");
+    fprintf(stdout," <shpfile> is the name of the .shp file to index.\n");
+    fprintf(stdout," <item>    is a column to index, one %s file is written\n", MS_ATTRIBUTE_INDEX_EXTENSION);
+    fprintf(stdout,"           per column. Layer filters comparing a column to\n");
+    fprintf(stdout,"           a value, a list of values (IN) or a range then\n");
+    fprintf(stdout,"           only look at the matching records.\n\n");
+    exit(0);
+  }
+
+  if(msShapefileOpen(&shapefile, "rb", argv[1], MS_TRUE) == -1) {
+    fprintf(stdout, "Error opening shapefile %s.\n", argv[1]);
+    exit(1);
+  }
+
+  /* name the indexes the way the shapefile layer looks them up */
+  basename = msStrdup(shapefile.source);
+  if((s = strstr(basename, ".shp")) != NULL || (s = strstr(basename, ".SHP")) != NULL)
+    *s = '\0';
+
+  for(i=2; i<argc; i++) {
+    if((item = msDBFGetItemIndex(shapefile.hDBF, argv[i])) == -1) {
+      msWriteError(stdout);
+      exit(1);
+    }
+
+    filename = msAttributeIndexFilename(basename, argv[i]);
+    printf("creating attribute index of %s on %s\n", argv[1], argv[i]);
+    if(msWriteAttributeIndex(shapefile.hDBF, item, filename) != MS_SUCCESS) {
+      msWriteError(stdout);
+      exit(1);
+    }
+    free(filename);
+  }
+
+  free(basename);
+  msShapefileClose(&shapefile);
+
+  return(0);
+}
@@ -0,0 +1,204 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  MapServer
+ * Purpose:  Commandline benchmark comparing stdio, memory mapped and
+ *           batched shapefile reads.
+ * Author:   Steve Lime and the MapServer team.
+ *
+ ******************************************************************************
+ * Copyright (c) 1996-2005 Regents of the University of Minnesota.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies of this Software or works derived from this Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "mapserver.h"
+#include "maptime.h"
+
+/*
+** Reads every shape (or a sorted pseudo random sample of them, like an
+** index search returns) with all of its attributes through stdio one
+** record at a time, through memory mappings, and through stdio in batches
+** with msSHPReadShapes(), and reports the time taken by each mode. A
+** checksum of the decoded data is printed so all modes can be seen to
+** read the same thing. Run it twice to compare warm cache numbers, which
+** is what a busy server sees.
+*/
+
+#define MODE_STDIO 0
+#define MODE_MMAP 1
+#define MODE_BATCH 2
+
+static const char *modeNames[] = { "stdio", "mmap", "batch" };
+
+typedef struct {
+  shapefileObj *shp;
+  int numfields;
+  double checksum;
+} benchObj;
+
+static double elapsed(struct mstimeval *start)
+{
+  struct mstimeval now;
+  msGettimeofday(&now, NULL);
+  return (now.tv_sec - start->tv_sec) + (now.tv_usec - start->tv_usec)/1000000.0;
+}
+
+/* read system calls issued so far, -1 where /proc/self/io is not available */
+static long readCalls(void)
+{
+  char line[128];
+  long count = -1;
+  FILE *fp = fopen("/proc/self/io", "r");
+
+  if(!fp) return -1;
+  while(fgets(line, sizeof(line), fp)) {
+    if(strncmp(line, "syscr:", 6) == 0) {
+      count = atol(line + 6);
+      break;
+    }
+  }
+  fclose(fp);
+  return count;
+}
+
+static int addShape(void *data, int record, shapeObj *shape)
+{
+  benchObj *bench = (benchObj *) data;
+  int j, k;
+
+  for(j=0; j<shape->numlines; j++)
+    for(k=0; k<shape->line[j].numpoints; k++)
+      bench->checksum += shape->line[j].point[k].x + shape->line[j].point[k].y;
+  msFreeShape(shape);
+
+  for(j=0; j<bench->numfields; j++)
+    bench->checksum += strlen(msDBFReadStringAttribute(bench->shp->hDBF, record, j));
+
+  return MS_SUCCESS;
+}
+
+static int run(char *filename, int mode, int *records, int n, double *checksum, double *seconds, long *reads)
+{
+  shapefileObj shp;
+  shapeObj shape;
+  struct mstimeval start;
+  benchObj bench;
+  int i, batch;
+
+  if(msShapefileOpen(&shp, "rb", filename, MS_TRUE) == -1)
+    return MS_FAILURE;
+
+  if(mode == MODE_MMAP && msShapefileMap(&shp) != MS_SUCCESS) {
+    fprintf(stderr, "Unable to map %s.\n", filename);
+    msShapefileClose(&shp);
+    return MS_FAILURE;
+  }
+
+  bench.shp = &shp;
+  bench.numfields = msDBFGetFieldCount(shp.hDBF);
+  bench.checksum = 0;
+
+  *reads = readCalls();
+  msGettimeofday(&start, NULL);
+  if(mode == MODE_BATCH) {
+    for(i=0; i<n; i+=batch) { /* same batch size as the shapefile layer */
+      batch = (n - i < 256) ? n - i : 256;
+      msSHPReadShapes(shp.hSHP, records + i, batch, addShape, &bench);
+    }
+  } else {
+    for(i=0; i<n; i++) {
+      msSHPReadShape(shp.hSHP, records[i], &shape);
+      addShape(&bench, records[i], &shape);
+    }
+  }
+  *seconds = elapsed(&start);
+  if(*reads >= 0) *reads = readCalls() - *reads;
+  *checksum = bench.checksum;
+
+  msShapefileClose(&shp);
+  return MS_SUCCESS;
+}
+
+static int compareRecords(const void *a, const void *b)
+{
+  return *((const int *) a) - *((const int *) b);
+}
+
+int main(int argc, char *argv[])
+{
+  double checksum[3], seconds[3];
+  long reads[3];
+  shapefileObj shp;
+  unsigned int seed = 12345;
+  int i, n, sample=0, *records;
+
+  if(argc > 1 && strcmp(argv[1], "-v") == 0) {
+    printf("%s\n", msGetVersion());
+    exit(0);
+  }
+
+  if(argc < 2) {
+    fprintf(stdout,"Syntax: shpbench [shapefile] [sample size]\n" );
+    fprintf(stdout,"Reads all shapes and attributes (or a random sample) through stdio, memory mappings and batched stdio reads.\n" );
+    exit(0);
+  }
+
+  if(argc > 2)
+    sample = atoi(argv[2]);
+
+  if(msShapefileOpen(&shp, "rb", argv[1], MS_TRUE) == -1) {
+    msWriteError(stderr);
+    exit(1);
+  }
+  n = (sample > 0 && sample < shp.numshapes) ? sample : shp.numshapes;
+  records = (int *) msSmallMalloc(sizeof(int) * (n > 0 ? n : 1));
+  for(i=0; i<n; i++) {
+    if(n == shp.numshapes)
+      records[i] = i;
+    else {
+      seed = seed * 1103515245 + 12345; /* repeatable across runs */
+      records[i] = (seed >> 8) % shp.numshapes;
+    }
+  }
+  qsort(records, n, sizeof(int), compareRecords);
+  msShapefileClose(&shp);
+
+  for(i=0; i<3; i++) {
+    if(run(argv[1], i, records, n, &checksum[i], &seconds[i], &reads[i]) != MS_SUCCESS) {
+      msWriteError(stderr);
+      exit(1);
+    }
+    printf("%-6s %10.3f s  checksum %.6f", modeNames[i], seconds[i], checksum[i]);
+    if(reads[i] >= 0) printf("  %ld reads", reads[i]);
+    printf("\n");
+  }
+  free(records);
+
+  if(checksum[0] != checksum[1] || checksum[0] != checksum[2]) {
+    printf("checksums differ!\n");
+    exit(1);
+  }
+  if(seconds[1] > 0)
+    printf("mmap speedup %.2fx\n", seconds[0]/seconds[1]);
+  if(seconds[2] > 0)
+    printf("batch speedup %.2fx\n", seconds[0]/seconds[2]);
+
+  return(0);
+}
@@ -0,0 +1,323 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  MapServer
+ * Purpose:  Commandline utility to write pre-generalized overviews of a
+ *           shapefile.
+ * Author:   Steve Lime and the MapServer team.
+ *
+ ******************************************************************************
+ * Copyright (c) 1996-2005 Regents of the University of Minnesota.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies of this Software or works derived from this Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "mapserver.h"
+#include "maptree.h"
+
+/*
+** Writes <shpfile>_ov1, <shpfile>_ov2, ... one per tolerance, with every
+** line and polygon simplified (Douglas-Peucker) by that tolerance and a
+** quadtree index each. Overviews hold the same records, in the same order,
+** as the shapefile, so queries, attribute indexes and the .dbf (copied as
+** is) stay valid for every level. Rings and lines that collapse are
+** dropped, except for the first part of a shape which is kept as small as
+** it gets.
+**
+** Shapefile layers pick a level from the map cellsize when given
+** PROCESSING "SHAPEFILE_OVERVIEWS=<tolerance>,<tolerance>,..."
+*/
+
+/* squared distance from p to the segment a-b */
+static double segmentDistance2(pointObj *p, pointObj *a, pointObj *b)
+{
+  double dx = b->x - a->x, dy = b->y - a->y, t;
+
+  if(dx == 0 && dy == 0)
+    return (p->x - a->x)*(p->x - a->x) + (p->y - a->y)*(p->y - a->y);
+
+  t = ((p->x - a->x)*dx + (p->y - a->y)*dy) / (dx*dx + dy*dy);
+  if(t < 0) t = 0;
+  else if(t > 1) t = 1;
+
+  dx = a->x + t*dx - p->x;
+  dy = a->y + t*dy - p->y;
+  return dx*dx + dy*dy;
+}
+
+/* index of the point of line between first and last farthest from segment a-b, -1 if none */
+static int farthestPoint(lineObj *line, int first, int last, pointObj *a, pointObj *b, double *dmax)
+{
+  int i, farthest = -1;
+  double d;
+
+  *dmax = 0;
+  for(i=first+1; i<last; i++) {
+    d = segmentDistance2(&line->point[i], a, b);
+    if(d > *dmax) {
+      *dmax = d;
+      farthest = i;
+    }
+  }
+
+  return farthest;
+}
+
+/*
+** Douglas-Peucker, in place, returns the number of points kept. With
+** minpoints set, a line simplified to fewer points keeps its extreme
+** points instead (so a small island still draws as a dot).
+*/
+static int simplifyLine(lineObj *line, double tolerance, int minpoints, char *keep, int *stack)
+{
+  int i, n, sp=0, first, last, farthest;
+  double dmax, tolerance2 = tolerance*tolerance;
+
+  if(line->numpoints < 3)
+    return line->numpoints;
+
+  memset(keep, 0, line->numpoints);
+  keep[0] = keep[line->numpoints-1] = 1;
+
+  stack[sp++] = 0;
+  stack[sp++] = line->numpoints-1;
+  while(sp > 0) {
+    last = stack[--sp];
+    first = stack[--sp];
+
+    farthest = farthestPoint(line, first, last, &line->point[first], &line->point[last], &dmax);
+    if(farthest != -1 && dmax > tolerance2) {
+      keep[farthest] = 1;
+      stack[sp++] = first;
+      stack[sp++] = farthest;
+      stack[sp++] = farthest;
+      stack[sp++] = last;
+    }
+  }
+
+  for(i=0, n=0; i<line->numpoints; i++)
+    n += keep[i];
+
+  if(n < minpoints && line->numpoints >= minpoints) { /* a ring: its first point, the farthest from it and the farthest from both */
+    memset(keep, 0, line->numpoints);
+    keep[0] = keep[line->numpoints-1] = 1;
+    farthest = farthestPoint(line, 0, line->numpoints-1, &line->point[0], &line->point[0], &dmax);
+    if(farthest == -1) farthest = 1;
+    keep[farthest] = 1;
+    i = farthestPoint(line, 0, line->numpoints-1, &line->point[0], &line->point[farthest], &dmax);
+    if(i == -1 || i == farthest) i = (farthest > 1) ? 1 : 2;
+    keep[i] = 1;
+  }
+
+  for(i=0, n=0; i<line->numpoints; i++)
+    if(keep[i])
+      line->point[n++] = line->point[i];
+  line->numpoints = n;
+
+  return n;
+}
+
+static char *buildFilename(const char *basename, int level, const char *extension)
+{
+  char *filename = (char *) msSmallMalloc(strlen(basename) + 32);
+
+  if(level > 0)
+    sprintf(filename, "%s_ov%d%s", basename, level, extension);
+  else
+    sprintf(filename, "%s%s", basename, extension);
+  return filename;
+}
+
+static int copyFile(const char *from, const char *to)
+{
+  FILE *in, *out;
+  char buffer[65536];
+  size_t n;
+  int status = MS_SUCCESS;
+
+  if((in = fopen(from, "rb")) == NULL)
+    return MS_FAILURE;
+  if((out = fopen(to, "wb")) == NULL) {
+    fclose(in);
+    return MS_FAILURE;
+  }
+
+  while((n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+    if(fwrite(buffer, 1, n, out) != n) {
+      status = MS_FAILURE;
+      break;
+    }
+  }
+
+  fclose(in);
+  if(fclose(out) != 0)
+    status = MS_FAILURE;
+  return status;
+}
+
+static int writeOverview(shapefileObj *shp, const char *basename, int level, double tolerance)
+{
+  SHPHandle outSHP;
+  shapefileObj overview;
+  shapeObj shape;
+  treeObj *tree;
+  char *filename, *dbfFilename, *keep = NULL;
+  int i, j, n, *stack = NULL, maxpoints = 0, minpoints, status;
+  long numin = 0, numout = 0;
+
+  filename = buildFilename(basename, level, "");
+  outSHP = msSHPCreate(filename, shp->type);
+  if(!outSHP) {
+    fprintf(stderr, "Failed to create file '%s'.\n", filename);
+    free(filename);
+    return MS_FAILURE;
+  }
+  free(filename);
+
+  minpoints = (shp->type == SHP_POLYGON || shp->type == SHP_POLYGONZ || shp->type == SHP_POLYGONM) ? 4 : 2;
+
+  msInitShape(&shape);
+  for(i=0; i<shp->numshapes; i++) {
+    msSHPReadShape(shp->hSHP, i, &shape);
+
+    for(j=0, n=0; j<shape.numlines; j++) {
+      lineObj *line = &shape.line[j];
+
+      numin += line->numpoints;
+      if(line->numpoints > maxpoints) {
+        maxpoints = line->numpoints;
+        keep = (char *) msSmallRealloc(keep, maxpoints);
+        stack = (int *) msSmallRealloc(stack, sizeof(int) * 2 * maxpoints);
+      }
+
+      /* the first part always stays, other rings and lines that collapse are dropped */
+      if(simplifyLine(line, tolerance, (j == 0) ? minpoints : 0, keep, stack) < minpoints && j > 0) {
+        free(line->point);
+        continue;
+      }
+      numout += line->numpoints;
+      shape.line[n++] = *line;
+    }
+    shape.numlines = n;
+
+    msSHPWriteShape(outSHP, &shape);
+    msFreeShape(&shape);
+  }
+  msSHPClose(outSHP);
+  free(keep);
+  free(stack);
+
+  /* same records, so the same attributes */
+  filename = buildFilename(basename, level, ".dbf");
+  dbfFilename = buildFilename(basename, 0, ".dbf");
+  status = copyFile(dbfFilename, filename);
+  if(status != MS_SUCCESS) {
+    strcpy(dbfFilename + strlen(basename), ".DBF");
+    status = copyFile(dbfFilename, filename);
+  }
+  free(dbfFilename);
+  free(filename);
+  if(status != MS_SUCCESS) {
+    fprintf(stderr, "Failed to copy the .dbf of %s.\n", basename);
+    return MS_FAILURE;
+  }
+
+  filename = buildFilename(basename, level, "");
+  if(msShapefileOpen(&overview, "rb", filename, MS_TRUE) == -1) {
+    free(filename);
+    return MS_FAILURE;
+  }
+  tree = msCreateTree(&overview, 0);
+  free(filename);
+  if(!tree) {
+    msShapefileClose(&overview);
+    return MS_FAILURE;
+  }
+  filename = buildFilename(basename, level, MS_INDEX_EXTENSION);
+  msWriteTree(tree, filename, MS_NEW_LSB_ORDER);
+  msDestroyTree(tree);
+  msShapefileClose(&overview);
+  free(filename);
+
+  printf("level %d, tolerance %g: %ld of %ld vertices (%.1f%%)\n", level, tolerance, numout, numin, numin > 0 ? 100.0*numout/numin : 0);
+
+  return MS_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+  shapefileObj shp;
+  char *basename;
+  double tolerance, previous = 0;
+  int i;
+
+  if(argc > 1 && strcmp(argv[1], "-v") == 0) {
+    printf("%s\n", msGetVersion());
+    exit(0);
+  }
+
+  if(argc < 3) {
+    fprintf(stdout,"Syntax: shpoverviews [shpfile] [tolerance] [tolerance] ...\n" );
+    fprintf(stdout,"Writes [shpfile]_ov1, [shpfile]_ov2, ... simplified with increasing tolerances\n"
+            "(in data units), to be drawn with PROCESSING \"SHAPEFILE_OVERVIEWS=[tolerance],...\".\n" );
+    exit(0);
+  }
+
+  if(msShapefileOpen(&shp, "rb", argv[1], MS_TRUE) == -1) {
+    msWriteError(stderr);
+    exit(1);
+  }
+
+  if(shp.type != SHP_ARC && shp.type != SHP_ARCZ && shp.type != SHP_ARCM &&
+      shp.type != SHP_POLYGON && shp.type != SHP_POLYGONZ && shp.type != SHP_POLYGONM) {
+    fprintf(stderr, "Only line and polygon shapefiles have overviews.\n");
+    exit(1);
+  }
+
+  basename = msStrdup(argv[1]);
+  for(i = strlen(basename)-1; i > 0 && basename[i] != '.' && basename[i] != '/' && basename[i] != '\\'; i--) {}
+  if(basename[i] == '.')
+    basename[i] = '\0';
+
+  for(i=2; i<argc; i++) {
+    tolerance = atof(argv[i]);
+    if(tolerance <= previous) {
+      fprintf(stderr, "Tolerances must be positive and increasing.\n");
+      exit(1);
+    }
+    previous = tolerance;
+  }
+
+  for(i=2; i<argc; i++) {
+    if(writeOverview(&shp, basename, i-1, atof(argv[i])) != MS_SUCCESS) {
+      msWriteError(stderr);
+      exit(1);
+    }
+  }
+
+  printf("PROCESSING \"SHAPEFILE_OVERVIEWS=");
+  for(i=2; i<argc; i++)
+    printf("%s%s", (i > 2) ? "," : "", argv[i]);
+  printf("\"\n");
+
+  free(basename);
+  msShapefileClose(&shp);
+
+  return(0);
+}
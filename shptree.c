@@ -29,6 +29,7 @@
 
 #include "mapserver.h"
 #include "maptree.h"
+#include "mapthread.h"
 #include <string.h>
 
 
@@ -68,9 +69,10 @@ int main(int argc, char *argv[])
 {
   shapefileObj shapefile;
 
-  treeObj *tree;
   int byte_order = MS_NEW_LSB_ORDER, i;
-  int depth=0;
+  int depth=0, rtree=MS_FALSE, iarg=1, numthreads;
+  size_t maxmemory=0;
+  char *filename;
 
   if(argc > 1 && strcmp(argv[1], "-v") == 0) {
     printf("%s\n", msGetVersion());
@@ -88,9 +90,23 @@ int main(int argc, char *argv[])
     byte_order = MS_NEW_MSB_ORDER;
 
 
-  if(argc<2) {
+  numthreads = msGetProcessorCount();
+
+  for( ; iarg < argc && argv[iarg][0] == '-'; iarg++) {
+    if(strcmp(argv[iarg], "-r") == 0)
+      rtree = MS_TRUE;
+    else if(strcmp(argv[iarg], "-t") == 0 && iarg+1 < argc)
+      numthreads = atoi(argv[++iarg]);
+    else if(strcmp(argv[iarg], "-m") == 0 && iarg+1 < argc)
+      maxmemory = (size_t) atoi(argv[++iarg]) * 1024 * 1024;
+    else
+      break;
+  }
+
+  if(argc<iarg+1) {
     fprintf(stdout,"Syntax:\n");
-    fprintf(stdout,"    shptree <shpfile> [<depth>] [<index_format>]\n" );
+    fprintf(stdout,"    shptree [-t <threads>] [-m <megabytes>] <shpfile> [<depth>] [<index_format>]\n" );
+    fprintf(stdout,"    shptree -r <shpfile> [<node_size>]\n" );
     fprintf(stdout,"Where:\n");
     fprintf(stdout," <shpfile> is the name of the .shp file to index.\n");
     fprintf(stdout," <depth>   (optional) is the maximum depth of the index\n");
@@ -105,27 +121,52 @@ int main(int argc, char *argv[])
     fprintf(stdout,"           M:  MSB byte order\n");
     fprintf(stdout,"       The default index_format on this system is: %s\n\n",
             (byte_order == MS_NEW_LSB_ORDER) ? "NL" : "NM" );
+    fprintf(stdout," -t        is the number of threads building the index, default\n");
+    fprintf(stdout,"           is %d on this system.\n", numthreads);
+    fprintf(stdout," -m        caps the memory used for the index, a larger one\n");
+    fprintf(stdout,"           is sorted through temporary files. Default is no cap.\n");
+    fprintf(stdout," -r        builds a packed Hilbert R-tree (%s) instead of a\n", MS_RTREE_INDEX_EXTENSION);
+    fprintf(stdout,"           quadtree, it is used in preference to the %s when\n", MS_INDEX_EXTENSION);
+    fprintf(stdout,"           both exist. <node_size> defaults to 16.\n\n");
     exit(0);
   }
 
-  if(argc >= 3)
-    depth = atoi(argv[2]);
+  if(rtree) {
+    if(msShapefileOpen(&shapefile, "rb", argv[iarg], MS_TRUE) == -1) {
+      fprintf(stdout, "Error opening shapefile %s.\n", argv[iarg]);
+      exit(0);
+    }
+
+    printf("creating packed R-tree index of %s\n", argv[iarg]);
+    filename = AddFileSuffix(argv[iarg], MS_RTREE_INDEX_EXTENSION);
+    if(msWritePackedRTree(&shapefile, filename, (argc > iarg+1) ? atoi(argv[iarg+1]) : 0) != MS_SUCCESS) {
+      msWriteError(stdout);
+      exit(1);
+    }
+
+    free(filename);
+    msShapefileClose(&shapefile);
+    return(0);
+  }
 
-  if(argc >= 4) {
-    if( !strcasecmp(argv[3],"N" ))
+  if(argc > iarg+1)
+    depth = atoi(argv[iarg+1]);
+
+  if(argc > iarg+2) {
+    if( !strcasecmp(argv[iarg+2],"N" ))
       byte_order = MS_NATIVE_ORDER;
-    if( !strcasecmp(argv[3],"L" ))
+    if( !strcasecmp(argv[iarg+2],"L" ))
       byte_order = MS_LSB_ORDER;
-    if( !strcasecmp(argv[3],"M" ))
+    if( !strcasecmp(argv[iarg+2],"M" ))
       byte_order = MS_MSB_ORDER;
-    if( !strcasecmp(argv[3],"NL" ))
+    if( !strcasecmp(argv[iarg+2],"NL" ))
       byte_order = MS_NEW_LSB_ORDER;
-    if( !strcasecmp(argv[3],"NM" ))
+    if( !strcasecmp(argv[iarg+2],"NM" ))
       byte_order = MS_NEW_MSB_ORDER;
   }
 
-  if(msShapefileOpen(&shapefile, "rb", argv[1], MS_TRUE) == -1) {
-    fprintf(stdout, "Error opening shapefile %s.\n", argv[1]);
+  if(msShapefileOpen(&shapefile, "rb", argv[iarg], MS_TRUE) == -1) {
+    fprintf(stdout, "Error opening shapefile %s.\n", argv[iarg]);
     exit(0);
   }
 
@@ -133,18 +174,12 @@ int main(int argc, char *argv[])
           ((byte_order == MS_NATIVE_ORDER) ? "native" :
            ((byte_order == MS_LSB_ORDER) || (byte_order == MS_NEW_LSB_ORDER)? " LSB":"MSB")));
 
-  tree = msCreateTree(&shapefile, depth);
-  if(!tree) {
-#if MAX_SUBNODE == 2
-    fprintf(stdout, "Error generating binary tree.\n");
-#else
-    fprintf(stdout, "Error generating quadtree.\n");
-#endif
-    exit(0);
+  filename = AddFileSuffix(argv[iarg], MS_INDEX_EXTENSION);
+  if(msWriteShapefileTree(&shapefile, filename, depth, byte_order, numthreads, maxmemory) != MS_SUCCESS) {
+    msWriteError(stdout);
+    exit(1);
   }
-
-  msWriteTree(tree, AddFileSuffix(argv[1], MS_INDEX_EXTENSION), byte_order);
-  msDestroyTree(tree);
+  free(filename);
 
   /*
   ** Clean things up
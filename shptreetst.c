@@ -28,6 +28,7 @@
  ****************************************************************************/
 
 #include "mapserver.h"
+#include "maptime.h"
 #include <string.h>
 #ifndef _WIN32
 #include <unistd.h>
@@ -73,6 +74,89 @@ char* AddFileSuffix ( const char * Filename, const char * Suffix )
   return (pszFullname);
 }
 
+static double elapsed(struct mstimeval *start)
+{
+  struct mstimeval now;
+  msGettimeofday(&now, NULL);
+  return (now.tv_sec - start->tv_sec) + (now.tv_usec - start->tv_usec)/1000000.0;
+}
+
+/*
+** Runs the same pseudo random extents through the .qix (search plus the
+** bounds filter msShapefileWhichShapes() applies) and the packed R-tree
+** (open plus search, as done per request) and reports the mean latency
+** of each along with any extent where the results differ.
+*/
+static int benchmark(char *filename, int count, double size)
+{
+  shapefileObj shp;
+  packedRTreeObj *rtree;
+  ms_bitarray qixbits, rtreebits;
+  struct mstimeval start;
+  double qixtime=0, rtreetime=0, width, height;
+  unsigned int seed = 12345;
+  char *qixname, *rtreename;
+  long hits=0;
+  int i, j, mismatches=0;
+  rectObj rect;
+
+  if(msShapefileOpen(&shp, "rb", filename, MS_TRUE) == -1) {
+    msWriteError(stdout);
+    return 1;
+  }
+  if(count <= 0) count = 1000;
+  qixname = AddFileSuffix(filename, MS_INDEX_EXTENSION);
+  rtreename = AddFileSuffix(filename, MS_RTREE_INDEX_EXTENSION);
+
+  width = (shp.bounds.maxx - shp.bounds.minx) * size;
+  height = (shp.bounds.maxy - shp.bounds.miny) * size;
+
+  for(i=0; i<count; i++) {
+    seed = seed * 1103515245 + 12345;
+    rect.minx = shp.bounds.minx + (shp.bounds.maxx - shp.bounds.minx - width) * ((seed >> 8) % 10000) / 10000.0;
+    seed = seed * 1103515245 + 12345;
+    rect.miny = shp.bounds.miny + (shp.bounds.maxy - shp.bounds.miny - height) * ((seed >> 8) % 10000) / 10000.0;
+    rect.maxx = rect.minx + width;
+    rect.maxy = rect.miny + height;
+
+    msGettimeofday(&start, NULL);
+    qixbits = msSearchDiskTree(qixname, rect, 0);
+    if(qixbits)
+      msFilterTreeSearch(&shp, qixbits, rect);
+    qixtime += elapsed(&start);
+
+    msGettimeofday(&start, NULL);
+    rtree = msPackedRTreeOpen(rtreename, 0);
+    rtreebits = rtree ? msSearchPackedRTree(rtree, rect) : NULL;
+    msPackedRTreeClose(rtree);
+    rtreetime += elapsed(&start);
+
+    if(!qixbits || !rtreebits) {
+      printf("unable to search %s, make sure both indexes exist (shptree and shptree -r).\n", !qixbits ? qixname : rtreename);
+      return 1;
+    }
+
+    for(j=0; j<shp.numshapes; j++) {
+      if(msGetBit(rtreebits, j)) hits++;
+      if(msGetBit(qixbits, j) != msGetBit(rtreebits, j)) {
+        mismatches++;
+        break;
+      }
+    }
+    free(qixbits);
+    free(rtreebits);
+  }
+
+  printf("%d extents of %g x %g, %.1f shapes on average\n", count, width, height, (double)hits/count);
+  printf("%-4s %10.1f us per query\n", MS_INDEX_EXTENSION+1, qixtime*1000000/count);
+  printf("%-4s %10.1f us per query\n", MS_RTREE_INDEX_EXTENSION+1, rtreetime*1000000/count);
+  printf("%d extents with different results\n", mismatches);
+
+  msShapefileClose(&shp);
+  free(qixname);
+  free(rtreename);
+  return mismatches ? 1 : 0;
+}
 
 int main( int argc, char ** argv )
 
@@ -96,8 +180,14 @@ int main( int argc, char ** argv )
   /* -------------------------------------------------------------------- */
   if( argc <= 1 ) {
     printf( "shptreetst shapefile {minx miny maxx maxy}\n" );
+    printf( "shptreetst -bench shapefile {count {size}}\n" );
+    printf( "  compares .qix and packed R-tree query latency over count (default 1000)\n" );
+    printf( "  extents of size (default 0.05) times the shapefile extent.\n" );
     exit( 1 );
   }
+
+  if( strcmp(argv[1], "-bench") == 0 && argc > 2 )
+    return benchmark(argv[2], argc > 3 ? atoi(argv[3]) : 1000, argc > 4 ? atof(argv[4]) : 0.05);
   
   /*
   i = 1;
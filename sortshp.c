@@ -4,7 +4,8 @@
  * Project:  MapServer
  * Purpose:  Command line utility to sort a shapefile based on a single
  *           attribute in ascending or decending order. Useful for
- *           prioritizing drawing or labeling of shapes.
+ *           prioritizing drawing or labeling of shapes. Can also sort
+ *           along a Hilbert curve for spatial locality on disk.
  * Author:   Steve Lime and the MapServer team.
  *
  ******************************************************************************
@@ -35,8 +36,10 @@
 #include <string.h>
 
 #include "mapserver.h"
+#include "maptree.h"
 
-
+#define HILBERT_RUN_SIZE 1000000 /* default number of keys sorted in memory at a time */
+#define HILBERT_MIN_RUN_SIZE 1024
 
 typedef struct {
   double number;
@@ -44,6 +47,19 @@ typedef struct {
   int index;
 } sortStruct;
 
+typedef struct {
+  unsigned int key;
+  int index;
+} hilbertStruct;
+
+/* a sorted run of keys in the temporary file, read back a buffer at a time */
+typedef struct {
+  long offset;
+  int remaining;
+  hilbertStruct *buffer;
+  int count, pos;
+} runStruct;
+
 static int compare_string_descending(const void *a, const void *b)
 {
   const sortStruct *i = a, *j = b;
@@ -76,19 +92,190 @@ static int compare_number_ascending(const void *a, const void *b)
   return(0);
 }
 
+static int compare_hilbert(const void *a, const void *b)
+{
+  const hilbertStruct *i = a, *j = b;
+  if(i->key != j->key)
+    return (i->key < j->key) ? -1 : 1;
+  return(i->index - j->index); /* keep the original order of ties */
+}
+
+/* ------------------------------------------------------------------------------- */
+/*       Copy record index of the input to record i of the output                  */
+/* ------------------------------------------------------------------------------- */
+static void writeRecord(SHPHandle inSHP, DBFHandle inDBF, SHPHandle outSHP, DBFHandle outDBF, int num_fields, int i, int index)
+{
+  DBFFieldType dbfField;
+  char fName[20];
+  int j, fWidth, fnDecimals;
+  shapeObj shape;
+
+  for(j=0; j<num_fields; j++) { /* ---- For each .dbf field ---- */
+
+    dbfField = msDBFGetFieldInfo(inDBF,j,fName,&fWidth,&fnDecimals);
+
+    switch (dbfField) {
+      case FTInteger:
+        msDBFWriteIntegerAttribute(outDBF, i, j, msDBFReadIntegerAttribute( inDBF, index, j));
+        break;
+      case FTDouble:
+        msDBFWriteDoubleAttribute(outDBF, i, j, msDBFReadDoubleAttribute( inDBF, index, j));
+        break;
+      case FTString:
+        msDBFWriteStringAttribute(outDBF, i, j, msDBFReadStringAttribute( inDBF, index, j));
+        break;
+      default:
+        fprintf(stderr,"Unsupported data type for field: %s, exiting.\n",fName);
+        exit(0);
+    }
+  }
+
+  msSHPReadShape( inSHP, index, &shape );
+  msSHPWriteShape( outSHP, &shape );
+  msFreeShape( &shape );
+}
+
+/* ------------------------------------------------------------------------------- */
+/*       Hilbert sort, first pass: key every shape by the Hilbert position of its  */
+/*       bounding box center and write sorted runs of run_size keys to a           */
+/*       temporary file. Shapes without bounds (NULL shapes) go last. Only the     */
+/*       keys are held in memory, so files of any size can be sorted.             */
+/* ------------------------------------------------------------------------------- */
+static runStruct *hilbertSortRuns(SHPHandle inSHP, int nShapes, int run_size, FILE *tmp, int *num_runs)
+{
+  hilbertStruct *keys;
+  runStruct *runs;
+  rectObj extent, rect;
+  int i, n=0, first=MS_TRUE;
+
+  /* the union of the shape bounds, as msWritePackedRTree() uses, rather */
+  /* than the header extent which may be stale                           */
+  extent.minx = extent.miny = extent.maxx = extent.maxy = 0;
+  for(i=0; i<nShapes; i++) {
+    if(msSHPReadBounds(inSHP, i, &rect) != MS_SUCCESS)
+      continue;
+    if(first)
+      extent = rect;
+    else
+      msMergeRect(&extent, &rect);
+    first = MS_FALSE;
+  }
+
+  keys = (hilbertStruct *) msSmallMalloc(sizeof(hilbertStruct) * run_size);
+  runs = (runStruct *) msSmallMalloc(sizeof(runStruct) * (nShapes / run_size + 1));
+  *num_runs = 0;
+
+  for(i=0; i<=nShapes; i++) {
+    if(n == run_size || (i == nShapes && n > 0)) { /* ---- Flush a run ---- */
+      qsort(keys, n, sizeof(hilbertStruct), compare_hilbert);
+      runs[*num_runs].offset = ftell(tmp);
+      runs[*num_runs].remaining = n;
+      if(fwrite(keys, sizeof(hilbertStruct), n, tmp) != (size_t) n) {
+        fprintf(stderr, "Unable to write to the temporary file.\n");
+        exit(1);
+      }
+      (*num_runs)++;
+      n = 0;
+    }
+    if(i == nShapes) break;
+
+    keys[n].index = i;
+    if(msSHPReadBounds(inSHP, i, &rect) == MS_SUCCESS)
+      keys[n].key = msHilbertKey(&extent, &rect);
+    else
+      keys[n].key = 0xFFFFFFFF;
+    n++;
+  }
+
+  free(keys);
+  return runs;
+}
+
+/* refill the buffer of a run, returns the number of keys available */
+static int readRun(runStruct *run, int buffer_size, FILE *tmp)
+{
+  run->count = MS_MIN(run->remaining, buffer_size);
+  run->pos = 0;
+  if(run->count == 0) return 0;
+
+  fseek(tmp, run->offset, SEEK_SET);
+  if(fread(run->buffer, sizeof(hilbertStruct), run->count, tmp) != (size_t) run->count) {
+    fprintf(stderr, "Unable to read the temporary file.\n");
+    exit(1);
+  }
+  run->offset += sizeof(hilbertStruct) * run->count;
+  run->remaining -= run->count;
+  return run->count;
+}
+
+#define RUN_HEAD(r) (&runs[r].buffer[runs[r].pos])
+
+static void siftDown(runStruct *runs, int *heap, int n, int i)
+{
+  int child, top = heap[i];
+
+  while((child = 2*i + 1) < n) {
+    if(child + 1 < n && compare_hilbert(RUN_HEAD(heap[child+1]), RUN_HEAD(heap[child])) < 0)
+      child++;
+    if(compare_hilbert(RUN_HEAD(heap[child]), RUN_HEAD(top)) >= 0)
+      break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = top;
+}
+
+/* ------------------------------------------------------------------------------- */
+/*       Hilbert sort, second pass: merge the runs through a heap, copying each     */
+/*       record to the output as its key comes up. Memory use stays about          */
+/*       run_size keys whatever the number of runs.                                */
+/* ------------------------------------------------------------------------------- */
+static void hilbertMergeRuns(runStruct *runs, int num_runs, int run_size, FILE *tmp,
+                             SHPHandle inSHP, DBFHandle inDBF, SHPHandle outSHP, DBFHandle outDBF, int num_fields)
+{
+  int i, r, n=0, record=0, buffer_size;
+  int *heap;
+
+  buffer_size = MS_MAX(run_size / MS_MAX(num_runs, 1), 64);
+  heap = (int *) msSmallMalloc(sizeof(int) * (num_runs > 0 ? num_runs : 1));
+
+  for(r=0; r<num_runs; r++) {
+    runs[r].buffer = (hilbertStruct *) msSmallMalloc(sizeof(hilbertStruct) * buffer_size);
+    if(readRun(&runs[r], buffer_size, tmp) > 0)
+      heap[n++] = r;
+  }
+  for(i=n/2-1; i>=0; i--)
+    siftDown(runs, heap, n, i);
+
+  while(n > 0) {
+    r = heap[0];
+    writeRecord(inSHP, inDBF, outSHP, outDBF, num_fields, record++, RUN_HEAD(r)->index);
+
+    if(++runs[r].pos == runs[r].count && readRun(&runs[r], buffer_size, tmp) == 0)
+      heap[0] = heap[--n]; /* ---- This run is done ---- */
+    siftDown(runs, heap, n, 0);
+  }
+
+  for(r=0; r<num_runs; r++)
+    free(runs[r].buffer);
+  free(heap);
+}
+
 int main(int argc, char *argv[])
 {
   SHPHandle    inSHP,outSHP; /* ---- Shapefile file pointers ---- */
   DBFHandle    inDBF,outDBF; /* ---- DBF file pointers ---- */
-  sortStruct   *array;
-  shapeObj     shape;
+  sortStruct   *array=NULL;
+  runStruct    *runs=NULL;
+  FILE         *tmp=NULL;
+  int          hilbert, run_size=HILBERT_RUN_SIZE, num_runs=0;
   int          shpType, nShapes;
   int          fieldNumber=-1; /* ---- Field number of item to be sorted on ---- */
   DBFFieldType dbfField;
   char         fName[20];
   int          fWidth,fnDecimals;
   char         buffer[1024];
-  int i,j;
+  int i;
   int num_fields, num_records;
 
   if(argc > 1 && strcmp(argv[1], "-v") == 0) {
@@ -99,10 +286,21 @@ int main(int argc, char *argv[])
   /* ------------------------------------------------------------------------------- */
   /*       Check the number of arguments, return syntax if not correct               */
   /* ------------------------------------------------------------------------------- */
-  if( argc != 5 ) {
+  hilbert = (argc == 4 || argc == 5) && strcasecmp(argv[3], "-hilbert") == 0;
+  if( argc != 5 && !hilbert ) {
     fprintf(stderr,"Syntax: sortshp [infile] [outfile] [item] [ascending|descending]\n" );
+    fprintf(stderr,"        sortshp [infile] [outfile] -hilbert [run size]\n" );
+    fprintf(stderr,"The -hilbert mode orders shapes along a Hilbert curve through their bounding box\n"
+            "centers, sorting at most [run size] (default %d) keys in memory at a time.\n", HILBERT_RUN_SIZE );
     exit(1);
   }
+  if( hilbert && argc == 5 ) {
+    run_size = atoi(argv[4]);
+    if( run_size < HILBERT_MIN_RUN_SIZE ) {
+      fprintf(stderr,"Run size must be at least %d.\n", HILBERT_MIN_RUN_SIZE );
+      exit(1);
+    }
+  }
 
   msSetErrorFile("stderr", NULL);
 
@@ -129,57 +327,70 @@ int main(int argc, char *argv[])
   num_fields = msDBFGetFieldCount(inDBF);
   num_records = msDBFGetRecordCount(inDBF);
 
-  for(i=0; i<num_fields; i++) {
-    msDBFGetFieldInfo(inDBF,i,fName,NULL,NULL);
-    if(strncasecmp(argv[3],fName,strlen(argv[3])) == 0) { /* ---- Found it ---- */
-      fieldNumber = i;
-      break;
+  if(hilbert) {
+    /* ------------------------------------------------------------------------------- */
+    /*       Write the sorted runs of Hilbert keys                                     */
+    /* ------------------------------------------------------------------------------- */
+    tmp = tmpfile();
+    if(!tmp) {
+      fprintf(stderr, "Unable to create a temporary file.\n");
+      exit(1);
     }
-  }
-
-  if(fieldNumber < 0) {
-    fprintf(stderr,"Item %s doesn't exist in %s\n",argv[3],buffer);
-    exit(1);
-  }
-
-  array = (sortStruct *)malloc(sizeof(sortStruct)*num_records); /* ---- Allocate the array ---- */
-  if(!array) {
-    fprintf(stderr, "Unable to allocate sort array.\n");
-    exit(1);
-  }
-
-  /* ------------------------------------------------------------------------------- */
-  /*       Load the array to be sorted                                               */
-  /* ------------------------------------------------------------------------------- */
-  dbfField = msDBFGetFieldInfo(inDBF,fieldNumber,NULL,NULL,NULL);
-  switch (dbfField) {
-    case FTString:
-      for(i=0; i<num_records; i++) {
-        strlcpy(array[i].string, msDBFReadStringAttribute( inDBF, i, fieldNumber), sizeof(array[i].string));
-        array[i].index = i;
-      }
-
-      if(*argv[4] == 'd')
-        qsort(array, num_records, sizeof(sortStruct), compare_string_descending);
-      else
-        qsort(array, num_records, sizeof(sortStruct), compare_string_ascending);
-      break;
-    case FTInteger:
-    case FTDouble:
-      for(i=0; i<num_records; i++) {
-        array[i].number = msDBFReadDoubleAttribute( inDBF, i, fieldNumber);
-        array[i].index = i;
+    run_size = MS_MIN(run_size, MS_MAX(nShapes, 1));
+    runs = hilbertSortRuns(inSHP, nShapes, run_size, tmp, &num_runs);
+  } else {
+    for(i=0; i<num_fields; i++) {
+      msDBFGetFieldInfo(inDBF,i,fName,NULL,NULL);
+      if(strncasecmp(argv[3],fName,strlen(argv[3])) == 0) { /* ---- Found it ---- */
+        fieldNumber = i;
+        break;
       }
+    }
 
-      if(*argv[4] == 'd')
-        qsort(array, num_records, sizeof(sortStruct), compare_number_descending);
-      else
-        qsort(array, num_records, sizeof(sortStruct), compare_number_ascending);
+    if(fieldNumber < 0) {
+      fprintf(stderr,"Item %s doesn't exist in %s\n",argv[3],buffer);
+      exit(1);
+    }
 
-      break;
-    default:
-      fprintf(stderr,"Data type for item %s not supported.\n",argv[3]);
+    array = (sortStruct *)malloc(sizeof(sortStruct)*num_records); /* ---- Allocate the array ---- */
+    if(!array) {
+      fprintf(stderr, "Unable to allocate sort array.\n");
       exit(1);
+    }
+
+    /* ------------------------------------------------------------------------------- */
+    /*       Load the array to be sorted                                               */
+    /* ------------------------------------------------------------------------------- */
+    dbfField = msDBFGetFieldInfo(inDBF,fieldNumber,NULL,NULL,NULL);
+    switch (dbfField) {
+      case FTString:
+        for(i=0; i<num_records; i++) {
+          strlcpy(array[i].string, msDBFReadStringAttribute( inDBF, i, fieldNumber), sizeof(array[i].string));
+          array[i].index = i;
+        }
+
+        if(*argv[4] == 'd')
+          qsort(array, num_records, sizeof(sortStruct), compare_string_descending);
+        else
+          qsort(array, num_records, sizeof(sortStruct), compare_string_ascending);
+        break;
+      case FTInteger:
+      case FTDouble:
+        for(i=0; i<num_records; i++) {
+          array[i].number = msDBFReadDoubleAttribute( inDBF, i, fieldNumber);
+          array[i].index = i;
+        }
+
+        if(*argv[4] == 'd')
+          qsort(array, num_records, sizeof(sortStruct), compare_number_descending);
+        else
+          qsort(array, num_records, sizeof(sortStruct), compare_number_ascending);
+
+        break;
+      default:
+        fprintf(stderr,"Data type for item %s not supported.\n",argv[3]);
+        exit(1);
+    }
   }
 
   /* ------------------------------------------------------------------------------- */
@@ -206,35 +417,16 @@ int main(int argc, char *argv[])
   /* ------------------------------------------------------------------------------- */
   /*       Write the sorted .shp/.shx and .dbf files                                 */
   /* ------------------------------------------------------------------------------- */
-  for(i=0; i<num_records; i++) { /* ---- For each shape/record ---- */
-
-    for(j=0; j<num_fields; j++) { /* ---- For each .dbf field ---- */
-
-      dbfField = msDBFGetFieldInfo(inDBF,j,fName,&fWidth,&fnDecimals);
-
-      switch (dbfField) {
-        case FTInteger:
-          msDBFWriteIntegerAttribute(outDBF, i, j, msDBFReadIntegerAttribute( inDBF, array[i].index, j));
-          break;
-        case FTDouble:
-          msDBFWriteDoubleAttribute(outDBF, i, j, msDBFReadDoubleAttribute( inDBF, array[i].index, j));
-          break;
-        case FTString:
-          msDBFWriteStringAttribute(outDBF, i, j, msDBFReadStringAttribute( inDBF, array[i].index, j));
-          break;
-        default:
-          fprintf(stderr,"Unsupported data type for field: %s, exiting.\n",fName);
-          exit(0);
-      }
-    }
-
-    msSHPReadShape( inSHP, array[i].index, &shape );
-    msSHPWriteShape( outSHP, &shape );
-    msFreeShape( &shape );
+  if(hilbert) {
+    hilbertMergeRuns(runs, num_runs, run_size, tmp, inSHP, inDBF, outSHP, outDBF, num_fields);
+    free(runs);
+    fclose(tmp);
+  } else {
+    for(i=0; i<num_records; i++) /* ---- For each shape/record ---- */
+      writeRecord(inSHP, inDBF, outSHP, outDBF, num_fields, i, array[i].index);
+    free(array);
   }
 
-  free(array);
-
   msSHPClose(inSHP);
   msDBFClose(inDBF);
   msSHPClose(outSHP);
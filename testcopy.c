@@ -2,8 +2,8 @@
  * $Id$
  *
  * Project:  MapServer
- * Purpose:  Test of msCopyMap()
- * Author:   Sean Gilles
+ * Purpose:  Commandline tester for map copies made by msLoadMapCached()
+ * Author:   Steve Lime and the MapServer team.
  *
  ******************************************************************************
  * Copyright (c) 1996-2005 Regents of the University of Minnesota.
@@ -29,57 +29,130 @@
 
 #include "mapserver.h"
 
+/*
+** Saves each mapfile given as parsed by msLoadMap() and as copied from the
+** cache by msLoadMapCached(), and reports the first line where the two
+** differ. Mapfiles that don't load (e.g. built without PROJ) are skipped.
+*/
 
+/* saves map in the current directory, msSaveMap() is relative to the mapfile */
+static char *saveMap(mapObj *map, const char *suffix)
+{
+  char cwd[MS_MAXPATHLEN], *filename;
 
-void printAtts(mapObj*, const char*);
+  if(!getcwd(cwd, sizeof(cwd))) {
+    msSetError(MS_IOERR, "Can't get the current directory.", "saveMap()");
+    return NULL;
+  }
+  filename = msStringConcatenate(msStrdup(cwd), "/testcopy");
+  filename = msStringConcatenate(filename, suffix);
 
-int main(int argc, char *argv[])
+  if(msSaveMap(map, filename) != 0) {
+    msFree(filename);
+    return NULL;
+  }
+  return filename;
+}
+
+/* returns the number of the first line that differs, 0 if none */
+static int compareFiles(const char *filename1, const char *filename2, char *line1, char *line2, int size)
 {
+  FILE *file1, *file2;
+  char *s1, *s2;
+  int lineno = 0;
+
+  file1 = fopen(filename1, "r");
+  file2 = fopen(filename2, "r");
+  if(!file1 || !file2) {
+    if(file1) fclose(file1);
+    if(file2) fclose(file2);
+    strlcpy(line1, "(can't open)", size);
+    line2[0] = '\0';
+    return -1;
+  }
 
-  mapObj *original_map, *clone_map;
+  do {
+    lineno++;
+    s1 = fgets(line1, size, file1);
+    s2 = fgets(line2, size, file2);
+    if(!s1) line1[0] = '\0';
+    if(!s2) line2[0] = '\0';
+    if(strcmp(line1, line2) != 0)
+      break;
+  } while(s1 && s2);
 
-  /* ---------------------------------------------------------------------
-   * Test 1: free original before freeing clone
-   * --------------------------------------------------------------------- */
+  fclose(file1);
+  fclose(file2);
 
-  /* Load map file */
-  original_map = msLoadMap("tests/test.map", NULL);
+  return (s1 || s2) ? lineno : 0;
+}
+
+static int testMapfile(char *mapfile)
+{
+  mapObj *map, *copy;
+  char *filename1 = NULL, *filename2 = NULL;
+  char line1[MS_BUFFER_LENGTH], line2[MS_BUFFER_LENGTH];
+  int i, lineno, status = MS_FAILURE;
 
-  if (original_map ==  NULL) {
-    /* Write errors */
+  map = msLoadMap(mapfile, NULL);
+  if(!map) {
+    msResetErrorList();
+    printf("%s: skipped, doesn't load\n", mapfile);
+    return MS_SUCCESS;
+  }
+
+  copy = NULL;
+  for(i=0; i<2; i++) { /* the second load copies the cached map */
+    msFreeMap(copy);
+    copy = msLoadMapCached(mapfile, NULL);
+  }
+
+  if(copy) {
+    filename1 = saveMap(map, ".fresh.map");
+    filename2 = saveMap(copy, ".cached.map");
+  }
+  if(!filename1 || !filename2) {
     msWriteError(stderr);
     msResetErrorList();
-    exit(0);
+    printf("%s: failed\n", mapfile);
+  } else if((lineno = compareFiles(filename1, filename2, line1, line2, sizeof(line1))) != 0) {
+    printf("%s: line %d differs\n  fresh:  %s  cached: %s", mapfile, lineno, line1, line2);
+  } else {
+    printf("%s: ok\n", mapfile);
+    status = MS_SUCCESS;
   }
 
-  /* Dump out some attributes */
-  printAtts(original_map, "Original");
+  if(filename1) unlink(filename1);
+  if(filename2) unlink(filename2);
+  msFree(filename1);
+  msFree(filename2);
+  msFreeMap(map);
+  msFreeMap(copy);
 
-  /* Clone it */
-  clone_map = msNewMapObj();
-  msCopyMap(clone_map, original_map);
+  return status;
+}
 
-  /* Write errors */
-  msWriteError(stderr);
-  msResetErrorList();
+int main(int argc, char *argv[])
+{
+  int i, failures = 0;
 
-  /* Free */
-  msFreeMap(original_map);
+  if(argc < 2) {
+    fprintf(stdout, "Syntax: testcopy mapfile...\n");
+    exit(0);
+  }
 
-  /* Dump clone's attributes */
-  printAtts(clone_map, "Clone");
+  if(msSetup() != MS_SUCCESS) {
+    msWriteError(stderr);
+    exit(1);
+  }
+  msSetMapCacheSize("1");
 
-  /* Free clone */
-  msFreeMap(clone_map);
+  for(i=1; i<argc; i++) {
+    if(testMapfile(argv[i]) != MS_SUCCESS)
+      failures++;
+  }
 
-  exit(0);
-}
+  msCleanup(0);
 
-void printAtts(mapObj *map, const char *title)
-{
-  printf("\n%s Attributes\n----------------------\n", title);
-  printf("Map Name: %s\n", map->name);
-  printf("Numlayers: %d\n", map->numlayers);
-  printf("Map Fontset Filename: %s\n", map->fontset.filename);
-  printf("Map Symbolset Filename: %s\n", map->symbolset.filename);
+  exit(failures > 0 ? 1 : 0);
 }
@@ -28,44 +28,243 @@
  ****************************************************************************/
 
 #include <time.h>
+#include <ctype.h>
 
 #include "mapserver.h"
-#include "mapparser.h"
-#include "mapfile.h"
+#include "maptime.h"
 
+extern int yyparse(parseObj *);
 
+/*
+** Evaluates an expression with both the bison parser (the reference) and the
+** compiled program from mapexprcompile.c, optionally against every record of
+** a shapefile, and reports any record where the two disagree. With -f, every
+** expression of a file is tested that way against each shapefile given.
+*/
 
-extern int msyyparse();
-extern int msyylex();
-extern char *msyystring_buffer;
+static double elapsed(struct mstimeval *start)
+{
+  struct mstimeval now;
+  msGettimeofday(&now, NULL);
+  return (now.tv_sec - start->tv_sec) + (now.tv_usec - start->tv_usec)/1000000.0;
+}
+
+static int evaluate(parseObj *p, int compiled, char **result)
+{
+  int status;
+
+  p->expr->curtoken = p->expr->tokens;
+  status = compiled ? msExecuteExpression(p) : yyparse(p);
+  msResetErrorList();
+
+  if(status != 0)
+    *result = msStrdup("(error)");
+  else if(p->type == MS_PARSE_TYPE_STRING)
+    *result = p->result.strval;
+  else
+    *result = msStrdup(p->result.intval ? "1" : "0");
+
+  return status;
+}
+
+/*
+** Tests one expression against every shape of shp (once without attributes if
+** shp is NULL). Returns the number of mismatches, or -1 if the expression does
+** not tokenize against the attributes of the shapefile. compiled is set if the
+** expression compiled to a program.
+*/
+static int testExpression(char *string, int type, shapefileObj *shp, int verbose, int *compiled, double *t1, double *t2)
+{
+  expressionObj e;
+  shapeObj shape;
+  parseObj p;
+  struct mstimeval start;
+  char **items=NULL, *r1, *r2;
+  int i, numitems=0, numfields=0, numrecords=1;
+  int mismatches=0, s1, s2;
+
+  initExpression(&e);
+  e.string = msStrdup(string);
+  e.type = MS_EXPRESSION;
+
+  if(shp) {
+    numfields = msDBFGetFieldCount(shp->hDBF);
+    numrecords = shp->numshapes;
+    numitems = numfields;
+    items = (char **) msSmallCalloc(numfields + msCountChars(e.string, '[') + 1, sizeof(char *));
+    if(numfields > 0) {
+      char **fields = msDBFGetItems(shp->hDBF);
+      for(i=0; i<numfields; i++) items[i] = msStrdup(fields[i]);
+      msFreeCharArray(fields, numfields);
+    }
+  }
+
+  if(msTokenizeExpression(&e, items, &numitems) != MS_SUCCESS) {
+    msWriteError(stderr);
+    mismatches = -1;
+  } else if(numitems > numfields) {
+    if(verbose) fprintf(stderr, "Expression references unknown attribute %s.\n", items[numfields]);
+    mismatches = -1;
+  }
+  if(mismatches == -1) {
+    msResetErrorList();
+    freeExpression(&e);
+    if(items) msFreeCharArray(items, numitems);
+    return -1;
+  }
+
+  msCompileExpression(&e);
+  *compiled = (e.programstatus == MS_EXPR_PROGRAM_COMPILED);
+  if(verbose)
+    printf("Expression is %s.\n", (e.programstatus == MS_EXPR_PROGRAM_COMPILED) ? "compiled" : "evaluated by the parser only");
+
+  p.expr = &e;
+  p.type = type;
+  p.dblval = p.dblval2 = 0;
+  p.shape = &shape;
+
+  msInitShape(&shape);
+  for(i=0; i<numrecords; i++) {
+    if(shp) {
+      msSHPReadShape(shp->hSHP, i, &shape); /* spatial operators need the geometry too */
+      shape.values = msDBFGetValues(shp->hDBF, i);
+      shape.numvalues = numfields;
+    }
+
+    msGettimeofday(&start, NULL);
+    s1 = evaluate(&p, MS_FALSE, &r1);
+    *t1 += elapsed(&start);
+
+    msGettimeofday(&start, NULL);
+    s2 = evaluate(&p, MS_TRUE, &r2);
+    *t2 += elapsed(&start);
+
+    if((s1 != 0) != (s2 != 0) || strcmp(r1, r2) != 0) { /* only failing matters, not how */
+      if(!verbose) printf("%s: ", string);
+      printf("Record %d: parser returned %s, compiled program returned %s.\n", i, r1, r2);
+      mismatches++;
+    } else if(verbose && !shp) {
+      printf("Expression evaluated to: %s.\n", r1);
+    }
+
+    msFree(r1);
+    msFree(r2);
+    msFreeShape(&shape);
+  }
+
+  freeExpression(&e);
+  if(items) msFreeCharArray(items, numitems);
+
+  return mismatches;
+}
+
+/*
+** Expression files hold one expression per line, blank lines and lines
+** starting with # are skipped and a line starting with "-text " is evaluated
+** as a text expression.
+*/
+static int testExpressionFile(char *filename, char **shapefiles, int numshapefiles)
+{
+  FILE *stream;
+  char line[MS_BUFFER_LENGTH], *string;
+  shapefileObj *shps;
+  int i, type, status, compiled, numtested, numexpressions=0, numcompiled=0, numfailures=0;
+  double t1=0, t2=0;
+
+  if((stream = fopen(filename, "r")) == NULL) {
+    fprintf(stderr, "Unable to open %s.\n", filename);
+    return 1;
+  }
+
+  shps = (shapefileObj *) msSmallCalloc(numshapefiles, sizeof(shapefileObj));
+  for(i=0; i<numshapefiles; i++) {
+    if(msShapefileOpen(&(shps[i]), "rb", shapefiles[i], MS_TRUE) == -1) {
+      msWriteError(stderr);
+      exit(1);
+    }
+  }
+
+  while(fgets(line, MS_BUFFER_LENGTH, stream) != NULL) {
+    msStringTrimEOL(line);
+    string = line;
+    while(isspace((unsigned char) *string)) string++;
+    if(*string == '\0' || *string == '#') continue;
+
+    type = MS_PARSE_TYPE_BOOLEAN;
+    if(strncmp(string, "-text ", 6) == 0) {
+      type = MS_PARSE_TYPE_STRING;
+      string += 6;
+    }
+
+    numexpressions++;
+    numtested = compiled = 0;
+    for(i=0; i<(numshapefiles > 0 ? numshapefiles : 1); i++) {
+      /* expressions on attributes a shapefile does not have are skipped for it */
+      status = testExpression(string, type, numshapefiles > 0 ? &(shps[i]) : NULL, MS_FALSE, &compiled, &t1, &t2);
+      if(status == -1) continue;
+      numtested++;
+      if(status > 0) {
+        printf("%s: %d mismatch(es) on %s.\n", string, status, numshapefiles > 0 ? shapefiles[i] : "no shape");
+        numfailures++;
+      }
+    }
+    if(numtested == 0) {
+      printf("%s: not tested, no shapefile has its attributes.\n", string);
+      numfailures++;
+    } else if(compiled) {
+      numcompiled++;
+    }
+  }
+  fclose(stream);
+
+  for(i=0; i<numshapefiles; i++)
+    msShapefileClose(&(shps[i]));
+  msFree(shps);
 
-extern int msyyresult; /* result of parsing, true/false */
-extern int msyystate;
-extern char *msyystring;
+  printf("%d expression(s), %d compiled, %d failure(s), parser %.3fs, compiled %.3fs.\n", numexpressions, numcompiled, numfailures, t1, t2);
+
+  return numfailures ? 1 : 0;
+}
 
 int main(int argc, char *argv[])
 {
-  int status;
+  shapefileObj shp;
+  int mismatches, compiled, type=MS_PARSE_TYPE_BOOLEAN, iarg=1;
+  double t1=0, t2=0;
 
   if(argc > 1 && strcmp(argv[1], "-v") == 0) {
     printf("%s\n", msGetVersion());
     exit(0);
   }
 
+  if(argc > 2 && strcmp(argv[1], "-f") == 0)
+    exit(testExpressionFile(argv[2], argv+3, argc-3));
+
+  if(argc > 1 && strcmp(argv[1], "-text") == 0) {
+    type = MS_PARSE_TYPE_STRING;
+    iarg++;
+  }
+
   /* ---- check the number of arguments, return syntax if not correct ---- */
-  if( argc < 2) {
-    fprintf(stdout, "Syntax: testexpr [string]\n");
+  if(argc - iarg < 1) {
+    fprintf(stdout, "Syntax: testexpr [-text] [expression] [shapefile]\n");
+    fprintf(stdout, "        testexpr -f [expressionfile] [shapefile]...\n");
     exit(0);
   }
 
-  msyystate = MS_TOKENIZE_EXPRESSION;
-  msyystring = argv[1];
+  if(argc - iarg > 1) {
+    if(msShapefileOpen(&shp, "rb", argv[iarg+1], MS_TRUE) == -1) {
+      msWriteError(stderr);
+      exit(1);
+    }
+  }
 
-  status = msyyparse();
-  if(status != 0)
-    printf("Error parsing expression near %s.\n", msyystring_buffer);
-  else
-    printf("Expression evalulated to: %d.\n", msyyresult);
+  mismatches = testExpression(argv[iarg], type, (argc - iarg > 1) ? &shp : NULL, MS_TRUE, &compiled, &t1, &t2);
+  if(mismatches == -1) exit(1);
+
+  printf("%d record(s), %d mismatch(es), parser %.3fs, compiled %.3fs.\n", (argc - iarg > 1) ? shp.numshapes : 1, mismatches, t1, t2);
+
+  if(argc - iarg > 1) msShapefileClose(&shp);
 
-  exit(0);
+  exit(mismatches ? 1 : 0);
 }